@@ -0,0 +1,726 @@
+/* gcp_client_adaptive.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Adaptive chunk length and parallelism routines.
+*/
+/**
+ * Routines choosing the chunk (or part) length and the number of transfers in progress at once from the throughput
+ * and round trip times (RTT) of completed transfers, rather than compiled in constants. There is a controller for
+ * each transfer direction (ranged parts of parallel reads, and uploads). Transfers report each completed chunk with
+ * GCP_Client_Adaptive_Record, and ask for the current settings with GCP_Client_Adaptive_Get before starting the next.
+ * <p>
+ * About once a second the controller makes a decision from the transfers completed since the last one:
+ * <ul>
+ * <li>The chunk length is set to a power of two long enough to keep a single transfer streaming for several round
+ *     trips (the per-transfer throughput times the smallest RTT seen, times ADAPTIVE_TARGET_RTT_MULTIPLE), so the
+ *     per-request latency is a small part of each chunk's transfer time. The smallest RTT is used, rather than
+ *     the smoothed RTT, so queueing delay (which longer chunks can add to) does not feed back into the length.
+ * <li>The parallelism is hill climbed on the aggregate throughput. It keeps moving in the same direction whilst
+ *     throughput improves, turns round when throughput drops, and backs off when the RTT rises well above the
+ *     smallest seen (queueing in the network or at the server). When throughput has been flat for a while, a step
+ *     up is tried to see whether conditions have changed.
+ * </ul>
+ * Both are kept within the limits set with GCP_Client_Adaptive_Set_Limits. Setting a limit's minimum and maximum
+ * to the same value fixes that setting. Each decision is kept in a history, so how the settings converged can be
+ * retrieved with GCP_Client_Adaptive_Get_History.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_adaptive.h"
+
+/* defines */
+/**
+ * The length of time completed transfers are measured over before a decision is made, in seconds.
+ */
+#define ADAPTIVE_WINDOW_LENGTH                         (1.0)
+/**
+ * The number of completed transfers needed in a window before a decision is made.
+ */
+#define ADAPTIVE_WINDOW_MIN_SAMPLE_COUNT               (4)
+/**
+ * The number of round trips a chunk should take to transfer.
+ */
+#define ADAPTIVE_TARGET_RTT_MULTIPLE                   (8.0)
+/**
+ * The largest factor the chunk length changes by in one decision.
+ */
+#define ADAPTIVE_MAX_CHUNK_STEP                        (4)
+/**
+ * The fraction aggregate throughput must change by to count as an improvement (or a drop).
+ */
+#define ADAPTIVE_THROUGHPUT_TOLERANCE                  (0.05)
+/**
+ * The multiple of the smallest RTT the smoothed RTT must rise above before the parallelism backs off.
+ */
+#define ADAPTIVE_RTT_INFLATION                         (2.0)
+/**
+ * The weight a new RTT measurement is given in the smoothed RTT.
+ */
+#define ADAPTIVE_RTT_ALPHA                             (0.125)
+/**
+ * The number of decisions throughput must stay flat for, before a step up in parallelism is tried.
+ */
+#define ADAPTIVE_PROBE_DECISION_COUNT                  (10)
+/**
+ * The initial read part length (8 MB).
+ */
+#define ADAPTIVE_INITIAL_READ_CHUNK                    (8*1024*1024)
+/**
+ * The initial number of read parts in progress at once.
+ */
+#define ADAPTIVE_INITIAL_READ_PARALLEL                 (4)
+/**
+ * The initial upload chunk length (8 MB).
+ */
+#define ADAPTIVE_INITIAL_UPLOAD_CHUNK                  (8*1024*1024)
+/**
+ * The initial number of uploads in progress at once.
+ */
+#define ADAPTIVE_INITIAL_UPLOAD_PARALLEL               (8)
+
+/* data types */
+/**
+ * Data type holding the state of the controller for one transfer direction. This consists of the following:
+ * <dl>
+ * <dt>Min_Chunk_Length</dt> <dd>The smallest chunk length the controller can choose.</dd>
+ * <dt>Max_Chunk_Length</dt> <dd>The largest chunk length the controller can choose.</dd>
+ * <dt>Min_Parallelism</dt> <dd>The smallest parallelism the controller can choose.</dd>
+ * <dt>Max_Parallelism</dt> <dd>The largest parallelism the controller can choose.</dd>
+ * <dt>Chunk_Length</dt> <dd>The current chunk length.</dd>
+ * <dt>Parallelism</dt> <dd>The current parallelism.</dd>
+ * <dt>Start_Time</dt> <dd>When the controller was started (or reset).</dd>
+ * <dt>Window_Start</dt> <dd>When the current measurement window started, in seconds since Start_Time.</dd>
+ * <dt>Window_Byte_Count</dt> <dd>The number of bytes transferred in the current window.</dd>
+ * <dt>Window_Transfer_Time</dt> <dd>The sum of the transfer times in the current window, in seconds.</dd>
+ * <dt>Window_Sample_Count</dt> <dd>The number of transfers completed in the current window.</dd>
+ * <dt>RTT</dt> <dd>The smoothed RTT in seconds, or 0 if none has been measured.</dd>
+ * <dt>Min_RTT</dt> <dd>The smallest RTT measured in seconds, or 0 if none has been measured.</dd>
+ * <dt>Last_Throughput</dt> <dd>The aggregate throughput of the previous window, or 0 before the first decision.</dd>
+ * <dt>Last_Step</dt> <dd>The direction the parallelism last moved in: 1 up, -1 down, 0 unchanged.</dd>
+ * <dt>Hold_Count</dt> <dd>The number of decisions since the parallelism last moved.</dd>
+ * <dt>History</dt> <dd>A ring of the most recent decisions.</dd>
+ * <dt>History_Count</dt> <dd>The number of decisions made.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH
+ */
+struct Adaptive_Controller_Struct
+{
+	size_t Min_Chunk_Length;
+	size_t Max_Chunk_Length;
+	int Min_Parallelism;
+	int Max_Parallelism;
+	size_t Chunk_Length;
+	int Parallelism;
+	struct timespec Start_Time;
+	double Window_Start;
+	unsigned long long Window_Byte_Count;
+	double Window_Transfer_Time;
+	int Window_Sample_Count;
+	double RTT;
+	double Min_RTT;
+	double Last_Throughput;
+	int Last_Step;
+	int Hold_Count;
+	struct GCP_Client_Adaptive_Decision_Struct History[GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH];
+	unsigned long long History_Count;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Adaptive_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Adaptive_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+/**
+ * Mutex protecting the controllers.
+ */
+static pthread_mutex_t Adaptive_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * A boolean, TRUE once the controllers have been set to their defaults.
+ */
+static int Adaptive_Initialised = FALSE;
+/**
+ * The controller for each transfer direction.
+ * @see #Adaptive_Controller_Struct
+ * @see #GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT
+ */
+static struct Adaptive_Controller_Struct Adaptive_Controller_List[GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT];
+
+/* internal functions */
+static void Adaptive_Initialise(void);
+static void Adaptive_Controller_Reset(int direction);
+static void Adaptive_Decide(int direction,double now);
+static size_t Adaptive_Clamp_Chunk_Length(int direction,size_t chunk_length);
+static int Adaptive_Clamp_Parallelism(int direction,int parallelism);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Set the limits the controller for a transfer direction chooses it's settings within. The current settings are
+ * moved inside the new limits. Setting a minimum and maximum to the same value fixes that setting.
+ * Upload chunk lengths are rounded up to a multiple of GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM.
+ * @param direction The transfer direction, one of GCP_CLIENT_ADAPTIVE_DIRECTION_*.
+ * @param min_chunk_length The smallest chunk length, in bytes.
+ * @param max_chunk_length The largest chunk length, in bytes.
+ * @param min_parallelism The smallest number of transfers in progress at once.
+ * @param max_parallelism The largest number of transfers in progress at once.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Adaptive_Error_Number /
+ *         Adaptive_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT
+ * @see #GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM
+ * @see #Adaptive_Mutex
+ * @see #Adaptive_Controller_List
+ * @see #Adaptive_Initialise
+ * @see #Adaptive_Clamp_Chunk_Length
+ * @see #Adaptive_Clamp_Parallelism
+ */
+int GCP_Client_Adaptive_Set_Limits(int direction,size_t min_chunk_length,size_t max_chunk_length,
+				   int min_parallelism,int max_parallelism)
+{
+	struct Adaptive_Controller_Struct *controller = NULL;
+
+	Adaptive_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT))
+	{
+		Adaptive_Error_Number = 1;
+		sprintf(Adaptive_Error_String,"GCP_Client_Adaptive_Set_Limits: Illegal direction %d.",direction);
+		return FALSE;
+	}
+	if((min_chunk_length == 0)||(min_chunk_length > max_chunk_length))
+	{
+		Adaptive_Error_Number = 2;
+		sprintf(Adaptive_Error_String,"GCP_Client_Adaptive_Set_Limits: Illegal chunk length limits "
+			"(%lu to %lu).",min_chunk_length,max_chunk_length);
+		return FALSE;
+	}
+	if((min_parallelism < 1)||(min_parallelism > max_parallelism))
+	{
+		Adaptive_Error_Number = 3;
+		sprintf(Adaptive_Error_String,"GCP_Client_Adaptive_Set_Limits: Illegal parallelism limits (%d to %d).",
+			min_parallelism,max_parallelism);
+		return FALSE;
+	}
+	if(direction == GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD)
+	{
+		min_chunk_length = ((min_chunk_length+GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM-1)/
+				    GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM)*GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM;
+		max_chunk_length = ((max_chunk_length+GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM-1)/
+				    GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM)*GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM;
+	}
+	pthread_mutex_lock(&Adaptive_Mutex);
+	Adaptive_Initialise();
+	controller = &(Adaptive_Controller_List[direction]);
+	controller->Min_Chunk_Length = min_chunk_length;
+	controller->Max_Chunk_Length = max_chunk_length;
+	controller->Min_Parallelism = min_parallelism;
+	controller->Max_Parallelism = max_parallelism;
+	controller->Chunk_Length = Adaptive_Clamp_Chunk_Length(direction,controller->Chunk_Length);
+	controller->Parallelism = Adaptive_Clamp_Parallelism(direction,controller->Parallelism);
+	pthread_mutex_unlock(&Adaptive_Mutex);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_ADAPTIVE,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Adaptive_Set_Limits:Direction %d limits set to chunk length "
+					     "%lu to %lu bytes, parallelism %d to %d.",direction,min_chunk_length,
+					     max_chunk_length,min_parallelism,max_parallelism);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the limits the controller for a transfer direction chooses it's settings within.
+ * @param direction The transfer direction, one of GCP_CLIENT_ADAPTIVE_DIRECTION_*.
+ * @param min_chunk_length The address of a size_t to store the smallest chunk length in, or NULL.
+ * @param max_chunk_length The address of a size_t to store the largest chunk length in, or NULL.
+ * @param min_parallelism The address of an integer to store the smallest parallelism in, or NULL.
+ * @param max_parallelism The address of an integer to store the largest parallelism in, or NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Adaptive_Error_Number /
+ *         Adaptive_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT
+ * @see #Adaptive_Mutex
+ * @see #Adaptive_Controller_List
+ * @see #Adaptive_Initialise
+ */
+int GCP_Client_Adaptive_Get_Limits(int direction,size_t *min_chunk_length,size_t *max_chunk_length,
+				   int *min_parallelism,int *max_parallelism)
+{
+	struct Adaptive_Controller_Struct *controller = NULL;
+
+	Adaptive_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT))
+	{
+		Adaptive_Error_Number = 4;
+		sprintf(Adaptive_Error_String,"GCP_Client_Adaptive_Get_Limits: Illegal direction %d.",direction);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Adaptive_Mutex);
+	Adaptive_Initialise();
+	controller = &(Adaptive_Controller_List[direction]);
+	if(min_chunk_length != NULL)
+		(*min_chunk_length) = controller->Min_Chunk_Length;
+	if(max_chunk_length != NULL)
+		(*max_chunk_length) = controller->Max_Chunk_Length;
+	if(min_parallelism != NULL)
+		(*min_parallelism) = controller->Min_Parallelism;
+	if(max_parallelism != NULL)
+		(*max_parallelism) = controller->Max_Parallelism;
+	pthread_mutex_unlock(&Adaptive_Mutex);
+	return TRUE;
+}
+
+/**
+ * Get the current settings of the controller for a transfer direction. Transfers call this before starting each
+ * chunk (or part), so a running transfer follows the controller's decisions.
+ * @param direction The transfer direction, one of GCP_CLIENT_ADAPTIVE_DIRECTION_*.
+ * @param chunk_length The address of a size_t to store the chunk length in, or NULL.
+ * @param parallelism The address of an integer to store the number of transfers to have in progress at once in,
+ *        or NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Adaptive_Error_Number /
+ *         Adaptive_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT
+ * @see #Adaptive_Mutex
+ * @see #Adaptive_Controller_List
+ * @see #Adaptive_Initialise
+ */
+int GCP_Client_Adaptive_Get(int direction,size_t *chunk_length,int *parallelism)
+{
+	Adaptive_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT))
+	{
+		Adaptive_Error_Number = 5;
+		sprintf(Adaptive_Error_String,"GCP_Client_Adaptive_Get: Illegal direction %d.",direction);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Adaptive_Mutex);
+	Adaptive_Initialise();
+	if(chunk_length != NULL)
+		(*chunk_length) = Adaptive_Controller_List[direction].Chunk_Length;
+	if(parallelism != NULL)
+		(*parallelism) = Adaptive_Controller_List[direction].Parallelism;
+	pthread_mutex_unlock(&Adaptive_Mutex);
+	return TRUE;
+}
+
+/**
+ * Record a completed transfer (a chunk, part, or whole object) with the controller for it's direction. Once a
+ * window's worth of transfers have been recorded, the controller makes a new decision.
+ * @param direction The transfer direction, one of GCP_CLIENT_ADAPTIVE_DIRECTION_*. Illegal directions are ignored.
+ * @param byte_count The number of bytes transferred. Transfers of no bytes are ignored.
+ * @param transfer_time How long the transfer took, from the request being made to the last byte, in seconds.
+ * @param rtt The round trip time of the transfer (from the request being made to the first byte of the response),
+ *        in seconds, or 0 if it was not measured.
+ * @see #ADAPTIVE_WINDOW_LENGTH
+ * @see #ADAPTIVE_WINDOW_MIN_SAMPLE_COUNT
+ * @see #ADAPTIVE_RTT_ALPHA
+ * @see #Adaptive_Mutex
+ * @see #Adaptive_Controller_List
+ * @see #Adaptive_Initialise
+ * @see #Adaptive_Decide
+ */
+void GCP_Client_Adaptive_Record(int direction,unsigned long long byte_count,double transfer_time,double rtt)
+{
+	struct Adaptive_Controller_Struct *controller = NULL;
+	struct timespec current_time;
+	double now;
+
+	if((direction < 0)||(direction >= GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT)||(byte_count == 0))
+		return;
+	if(transfer_time < 0.0)
+		transfer_time = 0.0;
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	pthread_mutex_lock(&Adaptive_Mutex);
+	Adaptive_Initialise();
+	controller = &(Adaptive_Controller_List[direction]);
+	now = fdifftime(current_time,controller->Start_Time);
+	/* start the window when the first transfer in it started, so idle time before it is not counted */
+	if(controller->Window_Sample_Count == 0)
+		controller->Window_Start = now-transfer_time;
+	controller->Window_Byte_Count += byte_count;
+	controller->Window_Transfer_Time += transfer_time;
+	controller->Window_Sample_Count++;
+	if(rtt > 0.0)
+	{
+		if(controller->RTT == 0.0)
+			controller->RTT = rtt;
+		else
+			controller->RTT = ((1.0-ADAPTIVE_RTT_ALPHA)*controller->RTT)+(ADAPTIVE_RTT_ALPHA*rtt);
+		if((controller->Min_RTT == 0.0)||(rtt < controller->Min_RTT))
+			controller->Min_RTT = rtt;
+	}
+	if(((now-controller->Window_Start) >= ADAPTIVE_WINDOW_LENGTH)&&
+	   (controller->Window_Sample_Count >= ADAPTIVE_WINDOW_MIN_SAMPLE_COUNT))
+	{
+		Adaptive_Decide(direction,now);
+	}
+	pthread_mutex_unlock(&Adaptive_Mutex);
+}
+
+/**
+ * Get the most recent decisions made by the controller for a transfer direction, oldest first.
+ * @param direction The transfer direction, one of GCP_CLIENT_ADAPTIVE_DIRECTION_*.
+ * @param decision_list The address of an array of max_count decision structures to fill in.
+ * @param max_count The length of decision_list. At most GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH decisions are kept.
+ * @param count The address of an integer to store the number of decisions copied into decision_list.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Adaptive_Error_Number /
+ *         Adaptive_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT
+ * @see #GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH
+ * @see #Adaptive_Mutex
+ * @see #Adaptive_Controller_List
+ * @see #Adaptive_Initialise
+ */
+int GCP_Client_Adaptive_Get_History(int direction,struct GCP_Client_Adaptive_Decision_Struct *decision_list,
+				    int max_count,int *count)
+{
+	struct Adaptive_Controller_Struct *controller = NULL;
+	unsigned long long stored_count,first;
+
+	Adaptive_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT))
+	{
+		Adaptive_Error_Number = 6;
+		sprintf(Adaptive_Error_String,"GCP_Client_Adaptive_Get_History: Illegal direction %d.",direction);
+		return FALSE;
+	}
+	if(((decision_list == NULL)&&(max_count > 0))||(count == NULL))
+	{
+		Adaptive_Error_Number = 7;
+		sprintf(Adaptive_Error_String,"GCP_Client_Adaptive_Get_History: decision_list or count was NULL.");
+		return FALSE;
+	}
+	(*count) = 0;
+	pthread_mutex_lock(&Adaptive_Mutex);
+	Adaptive_Initialise();
+	controller = &(Adaptive_Controller_List[direction]);
+	stored_count = controller->History_Count;
+	if(stored_count > GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH)
+		stored_count = GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH;
+	if((max_count > 0)&&(stored_count > (unsigned long long)max_count))
+		stored_count = max_count;
+	if(max_count <= 0)
+		stored_count = 0;
+	first = controller->History_Count-stored_count;
+	for(unsigned long long i = 0; i < stored_count; i++)
+		decision_list[i] = controller->History[(first+i)%GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH];
+	pthread_mutex_unlock(&Adaptive_Mutex);
+	(*count) = (int)stored_count;
+	return TRUE;
+}
+
+/**
+ * Reset the controller for a transfer direction to it's initial settings, forgetting it's measurements and
+ * history. The limits are kept.
+ * @param direction The transfer direction, one of GCP_CLIENT_ADAPTIVE_DIRECTION_*.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Adaptive_Error_Number /
+ *         Adaptive_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT
+ * @see #Adaptive_Mutex
+ * @see #Adaptive_Initialise
+ * @see #Adaptive_Controller_Reset
+ */
+int GCP_Client_Adaptive_Reset(int direction)
+{
+	Adaptive_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT))
+	{
+		Adaptive_Error_Number = 8;
+		sprintf(Adaptive_Error_String,"GCP_Client_Adaptive_Reset: Illegal direction %d.",direction);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Adaptive_Mutex);
+	Adaptive_Initialise();
+	Adaptive_Controller_Reset(direction);
+	pthread_mutex_unlock(&Adaptive_Mutex);
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_adaptive error number.
+ * @return The current value of the gcp_client_adaptive error number.
+ * @see #Adaptive_Error_Number
+ */
+int GCP_Client_Adaptive_Get_Error_Number(void)
+{
+	return Adaptive_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Adaptive_Error_Number
+ * @see #Adaptive_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Adaptive_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Adaptive_Error_Number == 0)
+		sprintf(Adaptive_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Adaptive:Error(%d) : %s\n",time_string,Adaptive_Error_Number,
+		Adaptive_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Adaptive_Error_Number
+ * @see #Adaptive_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Adaptive_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Adaptive_Error_Number == 0)
+		sprintf(Adaptive_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Adaptive:Error(%d) : %s\n",time_string,
+		Adaptive_Error_Number,Adaptive_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Set the controllers to their default limits and initial settings, the first time any routine uses them.
+ * Called with Adaptive_Mutex held.
+ * @see #Adaptive_Initialised
+ * @see #Adaptive_Controller_List
+ * @see #Adaptive_Controller_Reset
+ */
+static void Adaptive_Initialise(void)
+{
+	struct Adaptive_Controller_Struct *controller = NULL;
+
+	if(Adaptive_Initialised)
+		return;
+	controller = &(Adaptive_Controller_List[GCP_CLIENT_ADAPTIVE_DIRECTION_READ]);
+	controller->Min_Chunk_Length = GCP_CLIENT_ADAPTIVE_DEFAULT_READ_MIN_CHUNK;
+	controller->Max_Chunk_Length = GCP_CLIENT_ADAPTIVE_DEFAULT_READ_MAX_CHUNK;
+	controller->Min_Parallelism = 1;
+	controller->Max_Parallelism = GCP_CLIENT_ADAPTIVE_DEFAULT_READ_MAX_PARALLEL;
+	Adaptive_Controller_Reset(GCP_CLIENT_ADAPTIVE_DIRECTION_READ);
+	controller = &(Adaptive_Controller_List[GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD]);
+	controller->Min_Chunk_Length = GCP_CLIENT_ADAPTIVE_DEFAULT_UPLOAD_MIN_CHUNK;
+	controller->Max_Chunk_Length = GCP_CLIENT_ADAPTIVE_DEFAULT_UPLOAD_MAX_CHUNK;
+	controller->Min_Parallelism = 1;
+	controller->Max_Parallelism = GCP_CLIENT_ADAPTIVE_DEFAULT_UPLOAD_MAX_PARALLEL;
+	Adaptive_Controller_Reset(GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD);
+	Adaptive_Initialised = TRUE;
+}
+
+/**
+ * Reset a controller to it's initial settings (within it's limits), and forget it's measurements and history.
+ * Called with Adaptive_Mutex held.
+ * @param direction The transfer direction.
+ * @see #ADAPTIVE_INITIAL_READ_CHUNK
+ * @see #ADAPTIVE_INITIAL_READ_PARALLEL
+ * @see #ADAPTIVE_INITIAL_UPLOAD_CHUNK
+ * @see #ADAPTIVE_INITIAL_UPLOAD_PARALLEL
+ * @see #Adaptive_Controller_List
+ * @see #Adaptive_Clamp_Chunk_Length
+ * @see #Adaptive_Clamp_Parallelism
+ */
+static void Adaptive_Controller_Reset(int direction)
+{
+	struct Adaptive_Controller_Struct *controller = NULL;
+
+	controller = &(Adaptive_Controller_List[direction]);
+	if(direction == GCP_CLIENT_ADAPTIVE_DIRECTION_READ)
+	{
+		controller->Chunk_Length = Adaptive_Clamp_Chunk_Length(direction,ADAPTIVE_INITIAL_READ_CHUNK);
+		controller->Parallelism = Adaptive_Clamp_Parallelism(direction,ADAPTIVE_INITIAL_READ_PARALLEL);
+	}
+	else
+	{
+		controller->Chunk_Length = Adaptive_Clamp_Chunk_Length(direction,ADAPTIVE_INITIAL_UPLOAD_CHUNK);
+		controller->Parallelism = Adaptive_Clamp_Parallelism(direction,ADAPTIVE_INITIAL_UPLOAD_PARALLEL);
+	}
+	clock_gettime(CLOCK_MONOTONIC,&(controller->Start_Time));
+	controller->Window_Start = 0.0;
+	controller->Window_Byte_Count = 0;
+	controller->Window_Transfer_Time = 0.0;
+	controller->Window_Sample_Count = 0;
+	controller->RTT = 0.0;
+	controller->Min_RTT = 0.0;
+	controller->Last_Throughput = 0.0;
+	controller->Last_Step = 0;
+	controller->Hold_Count = 0;
+	controller->History_Count = 0;
+}
+
+/**
+ * Make a decision from the transfers recorded in the current window: choose a new chunk length and parallelism,
+ * add the decision to the history, and start a new window. Called with Adaptive_Mutex held.
+ * @param direction The transfer direction.
+ * @param now The current time, in seconds since the controller's Start_Time.
+ * @see #ADAPTIVE_TARGET_RTT_MULTIPLE
+ * @see #ADAPTIVE_MAX_CHUNK_STEP
+ * @see #ADAPTIVE_THROUGHPUT_TOLERANCE
+ * @see #ADAPTIVE_RTT_INFLATION
+ * @see #ADAPTIVE_PROBE_DECISION_COUNT
+ * @see #Adaptive_Controller_List
+ * @see #Adaptive_Clamp_Chunk_Length
+ * @see #Adaptive_Clamp_Parallelism
+ */
+static void Adaptive_Decide(int direction,double now)
+{
+	struct Adaptive_Controller_Struct *controller = NULL;
+	struct GCP_Client_Adaptive_Decision_Struct *decision = NULL;
+	double throughput,stream_throughput,target_length;
+	size_t chunk_length;
+	int congested,step,parallelism;
+
+	controller = &(Adaptive_Controller_List[direction]);
+	throughput = ((double)controller->Window_Byte_Count)/(now-controller->Window_Start);
+	if(controller->Window_Transfer_Time > 0.0)
+		stream_throughput = ((double)controller->Window_Byte_Count)/controller->Window_Transfer_Time;
+	else
+		stream_throughput = throughput;
+	/* chunk length: enough bytes to keep one transfer streaming for several round trips, rounded to the
+	** nearest power of two so small changes in the measurements do not change it */
+	if(controller->Min_RTT > 0.0)
+	{
+		target_length = stream_throughput*controller->Min_RTT*ADAPTIVE_TARGET_RTT_MULTIPLE;
+		chunk_length = 1;
+		while((chunk_length < (((size_t)1)<<62))&&(((double)(chunk_length*2)) <= target_length))
+			chunk_length *= 2;
+		if(target_length >= (1.5*((double)chunk_length)))
+			chunk_length *= 2;
+		if(chunk_length > (controller->Chunk_Length*ADAPTIVE_MAX_CHUNK_STEP))
+			chunk_length = controller->Chunk_Length*ADAPTIVE_MAX_CHUNK_STEP;
+		if(chunk_length < (controller->Chunk_Length/ADAPTIVE_MAX_CHUNK_STEP))
+			chunk_length = controller->Chunk_Length/ADAPTIVE_MAX_CHUNK_STEP;
+		controller->Chunk_Length = Adaptive_Clamp_Chunk_Length(direction,chunk_length);
+	}
+	/* parallelism: hill climb on aggregate throughput, backing off when the RTT inflates */
+	congested = ((controller->Min_RTT > 0.0)&&(controller->RTT > (ADAPTIVE_RTT_INFLATION*controller->Min_RTT)));
+	if(congested)
+		step = -1;
+	else if(controller->Last_Throughput == 0.0)
+		step = 1;
+	else if(throughput > (controller->Last_Throughput*(1.0+ADAPTIVE_THROUGHPUT_TOLERANCE)))
+	{
+		/* keep going the way that helped */
+		if(controller->Last_Step < 0)
+			step = -1;
+		else
+			step = 1;
+	}
+	else if(throughput < (controller->Last_Throughput*(1.0-ADAPTIVE_THROUGHPUT_TOLERANCE)))
+	{
+		/* undo the last move, if there was one, otherwise something else changed: wait and see */
+		step = -controller->Last_Step;
+	}
+	else if(controller->Hold_Count >= ADAPTIVE_PROBE_DECISION_COUNT)
+		step = 1;
+	else
+		step = 0;
+	parallelism = controller->Parallelism;
+	if(step > 0)
+	{
+		parallelism = (parallelism*3)/2;
+		if(parallelism <= controller->Parallelism)
+			parallelism = controller->Parallelism+1;
+	}
+	else if(step < 0)
+	{
+		parallelism = (parallelism*3)/4;
+		if(parallelism >= controller->Parallelism)
+			parallelism = controller->Parallelism-1;
+	}
+	parallelism = Adaptive_Clamp_Parallelism(direction,parallelism);
+	if(parallelism > controller->Parallelism)
+		controller->Last_Step = 1;
+	else if(parallelism < controller->Parallelism)
+		controller->Last_Step = -1;
+	else
+		controller->Last_Step = 0;
+	if(controller->Last_Step == 0)
+		controller->Hold_Count++;
+	else
+		controller->Hold_Count = 0;
+	controller->Parallelism = parallelism;
+	controller->Last_Throughput = throughput;
+	/* record the decision */
+	decision = &(controller->History[controller->History_Count%GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH]);
+	decision->Time = now;
+	decision->Throughput = throughput;
+	decision->Stream_Throughput = stream_throughput;
+	decision->RTT = controller->RTT;
+	decision->Min_RTT = controller->Min_RTT;
+	decision->Chunk_Length = controller->Chunk_Length;
+	decision->Parallelism = controller->Parallelism;
+	decision->Sample_Count = controller->Window_Sample_Count;
+	controller->History_Count++;
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_ADAPTIVE,LOG_VERBOSITY_VERBOSE,
+					     "Adaptive_Decide:Direction %d: throughput %.0f bytes/s (stream %.0f bytes/s), "
+					     "RTT %.6f s (min %.6f s) over %d transfers: chunk length %lu bytes, "
+					     "parallelism %d.",direction,throughput,stream_throughput,controller->RTT,
+					     controller->Min_RTT,controller->Window_Sample_Count,controller->Chunk_Length,
+					     controller->Parallelism);
+#endif
+	/* start a new window */
+	controller->Window_Start = now;
+	controller->Window_Byte_Count = 0;
+	controller->Window_Transfer_Time = 0.0;
+	controller->Window_Sample_Count = 0;
+}
+
+/**
+ * Keep a chunk length within a controller's limits. Called with Adaptive_Mutex held.
+ * @param direction The transfer direction.
+ * @param chunk_length The chunk length to clamp.
+ * @return The chunk length, within the controller's limits.
+ * @see #Adaptive_Controller_List
+ */
+static size_t Adaptive_Clamp_Chunk_Length(int direction,size_t chunk_length)
+{
+	if(chunk_length < Adaptive_Controller_List[direction].Min_Chunk_Length)
+		return Adaptive_Controller_List[direction].Min_Chunk_Length;
+	if(chunk_length > Adaptive_Controller_List[direction].Max_Chunk_Length)
+		return Adaptive_Controller_List[direction].Max_Chunk_Length;
+	return chunk_length;
+}
+
+/**
+ * Keep a parallelism within a controller's limits. Called with Adaptive_Mutex held.
+ * @param direction The transfer direction.
+ * @param parallelism The parallelism to clamp.
+ * @return The parallelism, within the controller's limits.
+ * @see #Adaptive_Controller_List
+ */
+static int Adaptive_Clamp_Parallelism(int direction,int parallelism)
+{
+	if(parallelism < Adaptive_Controller_List[direction].Min_Parallelism)
+		return Adaptive_Controller_List[direction].Min_Parallelism;
+	if(parallelism > Adaptive_Controller_List[direction].Max_Parallelism)
+		return Adaptive_Controller_List[direction].Max_Parallelism;
+	return parallelism;
+}
@@ -0,0 +1,596 @@
+/* gcp_client_bandwidth.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Token bucket bandwidth limiter routines.
+*/
+/**
+ * Routines limiting the library wide upload and download bandwidth, so transfers do not saturate a shared link.
+ * Each direction has a token bucket: tokens (bytes) are added at the limit rate, up to the burst size, and a
+ * transfer takes tokens for the bytes it moves, waiting when there are not enough. The transfer routines take
+ * tokens a part (at most READ_WRITE_BUFFER_RESIZE_LENGTH bytes) at a time, for downloads after each part is received
+ * and for uploads before each part is sent, so every transfer path is limited without the library's APIs changing.
+ * The limits can be changed at any time, and waiting transfers pick the new limit up straight away.
+ * <p>
+ * Each thread has a priority class (GCP_CLIENT_BANDWIDTH_PRIORITY_*), set with
+ * GCP_Client_Bandwidth_Set_Thread_Priority, which the threads the library starts for it (batches, parallel and
+ * hedged reads, syncs) inherit. Waiting transfers are granted tokens strictly in priority order, and in the order
+ * they asked within a class. A lower priority transfer gives way to a higher priority one between parts, so
+ * bulk transfers only use the bandwidth the higher classes leave.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <algorithm>
+#include <deque>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_bandwidth.h"
+
+/* defines */
+/**
+ * The default burst size, as a fraction of a second at the limit rate.
+ */
+#define BANDWIDTH_DEFAULT_BURST_TIME    (0.25)
+/**
+ * The smallest burst size, in bytes (64 KB).
+ */
+#define BANDWIDTH_MIN_BURST             (64*1024)
+/**
+ * The length of the window achieved rates are measured over, in seconds.
+ */
+#define BANDWIDTH_RATE_WINDOW           (1.0)
+/**
+ * The longest a waiting transfer sleeps before re-checking whether it is it's turn, in seconds.
+ */
+#define BANDWIDTH_MAX_WAIT              (0.1)
+
+/* data types */
+/**
+ * Data type holding the token bucket of one transfer direction. This consists of the following:
+ * <dl>
+ * <dt>Stats</dt> <dd>The limit, burst size and statistics reported by GCP_Client_Bandwidth_Get_Stats.</dd>
+ * <dt>Tokens</dt> <dd>The number of bytes that can be transferred now.</dd>
+ * <dt>Refill_Time</dt> <dd>The (CLOCK_MONOTONIC) time tokens were last added.</dd>
+ * <dt>Next_Ticket</dt> <dd>The ticket the next transfer to wait is given.</dd>
+ * <dt>Queue</dt> <dd>For each priority class, the tickets of the waiting transfers, in the order they asked.</dd>
+ * <dt>Window_Start_Time</dt> <dd>The (CLOCK_MONOTONIC) time the current rate measurement window started.</dd>
+ * <dt>Window_Byte_Count</dt> <dd>For each priority class, the bytes transferred in the current window.</dd>
+ * <dt>Condition</dt> <dd>Condition variable, broadcast when the limit changes or a waiting transfer is done.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT
+ */
+struct Bandwidth_Bucket_Struct
+{
+	struct GCP_Client_Bandwidth_Stats_Struct Stats;
+	double Tokens;
+	struct timespec Refill_Time;
+	unsigned long long Next_Ticket;
+	std::deque<unsigned long long> Queue[GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT];
+	struct timespec Window_Start_Time;
+	unsigned long long Window_Byte_Count[GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT];
+	pthread_cond_t Condition;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Bandwidth_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Bandwidth_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+/**
+ * The priority class of transfers made by the current thread.
+ * @see #GCP_CLIENT_BANDWIDTH_PRIORITY_NORMAL
+ */
+static thread_local int Bandwidth_Thread_Priority = GCP_CLIENT_BANDWIDTH_PRIORITY_NORMAL;
+/**
+ * Mutex protecting the token buckets.
+ */
+static pthread_mutex_t Bandwidth_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * A boolean, TRUE once the token buckets have been initialised.
+ */
+static int Bandwidth_Initialised = FALSE;
+/**
+ * The token bucket of each transfer direction. By default neither direction is limited.
+ * @see #GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT
+ */
+static struct Bandwidth_Bucket_Struct Bandwidth_Bucket_List[GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT];
+/**
+ * The names of the priority classes, indexed by priority.
+ * @see #GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT
+ */
+static const char *Bandwidth_Priority_Name_List[GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT] = {"high","normal","bulk"};
+
+/* internal functions */
+static void Bandwidth_Initialise(void);
+static void Bandwidth_Refill(struct Bandwidth_Bucket_Struct *bucket,struct timespec current_time);
+static void Bandwidth_Rate_Update(struct Bandwidth_Bucket_Struct *bucket,struct timespec current_time);
+static int Bandwidth_Is_Turn(struct Bandwidth_Bucket_Struct *bucket,int priority,unsigned long long ticket);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Set the bandwidth limit of a transfer direction. This can be called at any time, for instance to open the
+ * limit up fully during the day. Transfers waiting for bandwidth are woken to use the new limit.
+ * @param direction The transfer direction, GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD or
+ *        GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD.
+ * @param limit The limit in bytes per second, or GCP_CLIENT_BANDWIDTH_UNLIMITED.
+ * @param burst The token bucket size in bytes, or 0 to use BANDWIDTH_DEFAULT_BURST_TIME seconds at the limit rate
+ *        (at least BANDWIDTH_MIN_BURST bytes).
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Bandwidth_Bucket_List
+ * @see #Bandwidth_Initialise
+ * @see #Bandwidth_Refill
+ * @see #BANDWIDTH_DEFAULT_BURST_TIME
+ * @see #BANDWIDTH_MIN_BURST
+ */
+int GCP_Client_Bandwidth_Set_Limit(int direction,unsigned long long limit,unsigned long long burst)
+{
+	struct Bandwidth_Bucket_Struct *bucket = NULL;
+	struct timespec current_time;
+
+	Bandwidth_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT))
+	{
+		Bandwidth_Error_Number = 1;
+		sprintf(Bandwidth_Error_String,"GCP_Client_Bandwidth_Set_Limit:Illegal direction %d.",direction);
+		return FALSE;
+	}
+	if((limit != GCP_CLIENT_BANDWIDTH_UNLIMITED)&&(burst == 0))
+	{
+		burst = (unsigned long long)(limit*BANDWIDTH_DEFAULT_BURST_TIME);
+		if(burst < BANDWIDTH_MIN_BURST)
+			burst = BANDWIDTH_MIN_BURST;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	pthread_mutex_lock(&Bandwidth_Mutex);
+	Bandwidth_Initialise();
+	bucket = &(Bandwidth_Bucket_List[direction]);
+	/* add the tokens due at the old rate, then start the new rate from now */
+	Bandwidth_Refill(bucket,current_time);
+	if(bucket->Stats.Limit == GCP_CLIENT_BANDWIDTH_UNLIMITED)
+		bucket->Tokens = burst;
+	bucket->Stats.Limit = limit;
+	bucket->Stats.Burst = burst;
+	if(bucket->Tokens > burst)
+		bucket->Tokens = burst;
+	pthread_cond_broadcast(&(bucket->Condition));
+	pthread_mutex_unlock(&Bandwidth_Mutex);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_BANDWIDTH,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Bandwidth_Set_Limit:Direction %d limited to %llu bytes/s "
+					     "(burst %llu bytes).",direction,limit,burst);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the bandwidth limit of a transfer direction.
+ * @param direction The transfer direction, GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD or
+ *        GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD.
+ * @param limit The address of an integer to fill in with the limit in bytes per second (or
+ *        GCP_CLIENT_BANDWIDTH_UNLIMITED). Can be NULL.
+ * @param burst The address of an integer to fill in with the token bucket size in bytes. Can be NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Bandwidth_Bucket_List
+ */
+int GCP_Client_Bandwidth_Get_Limit(int direction,unsigned long long *limit,unsigned long long *burst)
+{
+	Bandwidth_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT))
+	{
+		Bandwidth_Error_Number = 2;
+		sprintf(Bandwidth_Error_String,"GCP_Client_Bandwidth_Get_Limit:Illegal direction %d.",direction);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Bandwidth_Mutex);
+	Bandwidth_Initialise();
+	if(limit != NULL)
+		(*limit) = Bandwidth_Bucket_List[direction].Stats.Limit;
+	if(burst != NULL)
+		(*burst) = Bandwidth_Bucket_List[direction].Stats.Burst;
+	pthread_mutex_unlock(&Bandwidth_Mutex);
+	return TRUE;
+}
+
+/**
+ * Set the priority class of transfers made by the calling thread. Threads the library starts to carry out a
+ * transfer (or batch of transfers) for the calling thread inherit it's priority class.
+ * @param priority The priority class, one of GCP_CLIENT_BANDWIDTH_PRIORITY_*.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Bandwidth_Thread_Priority
+ */
+int GCP_Client_Bandwidth_Set_Thread_Priority(int priority)
+{
+	Bandwidth_Error_Number = 0;
+	if((priority < 0)||(priority >= GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT))
+	{
+		Bandwidth_Error_Number = 3;
+		sprintf(Bandwidth_Error_String,"GCP_Client_Bandwidth_Set_Thread_Priority:Illegal priority %d.",priority);
+		return FALSE;
+	}
+	Bandwidth_Thread_Priority = priority;
+	return TRUE;
+}
+
+/**
+ * Get the priority class of transfers made by the calling thread.
+ * @return The priority class, one of GCP_CLIENT_BANDWIDTH_PRIORITY_*.
+ * @see #Bandwidth_Thread_Priority
+ */
+int GCP_Client_Bandwidth_Get_Thread_Priority(void)
+{
+	return Bandwidth_Thread_Priority;
+}
+
+/**
+ * Take bandwidth for a number of bytes in a transfer direction, in the calling thread's priority class. If the
+ * direction is limited, this waits until enough tokens have built up, it is the calling transfer's turn in it's
+ * class, and no higher priority transfer is waiting. Lengths longer than the burst size are taken a burst at a
+ * time, giving way to higher priority transfers between bursts. If the limit is removed whilst waiting, the
+ * routine returns straight away. The bytes are added to the direction's statistics whether or not it is limited.
+ * @param direction The transfer direction, GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD or
+ *        GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD.
+ * @param byte_count The number of bytes being transferred.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Bandwidth_Bucket_List
+ * @see #Bandwidth_Thread_Priority
+ * @see #Bandwidth_Initialise
+ * @see #Bandwidth_Refill
+ * @see #Bandwidth_Rate_Update
+ * @see #Bandwidth_Is_Turn
+ * @see #BANDWIDTH_MAX_WAIT
+ * @see gcp_client_general.html#fdifftime
+ */
+int GCP_Client_Bandwidth_Acquire(int direction,unsigned long long byte_count)
+{
+	struct Bandwidth_Bucket_Struct *bucket = NULL;
+	struct timespec start_time,current_time,deadline;
+	unsigned long long ticket,remaining,piece;
+	double wait_time;
+	int priority;
+
+	Bandwidth_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT))
+	{
+		Bandwidth_Error_Number = 4;
+		sprintf(Bandwidth_Error_String,"GCP_Client_Bandwidth_Acquire:Illegal direction %d.",direction);
+		return FALSE;
+	}
+	if(byte_count == 0)
+		return TRUE;
+	priority = Bandwidth_Thread_Priority;
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	current_time = start_time;
+	pthread_mutex_lock(&Bandwidth_Mutex);
+	Bandwidth_Initialise();
+	bucket = &(Bandwidth_Bucket_List[direction]);
+	if(bucket->Stats.Limit != GCP_CLIENT_BANDWIDTH_UNLIMITED)
+	{
+		ticket = bucket->Next_Ticket++;
+		bucket->Queue[priority].push_back(ticket);
+		bucket->Stats.Waiting_Count[priority]++;
+		remaining = byte_count;
+		while((remaining > 0)&&(bucket->Stats.Limit != GCP_CLIENT_BANDWIDTH_UNLIMITED))
+		{
+			Bandwidth_Refill(bucket,current_time);
+			if(Bandwidth_Is_Turn(bucket,priority,ticket))
+			{
+				piece = remaining;
+				if(piece > bucket->Stats.Burst)
+					piece = bucket->Stats.Burst;
+				if(bucket->Tokens >= piece)
+				{
+					bucket->Tokens -= piece;
+					remaining -= piece;
+					continue;
+				}
+				wait_time = (piece-bucket->Tokens)/((double)bucket->Stats.Limit);
+				if(wait_time > BANDWIDTH_MAX_WAIT)
+					wait_time = BANDWIDTH_MAX_WAIT;
+			}
+			else
+				wait_time = BANDWIDTH_MAX_WAIT;
+			clock_gettime(CLOCK_REALTIME,&deadline);
+			deadline.tv_nsec += (long)(wait_time*GCP_CLIENT_GENERAL_ONE_SECOND_NS)+1;
+			deadline.tv_sec += deadline.tv_nsec/GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+			deadline.tv_nsec %= GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+			pthread_cond_timedwait(&(bucket->Condition),&Bandwidth_Mutex,&deadline);
+			clock_gettime(CLOCK_MONOTONIC,&current_time);
+		}
+		/* the next transfer in this class (or a lower class) can now have it's turn */
+		bucket->Queue[priority].erase(std::find(bucket->Queue[priority].begin(),bucket->Queue[priority].end(),
+							ticket));
+		bucket->Stats.Waiting_Count[priority]--;
+		bucket->Stats.Wait_Time[priority] += fdifftime(current_time,start_time);
+		pthread_cond_broadcast(&(bucket->Condition));
+	}
+	bucket->Stats.Byte_Count[priority] += byte_count;
+	bucket->Window_Byte_Count[priority] += byte_count;
+	Bandwidth_Rate_Update(bucket,current_time);
+	pthread_mutex_unlock(&Bandwidth_Mutex);
+	return TRUE;
+}
+
+/**
+ * Get the bandwidth statistics of a transfer direction, including the rate each priority class achieved.
+ * @param direction The transfer direction, GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD or
+ *        GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD.
+ * @param stats The address of a structure to fill in with the statistics.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Bandwidth_Bucket_List
+ * @see #Bandwidth_Rate_Update
+ */
+int GCP_Client_Bandwidth_Get_Stats(int direction,struct GCP_Client_Bandwidth_Stats_Struct *stats)
+{
+	struct timespec current_time;
+
+	Bandwidth_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT))
+	{
+		Bandwidth_Error_Number = 5;
+		sprintf(Bandwidth_Error_String,"GCP_Client_Bandwidth_Get_Stats:Illegal direction %d.",direction);
+		return FALSE;
+	}
+	if(stats == NULL)
+	{
+		Bandwidth_Error_Number = 6;
+		sprintf(Bandwidth_Error_String,"GCP_Client_Bandwidth_Get_Stats:stats was NULL.");
+		return FALSE;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	pthread_mutex_lock(&Bandwidth_Mutex);
+	Bandwidth_Initialise();
+	Bandwidth_Rate_Update(&(Bandwidth_Bucket_List[direction]),current_time);
+	(*stats) = Bandwidth_Bucket_List[direction].Stats;
+	pthread_mutex_unlock(&Bandwidth_Mutex);
+	return TRUE;
+}
+
+/**
+ * Reset the byte counts, rates and wait times of a transfer direction. The limit is kept.
+ * @param direction The transfer direction, GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD or
+ *        GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Bandwidth_Bucket_List
+ */
+int GCP_Client_Bandwidth_Reset_Stats(int direction)
+{
+	struct Bandwidth_Bucket_Struct *bucket = NULL;
+	int i;
+
+	Bandwidth_Error_Number = 0;
+	if((direction < 0)||(direction >= GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT))
+	{
+		Bandwidth_Error_Number = 7;
+		sprintf(Bandwidth_Error_String,"GCP_Client_Bandwidth_Reset_Stats:Illegal direction %d.",direction);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Bandwidth_Mutex);
+	Bandwidth_Initialise();
+	bucket = &(Bandwidth_Bucket_List[direction]);
+	for(i = 0; i < GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT; i++)
+	{
+		bucket->Stats.Byte_Count[i] = 0;
+		bucket->Stats.Rate[i] = 0.0;
+		bucket->Stats.Wait_Time[i] = 0.0;
+		bucket->Window_Byte_Count[i] = 0;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&(bucket->Window_Start_Time));
+	pthread_mutex_unlock(&Bandwidth_Mutex);
+	return TRUE;
+}
+
+/**
+ * Return the name of a priority class.
+ * @param priority The priority class, one of GCP_CLIENT_BANDWIDTH_PRIORITY_*.
+ * @return The name ("high", "normal" or "bulk"), or "unknown".
+ * @see #Bandwidth_Priority_Name_List
+ */
+const char *GCP_Client_Bandwidth_Priority_To_String(int priority)
+{
+	if((priority < 0)||(priority >= GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT))
+		return "unknown";
+	return Bandwidth_Priority_Name_List[priority];
+}
+
+/**
+ * Parse the name of a priority class (as returned by GCP_Client_Bandwidth_Priority_To_String, in any case).
+ * @param string The string to parse.
+ * @param priority The address of an integer to fill in with the priority class.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Bandwidth_Priority_Name_List
+ */
+int GCP_Client_Bandwidth_Priority_Parse(const char *string,int *priority)
+{
+	int i;
+
+	Bandwidth_Error_Number = 0;
+	if((string == NULL)||(priority == NULL))
+	{
+		Bandwidth_Error_Number = 8;
+		sprintf(Bandwidth_Error_String,"GCP_Client_Bandwidth_Priority_Parse:string or priority was NULL.");
+		return FALSE;
+	}
+	for(i = 0; i < GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT; i++)
+	{
+		if(strcasecmp(string,Bandwidth_Priority_Name_List[i]) == 0)
+		{
+			(*priority) = i;
+			return TRUE;
+		}
+	}
+	Bandwidth_Error_Number = 9;
+	snprintf(Bandwidth_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+		 "GCP_Client_Bandwidth_Priority_Parse:Unknown priority '%s'.",string);
+	return FALSE;
+}
+
+/**
+ * Get the current value of the bandwidth module's error number.
+ * @return The current value of the bandwidth module's error number.
+ * @see #Bandwidth_Error_Number
+ */
+int GCP_Client_Bandwidth_Get_Error_Number(void)
+{
+	return Bandwidth_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Bandwidth_Error_Number
+ * @see #Bandwidth_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Bandwidth_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Bandwidth_Error_Number == 0)
+		sprintf(Bandwidth_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Bandwidth:Error(%d) : %s\n",time_string,Bandwidth_Error_Number,
+		Bandwidth_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Bandwidth_Error_Number
+ * @see #Bandwidth_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Bandwidth_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Bandwidth_Error_Number == 0)
+		sprintf(Bandwidth_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Bandwidth:Error(%d) : %s\n",time_string,
+		Bandwidth_Error_Number,Bandwidth_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Initialise the token buckets, if they have not already been. Called with Bandwidth_Mutex held.
+ * @see #Bandwidth_Initialised
+ * @see #Bandwidth_Bucket_List
+ */
+static void Bandwidth_Initialise(void)
+{
+	struct timespec current_time;
+	int i;
+
+	if(Bandwidth_Initialised)
+		return;
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	for(i = 0; i < GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT; i++)
+	{
+		memset(&(Bandwidth_Bucket_List[i].Stats),0,sizeof(struct GCP_Client_Bandwidth_Stats_Struct));
+		Bandwidth_Bucket_List[i].Stats.Limit = GCP_CLIENT_BANDWIDTH_UNLIMITED;
+		Bandwidth_Bucket_List[i].Tokens = 0.0;
+		Bandwidth_Bucket_List[i].Refill_Time = current_time;
+		Bandwidth_Bucket_List[i].Next_Ticket = 0;
+		Bandwidth_Bucket_List[i].Window_Start_Time = current_time;
+		memset(Bandwidth_Bucket_List[i].Window_Byte_Count,0,sizeof(Bandwidth_Bucket_List[i].Window_Byte_Count));
+		pthread_cond_init(&(Bandwidth_Bucket_List[i].Condition),NULL);
+	}
+	Bandwidth_Initialised = TRUE;
+}
+
+/**
+ * Add the tokens that have built up since the bucket was last refilled, up to the burst size.
+ * Called with Bandwidth_Mutex held.
+ * @param bucket The token bucket.
+ * @param current_time The current (CLOCK_MONOTONIC) time.
+ * @see #Bandwidth_Bucket_Struct
+ * @see gcp_client_general.html#fdifftime
+ */
+static void Bandwidth_Refill(struct Bandwidth_Bucket_Struct *bucket,struct timespec current_time)
+{
+	double elapsed;
+
+	elapsed = fdifftime(current_time,bucket->Refill_Time);
+	if(elapsed > 0.0)
+	{
+		bucket->Tokens += elapsed*bucket->Stats.Limit;
+		if(bucket->Tokens > bucket->Stats.Burst)
+			bucket->Tokens = bucket->Stats.Burst;
+		bucket->Refill_Time = current_time;
+	}
+}
+
+/**
+ * If the current rate measurement window has ended, calculate each priority class's achieved rate over it, and
+ * start a new window. Called with Bandwidth_Mutex held.
+ * @param bucket The token bucket.
+ * @param current_time The current (CLOCK_MONOTONIC) time.
+ * @see #Bandwidth_Bucket_Struct
+ * @see #BANDWIDTH_RATE_WINDOW
+ * @see gcp_client_general.html#fdifftime
+ */
+static void Bandwidth_Rate_Update(struct Bandwidth_Bucket_Struct *bucket,struct timespec current_time)
+{
+	double elapsed;
+	int i;
+
+	elapsed = fdifftime(current_time,bucket->Window_Start_Time);
+	if(elapsed < BANDWIDTH_RATE_WINDOW)
+		return;
+	for(i = 0; i < GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT; i++)
+	{
+		bucket->Stats.Rate[i] = bucket->Window_Byte_Count[i]/elapsed;
+		bucket->Window_Byte_Count[i] = 0;
+	}
+	bucket->Window_Start_Time = current_time;
+}
+
+/**
+ * Return whether it is a waiting transfer's turn to take tokens: it is first in it's priority class, and no
+ * transfer in a higher priority class is waiting. Called with Bandwidth_Mutex held.
+ * @param bucket The token bucket.
+ * @param priority The transfer's priority class.
+ * @param ticket The transfer's ticket in it's priority class.
+ * @return TRUE if it is the transfer's turn, FALSE if it must wait.
+ * @see #Bandwidth_Bucket_Struct
+ */
+static int Bandwidth_Is_Turn(struct Bandwidth_Bucket_Struct *bucket,int priority,unsigned long long ticket)
+{
+	int i;
+
+	if(bucket->Queue[priority].front() != ticket)
+		return FALSE;
+	for(i = 0; i < priority; i++)
+	{
+		if(bucket->Stats.Waiting_Count[i] > 0)
+			return FALSE;
+	}
+	return TRUE;
+}
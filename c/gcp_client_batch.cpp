@@ -0,0 +1,237 @@
+/* gcp_client_batch.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Bounded concurrency batch runner.
+*/
+/**
+ * Routines to run an operation over a batch of items (usually objects) on a bounded number of threads.
+ * Each thread repeatedly claims the next unprocessed item index with an atomic increment, so slow items
+ * do not hold up the rest of the batch. The batch operations (bulk metadata stat, copy, delete) are built on this.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_batch.h"
+
+/* data types */
+/**
+ * Data type holding the state shared between the threads processing a batch. This consists of the following:
+ * <dl>
+ * <dt>Item_Count</dt> <dd>The number of items in the batch.</dd>
+ * <dt>Next_Index</dt> <dd>The index of the next item to be claimed by a thread.</dd>
+ * <dt>Item_Function</dt> <dd>The function to call for each item.</dd>
+ * <dt>User_Data</dt> <dd>The user data pointer passed to the item function.</dd>
+ * <dt>Priority</dt> <dd>The bandwidth priority class of the thread running the batch, which the batch threads
+ *     inherit.</dd>
+ * </dl>
+ */
+struct Batch_Struct
+{
+	int Item_Count;
+	std::atomic<int> Next_Index;
+	GCP_Client_Batch_Item_Function_T Item_Function;
+	void *User_Data;
+	int Priority;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Batch_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Batch_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static void *Batch_Thread(void *arg);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Run a function over a batch of items, on up to concurrency threads. The routine returns when every item has
+ * been processed. If fewer threads than requested can be created, the batch is processed by the threads that
+ * were created. Errors from processing individual items are the item function's responsibility to record.
+ * @param item_count The number of items in the batch. The item function is called with each index 0..item_count-1.
+ * @param concurrency The maximum number of threads to use. If 0, GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY is used.
+ *        No more threads than items are created.
+ * @param item_fn The function to call for each item.
+ * @param user_data A pointer passed unaltered to each call of the item function.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Batch_Error_Number /
+ *         Batch_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY
+ * @see #GCP_CLIENT_BATCH_MAX_CONCURRENCY
+ * @see #Batch_Struct
+ * @see #Batch_Thread
+ * @see #Batch_Error_Number
+ * @see #Batch_Error_String
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Get_Thread_Priority
+ */
+int GCP_Client_Batch_Run(int item_count,int concurrency,GCP_Client_Batch_Item_Function_T item_fn,void *user_data)
+{
+	struct Batch_Struct batch;
+	pthread_t *thread_list = NULL;
+	int i,thread_count,retval = 0;
+
+	Batch_Error_Number = 0;
+	if(item_count < 0)
+	{
+		Batch_Error_Number = 1;
+		sprintf(Batch_Error_String,"GCP_Client_Batch_Run: item_count %d was negative.",item_count);
+		return FALSE;
+	}
+	if((concurrency < 0)||(concurrency > GCP_CLIENT_BATCH_MAX_CONCURRENCY))
+	{
+		Batch_Error_Number = 2;
+		sprintf(Batch_Error_String,"GCP_Client_Batch_Run: concurrency %d out of range (0..%d).",concurrency,
+			GCP_CLIENT_BATCH_MAX_CONCURRENCY);
+		return FALSE;
+	}
+	if(item_fn == NULL)
+	{
+		Batch_Error_Number = 3;
+		sprintf(Batch_Error_String,"GCP_Client_Batch_Run: item_fn was NULL.");
+		return FALSE;
+	}
+	if(item_count == 0)
+		return TRUE;
+	if(concurrency == 0)
+		concurrency = GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY;
+	if(concurrency > item_count)
+		concurrency = item_count;
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL,LOG_VERBOSITY_VERY_VERBOSE,
+					     "GCP_Client_Batch_Run:Running %d items on %d threads.",item_count,concurrency);
+#endif
+	thread_list = (pthread_t *)malloc(concurrency*sizeof(pthread_t));
+	if(thread_list == NULL)
+	{
+		Batch_Error_Number = 4;
+		sprintf(Batch_Error_String,"GCP_Client_Batch_Run: Failed to allocate %d threads.",concurrency);
+		return FALSE;
+	}
+	batch.Item_Count = item_count;
+	batch.Next_Index = 0;
+	batch.Item_Function = item_fn;
+	batch.User_Data = user_data;
+	batch.Priority = GCP_Client_Bandwidth_Get_Thread_Priority();
+	thread_count = 0;
+	for(i = 0; i < concurrency; i++)
+	{
+		retval = pthread_create(&(thread_list[i]),NULL,Batch_Thread,&batch);
+		if(retval != 0)
+		{
+#if LOGGING > 1
+			GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL,LOG_VERBOSITY_TERSE,
+				     "GCP_Client_Batch_Run:Failed to create thread %d (%d), continuing with %d threads.",
+							     i,retval,thread_count);
+#endif
+			break;
+		}
+		thread_count++;
+	}
+	if(thread_count == 0)
+	{
+		free(thread_list);
+		Batch_Error_Number = 5;
+		sprintf(Batch_Error_String,"GCP_Client_Batch_Run: Failed to create any threads (%d).",retval);
+		return FALSE;
+	}
+	for(i = 0; i < thread_count; i++)
+		pthread_join(thread_list[i],NULL);
+	free(thread_list);
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_batch error number.
+ * @return The current value of the gcp_client_batch error number.
+ * @see #Batch_Error_Number
+ */
+int GCP_Client_Batch_Get_Error_Number(void)
+{
+	return Batch_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Batch_Error_Number
+ * @see #Batch_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Batch_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Batch_Error_Number == 0)
+		sprintf(Batch_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Batch:Error(%d) : %s\n",time_string,Batch_Error_Number,Batch_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Batch_Error_Number
+ * @see #Batch_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Batch_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Batch_Error_Number == 0)
+		sprintf(Batch_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Batch:Error(%d) : %s\n",time_string,
+		Batch_Error_Number,Batch_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * The thread function of a batch thread. This claims item indexes until the batch is exhausted, calling the
+ * item function for each one. The thread's bandwidth priority class is set to that of the thread running the batch.
+ * @param arg A pointer to the Batch_Struct shared by the threads.
+ * @return NULL.
+ * @see #Batch_Struct
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Set_Thread_Priority
+ */
+static void *Batch_Thread(void *arg)
+{
+	struct Batch_Struct *batch = (struct Batch_Struct *)arg;
+	int index;
+
+	GCP_Client_Bandwidth_Set_Thread_Priority(batch->Priority);
+	index = batch->Next_Index.fetch_add(1,std::memory_order_relaxed);
+	while(index < batch->Item_Count)
+	{
+		batch->Item_Function(index,batch->User_Data);
+		index = batch->Next_Index.fetch_add(1,std::memory_order_relaxed);
+	}
+	return NULL;
+}
@@ -0,0 +1,547 @@
+/* gcp_client_budget.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Global in-flight memory budget routines.
+*/
+/**
+ * Routines managing a library wide budget for the memory held by transfers in progress (pooled buffers, read
+ * buffers, upload buffers, and any cache a program charges to it). Before allocating transfer memory, a reservation
+ * for it's length is made against the budget, and released when the memory is freed. When a reservation would take
+ * the memory in use past the limit, it waits (blocking, or asynchronously with a callback) until enough memory has
+ * been released, so a burst of large transfers queues up rather than exhausting memory. Waiting reservations are
+ * granted in the order they were made, so a large reservation is not starved by a stream of small ones.
+ * <p>
+ * A reservation is granted over the limit when waiting cannot help: when it is larger than the whole limit, or when
+ * everything in use was reserved by the calling thread (which could otherwise wait for itself forever).
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <deque>
+#include <vector>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_budget.h"
+
+/* data types */
+/**
+ * Data type holding a reservation waiting for budget. This consists of the following:
+ * <dl>
+ * <dt>Use</dt> <dd>What the memory is for, one of GCP_CLIENT_BUDGET_USE_*.</dd>
+ * <dt>Length</dt> <dd>The number of bytes to reserve.</dd>
+ * <dt>Own_Reserved</dt> <dd>The number of bytes the reserving thread already had reserved.</dd>
+ * <dt>Granted</dt> <dd>A boolean, set to TRUE when the reservation is granted.</dd>
+ * <dt>Condition</dt> <dd>A condition variable, signalled when a blocking reservation is granted.</dd>
+ * <dt>Callback</dt> <dd>The function to call when an asynchronous reservation is granted, or NULL for a
+ *     blocking reservation.</dd>
+ * <dt>User_Data</dt> <dd>The pointer to pass to Callback.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_BUDGET_USE_COUNT
+ */
+struct Budget_Waiter_Struct
+{
+	int Use;
+	unsigned long long Length;
+	unsigned long long Own_Reserved;
+	int Granted;
+	pthread_cond_t Condition;
+	GCP_Client_Budget_Callback_T Callback;
+	void *User_Data;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Budget_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Budget_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+/**
+ * The number of bytes the current thread has reserved (and not yet released). Used to grant reservations that
+ * would otherwise wait for memory only the reserving thread can release.
+ */
+static thread_local unsigned long long Budget_Thread_Reserved = 0;
+/**
+ * Mutex protecting the budget (statistics and waiter queue).
+ */
+static pthread_mutex_t Budget_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * The queue of reservations waiting for budget, in the order they were made.
+ * @see #Budget_Waiter_Struct
+ */
+static std::deque<struct Budget_Waiter_Struct*> Budget_Waiter_Queue;
+/**
+ * The budget statistics. Limit is the budget itself, 0 (no limit) by default.
+ */
+static struct GCP_Client_Budget_Stats_Struct Budget_Stats = {0,0,0,{0,0,0,0},0,0,0,0,0,0.0};
+/**
+ * How long a reservation made with GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT waits for budget, in milliseconds.
+ * By default, it waits forever.
+ * @see #GCP_CLIENT_BUDGET_WAIT_FOREVER
+ */
+static int Budget_Default_Timeout = GCP_CLIENT_BUDGET_WAIT_FOREVER;
+
+/* internal functions */
+static int Budget_Can_Grant(unsigned long long length,unsigned long long own_reserved);
+static void Budget_Grant(int use,unsigned long long length);
+static void Budget_Grant_Waiters(std::vector<struct Budget_Waiter_Struct*> &callback_list);
+static void Budget_Call_Callbacks(std::vector<struct Budget_Waiter_Struct*> &callback_list);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Set the memory budget. If the new limit is higher, waiting reservations that now fit are granted.
+ * @param limit The number of bytes transfers may hold in memory at once, or 0 for no limit.
+ * @see #Budget_Stats
+ * @see #Budget_Grant_Waiters
+ * @see #Budget_Call_Callbacks
+ */
+void GCP_Client_Budget_Set_Limit(unsigned long long limit)
+{
+	std::vector<struct Budget_Waiter_Struct*> callback_list;
+
+	pthread_mutex_lock(&Budget_Mutex);
+	Budget_Stats.Limit = limit;
+	Budget_Grant_Waiters(callback_list);
+	pthread_mutex_unlock(&Budget_Mutex);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_BUDGET,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Budget_Set_Limit:Memory budget set to %llu bytes.",limit);
+#endif
+	Budget_Call_Callbacks(callback_list);
+}
+
+/**
+ * Set how long reservations made with a timeout of GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT wait for budget.
+ * This is the timeout used by the library's own transfers.
+ * @param timeout_ms The timeout in milliseconds, or GCP_CLIENT_BUDGET_WAIT_FOREVER.
+ * @see #Budget_Default_Timeout
+ */
+void GCP_Client_Budget_Set_Default_Timeout(int timeout_ms)
+{
+	pthread_mutex_lock(&Budget_Mutex);
+	Budget_Default_Timeout = timeout_ms;
+	pthread_mutex_unlock(&Budget_Mutex);
+}
+
+/**
+ * Reserve length bytes of the memory budget, waiting if necessary until enough has been released.
+ * Reservations are granted in the order they were made. The reservation should be returned with
+ * GCP_Client_Budget_Release when the memory is freed.
+ * @param use What the memory is for, one of GCP_CLIENT_BUDGET_USE_*.
+ * @param length The number of bytes to reserve. Reserving 0 bytes always succeeds straight away.
+ * @param timeout_ms How long to wait for the budget, in milliseconds. 0 means do not wait,
+ *        GCP_CLIENT_BUDGET_WAIT_FOREVER waits for as long as it takes, and GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT uses the
+ *        timeout set by GCP_Client_Budget_Set_Default_Timeout.
+ * @return The routine returns TRUE if the budget was reserved, and FALSE if use was illegal, length is larger
+ *         than the whole budget (which could never be granted), or the budget was not available within the
+ *         timeout. If it fails, Budget_Error_Number / Budget_Error_String should
+ *         contain details of the failure.
+ * @see #GCP_CLIENT_BUDGET_USE_COUNT
+ * @see #Budget_Waiter_Struct
+ * @see #Budget_Waiter_Queue
+ * @see #Budget_Thread_Reserved
+ * @see #Budget_Default_Timeout
+ * @see #Budget_Can_Grant
+ * @see #Budget_Grant
+ * @see #Budget_Grant_Waiters
+ * @see #Budget_Call_Callbacks
+ */
+int GCP_Client_Budget_Reserve(int use,unsigned long long length,int timeout_ms)
+{
+	std::vector<struct Budget_Waiter_Struct*> callback_list;
+	std::deque<struct Budget_Waiter_Struct*>::iterator it;
+	struct Budget_Waiter_Struct waiter;
+	struct timespec start_time,end_time,deadline;
+	int retval;
+
+	Budget_Error_Number = 0;
+	if((use < 0)||(use >= GCP_CLIENT_BUDGET_USE_COUNT))
+	{
+		Budget_Error_Number = 1;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Reserve: Illegal use %d.",use);
+		return FALSE;
+	}
+	if(length == 0)
+		return TRUE;
+	pthread_mutex_lock(&Budget_Mutex);
+	Budget_Stats.Reserve_Count++;
+	/* a reservation larger than the whole budget can never fit, and would block the queue whilst it waited */
+	if((Budget_Stats.Limit > 0)&&(length > Budget_Stats.Limit))
+	{
+		Budget_Stats.Timeout_Count++;
+		pthread_mutex_unlock(&Budget_Mutex);
+		Budget_Error_Number = 8;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Reserve: %llu bytes is larger than the whole budget "
+			"(%llu bytes).",length,Budget_Stats.Limit);
+		return FALSE;
+	}
+	if(timeout_ms == GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT)
+		timeout_ms = Budget_Default_Timeout;
+	/* only jump the queue if nothing is waiting */
+	if((Budget_Waiter_Queue.size() == 0)&&Budget_Can_Grant(length,Budget_Thread_Reserved))
+	{
+		Budget_Grant(use,length);
+		pthread_mutex_unlock(&Budget_Mutex);
+		Budget_Thread_Reserved += length;
+		return TRUE;
+	}
+	if(timeout_ms == 0)
+	{
+		Budget_Stats.Timeout_Count++;
+		pthread_mutex_unlock(&Budget_Mutex);
+		Budget_Error_Number = 2;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Reserve: %llu bytes of budget not available "
+			"(%llu of %llu bytes in use).",length,Budget_Stats.In_Use,Budget_Stats.Limit);
+		return FALSE;
+	}
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_BUDGET,LOG_VERBOSITY_VERY_VERBOSE,
+					     "GCP_Client_Budget_Reserve:Waiting for %llu bytes of budget "
+					     "(%llu of %llu bytes in use).",length,Budget_Stats.In_Use,Budget_Stats.Limit);
+#endif
+	waiter.Use = use;
+	waiter.Length = length;
+	waiter.Own_Reserved = Budget_Thread_Reserved;
+	waiter.Granted = FALSE;
+	waiter.Callback = NULL;
+	waiter.User_Data = NULL;
+	pthread_cond_init(&(waiter.Condition),NULL);
+	Budget_Waiter_Queue.push_back(&waiter);
+	Budget_Stats.Wait_Count++;
+	Budget_Stats.Waiting_Count++;
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	if(timeout_ms > 0)
+	{
+		clock_gettime(CLOCK_REALTIME,&deadline);
+		deadline.tv_sec += timeout_ms/1000;
+		deadline.tv_nsec += (long)(timeout_ms%1000)*1000000L;
+		if(deadline.tv_nsec >= 1000000000L)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+	}
+	retval = 0;
+	while((waiter.Granted == FALSE)&&(retval != ETIMEDOUT))
+	{
+		if(timeout_ms > 0)
+			retval = pthread_cond_timedwait(&(waiter.Condition),&Budget_Mutex,&deadline);
+		else
+			pthread_cond_wait(&(waiter.Condition),&Budget_Mutex);
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	Budget_Stats.Waiting_Count--;
+	Budget_Stats.Wait_Time += fdifftime(end_time,start_time);
+	if(waiter.Granted == FALSE)
+	{
+		for(it = Budget_Waiter_Queue.begin(); it != Budget_Waiter_Queue.end(); it++)
+		{
+			if((*it) == &waiter)
+			{
+				Budget_Waiter_Queue.erase(it);
+				break;
+			}
+		}
+		Budget_Stats.Timeout_Count++;
+		/* the reservations queued behind this one may now fit */
+		Budget_Grant_Waiters(callback_list);
+	}
+	pthread_mutex_unlock(&Budget_Mutex);
+	pthread_cond_destroy(&(waiter.Condition));
+	Budget_Call_Callbacks(callback_list);
+	if(waiter.Granted == FALSE)
+	{
+		Budget_Error_Number = 3;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Reserve: Timed out after %d ms waiting for %llu bytes "
+			"of budget.",timeout_ms,length);
+		return FALSE;
+	}
+	Budget_Thread_Reserved += length;
+	return TRUE;
+}
+
+/**
+ * Reserve length bytes of the memory budget without blocking. When the budget is available callback is called
+ * with user_data, straight away from this routine if the budget is available now, otherwise later from the
+ * thread whose release (or limit change) makes it available. Reservations are granted in the order they were made
+ * (blocking and asynchronous alike). The reservation should be returned with GCP_Client_Budget_Release when the
+ * memory is freed.
+ * @param use What the memory is for, one of GCP_CLIENT_BUDGET_USE_*.
+ * @param length The number of bytes to reserve.
+ * @param callback The function to call when the budget has been reserved.
+ * @param user_data A pointer passed to callback.
+ * @return The routine returns TRUE if the reservation was granted or queued, and FALSE on failure (including
+ *         length being larger than the whole budget, in which case callback is never called). If it fails,
+ *         Budget_Error_Number / Budget_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_BUDGET_USE_COUNT
+ * @see #Budget_Waiter_Struct
+ * @see #Budget_Waiter_Queue
+ * @see #Budget_Can_Grant
+ * @see #Budget_Grant
+ */
+int GCP_Client_Budget_Reserve_Async(int use,unsigned long long length,GCP_Client_Budget_Callback_T callback,
+				    void *user_data)
+{
+	struct Budget_Waiter_Struct *waiter = NULL;
+
+	Budget_Error_Number = 0;
+	if((use < 0)||(use >= GCP_CLIENT_BUDGET_USE_COUNT))
+	{
+		Budget_Error_Number = 4;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Reserve_Async: Illegal use %d.",use);
+		return FALSE;
+	}
+	if(callback == NULL)
+	{
+		Budget_Error_Number = 5;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Reserve_Async: callback was NULL.");
+		return FALSE;
+	}
+	waiter = (struct Budget_Waiter_Struct *)malloc(sizeof(struct Budget_Waiter_Struct));
+	if(waiter == NULL)
+	{
+		Budget_Error_Number = 6;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Reserve_Async: Failed to allocate waiter.");
+		return FALSE;
+	}
+	waiter->Use = use;
+	waiter->Length = length;
+	/* the callback may run on any thread, so the reservation is not attributed to this one */
+	waiter->Own_Reserved = 0;
+	waiter->Granted = FALSE;
+	waiter->Callback = callback;
+	waiter->User_Data = user_data;
+	pthread_mutex_lock(&Budget_Mutex);
+	Budget_Stats.Reserve_Count++;
+	if((Budget_Stats.Limit > 0)&&(length > Budget_Stats.Limit))
+	{
+		Budget_Stats.Timeout_Count++;
+		pthread_mutex_unlock(&Budget_Mutex);
+		free(waiter);
+		Budget_Error_Number = 9;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Reserve_Async: %llu bytes is larger than the whole "
+			"budget (%llu bytes).",length,Budget_Stats.Limit);
+		return FALSE;
+	}
+	if((Budget_Waiter_Queue.size() == 0)&&Budget_Can_Grant(length,0))
+	{
+		Budget_Grant(use,length);
+		pthread_mutex_unlock(&Budget_Mutex);
+		free(waiter);
+		(*callback)(user_data);
+		return TRUE;
+	}
+	Budget_Waiter_Queue.push_back(waiter);
+	Budget_Stats.Wait_Count++;
+	Budget_Stats.Waiting_Count++;
+	pthread_mutex_unlock(&Budget_Mutex);
+	return TRUE;
+}
+
+/**
+ * Return length bytes reserved with GCP_Client_Budget_Reserve or GCP_Client_Budget_Reserve_Async to the budget,
+ * and grant any waiting reservations that now fit. The callbacks of granted asynchronous reservations are
+ * called from this routine.
+ * @param use What the memory was for, the use it was reserved with.
+ * @param length The number of bytes to release.
+ * @see #Budget_Stats
+ * @see #Budget_Thread_Reserved
+ * @see #Budget_Grant_Waiters
+ * @see #Budget_Call_Callbacks
+ */
+void GCP_Client_Budget_Release(int use,unsigned long long length)
+{
+	std::vector<struct Budget_Waiter_Struct*> callback_list;
+
+	if((use < 0)||(use >= GCP_CLIENT_BUDGET_USE_COUNT)||(length == 0))
+		return;
+	pthread_mutex_lock(&Budget_Mutex);
+	if(length > Budget_Stats.In_Use)
+		Budget_Stats.In_Use = 0;
+	else
+		Budget_Stats.In_Use -= length;
+	if(length > Budget_Stats.Use_In_Use[use])
+		Budget_Stats.Use_In_Use[use] = 0;
+	else
+		Budget_Stats.Use_In_Use[use] -= length;
+	Budget_Grant_Waiters(callback_list);
+	pthread_mutex_unlock(&Budget_Mutex);
+	/* memory can be reserved on one thread and released on another */
+	if(length > Budget_Thread_Reserved)
+		Budget_Thread_Reserved = 0;
+	else
+		Budget_Thread_Reserved -= length;
+	Budget_Call_Callbacks(callback_list);
+}
+
+/**
+ * Get a copy of the memory budget statistics.
+ * @param stats The address of a structure to copy the statistics into.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Budget_Error_Number /
+ *         Budget_Error_String should contain details of the failure.
+ * @see #Budget_Stats
+ */
+int GCP_Client_Budget_Get_Stats(struct GCP_Client_Budget_Stats_Struct *stats)
+{
+	Budget_Error_Number = 0;
+	if(stats == NULL)
+	{
+		Budget_Error_Number = 7;
+		sprintf(Budget_Error_String,"GCP_Client_Budget_Get_Stats: stats was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&Budget_Mutex);
+	(*stats) = Budget_Stats;
+	pthread_mutex_unlock(&Budget_Mutex);
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_budget error number.
+ * @return The current value of the gcp_client_budget error number.
+ * @see #Budget_Error_Number
+ */
+int GCP_Client_Budget_Get_Error_Number(void)
+{
+	return Budget_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Budget_Error_Number
+ * @see #Budget_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Budget_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Budget_Error_Number == 0)
+		sprintf(Budget_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Budget:Error(%d) : %s\n",time_string,Budget_Error_Number,Budget_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Budget_Error_Number
+ * @see #Budget_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Budget_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Budget_Error_Number == 0)
+		sprintf(Budget_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Budget:Error(%d) : %s\n",time_string,
+		Budget_Error_Number,Budget_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Return whether a reservation can be granted now. It can if there is no limit, it fits within the limit, or
+ * everything in use was reserved by the reserving thread (so waiting would never end). Called with Budget_Mutex held.
+ * @param length The number of bytes to reserve.
+ * @param own_reserved The number of bytes the reserving thread already has reserved.
+ * @return TRUE if the reservation can be granted, FALSE if it must wait.
+ * @see #Budget_Stats
+ */
+static int Budget_Can_Grant(unsigned long long length,unsigned long long own_reserved)
+{
+	if(Budget_Stats.Limit == 0)
+		return TRUE;
+	if((Budget_Stats.In_Use+length) <= Budget_Stats.Limit)
+		return TRUE;
+	if(Budget_Stats.In_Use <= own_reserved)
+		return TRUE;
+	return FALSE;
+}
+
+/**
+ * Add a granted reservation to the memory in use, and update the high water mark. Called with Budget_Mutex held.
+ * @param use What the memory is for.
+ * @param length The number of bytes reserved.
+ * @see #Budget_Stats
+ */
+static void Budget_Grant(int use,unsigned long long length)
+{
+	Budget_Stats.In_Use += length;
+	Budget_Stats.Use_In_Use[use] += length;
+	if((Budget_Stats.Limit > 0)&&(Budget_Stats.In_Use > Budget_Stats.Limit))
+		Budget_Stats.Over_Limit_Count++;
+	if(Budget_Stats.In_Use > Budget_Stats.High_Water)
+		Budget_Stats.High_Water = Budget_Stats.In_Use;
+}
+
+/**
+ * Grant waiting reservations, from the front of the queue, until one does not fit. Blocking waiters are
+ * signalled. Asynchronous waiters are added to callback_list, for their callbacks to be called once
+ * Budget_Mutex has been released. Called with Budget_Mutex held.
+ * @param callback_list A list to add the granted asynchronous waiters to.
+ * @see #Budget_Waiter_Queue
+ * @see #Budget_Can_Grant
+ * @see #Budget_Grant
+ */
+static void Budget_Grant_Waiters(std::vector<struct Budget_Waiter_Struct*> &callback_list)
+{
+	struct Budget_Waiter_Struct *waiter = NULL;
+
+	while(Budget_Waiter_Queue.size() > 0)
+	{
+		waiter = Budget_Waiter_Queue.front();
+		if(!Budget_Can_Grant(waiter->Length,waiter->Own_Reserved))
+			break;
+		Budget_Waiter_Queue.pop_front();
+		Budget_Grant(waiter->Use,waiter->Length);
+		waiter->Granted = TRUE;
+		if(waiter->Callback != NULL)
+		{
+			Budget_Stats.Waiting_Count--;
+			callback_list.push_back(waiter);
+		}
+		else
+			pthread_cond_signal(&(waiter->Condition));
+	}
+}
+
+/**
+ * Call the callbacks of granted asynchronous reservations, and free their waiters. Called without Budget_Mutex
+ * held, so the callbacks may reserve and release budget themselves.
+ * @param callback_list The list of granted asynchronous waiters.
+ */
+static void Budget_Call_Callbacks(std::vector<struct Budget_Waiter_Struct*> &callback_list)
+{
+	for(size_t i = 0; i < callback_list.size(); i++)
+	{
+		(*(callback_list[i]->Callback))(callback_list[i]->User_Data);
+		free(callback_list[i]);
+	}
+}
@@ -0,0 +1,564 @@
+/* gcp_client_buffer.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Pooled transfer buffer routines.
+*/
+/**
+ * Routines managing a pool of reusable transfer buffers, so programs reading many objects do not map and fault in
+ * fresh memory (and fragment the heap) for every object. Buffers come in power of two size classes, from
+ * GCP_CLIENT_BUFFER_MIN_CLASS_LENGTH upwards. They are mapped directly (rather than malloc'ed), and buffers of a huge
+ * page or longer are huge page aligned and advised to use transparent huge pages. Released buffers are kept on a
+ * free list per size class, up to a maximum retained length, and handed out again by later acquires.
+ * Outstanding buffers are charged to the memory budget (GCP_CLIENT_BUDGET_USE_BUFFER), from acquire until release.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unordered_map>
+#include <vector>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_budget.h"
+#include "gcp_client_buffer.h"
+
+/* data types */
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Buffer_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Buffer_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+/**
+ * Mutex protecting the pool (free lists, outstanding buffer map and statistics).
+ */
+static pthread_mutex_t Buffer_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * A free list of released buffers for each size class.
+ * @see #GCP_CLIENT_BUFFER_CLASS_COUNT
+ */
+static std::vector<void*> Buffer_Free_List[GCP_CLIENT_BUFFER_CLASS_COUNT];
+/**
+ * Map from each outstanding (handed out) buffer to it's mapped length.
+ */
+static std::unordered_map<void*,size_t> Buffer_Outstanding_Map;
+/**
+ * The buffer pool statistics. Max_Retained_Length is the pool's retention limit.
+ * @see #GCP_CLIENT_BUFFER_DEFAULT_MAX_RETAINED_LENGTH
+ */
+static struct GCP_Client_Buffer_Stats_Struct Buffer_Stats = {0,0,0,0,0,0,0,0,0,
+							   GCP_CLIENT_BUFFER_DEFAULT_MAX_RETAINED_LENGTH,0};
+
+/* internal functions */
+static int Buffer_Acquire(size_t length,void **buffer_ptr,size_t *capacity,int reserve);
+static int Buffer_Release(void *buffer,int unreserve);
+static int Buffer_Class_Index(size_t length);
+static size_t Buffer_Mapped_Length(size_t length);
+static void *Buffer_Map(size_t length);
+static void Buffer_Unmap(void *buffer,size_t length);
+static void Buffer_Trim_To(unsigned long long max_retained_length);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Acquire a buffer of at least length bytes. The buffer is taken from the pool if one of the right size class
+ * has been released, otherwise it is mapped. It should be returned with GCP_Client_Buffer_Release
+ * (not free) when finished with. The buffer's length is reserved from the memory budget first, waiting
+ * (for the default budget timeout) if the budget is exhausted.
+ * @param length The number of bytes needed. If 0, a buffer of the smallest size class is returned.
+ * @param buffer_ptr The address of a void pointer, on success set to the buffer.
+ * @param capacity The address of a size_t, on success set to the usable length of the buffer (the length of it's
+ *        size class, which may be more than length). Can be NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Buffer_Error_Number /
+ *         Buffer_Error_String should contain details of the failure.
+ * @see #Buffer_Acquire
+ */
+int GCP_Client_Buffer_Acquire(size_t length,void **buffer_ptr,size_t *capacity)
+{
+	return Buffer_Acquire(length,buffer_ptr,capacity,TRUE);
+}
+
+/**
+ * Grow a buffer so it can hold at least length bytes. If the buffer is already long enough it is left alone,
+ * otherwise a buffer of a large enough size class is acquired, the first used_length bytes are copied into it,
+ * and the old buffer is released. Only the extra length is reserved from the memory budget.
+ * @param buffer_ptr The address of a void pointer to the buffer. If the pointer is NULL, a new buffer is acquired.
+ *        On success, the pointer is set to the (possibly new) buffer.
+ * @param used_length The number of bytes of data in the buffer, to copy into a new buffer.
+ * @param length The number of bytes the buffer must hold.
+ * @param capacity The address of a size_t, on success set to the usable length of the buffer. Can be NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure (the old buffer is left as it was).
+ *         If it fails, Buffer_Error_Number / Buffer_Error_String should contain details of the failure.
+ * @see #GCP_Client_Buffer_Acquire
+ * @see #Buffer_Acquire
+ * @see #Buffer_Release
+ * @see #Buffer_Mapped_Length
+ * @see #Buffer_Outstanding_Map
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ */
+int GCP_Client_Buffer_Grow(void **buffer_ptr,size_t used_length,size_t length,size_t *capacity)
+{
+	std::unordered_map<void*,size_t>::iterator it;
+	void *new_buffer = NULL;
+	size_t current_length,extra_length;
+
+	Buffer_Error_Number = 0;
+	if(buffer_ptr == NULL)
+	{
+		Buffer_Error_Number = 3;
+		sprintf(Buffer_Error_String,"GCP_Client_Buffer_Grow: buffer_ptr was NULL.");
+		return FALSE;
+	}
+	if((*buffer_ptr) == NULL)
+		return GCP_Client_Buffer_Acquire(length,buffer_ptr,capacity);
+	pthread_mutex_lock(&Buffer_Mutex);
+	it = Buffer_Outstanding_Map.find(*buffer_ptr);
+	if(it == Buffer_Outstanding_Map.end())
+	{
+		pthread_mutex_unlock(&Buffer_Mutex);
+		Buffer_Error_Number = 4;
+		sprintf(Buffer_Error_String,"GCP_Client_Buffer_Grow: %p was not acquired from the buffer pool.",
+			(*buffer_ptr));
+		return FALSE;
+	}
+	current_length = it->second;
+	pthread_mutex_unlock(&Buffer_Mutex);
+	if(used_length > current_length)
+	{
+		Buffer_Error_Number = 5;
+		sprintf(Buffer_Error_String,"GCP_Client_Buffer_Grow: used_length %lu is longer than the buffer (%lu).",
+			(unsigned long)used_length,(unsigned long)current_length);
+		return FALSE;
+	}
+	if(current_length >= length)
+	{
+		if(capacity != NULL)
+			(*capacity) = current_length;
+		return TRUE;
+	}
+	/* the old buffer is already charged to the budget, so only reserve the extra length */
+	extra_length = Buffer_Mapped_Length(length)-current_length;
+	if(!GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_BUFFER,extra_length,GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT))
+	{
+		Buffer_Error_Number = 9;
+		snprintf(Buffer_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Buffer_Grow: Failed to reserve %lu bytes of memory budget.",
+			 (unsigned long)extra_length);
+		return FALSE;
+	}
+	if(!Buffer_Acquire(length,&new_buffer,capacity,FALSE))
+	{
+		GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_BUFFER,extra_length);
+		return FALSE;
+	}
+	memcpy(new_buffer,(*buffer_ptr),used_length);
+	Buffer_Release(*buffer_ptr,FALSE);
+	(*buffer_ptr) = new_buffer;
+	return TRUE;
+}
+
+/**
+ * Release a buffer acquired with GCP_Client_Buffer_Acquire (or returned by a pooled read). The buffer is kept
+ * in the pool for re-use, unless the pool already retains it's maximum length, or the buffer is too large to pool,
+ * in which case it is unmapped. The buffer's length is returned to the memory budget.
+ * @param buffer The buffer. If NULL, nothing is done.
+ * @return The routine returns TRUE on success, and FALSE if the buffer did not come from the pool.
+ *         If it fails, Buffer_Error_Number / Buffer_Error_String should contain details of the failure.
+ * @see #Buffer_Release
+ */
+int GCP_Client_Buffer_Release(void *buffer)
+{
+	return Buffer_Release(buffer,TRUE);
+}
+
+/**
+ * Set the maximum number of bytes of released buffers the pool retains. If the pool already retains more than
+ * this, the excess buffers (largest first) are unmapped.
+ * @param max_retained_length The maximum number of bytes to retain. 0 disables pooling.
+ * @see #GCP_CLIENT_BUFFER_DEFAULT_MAX_RETAINED_LENGTH
+ * @see #Buffer_Trim_To
+ */
+void GCP_Client_Buffer_Set_Max_Retained_Length(size_t max_retained_length)
+{
+	pthread_mutex_lock(&Buffer_Mutex);
+	Buffer_Stats.Max_Retained_Length = max_retained_length;
+	pthread_mutex_unlock(&Buffer_Mutex);
+	Buffer_Trim_To(max_retained_length);
+}
+
+/**
+ * Unmap all the released buffers retained by the pool, returning their memory to the operating system.
+ * Outstanding buffers are not affected.
+ * @see #Buffer_Trim_To
+ */
+void GCP_Client_Buffer_Trim(void)
+{
+	Buffer_Trim_To(0);
+}
+
+/**
+ * Get a copy of the buffer pool statistics.
+ * @param stats The address of a structure to copy the statistics into.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Buffer_Error_Number /
+ *         Buffer_Error_String should contain details of the failure.
+ * @see #Buffer_Stats
+ */
+int GCP_Client_Buffer_Get_Stats(struct GCP_Client_Buffer_Stats_Struct *stats)
+{
+	Buffer_Error_Number = 0;
+	if(stats == NULL)
+	{
+		Buffer_Error_Number = 7;
+		sprintf(Buffer_Error_String,"GCP_Client_Buffer_Get_Stats: stats was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&Buffer_Mutex);
+	(*stats) = Buffer_Stats;
+	pthread_mutex_unlock(&Buffer_Mutex);
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_buffer error number.
+ * @return The current value of the gcp_client_buffer error number.
+ * @see #Buffer_Error_Number
+ */
+int GCP_Client_Buffer_Get_Error_Number(void)
+{
+	return Buffer_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Buffer_Error_Number
+ * @see #Buffer_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Buffer_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Buffer_Error_Number == 0)
+		sprintf(Buffer_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Buffer:Error(%d) : %s\n",time_string,Buffer_Error_Number,Buffer_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Buffer_Error_Number
+ * @see #Buffer_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Buffer_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Buffer_Error_Number == 0)
+		sprintf(Buffer_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Buffer:Error(%d) : %s\n",time_string,
+		Buffer_Error_Number,Buffer_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Acquire a buffer of at least length bytes, from the pool if one of the right size class has been released,
+ * otherwise by mapping it.
+ * @param length The number of bytes needed.
+ * @param buffer_ptr The address of a void pointer, on success set to the buffer.
+ * @param capacity The address of a size_t, on success set to the usable length of the buffer. Can be NULL.
+ * @param reserve A boolean, if TRUE the buffer's mapped length is reserved from the memory budget first.
+ *        GCP_Client_Buffer_Grow passes FALSE, having reserved the extra length itself.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Buffer_Error_Number /
+ *         Buffer_Error_String should contain details of the failure.
+ * @see #Buffer_Class_Index
+ * @see #Buffer_Mapped_Length
+ * @see #Buffer_Map
+ * @see #Buffer_Free_List
+ * @see #Buffer_Outstanding_Map
+ * @see #Buffer_Stats
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ */
+static int Buffer_Acquire(size_t length,void **buffer_ptr,size_t *capacity,int reserve)
+{
+	void *buffer = NULL;
+	size_t mapped_length,mapped_total;
+	int class_index;
+
+	Buffer_Error_Number = 0;
+	if(buffer_ptr == NULL)
+	{
+		Buffer_Error_Number = 1;
+		sprintf(Buffer_Error_String,"GCP_Client_Buffer_Acquire: buffer_ptr was NULL.");
+		return FALSE;
+	}
+	(*buffer_ptr) = NULL;
+	class_index = Buffer_Class_Index(length);
+	mapped_length = Buffer_Mapped_Length(length);
+	if(reserve && (!GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_BUFFER,mapped_length,
+						  GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT)))
+	{
+		Buffer_Error_Number = 8;
+		snprintf(Buffer_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Buffer_Acquire: Failed to reserve %lu bytes of memory budget.",
+			 (unsigned long)mapped_length);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Buffer_Mutex);
+	if((class_index >= 0)&&(Buffer_Free_List[class_index].size() > 0))
+	{
+		buffer = Buffer_Free_List[class_index].back();
+		Buffer_Free_List[class_index].pop_back();
+		Buffer_Stats.Reuse_Count++;
+		Buffer_Stats.Retained_Count--;
+		Buffer_Stats.Retained_Length -= mapped_length;
+	}
+	pthread_mutex_unlock(&Buffer_Mutex);
+	if(buffer == NULL)
+	{
+		buffer = Buffer_Map(mapped_length);
+		if(buffer == NULL)
+		{
+			Buffer_Error_Number = 2;
+			snprintf(Buffer_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Buffer_Acquire: Failed to map buffer of %lu bytes (%s).",
+				 (unsigned long)mapped_length,strerror(errno));
+			if(reserve)
+				GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_BUFFER,mapped_length);
+			return FALSE;
+		}
+		pthread_mutex_lock(&Buffer_Mutex);
+		Buffer_Stats.Map_Count++;
+	}
+	else
+		pthread_mutex_lock(&Buffer_Mutex);
+	Buffer_Outstanding_Map[buffer] = mapped_length;
+	Buffer_Stats.Acquire_Count++;
+	Buffer_Stats.Outstanding_Count++;
+	Buffer_Stats.Outstanding_Length += mapped_length;
+	mapped_total = Buffer_Stats.Outstanding_Length+Buffer_Stats.Retained_Length;
+	if(mapped_total > Buffer_Stats.Peak_Mapped_Length)
+		Buffer_Stats.Peak_Mapped_Length = mapped_total;
+	pthread_mutex_unlock(&Buffer_Mutex);
+	(*buffer_ptr) = buffer;
+	if(capacity != NULL)
+		(*capacity) = mapped_length;
+	return TRUE;
+}
+
+/**
+ * Release a buffer back to the pool, or unmap it if the pool already retains it's maximum length or the buffer is
+ * too large to pool.
+ * @param buffer The buffer. If NULL, nothing is done.
+ * @param unreserve A boolean, if TRUE the buffer's mapped length is returned to the memory budget.
+ *        GCP_Client_Buffer_Grow passes FALSE, as the budget moves on to the grown buffer.
+ * @return The routine returns TRUE on success, and FALSE if the buffer did not come from the pool.
+ *         If it fails, Buffer_Error_Number / Buffer_Error_String should contain details of the failure.
+ * @see #Buffer_Class_Index
+ * @see #Buffer_Unmap
+ * @see #Buffer_Free_List
+ * @see #Buffer_Outstanding_Map
+ * @see #Buffer_Stats
+ * @see gcp_client_budget.html#GCP_Client_Budget_Release
+ */
+static int Buffer_Release(void *buffer,int unreserve)
+{
+	std::unordered_map<void*,size_t>::iterator it;
+	size_t length;
+	int class_index,retained;
+
+	Buffer_Error_Number = 0;
+	if(buffer == NULL)
+		return TRUE;
+	pthread_mutex_lock(&Buffer_Mutex);
+	it = Buffer_Outstanding_Map.find(buffer);
+	if(it == Buffer_Outstanding_Map.end())
+	{
+		pthread_mutex_unlock(&Buffer_Mutex);
+		Buffer_Error_Number = 6;
+		sprintf(Buffer_Error_String,"GCP_Client_Buffer_Release: %p was not acquired from the buffer pool.",buffer);
+		return FALSE;
+	}
+	length = it->second;
+	Buffer_Outstanding_Map.erase(it);
+	Buffer_Stats.Release_Count++;
+	Buffer_Stats.Outstanding_Count--;
+	Buffer_Stats.Outstanding_Length -= length;
+	class_index = Buffer_Class_Index(length);
+	retained = FALSE;
+	if((class_index >= 0)&&((Buffer_Stats.Retained_Length+length) <= Buffer_Stats.Max_Retained_Length))
+	{
+		Buffer_Free_List[class_index].push_back(buffer);
+		Buffer_Stats.Retained_Count++;
+		Buffer_Stats.Retained_Length += length;
+		retained = TRUE;
+	}
+	else
+		Buffer_Stats.Unmap_Count++;
+	pthread_mutex_unlock(&Buffer_Mutex);
+	if(retained == FALSE)
+		Buffer_Unmap(buffer,length);
+	if(unreserve)
+		GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_BUFFER,length);
+	return TRUE;
+}
+
+/**
+ * Return the index of the smallest size class that can hold length bytes.
+ * @param length The number of bytes.
+ * @return The size class index, or -1 if length is longer than the largest size class.
+ * @see #GCP_CLIENT_BUFFER_MIN_CLASS_LENGTH
+ * @see #GCP_CLIENT_BUFFER_CLASS_COUNT
+ */
+static int Buffer_Class_Index(size_t length)
+{
+	int class_index;
+
+	for(class_index = 0; class_index < GCP_CLIENT_BUFFER_CLASS_COUNT; class_index++)
+	{
+		if(length <= (((size_t)GCP_CLIENT_BUFFER_MIN_CLASS_LENGTH) << class_index))
+			return class_index;
+	}
+	return -1;
+}
+
+/**
+ * Return the length of the buffer mapped to hold length bytes: the length of it's size class, or for buffers too
+ * large to pool, length rounded up to a whole number of huge pages.
+ * @param length The number of bytes.
+ * @return The mapped length, in bytes.
+ * @see #Buffer_Class_Index
+ * @see #GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH
+ */
+static size_t Buffer_Mapped_Length(size_t length)
+{
+	int class_index;
+
+	class_index = Buffer_Class_Index(length);
+	if(class_index >= 0)
+		return ((size_t)GCP_CLIENT_BUFFER_MIN_CLASS_LENGTH) << class_index;
+	/* too large to pool, round up to a whole number of huge pages */
+	return ((length+GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH-1)/GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH)*
+		GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH;
+}
+
+/**
+ * Map an anonymous, private area of memory. Areas of a huge page or longer are mapped with a huge page of slack,
+ * which is unmapped again to leave a huge page aligned area, and (where supported) advised to use transparent
+ * huge pages.
+ * @param length The number of bytes to map, a whole number of pages.
+ * @return A pointer to the mapped memory, or NULL on failure (errno is set).
+ * @see #GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH
+ */
+static void *Buffer_Map(size_t length)
+{
+	char *buffer = NULL;
+	char *aligned_buffer = NULL;
+	size_t map_length,head_length,tail_length;
+
+	if(length < GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH)
+		map_length = length;
+	else
+		map_length = length+GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH;
+	buffer = (char *)mmap(NULL,map_length,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+	if(buffer == MAP_FAILED)
+		return NULL;
+	if(map_length == length)
+		aligned_buffer = buffer;
+	else
+	{
+		aligned_buffer = (char *)((((unsigned long)buffer)+GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH-1)&
+					  ~((unsigned long)(GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH-1)));
+		head_length = aligned_buffer-buffer;
+		tail_length = map_length-head_length-length;
+		if(head_length > 0)
+			munmap(buffer,head_length);
+		if(tail_length > 0)
+			munmap(aligned_buffer+length,tail_length);
+#ifdef MADV_HUGEPAGE
+		madvise(aligned_buffer,length,MADV_HUGEPAGE);
+#endif
+	}
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_BUFFER,LOG_VERBOSITY_VERY_VERBOSE,
+					     "Buffer_Map:Mapped %lu bytes at %p.",(unsigned long)length,aligned_buffer);
+#endif
+	return aligned_buffer;
+}
+
+/**
+ * Unmap an area of memory mapped by Buffer_Map.
+ * @param buffer The memory.
+ * @param length The number of bytes mapped.
+ */
+static void Buffer_Unmap(void *buffer,size_t length)
+{
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_BUFFER,LOG_VERBOSITY_VERY_VERBOSE,
+					     "Buffer_Unmap:Unmapping %lu bytes at %p.",(unsigned long)length,buffer);
+#endif
+	munmap(buffer,length);
+}
+
+/**
+ * Unmap retained buffers, largest size class first, until the pool retains no more than max_retained_length
+ * bytes. The buffers are taken off the free lists with the mutex held, and unmapped after it is released.
+ * @param max_retained_length The number of bytes the pool may retain.
+ * @see #Buffer_Free_List
+ * @see #Buffer_Unmap
+ * @see #Buffer_Stats
+ */
+static void Buffer_Trim_To(unsigned long long max_retained_length)
+{
+	std::vector<void*> unmap_list[GCP_CLIENT_BUFFER_CLASS_COUNT];
+	size_t length;
+	int class_index;
+
+	pthread_mutex_lock(&Buffer_Mutex);
+	for(class_index = GCP_CLIENT_BUFFER_CLASS_COUNT-1; class_index >= 0; class_index--)
+	{
+		length = ((size_t)GCP_CLIENT_BUFFER_MIN_CLASS_LENGTH) << class_index;
+		while((Buffer_Stats.Retained_Length > max_retained_length)&&(Buffer_Free_List[class_index].size() > 0))
+		{
+			unmap_list[class_index].push_back(Buffer_Free_List[class_index].back());
+			Buffer_Free_List[class_index].pop_back();
+			Buffer_Stats.Retained_Count--;
+			Buffer_Stats.Retained_Length -= length;
+			Buffer_Stats.Unmap_Count++;
+		}
+	}
+	pthread_mutex_unlock(&Buffer_Mutex);
+	for(class_index = 0; class_index < GCP_CLIENT_BUFFER_CLASS_COUNT; class_index++)
+	{
+		length = ((size_t)GCP_CLIENT_BUFFER_MIN_CLASS_LENGTH) << class_index;
+		for(size_t i = 0; i < unmap_list[class_index].size(); i++)
+			Buffer_Unmap(unmap_list[class_index][i],length);
+	}
+}
@@ -0,0 +1,951 @@
+/* gcp_client_completions.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Completion queue routines, for driving transfers from a select/poll/epoll event loop.
+*/
+/**
+ * Routines letting a single threaded event loop (select, poll or epoll) drive many transfers at once. A transfer is
+ * started (GCP_Client_Completions_Read_Start etc) without blocking, and is run by one of the completion queue's
+ * transfer threads. When it finishes, a completion is queued, and the queue's file descriptor (an eventfd,
+ * GCP_Client_Completions_Get_Fd) becomes readable. The event loop adds the file descriptor to it's read set, and
+ * when it is readable calls GCP_Client_Completions_Drain to collect the finished transfers.
+ * <p>
+ * The file descriptor stays readable while there are completions left to drain, so it works with level triggered
+ * loops (select, poll, epoll without EPOLLET). With edge triggered epoll, drain until no completions are returned.
+ * <p>
+ * Each transfer runs at the bandwidth priority (GCP_Client_Bandwidth_Set_Thread_Priority) of the thread that
+ * started it. Reads and writes are made with an operation, so they can be cancelled while running
+ * (GCP_Client_Completions_Cancel). Range reads and deletes can only be cancelled before they start.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <deque>
+#include <new>
+#include <string>
+#include <vector>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_completions.h"
+#include "gcp_client_delete.h"
+#include "gcp_client_operation.h"
+#include "gcp_client_read_write.h"
+
+/* data types */
+/**
+ * Data type holding a transfer that has been started, but has not finished. This consists of the following:
+ * <dl>
+ * <dt>Id</dt> <dd>The transfer's id.</dd>
+ * <dt>Type</dt> <dd>The transfer type (GCP_CLIENT_COMPLETIONS_TYPE_*).</dd>
+ * <dt>Bucket_Name</dt> <dd>The name of the bucket.</dd>
+ * <dt>Object_Name</dt> <dd>The name of the object.</dd>
+ * <dt>Offset</dt> <dd>For range reads, the offset of the first byte to read.</dd>
+ * <dt>Length</dt> <dd>For range reads, the number of bytes to read. For writes, the number of bytes to write.</dd>
+ * <dt>Data</dt> <dd>For writes, the caller's data.</dd>
+ * <dt>Generation</dt> <dd>For deletes, the generation precondition (0 for none).</dd>
+ * <dt>User_Data</dt> <dd>The caller's user data, returned in the completion.</dd>
+ * <dt>Priority</dt> <dd>The bandwidth priority of the thread that started the transfer.</dd>
+ * <dt>Operation</dt> <dd>The operation reads and writes are made with.</dd>
+ * <dt>Cancelled</dt> <dd>A boolean, TRUE when the running transfer has been cancelled.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_COMPLETIONS_TYPE_READ
+ */
+struct Completions_Transfer_Struct
+{
+	unsigned long long Id;
+	int Type;
+	std::string Bucket_Name;
+	std::string Object_Name;
+	unsigned long long Offset;
+	size_t Length;
+	void *Data;
+	long long Generation;
+	void *User_Data;
+	int Priority;
+	struct GCP_Client_Operation_Struct *Operation;
+	int Cancelled;
+};
+
+/**
+ * Data type holding a completion queue. This consists of the following:
+ * <dl>
+ * <dt>Mutex</dt> <dd>Mutex protecting the rest of the structure.</dd>
+ * <dt>Work_Condition</dt> <dd>Condition variable, signalled when a transfer is started.</dd>
+ * <dt>Event_Fd</dt> <dd>The eventfd, readable while Completed_List is not empty.</dd>
+ * <dt>Thread_List</dt> <dd>The transfer threads.</dd>
+ * <dt>Waiting_List</dt> <dd>The transfers started that are waiting for a thread.</dd>
+ * <dt>Running_List</dt> <dd>The transfers running now.</dd>
+ * <dt>Completed_List</dt> <dd>The completions waiting to be drained.</dd>
+ * <dt>Next_Id</dt> <dd>The id the next transfer started is given.</dd>
+ * <dt>Pending_Count</dt> <dd>The number of transfers started whose completions have not been drained.</dd>
+ * <dt>Shutdown</dt> <dd>A boolean, TRUE once GCP_Client_Completions_Destroy has been called.</dd>
+ * </dl>
+ */
+struct GCP_Client_Completions_Struct
+{
+	pthread_mutex_t Mutex;
+	pthread_cond_t Work_Condition;
+	int Event_Fd;
+	std::vector<pthread_t> Thread_List;
+	std::deque<struct Completions_Transfer_Struct*> Waiting_List;
+	std::vector<struct Completions_Transfer_Struct*> Running_List;
+	std::deque<struct GCP_Client_Completion_Struct> Completed_List;
+	unsigned long long Next_Id;
+	int Pending_Count;
+	int Shutdown;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Completions_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Completions_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static int Completions_Start(struct GCP_Client_Completions_Struct *completions,
+			     struct Completions_Transfer_Struct *transfer,unsigned long long *id);
+static void *Completions_Thread(void *user_data);
+static void Completions_Run(struct Completions_Transfer_Struct *transfer,
+			    struct GCP_Client_Completion_Struct *completion);
+static void Completions_Copy_Error(struct GCP_Client_Completion_Struct *completion,int error_number,
+				   void (*error_string_fn)(char *error_string));
+static void Completions_Post(struct GCP_Client_Completions_Struct *completions,
+			     struct GCP_Client_Completion_Struct *completion);
+static void Completions_Signal(struct GCP_Client_Completions_Struct *completions);
+static void Completions_Transfer_Free(struct Completions_Transfer_Struct *transfer);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Create a completion queue: it's eventfd, and it's transfer threads.
+ * @param completions The address of a pointer to fill in with the new completion queue.
+ * @param thread_count The number of transfer threads, which is the most transfers run at once. If 0,
+ *        GCP_CLIENT_COMPLETIONS_DEFAULT_THREAD_COUNT is used.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_CLIENT_COMPLETIONS_DEFAULT_THREAD_COUNT
+ * @see #GCP_CLIENT_COMPLETIONS_MAX_THREAD_COUNT
+ * @see #GCP_Client_Completions_Struct
+ * @see #GCP_Client_Completions_Destroy
+ * @see #Completions_Thread
+ */
+int GCP_Client_Completions_Create(struct GCP_Client_Completions_Struct **completions,int thread_count)
+{
+	pthread_t thread;
+	int i,retval;
+
+	Completions_Error_Number = 0;
+	if(completions == NULL)
+	{
+		Completions_Error_Number = 1;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Create:completions was NULL.");
+		return FALSE;
+	}
+	if(thread_count == 0)
+		thread_count = GCP_CLIENT_COMPLETIONS_DEFAULT_THREAD_COUNT;
+	if((thread_count < 1)||(thread_count > GCP_CLIENT_COMPLETIONS_MAX_THREAD_COUNT))
+	{
+		Completions_Error_Number = 2;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Create:Illegal thread count %d (1..%d).",
+			thread_count,GCP_CLIENT_COMPLETIONS_MAX_THREAD_COUNT);
+		return FALSE;
+	}
+	(*completions) = new (std::nothrow) struct GCP_Client_Completions_Struct;
+	if((*completions) == NULL)
+	{
+		Completions_Error_Number = 3;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Create:Failed to allocate completion queue.");
+		return FALSE;
+	}
+	(*completions)->Event_Fd = eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+	if((*completions)->Event_Fd < 0)
+	{
+		Completions_Error_Number = 4;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Create:Failed to create eventfd (%d:%s).",
+			errno,strerror(errno));
+		delete (*completions);
+		(*completions) = NULL;
+		return FALSE;
+	}
+	pthread_mutex_init(&((*completions)->Mutex),NULL);
+	pthread_cond_init(&((*completions)->Work_Condition),NULL);
+	(*completions)->Next_Id = 1;
+	(*completions)->Pending_Count = 0;
+	(*completions)->Shutdown = FALSE;
+	for(i=0; i < thread_count; i++)
+	{
+		retval = pthread_create(&thread,NULL,Completions_Thread,(void*)(*completions));
+		if(retval != 0)
+		{
+			/* stop the threads already started */
+			pthread_mutex_lock(&((*completions)->Mutex));
+			(*completions)->Shutdown = TRUE;
+			pthread_cond_broadcast(&((*completions)->Work_Condition));
+			pthread_mutex_unlock(&((*completions)->Mutex));
+			for(auto &transfer_thread : (*completions)->Thread_List)
+				pthread_join(transfer_thread,NULL);
+			pthread_cond_destroy(&((*completions)->Work_Condition));
+			pthread_mutex_destroy(&((*completions)->Mutex));
+			close((*completions)->Event_Fd);
+			delete (*completions);
+			(*completions) = NULL;
+			Completions_Error_Number = 5;
+			sprintf(Completions_Error_String,
+				"GCP_Client_Completions_Create:Failed to create transfer thread %d (%d).",i,retval);
+			return FALSE;
+		}
+		(*completions)->Thread_List.push_back(thread);
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COMPLETIONS,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Completions_Create:Completion queue %p started with %d threads, "
+					     "eventfd %d.",(void*)(*completions),thread_count,(*completions)->Event_Fd);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the completion queue's file descriptor, to add to an event loop's read set. It is readable while there are
+ * completions to drain. Do not read it directly, call GCP_Client_Completions_Drain.
+ * @param completions The completion queue.
+ * @param fd The address of an integer to fill in with the file descriptor.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Completions_Drain
+ */
+int GCP_Client_Completions_Get_Fd(struct GCP_Client_Completions_Struct *completions,int *fd)
+{
+	Completions_Error_Number = 0;
+	if(completions == NULL)
+	{
+		Completions_Error_Number = 6;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Get_Fd:completions was NULL.");
+		return FALSE;
+	}
+	if(fd == NULL)
+	{
+		Completions_Error_Number = 7;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Get_Fd:fd was NULL.");
+		return FALSE;
+	}
+	(*fd) = completions->Event_Fd;
+	return TRUE;
+}
+
+/**
+ * Start reading an object (GCP_Client_Read_Write_Read_Operation). The routine returns straight away. The bytes
+ * read are returned in the transfer's completion, and must be freed by the caller.
+ * @param completions The completion queue.
+ * @param bucket_name The name of the bucket.
+ * @param object_name The name of the object.
+ * @param user_data A pointer returned in the transfer's completion.
+ * @param id The address of an integer to fill in with the transfer's id, or NULL.
+ * @return The routine returns TRUE if the transfer was started, and FALSE on failure.
+ * @see #GCP_CLIENT_COMPLETIONS_TYPE_READ
+ * @see #Completions_Start
+ * @see gcp_client_read_write.html#GCP_Client_Read_Write_Read_Operation
+ */
+int GCP_Client_Completions_Read_Start(struct GCP_Client_Completions_Struct *completions,char *bucket_name,
+				      char *object_name,void *user_data,unsigned long long *id)
+{
+	struct Completions_Transfer_Struct *transfer = NULL;
+
+	Completions_Error_Number = 0;
+	if((bucket_name == NULL)||(object_name == NULL))
+	{
+		Completions_Error_Number = 8;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Read_Start:bucket_name or object_name was NULL.");
+		return FALSE;
+	}
+	transfer = new (std::nothrow) struct Completions_Transfer_Struct;
+	if(transfer == NULL)
+	{
+		Completions_Error_Number = 9;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Read_Start:Failed to allocate transfer.");
+		return FALSE;
+	}
+	transfer->Type = GCP_CLIENT_COMPLETIONS_TYPE_READ;
+	transfer->Bucket_Name = bucket_name;
+	transfer->Object_Name = object_name;
+	transfer->Offset = 0;
+	transfer->Length = 0;
+	transfer->Data = NULL;
+	transfer->Generation = 0;
+	transfer->User_Data = user_data;
+	return Completions_Start(completions,transfer,id);
+}
+
+/**
+ * Start reading part of an object (GCP_Client_Read_Write_Read_Range). The routine returns straight away. The bytes
+ * read are returned in the transfer's completion, and must be freed by the caller.
+ * @param completions The completion queue.
+ * @param bucket_name The name of the bucket.
+ * @param object_name The name of the object.
+ * @param offset The offset of the first byte to read.
+ * @param length The number of bytes to read (fewer are returned if the object ends first).
+ * @param user_data A pointer returned in the transfer's completion.
+ * @param id The address of an integer to fill in with the transfer's id, or NULL.
+ * @return The routine returns TRUE if the transfer was started, and FALSE on failure.
+ * @see #GCP_CLIENT_COMPLETIONS_TYPE_READ_RANGE
+ * @see #Completions_Start
+ * @see gcp_client_read_write.html#GCP_Client_Read_Write_Read_Range
+ */
+int GCP_Client_Completions_Read_Range_Start(struct GCP_Client_Completions_Struct *completions,
+					    char *bucket_name,char *object_name,unsigned long long offset,
+					    size_t length,void *user_data,unsigned long long *id)
+{
+	struct Completions_Transfer_Struct *transfer = NULL;
+
+	Completions_Error_Number = 0;
+	if((bucket_name == NULL)||(object_name == NULL))
+	{
+		Completions_Error_Number = 10;
+		sprintf(Completions_Error_String,
+			"GCP_Client_Completions_Read_Range_Start:bucket_name or object_name was NULL.");
+		return FALSE;
+	}
+	if(length == 0)
+	{
+		Completions_Error_Number = 11;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Read_Range_Start:length was 0.");
+		return FALSE;
+	}
+	transfer = new (std::nothrow) struct Completions_Transfer_Struct;
+	if(transfer == NULL)
+	{
+		Completions_Error_Number = 12;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Read_Range_Start:Failed to allocate transfer.");
+		return FALSE;
+	}
+	transfer->Type = GCP_CLIENT_COMPLETIONS_TYPE_READ_RANGE;
+	transfer->Bucket_Name = bucket_name;
+	transfer->Object_Name = object_name;
+	transfer->Offset = offset;
+	transfer->Length = length;
+	transfer->Data = NULL;
+	transfer->Generation = 0;
+	transfer->User_Data = user_data;
+	return Completions_Start(completions,transfer,id);
+}
+
+/**
+ * Start writing an object (GCP_Client_Read_Write_Write_Operation). The routine returns straight away. The data is
+ * not copied, and must not be changed or freed until the transfer's completion has been drained.
+ * @param completions The completion queue.
+ * @param bucket_name The name of the bucket.
+ * @param object_name The name of the object.
+ * @param data The bytes to write.
+ * @param length The number of bytes to write.
+ * @param user_data A pointer returned in the transfer's completion.
+ * @param id The address of an integer to fill in with the transfer's id, or NULL.
+ * @return The routine returns TRUE if the transfer was started, and FALSE on failure.
+ * @see #GCP_CLIENT_COMPLETIONS_TYPE_WRITE
+ * @see #Completions_Start
+ * @see gcp_client_read_write.html#GCP_Client_Read_Write_Write_Operation
+ */
+int GCP_Client_Completions_Write_Start(struct GCP_Client_Completions_Struct *completions,char *bucket_name,
+				       char *object_name,void *data,size_t length,void *user_data,
+				       unsigned long long *id)
+{
+	struct Completions_Transfer_Struct *transfer = NULL;
+
+	Completions_Error_Number = 0;
+	if((bucket_name == NULL)||(object_name == NULL))
+	{
+		Completions_Error_Number = 13;
+		sprintf(Completions_Error_String,
+			"GCP_Client_Completions_Write_Start:bucket_name or object_name was NULL.");
+		return FALSE;
+	}
+	if((data == NULL)&&(length > 0))
+	{
+		Completions_Error_Number = 14;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Write_Start:data was NULL.");
+		return FALSE;
+	}
+	transfer = new (std::nothrow) struct Completions_Transfer_Struct;
+	if(transfer == NULL)
+	{
+		Completions_Error_Number = 15;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Write_Start:Failed to allocate transfer.");
+		return FALSE;
+	}
+	transfer->Type = GCP_CLIENT_COMPLETIONS_TYPE_WRITE;
+	transfer->Bucket_Name = bucket_name;
+	transfer->Object_Name = object_name;
+	transfer->Offset = 0;
+	transfer->Length = length;
+	transfer->Data = data;
+	transfer->Generation = 0;
+	transfer->User_Data = user_data;
+	return Completions_Start(completions,transfer,id);
+}
+
+/**
+ * Start deleting an object (GCP_Client_Delete). The routine returns straight away. The delete status is returned in
+ * the transfer's completion.
+ * @param completions The completion queue.
+ * @param bucket_name The name of the bucket.
+ * @param object_name The name of the object.
+ * @param generation If greater than zero, the object is only deleted if it's live generation matches this.
+ * @param user_data A pointer returned in the transfer's completion.
+ * @param id The address of an integer to fill in with the transfer's id, or NULL.
+ * @return The routine returns TRUE if the transfer was started, and FALSE on failure.
+ * @see #GCP_CLIENT_COMPLETIONS_TYPE_DELETE
+ * @see #Completions_Start
+ * @see gcp_client_delete.html#GCP_Client_Delete
+ */
+int GCP_Client_Completions_Delete_Start(struct GCP_Client_Completions_Struct *completions,char *bucket_name,
+					char *object_name,long long generation,void *user_data,
+					unsigned long long *id)
+{
+	struct Completions_Transfer_Struct *transfer = NULL;
+
+	Completions_Error_Number = 0;
+	if((bucket_name == NULL)||(object_name == NULL))
+	{
+		Completions_Error_Number = 16;
+		sprintf(Completions_Error_String,
+			"GCP_Client_Completions_Delete_Start:bucket_name or object_name was NULL.");
+		return FALSE;
+	}
+	transfer = new (std::nothrow) struct Completions_Transfer_Struct;
+	if(transfer == NULL)
+	{
+		Completions_Error_Number = 17;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Delete_Start:Failed to allocate transfer.");
+		return FALSE;
+	}
+	transfer->Type = GCP_CLIENT_COMPLETIONS_TYPE_DELETE;
+	transfer->Bucket_Name = bucket_name;
+	transfer->Object_Name = object_name;
+	transfer->Offset = 0;
+	transfer->Length = 0;
+	transfer->Data = NULL;
+	transfer->Generation = generation;
+	transfer->User_Data = user_data;
+	return Completions_Start(completions,transfer,id);
+}
+
+/**
+ * Cancel a transfer. A transfer still waiting for a thread is removed, and it's completion (with state
+ * GCP_CLIENT_OPERATION_STATE_CANCELLED) is queued straight away. A running read or write is cancelled
+ * (GCP_Client_Operation_Cancel), and it's completion is queued when it's transfer thread notices. A running range
+ * read or delete can't be cancelled, and finishes normally.
+ * @param completions The completion queue.
+ * @param id The id of the transfer to cancel.
+ * @return The routine returns TRUE if the transfer was found, and FALSE if it was not (it may already have
+ *         finished).
+ * @see #Completions_Post
+ * @see gcp_client_operation.html#GCP_Client_Operation_Cancel
+ */
+int GCP_Client_Completions_Cancel(struct GCP_Client_Completions_Struct *completions,unsigned long long id)
+{
+	struct GCP_Client_Completion_Struct completion;
+
+	Completions_Error_Number = 0;
+	if(completions == NULL)
+	{
+		Completions_Error_Number = 18;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Cancel:completions was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(completions->Mutex));
+	for(auto it = completions->Waiting_List.begin(); it != completions->Waiting_List.end(); it++)
+	{
+		if((*it)->Id == id)
+		{
+			auto transfer = (*it);
+
+			completions->Waiting_List.erase(it);
+			memset(&completion,0,sizeof(struct GCP_Client_Completion_Struct));
+			completion.Id = transfer->Id;
+			completion.Type = transfer->Type;
+			completion.Success = FALSE;
+			completion.State = GCP_CLIENT_OPERATION_STATE_CANCELLED;
+			if(transfer->Type == GCP_CLIENT_COMPLETIONS_TYPE_WRITE)
+				completion.Data = transfer->Data;
+			completion.User_Data = transfer->User_Data;
+			Completions_Post(completions,&completion);
+			pthread_mutex_unlock(&(completions->Mutex));
+			Completions_Transfer_Free(transfer);
+			return TRUE;
+		}
+	}
+	for(auto transfer : completions->Running_List)
+	{
+		if(transfer->Id == id)
+		{
+			transfer->Cancelled = TRUE;
+			GCP_Client_Operation_Cancel(transfer->Operation);
+			pthread_mutex_unlock(&(completions->Mutex));
+			return TRUE;
+		}
+	}
+	pthread_mutex_unlock(&(completions->Mutex));
+	Completions_Error_Number = 19;
+	sprintf(Completions_Error_String,"GCP_Client_Completions_Cancel:Transfer %llu not found.",id);
+	return FALSE;
+}
+
+/**
+ * Collect finished transfers. Call this when the completion queue's file descriptor is readable. The routine
+ * does not block: if no transfers have finished, completion_count is set to 0. If more than max_count transfers
+ * have finished, the rest are left queued, and the file descriptor stays readable.
+ * @param completions The completion queue.
+ * @param completion_list An array of at least max_count completions, to fill in with the finished transfers, in
+ *        the order they finished.
+ * @param max_count The number of completions completion_list can hold.
+ * @param completion_count The address of an integer to fill in with the number of completions returned.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Completion_Struct
+ * @see #Completions_Signal
+ */
+int GCP_Client_Completions_Drain(struct GCP_Client_Completions_Struct *completions,
+				 struct GCP_Client_Completion_Struct *completion_list,int max_count,
+				 int *completion_count)
+{
+	uint64_t event_count;
+
+	Completions_Error_Number = 0;
+	if(completions == NULL)
+	{
+		Completions_Error_Number = 20;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Drain:completions was NULL.");
+		return FALSE;
+	}
+	if((completion_list == NULL)||(max_count < 1))
+	{
+		Completions_Error_Number = 21;
+		sprintf(Completions_Error_String,
+			"GCP_Client_Completions_Drain:completion_list was NULL or max_count %d was less than 1.",
+			max_count);
+		return FALSE;
+	}
+	if(completion_count == NULL)
+	{
+		Completions_Error_Number = 22;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Drain:completion_count was NULL.");
+		return FALSE;
+	}
+	(*completion_count) = 0;
+	pthread_mutex_lock(&(completions->Mutex));
+	/* clear the eventfd (it's non-blocking, so this fails with EAGAIN if it was already clear) */
+	if(read(completions->Event_Fd,&event_count,sizeof(uint64_t)) < 0)
+		event_count = 0;
+	while(((*completion_count) < max_count)&&(completions->Completed_List.size() > 0))
+	{
+		completion_list[(*completion_count)] = completions->Completed_List.front();
+		completions->Completed_List.pop_front();
+		(*completion_count)++;
+	}
+	completions->Pending_Count -= (*completion_count);
+	/* leave the eventfd readable if there are completions left */
+	if(completions->Completed_List.size() > 0)
+		Completions_Signal(completions);
+	pthread_mutex_unlock(&(completions->Mutex));
+	return TRUE;
+}
+
+/**
+ * Get the number of transfers started whose completions have not yet been drained (waiting, running, or finished
+ * but not drained). An event loop can use this to tell when all it's transfers are done.
+ * @param completions The completion queue.
+ * @param pending_count The address of an integer to fill in with the number of transfers.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ */
+int GCP_Client_Completions_Get_Pending_Count(struct GCP_Client_Completions_Struct *completions,
+					     int *pending_count)
+{
+	Completions_Error_Number = 0;
+	if(completions == NULL)
+	{
+		Completions_Error_Number = 23;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Get_Pending_Count:completions was NULL.");
+		return FALSE;
+	}
+	if(pending_count == NULL)
+	{
+		Completions_Error_Number = 24;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Get_Pending_Count:pending_count was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(completions->Mutex));
+	(*pending_count) = completions->Pending_Count;
+	pthread_mutex_unlock(&(completions->Mutex));
+	return TRUE;
+}
+
+/**
+ * Destroy a completion queue. Transfers waiting for a thread are discarded, running reads and writes are cancelled,
+ * and the routine waits for the transfer threads to stop. The bytes of reads whose completions were not drained
+ * are freed. The file descriptor is closed, so remove it from the event loop first.
+ * @param completions The completion queue.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Completions_Transfer_Free
+ * @see gcp_client_operation.html#GCP_Client_Operation_Cancel
+ */
+int GCP_Client_Completions_Destroy(struct GCP_Client_Completions_Struct *completions)
+{
+	Completions_Error_Number = 0;
+	if(completions == NULL)
+	{
+		Completions_Error_Number = 25;
+		sprintf(Completions_Error_String,"GCP_Client_Completions_Destroy:completions was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(completions->Mutex));
+	completions->Shutdown = TRUE;
+	for(auto transfer : completions->Waiting_List)
+		Completions_Transfer_Free(transfer);
+	completions->Waiting_List.clear();
+	for(auto transfer : completions->Running_List)
+	{
+		transfer->Cancelled = TRUE;
+		GCP_Client_Operation_Cancel(transfer->Operation);
+	}
+	pthread_cond_broadcast(&(completions->Work_Condition));
+	pthread_mutex_unlock(&(completions->Mutex));
+	for(auto &thread : completions->Thread_List)
+		pthread_join(thread,NULL);
+	for(auto &completion : completions->Completed_List)
+	{
+		if((completion.Type != GCP_CLIENT_COMPLETIONS_TYPE_WRITE)&&(completion.Data != NULL))
+			free(completion.Data);
+	}
+	pthread_cond_destroy(&(completions->Work_Condition));
+	pthread_mutex_destroy(&(completions->Mutex));
+	close(completions->Event_Fd);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COMPLETIONS,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Completions_Destroy:Completion queue %p stopped.",
+					     (void*)completions);
+#endif
+	delete completions;
+	return TRUE;
+}
+
+/**
+ * Get the current value of the completions module's error number.
+ * @return The current value of the completions module's error number.
+ * @see #Completions_Error_Number
+ */
+int GCP_Client_Completions_Get_Error_Number(void)
+{
+	return Completions_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Completions_Error_Number
+ * @see #Completions_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Completions_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Completions_Error_Number == 0)
+		sprintf(Completions_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Completions:Error(%d) : %s\n",time_string,Completions_Error_Number,
+		Completions_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Completions_Error_Number
+ * @see #Completions_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Completions_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Completions_Error_Number == 0)
+		sprintf(Completions_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Completions:Error(%d) : %s\n",time_string,
+		Completions_Error_Number,Completions_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Queue a transfer for the next free transfer thread. The transfer is given an id, an operation, and the calling
+ * thread's bandwidth priority. The transfer is freed on failure.
+ * @param completions The completion queue.
+ * @param transfer The transfer, with it's type, names and user data filled in.
+ * @param id The address of an integer to fill in with the transfer's id, or NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Completions_Transfer_Free
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Get_Thread_Priority
+ * @see gcp_client_operation.html#GCP_Client_Operation_Create
+ */
+static int Completions_Start(struct GCP_Client_Completions_Struct *completions,
+			     struct Completions_Transfer_Struct *transfer,unsigned long long *id)
+{
+	if(completions == NULL)
+	{
+		delete transfer;
+		Completions_Error_Number = 26;
+		sprintf(Completions_Error_String,"Completions_Start:completions was NULL.");
+		return FALSE;
+	}
+	if(!GCP_Client_Operation_Create(&(transfer->Operation)))
+	{
+		delete transfer;
+		Completions_Error_Number = 27;
+		sprintf(Completions_Error_String,"Completions_Start:Failed to create operation.");
+		return FALSE;
+	}
+	transfer->Priority = GCP_Client_Bandwidth_Get_Thread_Priority();
+	transfer->Cancelled = FALSE;
+	pthread_mutex_lock(&(completions->Mutex));
+	if(completions->Shutdown)
+	{
+		pthread_mutex_unlock(&(completions->Mutex));
+		Completions_Transfer_Free(transfer);
+		Completions_Error_Number = 28;
+		sprintf(Completions_Error_String,"Completions_Start:The completion queue is shutting down.");
+		return FALSE;
+	}
+	transfer->Id = completions->Next_Id++;
+	if(id != NULL)
+		(*id) = transfer->Id;
+	completions->Waiting_List.push_back(transfer);
+	completions->Pending_Count++;
+	/* logged before the mutex is released, a transfer thread can run, post and free the transfer as soon as
+	** it is */
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COMPLETIONS,LOG_VERBOSITY_VERY_VERBOSE,
+					     "Completions_Start:Started transfer %llu of type %d for %s/%s.",
+					     transfer->Id,transfer->Type,transfer->Bucket_Name.c_str(),
+					     transfer->Object_Name.c_str());
+#endif
+	pthread_cond_signal(&(completions->Work_Condition));
+	pthread_mutex_unlock(&(completions->Mutex));
+	return TRUE;
+}
+
+/**
+ * Transfer thread. Repeatedly takes the oldest waiting transfer, runs it (Completions_Run) at the bandwidth
+ * priority of the thread that started it, and queues it's completion (Completions_Post). The thread exits when the
+ * completion queue is shutting down.
+ * @param user_data The completion queue, cast to a void pointer.
+ * @return The routine returns NULL.
+ * @see #Completions_Run
+ * @see #Completions_Post
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Set_Thread_Priority
+ */
+static void *Completions_Thread(void *user_data)
+{
+	struct GCP_Client_Completions_Struct *completions = (struct GCP_Client_Completions_Struct *)user_data;
+	struct Completions_Transfer_Struct *transfer = NULL;
+	struct GCP_Client_Completion_Struct completion;
+
+	pthread_mutex_lock(&(completions->Mutex));
+	while(TRUE)
+	{
+		if(completions->Waiting_List.size() == 0)
+		{
+			if(completions->Shutdown)
+				break;
+			pthread_cond_wait(&(completions->Work_Condition),&(completions->Mutex));
+			continue;
+		}
+		transfer = completions->Waiting_List.front();
+		completions->Waiting_List.pop_front();
+		completions->Running_List.push_back(transfer);
+		pthread_mutex_unlock(&(completions->Mutex));
+		GCP_Client_Bandwidth_Set_Thread_Priority(transfer->Priority);
+		Completions_Run(transfer,&completion);
+		pthread_mutex_lock(&(completions->Mutex));
+		for(auto it = completions->Running_List.begin(); it != completions->Running_List.end(); it++)
+		{
+			if((*it) == transfer)
+			{
+				completions->Running_List.erase(it);
+				break;
+			}
+		}
+		if(transfer->Cancelled&&(completion.Success == FALSE))
+			completion.State = GCP_CLIENT_OPERATION_STATE_CANCELLED;
+		if(completions->Shutdown)
+		{
+			/* nobody will drain this completion */
+			if((completion.Type != GCP_CLIENT_COMPLETIONS_TYPE_WRITE)&&(completion.Data != NULL))
+				free(completion.Data);
+		}
+		else
+			Completions_Post(completions,&completion);
+		Completions_Transfer_Free(transfer);
+	}
+	pthread_mutex_unlock(&(completions->Mutex));
+	return NULL;
+}
+
+/**
+ * Run a transfer in the calling thread, and fill in it's completion.
+ * @param transfer The transfer.
+ * @param completion The address of a completion to fill in.
+ * @see #Completions_Copy_Error
+ * @see gcp_client_delete.html#GCP_Client_Delete
+ * @see gcp_client_operation.html#GCP_Client_Operation_Get_State
+ * @see gcp_client_read_write.html#GCP_Client_Read_Write_Read_Operation
+ * @see gcp_client_read_write.html#GCP_Client_Read_Write_Read_Range
+ * @see gcp_client_read_write.html#GCP_Client_Read_Write_Write_Operation
+ */
+static void Completions_Run(struct Completions_Transfer_Struct *transfer,
+			    struct GCP_Client_Completion_Struct *completion)
+{
+	int state;
+
+	memset(completion,0,sizeof(struct GCP_Client_Completion_Struct));
+	completion->Id = transfer->Id;
+	completion->Type = transfer->Type;
+	completion->User_Data = transfer->User_Data;
+	switch(transfer->Type)
+	{
+		case GCP_CLIENT_COMPLETIONS_TYPE_READ:
+			completion->Success = GCP_Client_Read_Write_Read_Operation(transfer->Operation,
+										  (char*)transfer->Bucket_Name.c_str(),
+										  (char*)transfer->Object_Name.c_str(),
+										  &(completion->Data),
+										  &(completion->Length));
+			if(completion->Success == FALSE)
+				Completions_Copy_Error(completion,GCP_Client_Read_Write_Get_Error_Number(),
+						       GCP_Client_Read_Write_Error_String);
+			break;
+		case GCP_CLIENT_COMPLETIONS_TYPE_READ_RANGE:
+			completion->Success = GCP_Client_Read_Write_Read_Range((char*)transfer->Bucket_Name.c_str(),
+									      (char*)transfer->Object_Name.c_str(),
+									      transfer->Offset,transfer->Length,
+									      &(completion->Data),
+									      &(completion->Length));
+			if(completion->Success == FALSE)
+				Completions_Copy_Error(completion,GCP_Client_Read_Write_Get_Error_Number(),
+						       GCP_Client_Read_Write_Error_String);
+			break;
+		case GCP_CLIENT_COMPLETIONS_TYPE_WRITE:
+			completion->Data = transfer->Data;
+			completion->Success = GCP_Client_Read_Write_Write_Operation(transfer->Operation,
+										   (char*)transfer->Bucket_Name.c_str(),
+										   (char*)transfer->Object_Name.c_str(),
+										   transfer->Data,transfer->Length);
+			if(completion->Success)
+				completion->Length = transfer->Length;
+			else
+				Completions_Copy_Error(completion,GCP_Client_Read_Write_Get_Error_Number(),
+						       GCP_Client_Read_Write_Error_String);
+			break;
+		case GCP_CLIENT_COMPLETIONS_TYPE_DELETE:
+			completion->Success = GCP_Client_Delete((char*)transfer->Bucket_Name.c_str(),
+								(char*)transfer->Object_Name.c_str(),
+								transfer->Generation,&(completion->Delete_Status));
+			if(completion->Success == FALSE)
+				Completions_Copy_Error(completion,GCP_Client_Delete_Get_Error_Number(),
+						       GCP_Client_Delete_Error_String);
+			break;
+	}
+	if(completion->Success)
+		completion->State = GCP_CLIENT_OPERATION_STATE_COMPLETED;
+	else
+	{
+		completion->State = GCP_CLIENT_OPERATION_STATE_FAILED;
+		/* reads and writes may have stopped because their operation was cancelled, or timed out */
+		if(GCP_Client_Operation_Get_State(transfer->Operation,&state,NULL)&&
+		   ((state == GCP_CLIENT_OPERATION_STATE_CANCELLED)||
+		    (state == GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED)||
+		    (state == GCP_CLIENT_OPERATION_STATE_STALLED)))
+			completion->State = state;
+	}
+}
+
+/**
+ * Copy the failing module's (per-thread) error into a completion, so it can be read by the thread that drains it.
+ * @param completion The completion.
+ * @param error_number The failing module's error number.
+ * @param error_string_fn The failing module's Error_String routine.
+ * @see #GCP_CLIENT_COMPLETIONS_ERROR_STRING_LENGTH
+ */
+static void Completions_Copy_Error(struct GCP_Client_Completion_Struct *completion,int error_number,
+				   void (*error_string_fn)(char *error_string))
+{
+	char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH*2] = "";
+
+	(*error_string_fn)(error_string);
+	completion->Error_Number = error_number;
+	strncpy(completion->Error_String,error_string,GCP_CLIENT_COMPLETIONS_ERROR_STRING_LENGTH-1);
+	completion->Error_String[GCP_CLIENT_COMPLETIONS_ERROR_STRING_LENGTH-1] = '\0';
+}
+
+/**
+ * Queue a completion to be drained, and make the file descriptor readable. The completion queue's mutex must be
+ * locked.
+ * @param completions The completion queue.
+ * @param completion The completion, which is copied.
+ * @see #Completions_Signal
+ */
+static void Completions_Post(struct GCP_Client_Completions_Struct *completions,
+			     struct GCP_Client_Completion_Struct *completion)
+{
+	completions->Completed_List.push_back((*completion));
+	Completions_Signal(completions);
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COMPLETIONS,LOG_VERBOSITY_VERY_VERBOSE,
+					     "Completions_Post:Transfer %llu finished in state %s.",completion->Id,
+					     GCP_Client_Operation_State_To_String(completion->State));
+#endif
+}
+
+/**
+ * Make the completion queue's eventfd readable, by adding 1 to it's counter.
+ * @param completions The completion queue.
+ */
+static void Completions_Signal(struct GCP_Client_Completions_Struct *completions)
+{
+	uint64_t event_count = 1;
+
+	/* this can only fail if the counter would overflow, in which case the eventfd is already readable */
+	if(write(completions->Event_Fd,&event_count,sizeof(uint64_t)) < 0)
+		event_count = 0;
+}
+
+/**
+ * Free a transfer, and it's operation.
+ * @param transfer The transfer.
+ * @see gcp_client_operation.html#GCP_Client_Operation_Destroy
+ */
+static void Completions_Transfer_Free(struct Completions_Transfer_Struct *transfer)
+{
+	GCP_Client_Operation_Destroy(transfer->Operation);
+	delete transfer;
+}
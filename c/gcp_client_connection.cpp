@@ -11,6 +11,7 @@
 #include "log_udp.h"
 #include "gcp_client_general.h"
 #include "gcp_client_connection.h"
+#include "gcp_client_stats.h"
 
 /* defines */
 /* data types */
@@ -52,17 +53,24 @@ static char Connection_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = ""
  * Create a google cloud services Client connection instance.
  * We authenticate using the google cloud application-default credentials (gcloud auth application-default login).
  * @see #Connection_Data
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
  */
 int GCP_Client_Connection_Open(void)
 {
+	struct timespec start_time;
+
 	Connection_Error_Number = 0;
 	namespace gcs = ::google::cloud::storage;
 #if LOGGING > 0
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_TERSE,"GCP_Client_Connection_Open:Started.");
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_CONNECTION,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Connection_Open:Started.");
 #endif
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
 	Connection_Data.Client_Connection = gcs::Client();
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_OPEN,start_time,0,TRUE);
 #if LOGGING > 0
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_TERSE,"GCP_Client_Connection_Open:Finished.");
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_CONNECTION,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Connection_Open:Finished.");
 #endif
 	return TRUE;
 }
@@ -0,0 +1,476 @@
+/* gcp_client_copy.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Server-side object copy routines.
+*/
+/**
+ * Google Cloud Platform server-side object copy routines. The object data is copied within the cloud, and does not
+ * pass through this machine. GCP_Client_Copy makes a single CopyObject request, which only works for objects the
+ * service can copy in one call (usually those within the same location and storage class). GCP_Client_Rewrite
+ * makes as many RewriteObject calls as needed, passing the rewrite token returned by each call to the next, so
+ * copies of any size between any buckets and storage classes work, and interrupted copies can be resumed.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include "google/cloud/storage/client.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_copy.h"
+#include "gcp_client_list.h"
+#include "gcp_client_stats.h"
+#include "gcp_client_trace.h"
+#include "gcp_client_connection_private.h"
+#include "gcp_client_list_private.h"
+
+/* data types */
+/**
+ * Data type holding the state of a batch of rewrites, shared between the batch threads.
+ * This consists of the following:
+ * <dl>
+ * <dt>Request_List</dt> <dd>The list of copy requests.</dd>
+ * <dt>Mutex</dt> <dd>A mutex protecting the failure fields below.</dd>
+ * <dt>Failed_Count</dt> <dd>The number of copies that failed.</dd>
+ * <dt>Failed_Index</dt> <dd>The index of the first failed copy, or -1.</dd>
+ * <dt>Error_String</dt> <dd>The Copy_Error_String of the first failed copy.</dd>
+ * </dl>
+ */
+struct Copy_Batch_Struct
+{
+	struct GCP_Client_Copy_Request_Struct *Request_List;
+	pthread_mutex_t Mutex;
+	int Failed_Count;
+	int Failed_Index;
+	char Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread, as batches copy
+ * from several threads at once.
+ */
+static thread_local int Copy_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Copy_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static int Copy_Check_Arguments(const char *function_name,char *source_bucket_name,char *source_object_name,
+				char *destination_bucket_name,char *destination_object_name);
+static void Copy_Batch_Item(int index,void *user_data);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Routine to copy an object with a single server-side CopyObject request. This is suitable for small objects,
+ * or copies within the same location and storage class. Otherwise the service may refuse the copy, and
+ * GCP_Client_Rewrite should be used.
+ * @param source_bucket_name The bucket to copy from.
+ * @param source_object_name The object to copy.
+ * @param destination_bucket_name The bucket to copy to (which can be the same as the source bucket).
+ * @param destination_object_name The name of the new object.
+ * @param storage_class The storage class of the new object (e.g. "STANDARD", "NEARLINE", "COLDLINE", "ARCHIVE"),
+ *        or NULL to use the destination bucket's default storage class.
+ * @param metadata The address of a structure to fill in with the new object's metadata, or NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Copy_Error_Number /
+ *         Copy_Error_String should contain details of the failure.
+ * @see #Copy_Check_Arguments
+ * @see #Copy_Error_Number
+ * @see #Copy_Error_String
+ * @see gcp_client_list.html#GCP_Client_List_Metadata_Copy
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Copy(char *source_bucket_name,char *source_object_name,char *destination_bucket_name,
+		    char *destination_object_name,char *storage_class,struct GCP_Client_Object_Metadata_Struct *metadata)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	gcs::WithObjectMetadata object_metadata_option;
+	struct timespec start_time,trace_start_time;
+
+	Copy_Error_Number = 0;
+	if(!Copy_Check_Arguments("GCP_Client_Copy",source_bucket_name,source_object_name,destination_bucket_name,
+				 destination_object_name))
+		return FALSE;
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COPY,LOG_VERBOSITY_INTERMEDIATE,
+				      "GCP_Client_Copy(source=%s/%s,destination=%s/%s,storage_class=%s):Started.",
+				      source_bucket_name,source_object_name,destination_bucket_name,
+				      destination_object_name,(storage_class != NULL) ? storage_class : "default");
+#endif
+	if(storage_class != NULL)
+		object_metadata_option = gcs::WithObjectMetadata(gcs::ObjectMetadata().set_storage_class(storage_class));
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	auto object_metadata = client.CopyObject(source_bucket_name,source_object_name,destination_bucket_name,
+						 destination_object_name,object_metadata_option);
+	if(!object_metadata)
+	{
+		Copy_Error_Number = 5;
+		snprintf(Copy_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Copy: Failed to copy '%s/%s' to '%s/%s' with status '%s'.",
+			 source_bucket_name,source_object_name,destination_bucket_name,destination_object_name,
+			 object_metadata.status().message().c_str());
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_COPY,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("copy",destination_bucket_name,destination_object_name,&trace_start_time,0,
+					  FALSE);
+		return FALSE;
+	}
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_COPY,start_time,object_metadata->size(),TRUE);
+	GCP_Client_Trace_Span_End("copy",destination_bucket_name,destination_object_name,&trace_start_time,
+				  object_metadata->size(),TRUE);
+	if(metadata != NULL)
+		GCP_Client_List_Metadata_Copy(*object_metadata,metadata);
+	return TRUE;
+}
+
+/**
+ * Routine to copy an object server-side with RewriteObject. Large copies, and copies between locations or
+ * storage classes, are done by the service in several steps: each call returns a rewrite token which is passed
+ * to the next call, until the rewrite is done. If rewrite_token is supplied, it is updated after each step, so
+ * a copy that fails part way through (or is interrupted) can be resumed by calling this routine again with the
+ * same arguments and token.
+ * @param source_bucket_name The bucket to copy from.
+ * @param source_object_name The object to copy.
+ * @param destination_bucket_name The bucket to copy to (which can be the same as the source bucket).
+ * @param destination_object_name The name of the new object. This can be the same as the source object,
+ *        for instance to change an object's storage class in place.
+ * @param storage_class The storage class of the new object (e.g. "STANDARD", "NEARLINE", "COLDLINE", "ARCHIVE"),
+ *        or NULL to use the destination bucket's default storage class.
+ * @param rewrite_token A buffer of at least GCP_CLIENT_COPY_REWRITE_TOKEN_LENGTH+1 characters, or NULL.
+ *        If it contains a non-empty token on entry, the rewrite it identifies is resumed.
+ *        On return it contains the token to resume the rewrite with, or an empty string if the rewrite finished.
+ * @param metadata The address of a structure to fill in with the new object's metadata, or NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Copy_Error_Number /
+ *         Copy_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_COPY_REWRITE_TOKEN_LENGTH
+ * @see #Copy_Check_Arguments
+ * @see #Copy_Error_Number
+ * @see #Copy_Error_String
+ * @see gcp_client_list.html#GCP_Client_List_Metadata_Copy
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Rewrite(char *source_bucket_name,char *source_object_name,char *destination_bucket_name,
+		       char *destination_object_name,char *storage_class,char *rewrite_token,
+		       struct GCP_Client_Object_Metadata_Struct *metadata)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	gcs::WithObjectMetadata object_metadata_option;
+	struct timespec start_time,trace_start_time,trace_call_start_time;
+	unsigned long long byte_count;
+	int call_count;
+
+	Copy_Error_Number = 0;
+	if(!Copy_Check_Arguments("GCP_Client_Rewrite",source_bucket_name,source_object_name,destination_bucket_name,
+				 destination_object_name))
+		return FALSE;
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COPY,LOG_VERBOSITY_INTERMEDIATE,
+				      "GCP_Client_Rewrite(source=%s/%s,destination=%s/%s,storage_class=%s,token=%s):Started.",
+				      source_bucket_name,source_object_name,destination_bucket_name,
+				      destination_object_name,(storage_class != NULL) ? storage_class : "default",
+				      ((rewrite_token != NULL)&&(strlen(rewrite_token) > 0)) ? "resumed" : "none");
+#endif
+	if(storage_class != NULL)
+		object_metadata_option = gcs::WithObjectMetadata(gcs::ObjectMetadata().set_storage_class(storage_class));
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	auto rewriter = ((rewrite_token != NULL)&&(strlen(rewrite_token) > 0)) ?
+		client.ResumeRewriteObject(source_bucket_name,source_object_name,destination_bucket_name,
+					   destination_object_name,rewrite_token,object_metadata_option) :
+		client.RewriteObject(source_bucket_name,source_object_name,destination_bucket_name,
+				     destination_object_name,object_metadata_option);
+	byte_count = 0;
+	call_count = 0;
+	/* each Iterate makes one RewriteObject call, which copies up to a service chosen number of bytes */
+	do
+	{
+		GCP_Client_Trace_Span_Begin(&trace_call_start_time);
+		auto progress = rewriter.Iterate();
+		call_count++;
+		if(!progress)
+		{
+			GCP_Client_Trace_Span_End("rewrite_call",destination_bucket_name,destination_object_name,
+						  &trace_call_start_time,0,FALSE);
+			Copy_Error_Number = 6;
+			snprintf(Copy_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Rewrite: Failed to rewrite '%s/%s' to '%s/%s' after %llu bytes "
+				 "with status '%s'.",source_bucket_name,source_object_name,destination_bucket_name,
+				 destination_object_name,byte_count,progress.status().message().c_str());
+			GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_COPY,start_time,byte_count,FALSE);
+			GCP_Client_Trace_Span_End("rewrite",destination_bucket_name,destination_object_name,
+						  &trace_start_time,byte_count,FALSE);
+			return FALSE;
+		}
+		GCP_Client_Trace_Span_End("rewrite_call",destination_bucket_name,destination_object_name,
+					  &trace_call_start_time,progress->total_bytes_rewritten-byte_count,TRUE);
+		byte_count = progress->total_bytes_rewritten;
+		/* save the token so the caller can resume the rewrite from here */
+		if(rewrite_token != NULL)
+		{
+			if(rewriter.token().length() > GCP_CLIENT_COPY_REWRITE_TOKEN_LENGTH)
+			{
+				Copy_Error_Number = 7;
+				sprintf(Copy_Error_String,"GCP_Client_Rewrite: Rewrite token too long (%lu).",
+					rewriter.token().length());
+				GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_COPY,start_time,byte_count,FALSE);
+				GCP_Client_Trace_Span_End("rewrite",destination_bucket_name,destination_object_name,
+							  &trace_start_time,byte_count,FALSE);
+				return FALSE;
+			}
+			strcpy(rewrite_token,rewriter.token().c_str());
+		}
+#if LOGGING > 5
+		GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COPY,LOG_VERBOSITY_VERY_VERBOSE,
+					     "GCP_Client_Rewrite(destination=%s/%s):Rewritten %llu of %llu bytes.",
+					     destination_bucket_name,destination_object_name,byte_count,
+					     (unsigned long long)progress->object_size);
+#endif
+		if(progress->done)
+			break;
+	} while(TRUE);
+	auto object_metadata = rewriter.Result();
+	if(!object_metadata)
+	{
+		Copy_Error_Number = 8;
+		snprintf(Copy_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Rewrite: Failed to get metadata of rewritten object '%s/%s' with status '%s'.",
+			 destination_bucket_name,destination_object_name,object_metadata.status().message().c_str());
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_COPY,start_time,byte_count,FALSE);
+		GCP_Client_Trace_Span_End("rewrite",destination_bucket_name,destination_object_name,
+					  &trace_start_time,byte_count,FALSE);
+		return FALSE;
+	}
+	if(rewrite_token != NULL)
+		rewrite_token[0] = '\0';
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_COPY,start_time,byte_count,TRUE);
+	GCP_Client_Trace_Span_End("rewrite",destination_bucket_name,destination_object_name,&trace_start_time,
+				  byte_count,TRUE);
+	if(metadata != NULL)
+		GCP_Client_List_Metadata_Copy(*object_metadata,metadata);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COPY,LOG_VERBOSITY_INTERMEDIATE,
+				      "GCP_Client_Rewrite(destination=%s/%s):Finished rewriting %llu bytes in %d calls.",
+				      destination_bucket_name,destination_object_name,byte_count,call_count);
+#endif
+	return TRUE;
+}
+
+/**
+ * Routine to perform a batch of server-side copies with GCP_Client_Rewrite, with up to concurrency copies in
+ * progress at once. Every copy in the batch is attempted, and the result of each is returned in it's
+ * request structure.
+ * @param request_list A list of request_count copy requests. The Success, Error_Number and Byte_Count fields of
+ *        each are filled in.
+ * @param request_count The number of copies in the batch.
+ * @param concurrency The maximum number of copies in progress at once.
+ *        If 0, GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY is used.
+ * @return The routine returns TRUE if every copy succeeded, and FALSE if one or more copies failed, or the batch
+ *         could not be run. If it fails, Copy_Error_Number / Copy_Error_String should contain details of the
+ *         (first) failure.
+ * @see #Copy_Batch_Struct
+ * @see #Copy_Batch_Item
+ * @see #Copy_Error_Number
+ * @see #Copy_Error_String
+ * @see gcp_client_batch.html#GCP_Client_Batch_Run
+ */
+int GCP_Client_Rewrite_Batch(struct GCP_Client_Copy_Request_Struct *request_list,int request_count,int concurrency)
+{
+	struct Copy_Batch_Struct batch;
+	char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+
+	Copy_Error_Number = 0;
+	if(request_list == NULL)
+	{
+		Copy_Error_Number = 9;
+		sprintf(Copy_Error_String,"GCP_Client_Rewrite_Batch: request_list was NULL.");
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COPY,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Rewrite_Batch:Started %d copies with concurrency %d.",
+					     request_count,concurrency);
+#endif
+	batch.Request_List = request_list;
+	pthread_mutex_init(&(batch.Mutex),NULL);
+	batch.Failed_Count = 0;
+	batch.Failed_Index = -1;
+	batch.Error_String[0] = '\0';
+	if(!GCP_Client_Batch_Run(request_count,concurrency,Copy_Batch_Item,&batch))
+	{
+		pthread_mutex_destroy(&(batch.Mutex));
+		error_string[0] = '\0';
+		GCP_Client_Batch_Error_String(error_string);
+		Copy_Error_Number = 10;
+		snprintf(Copy_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Rewrite_Batch: Failed to run batch:%s",error_string);
+		return FALSE;
+	}
+	pthread_mutex_destroy(&(batch.Mutex));
+	if(batch.Failed_Count > 0)
+	{
+		Copy_Error_Number = 11;
+		snprintf(Copy_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Rewrite_Batch: %d of %d copies failed, the first failure (copy %d) was:"
+			 "Error(%d) : %s",batch.Failed_Count,request_count,batch.Failed_Index,
+			 request_list[batch.Failed_Index].Error_Number,batch.Error_String);
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_COPY,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Rewrite_Batch:Finished %d copies.",request_count);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_copy error number.
+ * @return The current value of the gcp_client_copy error number.
+ * @see #Copy_Error_Number
+ */
+int GCP_Client_Copy_Get_Error_Number(void)
+{
+	return Copy_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Copy_Error_Number
+ * @see #Copy_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Copy_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Copy_Error_Number == 0)
+		sprintf(Copy_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Copy:Error(%d) : %s\n",time_string,Copy_Error_Number,Copy_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Copy_Error_Number
+ * @see #Copy_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Copy_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Copy_Error_Number == 0)
+		sprintf(Copy_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Copy:Error(%d) : %s\n",time_string,
+		Copy_Error_Number,Copy_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Check the source and destination arguments of a copy are not NULL.
+ * @param function_name The name of the calling function, for the error message.
+ * @param source_bucket_name The bucket to copy from.
+ * @param source_object_name The object to copy.
+ * @param destination_bucket_name The bucket to copy to.
+ * @param destination_object_name The name of the new object.
+ * @return The routine returns TRUE if the arguments are valid, and FALSE if they are not
+ *         (Copy_Error_Number / Copy_Error_String are set).
+ * @see #Copy_Error_Number
+ * @see #Copy_Error_String
+ */
+static int Copy_Check_Arguments(const char *function_name,char *source_bucket_name,char *source_object_name,
+				char *destination_bucket_name,char *destination_object_name)
+{
+	if(source_bucket_name == NULL)
+	{
+		Copy_Error_Number = 1;
+		sprintf(Copy_Error_String,"%s: source_bucket_name was NULL.",function_name);
+		return FALSE;
+	}
+	if(source_object_name == NULL)
+	{
+		Copy_Error_Number = 2;
+		sprintf(Copy_Error_String,"%s: source_object_name was NULL.",function_name);
+		return FALSE;
+	}
+	if(destination_bucket_name == NULL)
+	{
+		Copy_Error_Number = 3;
+		sprintf(Copy_Error_String,"%s: destination_bucket_name was NULL.",function_name);
+		return FALSE;
+	}
+	if(destination_object_name == NULL)
+	{
+		Copy_Error_Number = 4;
+		sprintf(Copy_Error_String,"%s: destination_object_name was NULL.",function_name);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Batch item function, called by the batch threads to perform one copy. The copy's result is put into
+ * it's request structure, and the first failure's error string is copied out of this thread's (thread local)
+ * error variables into the batch structure.
+ * @param index The index of the copy in the batch.
+ * @param user_data A pointer to the Copy_Batch_Struct.
+ * @see #Copy_Batch_Struct
+ * @see #GCP_Client_Rewrite
+ */
+static void Copy_Batch_Item(int index,void *user_data)
+{
+	struct Copy_Batch_Struct *batch = (struct Copy_Batch_Struct *)user_data;
+	struct GCP_Client_Copy_Request_Struct *request = &(batch->Request_List[index]);
+	struct GCP_Client_Object_Metadata_Struct metadata;
+
+	request->Success = GCP_Client_Rewrite(request->Source_Bucket_Name,request->Source_Object_Name,
+					      request->Destination_Bucket_Name,request->Destination_Object_Name,
+					      request->Storage_Class,NULL,&metadata);
+	if(request->Success)
+	{
+		request->Error_Number = 0;
+		request->Byte_Count = metadata.Size;
+		return;
+	}
+	request->Error_Number = Copy_Error_Number;
+	request->Byte_Count = 0;
+	pthread_mutex_lock(&(batch->Mutex));
+	batch->Failed_Count++;
+	if((batch->Failed_Index < 0)||(index < batch->Failed_Index))
+	{
+		batch->Failed_Index = index;
+		strncpy(batch->Error_String,Copy_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1);
+		batch->Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1] = '\0';
+	}
+	pthread_mutex_unlock(&(batch->Mutex));
+}
@@ -0,0 +1,762 @@
+/* gcp_client_delete.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Object delete routines.
+*/
+/**
+ * Google Cloud Platform object delete routines. Single objects can be deleted, as can batches of objects
+ * (on a bounded number of threads), and all the objects under a prefix (listing the prefix on one thread while
+ * the listed objects are deleted on others). Deletes can be made conditional on an object's generation, so an
+ * object that has been re-written since it was listed is not deleted, and the rate of deletes can be limited
+ * so a large clean up does not starve other users of the bucket.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include "google/cloud/storage/client.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_delete.h"
+#include "gcp_client_list.h"
+#include "gcp_client_stats.h"
+#include "gcp_client_trace.h"
+#include "gcp_client_connection_private.h"
+
+/* hash defines */
+/**
+ * The number of object names the prefix delete queue can hold, between the listing thread and the delete
+ * threads. Enough for the listing to get a page ahead of the deletes.
+ */
+#define DELETE_PREFIX_QUEUE_LENGTH                     (2*GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE)
+
+/* data types */
+/**
+ * Data type used to limit the rate deletes are started at, shared between the threads deleting.
+ * Each delete is given the next free start time slot, Interval after the previous one.
+ * This consists of the following:
+ * <dl>
+ * <dt>Mutex</dt> <dd>A mutex protecting Next_Time.</dd>
+ * <dt>Interval</dt> <dd>The minimum time between starting deletes, in seconds, or 0.0 for no rate limit.</dd>
+ * <dt>Next_Time</dt> <dd>The (CLOCK_MONOTONIC) time the next delete can be started.</dd>
+ * </dl>
+ */
+struct Delete_Rate_Struct
+{
+	pthread_mutex_t Mutex;
+	double Interval;
+	struct timespec Next_Time;
+};
+
+/**
+ * Data type holding the arguments and results of a batch delete, shared between the batch threads.
+ * This consists of the following:
+ * <dl>
+ * <dt>Bucket_Name</dt> <dd>The bucket containing the objects.</dd>
+ * <dt>Object_Name_List</dt> <dd>The list of object names to delete.</dd>
+ * <dt>Generation_List</dt> <dd>The list of generations the objects must have to be deleted, or NULL.</dd>
+ * <dt>Status_List</dt> <dd>The list of per-object delete statuses to fill in, or NULL.</dd>
+ * <dt>Rate</dt> <dd>The delete rate limiter.</dd>
+ * <dt>Mutex</dt> <dd>A mutex protecting the failure fields below.</dd>
+ * <dt>Failed_Count</dt> <dd>The number of objects that failed to delete (not counting those not found).</dd>
+ * <dt>Failed_Index</dt> <dd>The index of the first failed object, or -1.</dd>
+ * <dt>Error_Number</dt> <dd>The Delete_Error_Number of the first failed object.</dd>
+ * <dt>Error_String</dt> <dd>The Delete_Error_String of the first failed object.</dd>
+ * </dl>
+ * @see #Delete_Rate_Struct
+ */
+struct Delete_Batch_Struct
+{
+	char *Bucket_Name;
+	char **Object_Name_List;
+	long long *Generation_List;
+	unsigned char *Status_List;
+	struct Delete_Rate_Struct Rate;
+	pthread_mutex_t Mutex;
+	int Failed_Count;
+	int Failed_Index;
+	int Error_Number;
+	char Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+};
+
+/**
+ * Data type holding one object in the prefix delete queue.
+ * <dl>
+ * <dt>Name</dt> <dd>The object name.</dd>
+ * <dt>Generation</dt> <dd>The object's generation when it was listed.</dd>
+ * </dl>
+ */
+struct Delete_Queue_Entry_Struct
+{
+	char Name[GCP_CLIENT_LIST_NAME_LENGTH+1];
+	long long Generation;
+};
+
+/**
+ * Data type holding the state of a prefix delete, shared between the listing thread and the delete threads.
+ * The listing thread adds listed objects to a circular queue, which the delete threads remove them from.
+ * This consists of the following:
+ * <dl>
+ * <dt>Bucket_Name</dt> <dd>The bucket containing the objects.</dd>
+ * <dt>Prefix</dt> <dd>The prefix of the objects to delete.</dd>
+ * <dt>Rate</dt> <dd>The delete rate limiter.</dd>
+ * <dt>Mutex</dt> <dd>A mutex protecting the rest of the structure.</dd>
+ * <dt>Not_Empty_Condition</dt> <dd>Signalled when an entry is added to the queue, or the listing finishes.</dd>
+ * <dt>Not_Full_Condition</dt> <dd>Signalled when an entry is removed from the queue, or Stop is set.</dd>
+ * <dt>Queue</dt> <dd>The circular queue of DELETE_PREFIX_QUEUE_LENGTH objects to delete.</dd>
+ * <dt>Queue_Start</dt> <dd>The index in Queue of the next object to delete.</dd>
+ * <dt>Queue_Count</dt> <dd>The number of objects in Queue.</dd>
+ * <dt>Listing_Done</dt> <dd>A boolean, set when the listing thread has finished adding objects.</dd>
+ * <dt>Stop</dt> <dd>A boolean, set to make the listing thread stop (if the delete threads can't be run).</dd>
+ * <dt>List_Success</dt> <dd>A boolean, whether the listing succeeded.</dd>
+ * <dt>List_Error_String</dt> <dd>The list error string, if the listing failed.</dd>
+ * <dt>Deleted_Count</dt> <dd>The number of objects deleted.</dd>
+ * <dt>Failed_Count</dt> <dd>The number of objects that failed to delete (not counting those not found).</dd>
+ * <dt>Error_Number</dt> <dd>The Delete_Error_Number of the first failed delete.</dd>
+ * <dt>Error_String</dt> <dd>The Delete_Error_String of the first failed delete.</dd>
+ * </dl>
+ * @see #DELETE_PREFIX_QUEUE_LENGTH
+ * @see #Delete_Rate_Struct
+ * @see #Delete_Queue_Entry_Struct
+ */
+struct Delete_Prefix_Struct
+{
+	char *Bucket_Name;
+	char *Prefix;
+	struct Delete_Rate_Struct Rate;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Not_Empty_Condition;
+	pthread_cond_t Not_Full_Condition;
+	struct Delete_Queue_Entry_Struct *Queue;
+	int Queue_Start;
+	int Queue_Count;
+	int Listing_Done;
+	int Stop;
+	int List_Success;
+	char List_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+	unsigned long long Deleted_Count;
+	unsigned long long Failed_Count;
+	int Error_Number;
+	char Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread, as batches delete
+ * from several threads at once.
+ */
+static thread_local int Delete_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Delete_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static void Delete_Rate_Initialise(struct Delete_Rate_Struct *rate,double max_rate);
+static void Delete_Rate_Wait(struct Delete_Rate_Struct *rate);
+static void Delete_Batch_Item(int index,void *user_data);
+static void *Delete_Prefix_List_Thread(void *user_data);
+static int Delete_Prefix_List_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,
+				       int object_count,void *user_data);
+static void Delete_Prefix_Worker(int index,void *user_data);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Routine to delete an object (DeleteObject).
+ * @param bucket_name The name of the bucket.
+ * @param object_name The name of the object (filename) within the bucket.
+ * @param generation If greater than zero, the object is only deleted if it's live generation matches this
+ *        (an IfGenerationMatch precondition). Otherwise the object is deleted unconditionally.
+ * @param status The address of an integer to set to the delete status (GCP_CLIENT_DELETE_STATUS_DELETED,
+ *        GCP_CLIENT_DELETE_STATUS_NOT_FOUND, GCP_CLIENT_DELETE_STATUS_PRECONDITION_FAILED or
+ *        GCP_CLIENT_DELETE_STATUS_FAILED), or NULL.
+ * @return The routine returns TRUE if the object was deleted, and FALSE on failure (including the object
+ *         not existing). If it fails, Delete_Error_Number / Delete_Error_String should contain details
+ *         of the failure.
+ * @see #GCP_CLIENT_DELETE_STATUS_DELETED
+ * @see #GCP_CLIENT_DELETE_STATUS_NOT_FOUND
+ * @see #GCP_CLIENT_DELETE_STATUS_PRECONDITION_FAILED
+ * @see #GCP_CLIENT_DELETE_STATUS_FAILED
+ * @see #Delete_Error_Number
+ * @see #Delete_Error_String
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Delete(char *bucket_name,char *object_name,long long generation,int *status)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	struct timespec start_time,trace_start_time;
+
+	Delete_Error_Number = 0;
+	if(status != NULL)
+		(*status) = GCP_CLIENT_DELETE_STATUS_FAILED;
+	if(bucket_name == NULL)
+	{
+		Delete_Error_Number = 1;
+		sprintf(Delete_Error_String,"GCP_Client_Delete: bucket_name was NULL.");
+		return FALSE;
+	}
+	if(object_name == NULL)
+	{
+		Delete_Error_Number = 2;
+		sprintf(Delete_Error_String,"GCP_Client_Delete: object_name was NULL.");
+		return FALSE;
+	}
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_DELETE,LOG_VERBOSITY_VERY_VERBOSE,
+					     "GCP_Client_Delete(bucket=%s,object=%s,generation=%lld):Started.",
+					     bucket_name,object_name,generation);
+#endif
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	auto delete_status = client.DeleteObject(bucket_name,object_name,(generation > 0) ?
+						 gcs::IfGenerationMatch(generation) : gcs::IfGenerationMatch());
+	if(!delete_status.ok())
+	{
+		if(status != NULL)
+		{
+			if(delete_status.code() == ::google::cloud::StatusCode::kNotFound)
+				(*status) = GCP_CLIENT_DELETE_STATUS_NOT_FOUND;
+			else if(delete_status.code() == ::google::cloud::StatusCode::kFailedPrecondition)
+				(*status) = GCP_CLIENT_DELETE_STATUS_PRECONDITION_FAILED;
+		}
+		Delete_Error_Number = 3;
+		snprintf(Delete_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Delete: Failed to delete '%s' in bucket '%s' (generation %lld) with status '%s'.",
+			 object_name,bucket_name,generation,delete_status.message().c_str());
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_DELETE,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("delete",bucket_name,object_name,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	if(status != NULL)
+		(*status) = GCP_CLIENT_DELETE_STATUS_DELETED;
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_DELETE,start_time,0,TRUE);
+	GCP_Client_Trace_Span_End("delete",bucket_name,object_name,&trace_start_time,0,TRUE);
+	return TRUE;
+}
+
+/**
+ * Routine to delete a batch of objects, with up to concurrency deletes in progress at once. Every object in the
+ * batch is attempted, and the result of each is returned in status_list. Objects that do not exist are not
+ * counted as failures, as a clean up that is re-run (or overlaps another) will find objects already deleted.
+ * @param bucket_name The name of the bucket containing the objects.
+ * @param object_name_list A list of object_count object names.
+ * @param generation_list A list of object_count generations. Each object is only deleted if it's live generation
+ *        matches (a generation of 0 deletes unconditionally). Can be NULL, to delete all the objects
+ *        unconditionally.
+ * @param object_count The number of objects in the batch.
+ * @param concurrency The maximum number of deletes in progress at once.
+ *        If 0, GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY is used.
+ * @param max_rate The maximum number of deletes to start per second, or 0.0 for no limit.
+ * @param status_list A list of object_count bytes, filled in with each object's delete status
+ *        (GCP_CLIENT_DELETE_STATUS_DELETED etc). Can be NULL.
+ * @return The routine returns TRUE if every object was deleted (or did not exist), and FALSE if one or more
+ *         objects failed to delete, or the batch could not be run. If it fails, Delete_Error_Number /
+ *         Delete_Error_String should contain details of the (first) failure.
+ * @see #Delete_Batch_Struct
+ * @see #Delete_Batch_Item
+ * @see #Delete_Rate_Initialise
+ * @see #Delete_Error_Number
+ * @see #Delete_Error_String
+ * @see gcp_client_batch.html#GCP_Client_Batch_Run
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Delete_Batch(char *bucket_name,char **object_name_list,long long *generation_list,
+			    int object_count,int concurrency,double max_rate,unsigned char *status_list)
+{
+	struct Delete_Batch_Struct batch;
+	struct timespec trace_start_time;
+	char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+
+	Delete_Error_Number = 0;
+	if(bucket_name == NULL)
+	{
+		Delete_Error_Number = 4;
+		sprintf(Delete_Error_String,"GCP_Client_Delete_Batch: bucket_name was NULL.");
+		return FALSE;
+	}
+	if(object_name_list == NULL)
+	{
+		Delete_Error_Number = 5;
+		sprintf(Delete_Error_String,"GCP_Client_Delete_Batch: object_name_list was NULL.");
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_DELETE,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Delete_Batch(bucket=%s):Started deleting %d objects "
+					     "with concurrency %d and maximum rate %.1f/s.",bucket_name,object_count,
+					     concurrency,max_rate);
+#endif
+	batch.Bucket_Name = bucket_name;
+	batch.Object_Name_List = object_name_list;
+	batch.Generation_List = generation_list;
+	batch.Status_List = status_list;
+	Delete_Rate_Initialise(&(batch.Rate),max_rate);
+	pthread_mutex_init(&(batch.Mutex),NULL);
+	batch.Failed_Count = 0;
+	batch.Failed_Index = -1;
+	batch.Error_Number = 0;
+	batch.Error_String[0] = '\0';
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	if(!GCP_Client_Batch_Run(object_count,concurrency,Delete_Batch_Item,&batch))
+	{
+		pthread_mutex_destroy(&(batch.Mutex));
+		pthread_mutex_destroy(&(batch.Rate.Mutex));
+		error_string[0] = '\0';
+		GCP_Client_Batch_Error_String(error_string);
+		Delete_Error_Number = 6;
+		snprintf(Delete_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Delete_Batch: Failed to run batch:%s",error_string);
+		GCP_Client_Trace_Span_End("delete_batch",bucket_name,NULL,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	pthread_mutex_destroy(&(batch.Mutex));
+	pthread_mutex_destroy(&(batch.Rate.Mutex));
+	GCP_Client_Trace_Span_End("delete_batch",bucket_name,NULL,&trace_start_time,0,(batch.Failed_Count == 0));
+	if(batch.Failed_Count > 0)
+	{
+		Delete_Error_Number = 7;
+		snprintf(Delete_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Delete_Batch: Failed to delete %d of %d objects, "
+			 "the first failure (object %d) was:Error(%d) : %s",batch.Failed_Count,object_count,
+			 batch.Failed_Index,batch.Error_Number,batch.Error_String);
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_DELETE,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Delete_Batch(bucket=%s):Finished.",bucket_name);
+#endif
+	return TRUE;
+}
+
+/**
+ * Routine to delete all the objects whose names start with a prefix. The prefix is listed on a separate thread,
+ * while up to concurrency threads delete the objects already listed, so deleting starts with the first page of
+ * the listing rather than after the whole prefix has been listed. Each object is deleted with a precondition
+ * on the generation it was listed with, so an object re-written during the clean up is left alone (and counted
+ * as a failure). Objects that no longer exist when they are deleted are not counted as failures.
+ * @param bucket_name The name of the bucket containing the objects.
+ * @param prefix The prefix of the objects to delete. This must not be NULL or empty, deleting the whole
+ *        contents of a bucket by accident is too easy otherwise.
+ * @param concurrency The maximum number of deletes in progress at once.
+ *        If 0, GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY is used.
+ * @param max_rate The maximum number of deletes to start per second, or 0.0 for no limit.
+ * @param deleted_count The address of an unsigned long long to set to the number of objects deleted, or NULL.
+ * @param failed_count The address of an unsigned long long to set to the number of objects that failed to
+ *        delete, or NULL.
+ * @return The routine returns TRUE if every listed object was deleted (or no longer existed), and FALSE if
+ *         one or more objects failed to delete, or the listing failed. If it fails, Delete_Error_Number /
+ *         Delete_Error_String should contain details of the (first) failure.
+ * @see #DELETE_PREFIX_QUEUE_LENGTH
+ * @see #Delete_Prefix_Struct
+ * @see #Delete_Prefix_List_Thread
+ * @see #Delete_Prefix_Worker
+ * @see #Delete_Rate_Initialise
+ * @see #Delete_Error_Number
+ * @see #Delete_Error_String
+ * @see gcp_client_batch.html#GCP_Client_Batch_Run
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Delete_Prefix(char *bucket_name,char *prefix,int concurrency,double max_rate,
+			     unsigned long long *deleted_count,unsigned long long *failed_count)
+{
+	struct Delete_Prefix_Struct delete_prefix;
+	struct timespec trace_start_time;
+	pthread_t list_thread;
+	char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+	int retval,batch_retval;
+
+	Delete_Error_Number = 0;
+	if(deleted_count != NULL)
+		(*deleted_count) = 0;
+	if(failed_count != NULL)
+		(*failed_count) = 0;
+	if(bucket_name == NULL)
+	{
+		Delete_Error_Number = 8;
+		sprintf(Delete_Error_String,"GCP_Client_Delete_Prefix: bucket_name was NULL.");
+		return FALSE;
+	}
+	if((prefix == NULL)||(strlen(prefix) == 0))
+	{
+		Delete_Error_Number = 9;
+		sprintf(Delete_Error_String,"GCP_Client_Delete_Prefix: prefix was NULL or empty.");
+		return FALSE;
+	}
+	if(concurrency < 1)
+		concurrency = GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY;
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_DELETE,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Delete_Prefix(bucket=%s,prefix=%s):Started with concurrency %d "
+					     "and maximum rate %.1f/s.",bucket_name,prefix,concurrency,max_rate);
+#endif
+	delete_prefix.Queue = (struct Delete_Queue_Entry_Struct *)malloc(DELETE_PREFIX_QUEUE_LENGTH*
+									 sizeof(struct Delete_Queue_Entry_Struct));
+	if(delete_prefix.Queue == NULL)
+	{
+		Delete_Error_Number = 10;
+		sprintf(Delete_Error_String,"GCP_Client_Delete_Prefix: Failed to allocate queue of %d objects.",
+			DELETE_PREFIX_QUEUE_LENGTH);
+		return FALSE;
+	}
+	delete_prefix.Bucket_Name = bucket_name;
+	delete_prefix.Prefix = prefix;
+	Delete_Rate_Initialise(&(delete_prefix.Rate),max_rate);
+	pthread_mutex_init(&(delete_prefix.Mutex),NULL);
+	pthread_cond_init(&(delete_prefix.Not_Empty_Condition),NULL);
+	pthread_cond_init(&(delete_prefix.Not_Full_Condition),NULL);
+	delete_prefix.Queue_Start = 0;
+	delete_prefix.Queue_Count = 0;
+	delete_prefix.Listing_Done = FALSE;
+	delete_prefix.Stop = FALSE;
+	delete_prefix.List_Success = FALSE;
+	delete_prefix.List_Error_String[0] = '\0';
+	delete_prefix.Deleted_Count = 0;
+	delete_prefix.Failed_Count = 0;
+	delete_prefix.Error_Number = 0;
+	delete_prefix.Error_String[0] = '\0';
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	retval = pthread_create(&list_thread,NULL,Delete_Prefix_List_Thread,&delete_prefix);
+	if(retval != 0)
+	{
+		pthread_cond_destroy(&(delete_prefix.Not_Full_Condition));
+		pthread_cond_destroy(&(delete_prefix.Not_Empty_Condition));
+		pthread_mutex_destroy(&(delete_prefix.Mutex));
+		pthread_mutex_destroy(&(delete_prefix.Rate.Mutex));
+		free(delete_prefix.Queue);
+		Delete_Error_Number = 11;
+		sprintf(Delete_Error_String,"GCP_Client_Delete_Prefix: Failed to create listing thread (%d).",retval);
+		GCP_Client_Trace_Span_End("delete_prefix",bucket_name,prefix,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	/* each batch item is a delete thread, which deletes objects from the queue until the listing is done */
+	batch_retval = GCP_Client_Batch_Run(concurrency,concurrency,Delete_Prefix_Worker,&delete_prefix);
+	if(batch_retval == FALSE)
+	{
+		error_string[0] = '\0';
+		GCP_Client_Batch_Error_String(error_string);
+		/* stop the listing thread, it may be waiting for the (full) queue to empty */
+		pthread_mutex_lock(&(delete_prefix.Mutex));
+		delete_prefix.Stop = TRUE;
+		pthread_cond_broadcast(&(delete_prefix.Not_Full_Condition));
+		pthread_mutex_unlock(&(delete_prefix.Mutex));
+	}
+	pthread_join(list_thread,NULL);
+	pthread_cond_destroy(&(delete_prefix.Not_Full_Condition));
+	pthread_cond_destroy(&(delete_prefix.Not_Empty_Condition));
+	pthread_mutex_destroy(&(delete_prefix.Mutex));
+	pthread_mutex_destroy(&(delete_prefix.Rate.Mutex));
+	free(delete_prefix.Queue);
+	if(deleted_count != NULL)
+		(*deleted_count) = delete_prefix.Deleted_Count;
+	if(failed_count != NULL)
+		(*failed_count) = delete_prefix.Failed_Count;
+	if(batch_retval == FALSE)
+	{
+		Delete_Error_Number = 12;
+		snprintf(Delete_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Delete_Prefix: Failed to run delete threads:%s",error_string);
+		GCP_Client_Trace_Span_End("delete_prefix",bucket_name,prefix,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	GCP_Client_Trace_Span_End("delete_prefix",bucket_name,prefix,&trace_start_time,0,
+				  delete_prefix.List_Success&&(delete_prefix.Failed_Count == 0));
+	if(!delete_prefix.List_Success)
+	{
+		Delete_Error_Number = 13;
+		snprintf(Delete_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Delete_Prefix: Failed to list prefix '%s' in bucket '%s' "
+			 "(after deleting %llu objects):%s",prefix,bucket_name,delete_prefix.Deleted_Count,
+			 delete_prefix.List_Error_String);
+		return FALSE;
+	}
+	if(delete_prefix.Failed_Count > 0)
+	{
+		Delete_Error_Number = 14;
+		snprintf(Delete_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Delete_Prefix: Failed to delete %llu objects (%llu deleted), "
+			 "the first failure was:Error(%d) : %s",delete_prefix.Failed_Count,delete_prefix.Deleted_Count,
+			 delete_prefix.Error_Number,delete_prefix.Error_String);
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_DELETE,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Delete_Prefix(bucket=%s,prefix=%s):Finished, deleted %llu objects.",
+					     bucket_name,prefix,delete_prefix.Deleted_Count);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_delete error number.
+ * @return The current value of the gcp_client_delete error number.
+ * @see #Delete_Error_Number
+ */
+int GCP_Client_Delete_Get_Error_Number(void)
+{
+	return Delete_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Delete_Error_Number
+ * @see #Delete_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Delete_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Delete_Error_Number == 0)
+		sprintf(Delete_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Delete:Error(%d) : %s\n",time_string,Delete_Error_Number,Delete_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Delete_Error_Number
+ * @see #Delete_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Delete_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Delete_Error_Number == 0)
+		sprintf(Delete_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Delete:Error(%d) : %s\n",time_string,
+		Delete_Error_Number,Delete_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Initialise a delete rate limiter.
+ * @param rate The rate limiter to initialise.
+ * @param max_rate The maximum number of deletes to start per second, or 0.0 (or less) for no limit.
+ * @see #Delete_Rate_Struct
+ */
+static void Delete_Rate_Initialise(struct Delete_Rate_Struct *rate,double max_rate)
+{
+	pthread_mutex_init(&(rate->Mutex),NULL);
+	if(max_rate > 0.0)
+		rate->Interval = 1.0/max_rate;
+	else
+		rate->Interval = 0.0;
+	clock_gettime(CLOCK_MONOTONIC,&(rate->Next_Time));
+}
+
+/**
+ * Wait until this thread is allowed to start a delete. The thread takes the next free start time slot
+ * (or now, if that has passed), moves the next slot on by Interval, and sleeps until it's slot.
+ * @param rate The rate limiter.
+ * @see #Delete_Rate_Struct
+ */
+static void Delete_Rate_Wait(struct Delete_Rate_Struct *rate)
+{
+	struct timespec current_time,slot_time;
+	long long next_time_ns;
+
+	if(rate->Interval <= 0.0)
+		return;
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	pthread_mutex_lock(&(rate->Mutex));
+	if(fdifftime(rate->Next_Time,current_time) < 0.0)
+		rate->Next_Time = current_time;
+	slot_time = rate->Next_Time;
+	next_time_ns = (((long long)rate->Next_Time.tv_sec)*GCP_CLIENT_GENERAL_ONE_SECOND_NS)+
+		rate->Next_Time.tv_nsec+(long long)(rate->Interval*((double)GCP_CLIENT_GENERAL_ONE_SECOND_NS));
+	rate->Next_Time.tv_sec = next_time_ns/GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+	rate->Next_Time.tv_nsec = next_time_ns%GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+	pthread_mutex_unlock(&(rate->Mutex));
+	while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&slot_time,NULL) == EINTR)
+		;
+}
+
+/**
+ * Batch item function, called by the batch threads to delete one object. The delete status is put into the
+ * status list, and the first failure's error is copied out of this thread's (thread local) error variables
+ * into the batch structure.
+ * @param index The index of the object in the batch.
+ * @param user_data A pointer to the Delete_Batch_Struct.
+ * @see #Delete_Batch_Struct
+ * @see #Delete_Rate_Wait
+ * @see #GCP_Client_Delete
+ */
+static void Delete_Batch_Item(int index,void *user_data)
+{
+	struct Delete_Batch_Struct *batch = (struct Delete_Batch_Struct *)user_data;
+	long long generation;
+	int status;
+
+	if(batch->Generation_List != NULL)
+		generation = batch->Generation_List[index];
+	else
+		generation = 0;
+	Delete_Rate_Wait(&(batch->Rate));
+	GCP_Client_Delete(batch->Bucket_Name,batch->Object_Name_List[index],generation,&status);
+	if(batch->Status_List != NULL)
+		batch->Status_List[index] = (unsigned char)status;
+	if((status == GCP_CLIENT_DELETE_STATUS_DELETED)||(status == GCP_CLIENT_DELETE_STATUS_NOT_FOUND))
+		return;
+	pthread_mutex_lock(&(batch->Mutex));
+	batch->Failed_Count++;
+	if((batch->Failed_Index < 0)||(index < batch->Failed_Index))
+	{
+		batch->Failed_Index = index;
+		batch->Error_Number = Delete_Error_Number;
+		strncpy(batch->Error_String,Delete_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1);
+		batch->Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1] = '\0';
+	}
+	pthread_mutex_unlock(&(batch->Mutex));
+}
+
+/**
+ * Prefix delete listing thread. Lists the prefix with GCP_Client_List, adding each listed object to the queue
+ * (Delete_Prefix_List_Callback). When the listing finishes, the list result is saved, Listing_Done is set,
+ * and the delete threads are woken up.
+ * @param user_data A pointer to the Delete_Prefix_Struct.
+ * @return The routine returns NULL.
+ * @see #Delete_Prefix_Struct
+ * @see #Delete_Prefix_List_Callback
+ * @see gcp_client_list.html#GCP_Client_List
+ * @see gcp_client_list.html#GCP_Client_List_Error_String
+ */
+static void *Delete_Prefix_List_Thread(void *user_data)
+{
+	struct Delete_Prefix_Struct *delete_prefix = (struct Delete_Prefix_Struct *)user_data;
+	int retval;
+
+	retval = GCP_Client_List(delete_prefix->Bucket_Name,delete_prefix->Prefix,NULL,NULL,NULL,0,
+				 Delete_Prefix_List_Callback,delete_prefix);
+	pthread_mutex_lock(&(delete_prefix->Mutex));
+	delete_prefix->List_Success = retval;
+	if(retval == FALSE)
+		GCP_Client_List_Error_String(delete_prefix->List_Error_String);
+	delete_prefix->Listing_Done = TRUE;
+	pthread_cond_broadcast(&(delete_prefix->Not_Empty_Condition));
+	pthread_mutex_unlock(&(delete_prefix->Mutex));
+	return NULL;
+}
+
+/**
+ * Listing callback, called with each page of listed objects. Each object is added to the queue, waiting for
+ * the delete threads to make space in it if it is full.
+ * @param object_list The page of listed objects.
+ * @param object_count The number of objects in the page.
+ * @param user_data A pointer to the Delete_Prefix_Struct.
+ * @return The routine returns TRUE to continue listing, or FALSE if Stop has been set.
+ * @see #DELETE_PREFIX_QUEUE_LENGTH
+ * @see #Delete_Prefix_Struct
+ */
+static int Delete_Prefix_List_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,
+				       int object_count,void *user_data)
+{
+	struct Delete_Prefix_Struct *delete_prefix = (struct Delete_Prefix_Struct *)user_data;
+	struct Delete_Queue_Entry_Struct *entry = NULL;
+	int i;
+
+	pthread_mutex_lock(&(delete_prefix->Mutex));
+	for(i = 0; i < object_count; i++)
+	{
+		if(object_list[i].Is_Prefix)
+			continue;
+		while((delete_prefix->Queue_Count == DELETE_PREFIX_QUEUE_LENGTH)&&(delete_prefix->Stop == FALSE))
+			pthread_cond_wait(&(delete_prefix->Not_Full_Condition),&(delete_prefix->Mutex));
+		if(delete_prefix->Stop)
+		{
+			pthread_mutex_unlock(&(delete_prefix->Mutex));
+			return FALSE;
+		}
+		entry = &(delete_prefix->Queue[(delete_prefix->Queue_Start+delete_prefix->Queue_Count)%
+					       DELETE_PREFIX_QUEUE_LENGTH]);
+		strcpy(entry->Name,object_list[i].Name);
+		entry->Generation = object_list[i].Generation;
+		delete_prefix->Queue_Count++;
+		pthread_cond_signal(&(delete_prefix->Not_Empty_Condition));
+	}
+	pthread_mutex_unlock(&(delete_prefix->Mutex));
+	return TRUE;
+}
+
+/**
+ * Prefix delete thread, run as a batch item. Takes objects off the queue and deletes them (with a precondition
+ * on their listed generation) until the queue is empty and the listing is done. The first failure's error is
+ * copied out of this thread's (thread local) error variables into the prefix delete structure.
+ * @param index The index of the delete thread (unused).
+ * @param user_data A pointer to the Delete_Prefix_Struct.
+ * @see #Delete_Prefix_Struct
+ * @see #Delete_Rate_Wait
+ * @see #GCP_Client_Delete
+ */
+static void Delete_Prefix_Worker(int index,void *user_data)
+{
+	struct Delete_Prefix_Struct *delete_prefix = (struct Delete_Prefix_Struct *)user_data;
+	struct Delete_Queue_Entry_Struct entry;
+	int status;
+
+	(void)index;
+	while(TRUE)
+	{
+		pthread_mutex_lock(&(delete_prefix->Mutex));
+		while((delete_prefix->Queue_Count == 0)&&(delete_prefix->Listing_Done == FALSE))
+			pthread_cond_wait(&(delete_prefix->Not_Empty_Condition),&(delete_prefix->Mutex));
+		if(delete_prefix->Queue_Count == 0)
+		{
+			pthread_mutex_unlock(&(delete_prefix->Mutex));
+			return;
+		}
+		entry = delete_prefix->Queue[delete_prefix->Queue_Start];
+		delete_prefix->Queue_Start = (delete_prefix->Queue_Start+1)%DELETE_PREFIX_QUEUE_LENGTH;
+		delete_prefix->Queue_Count--;
+		pthread_cond_signal(&(delete_prefix->Not_Full_Condition));
+		pthread_mutex_unlock(&(delete_prefix->Mutex));
+		Delete_Rate_Wait(&(delete_prefix->Rate));
+		GCP_Client_Delete(delete_prefix->Bucket_Name,entry.Name,entry.Generation,&status);
+		pthread_mutex_lock(&(delete_prefix->Mutex));
+		if(status == GCP_CLIENT_DELETE_STATUS_DELETED)
+			delete_prefix->Deleted_Count++;
+		else if(status != GCP_CLIENT_DELETE_STATUS_NOT_FOUND)
+		{
+			if(delete_prefix->Failed_Count == 0)
+			{
+				delete_prefix->Error_Number = Delete_Error_Number;
+				strncpy(delete_prefix->Error_String,Delete_Error_String,
+					GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1);
+				delete_prefix->Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1] = '\0';
+			}
+			delete_prefix->Failed_Count++;
+		}
+		pthread_mutex_unlock(&(delete_prefix->Mutex));
+	}
+}
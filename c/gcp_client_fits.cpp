@@ -0,0 +1,851 @@
+/* gcp_client_fits.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** FITS header indexing and query routines.
+*/
+/**
+ * Routines indexing the FITS primary header of uploaded frames, so frames can be found by their header keywords
+ * (for instance OBJECT=M31 and EXPTIME>60) with listing and metadata calls only, without downloading them.
+ * <p>
+ * When indexing is enabled (GCP_Client_Fits_Index_Set), uploads made with GCP_Client_Read_Write_Write (and the
+ * routines built on it), GCP_Client_Sync and GCP_Client_Sync_Upload_File parse the primary header of data that
+ * starts with a FITS SIMPLE card, in memory, with cfitsio. The selected keywords are attached to the object as
+ * custom metadata, under GCP_CLIENT_FITS_METADATA_PREFIX followed by the keyword in lower case. Data that is not
+ * FITS, or whose header can't be parsed, is uploaded without an index.
+ * <p>
+ * GCP_Client_Fits_Query lists the objects under a prefix, and calls back with those whose indexed keywords match
+ * all the conditions. The listing returns each object's custom metadata, so no further requests are made.
+ * <p>
+ * The header parsing needs the library to be built with CFITSIO defined (see c/Makefile). Without it, indexing
+ * can't be enabled, but objects indexed by another build can still be queried.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include "google/cloud/storage/client.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#ifdef CFITSIO
+#include "fitsio.h"
+#endif
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_fits.h"
+#include "gcp_client_list.h"
+#include "gcp_client_stats.h"
+#include "gcp_client_trace.h"
+#include "gcp_client_connection_private.h"
+#include "gcp_client_fits_private.h"
+#include "gcp_client_list_private.h"
+
+/* hash defines */
+/**
+ * The length of a FITS header block, in bytes. A FITS file is at least one block long.
+ */
+#define FITS_BLOCK_LENGTH              (2880)
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Fits_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Fits_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+/**
+ * Mutex protecting Fits_Index_Enable and Fits_Keyword_List.
+ */
+static pthread_mutex_t Fits_Index_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * A boolean, TRUE if uploads of FITS data are indexed.
+ */
+static int Fits_Index_Enable = FALSE;
+/**
+ * The keywords indexed, in upper case. Initialised from GCP_CLIENT_FITS_DEFAULT_KEYWORD_LIST.
+ * @see #GCP_CLIENT_FITS_DEFAULT_KEYWORD_LIST
+ */
+static std::vector<std::string> Fits_Keyword_List = {"OBJECT","EXPTIME","DATE-OBS","MJD","INSTRUME","FILTER1",
+						     "RA","DEC"};
+#ifdef CFITSIO
+/**
+ * Mutex serialising calls into cfitsio, which is not thread safe unless it was built re-entrant. Headers are
+ * small, so uploads don't wait on each other for long.
+ */
+static pthread_mutex_t Fits_Cfitsio_Mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* internal functions */
+static int Fits_Keyword_List_Parse(const char *function_name,const char *string,
+				   std::vector<std::string> &keyword_list);
+static int Fits_Parse(const void *data,size_t length,std::vector<std::string> const &name_list,
+		      struct GCP_Client_Fits_Keyword_Struct *keyword_list,int max_count,int *keyword_count);
+static int Fits_Metadata_Keywords(std::map<std::string,std::string> const &metadata,
+				  struct GCP_Client_Fits_Keyword_Struct *keyword_list,int max_count);
+static int Fits_Condition_Match(struct GCP_Client_Fits_Condition_Struct *condition,
+				const struct GCP_Client_Fits_Keyword_Struct *keyword_list,int keyword_count);
+static int Fits_Compare(const char *value,const char *condition_value);
+static int Fits_Is_Number(const char *string,double *number);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Turn indexing of uploaded FITS data on or off, and set the keywords indexed. This is process wide.
+ * @param enable A boolean, TRUE to index uploads of FITS data, FALSE to stop.
+ * @param keyword_list A comma separated list of header keywords to index, for instance "OBJECT,EXPTIME".
+ *        Case is ignored. If NULL, the keywords are left as they are (GCP_CLIENT_FITS_DEFAULT_KEYWORD_LIST
+ *        unless they have been set).
+ * @return The routine returns TRUE on success, and FALSE on failure (including enabling indexing in a library
+ *         built without CFITSIO).
+ * @see #GCP_CLIENT_FITS_DEFAULT_KEYWORD_LIST
+ * @see #Fits_Index_Enable
+ * @see #Fits_Keyword_List
+ * @see #Fits_Keyword_List_Parse
+ */
+int GCP_Client_Fits_Index_Set(int enable,const char *keyword_list)
+{
+	std::vector<std::string> new_keyword_list;
+
+	Fits_Error_Number = 0;
+#ifndef CFITSIO
+	if(enable)
+	{
+		Fits_Error_Number = 1;
+		sprintf(Fits_Error_String,"GCP_Client_Fits_Index_Set:The library was built without CFITSIO.");
+		return FALSE;
+	}
+#endif
+	if(keyword_list != NULL)
+	{
+		if(!Fits_Keyword_List_Parse("GCP_Client_Fits_Index_Set",keyword_list,new_keyword_list))
+			return FALSE;
+	}
+	pthread_mutex_lock(&Fits_Index_Mutex);
+	Fits_Index_Enable = enable;
+	if(keyword_list != NULL)
+		Fits_Keyword_List = new_keyword_list;
+	pthread_mutex_unlock(&Fits_Index_Mutex);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_FITS,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Fits_Index_Set:FITS indexing %s%s%s.",
+					     enable ? "enabled" : "disabled",(keyword_list != NULL) ? " for " : "",
+					     (keyword_list != NULL) ? keyword_list : "");
+#endif
+	return TRUE;
+}
+
+/**
+ * Get whether uploaded FITS data is indexed, and the keywords indexed.
+ * @param enable The address of an integer to set to TRUE if indexing is enabled, and FALSE if it is not. Can be
+ *        NULL.
+ * @param keyword_list A string to fill in with the comma separated list of keywords indexed. Can be NULL.
+ * @param keyword_list_length The length of keyword_list, including the terminating NUL.
+ * @return The routine returns TRUE on success, and FALSE on failure (the keyword list being too long for
+ *         keyword_list).
+ * @see #Fits_Index_Enable
+ * @see #Fits_Keyword_List
+ */
+int GCP_Client_Fits_Index_Get(int *enable,char *keyword_list,size_t keyword_list_length)
+{
+	std::string keyword_list_string;
+
+	Fits_Error_Number = 0;
+	pthread_mutex_lock(&Fits_Index_Mutex);
+	if(enable != NULL)
+		(*enable) = Fits_Index_Enable;
+	for(auto &keyword : Fits_Keyword_List)
+	{
+		if(keyword_list_string.empty() == FALSE)
+			keyword_list_string += ",";
+		keyword_list_string += keyword;
+	}
+	pthread_mutex_unlock(&Fits_Index_Mutex);
+	if(keyword_list != NULL)
+	{
+		if(keyword_list_string.length() >= keyword_list_length)
+		{
+			Fits_Error_Number = 2;
+			sprintf(Fits_Error_String,"GCP_Client_Fits_Index_Get:keyword_list_length %lu is too short "
+				"for '%s'.",(unsigned long)keyword_list_length,keyword_list_string.c_str());
+			return FALSE;
+		}
+		strcpy(keyword_list,keyword_list_string.c_str());
+	}
+	return TRUE;
+}
+
+/**
+ * Parse the primary header of FITS data in memory, and return the values of the keywords being indexed
+ * (GCP_Client_Fits_Index_Set) that it contains. Only the header is read, so the data can be just the start of a
+ * file, as long as it holds the whole primary header.
+ * @param data The FITS data.
+ * @param length The number of bytes of data.
+ * @param keyword_list A list of max_count keyword structures, to fill in with the keywords found, in the order
+ *        they are indexed.
+ * @param max_count The number of keyword structures in keyword_list.
+ * @param keyword_count The address of an integer to set to the number of keywords found.
+ * @return The routine returns TRUE on success, and FALSE on failure (including the data not being FITS, and the
+ *         library being built without CFITSIO).
+ * @see #Fits_Parse
+ * @see #Fits_Keyword_List
+ */
+int GCP_Client_Fits_Header_Parse(const void *data,size_t length,
+				 struct GCP_Client_Fits_Keyword_Struct *keyword_list,int max_count,
+				 int *keyword_count)
+{
+	std::vector<std::string> name_list;
+
+	Fits_Error_Number = 0;
+	if(data == NULL)
+	{
+		Fits_Error_Number = 3;
+		sprintf(Fits_Error_String,"GCP_Client_Fits_Header_Parse:data was NULL.");
+		return FALSE;
+	}
+	if((keyword_list == NULL)||(keyword_count == NULL))
+	{
+		Fits_Error_Number = 4;
+		sprintf(Fits_Error_String,"GCP_Client_Fits_Header_Parse:keyword_list or keyword_count was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&Fits_Index_Mutex);
+	name_list = Fits_Keyword_List;
+	pthread_mutex_unlock(&Fits_Index_Mutex);
+	return Fits_Parse(data,length,name_list,keyword_list,max_count,keyword_count);
+}
+
+/**
+ * Get the indexed keywords of an object, from it's custom metadata (one GetObjectMetadata request).
+ * @param bucket_name The name of the bucket.
+ * @param object_name The name of the object.
+ * @param keyword_list A list of max_count keyword structures, to fill in with the object's indexed keywords.
+ * @param max_count The number of keyword structures in keyword_list.
+ * @param keyword_count The address of an integer to set to the number of keywords returned (0 if the object has
+ *        not been indexed).
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Fits_Metadata_Keywords
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Fits_Get_Keywords(char *bucket_name,char *object_name,
+				 struct GCP_Client_Fits_Keyword_Struct *keyword_list,int max_count,
+				 int *keyword_count)
+{
+	::google::cloud::storage::Client client;
+	struct timespec start_time,trace_start_time;
+
+	Fits_Error_Number = 0;
+	if((bucket_name == NULL)||(object_name == NULL))
+	{
+		Fits_Error_Number = 5;
+		sprintf(Fits_Error_String,"GCP_Client_Fits_Get_Keywords:bucket_name or object_name was NULL.");
+		return FALSE;
+	}
+	if((keyword_list == NULL)||(keyword_count == NULL))
+	{
+		Fits_Error_Number = 6;
+		sprintf(Fits_Error_String,"GCP_Client_Fits_Get_Keywords:keyword_list or keyword_count was NULL.");
+		return FALSE;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	auto object_metadata = client.GetObjectMetadata(bucket_name,object_name);
+	if(!object_metadata)
+	{
+		Fits_Error_Number = 7;
+		snprintf(Fits_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Fits_Get_Keywords:Failed to get metadata of '%s' in '%s' with status '%s'.",
+			 object_name,bucket_name,object_metadata.status().message().c_str());
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_METADATA,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("stat",bucket_name,object_name,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	(*keyword_count) = Fits_Metadata_Keywords(object_metadata->metadata(),keyword_list,max_count);
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_METADATA,start_time,0,TRUE);
+	GCP_Client_Trace_Span_End("stat",bucket_name,object_name,&trace_start_time,0,TRUE);
+	return TRUE;
+}
+
+/**
+ * Parse a query string into a list of conditions. The string is a comma separated list of conditions, each a
+ * keyword, an operator (=, !=, <, <=, > or >=) and a value, for instance "OBJECT=M31,EXPTIME>60". Spaces around
+ * the keyword and value are ignored.
+ * @param string The query string.
+ * @param condition_list A list of max_count condition structures, to fill in.
+ * @param max_count The number of condition structures in condition_list.
+ * @param condition_count The address of an integer to set to the number of conditions parsed.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Fits_Condition_Struct
+ */
+int GCP_Client_Fits_Condition_Parse(const char *string,struct GCP_Client_Fits_Condition_Struct *condition_list,
+				    int max_count,int *condition_count)
+{
+	struct GCP_Client_Fits_Condition_Struct *condition = NULL;
+	std::string condition_string,keyword,value;
+	size_t start,end,operator_start,operator_length;
+
+	Fits_Error_Number = 0;
+	if((string == NULL)||(condition_list == NULL)||(condition_count == NULL))
+	{
+		Fits_Error_Number = 8;
+		sprintf(Fits_Error_String,
+			"GCP_Client_Fits_Condition_Parse:string, condition_list or condition_count was NULL.");
+		return FALSE;
+	}
+	(*condition_count) = 0;
+	start = 0;
+	while(start <= strlen(string))
+	{
+		end = strcspn(string+start,",")+start;
+		condition_string = std::string(string+start,end-start);
+		start = end+1;
+		if(condition_string.find_first_not_of(" ") == std::string::npos)
+			continue;
+		if((*condition_count) >= max_count)
+		{
+			Fits_Error_Number = 9;
+			sprintf(Fits_Error_String,"GCP_Client_Fits_Condition_Parse:Too many conditions (%d).",max_count);
+			return FALSE;
+		}
+		condition = &(condition_list[(*condition_count)]);
+		operator_start = condition_string.find_first_of("=!<>");
+		if(operator_start == std::string::npos)
+		{
+			Fits_Error_Number = 10;
+			snprintf(Fits_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Fits_Condition_Parse:No operator in condition '%s'.",condition_string.c_str());
+			return FALSE;
+		}
+		operator_length = 1;
+		if(condition_string.compare(operator_start,2,"!=") == 0)
+		{
+			condition->Operator = GCP_CLIENT_FITS_OPERATOR_NE;
+			operator_length = 2;
+		}
+		else if(condition_string.compare(operator_start,2,"<=") == 0)
+		{
+			condition->Operator = GCP_CLIENT_FITS_OPERATOR_LE;
+			operator_length = 2;
+		}
+		else if(condition_string.compare(operator_start,2,">=") == 0)
+		{
+			condition->Operator = GCP_CLIENT_FITS_OPERATOR_GE;
+			operator_length = 2;
+		}
+		else if(condition_string[operator_start] == '=')
+			condition->Operator = GCP_CLIENT_FITS_OPERATOR_EQ;
+		else if(condition_string[operator_start] == '<')
+			condition->Operator = GCP_CLIENT_FITS_OPERATOR_LT;
+		else if(condition_string[operator_start] == '>')
+			condition->Operator = GCP_CLIENT_FITS_OPERATOR_GT;
+		else
+		{
+			Fits_Error_Number = 11;
+			snprintf(Fits_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Fits_Condition_Parse:Illegal operator in condition '%s'.",
+				 condition_string.c_str());
+			return FALSE;
+		}
+		keyword = condition_string.substr(0,operator_start);
+		value = condition_string.substr(operator_start+operator_length);
+		keyword.erase(0,keyword.find_first_not_of(" "));
+		keyword.erase(keyword.find_last_not_of(" ")+1);
+		value.erase(0,value.find_first_not_of(" "));
+		value.erase(value.find_last_not_of(" ")+1);
+		if((keyword.length() == 0)||(keyword.length() >= GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH)||
+		   (value.length() >= GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH))
+		{
+			Fits_Error_Number = 12;
+			snprintf(Fits_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Fits_Condition_Parse:Illegal keyword or value length in condition '%s'.",
+				 condition_string.c_str());
+			return FALSE;
+		}
+		strcpy(condition->Keyword,keyword.c_str());
+		strcpy(condition->Value,value.c_str());
+		(*condition_count)++;
+	}
+	return TRUE;
+}
+
+/**
+ * Find the indexed objects under a prefix whose keywords match all of a list of conditions. The objects are
+ * listed (a page of up to GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE objects per request), and their indexed keywords
+ * read from the custom metadata returned by the listing, so the frames are not downloaded. An object that has not
+ * been indexed, or lacks a keyword a condition is on, does not match.
+ * @param bucket_name The name of the bucket.
+ * @param prefix Only query objects whose names start with this prefix. Can be NULL to query the whole bucket.
+ * @param condition_list The list of conditions, or NULL if condition_count is 0.
+ * @param condition_count The number of conditions (0 to GCP_CLIENT_FITS_MAX_CONDITION_COUNT). If 0, every
+ *        indexed object matches.
+ * @param callback The function to call with each matching object.
+ * @param user_data A pointer passed unaltered to each call of the callback.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_CLIENT_FITS_MAX_CONDITION_COUNT
+ * @see #Fits_Metadata_Keywords
+ * @see #Fits_Condition_Match
+ * @see gcp_client_list.html#GCP_Client_List_Metadata_Copy
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Fits_Query(char *bucket_name,char *prefix,
+			  struct GCP_Client_Fits_Condition_Struct *condition_list,int condition_count,
+			  GCP_Client_Fits_Query_Callback_T callback,void *user_data)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	gcs::Prefix prefix_option;
+	struct GCP_Client_Object_Metadata_Struct object;
+	struct GCP_Client_Fits_Keyword_Struct keyword_list[GCP_CLIENT_FITS_MAX_KEYWORD_COUNT];
+	struct timespec start_time,trace_start_time;
+	unsigned long long object_count,match_count;
+	int i,keyword_count,match;
+
+	Fits_Error_Number = 0;
+	if(bucket_name == NULL)
+	{
+		Fits_Error_Number = 13;
+		sprintf(Fits_Error_String,"GCP_Client_Fits_Query:bucket_name was NULL.");
+		return FALSE;
+	}
+	if((condition_count < 0)||(condition_count > GCP_CLIENT_FITS_MAX_CONDITION_COUNT)||
+	   ((condition_count > 0)&&(condition_list == NULL)))
+	{
+		Fits_Error_Number = 14;
+		sprintf(Fits_Error_String,"GCP_Client_Fits_Query:Illegal condition count %d (0..%d), "
+			"or condition_list was NULL.",condition_count,GCP_CLIENT_FITS_MAX_CONDITION_COUNT);
+		return FALSE;
+	}
+	if(callback == NULL)
+	{
+		Fits_Error_Number = 15;
+		sprintf(Fits_Error_String,"GCP_Client_Fits_Query:callback was NULL.");
+		return FALSE;
+	}
+	/* an unset prefix option is default constructed, and is not sent to the server */
+	if(prefix != NULL)
+		prefix_option = gcs::Prefix(prefix);
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	object_count = 0;
+	match_count = 0;
+	for(auto&& object_metadata : client.ListObjects(bucket_name,prefix_option,
+							gcs::MaxResults(GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE)))
+	{
+		if(!object_metadata)
+		{
+			Fits_Error_Number = 16;
+			snprintf(Fits_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Fits_Query:Failed to list bucket '%s' with status '%s'.",bucket_name,
+				 object_metadata.status().message().c_str());
+			GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_LIST,start_time,0,FALSE);
+			GCP_Client_Trace_Span_End("fits_query",bucket_name,prefix,&trace_start_time,0,FALSE);
+			return FALSE;
+		}
+		object_count++;
+		keyword_count = Fits_Metadata_Keywords(object_metadata->metadata(),keyword_list,
+						       GCP_CLIENT_FITS_MAX_KEYWORD_COUNT);
+		if(keyword_count == 0)
+			continue;
+		match = TRUE;
+		for(i = 0; (i < condition_count)&&match; i++)
+			match = Fits_Condition_Match(&(condition_list[i]),keyword_list,keyword_count);
+		if(match == FALSE)
+			continue;
+		match_count++;
+		GCP_Client_List_Metadata_Copy(*object_metadata,&object);
+		if(callback(&object,keyword_list,keyword_count,user_data) == FALSE)
+			break;
+	}
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_LIST,start_time,0,TRUE);
+	GCP_Client_Trace_Span_End("fits_query",bucket_name,prefix,&trace_start_time,0,TRUE);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_FITS,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Fits_Query(bucket=%s,prefix=%s):%llu of %llu objects matched.",
+					     bucket_name,(prefix != NULL) ? prefix : "NULL",match_count,object_count);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the current value of the fits module's error number.
+ * @return The current value of the fits module's error number.
+ * @see #Fits_Error_Number
+ */
+int GCP_Client_Fits_Get_Error_Number(void)
+{
+	return Fits_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Fits_Error_Number
+ * @see #Fits_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Fits_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Fits_Error_Number == 0)
+		sprintf(Fits_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Fits:Error(%d) : %s\n",time_string,Fits_Error_Number,Fits_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Fits_Error_Number
+ * @see #Fits_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Fits_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Fits_Error_Number == 0)
+		sprintf(Fits_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Fits:Error(%d) : %s\n",time_string,
+		Fits_Error_Number,Fits_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal C++ Functions (exported via gcp_client_fits_private.h)
+** -------------------------------------------------------- */
+/**
+ * Called by the upload routines before an upload is opened. If indexing is enabled and the data starts with a
+ * FITS primary header, the indexed keywords found in it are added to the object metadata the upload is opened
+ * with, as custom metadata. A header that can't be parsed is logged, and the upload carries on without an index
+ * (the fits module's error is cleared, as the upload has not failed).
+ * @param data The data being uploaded (or at least it's start, holding the whole primary header).
+ * @param length The number of bytes of data.
+ * @param object_metadata The object metadata to add the keywords to.
+ * @return The number of keywords added (0 if indexing is disabled, or the data is not FITS).
+ * @see #GCP_CLIENT_FITS_METADATA_PREFIX
+ * @see #Fits_Index_Enable
+ * @see #Fits_Parse
+ */
+int GCP_Client_Fits_Index_Metadata(const void *data,size_t length,
+				   ::google::cloud::storage::ObjectMetadata &object_metadata)
+{
+	struct GCP_Client_Fits_Keyword_Struct keyword_list[GCP_CLIENT_FITS_MAX_KEYWORD_COUNT];
+	std::vector<std::string> name_list;
+	std::string key;
+	int i,enable,keyword_count;
+
+	pthread_mutex_lock(&Fits_Index_Mutex);
+	enable = Fits_Index_Enable;
+	if(enable)
+		name_list = Fits_Keyword_List;
+	pthread_mutex_unlock(&Fits_Index_Mutex);
+	/* data that is not FITS is uploaded as is, without logging */
+	if((enable == FALSE)||(data == NULL)||(length < FITS_BLOCK_LENGTH)||
+	   (strncmp((const char*)data,"SIMPLE  =",9) != 0))
+		return 0;
+	if(!Fits_Parse(data,length,name_list,keyword_list,GCP_CLIENT_FITS_MAX_KEYWORD_COUNT,&keyword_count))
+	{
+#if LOGGING > 1
+		GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_FITS,LOG_VERBOSITY_INTERMEDIATE,
+						     "GCP_Client_Fits_Index_Metadata:Not indexing upload:%s",
+						     Fits_Error_String);
+#endif
+		Fits_Error_Number = 0;
+		return 0;
+	}
+	for(i = 0; i < keyword_count; i++)
+	{
+		key = GCP_CLIENT_FITS_METADATA_PREFIX;
+		for(char *ch = keyword_list[i].Name; (*ch) != '\0'; ch++)
+			key += (char)tolower((int)(*ch));
+		object_metadata.upsert_metadata(key,keyword_list[i].Value);
+	}
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_FITS,LOG_VERBOSITY_VERY_VERBOSE,
+					     "GCP_Client_Fits_Index_Metadata:Indexed %d keywords.",keyword_count);
+#endif
+	return keyword_count;
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Parse a comma separated list of keywords. The keywords are trimmed of spaces and converted to upper case.
+ * @param function_name The name of the calling routine, used in error messages.
+ * @param string The list, for instance "OBJECT,EXPTIME".
+ * @param keyword_list A vector to fill in with the keywords.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_CLIENT_FITS_MAX_KEYWORD_COUNT
+ * @see #GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH
+ */
+static int Fits_Keyword_List_Parse(const char *function_name,const char *string,
+				   std::vector<std::string> &keyword_list)
+{
+	std::string keyword;
+	size_t start,end;
+
+	keyword_list.clear();
+	start = 0;
+	while(start <= strlen(string))
+	{
+		end = strcspn(string+start,",")+start;
+		keyword.clear();
+		for(size_t i = start; i < end; i++)
+		{
+			if(string[i] != ' ')
+				keyword += (char)toupper((int)(string[i]));
+		}
+		start = end+1;
+		if(keyword.length() == 0)
+			continue;
+		if(keyword.length() >= GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH)
+		{
+			Fits_Error_Number = 17;
+			snprintf(Fits_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,"%s:Keyword '%s' is too long.",
+				 function_name,keyword.c_str());
+			return FALSE;
+		}
+		if(keyword_list.size() >= GCP_CLIENT_FITS_MAX_KEYWORD_COUNT)
+		{
+			Fits_Error_Number = 18;
+			sprintf(Fits_Error_String,"%s:Too many keywords (%d).",function_name,
+				GCP_CLIENT_FITS_MAX_KEYWORD_COUNT);
+			return FALSE;
+		}
+		keyword_list.push_back(keyword);
+	}
+	return TRUE;
+}
+
+/**
+ * Parse the primary header of FITS data in memory with cfitsio (fits_open_memfile), and read the value of each
+ * named keyword (as a string) that is present.
+ * @param data The FITS data.
+ * @param length The number of bytes of data.
+ * @param name_list The names of the keywords to read.
+ * @param keyword_list A list of max_count keyword structures, to fill in with the keywords found.
+ * @param max_count The number of keyword structures in keyword_list.
+ * @param keyword_count The address of an integer to set to the number of keywords found.
+ * @return The routine returns TRUE on success, and FALSE on failure (Fits_Error_Number / Fits_Error_String
+ *         are set).
+ * @see #FITS_BLOCK_LENGTH
+ * @see #Fits_Cfitsio_Mutex
+ */
+static int Fits_Parse(const void *data,size_t length,std::vector<std::string> const &name_list,
+		      struct GCP_Client_Fits_Keyword_Struct *keyword_list,int max_count,int *keyword_count)
+{
+#ifdef CFITSIO
+	fitsfile *fits_fp = NULL;
+	void *memory_ptr = NULL;
+	size_t memory_length;
+	char value[FLEN_VALUE];
+	char cfitsio_error_string[FLEN_STATUS];
+	int status = 0;
+
+	(*keyword_count) = 0;
+	if((length < FITS_BLOCK_LENGTH)||(strncmp((const char*)data,"SIMPLE  =",9) != 0))
+	{
+		Fits_Error_Number = 19;
+		sprintf(Fits_Error_String,"Fits_Parse:Data of %lu bytes does not start with a FITS primary header.",
+			(unsigned long)length);
+		return FALSE;
+	}
+	/* cfitsio only reads from the memory, as it is opened READONLY */
+	memory_ptr = (void *)data;
+	memory_length = length;
+	pthread_mutex_lock(&Fits_Cfitsio_Mutex);
+	fits_open_memfile(&fits_fp,"gcp_client_fits",READONLY,&memory_ptr,&memory_length,0,NULL,&status);
+	if(status)
+	{
+		pthread_mutex_unlock(&Fits_Cfitsio_Mutex);
+		fits_get_errstatus(status,cfitsio_error_string);
+		Fits_Error_Number = 20;
+		sprintf(Fits_Error_String,"Fits_Parse:Failed to open FITS data in memory (%d:%s).",status,
+			cfitsio_error_string);
+		return FALSE;
+	}
+	for(auto &name : name_list)
+	{
+		if((*keyword_count) >= max_count)
+			break;
+		fits_read_key(fits_fp,TSTRING,(char *)name.c_str(),value,NULL,&status);
+		if(status == KEY_NO_EXIST)
+		{
+			status = 0;
+			continue;
+		}
+		if(status)
+		{
+			fits_get_errstatus(status,cfitsio_error_string);
+			status = 0;
+			fits_close_file(fits_fp,&status);
+			pthread_mutex_unlock(&Fits_Cfitsio_Mutex);
+			Fits_Error_Number = 21;
+			sprintf(Fits_Error_String,"Fits_Parse:Failed to read keyword '%s' (%s).",name.c_str(),
+				cfitsio_error_string);
+			return FALSE;
+		}
+		strncpy(keyword_list[(*keyword_count)].Name,name.c_str(),GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH-1);
+		keyword_list[(*keyword_count)].Name[GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH-1] = '\0';
+		strncpy(keyword_list[(*keyword_count)].Value,value,GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH-1);
+		keyword_list[(*keyword_count)].Value[GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH-1] = '\0';
+		(*keyword_count)++;
+	}
+	fits_close_file(fits_fp,&status);
+	pthread_mutex_unlock(&Fits_Cfitsio_Mutex);
+	return TRUE;
+#else
+	(*keyword_count) = 0;
+	Fits_Error_Number = 22;
+	sprintf(Fits_Error_String,"Fits_Parse:The library was built without CFITSIO.");
+	return FALSE;
+#endif
+}
+
+/**
+ * Extract the indexed keywords from an object's custom metadata: the entries whose keys start with
+ * GCP_CLIENT_FITS_METADATA_PREFIX. The keyword names are returned in upper case.
+ * @param metadata The object's custom metadata.
+ * @param keyword_list A list of max_count keyword structures, to fill in.
+ * @param max_count The number of keyword structures in keyword_list.
+ * @return The number of keywords returned.
+ * @see #GCP_CLIENT_FITS_METADATA_PREFIX
+ */
+static int Fits_Metadata_Keywords(std::map<std::string,std::string> const &metadata,
+				  struct GCP_Client_Fits_Keyword_Struct *keyword_list,int max_count)
+{
+	size_t prefix_length = strlen(GCP_CLIENT_FITS_METADATA_PREFIX);
+	int i,keyword_count;
+
+	keyword_count = 0;
+	/* the map is sorted, so the prefixed keys are together */
+	for(auto it = metadata.lower_bound(GCP_CLIENT_FITS_METADATA_PREFIX); it != metadata.end(); it++)
+	{
+		if((keyword_count >= max_count)||(it->first.compare(0,prefix_length,GCP_CLIENT_FITS_METADATA_PREFIX) != 0))
+			break;
+		strncpy(keyword_list[keyword_count].Name,it->first.c_str()+prefix_length,
+			GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH-1);
+		keyword_list[keyword_count].Name[GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH-1] = '\0';
+		for(i = 0; keyword_list[keyword_count].Name[i] != '\0'; i++)
+			keyword_list[keyword_count].Name[i] = toupper((int)(keyword_list[keyword_count].Name[i]));
+		strncpy(keyword_list[keyword_count].Value,it->second.c_str(),GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH-1);
+		keyword_list[keyword_count].Value[GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH-1] = '\0';
+		keyword_count++;
+	}
+	return keyword_count;
+}
+
+/**
+ * Test whether a list of keywords matches a condition.
+ * @param condition The condition.
+ * @param keyword_list The keywords.
+ * @param keyword_count The number of keywords.
+ * @return TRUE if the condition's keyword is in the list, and it's value satisfies the condition, otherwise FALSE.
+ * @see #Fits_Compare
+ */
+static int Fits_Condition_Match(struct GCP_Client_Fits_Condition_Struct *condition,
+				const struct GCP_Client_Fits_Keyword_Struct *keyword_list,int keyword_count)
+{
+	int i,compare;
+
+	for(i = 0; i < keyword_count; i++)
+	{
+		if(strcasecmp(keyword_list[i].Name,condition->Keyword) != 0)
+			continue;
+		compare = Fits_Compare(keyword_list[i].Value,condition->Value);
+		switch(condition->Operator)
+		{
+			case GCP_CLIENT_FITS_OPERATOR_EQ:
+				return (compare == 0);
+			case GCP_CLIENT_FITS_OPERATOR_NE:
+				return (compare != 0);
+			case GCP_CLIENT_FITS_OPERATOR_LT:
+				return (compare < 0);
+			case GCP_CLIENT_FITS_OPERATOR_LE:
+				return (compare <= 0);
+			case GCP_CLIENT_FITS_OPERATOR_GT:
+				return (compare > 0);
+			case GCP_CLIENT_FITS_OPERATOR_GE:
+				return (compare >= 0);
+			default:
+				return FALSE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * Compare a keyword value with a condition value: numerically if both are numbers, otherwise as strings.
+ * @param value The keyword value.
+ * @param condition_value The condition value.
+ * @return Less than, equal to, or greater than zero, as value is less than, equal to, or greater than
+ *         condition_value.
+ * @see #Fits_Is_Number
+ */
+static int Fits_Compare(const char *value,const char *condition_value)
+{
+	double number,condition_number;
+
+	if(Fits_Is_Number(value,&number)&&Fits_Is_Number(condition_value,&condition_number))
+	{
+		if(number < condition_number)
+			return -1;
+		if(number > condition_number)
+			return 1;
+		return 0;
+	}
+	return strcmp(value,condition_value);
+}
+
+/**
+ * Test whether a string is a number (as written in a FITS header, which may use a D exponent).
+ * @param string The string.
+ * @param number The address of a double to set to the number.
+ * @return TRUE if the whole string (apart from surrounding spaces) is a number, otherwise FALSE.
+ */
+static int Fits_Is_Number(const char *string,double *number)
+{
+	char number_string[GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH];
+	char *end_ptr = NULL;
+	int i;
+
+	strncpy(number_string,string,GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH-1);
+	number_string[GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH-1] = '\0';
+	for(i = 0; number_string[i] != '\0'; i++)
+	{
+		if((number_string[i] == 'D')||(number_string[i] == 'd'))
+			number_string[i] = 'E';
+	}
+	(*number) = strtod(number_string,&end_ptr);
+	if(end_ptr == number_string)
+		return FALSE;
+	while((*end_ptr) == ' ')
+		end_ptr++;
+	return ((*end_ptr) == '\0');
+}
@@ -22,15 +22,55 @@
 #include <time.h>
 #include <stdarg.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <atomic>
+#include <new>
 #include "gcp_client_general.h"
 #include "gcp_client_connection.h"
+#include "gcp_client_log_udp.h"
 #include "gcp_client_read_write.h"
+#include "gcp_client_stats.h"
+#include "gcp_client_trace.h"
+#include "gcp_client_list.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_metadata.h"
+#include "gcp_client_manifest.h"
+#include "gcp_client_copy.h"
+#include "gcp_client_delete.h"
+#include "gcp_client_sync.h"
+#include "gcp_client_buffer.h"
+#include "gcp_client_budget.h"
+#include "gcp_client_adaptive.h"
+#include "gcp_client_operation.h"
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_scheduler.h"
+#include "gcp_client_completions.h"
+#include "gcp_client_fits.h"
 
 /* defines */
 /**
  * How long some buffers are when generating logging messages.
  */
 #define LOG_BUFF_LENGTH           (4096)
+/**
+ * The maximum length of a message held in an asynchronous log record. Longer messages are truncated.
+ */
+#define LOG_ASYNC_MESSAGE_LENGTH  (1024)
+/**
+ * The default number of records in the asynchronous log ring buffer. Must be a power of two.
+ */
+#define LOG_ASYNC_DEFAULT_RECORD_COUNT (1024)
+/**
+ * How long (in milliseconds) the asynchronous log thread is given to flush queued records,
+ * when the program exits with asynchronous logging still running.
+ */
+#define LOG_ASYNC_EXIT_FLUSH_TIMEOUT_MS (1000)
+/**
+ * How long (in milliseconds) the asynchronous log thread sleeps waiting for new records, 
+ * before re-checking whether it has been asked to stop.
+ */
+#define LOG_ASYNC_WAIT_MS         (100)
 
 /* data types */
 /**
@@ -43,17 +83,86 @@
  * 		This is set using GCP_Client_General_Set_Log_Filter_Level.
  * 		GCP_Client_General_Log_Filter_Level_Absolute and GCP_Client_General_Log_Filter_Level_Bitwise 
  *              test it against message levels to determine whether to log messages.</dd>
+ * <dt>Module_Log_Level_List</dt> <dd>A per-module log level, indexed by GCP_CLIENT_GENERAL_LOG_MODULE_*.
+ * 		Messages logged by a module with a level greater than the module's level are discarded before
+ * 		they are formatted. This is set at runtime using GCP_Client_General_Set_Module_Log_Level.</dd>
  * </dl>
+ * Log_Filter_Level and Module_Log_Level_List are atomic, as they can be changed at runtime by one thread
+ * whilst being tested by others.
  * @see #GCP_Client_General_Log
  * @see #GCP_Client_General_Set_Log_Filter_Level
  * @see #GCP_Client_General_Log_Filter_Level_Absolute
  * @see #GCP_Client_General_Log_Filter_Level_Bitwise
+ * @see #GCP_Client_General_Set_Module_Log_Level
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
  */
 struct General_Struct
 {
 	void (*Log_Handler)(int level,const char *string);
 	int (*Log_Filter)(int level,const char *string);
-	int Log_Filter_Level;
+	std::atomic<int> Log_Filter_Level;
+	std::atomic<int> Module_Log_Level_List[GCP_CLIENT_GENERAL_LOG_MODULE_COUNT];
+};
+
+/**
+ * Data type holding one queued asynchronous log record. This consists of the following:
+ * <dl>
+ * <dt>Sequence</dt> <dd>The ring buffer sequence number of this slot. The slot is free for a producer to
+ *     claim when it equals the enqueue position, and holds a published record when it equals 
+ *     the dequeue position plus one.</dd>
+ * <dt>Level</dt> <dd>The log level of the message.</dd>
+ * <dt>Timestamp</dt> <dd>When the message was logged (CLOCK_REALTIME).</dd>
+ * <dt>Message</dt> <dd>The formatted message.</dd>
+ * </dl>
+ * @see #LOG_ASYNC_MESSAGE_LENGTH
+ */
+struct Log_Async_Record_Struct
+{
+	std::atomic<unsigned long> Sequence;
+	int Level;
+	struct timespec Timestamp;
+	char Message[LOG_ASYNC_MESSAGE_LENGTH];
+};
+
+/**
+ * Data type holding the state of the asynchronous logging pipeline. Log records are placed into a lock-free,
+ * multi-producer, single-consumer ring buffer by the logging threads, and a background thread removes them and
+ * passes them to the configured log filter and handler. This consists of the following:
+ * <dl>
+ * <dt>Enabled</dt> <dd>Whether new log messages are put into the ring buffer (TRUE) or logged synchronously (FALSE).</dd>
+ * <dt>In_Flight_Count</dt> <dd>The number of producers currently in the process of queueing a record.</dd>
+ * <dt>Stop</dt> <dd>Set to TRUE to ask the background thread to flush the ring buffer and exit.</dd>
+ * <dt>Record_List</dt> <dd>The ring buffer of records.</dd>
+ * <dt>Record_Mask</dt> <dd>The number of records in Record_List minus one, used to wrap positions.</dd>
+ * <dt>Enqueue_Position</dt> <dd>The next position a producer will claim.</dd>
+ * <dt>Dequeue_Position</dt> <dd>The next position the background thread will read (only used by that thread).</dd>
+ * <dt>Thread</dt> <dd>The background thread id.</dd>
+ * <dt>Semaphore</dt> <dd>Posted by producers to wake the background thread.</dd>
+ * <dt>Flush_Deadline</dt> <dd>When stopping, the time by which the background thread must have finished 
+ *     flushing records.</dd>
+ * <dt>Logged_Count</dt> <dd>The number of records passed to the log handler by the background thread.</dd>
+ * <dt>Dropped_Count</dt> <dd>The number of records discarded, because the ring buffer was full, or because
+ *     they were still queued when the flush deadline expired.</dd>
+ * <dt>Exit_Handler_Installed</dt> <dd>Whether Log_Async_Exit_Handler has been registered with atexit.</dd>
+ * </dl>
+ * @see #Log_Async_Record_Struct
+ * @see #Log_Async_Exit_Handler
+ */
+struct Log_Async_Struct
+{
+	std::atomic<int> Enabled;
+	std::atomic<int> In_Flight_Count;
+	std::atomic<int> Stop;
+	struct Log_Async_Record_Struct *Record_List;
+	unsigned long Record_Mask;
+	std::atomic<unsigned long> Enqueue_Position;
+	unsigned long Dequeue_Position;
+	pthread_t Thread;
+	sem_t Semaphore;
+	struct timespec Flush_Deadline;
+	std::atomic<unsigned long long> Logged_Count;
+	std::atomic<unsigned long long> Dropped_Count;
+	int Exit_Handler_Installed;
 };
 
 /* internal variables */
@@ -68,12 +177,32 @@ static char rcsid[] = "$Id$";
  * <dt>Log_Handler</dt> <dd>NULL</dd>
  * <dt>Log_Filter</dt> <dd>NULL</dd>
  * <dt>Log_Filter_Level</dt> <dd>0</dd>
+ * <dt>Module_Log_Level_List</dt> <dd>GCP_CLIENT_GENERAL_LOG_LEVEL_ALL for every module.</dd>
  * </dl>
  * @see #General_Struct
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_LOG_LEVEL_ALL
  */
 static struct General_Struct General_Data = 
 {
 	NULL,NULL,0,
+	{
+		GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,
+		GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,
+		GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,
+		GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,
+		GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,
+		GCP_CLIENT_GENERAL_LOG_LEVEL_ALL,GCP_CLIENT_GENERAL_LOG_LEVEL_ALL
+	}
+};
+/**
+ * The names of the modules, indexed by GCP_CLIENT_GENERAL_LOG_MODULE_*, as used by 
+ * GCP_Client_General_Set_Module_Log_Levels.
+ * @see #GCP_Client_General_Set_Module_Log_Levels
+ */
+static const char *General_Log_Module_Name_List[GCP_CLIENT_GENERAL_LOG_MODULE_COUNT] = 
+{
+	"general","connection","read_write","list","metadata","manifest","copy","delete","sync","buffer","budget",
+	"adaptive","operation","bandwidth","scheduler","completions","fits"
 };
 
 /**
@@ -85,6 +214,28 @@ static int General_Error_Number = 0;
  * @see #GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
  */
 static char General_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+/**
+ * The instance of Log_Async_Struct that contains the asynchronous logging state. 
+ * Being static, it is zero initialised i.e. asynchronous logging is disabled.
+ * @see #Log_Async_Struct
+ */
+static struct Log_Async_Struct Log_Async_Data;
+/**
+ * Per-thread pointer to the timestamp of the log record currently being passed to the log handler
+ * by the asynchronous log thread. NULL when the handler is being called synchronously.
+ * @see #GCP_Client_General_Get_Log_Time_String
+ */
+static thread_local struct timespec *Log_Async_Current_Timestamp = NULL;
+
+/* internal functions */
+static void General_Time_To_String(struct timespec *timestamp,char *time_string,int string_length);
+static int General_Log_Filter_Before_Format(int module,int level);
+static void General_Log_VFormat(int level,const char *format,va_list ap);
+static void General_Log_Dispatch(int level,const char *string);
+static int Log_Async_Enqueue(int level,const char *format,va_list ap);
+static int Log_Async_Enqueue_Format(int level,const char *format,...);
+static void *Log_Async_Thread(void *arg);
+static void Log_Async_Exit_Handler(void);
 
 /* --------------------------------------------------------
 ** External Functions
@@ -95,6 +246,24 @@ static char General_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
  * @see #General_Error_Number
  * @see gcp_client_connection.html#GCP_Client_Connection_Get_Error_Number
  * @see gcp_client_read_write.html#GCP_Client_Read_Write_Get_Error_Number
+ * @see gcp_client_log_udp.html#GCP_Client_Log_UDP_Get_Error_Number
+ * @see gcp_client_stats.html#GCP_Client_Stats_Get_Error_Number
+ * @see gcp_client_trace.html#GCP_Client_Trace_Get_Error_Number
+ * @see gcp_client_list.html#GCP_Client_List_Get_Error_Number
+ * @see gcp_client_batch.html#GCP_Client_Batch_Get_Error_Number
+ * @see gcp_client_metadata.html#GCP_Client_Metadata_Get_Error_Number
+ * @see gcp_client_manifest.html#GCP_Client_Manifest_Get_Error_Number
+ * @see gcp_client_copy.html#GCP_Client_Copy_Get_Error_Number
+ * @see gcp_client_delete.html#GCP_Client_Delete_Get_Error_Number
+ * @see gcp_client_sync.html#GCP_Client_Sync_Get_Error_Number
+ * @see gcp_client_buffer.html#GCP_Client_Buffer_Get_Error_Number
+ * @see gcp_client_budget.html#GCP_Client_Budget_Get_Error_Number
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get_Error_Number
+ * @see gcp_client_operation.html#GCP_Client_Operation_Get_Error_Number
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Get_Error_Number
+ * @see gcp_client_scheduler.html#GCP_Client_Scheduler_Get_Error_Number
+ * @see gcp_client_completions.html#GCP_Client_Completions_Get_Error_Number
+ * @see gcp_client_fits.html#GCP_Client_Fits_Get_Error_Number
  */
 int GCP_Client_General_Is_Error(void)
 {
@@ -106,6 +275,42 @@ int GCP_Client_General_Is_Error(void)
 		found = TRUE;
 	if(GCP_Client_Read_Write_Get_Error_Number() != 0)
 		found = TRUE;
+	if(GCP_Client_Log_UDP_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Stats_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Trace_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_List_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Batch_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Metadata_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Manifest_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Copy_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Delete_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Sync_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Buffer_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Budget_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Adaptive_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Operation_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Bandwidth_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Scheduler_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Completions_Get_Error_Number() != 0)
+		found = TRUE;
+	if(GCP_Client_Fits_Get_Error_Number() != 0)
+		found = TRUE;
 	return found;
 }
 
@@ -118,6 +323,42 @@ int GCP_Client_General_Is_Error(void)
  * @see gcp_client_connection.html#GCP_Client_Connection_Error
  * @see gcp_client_read_write.html#GCP_Read_Write_Connection_Get_Error_Number
  * @see gcp_client_read_write.html#GCP_Read_Write_Connection_Error
+ * @see gcp_client_log_udp.html#GCP_Client_Log_UDP_Get_Error_Number
+ * @see gcp_client_log_udp.html#GCP_Client_Log_UDP_Error
+ * @see gcp_client_stats.html#GCP_Client_Stats_Get_Error_Number
+ * @see gcp_client_stats.html#GCP_Client_Stats_Error
+ * @see gcp_client_trace.html#GCP_Client_Trace_Get_Error_Number
+ * @see gcp_client_trace.html#GCP_Client_Trace_Error
+ * @see gcp_client_list.html#GCP_Client_List_Get_Error_Number
+ * @see gcp_client_list.html#GCP_Client_List_Error
+ * @see gcp_client_batch.html#GCP_Client_Batch_Get_Error_Number
+ * @see gcp_client_batch.html#GCP_Client_Batch_Error
+ * @see gcp_client_metadata.html#GCP_Client_Metadata_Get_Error_Number
+ * @see gcp_client_metadata.html#GCP_Client_Metadata_Error
+ * @see gcp_client_manifest.html#GCP_Client_Manifest_Get_Error_Number
+ * @see gcp_client_manifest.html#GCP_Client_Manifest_Error
+ * @see gcp_client_copy.html#GCP_Client_Copy_Get_Error_Number
+ * @see gcp_client_copy.html#GCP_Client_Copy_Error
+ * @see gcp_client_delete.html#GCP_Client_Delete_Get_Error_Number
+ * @see gcp_client_delete.html#GCP_Client_Delete_Error
+ * @see gcp_client_sync.html#GCP_Client_Sync_Get_Error_Number
+ * @see gcp_client_sync.html#GCP_Client_Sync_Error
+ * @see gcp_client_buffer.html#GCP_Client_Buffer_Get_Error_Number
+ * @see gcp_client_buffer.html#GCP_Client_Buffer_Error
+ * @see gcp_client_budget.html#GCP_Client_Budget_Get_Error_Number
+ * @see gcp_client_budget.html#GCP_Client_Budget_Error
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get_Error_Number
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Error
+ * @see gcp_client_operation.html#GCP_Client_Operation_Get_Error_Number
+ * @see gcp_client_operation.html#GCP_Client_Operation_Error
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Get_Error_Number
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Error
+ * @see gcp_client_scheduler.html#GCP_Client_Scheduler_Get_Error_Number
+ * @see gcp_client_scheduler.html#GCP_Client_Scheduler_Error
+ * @see gcp_client_completions.html#GCP_Client_Completions_Get_Error_Number
+ * @see gcp_client_completions.html#GCP_Client_Completions_Error
+ * @see gcp_client_fits.html#GCP_Client_Fits_Get_Error_Number
+ * @see gcp_client_fits.html#GCP_Client_Fits_Error
  */
 void GCP_Client_General_Error(void)
 {
@@ -134,6 +375,96 @@ void GCP_Client_General_Error(void)
 		found = TRUE;
 		GCP_Client_Read_Write_Error();
 	}
+	if(GCP_Client_Log_UDP_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Log_UDP_Error();
+	}
+	if(GCP_Client_Stats_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Stats_Error();
+	}
+	if(GCP_Client_Trace_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Trace_Error();
+	}
+	if(GCP_Client_List_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_List_Error();
+	}
+	if(GCP_Client_Batch_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Batch_Error();
+	}
+	if(GCP_Client_Metadata_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Metadata_Error();
+	}
+	if(GCP_Client_Manifest_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Manifest_Error();
+	}
+	if(GCP_Client_Copy_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Copy_Error();
+	}
+	if(GCP_Client_Delete_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Delete_Error();
+	}
+	if(GCP_Client_Sync_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Sync_Error();
+	}
+	if(GCP_Client_Buffer_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Buffer_Error();
+	}
+	if(GCP_Client_Budget_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Budget_Error();
+	}
+	if(GCP_Client_Adaptive_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Adaptive_Error();
+	}
+	if(GCP_Client_Operation_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Operation_Error();
+	}
+	if(GCP_Client_Bandwidth_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Bandwidth_Error();
+	}
+	if(GCP_Client_Scheduler_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Scheduler_Error();
+	}
+	if(GCP_Client_Completions_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Completions_Error();
+	}
+	if(GCP_Client_Fits_Get_Error_Number() != 0)
+	{
+		found = TRUE;
+		GCP_Client_Fits_Error();
+	}
 	if(General_Error_Number != 0)
 	{
 		found = TRUE;
@@ -159,6 +490,42 @@ void GCP_Client_General_Error(void)
  * @see gcp_client_connection.html#GCP_Client_Connection_Error_String
  * @see gcp_client_read_write.html#GCP_Client_Read_Write_Get_Error_Number
  * @see gcp_client_read_write.html#GCP_Client_Read_Write_Error_String
+ * @see gcp_client_log_udp.html#GCP_Client_Log_UDP_Get_Error_Number
+ * @see gcp_client_log_udp.html#GCP_Client_Log_UDP_Error_String
+ * @see gcp_client_stats.html#GCP_Client_Stats_Get_Error_Number
+ * @see gcp_client_stats.html#GCP_Client_Stats_Error_String
+ * @see gcp_client_trace.html#GCP_Client_Trace_Get_Error_Number
+ * @see gcp_client_trace.html#GCP_Client_Trace_Error_String
+ * @see gcp_client_list.html#GCP_Client_List_Get_Error_Number
+ * @see gcp_client_list.html#GCP_Client_List_Error_String
+ * @see gcp_client_batch.html#GCP_Client_Batch_Get_Error_Number
+ * @see gcp_client_batch.html#GCP_Client_Batch_Error_String
+ * @see gcp_client_metadata.html#GCP_Client_Metadata_Get_Error_Number
+ * @see gcp_client_metadata.html#GCP_Client_Metadata_Error_String
+ * @see gcp_client_manifest.html#GCP_Client_Manifest_Get_Error_Number
+ * @see gcp_client_manifest.html#GCP_Client_Manifest_Error_String
+ * @see gcp_client_copy.html#GCP_Client_Copy_Get_Error_Number
+ * @see gcp_client_copy.html#GCP_Client_Copy_Error_String
+ * @see gcp_client_delete.html#GCP_Client_Delete_Get_Error_Number
+ * @see gcp_client_delete.html#GCP_Client_Delete_Error_String
+ * @see gcp_client_sync.html#GCP_Client_Sync_Get_Error_Number
+ * @see gcp_client_sync.html#GCP_Client_Sync_Error_String
+ * @see gcp_client_buffer.html#GCP_Client_Buffer_Get_Error_Number
+ * @see gcp_client_buffer.html#GCP_Client_Buffer_Error_String
+ * @see gcp_client_budget.html#GCP_Client_Budget_Get_Error_Number
+ * @see gcp_client_budget.html#GCP_Client_Budget_Error_String
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get_Error_Number
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Error_String
+ * @see gcp_client_operation.html#GCP_Client_Operation_Get_Error_Number
+ * @see gcp_client_operation.html#GCP_Client_Operation_Error_String
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Get_Error_Number
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Error_String
+ * @see gcp_client_scheduler.html#GCP_Client_Scheduler_Get_Error_Number
+ * @see gcp_client_scheduler.html#GCP_Client_Scheduler_Error_String
+ * @see gcp_client_completions.html#GCP_Client_Completions_Get_Error_Number
+ * @see gcp_client_completions.html#GCP_Client_Completions_Error_String
+ * @see gcp_client_fits.html#GCP_Client_Fits_Get_Error_Number
+ * @see gcp_client_fits.html#GCP_Client_Fits_Error_String
  */
 void GCP_Client_General_Error_To_String(char *error_string)
 {
@@ -173,6 +540,78 @@ void GCP_Client_General_Error_To_String(char *error_string)
 	{
 		GCP_Client_Read_Write_Error_String(error_string);
 	}
+	if(GCP_Client_Log_UDP_Get_Error_Number() != 0)
+	{
+		GCP_Client_Log_UDP_Error_String(error_string);
+	}
+	if(GCP_Client_Stats_Get_Error_Number() != 0)
+	{
+		GCP_Client_Stats_Error_String(error_string);
+	}
+	if(GCP_Client_Trace_Get_Error_Number() != 0)
+	{
+		GCP_Client_Trace_Error_String(error_string);
+	}
+	if(GCP_Client_List_Get_Error_Number() != 0)
+	{
+		GCP_Client_List_Error_String(error_string);
+	}
+	if(GCP_Client_Batch_Get_Error_Number() != 0)
+	{
+		GCP_Client_Batch_Error_String(error_string);
+	}
+	if(GCP_Client_Metadata_Get_Error_Number() != 0)
+	{
+		GCP_Client_Metadata_Error_String(error_string);
+	}
+	if(GCP_Client_Manifest_Get_Error_Number() != 0)
+	{
+		GCP_Client_Manifest_Error_String(error_string);
+	}
+	if(GCP_Client_Copy_Get_Error_Number() != 0)
+	{
+		GCP_Client_Copy_Error_String(error_string);
+	}
+	if(GCP_Client_Delete_Get_Error_Number() != 0)
+	{
+		GCP_Client_Delete_Error_String(error_string);
+	}
+	if(GCP_Client_Sync_Get_Error_Number() != 0)
+	{
+		GCP_Client_Sync_Error_String(error_string);
+	}
+	if(GCP_Client_Buffer_Get_Error_Number() != 0)
+	{
+		GCP_Client_Buffer_Error_String(error_string);
+	}
+	if(GCP_Client_Budget_Get_Error_Number() != 0)
+	{
+		GCP_Client_Budget_Error_String(error_string);
+	}
+	if(GCP_Client_Adaptive_Get_Error_Number() != 0)
+	{
+		GCP_Client_Adaptive_Error_String(error_string);
+	}
+	if(GCP_Client_Operation_Get_Error_Number() != 0)
+	{
+		GCP_Client_Operation_Error_String(error_string);
+	}
+	if(GCP_Client_Bandwidth_Get_Error_Number() != 0)
+	{
+		GCP_Client_Bandwidth_Error_String(error_string);
+	}
+	if(GCP_Client_Scheduler_Get_Error_Number() != 0)
+	{
+		GCP_Client_Scheduler_Error_String(error_string);
+	}
+	if(GCP_Client_Completions_Get_Error_Number() != 0)
+	{
+		GCP_Client_Completions_Error_String(error_string);
+	}
+	if(GCP_Client_Fits_Get_Error_Number() != 0)
+	{
+		GCP_Client_Fits_Error_String(error_string);
+	}
 	if(General_Error_Number != 0)
 	{
 		GCP_Client_General_Get_Current_Time_String(time_string,32);
@@ -205,74 +644,147 @@ int GCP_Client_General_Get_Error_Number(void)
  */
 void GCP_Client_General_Get_Current_Time_String(char *time_string,int string_length)
 {
-	char timezone_string[16];
-	char millsecond_string[8];
 	struct timespec current_time;
-	struct tm *utc_time = NULL;
 
 	clock_gettime(CLOCK_REALTIME,&current_time);
-	utc_time = gmtime(&(current_time.tv_sec));
-	strftime(time_string,string_length,"%d-%m-%YT%H:%M:%S",utc_time);
-	sprintf(millsecond_string,"%03ld",(current_time.tv_nsec/GCP_CLIENT_GENERAL_ONE_MILLISECOND_NS));
-	strftime(timezone_string,16,"%z",utc_time);
-	if((strlen(time_string)+strlen(millsecond_string)+strlen(timezone_string)+3) < string_length)
-	{
-		strcat(time_string,".");
-		strcat(time_string,millsecond_string);
-		strcat(time_string," ");
-		strcat(time_string,timezone_string);
-	}
+	General_Time_To_String(&current_time,time_string,string_length);
+}
+
+/**
+ * Routine to get the time the log message currently being handled was logged, in a string. 
+ * When asynchronous logging is enabled, log handlers are called some time after the message was logged, by the
+ * asynchronous log thread; in this case the time the message was originally logged is returned.
+ * Otherwise the current time is returned. The string is returned in the same format as
+ * GCP_Client_General_Get_Current_Time_String.
+ * @param time_string The string to fill with the time.
+ * @param string_length The length of the buffer passed in. It is recommended the length is at least 20 characters.
+ * @see #Log_Async_Current_Timestamp
+ * @see #General_Time_To_String
+ * @see #GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_General_Get_Log_Time_String(char *time_string,int string_length)
+{
+	if(Log_Async_Current_Timestamp != NULL)
+		General_Time_To_String(Log_Async_Current_Timestamp,time_string,string_length);
+	else
+		GCP_Client_General_Get_Current_Time_String(time_string,string_length);
 }
 
 /**
  * Routine to log a message to a defined logging mechanism. This routine has an arbitary number of arguments,
- * and uses vsprintf to format them i.e. like fprintf. 
- * GCP_Client_General_Log is then called to handle the log message.
+ * and uses vsprintf to format them i.e. like fprintf. The message is logged on behalf of the general module,
+ * see GCP_Client_General_Module_Log_Format.
  * @param level An integer, used to decide whether this particular message has been selected for
  * 	logging or not.
  * @param format A string, with formatting statements the same as fprintf would use to determine the type
  * 	of the following arguments.
- * @see #GCP_Client_General_Log
- * @see #LOG_BUFF_LENGTH
+ * @see #General_Log_Filter_Before_Format
+ * @see #General_Log_VFormat
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL
  */
 void GCP_Client_General_Log_Format(int level,const char *format,...)
 {
-	char buff[LOG_BUFF_LENGTH];
 	va_list ap;
 
-/* format the arguments */
+	if(format == NULL)
+		return;
+	if(General_Log_Filter_Before_Format(GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL,level) == FALSE)
+		return;
+	va_start(ap,format);
+	General_Log_VFormat(level,format,ap);
+	va_end(ap);
+}
+
+/**
+ * Routine to log a message on behalf of a library module. This routine has an arbitary number of arguments,
+ * and uses vsprintf to format them i.e. like fprintf. Before the message is formatted, the level is tested
+ * against the module's runtime log level (and the log filter, if it is one of the level filters supplied
+ * by this module), and the message is discarded without being formatted if it would not be logged.
+ * Otherwise the message is formatted and passed to the log filter and handler, or 
+ * queued for the asynchronous log thread if asynchronous logging is enabled.
+ * @param module Which module is logging the message, one of GCP_CLIENT_GENERAL_LOG_MODULE_*.
+ * @param level An integer, used to decide whether this particular message has been selected for
+ * 	logging or not.
+ * @param format A string, with formatting statements the same as fprintf would use to determine the type
+ * 	of the following arguments.
+ * @see #General_Log_Filter_Before_Format
+ * @see #General_Log_VFormat
+ */
+void GCP_Client_General_Module_Log_Format(int module,int level,const char *format,...)
+{
+	va_list ap;
+
+	if(format == NULL)
+		return;
+	if(General_Log_Filter_Before_Format(module,level) == FALSE)
+		return;
 	va_start(ap,format);
-	vsprintf(buff,format,ap);
+	General_Log_VFormat(level,format,ap);
 	va_end(ap);
-/* call the log routine to log the results */
-	GCP_Client_General_Log(level,buff);
 }
 
 /**
  * Routine to log a message to a defined logging mechanism. If the string or General_Data.Log_Handler are NULL
  * the routine does not log the message. If the General_Data.Log_Filter function pointer is non-NULL, the
  * message is passed to it to determine whether to log the message.
+ * If asynchronous logging is enabled, the message is instead copied into a ring buffer record and 
+ * queued for the asynchronous log thread, which does the filtering and calls the handler.
+ * The message is logged on behalf of the general module, see GCP_Client_General_Module_Log.
  * @param level An integer, used to decide whether this particular message has been selected for
  * 	logging or not.
  * @param string The message to log.
- * @see #General_Data
+ * @see #GCP_Client_General_Module_Log
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL
  */
 void GCP_Client_General_Log(int level,const char *string)
+{
+	GCP_Client_General_Module_Log(GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL,level,string);
+}
+
+/**
+ * Routine to log a message on behalf of a library module. If the string is NULL, or the level fails the
+ * module's runtime log level, or General_Data.Log_Handler is NULL the routine does not log the message. 
+ * If the General_Data.Log_Filter function pointer is non-NULL, the
+ * message is passed to it to determine whether to log the message.
+ * If asynchronous logging is enabled, the message is instead copied into a ring buffer record and 
+ * queued for the asynchronous log thread, which does the filtering and calls the handler.
+ * @param module Which module is logging the message, one of GCP_CLIENT_GENERAL_LOG_MODULE_*.
+ * @param level An integer, used to decide whether this particular message has been selected for
+ * 	logging or not.
+ * @param string The message to log.
+ * @see #General_Data
+ * @see #Log_Async_Data
+ * @see #General_Log_Filter_Before_Format
+ * @see #General_Log_Dispatch
+ * @see #Log_Async_Enqueue_Format
+ */
+void GCP_Client_General_Module_Log(int module,int level,const char *string)
 {
 /* If the string is NULL, don't log. */
 	if(string == NULL)
 		return;
-/* If there is no log handler, return */
-	if(General_Data.Log_Handler == NULL)
+	if(General_Log_Filter_Before_Format(module,level) == FALSE)
 		return;
-/* If there's a log filter, check it returns TRUE for this message */
-	if(General_Data.Log_Filter != NULL)
+	if(Log_Async_Data.Enabled.load(std::memory_order_relaxed))
 	{
-		if(General_Data.Log_Filter(level,string) == FALSE)
-			return;
+		Log_Async_Enqueue_Format(level,"%s",string);
+		return;
 	}
-/* We can log the message */
-	(*General_Data.Log_Handler)(level,string);
+	General_Log_Dispatch(level,string);
+}
+
+/**
+ * Routine to determine whether a message of the specified level, logged by the specified module, would be
+ * discarded before being formatted. This allows callers to skip expensive work done solely to generate
+ * log message arguments.
+ * @param module Which module is logging the message, one of GCP_CLIENT_GENERAL_LOG_MODULE_*.
+ * @param level The log level of the message.
+ * @return The routine returns TRUE if the message might be logged, and FALSE if it definitely won't be.
+ * @see #General_Log_Filter_Before_Format
+ */
+int GCP_Client_General_Log_Is_Enabled(int module,int level)
+{
+	return General_Log_Filter_Before_Format(module,level);
 }
 
 /**
@@ -300,10 +812,10 @@ void GCP_Client_General_Set_Log_Filter_Function(int (*filter_fn)(int level,const
 /**
  * A log handler to be used for the General_Data.Log_Handler function.
  * Prints the message to stdout, terminated by a newline and Prepended by a timestamp generated by 
- * GCP_Client_General_Get_Current_Time_String.
+ * GCP_Client_General_Get_Log_Time_String.
  * @param level The log level for this message.
  * @param string The log message to be logged. 
- * @see #GCP_Client_General_Get_Current_Time_String
+ * @see #GCP_Client_General_Get_Log_Time_String
  */
 void GCP_Client_General_Log_Handler_Stdout(int level,const char *string)
 {
@@ -311,7 +823,7 @@ void GCP_Client_General_Log_Handler_Stdout(int level,const char *string)
 
 	if(string == NULL)
 		return;
-	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	GCP_Client_General_Get_Log_Time_String(time_string,32);
 	fprintf(stdout,"%s %s\n",time_string,string);
 }
 
@@ -321,7 +833,7 @@ void GCP_Client_General_Log_Handler_Stdout(int level,const char *string)
  */
 void GCP_Client_General_Set_Log_Filter_Level(int level)
 {
-	General_Data.Log_Filter_Level = level;
+	General_Data.Log_Filter_Level.store(level,std::memory_order_relaxed);
 }
 
 /**
@@ -334,7 +846,7 @@ void GCP_Client_General_Set_Log_Filter_Level(int level)
  */
 int GCP_Client_General_Log_Filter_Level_Absolute(int level,const char *string)
 {
-	return (level <= General_Data.Log_Filter_Level);
+	return (level <= General_Data.Log_Filter_Level.load(std::memory_order_relaxed));
 }
 
 /**
@@ -347,6 +859,538 @@ int GCP_Client_General_Log_Filter_Level_Absolute(int level,const char *string)
  */
 int GCP_Client_General_Log_Filter_Level_Bitwise(int level,const char *string)
 {
-	return ((level & General_Data.Log_Filter_Level) > 0);
+	return ((level & General_Data.Log_Filter_Level.load(std::memory_order_relaxed)) > 0);
+}
+
+/**
+ * Routine to set the runtime log level of one module of the library. Messages logged by that module
+ * with a level greater than this are discarded before being formatted, so this can be left low in production 
+ * (where the library is still compiled with full logging) at almost no cost. This can be called at any time,
+ * from any thread.
+ * @param module Which module to set the log level for, one of GCP_CLIENT_GENERAL_LOG_MODULE_*.
+ * @param level The new log level for the module. Use 0 to discard all messages from the module, 
+ * 	and GCP_CLIENT_GENERAL_LOG_LEVEL_ALL to pass all messages on to the log filter.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, General_Error_Number / 
+ * 	General_Error_String should contain details of the failure.
+ * @see #General_Data
+ * @see #General_Error_Number
+ * @see #General_Error_String
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_LOG_LEVEL_ALL
+ */
+int GCP_Client_General_Set_Module_Log_Level(int module,int level)
+{
+	General_Error_Number = 0;
+	if((module < 0)||(module >= GCP_CLIENT_GENERAL_LOG_MODULE_COUNT))
+	{
+		General_Error_Number = 6;
+		sprintf(General_Error_String,"GCP_Client_General_Set_Module_Log_Level:Illegal module %d.",module);
+		return FALSE;
+	}
+	General_Data.Module_Log_Level_List[module].store(level,std::memory_order_relaxed);
+	return TRUE;
 }
 
+/**
+ * Routine to get the runtime log level of one module of the library.
+ * @param module Which module to get the log level for, one of GCP_CLIENT_GENERAL_LOG_MODULE_*.
+ * @return The module's log level, or 0 if module is out of range.
+ * @see #General_Data
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+int GCP_Client_General_Get_Module_Log_Level(int module)
+{
+	if((module < 0)||(module >= GCP_CLIENT_GENERAL_LOG_MODULE_COUNT))
+		return 0;
+	return General_Data.Module_Log_Level_List[module].load(std::memory_order_relaxed);
+}
+
+/**
+ * Routine to set the runtime log levels of several modules from a string, for instance one taken from 
+ * a command line argument or environment variable. The string is a comma separated list of
+ * &lt;module&gt;=&lt;level&gt; pairs, where &lt;module&gt; is one of 'general', 'connection', 'read_write' 
+ * (etc) or 'all' e.g. "all=1,read_write=5".
+ * @param level_string The string to parse.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, General_Error_Number / 
+ * 	General_Error_String should contain details of the failure. Pairs before the failing one are 
+ * 	still applied.
+ * @see #General_Log_Module_Name_List
+ * @see #GCP_Client_General_Set_Module_Log_Level
+ * @see #General_Error_Number
+ * @see #General_Error_String
+ */
+int GCP_Client_General_Set_Module_Log_Levels(const char *level_string)
+{
+	char buff[LOG_BUFF_LENGTH];
+	char *pair_string = NULL;
+	char *save_ptr = NULL;
+	char *equals_ptr = NULL;
+	int module,level,found;
+
+	General_Error_Number = 0;
+	if(level_string == NULL)
+	{
+		General_Error_Number = 7;
+		sprintf(General_Error_String,"GCP_Client_General_Set_Module_Log_Levels:level_string was NULL.");
+		return FALSE;
+	}
+	strncpy(buff,level_string,LOG_BUFF_LENGTH-1);
+	buff[LOG_BUFF_LENGTH-1] = '\0';
+	pair_string = strtok_r(buff,",",&save_ptr);
+	while(pair_string != NULL)
+	{
+		equals_ptr = strchr(pair_string,'=');
+		if((equals_ptr == NULL)||(sscanf(equals_ptr+1,"%d",&level) != 1))
+		{
+			General_Error_Number = 8;
+			snprintf(General_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_General_Set_Module_Log_Levels:Failed to parse '%s'.",pair_string);
+			return FALSE;
+		}
+		(*equals_ptr) = '\0';
+		found = FALSE;
+		for(module = 0; module < GCP_CLIENT_GENERAL_LOG_MODULE_COUNT; module++)
+		{
+			if((strcmp(pair_string,"all") == 0)||(strcmp(pair_string,General_Log_Module_Name_List[module]) == 0))
+			{
+				General_Data.Module_Log_Level_List[module].store(level,std::memory_order_relaxed);
+				found = TRUE;
+			}
+		}
+		if(found == FALSE)
+		{
+			General_Error_Number = 9;
+			snprintf(General_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_General_Set_Module_Log_Levels:Unknown module '%s'.",pair_string);
+			return FALSE;
+		}
+		pair_string = strtok_r(NULL,",",&save_ptr);
+	}
+	return TRUE;
+}
+
+
+/**
+ * Routine to start asynchronous logging. Log messages passed to GCP_Client_General_Log_Format and 
+ * GCP_Client_General_Log are formatted into a record in a lock-free multi-producer ring buffer, rather than
+ * being filtered and handled on the calling thread. A background thread removes the records from the ring buffer,
+ * and passes them to the configured filter and handler functions. If the ring buffer is full the message is
+ * dropped (and counted) rather than blocking the caller. An atexit handler is installed to flush the ring buffer
+ * (for at most LOG_ASYNC_EXIT_FLUSH_TIMEOUT_MS milliseconds) when the program exits.
+ * @param record_count The number of records in the ring buffer. This must be a power of two, or 0 to use the
+ *        default (LOG_ASYNC_DEFAULT_RECORD_COUNT).
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, General_Error_Number / 
+ *         General_Error_String should contain details of the failure.
+ * @see #LOG_ASYNC_DEFAULT_RECORD_COUNT
+ * @see #LOG_ASYNC_EXIT_FLUSH_TIMEOUT_MS
+ * @see #Log_Async_Data
+ * @see #Log_Async_Thread
+ * @see #Log_Async_Exit_Handler
+ * @see #General_Error_Number
+ * @see #General_Error_String
+ */
+int GCP_Client_General_Log_Async_Start(int record_count)
+{
+	unsigned long i;
+	int retval;
+
+	General_Error_Number = 0;
+	if(record_count == 0)
+		record_count = LOG_ASYNC_DEFAULT_RECORD_COUNT;
+	if((record_count < 2)||((record_count & (record_count-1)) != 0))
+	{
+		General_Error_Number = 1;
+		sprintf(General_Error_String,"GCP_Client_General_Log_Async_Start:record_count %d is not a power of two.",
+			record_count);
+		return FALSE;
+	}
+	if(Log_Async_Data.Record_List != NULL)
+	{
+		General_Error_Number = 2;
+		sprintf(General_Error_String,"GCP_Client_General_Log_Async_Start:Asynchronous logging already started.");
+		return FALSE;
+	}
+	Log_Async_Data.Record_List = new (std::nothrow) struct Log_Async_Record_Struct[record_count];
+	if(Log_Async_Data.Record_List == NULL)
+	{
+		General_Error_Number = 3;
+		sprintf(General_Error_String,"GCP_Client_General_Log_Async_Start:Failed to allocate %d records.",
+			record_count);
+		return FALSE;
+	}
+	for(i = 0; i < (unsigned long)record_count; i++)
+		Log_Async_Data.Record_List[i].Sequence.store(i,std::memory_order_relaxed);
+	Log_Async_Data.Record_Mask = record_count-1;
+	Log_Async_Data.Enqueue_Position.store(0,std::memory_order_relaxed);
+	Log_Async_Data.Dequeue_Position = 0;
+	Log_Async_Data.Stop.store(FALSE,std::memory_order_relaxed);
+	sem_init(&(Log_Async_Data.Semaphore),0,0);
+	retval = pthread_create(&(Log_Async_Data.Thread),NULL,Log_Async_Thread,NULL);
+	if(retval != 0)
+	{
+		sem_destroy(&(Log_Async_Data.Semaphore));
+		delete [] Log_Async_Data.Record_List;
+		Log_Async_Data.Record_List = NULL;
+		General_Error_Number = 4;
+		sprintf(General_Error_String,"GCP_Client_General_Log_Async_Start:Failed to create log thread (%d).",
+			retval);
+		return FALSE;
+	}
+	if(Log_Async_Data.Exit_Handler_Installed == FALSE)
+	{
+		atexit(Log_Async_Exit_Handler);
+		Log_Async_Data.Exit_Handler_Installed = TRUE;
+	}
+	Log_Async_Data.Enabled.store(TRUE,std::memory_order_release);
+	return TRUE;
+}
+
+/**
+ * Routine to stop asynchronous logging. New log messages are logged synchronously from the point this
+ * routine is called. The asynchronous log thread is then given flush_timeout_ms milliseconds to pass 
+ * any records still in the ring buffer to the log handler; records still queued after this
+ * are dropped (and counted as such). The ring buffer is then freed.
+ * @param flush_timeout_ms The maximum length of time to spend flushing queued records, in milliseconds.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, General_Error_Number / 
+ *         General_Error_String should contain details of the failure.
+ * @see #Log_Async_Data
+ * @see #Log_Async_Thread
+ * @see #General_Error_Number
+ * @see #General_Error_String
+ */
+int GCP_Client_General_Log_Async_Stop(int flush_timeout_ms)
+{
+	struct timespec sleep_time;
+
+	General_Error_Number = 0;
+	if(Log_Async_Data.Record_List == NULL)
+	{
+		General_Error_Number = 5;
+		sprintf(General_Error_String,"GCP_Client_General_Log_Async_Stop:Asynchronous logging not started.");
+		return FALSE;
+	}
+	/* stop new records being queued, and wait for producers part way through queueing a record */
+	Log_Async_Data.Enabled.store(FALSE,std::memory_order_seq_cst);
+	sleep_time.tv_sec = 0;
+	sleep_time.tv_nsec = GCP_CLIENT_GENERAL_ONE_MILLISECOND_NS;
+	while(Log_Async_Data.In_Flight_Count.load(std::memory_order_seq_cst) > 0)
+		nanosleep(&sleep_time,NULL);
+	/* ask the log thread to flush the ring buffer and exit */
+	clock_gettime(CLOCK_REALTIME,&(Log_Async_Data.Flush_Deadline));
+	Log_Async_Data.Flush_Deadline.tv_sec += flush_timeout_ms/GCP_CLIENT_GENERAL_ONE_SECOND_MS;
+	Log_Async_Data.Flush_Deadline.tv_nsec += (flush_timeout_ms%GCP_CLIENT_GENERAL_ONE_SECOND_MS)*
+		GCP_CLIENT_GENERAL_ONE_MILLISECOND_NS;
+	if(Log_Async_Data.Flush_Deadline.tv_nsec >= GCP_CLIENT_GENERAL_ONE_SECOND_NS)
+	{
+		Log_Async_Data.Flush_Deadline.tv_sec++;
+		Log_Async_Data.Flush_Deadline.tv_nsec -= GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+	}
+	Log_Async_Data.Stop.store(TRUE,std::memory_order_release);
+	sem_post(&(Log_Async_Data.Semaphore));
+	pthread_join(Log_Async_Data.Thread,NULL);
+	sem_destroy(&(Log_Async_Data.Semaphore));
+	delete [] Log_Async_Data.Record_List;
+	Log_Async_Data.Record_List = NULL;
+	return TRUE;
+}
+
+/**
+ * Routine to retrieve the asynchronous logging counters. These accumulate over the life of the program.
+ * @param logged_count The address of an unsigned long long, on return filled with the number of records
+ *        the asynchronous log thread has passed to the log filter/handler. Can be NULL.
+ * @param dropped_count The address of an unsigned long long, on return filled with the number of records
+ *        dropped because the ring buffer was full, or because they were not flushed in time when 
+ *        asynchronous logging was stopped. Can be NULL.
+ * @see #Log_Async_Data
+ */
+void GCP_Client_General_Log_Async_Get_Statistics(unsigned long long *logged_count,unsigned long long *dropped_count)
+{
+	if(logged_count != NULL)
+		(*logged_count) = Log_Async_Data.Logged_Count.load(std::memory_order_relaxed);
+	if(dropped_count != NULL)
+		(*dropped_count) = Log_Async_Data.Dropped_Count.load(std::memory_order_relaxed);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Convert the specified time into a string. The string is returned in the format
+ * '01/01/2000 13:59:59.123 UTC'. The time is in UTC.
+ * @param timestamp The time to convert.
+ * @param time_string The string to fill with the time.
+ * @param string_length The length of the buffer passed in. It is recommended the length is at least 20 characters.
+ * @see #GCP_CLIENT_GENERAL_ONE_MILLISECOND_NS
+ */
+static void General_Time_To_String(struct timespec *timestamp,char *time_string,int string_length)
+{
+	char timezone_string[16];
+	char millsecond_string[8];
+	struct tm utc_time;
+
+	gmtime_r(&(timestamp->tv_sec),&utc_time);
+	strftime(time_string,string_length,"%d-%m-%YT%H:%M:%S",&utc_time);
+	sprintf(millsecond_string,"%03ld",(timestamp->tv_nsec/GCP_CLIENT_GENERAL_ONE_MILLISECOND_NS));
+	strftime(timezone_string,16,"%z",&utc_time);
+	if((strlen(time_string)+strlen(millsecond_string)+strlen(timezone_string)+3) < (size_t)string_length)
+	{
+		strcat(time_string,".");
+		strcat(time_string,millsecond_string);
+		strcat(time_string," ");
+		strcat(time_string,timezone_string);
+	}
+}
+
+/**
+ * Decide whether a message should be discarded before it is formatted. This is the cheap part of the filtering,
+ * done on the logging thread before any formatting: the level is tested against the module's runtime
+ * log level (a relaxed atomic load), we check there is a log handler, and if the log filter is one of 
+ * the level based filters supplied by this module (which do not look at the message string) it is called as well.
+ * Any other log filter is called after formatting, in General_Log_Dispatch.
+ * @param module Which module is logging the message, one of GCP_CLIENT_GENERAL_LOG_MODULE_*. 
+ * 	Out of range modules are treated as GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL.
+ * @param level The log level of the message.
+ * @return The routine returns TRUE if the message should be formatted and logged, and FALSE if it should be
+ * 	discarded.
+ * @see #General_Data
+ * @see #GCP_Client_General_Log_Filter_Level_Absolute
+ * @see #GCP_Client_General_Log_Filter_Level_Bitwise
+ * @see #General_Log_Dispatch
+ */
+static int General_Log_Filter_Before_Format(int module,int level)
+{
+	int (*log_filter)(int level,const char *string);
+
+	if((module < 0)||(module >= GCP_CLIENT_GENERAL_LOG_MODULE_COUNT))
+		module = GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL;
+	if(level > General_Data.Module_Log_Level_List[module].load(std::memory_order_relaxed))
+		return FALSE;
+	if(General_Data.Log_Handler == NULL)
+		return FALSE;
+	log_filter = General_Data.Log_Filter;
+	if((log_filter == GCP_Client_General_Log_Filter_Level_Absolute)||
+	   (log_filter == GCP_Client_General_Log_Filter_Level_Bitwise))
+	{
+		return (*log_filter)(level,NULL);
+	}
+	return TRUE;
+}
+
+/**
+ * Format a log message that has passed General_Log_Filter_Before_Format and log it. If asynchronous logging is
+ * enabled, the message is formatted straight into a ring buffer record and queued for the asynchronous log thread.
+ * Otherwise it is formatted into a LOG_BUFF_LENGTH buffer and passed to General_Log_Dispatch.
+ * @param level The log level of the message.
+ * @param format A string, with formatting statements the same as fprintf would use to determine the type
+ * 	of the following arguments.
+ * @param ap The arguments to format.
+ * @see #LOG_BUFF_LENGTH
+ * @see #Log_Async_Data
+ * @see #Log_Async_Enqueue
+ * @see #General_Log_Dispatch
+ */
+static void General_Log_VFormat(int level,const char *format,va_list ap)
+{
+	char buff[LOG_BUFF_LENGTH];
+
+	if(Log_Async_Data.Enabled.load(std::memory_order_relaxed))
+	{
+		Log_Async_Enqueue(level,format,ap);
+		return;
+	}
+	vsnprintf(buff,LOG_BUFF_LENGTH,format,ap);
+	General_Log_Dispatch(level,buff);
+}
+
+/**
+ * Pass a formatted log message through the General_Data.Log_Filter (if any), and if it passes, to
+ * the General_Data.Log_Handler. This is called on the logging thread when logging synchronously, or 
+ * on the asynchronous log thread when asynchronous logging is enabled.
+ * @param level An integer, used to decide whether this particular message has been selected for
+ * 	logging or not.
+ * @param string The message to log.
+ * @see #General_Data
+ */
+static void General_Log_Dispatch(int level,const char *string)
+{
+	void (*log_handler)(int level,const char *string);
+
+	log_handler = General_Data.Log_Handler;
+	if(log_handler == NULL)
+		return;
+/* If there's a log filter, check it returns TRUE for this message */
+	if(General_Data.Log_Filter != NULL)
+	{
+		if(General_Data.Log_Filter(level,string) == FALSE)
+			return;
+	}
+/* We can log the message */
+	(*log_handler)(level,string);
+}
+
+/**
+ * Queue a log message for the asynchronous log thread. A free record is claimed in the ring buffer
+ * using a compare and swap on the enqueue position (so multiple threads can log concurrently without locking),
+ * the message is formatted directly into the record with vsnprintf, the record timestamped, and then published by
+ * updating it's sequence number. If the ring buffer is full, the message is dropped and 
+ * Log_Async_Data.Dropped_Count is incremented; this routine never waits for the log thread.
+ * @param level The log level of the message.
+ * @param format A string, with formatting statements the same as fprintf would use to determine the type
+ * 	of the following arguments.
+ * @param ap The arguments to format.
+ * @return The routine returns TRUE if the message was queued, and FALSE if it was dropped.
+ * @see #Log_Async_Data
+ * @see #Log_Async_Record_Struct
+ * @see #LOG_ASYNC_MESSAGE_LENGTH
+ */
+static int Log_Async_Enqueue(int level,const char *format,va_list ap)
+{
+	struct Log_Async_Record_Struct *record = NULL;
+	unsigned long position,sequence;
+	long difference;
+	int done;
+
+	Log_Async_Data.In_Flight_Count.fetch_add(1,std::memory_order_seq_cst);
+	/* Asynchronous logging may have been stopped since the caller checked. Log synchronously in this case. */
+	if(Log_Async_Data.Enabled.load(std::memory_order_seq_cst) == FALSE)
+	{
+		Log_Async_Data.In_Flight_Count.fetch_sub(1,std::memory_order_seq_cst);
+		char buff[LOG_BUFF_LENGTH];
+		vsnprintf(buff,LOG_BUFF_LENGTH,format,ap);
+		General_Log_Dispatch(level,buff);
+		return TRUE;
+	}
+	position = Log_Async_Data.Enqueue_Position.load(std::memory_order_relaxed);
+	done = FALSE;
+	while(done == FALSE)
+	{
+		record = &(Log_Async_Data.Record_List[position & Log_Async_Data.Record_Mask]);
+		sequence = record->Sequence.load(std::memory_order_acquire);
+		difference = (long)sequence-(long)position;
+		if(difference == 0)
+		{
+			/* slot is free, try to claim it */
+			if(Log_Async_Data.Enqueue_Position.compare_exchange_weak(position,position+1,
+										 std::memory_order_relaxed))
+				done = TRUE;
+		}
+		else if(difference < 0)
+		{
+			/* ring buffer is full: drop the message rather than wait */
+			Log_Async_Data.Dropped_Count.fetch_add(1,std::memory_order_relaxed);
+			Log_Async_Data.In_Flight_Count.fetch_sub(1,std::memory_order_seq_cst);
+			return FALSE;
+		}
+		else
+			position = Log_Async_Data.Enqueue_Position.load(std::memory_order_relaxed);
+	}
+	record->Level = level;
+	clock_gettime(CLOCK_REALTIME,&(record->Timestamp));
+	vsnprintf(record->Message,LOG_ASYNC_MESSAGE_LENGTH,format,ap);
+	/* publish the record */
+	record->Sequence.store(position+1,std::memory_order_release);
+	Log_Async_Data.In_Flight_Count.fetch_sub(1,std::memory_order_seq_cst);
+	sem_post(&(Log_Async_Data.Semaphore));
+	return TRUE;
+}
+
+/**
+ * Queue a log message for the asynchronous log thread, with a variable number of arguments.
+ * @param level The log level of the message.
+ * @param format A string, with formatting statements the same as fprintf would use to determine the type
+ * 	of the following arguments.
+ * @return The routine returns TRUE if the message was queued, and FALSE if it was dropped.
+ * @see #Log_Async_Enqueue
+ */
+static int Log_Async_Enqueue_Format(int level,const char *format,...)
+{
+	va_list ap;
+	int retval;
+
+	va_start(ap,format);
+	retval = Log_Async_Enqueue(level,format,ap);
+	va_end(ap);
+	return retval;
+}
+
+/**
+ * The asynchronous log thread. Waits on Log_Async_Data.Semaphore for records to be published, and passes
+ * each one in turn to General_Log_Dispatch, with Log_Async_Current_Timestamp pointing at the record's
+ * timestamp so handlers can retrieve the time the message was logged. When Log_Async_Data.Stop is set,
+ * the remaining records are flushed until the ring buffer is empty or Log_Async_Data.Flush_Deadline has passed,
+ * any records left are counted as dropped, and the thread exits.
+ * @param arg Thread argument, not used.
+ * @return The routine returns NULL.
+ * @see #Log_Async_Data
+ * @see #Log_Async_Current_Timestamp
+ * @see #General_Log_Dispatch
+ * @see #LOG_ASYNC_WAIT_MS
+ */
+static void *Log_Async_Thread(void *arg)
+{
+	struct Log_Async_Record_Struct *record = NULL;
+	struct timespec wait_time,current_time;
+	unsigned long position,sequence;
+	int stopping,done;
+
+	done = FALSE;
+	while(done == FALSE)
+	{
+		stopping = Log_Async_Data.Stop.load(std::memory_order_acquire);
+		/* process all published records */
+		position = Log_Async_Data.Dequeue_Position;
+		record = &(Log_Async_Data.Record_List[position & Log_Async_Data.Record_Mask]);
+		sequence = record->Sequence.load(std::memory_order_acquire);
+		while(sequence == (position+1))
+		{
+			if(stopping)
+			{
+				clock_gettime(CLOCK_REALTIME,&current_time);
+				if(fdifftime(current_time,Log_Async_Data.Flush_Deadline) > 0.0)
+					break;
+			}
+			Log_Async_Current_Timestamp = &(record->Timestamp);
+			General_Log_Dispatch(record->Level,record->Message);
+			Log_Async_Current_Timestamp = NULL;
+			Log_Async_Data.Logged_Count.fetch_add(1,std::memory_order_relaxed);
+			/* release the slot for reuse one lap later */
+			record->Sequence.store(position+Log_Async_Data.Record_Mask+1,std::memory_order_release);
+			position++;
+			Log_Async_Data.Dequeue_Position = position;
+			record = &(Log_Async_Data.Record_List[position & Log_Async_Data.Record_Mask]);
+			sequence = record->Sequence.load(std::memory_order_acquire);
+		}
+		if(stopping)
+		{
+			/* anything still queued missed the flush deadline */
+			Log_Async_Data.Dropped_Count.fetch_add(Log_Async_Data.Enqueue_Position.load(std::memory_order_acquire)-
+							      position,std::memory_order_relaxed);
+			done = TRUE;
+		}
+		else
+		{
+			clock_gettime(CLOCK_REALTIME,&wait_time);
+			wait_time.tv_nsec += LOG_ASYNC_WAIT_MS*GCP_CLIENT_GENERAL_ONE_MILLISECOND_NS;
+			if(wait_time.tv_nsec >= GCP_CLIENT_GENERAL_ONE_SECOND_NS)
+			{
+				wait_time.tv_sec++;
+				wait_time.tv_nsec -= GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+			}
+			sem_timedwait(&(Log_Async_Data.Semaphore),&wait_time);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Routine installed with atexit when asynchronous logging is started. If asynchronous logging is still
+ * running when the program exits, the ring buffer is flushed, for at most LOG_ASYNC_EXIT_FLUSH_TIMEOUT_MS 
+ * milliseconds, so a program exiting never stalls waiting for the log handler.
+ * @see #GCP_Client_General_Log_Async_Stop
+ * @see #LOG_ASYNC_EXIT_FLUSH_TIMEOUT_MS
+ */
+static void Log_Async_Exit_Handler(void)
+{
+	if(Log_Async_Data.Record_List != NULL)
+		GCP_Client_General_Log_Async_Stop(LOG_ASYNC_EXIT_FLUSH_TIMEOUT_MS);
+}
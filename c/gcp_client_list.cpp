@@ -0,0 +1,592 @@
+/* gcp_client_list.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Bucket object listing routines.
+*/
+/**
+ * Google Cloud Platform bucket object listing routines. Listings are streamed a page at a time to a
+ * caller supplied callback, so memory use is bounded by the page size and not the number of objects in the bucket.
+ * A listing can also be split into disjoint name ranges which are listed in parallel.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include "google/cloud/storage/client.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_list.h"
+#include "gcp_client_stats.h"
+#include "gcp_client_trace.h"
+#include "gcp_client_connection_private.h"
+#include "gcp_client_list_private.h"
+
+/* data types */
+/**
+ * Data type holding the state shared between the threads of a parallel listing. This consists of the following:
+ * <dl>
+ * <dt>Mutex</dt> <dd>A mutex serialising calls to the caller's callback.</dd>
+ * <dt>Callback</dt> <dd>The caller's callback function.</dd>
+ * <dt>User_Data</dt> <dd>The caller's user data pointer, passed to the callback.</dd>
+ * <dt>Stop</dt> <dd>Set when the callback returns FALSE, or a worker fails, so the other workers stop early.</dd>
+ * </dl>
+ */
+struct List_Parallel_Struct
+{
+	pthread_mutex_t Mutex;
+	GCP_Client_List_Callback_T Callback;
+	void *User_Data;
+	std::atomic<int> Stop;
+};
+
+/**
+ * Data type holding the arguments and result of one worker thread of a parallel listing.
+ * This consists of the following:
+ * <dl>
+ * <dt>Thread</dt> <dd>The worker's thread id.</dd>
+ * <dt>Parallel</dt> <dd>A pointer to the shared parallel listing state.</dd>
+ * <dt>Bucket_Name</dt> <dd>The bucket to list.</dd>
+ * <dt>Prefix</dt> <dd>The object name prefix to list, or NULL.</dd>
+ * <dt>Start_Offset</dt> <dd>The (inclusive) start of the worker's name range, or NULL for the start of the bucket.</dd>
+ * <dt>End_Offset</dt> <dd>The (exclusive) end of the worker's name range, or NULL for the end of the bucket.</dd>
+ * <dt>Page_Size</dt> <dd>The number of objects per page.</dd>
+ * <dt>Return_Value</dt> <dd>The value GCP_Client_List returned in the worker thread.</dd>
+ * <dt>Error_Number</dt> <dd>A copy of the worker's List_Error_Number, if it failed.</dd>
+ * <dt>Error_String</dt> <dd>A copy of the worker's List_Error_String, if it failed.</dd>
+ * </dl>
+ * @see #List_Parallel_Struct
+ */
+struct List_Worker_Struct
+{
+	pthread_t Thread;
+	struct List_Parallel_Struct *Parallel;
+	char *Bucket_Name;
+	char *Prefix;
+	char *Start_Offset;
+	char *End_Offset;
+	int Page_Size;
+	int Return_Value;
+	int Error_Number;
+	char Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread, as parallel listings
+ * call GCP_Client_List from several threads at once.
+ */
+static thread_local int List_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char List_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static int List_Parallel_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+				  void *user_data);
+static void *List_Parallel_Thread(void *arg);
+static unsigned int List_CRC32C_Decode(const std::string &crc32c_string);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Routine to list the objects in a bucket. Objects are retrieved from the cloud a page at a time, copied into
+ * a page buffer of page_size compact metadata structures, and passed to the callback, so the memory used
+ * does not depend on the number of objects listed. Objects are returned in lexicographical name order.
+ * @param bucket_name The name of the bucket.
+ * @param prefix Only list objects whose names start with this prefix. Can be NULL to list all objects.
+ * @param delimiter If not NULL, a delimiter (usually "/") used to emulate directories. Objects whose names
+ *        contain the delimiter after the prefix are not returned, instead each common prefix up to and including
+ *        the delimiter is returned once with Is_Prefix set.
+ * @param start_offset If not NULL, only list objects whose names are lexicographically equal to or after this.
+ * @param end_offset If not NULL, only list objects whose names are lexicographically before this.
+ * @param page_size The number of objects to pass to each call of the callback (and to ask for in each
+ *        request to the cloud). If 0, GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE is used.
+ * @param callback The function to call with each page of objects. It should return TRUE to continue the listing,
+ *        and FALSE to stop it. Stopping the listing early is not an error.
+ * @param user_data A pointer passed unaltered to each call of the callback.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, List_Error_Number /
+ *         List_Error_String should contain details of the failure.
+ * @see #GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE
+ * @see #GCP_Client_List_Metadata_Copy
+ * @see #List_Error_Number
+ * @see #List_Error_String
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_List(char *bucket_name,char *prefix,char *delimiter,char *start_offset,char *end_offset,
+		    int page_size,GCP_Client_List_Callback_T callback,void *user_data)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	gcs::Prefix prefix_option;
+	gcs::Delimiter delimiter_option;
+	gcs::StartOffset start_offset_option;
+	gcs::EndOffset end_offset_option;
+	struct GCP_Client_Object_Metadata_Struct *page_list = NULL;
+	struct timespec start_time,trace_start_time;
+	unsigned long long object_count;
+	int page_count,done;
+
+	List_Error_Number = 0;
+	if(bucket_name == NULL)
+	{
+		List_Error_Number = 1;
+		sprintf(List_Error_String,"GCP_Client_List: bucket_name was NULL.");
+		return FALSE;
+	}
+	if(callback == NULL)
+	{
+		List_Error_Number = 2;
+		sprintf(List_Error_String,"GCP_Client_List: callback was NULL.");
+		return FALSE;
+	}
+	if(page_size < 0)
+	{
+		List_Error_Number = 3;
+		sprintf(List_Error_String,"GCP_Client_List: page_size %d was negative.",page_size);
+		return FALSE;
+	}
+	if(page_size == 0)
+		page_size = GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE;
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_LIST,LOG_VERBOSITY_TERSE,
+				      "GCP_Client_List(bucket=%s,prefix=%s,delimiter=%s,start_offset=%s,end_offset=%s,"
+				      "page_size=%d):Started.",bucket_name,(prefix != NULL) ? prefix : "NULL",
+				      (delimiter != NULL) ? delimiter : "NULL",
+				      (start_offset != NULL) ? start_offset : "NULL",
+				      (end_offset != NULL) ? end_offset : "NULL",page_size);
+#endif
+	page_list = (struct GCP_Client_Object_Metadata_Struct *)malloc(page_size*
+								sizeof(struct GCP_Client_Object_Metadata_Struct));
+	if(page_list == NULL)
+	{
+		List_Error_Number = 4;
+		sprintf(List_Error_String,"GCP_Client_List: Failed to allocate page of %d objects.",page_size);
+		return FALSE;
+	}
+	/* unset options are default constructed, and are not sent to the server */
+	if(prefix != NULL)
+		prefix_option = gcs::Prefix(prefix);
+	if(delimiter != NULL)
+		delimiter_option = gcs::Delimiter(delimiter);
+	if(start_offset != NULL)
+		start_offset_option = gcs::StartOffset(start_offset);
+	if(end_offset != NULL)
+		end_offset_option = gcs::EndOffset(end_offset);
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	object_count = 0;
+	page_count = 0;
+	done = FALSE;
+	/* The readers fetch the next page from the server when the previous one has been iterated over,
+	** so only one page of metadata is held at a time. */
+	if(delimiter != NULL)
+	{
+		for(auto&& item : client.ListObjectsAndPrefixes(bucket_name,prefix_option,delimiter_option,
+								start_offset_option,end_offset_option,
+								gcs::MaxResults(page_size)))
+		{
+			if(!item)
+			{
+				List_Error_Number = 5;
+				sprintf(List_Error_String,"GCP_Client_List: Failed to list bucket '%s' "
+					"with status '%s'.",bucket_name,item.status().message().c_str());
+				free(page_list);
+				GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_LIST,start_time,0,FALSE);
+				GCP_Client_Trace_Span_End("list",bucket_name,prefix,&trace_start_time,0,FALSE);
+				return FALSE;
+			}
+			if(absl::holds_alternative<gcs::ObjectMetadata>(*item))
+			{
+				GCP_Client_List_Metadata_Copy(absl::get<gcs::ObjectMetadata>(*item),&(page_list[page_count]));
+			}
+			else
+			{
+				memset(&(page_list[page_count]),0,sizeof(struct GCP_Client_Object_Metadata_Struct));
+				strncpy(page_list[page_count].Name,absl::get<std::string>(*item).c_str(),
+					GCP_CLIENT_LIST_NAME_LENGTH);
+				page_list[page_count].Is_Prefix = TRUE;
+			}
+			page_count++;
+			object_count++;
+			if(page_count == page_size)
+			{
+				done = (callback(page_list,page_count,user_data) == FALSE);
+				page_count = 0;
+				if(done)
+					break;
+			}
+		}
+	}
+	else
+	{
+		for(auto&& object_metadata : client.ListObjects(bucket_name,prefix_option,start_offset_option,
+								end_offset_option,gcs::MaxResults(page_size)))
+		{
+			if(!object_metadata)
+			{
+				List_Error_Number = 5;
+				sprintf(List_Error_String,"GCP_Client_List: Failed to list bucket '%s' "
+					"with status '%s'.",bucket_name,object_metadata.status().message().c_str());
+				free(page_list);
+				GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_LIST,start_time,0,FALSE);
+				GCP_Client_Trace_Span_End("list",bucket_name,prefix,&trace_start_time,0,FALSE);
+				return FALSE;
+			}
+			GCP_Client_List_Metadata_Copy(*object_metadata,&(page_list[page_count]));
+			page_count++;
+			object_count++;
+			if(page_count == page_size)
+			{
+				done = (callback(page_list,page_count,user_data) == FALSE);
+				page_count = 0;
+				if(done)
+					break;
+			}
+		}
+	}
+	/* pass on the last partial page */
+	if((done == FALSE)&&(page_count > 0))
+		callback(page_list,page_count,user_data);
+	free(page_list);
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_LIST,start_time,0,TRUE);
+	GCP_Client_Trace_Span_End("list",bucket_name,prefix,&trace_start_time,0,TRUE);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_LIST,LOG_VERBOSITY_TERSE,
+				      "GCP_Client_List(bucket=%s):Finished after listing %llu objects%s.",
+				      bucket_name,object_count,done ? " (stopped by callback)" : "");
+#endif
+	return TRUE;
+}
+
+/**
+ * Routine to list the objects in a bucket in parallel. The name space is split into disjoint ranges
+ * at the supplied boundaries: [start,boundary_list[0]), [boundary_list[0],boundary_list[1]) ...
+ * [boundary_list[boundary_count-1],end), and each range is listed by GCP_Client_List in it's own thread.
+ * Calls to the callback are serialised (so it need not be re-entrant), but pages from different ranges
+ * arrive interleaved, so the objects are not returned in overall name order. If the callback returns FALSE
+ * all the ranges stop listing.
+ * @param bucket_name The name of the bucket.
+ * @param prefix Only list objects whose names start with this prefix. Can be NULL to list all objects.
+ * @param boundary_list A list of boundary_count object names, in ascending lexicographical order, to split the
+ *        listing at. For instance, for objects named by date, { "2023", "2024" }. Can be NULL if boundary_count is 0.
+ * @param boundary_count The number of boundaries. boundary_count+1 ranges are listed in parallel.
+ * @param page_size The number of objects to pass to each call of the callback.
+ *        If 0, GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE is used.
+ * @param callback The function to call with each page of objects.
+ * @param user_data A pointer passed unaltered to each call of the callback.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, List_Error_Number /
+ *         List_Error_String should contain details of the failure. If any range failed, the error of the
+ *         first failed range is reported.
+ * @see #GCP_Client_List
+ * @see #List_Parallel_Struct
+ * @see #List_Worker_Struct
+ * @see #List_Parallel_Thread
+ * @see #List_Error_Number
+ * @see #List_Error_String
+ */
+int GCP_Client_List_Parallel(char *bucket_name,char *prefix,char **boundary_list,int boundary_count,
+			     int page_size,GCP_Client_List_Callback_T callback,void *user_data)
+{
+	struct List_Parallel_Struct parallel;
+	struct List_Worker_Struct *worker_list = NULL;
+	int i,worker_count,started_count,retval,failed_index;
+
+	List_Error_Number = 0;
+	if(bucket_name == NULL)
+	{
+		List_Error_Number = 6;
+		sprintf(List_Error_String,"GCP_Client_List_Parallel: bucket_name was NULL.");
+		return FALSE;
+	}
+	if(callback == NULL)
+	{
+		List_Error_Number = 7;
+		sprintf(List_Error_String,"GCP_Client_List_Parallel: callback was NULL.");
+		return FALSE;
+	}
+	if(boundary_count < 0)
+	{
+		List_Error_Number = 8;
+		sprintf(List_Error_String,"GCP_Client_List_Parallel: boundary_count %d was negative.",boundary_count);
+		return FALSE;
+	}
+	if((boundary_count > 0)&&(boundary_list == NULL))
+	{
+		List_Error_Number = 9;
+		sprintf(List_Error_String,"GCP_Client_List_Parallel: boundary_list was NULL.");
+		return FALSE;
+	}
+	for(i = 0; i < boundary_count; i++)
+	{
+		if(boundary_list[i] == NULL)
+		{
+			List_Error_Number = 10;
+			sprintf(List_Error_String,"GCP_Client_List_Parallel: boundary_list[%d] was NULL.",i);
+			return FALSE;
+		}
+		if((i > 0)&&(strcmp(boundary_list[i-1],boundary_list[i]) >= 0))
+		{
+			List_Error_Number = 11;
+			snprintf(List_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_List_Parallel: boundary_list[%d] '%s' was not after boundary_list[%d] '%s'.",
+				 i,boundary_list[i],i-1,boundary_list[i-1]);
+			return FALSE;
+		}
+	}
+	worker_count = boundary_count+1;
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_LIST,LOG_VERBOSITY_TERSE,
+				      "GCP_Client_List_Parallel(bucket=%s,prefix=%s):Started listing %d ranges.",
+				      bucket_name,(prefix != NULL) ? prefix : "NULL",worker_count);
+#endif
+	worker_list = (struct List_Worker_Struct *)malloc(worker_count*sizeof(struct List_Worker_Struct));
+	if(worker_list == NULL)
+	{
+		List_Error_Number = 12;
+		sprintf(List_Error_String,"GCP_Client_List_Parallel: Failed to allocate %d workers.",worker_count);
+		return FALSE;
+	}
+	pthread_mutex_init(&(parallel.Mutex),NULL);
+	parallel.Callback = callback;
+	parallel.User_Data = user_data;
+	parallel.Stop = FALSE;
+	started_count = 0;
+	for(i = 0; i < worker_count; i++)
+	{
+		worker_list[i].Parallel = &parallel;
+		worker_list[i].Bucket_Name = bucket_name;
+		worker_list[i].Prefix = prefix;
+		if(i > 0)
+			worker_list[i].Start_Offset = boundary_list[i-1];
+		else
+			worker_list[i].Start_Offset = NULL;
+		if(i < boundary_count)
+			worker_list[i].End_Offset = boundary_list[i];
+		else
+			worker_list[i].End_Offset = NULL;
+		worker_list[i].Page_Size = page_size;
+		worker_list[i].Return_Value = FALSE;
+		worker_list[i].Error_Number = 0;
+		worker_list[i].Error_String[0] = '\0';
+		retval = pthread_create(&(worker_list[i].Thread),NULL,List_Parallel_Thread,&(worker_list[i]));
+		if(retval != 0)
+		{
+			List_Error_Number = 13;
+			sprintf(List_Error_String,"GCP_Client_List_Parallel: Failed to create worker thread %d (%d).",
+				i,retval);
+			break;
+		}
+		started_count++;
+	}
+	/* if we failed to start all the threads, stop the ones that did start */
+	if(started_count < worker_count)
+		parallel.Stop = TRUE;
+	failed_index = -1;
+	for(i = 0; i < started_count; i++)
+	{
+		pthread_join(worker_list[i].Thread,NULL);
+		if((worker_list[i].Return_Value == FALSE)&&(failed_index < 0))
+			failed_index = i;
+	}
+	pthread_mutex_destroy(&(parallel.Mutex));
+	if(started_count < worker_count)
+	{
+		free(worker_list);
+		return FALSE;
+	}
+	if(failed_index >= 0)
+	{
+		List_Error_Number = 14;
+		snprintf(List_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_List_Parallel: Range %d failed:Error(%d) : %s",failed_index,
+			 worker_list[failed_index].Error_Number,worker_list[failed_index].Error_String);
+		free(worker_list);
+		return FALSE;
+	}
+	free(worker_list);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_LIST,LOG_VERBOSITY_TERSE,
+				      "GCP_Client_List_Parallel(bucket=%s):Finished.",bucket_name);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_list error number.
+ * @return The current value of the gcp_client_list error number.
+ * @see #List_Error_Number
+ */
+int GCP_Client_List_Get_Error_Number(void)
+{
+	return List_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #List_Error_Number
+ * @see #List_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_List_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(List_Error_Number == 0)
+		sprintf(List_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_List:Error(%d) : %s\n",time_string,List_Error_Number,List_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #List_Error_Number
+ * @see #List_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_List_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(List_Error_Number == 0)
+		sprintf(List_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_List:Error(%d) : %s\n",time_string,
+		List_Error_Number,List_Error_String);
+}
+
+/**
+ * Copy the parts of a google-cloud-cpp object metadata we are interested in into a compact metadata structure.
+ * This is c++ only, and is declared in gcp_client_list_private.h so other modules returning object metadata
+ * can use it.
+ * @param object_metadata The google-cloud-cpp object metadata to copy.
+ * @param metadata The address of the compact metadata structure to fill in.
+ * @see #GCP_CLIENT_LIST_NAME_LENGTH
+ * @see #List_CRC32C_Decode
+ */
+void GCP_Client_List_Metadata_Copy(const ::google::cloud::storage::ObjectMetadata &object_metadata,
+				   struct GCP_Client_Object_Metadata_Struct *metadata)
+{
+	long long updated_ns;
+
+	strncpy(metadata->Name,object_metadata.name().c_str(),GCP_CLIENT_LIST_NAME_LENGTH);
+	metadata->Name[GCP_CLIENT_LIST_NAME_LENGTH] = '\0';
+	metadata->Size = object_metadata.size();
+	metadata->Generation = object_metadata.generation();
+	metadata->CRC32C = List_CRC32C_Decode(object_metadata.crc32c());
+	metadata->Is_Prefix = FALSE;
+	updated_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		object_metadata.updated().time_since_epoch()).count();
+	metadata->Updated.tv_sec = updated_ns/GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+	metadata->Updated.tv_nsec = updated_ns%GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Callback used by the worker threads of a parallel listing. This serialises calls to the caller's callback,
+ * and tells the other workers to stop if the caller's callback returns FALSE.
+ * @param object_list The page of objects.
+ * @param object_count The number of objects in the page.
+ * @param user_data A pointer to the List_Parallel_Struct shared by the workers.
+ * @return TRUE to continue listing, FALSE to stop.
+ * @see #List_Parallel_Struct
+ */
+static int List_Parallel_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+				  void *user_data)
+{
+	struct List_Parallel_Struct *parallel = (struct List_Parallel_Struct *)user_data;
+	int retval;
+
+	if(parallel->Stop)
+		return FALSE;
+	pthread_mutex_lock(&(parallel->Mutex));
+	/* re-check, another worker's callback may have stopped the listing whilst we waited */
+	if(parallel->Stop)
+		retval = FALSE;
+	else
+		retval = parallel->Callback(object_list,object_count,parallel->User_Data);
+	if(retval == FALSE)
+		parallel->Stop = TRUE;
+	pthread_mutex_unlock(&(parallel->Mutex));
+	return retval;
+}
+
+/**
+ * The thread function of one worker of a parallel listing. This calls GCP_Client_List on the worker's
+ * name range, and copies any error out of the thread's (thread local) error variables into the worker structure.
+ * @param arg A pointer to the worker's List_Worker_Struct.
+ * @return NULL.
+ * @see #List_Worker_Struct
+ * @see #List_Parallel_Callback
+ * @see #GCP_Client_List
+ */
+static void *List_Parallel_Thread(void *arg)
+{
+	struct List_Worker_Struct *worker = (struct List_Worker_Struct *)arg;
+
+	worker->Return_Value = GCP_Client_List(worker->Bucket_Name,worker->Prefix,NULL,worker->Start_Offset,
+					       worker->End_Offset,worker->Page_Size,List_Parallel_Callback,
+					       worker->Parallel);
+	if(worker->Return_Value == FALSE)
+	{
+		worker->Error_Number = List_Error_Number;
+		strncpy(worker->Error_String,List_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1);
+		worker->Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1] = '\0';
+		worker->Parallel->Stop = TRUE;
+	}
+	return NULL;
+}
+
+/**
+ * Decode a CRC32C checksum, as returned in google-cloud-cpp object metadata (the base64 encoding of the
+ * big-endian 4 byte checksum), into an unsigned integer.
+ * @param crc32c_string The base64 encoded checksum.
+ * @return The checksum. 0 is returned if the string is empty or cannot be decoded.
+ */
+static unsigned int List_CRC32C_Decode(const std::string &crc32c_string)
+{
+	const char *base64_alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	const char *ch_ptr = NULL;
+	unsigned long long bits;
+	int i,bit_count;
+
+	bits = 0;
+	bit_count = 0;
+	for(i = 0; (i < (int)crc32c_string.length())&&(crc32c_string[i] != '='); i++)
+	{
+		ch_ptr = strchr(base64_alphabet,crc32c_string[i]);
+		if((ch_ptr == NULL)||(crc32c_string[i] == '\0'))
+			return 0;
+		bits = (bits << 6)|(ch_ptr-base64_alphabet);
+		bit_count += 6;
+	}
+	/* 4 bytes are encoded in 6 base64 characters (36 bits), the bottom 4 bits are padding */
+	if(bit_count < 32)
+		return 0;
+	return (unsigned int)((bits >> (bit_count-32))&0xffffffff);
+}
@@ -0,0 +1,550 @@
+/* gcp_client_log_udp.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Batched UDP log handler.
+*/
+/**
+ * A log handler that coalesces log messages into batched UDP datagrams, sent to a log server by a background
+ * thread. The handler itself only copies the message into a batch buffer, it never waits for network I/O.
+ * Batches are sent when they are full, or when the oldest message in them has waited flush_ms milliseconds.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "gcp_client_general.h"
+#include "gcp_client_log_udp.h"
+
+/* defines */
+/**
+ * The maximum length of a UDP datagram payload over IPv4.
+ */
+#define LOG_UDP_MAX_DATAGRAM_LENGTH    (65507)
+/**
+ * The number of bytes in each datagram reserved for the batch header line.
+ * @see gcp_client_log_udp.html#GCP_CLIENT_LOG_UDP_DATAGRAM_HEADER
+ */
+#define LOG_UDP_HEADER_LENGTH          (80)
+/**
+ * The maximum length of a single log line in a batch. Longer messages are truncated.
+ */
+#define LOG_UDP_LINE_LENGTH            (4096)
+
+/* data types */
+/**
+ * Data type holding local data to gcp_client_log_udp. Log lines are appended to the fill buffer by
+ * GCP_Client_Log_UDP_Handler. When the fill buffer is full or has been waiting long enough, it is swapped with
+ * the (empty) send buffer and the sender thread transmits it. This consists of the following:
+ * <dl>
+ * <dt>Socket_Fd</dt> <dd>The connected UDP socket, or -1 if not open.</dd>
+ * <dt>Datagram_Length</dt> <dd>The maximum length of a datagram, in bytes.</dd>
+ * <dt>Flush_MS</dt> <dd>The maximum time a message waits in the fill buffer, in milliseconds.</dd>
+ * <dt>Thread</dt> <dd>The sender thread.</dd>
+ * <dt>Mutex</dt> <dd>Protects all the following fields. It is only ever held for the length of a memcpy.</dd>
+ * <dt>Condition</dt> <dd>Signalled to wake the sender thread.</dd>
+ * <dt>Fill_Buffer</dt> <dd>The buffer log lines are being appended to.</dd>
+ * <dt>Fill_Length</dt> <dd>The number of bytes used in Fill_Buffer.</dd>
+ * <dt>Fill_Count</dt> <dd>The number of log lines in Fill_Buffer.</dd>
+ * <dt>Fill_First_Sequence</dt> <dd>The sequence number of the first log line in Fill_Buffer.</dd>
+ * <dt>Fill_Start_Time</dt> <dd>When the first log line was appended to Fill_Buffer.</dd>
+ * <dt>Send_Buffer</dt> <dd>The buffer being transmitted by the sender thread.</dd>
+ * <dt>Send_Length</dt> <dd>The number of bytes used in Send_Buffer.</dd>
+ * <dt>Send_Count</dt> <dd>The number of log lines in Send_Buffer.</dd>
+ * <dt>Send_First_Sequence</dt> <dd>The sequence number of the first log line in Send_Buffer.</dd>
+ * <dt>Send_Pending</dt> <dd>TRUE when Send_Buffer contains a batch the sender thread has not yet sent.</dd>
+ * <dt>Stop</dt> <dd>Set to TRUE to ask the sender thread to send any remaining lines and exit.</dd>
+ * <dt>Next_Sequence</dt> <dd>The sequence number to give the next log message. Dropped messages consume a
+ *     sequence number, so the receiver can see where they were.</dd>
+ * <dt>Message_Count</dt> <dd>The number of messages passed to the handler.</dd>
+ * <dt>Sent_Count</dt> <dd>The number of messages in successfully sent datagrams.</dd>
+ * <dt>Dropped_Count</dt> <dd>The number of messages dropped, because both buffers were full or the send failed.</dd>
+ * <dt>Datagram_Count</dt> <dd>The number of datagrams successfully sent.</dd>
+ * </dl>
+ */
+struct Log_UDP_Struct
+{
+	int Socket_Fd;
+	int Datagram_Length;
+	int Flush_MS;
+	pthread_t Thread;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Condition;
+	char *Fill_Buffer;
+	int Fill_Length;
+	int Fill_Count;
+	unsigned long long Fill_First_Sequence;
+	struct timespec Fill_Start_Time;
+	char *Send_Buffer;
+	int Send_Length;
+	int Send_Count;
+	unsigned long long Send_First_Sequence;
+	int Send_Pending;
+	int Stop;
+	unsigned long long Next_Sequence;
+	unsigned long long Message_Count;
+	unsigned long long Sent_Count;
+	unsigned long long Dropped_Count;
+	unsigned long long Datagram_Count;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The instance of Log_UDP_Struct that contains local data for this module.
+ * The Mutex and Condition are statically initialised, Socket_Fd to -1 (not open), the buffers to NULL, and
+ * everything else to 0.
+ * @see #Log_UDP_Struct
+ */
+static struct Log_UDP_Struct Log_UDP_Data =
+{
+	-1,0,0,0,PTHREAD_MUTEX_INITIALIZER,PTHREAD_COND_INITIALIZER,
+	NULL,0,0,0ULL,{0,0},
+	NULL,0,0,0ULL,FALSE,FALSE,
+	0ULL,0ULL,0ULL,0ULL,0ULL
+};
+/**
+ * Variable holding error code of last operation performed.
+ */
+static int Log_UDP_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static char Log_UDP_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static void Log_UDP_Swap_Buffers(void);
+static void *Log_UDP_Thread(void *arg);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Open a UDP socket to the specified log server, and start the sender thread. Once this has succeeded,
+ * GCP_Client_Log_UDP_Handler can be passed to GCP_Client_General_Set_Log_Handler_Function.
+ * @param hostname The hostname or IP address of the log server.
+ * @param port_number The UDP port number of the log server.
+ * @param datagram_length The maximum length of a batched datagram in bytes,
+ *        or 0 to use GCP_CLIENT_LOG_UDP_DEFAULT_DATAGRAM_LENGTH.
+ * @param flush_ms The maximum length of time a message can wait in a partly filled batch, in milliseconds,
+ *        or 0 to use GCP_CLIENT_LOG_UDP_DEFAULT_FLUSH_MS.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Log_UDP_Error_Number /
+ *         Log_UDP_Error_String should contain details of the failure.
+ * @see #Log_UDP_Data
+ * @see #Log_UDP_Thread
+ * @see #LOG_UDP_HEADER_LENGTH
+ * @see #LOG_UDP_MAX_DATAGRAM_LENGTH
+ * @see gcp_client_log_udp.html#GCP_CLIENT_LOG_UDP_DEFAULT_DATAGRAM_LENGTH
+ * @see gcp_client_log_udp.html#GCP_CLIENT_LOG_UDP_DEFAULT_FLUSH_MS
+ */
+int GCP_Client_Log_UDP_Open(const char *hostname,int port_number,int datagram_length,int flush_ms)
+{
+	struct addrinfo hints;
+	struct addrinfo *address_list = NULL;
+	char port_string[16];
+	int retval,socket_errno;
+
+	Log_UDP_Error_Number = 0;
+	if(hostname == NULL)
+	{
+		Log_UDP_Error_Number = 1;
+		sprintf(Log_UDP_Error_String,"GCP_Client_Log_UDP_Open:hostname was NULL.");
+		return FALSE;
+	}
+	if(Log_UDP_Data.Socket_Fd >= 0)
+	{
+		Log_UDP_Error_Number = 2;
+		sprintf(Log_UDP_Error_String,"GCP_Client_Log_UDP_Open:Already open.");
+		return FALSE;
+	}
+	if(datagram_length == 0)
+		datagram_length = GCP_CLIENT_LOG_UDP_DEFAULT_DATAGRAM_LENGTH;
+	if(flush_ms == 0)
+		flush_ms = GCP_CLIENT_LOG_UDP_DEFAULT_FLUSH_MS;
+	if((datagram_length <= (LOG_UDP_HEADER_LENGTH*2))||(datagram_length > LOG_UDP_MAX_DATAGRAM_LENGTH))
+	{
+		Log_UDP_Error_Number = 3;
+		sprintf(Log_UDP_Error_String,"GCP_Client_Log_UDP_Open:Illegal datagram length %d.",datagram_length);
+		return FALSE;
+	}
+	memset(&hints,0,sizeof(struct addrinfo));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	sprintf(port_string,"%d",port_number);
+	retval = getaddrinfo(hostname,port_string,&hints,&address_list);
+	if(retval != 0)
+	{
+		Log_UDP_Error_Number = 4;
+		snprintf(Log_UDP_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Log_UDP_Open:Failed to resolve '%s' (%s).",hostname,gai_strerror(retval));
+		return FALSE;
+	}
+	Log_UDP_Data.Socket_Fd = socket(address_list->ai_family,address_list->ai_socktype,address_list->ai_protocol);
+	if(Log_UDP_Data.Socket_Fd < 0)
+	{
+		socket_errno = errno;
+		freeaddrinfo(address_list);
+		Log_UDP_Error_Number = 5;
+		sprintf(Log_UDP_Error_String,"GCP_Client_Log_UDP_Open:Failed to create socket (%d).",socket_errno);
+		return FALSE;
+	}
+	retval = connect(Log_UDP_Data.Socket_Fd,address_list->ai_addr,address_list->ai_addrlen);
+	freeaddrinfo(address_list);
+	if(retval != 0)
+	{
+		socket_errno = errno;
+		close(Log_UDP_Data.Socket_Fd);
+		Log_UDP_Data.Socket_Fd = -1;
+		Log_UDP_Error_Number = 6;
+		snprintf(Log_UDP_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Log_UDP_Open:Failed to connect socket to '%s:%d' (%d).",hostname,port_number,
+			 socket_errno);
+		return FALSE;
+	}
+	pthread_mutex_lock(&(Log_UDP_Data.Mutex));
+	Log_UDP_Data.Datagram_Length = datagram_length;
+	Log_UDP_Data.Flush_MS = flush_ms;
+	Log_UDP_Data.Fill_Buffer = (char*)malloc(datagram_length);
+	Log_UDP_Data.Send_Buffer = (char*)malloc(datagram_length);
+	Log_UDP_Data.Fill_Length = 0;
+	Log_UDP_Data.Fill_Count = 0;
+	Log_UDP_Data.Send_Length = 0;
+	Log_UDP_Data.Send_Count = 0;
+	Log_UDP_Data.Send_Pending = FALSE;
+	Log_UDP_Data.Stop = FALSE;
+	pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+	if((Log_UDP_Data.Fill_Buffer == NULL)||(Log_UDP_Data.Send_Buffer == NULL))
+	{
+		GCP_Client_Log_UDP_Close();
+		Log_UDP_Error_Number = 7;
+		sprintf(Log_UDP_Error_String,"GCP_Client_Log_UDP_Open:Failed to allocate batch buffers of length %d.",
+			datagram_length);
+		return FALSE;
+	}
+	retval = pthread_create(&(Log_UDP_Data.Thread),NULL,Log_UDP_Thread,NULL);
+	if(retval != 0)
+	{
+		close(Log_UDP_Data.Socket_Fd);
+		Log_UDP_Data.Socket_Fd = -1;
+		free(Log_UDP_Data.Fill_Buffer);
+		free(Log_UDP_Data.Send_Buffer);
+		Log_UDP_Data.Fill_Buffer = NULL;
+		Log_UDP_Data.Send_Buffer = NULL;
+		Log_UDP_Error_Number = 8;
+		sprintf(Log_UDP_Error_String,"GCP_Client_Log_UDP_Open:Failed to create sender thread (%d).",retval);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * A log handler to be used for the General_Data.Log_Handler function (see
+ * GCP_Client_General_Set_Log_Handler_Function). The message is timestamped (with the time it was logged,
+ * see GCP_Client_General_Get_Log_Time_String), given a sequence number, and appended to the current batch.
+ * If the batch is full and the sender thread is idle, the batches are swapped and the sender thread woken.
+ * If the sender thread is still busy sending the previous batch, the message is dropped and counted as such.
+ * This routine does no network I/O, and only holds a mutex for the length of a memcpy.
+ * @param level The log level for this message.
+ * @param string The log message to be logged.
+ * @see #Log_UDP_Data
+ * @see #Log_UDP_Swap_Buffers
+ * @see #LOG_UDP_LINE_LENGTH
+ * @see #LOG_UDP_HEADER_LENGTH
+ * @see gcp_client_general.html#GCP_Client_General_Get_Log_Time_String
+ */
+void GCP_Client_Log_UDP_Handler(int level,const char *string)
+{
+	char line[LOG_UDP_LINE_LENGTH];
+	char sequence_string[32];
+	char time_string[32];
+	int line_length,sequence_length,capacity;
+
+	if(string == NULL)
+		return;
+	if(Log_UDP_Data.Socket_Fd < 0)
+		return;
+	GCP_Client_General_Get_Log_Time_String(time_string,32);
+	line_length = snprintf(line,LOG_UDP_LINE_LENGTH,"%d %s %s\n",level,time_string,string);
+	pthread_mutex_lock(&(Log_UDP_Data.Mutex));
+	/* closing, or already closed */
+	if((Log_UDP_Data.Fill_Buffer == NULL)||(Log_UDP_Data.Stop))
+	{
+		pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+		return;
+	}
+	capacity = Log_UDP_Data.Datagram_Length-LOG_UDP_HEADER_LENGTH;
+	sequence_length = sprintf(sequence_string,"%llu ",Log_UDP_Data.Next_Sequence);
+	/* truncate over-long lines so they always fit in an empty batch */
+	if(line_length >= LOG_UDP_LINE_LENGTH)
+		line_length = LOG_UDP_LINE_LENGTH-1;
+	if((sequence_length+line_length) > capacity)
+		line_length = capacity-sequence_length;
+	line[line_length-1] = '\n';
+	Log_UDP_Data.Message_Count++;
+	if((Log_UDP_Data.Fill_Length+sequence_length+line_length) > capacity)
+	{
+		if(Log_UDP_Data.Send_Pending == FALSE)
+		{
+			Log_UDP_Swap_Buffers();
+			pthread_cond_signal(&(Log_UDP_Data.Condition));
+		}
+		else
+		{
+			/* both batches are full: drop rather than wait for the sender thread */
+			Log_UDP_Data.Next_Sequence++;
+			Log_UDP_Data.Dropped_Count++;
+			pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+			return;
+		}
+	}
+	if(Log_UDP_Data.Fill_Count == 0)
+	{
+		Log_UDP_Data.Fill_First_Sequence = Log_UDP_Data.Next_Sequence;
+		clock_gettime(CLOCK_REALTIME,&(Log_UDP_Data.Fill_Start_Time));
+		pthread_cond_signal(&(Log_UDP_Data.Condition));
+	}
+	memcpy(Log_UDP_Data.Fill_Buffer+Log_UDP_Data.Fill_Length,sequence_string,sequence_length);
+	memcpy(Log_UDP_Data.Fill_Buffer+Log_UDP_Data.Fill_Length+sequence_length,line,line_length);
+	Log_UDP_Data.Fill_Length += sequence_length+line_length;
+	Log_UDP_Data.Fill_Count++;
+	Log_UDP_Data.Next_Sequence++;
+	pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+}
+
+/**
+ * Close the log server connection. The sender thread sends any batched messages, and exits. The socket
+ * is then closed and the batch buffers freed. The statistics are not reset.
+ * The log handler should be changed from GCP_Client_Log_UDP_Handler before calling this routine, messages
+ * passed to the handler after this routine has started are discarded.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Log_UDP_Error_Number /
+ *         Log_UDP_Error_String should contain details of the failure.
+ * @see #Log_UDP_Data
+ * @see #Log_UDP_Thread
+ */
+int GCP_Client_Log_UDP_Close(void)
+{
+	int socket_fd,thread_started;
+
+	Log_UDP_Error_Number = 0;
+	if(Log_UDP_Data.Socket_Fd < 0)
+	{
+		Log_UDP_Error_Number = 9;
+		sprintf(Log_UDP_Error_String,"GCP_Client_Log_UDP_Close:Not open.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(Log_UDP_Data.Mutex));
+	Log_UDP_Data.Stop = TRUE;
+	/* the sender thread is only started once both buffers are allocated */
+	thread_started = ((Log_UDP_Data.Fill_Buffer != NULL)&&(Log_UDP_Data.Send_Buffer != NULL));
+	pthread_cond_signal(&(Log_UDP_Data.Condition));
+	pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+	if(thread_started)
+		pthread_join(Log_UDP_Data.Thread,NULL);
+	pthread_mutex_lock(&(Log_UDP_Data.Mutex));
+	socket_fd = Log_UDP_Data.Socket_Fd;
+	Log_UDP_Data.Socket_Fd = -1;
+	free(Log_UDP_Data.Fill_Buffer);
+	free(Log_UDP_Data.Send_Buffer);
+	Log_UDP_Data.Fill_Buffer = NULL;
+	Log_UDP_Data.Send_Buffer = NULL;
+	pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+	close(socket_fd);
+	return TRUE;
+}
+
+/**
+ * Retrieve the batched UDP log handler statistics. These accumulate over the life of the program.
+ * Any of the parameters can be NULL.
+ * @param message_count The address of an unsigned long long, filled with the number of messages passed
+ *        to the handler.
+ * @param sent_count The address of an unsigned long long, filled with the number of messages
+ *        in successfully sent datagrams.
+ * @param dropped_count The address of an unsigned long long, filled with the number of messages dropped,
+ *        either because the batch buffers were full, or because sending the datagram failed.
+ * @param datagram_count The address of an unsigned long long, filled with the number of datagrams
+ *        successfully sent.
+ * @see #Log_UDP_Data
+ */
+void GCP_Client_Log_UDP_Get_Statistics(unsigned long long *message_count,unsigned long long *sent_count,
+				       unsigned long long *dropped_count,unsigned long long *datagram_count)
+{
+	pthread_mutex_lock(&(Log_UDP_Data.Mutex));
+	if(message_count != NULL)
+		(*message_count) = Log_UDP_Data.Message_Count;
+	if(sent_count != NULL)
+		(*sent_count) = Log_UDP_Data.Sent_Count;
+	if(dropped_count != NULL)
+		(*dropped_count) = Log_UDP_Data.Dropped_Count;
+	if(datagram_count != NULL)
+		(*datagram_count) = Log_UDP_Data.Datagram_Count;
+	pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+}
+
+/**
+ * Routine to return the current value of the error number.
+ * @return The value of Log_UDP_Error_Number.
+ * @see #Log_UDP_Error_Number
+ */
+int GCP_Client_Log_UDP_Get_Error_Number(void)
+{
+	return Log_UDP_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Log_UDP_Error_Number
+ * @see #Log_UDP_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Log_UDP_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Log_UDP_Error_Number == 0)
+		sprintf(Log_UDP_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Log_UDP:Error(%d) : %s\n",time_string,
+		Log_UDP_Error_Number,Log_UDP_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Log_UDP_Error_Number
+ * @see #Log_UDP_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Log_UDP_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Log_UDP_Error_Number == 0)
+		sprintf(Log_UDP_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Log_UDP:Error(%d) : %s\n",time_string,
+		Log_UDP_Error_Number,Log_UDP_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Swap the fill and send buffers, and mark the send buffer as pending. Log_UDP_Data.Mutex must be held,
+ * and Log_UDP_Data.Send_Pending must be FALSE.
+ * @see #Log_UDP_Data
+ */
+static void Log_UDP_Swap_Buffers(void)
+{
+	char *buffer = NULL;
+
+	buffer = Log_UDP_Data.Send_Buffer;
+	Log_UDP_Data.Send_Buffer = Log_UDP_Data.Fill_Buffer;
+	Log_UDP_Data.Send_Length = Log_UDP_Data.Fill_Length;
+	Log_UDP_Data.Send_Count = Log_UDP_Data.Fill_Count;
+	Log_UDP_Data.Send_First_Sequence = Log_UDP_Data.Fill_First_Sequence;
+	Log_UDP_Data.Send_Pending = TRUE;
+	Log_UDP_Data.Fill_Buffer = buffer;
+	Log_UDP_Data.Fill_Length = 0;
+	Log_UDP_Data.Fill_Count = 0;
+}
+
+/**
+ * The sender thread. Waits until the handler has swapped a full batch into the send buffer, or until the
+ * first message in a partly filled batch has waited Log_UDP_Data.Flush_MS milliseconds (when it swaps the
+ * buffers itself). The batch is then sent as one datagram (a header line followed by the batched lines),
+ * with the mutex released. When Log_UDP_Data.Stop is set, any remaining batched lines are sent and the
+ * thread exits.
+ * @param arg Thread argument, not used.
+ * @return The routine returns NULL.
+ * @see #Log_UDP_Data
+ * @see #Log_UDP_Swap_Buffers
+ * @see gcp_client_log_udp.html#GCP_CLIENT_LOG_UDP_DATAGRAM_HEADER
+ */
+static void *Log_UDP_Thread(void *arg)
+{
+	struct iovec iov[2];
+	struct timespec deadline;
+	char header[LOG_UDP_HEADER_LENGTH];
+	unsigned long long first_sequence,dropped_count;
+	ssize_t send_retval;
+	int done,count,retval;
+
+	pthread_mutex_lock(&(Log_UDP_Data.Mutex));
+	done = FALSE;
+	while(done == FALSE)
+	{
+		while((Log_UDP_Data.Send_Pending == FALSE)&&(Log_UDP_Data.Stop == FALSE))
+		{
+			if(Log_UDP_Data.Fill_Count > 0)
+			{
+				deadline = Log_UDP_Data.Fill_Start_Time;
+				deadline.tv_sec += Log_UDP_Data.Flush_MS/GCP_CLIENT_GENERAL_ONE_SECOND_MS;
+				deadline.tv_nsec += (Log_UDP_Data.Flush_MS%GCP_CLIENT_GENERAL_ONE_SECOND_MS)*
+					GCP_CLIENT_GENERAL_ONE_MILLISECOND_NS;
+				if(deadline.tv_nsec >= GCP_CLIENT_GENERAL_ONE_SECOND_NS)
+				{
+					deadline.tv_sec++;
+					deadline.tv_nsec -= GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+				}
+				retval = pthread_cond_timedwait(&(Log_UDP_Data.Condition),&(Log_UDP_Data.Mutex),&deadline);
+				if((retval == ETIMEDOUT)&&(Log_UDP_Data.Send_Pending == FALSE)&&(Log_UDP_Data.Fill_Count > 0))
+					Log_UDP_Swap_Buffers();
+			}
+			else
+				pthread_cond_wait(&(Log_UDP_Data.Condition),&(Log_UDP_Data.Mutex));
+		}
+		if(Log_UDP_Data.Send_Pending == FALSE)
+		{
+			/* stopping: send whatever is left, then exit */
+			if(Log_UDP_Data.Fill_Count > 0)
+				Log_UDP_Swap_Buffers();
+			else
+			{
+				done = TRUE;
+				continue;
+			}
+		}
+		first_sequence = Log_UDP_Data.Send_First_Sequence;
+		count = Log_UDP_Data.Send_Count;
+		dropped_count = Log_UDP_Data.Dropped_Count;
+		iov[1].iov_base = Log_UDP_Data.Send_Buffer;
+		iov[1].iov_len = Log_UDP_Data.Send_Length;
+		pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+		/* send the batch without holding the mutex */
+		iov[0].iov_base = header;
+		iov[0].iov_len = snprintf(header,LOG_UDP_HEADER_LENGTH,"%s %llu %d %llu\n",
+					  GCP_CLIENT_LOG_UDP_DATAGRAM_HEADER,first_sequence,count,dropped_count);
+		send_retval = writev(Log_UDP_Data.Socket_Fd,iov,2);
+		pthread_mutex_lock(&(Log_UDP_Data.Mutex));
+		if(send_retval < 0)
+			Log_UDP_Data.Dropped_Count += count;
+		else
+		{
+			Log_UDP_Data.Sent_Count += count;
+			Log_UDP_Data.Datagram_Count++;
+		}
+		Log_UDP_Data.Send_Pending = FALSE;
+	}
+	pthread_mutex_unlock(&(Log_UDP_Data.Mutex));
+	return NULL;
+}
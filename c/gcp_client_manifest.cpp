@@ -0,0 +1,994 @@
+/* gcp_client_manifest.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Local bucket manifest routines.
+*/
+/**
+ * Routines to keep a local manifest (index) of the objects in a bucket, or part of a bucket, so the metadata
+ * of objects can be looked up, and ranges of objects scanned, without listing the bucket again.
+ * The manifest is a single file designed to be memory mapped read-only, laid out as follows:
+ * <ul>
+ * <li>A fixed size header (Manifest_Header_Struct).
+ * <li>Record_Count fixed size object records (Manifest_Record_Struct), sorted in ascending (byte) order of
+ *     object name, the same order as bucket listings.
+ * <li>A string table of the NULL terminated object names, referenced by offset from the records.
+ * </ul>
+ * Integers are stored in the native byte order of the machine that wrote the file, the header contains a byte
+ * order mark so a file from a machine of the other byte order is rejected. Lookups are a binary search of the
+ * records, and prefix scans a binary search followed by a sequential walk, neither touches the network.
+ * The manifest is refreshed by listing (part of) the bucket, and merging the listing with the existing
+ * manifest into a new file, which is renamed over the old one, so processes with the old manifest open
+ * (mapped) are unaffected.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_list.h"
+#include "gcp_client_manifest.h"
+
+/* defines */
+/**
+ * The magic string at the start of every manifest file.
+ */
+#define MANIFEST_MAGIC                 "GCPMANIF"
+/**
+ * The version of the manifest file format.
+ */
+#define MANIFEST_VERSION               (1)
+/**
+ * Byte order mark, written in native byte order. A manifest written on a machine of the other byte order
+ * will not match this.
+ */
+#define MANIFEST_BYTE_ORDER            (0x01020304)
+/**
+ * The length of the bucket name field in the manifest header.
+ */
+#define MANIFEST_BUCKET_NAME_LENGTH    (256)
+/**
+ * The size of the buffer used to copy the string table into the manifest file during a refresh.
+ */
+#define MANIFEST_COPY_BUFFER_LENGTH    (65536)
+
+/* data types */
+/**
+ * The header at the start of a manifest file. This consists of the following:
+ * <dl>
+ * <dt>Magic</dt> <dd>MANIFEST_MAGIC (not NULL terminated).</dd>
+ * <dt>Version</dt> <dd>MANIFEST_VERSION.</dd>
+ * <dt>Byte_Order</dt> <dd>MANIFEST_BYTE_ORDER.</dd>
+ * <dt>Record_Count</dt> <dd>The number of object records.</dd>
+ * <dt>Record_Offset</dt> <dd>The offset of the first object record from the start of the file.</dd>
+ * <dt>String_Table_Offset</dt> <dd>The offset of the string table from the start of the file.</dd>
+ * <dt>String_Table_Length</dt> <dd>The length of the string table in bytes.</dd>
+ * <dt>Refresh_Time</dt> <dd>When the manifest was last refreshed, in seconds since the epoch.</dd>
+ * <dt>Bucket_Name</dt> <dd>The name of the bucket the manifest indexes, NULL terminated.</dd>
+ * </dl>
+ * @see #MANIFEST_MAGIC
+ * @see #MANIFEST_VERSION
+ * @see #MANIFEST_BYTE_ORDER
+ * @see #MANIFEST_BUCKET_NAME_LENGTH
+ */
+struct Manifest_Header_Struct
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t Byte_Order;
+	uint64_t Record_Count;
+	uint64_t Record_Offset;
+	uint64_t String_Table_Offset;
+	uint64_t String_Table_Length;
+	int64_t Refresh_Time;
+	char Bucket_Name[MANIFEST_BUCKET_NAME_LENGTH];
+};
+
+/**
+ * The record held in a manifest file for each object. This consists of the following:
+ * <dl>
+ * <dt>Name_Offset</dt> <dd>The offset of the object's NULL terminated name in the string table.</dd>
+ * <dt>Size</dt> <dd>The size of the object in bytes.</dd>
+ * <dt>Generation</dt> <dd>The generation number of the object.</dd>
+ * <dt>Updated_Sec</dt> <dd>The seconds part of the object's update time.</dd>
+ * <dt>Updated_Nsec</dt> <dd>The nanoseconds part of the object's update time.</dd>
+ * <dt>Name_Length</dt> <dd>The length of the object's name (excluding the NULL terminator).</dd>
+ * <dt>CRC32C</dt> <dd>The CRC32C checksum of the object.</dd>
+ * <dt>Pad</dt> <dd>Padding, to make the record a multiple of 8 bytes long.</dd>
+ * </dl>
+ */
+struct Manifest_Record_Struct
+{
+	uint64_t Name_Offset;
+	uint64_t Size;
+	int64_t Generation;
+	int64_t Updated_Sec;
+	uint32_t Updated_Nsec;
+	uint32_t Name_Length;
+	uint32_t CRC32C;
+	uint32_t Pad;
+};
+
+/**
+ * An open manifest. This consists of the following:
+ * <dl>
+ * <dt>Fd</dt> <dd>The file descriptor of the open manifest file.</dd>
+ * <dt>Map_Address</dt> <dd>The address the manifest file is mapped at.</dd>
+ * <dt>Map_Length</dt> <dd>The length of the mapping (the file size).</dd>
+ * <dt>Header</dt> <dd>A pointer to the manifest header.</dd>
+ * <dt>Record_List</dt> <dd>A pointer to the first object record.</dd>
+ * <dt>String_Table</dt> <dd>A pointer to the string table.</dd>
+ * </dl>
+ */
+struct GCP_Client_Manifest_Struct
+{
+	int Fd;
+	void *Map_Address;
+	size_t Map_Length;
+	const struct Manifest_Header_Struct *Header;
+	const struct Manifest_Record_Struct *Record_List;
+	const char *String_Table;
+};
+
+/**
+ * Data type holding the state of a manifest refresh, passed to the listing callback.
+ * This consists of the following:
+ * <dl>
+ * <dt>Old_Manifest</dt> <dd>The existing manifest, or NULL if there was none.</dd>
+ * <dt>Old_Index</dt> <dd>The index of the next record of the existing manifest to merge.</dd>
+ * <dt>Prefix</dt> <dd>The prefix being refreshed, or NULL.</dd>
+ * <dt>Start_Offset</dt> <dd>The start of the name range being refreshed, or NULL.</dd>
+ * <dt>End_Offset</dt> <dd>The end of the name range being refreshed, or NULL.</dd>
+ * <dt>Record_Fp</dt> <dd>The new manifest file, records are written to it.</dd>
+ * <dt>String_Fp</dt> <dd>A temporary file the string table is written to.</dd>
+ * <dt>String_Table_Length</dt> <dd>The length of the string table written so far.</dd>
+ * <dt>Record_Count</dt> <dd>The number of records written so far.</dd>
+ * <dt>Last_Name</dt> <dd>The last object name written, to check the records are in order.</dd>
+ * <dt>Failed</dt> <dd>Set if writing the new manifest failed during the listing (Manifest_Error_Number is set).</dd>
+ * </dl>
+ */
+struct Manifest_Refresh_Struct
+{
+	struct GCP_Client_Manifest_Struct *Old_Manifest;
+	unsigned long long Old_Index;
+	char *Prefix;
+	char *Start_Offset;
+	char *End_Offset;
+	FILE *Record_Fp;
+	FILE *String_Fp;
+	unsigned long long String_Table_Length;
+	unsigned long long Record_Count;
+	char Last_Name[GCP_CLIENT_LIST_NAME_LENGTH+1];
+	int Failed;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread, an open manifest can be
+ * used from several threads at once.
+ */
+static thread_local int Manifest_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Manifest_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static int Manifest_Refresh_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+				     void *user_data);
+static int Manifest_Refresh_Merge_Old(struct Manifest_Refresh_Struct *refresh,const char *next_name);
+static int Manifest_Refresh_Write(struct Manifest_Refresh_Struct *refresh,
+				  const struct GCP_Client_Object_Metadata_Struct *metadata);
+static int Manifest_In_Range(const char *name,char *prefix,char *start_offset,char *end_offset);
+static void Manifest_Free(struct GCP_Client_Manifest_Struct *manifest);
+static const char *Manifest_Record_Name(struct GCP_Client_Manifest_Struct *manifest,unsigned long long index);
+static void Manifest_Record_To_Metadata(struct GCP_Client_Manifest_Struct *manifest,unsigned long long index,
+					struct GCP_Client_Object_Metadata_Struct *metadata);
+static int Manifest_Lower_Bound(struct GCP_Client_Manifest_Struct *manifest,const char *name,
+				unsigned long long *index);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Refresh (or create) a manifest file, by listing a range of a bucket and merging the listing with the existing
+ * manifest. Objects in the existing manifest inside the refreshed range are replaced by the listing (so deleted
+ * objects are removed), objects outside it are kept. Passing NULL for prefix, start_offset and end_offset refreshes
+ * the whole bucket. The new manifest is written to a temporary file and renamed over the old one, so the refresh
+ * is atomic, and manifests already open (mapped) by other processes remain valid (but are not updated).
+ * Memory use does not depend on the number of objects.
+ * @param filename The filename of the manifest. If it does not exist, it is created.
+ * @param bucket_name The name of the bucket. If the manifest already exists, it must index the same bucket.
+ * @param prefix Only refresh objects whose names start with this prefix. Can be NULL.
+ * @param start_offset Only refresh objects whose names are equal to or after this. Can be NULL.
+ * @param end_offset Only refresh objects whose names are before this. Can be NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Manifest_Error_Number /
+ *         Manifest_Error_String should contain details of the failure.
+ * @see #Manifest_Header_Struct
+ * @see #Manifest_Refresh_Struct
+ * @see #Manifest_Refresh_Callback
+ * @see #Manifest_Refresh_Merge_Old
+ * @see #MANIFEST_COPY_BUFFER_LENGTH
+ * @see #GCP_Client_Manifest_Open
+ * @see #Manifest_Free
+ * @see gcp_client_list.html#GCP_Client_List
+ */
+int GCP_Client_Manifest_Refresh(char *filename,char *bucket_name,char *prefix,char *start_offset,char *end_offset)
+{
+	struct Manifest_Refresh_Struct refresh;
+	struct Manifest_Header_Struct header;
+	char tmp_filename[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+	char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+	char copy_buffer[MANIFEST_COPY_BUFFER_LENGTH];
+	struct stat stat_buffer;
+	size_t read_length;
+
+	Manifest_Error_Number = 0;
+	if(filename == NULL)
+	{
+		Manifest_Error_Number = 1;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Refresh: filename was NULL.");
+		return FALSE;
+	}
+	if(bucket_name == NULL)
+	{
+		Manifest_Error_Number = 2;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Refresh: bucket_name was NULL.");
+		return FALSE;
+	}
+	if(strlen(bucket_name) >= MANIFEST_BUCKET_NAME_LENGTH)
+	{
+		Manifest_Error_Number = 3;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Refresh: bucket_name was too long (%ld).",
+			strlen(bucket_name));
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_MANIFEST,LOG_VERBOSITY_TERSE,
+				      "GCP_Client_Manifest_Refresh(filename=%s,bucket=%s,prefix=%s,start_offset=%s,"
+				      "end_offset=%s):Started.",filename,bucket_name,(prefix != NULL) ? prefix : "NULL",
+				      (start_offset != NULL) ? start_offset : "NULL",
+				      (end_offset != NULL) ? end_offset : "NULL");
+#endif
+	refresh.Old_Manifest = NULL;
+	refresh.Old_Index = 0;
+	refresh.Prefix = prefix;
+	refresh.Start_Offset = start_offset;
+	refresh.End_Offset = end_offset;
+	refresh.Record_Fp = NULL;
+	refresh.String_Fp = NULL;
+	refresh.String_Table_Length = 0;
+	refresh.Record_Count = 0;
+	refresh.Last_Name[0] = '\0';
+	refresh.Failed = FALSE;
+	/* open the existing manifest, if there is one */
+	if(stat(filename,&stat_buffer) == 0)
+	{
+		if(!GCP_Client_Manifest_Open(filename,&(refresh.Old_Manifest)))
+			return FALSE;
+		if(strcmp(refresh.Old_Manifest->Header->Bucket_Name,bucket_name) != 0)
+		{
+			Manifest_Error_Number = 4;
+			snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Manifest_Refresh: Manifest '%s' indexes bucket '%s' not '%s'.",
+				 filename,refresh.Old_Manifest->Header->Bucket_Name,bucket_name);
+			Manifest_Free(refresh.Old_Manifest);
+			return FALSE;
+		}
+	}
+	/* create the new manifest, with space for the header */
+	snprintf(tmp_filename,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,"%s.tmp.%d",filename,(int)getpid());
+	refresh.Record_Fp = fopen(tmp_filename,"w+b");
+	if(refresh.Record_Fp == NULL)
+	{
+		Manifest_Error_Number = 5;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Manifest_Refresh: Failed to create '%s' (%d).",tmp_filename,errno);
+		if(refresh.Old_Manifest != NULL)
+			Manifest_Free(refresh.Old_Manifest);
+		return FALSE;
+	}
+	refresh.String_Fp = tmpfile();
+	if(refresh.String_Fp == NULL)
+	{
+		Manifest_Error_Number = 6;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Refresh: Failed to create string table file (%d).",
+			errno);
+		fclose(refresh.Record_Fp);
+		unlink(tmp_filename);
+		if(refresh.Old_Manifest != NULL)
+			Manifest_Free(refresh.Old_Manifest);
+		return FALSE;
+	}
+	memset(&header,0,sizeof(struct Manifest_Header_Struct));
+	if(fwrite(&header,sizeof(struct Manifest_Header_Struct),1,refresh.Record_Fp) != 1)
+	{
+		Manifest_Error_Number = 7;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Manifest_Refresh: Failed to write header to '%s' (%d).",tmp_filename,errno);
+		refresh.Failed = TRUE;
+	}
+	/* list the range, merging in the old records as we go */
+	if(refresh.Failed == FALSE)
+	{
+		if(!GCP_Client_List(bucket_name,prefix,NULL,start_offset,end_offset,0,Manifest_Refresh_Callback,
+				    &refresh))
+		{
+			error_string[0] = '\0';
+			GCP_Client_List_Error_String(error_string);
+			Manifest_Error_Number = 8;
+			snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Manifest_Refresh: Failed to list bucket '%s':%s",bucket_name,error_string);
+			refresh.Failed = TRUE;
+		}
+	}
+	/* merge the old records after the last listed object */
+	if(refresh.Failed == FALSE)
+	{
+		if(!Manifest_Refresh_Merge_Old(&refresh,NULL))
+			refresh.Failed = TRUE;
+	}
+	if(refresh.Old_Manifest != NULL)
+		Manifest_Free(refresh.Old_Manifest);
+	/* append the string table to the records */
+	if(refresh.Failed == FALSE)
+	{
+		rewind(refresh.String_Fp);
+		while((read_length = fread(copy_buffer,1,MANIFEST_COPY_BUFFER_LENGTH,refresh.String_Fp)) > 0)
+		{
+			if(fwrite(copy_buffer,1,read_length,refresh.Record_Fp) != read_length)
+			{
+				Manifest_Error_Number = 9;
+				snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+					 "GCP_Client_Manifest_Refresh: Failed to write string table to '%s' (%d).",
+					 tmp_filename,errno);
+				refresh.Failed = TRUE;
+				break;
+			}
+		}
+	}
+	fclose(refresh.String_Fp);
+	/* fill in the header */
+	if(refresh.Failed == FALSE)
+	{
+		memcpy(header.Magic,MANIFEST_MAGIC,8);
+		header.Version = MANIFEST_VERSION;
+		header.Byte_Order = MANIFEST_BYTE_ORDER;
+		header.Record_Count = refresh.Record_Count;
+		header.Record_Offset = sizeof(struct Manifest_Header_Struct);
+		header.String_Table_Offset = header.Record_Offset+(refresh.Record_Count*
+								    sizeof(struct Manifest_Record_Struct));
+		header.String_Table_Length = refresh.String_Table_Length;
+		header.Refresh_Time = time(NULL);
+		strcpy(header.Bucket_Name,bucket_name);
+		if((fseek(refresh.Record_Fp,0,SEEK_SET) != 0)||
+		   (fwrite(&header,sizeof(struct Manifest_Header_Struct),1,refresh.Record_Fp) != 1)||
+		   (fflush(refresh.Record_Fp) != 0)||(fsync(fileno(refresh.Record_Fp)) != 0))
+		{
+			Manifest_Error_Number = 10;
+			snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Manifest_Refresh: Failed to write header to '%s' (%d).",tmp_filename,errno);
+			refresh.Failed = TRUE;
+		}
+	}
+	if((fclose(refresh.Record_Fp) != 0)&&(refresh.Failed == FALSE))
+	{
+		Manifest_Error_Number = 11;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Manifest_Refresh: Failed to close '%s' (%d).",tmp_filename,errno);
+		refresh.Failed = TRUE;
+	}
+	if(refresh.Failed)
+	{
+		unlink(tmp_filename);
+		return FALSE;
+	}
+	/* atomically replace the old manifest */
+	if(rename(tmp_filename,filename) != 0)
+	{
+		Manifest_Error_Number = 12;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Manifest_Refresh: Failed to rename '%s' to '%s' (%d).",tmp_filename,filename,errno);
+		unlink(tmp_filename);
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_MANIFEST,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Manifest_Refresh(filename=%s):Finished with %llu objects.",
+					     filename,refresh.Record_Count);
+#endif
+	return TRUE;
+}
+
+/**
+ * Open a manifest file, by memory mapping it read-only. Only the header is validated, so opening is quick
+ * regardless of the manifest size. The returned manifest can be used from several threads at once.
+ * @param filename The filename of the manifest.
+ * @param manifest The address of a manifest pointer, on success set to an allocated manifest, which should be
+ *        closed with GCP_Client_Manifest_Close.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Manifest_Error_Number /
+ *         Manifest_Error_String should contain details of the failure.
+ * @see #GCP_Client_Manifest_Struct
+ * @see #Manifest_Header_Struct
+ * @see #MANIFEST_MAGIC
+ * @see #MANIFEST_VERSION
+ * @see #MANIFEST_BYTE_ORDER
+ * @see #GCP_Client_Manifest_Close
+ */
+int GCP_Client_Manifest_Open(char *filename,struct GCP_Client_Manifest_Struct **manifest)
+{
+	struct GCP_Client_Manifest_Struct *new_manifest = NULL;
+	const struct Manifest_Header_Struct *header = NULL;
+	struct stat stat_buffer;
+
+	Manifest_Error_Number = 0;
+	if(filename == NULL)
+	{
+		Manifest_Error_Number = 13;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Open: filename was NULL.");
+		return FALSE;
+	}
+	if(manifest == NULL)
+	{
+		Manifest_Error_Number = 14;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Open: manifest was NULL.");
+		return FALSE;
+	}
+	new_manifest = (struct GCP_Client_Manifest_Struct *)malloc(sizeof(struct GCP_Client_Manifest_Struct));
+	if(new_manifest == NULL)
+	{
+		Manifest_Error_Number = 15;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Open: Failed to allocate manifest.");
+		return FALSE;
+	}
+	new_manifest->Fd = open(filename,O_RDONLY);
+	if(new_manifest->Fd < 0)
+	{
+		Manifest_Error_Number = 16;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Manifest_Open: Failed to open '%s' (%d).",filename,errno);
+		free(new_manifest);
+		return FALSE;
+	}
+	if((fstat(new_manifest->Fd,&stat_buffer) != 0)||
+	   (stat_buffer.st_size < (off_t)sizeof(struct Manifest_Header_Struct)))
+	{
+		Manifest_Error_Number = 17;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Manifest_Open: '%s' is too small to be a manifest.",filename);
+		close(new_manifest->Fd);
+		free(new_manifest);
+		return FALSE;
+	}
+	new_manifest->Map_Length = stat_buffer.st_size;
+	new_manifest->Map_Address = mmap(NULL,new_manifest->Map_Length,PROT_READ,MAP_SHARED,new_manifest->Fd,0);
+	if(new_manifest->Map_Address == MAP_FAILED)
+	{
+		Manifest_Error_Number = 18;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Manifest_Open: Failed to map '%s' (%d).",filename,errno);
+		close(new_manifest->Fd);
+		free(new_manifest);
+		return FALSE;
+	}
+	header = (const struct Manifest_Header_Struct *)(new_manifest->Map_Address);
+	if((memcmp(header->Magic,MANIFEST_MAGIC,8) != 0)||(header->Version != MANIFEST_VERSION)||
+	   (header->Byte_Order != MANIFEST_BYTE_ORDER)||
+	   (header->Record_Offset < sizeof(struct Manifest_Header_Struct))||
+	   (header->Record_Count > (new_manifest->Map_Length/sizeof(struct Manifest_Record_Struct)))||
+	   ((header->Record_Offset+(header->Record_Count*sizeof(struct Manifest_Record_Struct))) >
+	    header->String_Table_Offset)||
+	   (header->String_Table_Offset > new_manifest->Map_Length)||
+	   (header->String_Table_Length > (new_manifest->Map_Length-header->String_Table_Offset))||
+	   (memchr(header->Bucket_Name,'\0',MANIFEST_BUCKET_NAME_LENGTH) == NULL))
+	{
+		Manifest_Error_Number = 19;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Manifest_Open: '%s' is not a valid version %d manifest.",filename,MANIFEST_VERSION);
+		munmap(new_manifest->Map_Address,new_manifest->Map_Length);
+		close(new_manifest->Fd);
+		free(new_manifest);
+		return FALSE;
+	}
+	new_manifest->Header = header;
+	new_manifest->Record_List = (const struct Manifest_Record_Struct *)(((const char *)header)+
+									    header->Record_Offset);
+	new_manifest->String_Table = ((const char *)header)+header->String_Table_Offset;
+	/* lookups are binary searches, so don't read ahead */
+	madvise(new_manifest->Map_Address,new_manifest->Map_Length,MADV_RANDOM);
+	(*manifest) = new_manifest;
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_MANIFEST,LOG_VERBOSITY_VERY_VERBOSE,
+					     "GCP_Client_Manifest_Open(filename=%s):Opened manifest of bucket '%s' "
+					     "with %llu objects.",filename,header->Bucket_Name,
+					     (unsigned long long)header->Record_Count);
+#endif
+	return TRUE;
+}
+
+/**
+ * Close a manifest opened with GCP_Client_Manifest_Open, unmapping the file and freeing the manifest.
+ * @param manifest The address of the manifest pointer. The manifest pointer is set to NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Manifest_Error_Number /
+ *         Manifest_Error_String should contain details of the failure.
+ * @see #GCP_Client_Manifest_Open
+ * @see #Manifest_Free
+ */
+int GCP_Client_Manifest_Close(struct GCP_Client_Manifest_Struct **manifest)
+{
+	Manifest_Error_Number = 0;
+	if((manifest == NULL)||((*manifest) == NULL))
+	{
+		Manifest_Error_Number = 20;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Close: manifest was NULL.");
+		return FALSE;
+	}
+	Manifest_Free((*manifest));
+	(*manifest) = NULL;
+	return TRUE;
+}
+
+/**
+ * Get the number of objects in a manifest.
+ * @param manifest The open manifest.
+ * @return The number of objects in the manifest, or 0 if manifest is NULL.
+ */
+unsigned long long GCP_Client_Manifest_Get_Object_Count(struct GCP_Client_Manifest_Struct *manifest)
+{
+	if(manifest == NULL)
+		return 0;
+	return manifest->Header->Record_Count;
+}
+
+/**
+ * Get the name of the bucket a manifest indexes.
+ * @param manifest The open manifest.
+ * @return The bucket name (part of the mapped manifest, valid until it is closed), or NULL if manifest is NULL.
+ */
+const char *GCP_Client_Manifest_Get_Bucket_Name(struct GCP_Client_Manifest_Struct *manifest)
+{
+	if(manifest == NULL)
+		return NULL;
+	return manifest->Header->Bucket_Name;
+}
+
+/**
+ * Look up an object in a manifest by name, with a binary search of the records.
+ * @param manifest The open manifest.
+ * @param object_name The name of the object to look up.
+ * @param metadata The address of a structure, filled in with the object's metadata if it is found.
+ * @param found The address of an integer, set to TRUE if the object is in the manifest and FALSE if it is not.
+ * @return The routine returns TRUE on success (whether or not the object was found), and FALSE on failure.
+ *         If it fails, Manifest_Error_Number / Manifest_Error_String should contain details of the failure.
+ * @see #Manifest_Lower_Bound
+ * @see #Manifest_Record_Name
+ * @see #Manifest_Record_To_Metadata
+ */
+int GCP_Client_Manifest_Lookup(struct GCP_Client_Manifest_Struct *manifest,char *object_name,
+			       struct GCP_Client_Object_Metadata_Struct *metadata,int *found)
+{
+	const char *name = NULL;
+	unsigned long long index;
+
+	Manifest_Error_Number = 0;
+	if(manifest == NULL)
+	{
+		Manifest_Error_Number = 21;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Lookup: manifest was NULL.");
+		return FALSE;
+	}
+	if(object_name == NULL)
+	{
+		Manifest_Error_Number = 22;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Lookup: object_name was NULL.");
+		return FALSE;
+	}
+	if(metadata == NULL)
+	{
+		Manifest_Error_Number = 23;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Lookup: metadata was NULL.");
+		return FALSE;
+	}
+	if(found == NULL)
+	{
+		Manifest_Error_Number = 24;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Lookup: found was NULL.");
+		return FALSE;
+	}
+	(*found) = FALSE;
+	if(!Manifest_Lower_Bound(manifest,object_name,&index))
+		return FALSE;
+	if(index < manifest->Header->Record_Count)
+	{
+		name = Manifest_Record_Name(manifest,index);
+		if(name == NULL)
+			return FALSE;
+		if(strcmp(name,object_name) == 0)
+		{
+			Manifest_Record_To_Metadata(manifest,index,metadata);
+			(*found) = TRUE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Scan the objects in a manifest whose names start with a prefix, in name order, passing them to a callback
+ * a page at a time (as GCP_Client_List does). The start of the range is found with a binary search.
+ * @param manifest The open manifest.
+ * @param prefix The prefix of the objects to scan. NULL or an empty string scans the whole manifest.
+ * @param callback The function to call with each page of objects. It should return TRUE to continue the scan,
+ *        and FALSE to stop it. Stopping the scan early is not an error.
+ * @param user_data A pointer passed unaltered to each call of the callback.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Manifest_Error_Number /
+ *         Manifest_Error_String should contain details of the failure.
+ * @see #Manifest_Lower_Bound
+ * @see #Manifest_Record_Name
+ * @see #Manifest_Record_To_Metadata
+ * @see gcp_client_list.html#GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE
+ */
+int GCP_Client_Manifest_Scan(struct GCP_Client_Manifest_Struct *manifest,char *prefix,
+			     GCP_Client_List_Callback_T callback,void *user_data)
+{
+	struct GCP_Client_Object_Metadata_Struct *page_list = NULL;
+	const char *name = NULL;
+	unsigned long long index;
+	size_t prefix_length;
+	int page_count,done;
+
+	Manifest_Error_Number = 0;
+	if(manifest == NULL)
+	{
+		Manifest_Error_Number = 25;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Scan: manifest was NULL.");
+		return FALSE;
+	}
+	if(callback == NULL)
+	{
+		Manifest_Error_Number = 26;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Scan: callback was NULL.");
+		return FALSE;
+	}
+	if(prefix == NULL)
+		prefix = (char *)"";
+	prefix_length = strlen(prefix);
+	page_list = (struct GCP_Client_Object_Metadata_Struct *)malloc(GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE*
+								sizeof(struct GCP_Client_Object_Metadata_Struct));
+	if(page_list == NULL)
+	{
+		Manifest_Error_Number = 27;
+		sprintf(Manifest_Error_String,"GCP_Client_Manifest_Scan: Failed to allocate page of %d objects.",
+			GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE);
+		return FALSE;
+	}
+	if(!Manifest_Lower_Bound(manifest,prefix,&index))
+	{
+		free(page_list);
+		return FALSE;
+	}
+	page_count = 0;
+	done = FALSE;
+	for(; index < manifest->Header->Record_Count; index++)
+	{
+		name = Manifest_Record_Name(manifest,index);
+		if(name == NULL)
+		{
+			free(page_list);
+			return FALSE;
+		}
+		if(strncmp(name,prefix,prefix_length) != 0)
+			break;
+		Manifest_Record_To_Metadata(manifest,index,&(page_list[page_count]));
+		page_count++;
+		if(page_count == GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE)
+		{
+			done = (callback(page_list,page_count,user_data) == FALSE);
+			page_count = 0;
+			if(done)
+				break;
+		}
+	}
+	if((done == FALSE)&&(page_count > 0))
+		callback(page_list,page_count,user_data);
+	free(page_list);
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_manifest error number.
+ * @return The current value of the gcp_client_manifest error number.
+ * @see #Manifest_Error_Number
+ */
+int GCP_Client_Manifest_Get_Error_Number(void)
+{
+	return Manifest_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Manifest_Error_Number
+ * @see #Manifest_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Manifest_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Manifest_Error_Number == 0)
+		sprintf(Manifest_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Manifest:Error(%d) : %s\n",time_string,Manifest_Error_Number,
+		Manifest_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Manifest_Error_Number
+ * @see #Manifest_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Manifest_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Manifest_Error_Number == 0)
+		sprintf(Manifest_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Manifest:Error(%d) : %s\n",time_string,
+		Manifest_Error_Number,Manifest_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Listing callback used by GCP_Client_Manifest_Refresh. For each listed object, the old manifest records
+ * before it (and outside the refreshed range) are written to the new manifest, followed by the listed object.
+ * @param object_list The page of listed objects.
+ * @param object_count The number of objects in the page.
+ * @param user_data A pointer to the Manifest_Refresh_Struct.
+ * @return TRUE to continue the listing, FALSE to stop it if writing the new manifest failed
+ *         (refresh->Failed is set).
+ * @see #Manifest_Refresh_Struct
+ * @see #Manifest_Refresh_Merge_Old
+ * @see #Manifest_Refresh_Write
+ */
+static int Manifest_Refresh_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+				     void *user_data)
+{
+	struct Manifest_Refresh_Struct *refresh = (struct Manifest_Refresh_Struct *)user_data;
+	int i;
+
+	for(i = 0; i < object_count; i++)
+	{
+		if(!Manifest_Refresh_Merge_Old(refresh,object_list[i].Name))
+		{
+			refresh->Failed = TRUE;
+			return FALSE;
+		}
+		if(!Manifest_Refresh_Write(refresh,&(object_list[i])))
+		{
+			refresh->Failed = TRUE;
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Write the records of the old manifest whose names are before next_name, and outside the refreshed range,
+ * to the new manifest. Records inside the refreshed range are skipped, they have been replaced by the listing.
+ * @param refresh The refresh state.
+ * @param next_name The name of the next listed object, or NULL to write all the remaining old records.
+ * @return The routine returns TRUE on success, and FALSE on failure (Manifest_Error_Number is set).
+ * @see #Manifest_Refresh_Struct
+ * @see #Manifest_In_Range
+ * @see #Manifest_Record_Name
+ * @see #Manifest_Record_To_Metadata
+ * @see #Manifest_Refresh_Write
+ */
+static int Manifest_Refresh_Merge_Old(struct Manifest_Refresh_Struct *refresh,const char *next_name)
+{
+	struct GCP_Client_Object_Metadata_Struct metadata;
+	const char *name = NULL;
+
+	if(refresh->Old_Manifest == NULL)
+		return TRUE;
+	while(refresh->Old_Index < refresh->Old_Manifest->Header->Record_Count)
+	{
+		name = Manifest_Record_Name(refresh->Old_Manifest,refresh->Old_Index);
+		if(name == NULL)
+			return FALSE;
+		if((next_name != NULL)&&(strcmp(name,next_name) >= 0))
+			break;
+		if(!Manifest_In_Range(name,refresh->Prefix,refresh->Start_Offset,refresh->End_Offset))
+		{
+			Manifest_Record_To_Metadata(refresh->Old_Manifest,refresh->Old_Index,&metadata);
+			if(!Manifest_Refresh_Write(refresh,&metadata))
+				return FALSE;
+		}
+		refresh->Old_Index++;
+	}
+	return TRUE;
+}
+
+/**
+ * Write an object's record to the new manifest, and it's name to the string table.
+ * @param refresh The refresh state.
+ * @param metadata The object's metadata.
+ * @return The routine returns TRUE on success, and FALSE on failure (Manifest_Error_Number is set).
+ * @see #Manifest_Refresh_Struct
+ * @see #Manifest_Record_Struct
+ */
+static int Manifest_Refresh_Write(struct Manifest_Refresh_Struct *refresh,
+				  const struct GCP_Client_Object_Metadata_Struct *metadata)
+{
+	struct Manifest_Record_Struct record;
+	size_t name_length;
+
+	/* lookups rely on the records being sorted */
+	if((refresh->Record_Count > 0)&&(strcmp(metadata->Name,refresh->Last_Name) <= 0))
+	{
+		Manifest_Error_Number = 28;
+		snprintf(Manifest_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "Manifest_Refresh_Write: Object '%s' is not after object '%s'.",metadata->Name,
+			 refresh->Last_Name);
+		return FALSE;
+	}
+	name_length = strlen(metadata->Name);
+	memset(&record,0,sizeof(struct Manifest_Record_Struct));
+	record.Name_Offset = refresh->String_Table_Length;
+	record.Size = metadata->Size;
+	record.Generation = metadata->Generation;
+	record.Updated_Sec = metadata->Updated.tv_sec;
+	record.Updated_Nsec = metadata->Updated.tv_nsec;
+	record.Name_Length = name_length;
+	record.CRC32C = metadata->CRC32C;
+	if((fwrite(&record,sizeof(struct Manifest_Record_Struct),1,refresh->Record_Fp) != 1)||
+	   (fwrite(metadata->Name,1,name_length+1,refresh->String_Fp) != (name_length+1)))
+	{
+		Manifest_Error_Number = 29;
+		sprintf(Manifest_Error_String,"Manifest_Refresh_Write: Failed to write record %llu (%d).",
+			refresh->Record_Count,errno);
+		return FALSE;
+	}
+	refresh->String_Table_Length += name_length+1;
+	refresh->Record_Count++;
+	strcpy(refresh->Last_Name,metadata->Name);
+	return TRUE;
+}
+
+/**
+ * Determine whether an object name is inside the range being refreshed.
+ * @param name The object name.
+ * @param prefix The prefix of the range, or NULL.
+ * @param start_offset The (inclusive) start of the range, or NULL.
+ * @param end_offset The (exclusive) end of the range, or NULL.
+ * @return TRUE if the name is in the range, FALSE if it is not.
+ */
+static int Manifest_In_Range(const char *name,char *prefix,char *start_offset,char *end_offset)
+{
+	if((prefix != NULL)&&(strncmp(name,prefix,strlen(prefix)) != 0))
+		return FALSE;
+	if((start_offset != NULL)&&(strcmp(name,start_offset) < 0))
+		return FALSE;
+	if((end_offset != NULL)&&(strcmp(name,end_offset) >= 0))
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * Unmap and free an open manifest. Unlike GCP_Client_Manifest_Close, this does not reset Manifest_Error_Number,
+ * so it can be used to clean up after an error.
+ * @param manifest The open manifest.
+ * @see #GCP_Client_Manifest_Struct
+ */
+static void Manifest_Free(struct GCP_Client_Manifest_Struct *manifest)
+{
+	munmap(manifest->Map_Address,manifest->Map_Length);
+	close(manifest->Fd);
+	free(manifest);
+}
+
+/**
+ * Get the name of the index'th object in a manifest. The name's offset and length are checked against the
+ * string table, so a corrupt manifest cannot cause a read outside the mapping.
+ * @param manifest The open manifest.
+ * @param index The index of the record.
+ * @return A pointer to the NULL terminated name, or NULL if the record is corrupt (Manifest_Error_Number is set).
+ * @see #Manifest_Record_Struct
+ */
+static const char *Manifest_Record_Name(struct GCP_Client_Manifest_Struct *manifest,unsigned long long index)
+{
+	const struct Manifest_Record_Struct *record = &(manifest->Record_List[index]);
+
+	if((record->Name_Length > GCP_CLIENT_LIST_NAME_LENGTH)||
+	   (record->Name_Offset >= manifest->Header->String_Table_Length)||
+	   (record->Name_Length >= (manifest->Header->String_Table_Length-record->Name_Offset))||
+	   (manifest->String_Table[record->Name_Offset+record->Name_Length] != '\0'))
+	{
+		Manifest_Error_Number = 30;
+		sprintf(Manifest_Error_String,"Manifest_Record_Name: Record %llu has an illegal name.",index);
+		return NULL;
+	}
+	return manifest->String_Table+record->Name_Offset;
+}
+
+/**
+ * Copy the index'th record of a manifest into a compact metadata structure.
+ * The record's name must already have been checked with Manifest_Record_Name.
+ * @param manifest The open manifest.
+ * @param index The index of the record.
+ * @param metadata The address of the structure to fill in.
+ * @see #Manifest_Record_Struct
+ */
+static void Manifest_Record_To_Metadata(struct GCP_Client_Manifest_Struct *manifest,unsigned long long index,
+					struct GCP_Client_Object_Metadata_Struct *metadata)
+{
+	const struct Manifest_Record_Struct *record = &(manifest->Record_List[index]);
+
+	memcpy(metadata->Name,manifest->String_Table+record->Name_Offset,record->Name_Length+1);
+	metadata->Size = record->Size;
+	metadata->Generation = record->Generation;
+	metadata->CRC32C = record->CRC32C;
+	metadata->Is_Prefix = FALSE;
+	metadata->Updated.tv_sec = record->Updated_Sec;
+	metadata->Updated.tv_nsec = record->Updated_Nsec;
+}
+
+/**
+ * Binary search a manifest for the first record whose name is equal to or after name.
+ * @param manifest The open manifest.
+ * @param name The name to search for.
+ * @param index The address of an index, set to the index of the first record not before name
+ *        (the record count if all the records are before name).
+ * @return The routine returns TRUE on success, and FALSE if a corrupt record was found
+ *         (Manifest_Error_Number is set).
+ * @see #Manifest_Record_Name
+ */
+static int Manifest_Lower_Bound(struct GCP_Client_Manifest_Struct *manifest,const char *name,
+				unsigned long long *index)
+{
+	const char *record_name = NULL;
+	unsigned long long low,high,middle;
+
+	low = 0;
+	high = manifest->Header->Record_Count;
+	while(low < high)
+	{
+		middle = low+((high-low)/2);
+		record_name = Manifest_Record_Name(manifest,middle);
+		if(record_name == NULL)
+			return FALSE;
+		if(strcmp(record_name,name) < 0)
+			low = middle+1;
+		else
+			high = middle;
+	}
+	(*index) = low;
+	return TRUE;
+}
@@ -0,0 +1,331 @@
+/* gcp_client_metadata.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Object metadata routines.
+*/
+/**
+ * Google Cloud Platform object metadata (stat) routines. The metadata of a single object, or a batch of objects
+ * retrieved on a bounded number of threads, is returned in compact metadata structures.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include "google/cloud/storage/client.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_list.h"
+#include "gcp_client_metadata.h"
+#include "gcp_client_stats.h"
+#include "gcp_client_trace.h"
+#include "gcp_client_connection_private.h"
+#include "gcp_client_list_private.h"
+
+/* data types */
+/**
+ * Data type holding the arguments and results of a batch metadata retrieval, shared between the batch threads.
+ * This consists of the following:
+ * <dl>
+ * <dt>Bucket_Name</dt> <dd>The bucket containing the objects.</dd>
+ * <dt>Object_Name_List</dt> <dd>The list of object names to retrieve the metadata of.</dd>
+ * <dt>Metadata_List</dt> <dd>The list of metadata structures to fill in.</dd>
+ * <dt>Success_List</dt> <dd>A list of per-object success flags to fill in, or NULL.</dd>
+ * <dt>Mutex</dt> <dd>A mutex protecting the failure fields below.</dd>
+ * <dt>Failed_Count</dt> <dd>The number of objects whose metadata could not be retrieved.</dd>
+ * <dt>Failed_Index</dt> <dd>The index of the first failed object, or -1.</dd>
+ * <dt>Error_Number</dt> <dd>The Metadata_Error_Number of the first failed object.</dd>
+ * <dt>Error_String</dt> <dd>The Metadata_Error_String of the first failed object.</dd>
+ * </dl>
+ */
+struct Metadata_Batch_Struct
+{
+	char *Bucket_Name;
+	char **Object_Name_List;
+	struct GCP_Client_Object_Metadata_Struct *Metadata_List;
+	int *Success_List;
+	pthread_mutex_t Mutex;
+	int Failed_Count;
+	int Failed_Index;
+	int Error_Number;
+	char Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread, as batches retrieve
+ * metadata from several threads at once.
+ */
+static thread_local int Metadata_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Metadata_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static void Metadata_Batch_Item(int index,void *user_data);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Routine to retrieve the metadata of an object (GetObjectMetadata).
+ * @param bucket_name The name of the bucket.
+ * @param object_name The name of the object (filename) within the bucket.
+ * @param metadata The address of a structure to fill in with the object's metadata.
+ * @return The routine returns TRUE on success, and FALSE on failure (including the object not existing).
+ *         If it fails, Metadata_Error_Number / Metadata_Error_String should contain details of the failure.
+ * @see #Metadata_Error_Number
+ * @see #Metadata_Error_String
+ * @see gcp_client_list.html#GCP_Client_List_Metadata_Copy
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Metadata_Get(char *bucket_name,char *object_name,struct GCP_Client_Object_Metadata_Struct *metadata)
+{
+	::google::cloud::storage::Client client;
+	struct timespec start_time,trace_start_time;
+
+	Metadata_Error_Number = 0;
+	if(bucket_name == NULL)
+	{
+		Metadata_Error_Number = 1;
+		sprintf(Metadata_Error_String,"GCP_Client_Metadata_Get: bucket_name was NULL.");
+		return FALSE;
+	}
+	if(object_name == NULL)
+	{
+		Metadata_Error_Number = 2;
+		sprintf(Metadata_Error_String,"GCP_Client_Metadata_Get: object_name was NULL.");
+		return FALSE;
+	}
+	if(metadata == NULL)
+	{
+		Metadata_Error_Number = 3;
+		sprintf(Metadata_Error_String,"GCP_Client_Metadata_Get: metadata was NULL.");
+		return FALSE;
+	}
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_METADATA,LOG_VERBOSITY_VERY_VERBOSE,
+					     "GCP_Client_Metadata_Get(bucket=%s,object=%s):Started.",
+					     bucket_name,object_name);
+#endif
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	auto object_metadata = client.GetObjectMetadata(bucket_name,object_name);
+	if(!object_metadata)
+	{
+		Metadata_Error_Number = 4;
+		snprintf(Metadata_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Metadata_Get: Failed to get metadata of '%s' in '%s' with status '%s'.",
+			 object_name,bucket_name,object_metadata.status().message().c_str());
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_METADATA,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("stat",bucket_name,object_name,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	GCP_Client_List_Metadata_Copy(*object_metadata,metadata);
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_METADATA,start_time,0,TRUE);
+	GCP_Client_Trace_Span_End("stat",bucket_name,object_name,&trace_start_time,0,TRUE);
+	return TRUE;
+}
+
+/**
+ * Routine to retrieve the metadata of a batch of objects in the same bucket. The GetObjectMetadata requests are
+ * issued on up to concurrency threads at once (using GCP_Client_Batch_Run), which for thousands of objects
+ * is much faster than calling GCP_Client_Metadata_Get for each in turn. Every object in the batch is attempted,
+ * even if some of them fail.
+ * @param bucket_name The name of the bucket.
+ * @param object_name_list A list of object_count object names.
+ * @param object_count The number of objects in the batch.
+ * @param concurrency The maximum number of requests in progress at once.
+ *        If 0, GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY is used.
+ * @param metadata_list A caller allocated list of object_count metadata structures, filled in with the metadata
+ *        of the corresponding object. For objects whose metadata could not be retrieved, only the Name is filled in.
+ * @param success_list A caller allocated list of object_count integers, each set to TRUE if the corresponding
+ *        object's metadata was retrieved, and FALSE if it was not (for instance, if the object does not exist).
+ *        Can be NULL.
+ * @return The routine returns TRUE if the metadata of every object was retrieved, and FALSE if the metadata of
+ *         one or more objects could not be retrieved, or the batch could not be run. If it fails,
+ *         Metadata_Error_Number / Metadata_Error_String should contain details of the (first) failure.
+ * @see #Metadata_Batch_Struct
+ * @see #Metadata_Batch_Item
+ * @see #Metadata_Error_Number
+ * @see #Metadata_Error_String
+ * @see gcp_client_batch.html#GCP_Client_Batch_Run
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Metadata_Get_Batch(char *bucket_name,char **object_name_list,int object_count,int concurrency,
+				  struct GCP_Client_Object_Metadata_Struct *metadata_list,int *success_list)
+{
+	struct Metadata_Batch_Struct batch;
+	struct timespec trace_start_time;
+	char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+
+	Metadata_Error_Number = 0;
+	if(bucket_name == NULL)
+	{
+		Metadata_Error_Number = 5;
+		sprintf(Metadata_Error_String,"GCP_Client_Metadata_Get_Batch: bucket_name was NULL.");
+		return FALSE;
+	}
+	if(object_name_list == NULL)
+	{
+		Metadata_Error_Number = 6;
+		sprintf(Metadata_Error_String,"GCP_Client_Metadata_Get_Batch: object_name_list was NULL.");
+		return FALSE;
+	}
+	if(metadata_list == NULL)
+	{
+		Metadata_Error_Number = 7;
+		sprintf(Metadata_Error_String,"GCP_Client_Metadata_Get_Batch: metadata_list was NULL.");
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_METADATA,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Metadata_Get_Batch(bucket=%s):Started retrieving metadata "
+					     "for %d objects with concurrency %d.",bucket_name,object_count,concurrency);
+#endif
+	batch.Bucket_Name = bucket_name;
+	batch.Object_Name_List = object_name_list;
+	batch.Metadata_List = metadata_list;
+	batch.Success_List = success_list;
+	pthread_mutex_init(&(batch.Mutex),NULL);
+	batch.Failed_Count = 0;
+	batch.Failed_Index = -1;
+	batch.Error_Number = 0;
+	batch.Error_String[0] = '\0';
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	if(!GCP_Client_Batch_Run(object_count,concurrency,Metadata_Batch_Item,&batch))
+	{
+		pthread_mutex_destroy(&(batch.Mutex));
+		error_string[0] = '\0';
+		GCP_Client_Batch_Error_String(error_string);
+		Metadata_Error_Number = 8;
+		snprintf(Metadata_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Metadata_Get_Batch: Failed to run batch:%s",error_string);
+		GCP_Client_Trace_Span_End("stat_batch",bucket_name,NULL,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	pthread_mutex_destroy(&(batch.Mutex));
+	GCP_Client_Trace_Span_End("stat_batch",bucket_name,NULL,&trace_start_time,0,(batch.Failed_Count == 0));
+	if(batch.Failed_Count > 0)
+	{
+		Metadata_Error_Number = 9;
+		snprintf(Metadata_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Metadata_Get_Batch: Failed to get metadata of %d of %d objects, "
+			 "the first failure (object %d) was:Error(%d) : %s",batch.Failed_Count,object_count,
+			 batch.Failed_Index,batch.Error_Number,batch.Error_String);
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_METADATA,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Metadata_Get_Batch(bucket=%s):Finished.",bucket_name);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the current value of the gcp_client_metadata error number.
+ * @return The current value of the gcp_client_metadata error number.
+ * @see #Metadata_Error_Number
+ */
+int GCP_Client_Metadata_Get_Error_Number(void)
+{
+	return Metadata_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Metadata_Error_Number
+ * @see #Metadata_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Metadata_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Metadata_Error_Number == 0)
+		sprintf(Metadata_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Metadata:Error(%d) : %s\n",time_string,Metadata_Error_Number,
+		Metadata_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Metadata_Error_Number
+ * @see #Metadata_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Metadata_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Metadata_Error_Number == 0)
+		sprintf(Metadata_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Metadata:Error(%d) : %s\n",time_string,
+		Metadata_Error_Number,Metadata_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Batch item function, called by the batch threads to retrieve the metadata of one object. On failure the
+ * metadata structure is cleared (apart from the name), and the first failure's error is copied out of this
+ * thread's (thread local) error variables into the batch structure.
+ * @param index The index of the object in the batch.
+ * @param user_data A pointer to the Metadata_Batch_Struct.
+ * @see #Metadata_Batch_Struct
+ * @see #GCP_Client_Metadata_Get
+ */
+static void Metadata_Batch_Item(int index,void *user_data)
+{
+	struct Metadata_Batch_Struct *batch = (struct Metadata_Batch_Struct *)user_data;
+	struct GCP_Client_Object_Metadata_Struct *metadata = &(batch->Metadata_List[index]);
+	int retval;
+
+	retval = GCP_Client_Metadata_Get(batch->Bucket_Name,batch->Object_Name_List[index],metadata);
+	if(batch->Success_List != NULL)
+		batch->Success_List[index] = retval;
+	if(retval == FALSE)
+	{
+		memset(metadata,0,sizeof(struct GCP_Client_Object_Metadata_Struct));
+		if(batch->Object_Name_List[index] != NULL)
+		{
+			strncpy(metadata->Name,batch->Object_Name_List[index],GCP_CLIENT_LIST_NAME_LENGTH);
+			metadata->Name[GCP_CLIENT_LIST_NAME_LENGTH] = '\0';
+		}
+		pthread_mutex_lock(&(batch->Mutex));
+		batch->Failed_Count++;
+		/* indexes are claimed in order, but may complete out of order */
+		if((batch->Failed_Index < 0)||(index < batch->Failed_Index))
+		{
+			batch->Failed_Index = index;
+			batch->Error_Number = Metadata_Error_Number;
+			strncpy(batch->Error_String,Metadata_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1);
+			batch->Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1] = '\0';
+		}
+		pthread_mutex_unlock(&(batch->Mutex));
+	}
+}
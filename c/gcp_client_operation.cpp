@@ -0,0 +1,672 @@
+/* gcp_client_operation.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Per-operation deadline, stall timeout and cancellation routines.
+*/
+/**
+ * Routines managing operation handles. An operation handle is passed to a transfer routine (for instance
+ * GCP_Client_Read_Write_Read_Operation) to bound how long it can take, and to allow another thread to cancel it.
+ * Each operation can have:
+ * <ul>
+ * <li>A deadline: the transfer is abandoned once it has been running this long, however quickly bytes are moving.
+ * <li>A stall timeout: the transfer is abandoned when no bytes have moved for this long. This is also passed to
+ *     google-cloud-cpp as it's download and transfer stall timeouts, so a read() or Close() blocked on a hung
+ *     connection returns rather than blocking the calling thread forever.
+ * </ul>
+ * Transfer routines check the operation between chunks, so a cancel (or passed deadline) is acted on as soon as
+ * the chunk in progress completes, or the stall timeout ends it. The transfer then frees it's resources (buffers,
+ * budget, resumable upload sessions) and fails with an error number specific to the reason, and the operation's
+ * state records the reason too.
+ * An operation can also be paused (for instance by the scheduler, to let a more urgent transfer go first). A paused
+ * upload keeps it's resumable upload session in the operation, and after GCP_Client_Operation_Resume the next
+ * upload using the operation carries on from the last byte the server received.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include "google/cloud/storage/client.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_operation.h"
+#include "gcp_client_operation_private.h"
+
+/* data types */
+/**
+ * Data type holding an operation. This consists of the following:
+ * <dl>
+ * <dt>Mutex</dt> <dd>Mutex protecting the rest of the structure, as it is cancelled and queried from other
+ *     threads.</dd>
+ * <dt>State</dt> <dd>The state of the operation, one of GCP_CLIENT_OPERATION_STATE_*.</dd>
+ * <dt>Cancelled</dt> <dd>A boolean, TRUE when GCP_Client_Operation_Cancel has been called.</dd>
+ * <dt>Pause_Requested</dt> <dd>A boolean, TRUE when GCP_Client_Operation_Pause has been called (and the operation
+ *     not resumed since).</dd>
+ * <dt>Deadline_Ms</dt> <dd>How long the transfer can run for in milliseconds, or 0 for no deadline.</dd>
+ * <dt>Stall_Timeout_Ms</dt> <dd>How long the transfer can go without moving any bytes in milliseconds,
+ *     or 0 to use google-cloud-cpp's defaults.</dd>
+ * <dt>Start_Time</dt> <dd>The (CLOCK_MONOTONIC) time the transfer began.</dd>
+ * <dt>Last_Progress_Time</dt> <dd>The (CLOCK_MONOTONIC) time bytes last moved (or the transfer began).</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes transferred so far.</dd>
+ * <dt>Session_Id</dt> <dd>The resumable upload session of a paused upload, allocated with strdup, or NULL.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_OPERATION_STATE_IDLE
+ */
+struct GCP_Client_Operation_Struct
+{
+	pthread_mutex_t Mutex;
+	int State;
+	int Cancelled;
+	int Pause_Requested;
+	int Deadline_Ms;
+	int Stall_Timeout_Ms;
+	struct timespec Start_Time;
+	struct timespec Last_Progress_Time;
+	unsigned long long Byte_Count;
+	char *Session_Id;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Operation_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Operation_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static int Operation_Is_Terminal(int state);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Create an operation handle, with no deadline and the default stall timeout.
+ * @param operation The address of a pointer to fill in with the new operation.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Operation_Struct
+ * @see #GCP_Client_Operation_Destroy
+ */
+int GCP_Client_Operation_Create(struct GCP_Client_Operation_Struct **operation)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 1;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Create:operation was NULL.");
+		return FALSE;
+	}
+	(*operation) = (struct GCP_Client_Operation_Struct *)malloc(sizeof(struct GCP_Client_Operation_Struct));
+	if((*operation) == NULL)
+	{
+		Operation_Error_Number = 2;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Create:Failed to allocate operation.");
+		return FALSE;
+	}
+	pthread_mutex_init(&((*operation)->Mutex),NULL);
+	(*operation)->State = GCP_CLIENT_OPERATION_STATE_IDLE;
+	(*operation)->Cancelled = FALSE;
+	(*operation)->Pause_Requested = FALSE;
+	(*operation)->Deadline_Ms = 0;
+	(*operation)->Stall_Timeout_Ms = 0;
+	(*operation)->Start_Time.tv_sec = 0;
+	(*operation)->Start_Time.tv_nsec = 0;
+	(*operation)->Last_Progress_Time = (*operation)->Start_Time;
+	(*operation)->Byte_Count = 0;
+	(*operation)->Session_Id = NULL;
+	return TRUE;
+}
+
+/**
+ * Set how long transfers using the operation can run for. The deadline is measured from the start of the transfer.
+ * It also bounds how long google-cloud-cpp spends retrying a failed request.
+ * @param operation The operation.
+ * @param deadline_ms The deadline in milliseconds, or 0 for no deadline.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Operation_Struct
+ */
+int GCP_Client_Operation_Set_Deadline(struct GCP_Client_Operation_Struct *operation,int deadline_ms)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 3;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Set_Deadline:operation was NULL.");
+		return FALSE;
+	}
+	if(deadline_ms < 0)
+	{
+		Operation_Error_Number = 4;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Set_Deadline:Illegal deadline %d ms.",deadline_ms);
+		return FALSE;
+	}
+	pthread_mutex_lock(&(operation->Mutex));
+	operation->Deadline_Ms = deadline_ms;
+	pthread_mutex_unlock(&(operation->Mutex));
+	return TRUE;
+}
+
+/**
+ * Set how long transfers using the operation can go without moving any bytes. google-cloud-cpp's stall timeouts
+ * are in whole seconds, so the timeout is rounded up to the next second when passed to it.
+ * @param operation The operation.
+ * @param stall_timeout_ms The stall timeout in milliseconds, or 0 to use google-cloud-cpp's defaults.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Operation_Struct
+ */
+int GCP_Client_Operation_Set_Stall_Timeout(struct GCP_Client_Operation_Struct *operation,int stall_timeout_ms)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 5;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Set_Stall_Timeout:operation was NULL.");
+		return FALSE;
+	}
+	if(stall_timeout_ms < 0)
+	{
+		Operation_Error_Number = 6;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Set_Stall_Timeout:Illegal stall timeout %d ms.",
+			stall_timeout_ms);
+		return FALSE;
+	}
+	pthread_mutex_lock(&(operation->Mutex));
+	operation->Stall_Timeout_Ms = stall_timeout_ms;
+	pthread_mutex_unlock(&(operation->Mutex));
+	return TRUE;
+}
+
+/**
+ * Cancel the transfer using the operation. This can be called from any thread. The transfer stops after the chunk
+ * in progress (or when it's stall timeout ends a hung request), frees it's resources, and fails. Cancelling an
+ * operation before it's transfer starts makes the transfer fail straight away.
+ * @param operation The operation.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Operation_Struct
+ */
+int GCP_Client_Operation_Cancel(struct GCP_Client_Operation_Struct *operation)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 7;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Cancel:operation was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(operation->Mutex));
+	operation->Cancelled = TRUE;
+	pthread_mutex_unlock(&(operation->Mutex));
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_OPERATION,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Operation_Cancel:Operation %p cancelled.",(void*)operation);
+#endif
+	return TRUE;
+}
+
+/**
+ * Pause the transfer using the operation. This can be called from any thread. The transfer stops after the chunk
+ * in progress, in the GCP_CLIENT_OPERATION_STATE_PAUSED state. A paused upload does not delete it's resumable upload
+ * session, but keeps it in the operation, so once the operation is resumed (GCP_Client_Operation_Resume) the upload
+ * can be carried on by passing the same operation and data to the upload routine again. Other transfers have to
+ * start again from the beginning. Pausing an operation before it's transfer starts makes the transfer stop
+ * straight away. A cancel takes precedence over a pause.
+ * @param operation The operation.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Operation_Struct
+ * @see #GCP_Client_Operation_Resume
+ */
+int GCP_Client_Operation_Pause(struct GCP_Client_Operation_Struct *operation)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 13;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Pause:operation was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(operation->Mutex));
+	operation->Pause_Requested = TRUE;
+	pthread_mutex_unlock(&(operation->Mutex));
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_OPERATION,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Operation_Pause:Operation %p paused.",(void*)operation);
+#endif
+	return TRUE;
+}
+
+/**
+ * Resume a paused operation, so it can be passed to a transfer routine again. The state is returned to idle, and
+ * the pause cleared. Unlike GCP_Client_Operation_Reset, a paused upload's resumable upload session is kept, so the
+ * next upload using the operation carries on from where the paused one stopped.
+ * @param operation The operation.
+ * @return The routine returns TRUE on success, and FALSE on failure (including when the operation is not paused).
+ * @see #GCP_Client_Operation_Struct
+ * @see #GCP_Client_Operation_Pause
+ */
+int GCP_Client_Operation_Resume(struct GCP_Client_Operation_Struct *operation)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 14;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Resume:operation was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(operation->Mutex));
+	if(operation->State != GCP_CLIENT_OPERATION_STATE_PAUSED)
+	{
+		Operation_Error_Number = 15;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Resume:Operation is not paused (%s).",
+			GCP_Client_Operation_State_To_String(operation->State));
+		pthread_mutex_unlock(&(operation->Mutex));
+		return FALSE;
+	}
+	operation->State = GCP_CLIENT_OPERATION_STATE_IDLE;
+	operation->Pause_Requested = FALSE;
+	pthread_mutex_unlock(&(operation->Mutex));
+	return TRUE;
+}
+
+/**
+ * Get the state of the operation, and the number of bytes it's transfer has moved so far.
+ * @param operation The operation.
+ * @param state The address of an integer to fill in with the state, one of GCP_CLIENT_OPERATION_STATE_*.
+ *        Can be NULL.
+ * @param byte_count The address of an integer to fill in with the number of bytes transferred. Can be NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Operation_Struct
+ */
+int GCP_Client_Operation_Get_State(struct GCP_Client_Operation_Struct *operation,int *state,
+				   unsigned long long *byte_count)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 8;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Get_State:operation was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(operation->Mutex));
+	if(state != NULL)
+		(*state) = operation->State;
+	if(byte_count != NULL)
+		(*byte_count) = operation->Byte_Count;
+	pthread_mutex_unlock(&(operation->Mutex));
+	return TRUE;
+}
+
+/**
+ * Reset the operation, so it can be used for another transfer. The state is returned to idle, and any cancel or
+ * pause is cleared, as is a paused upload's resumable upload session (the server discards an unfinished session
+ * after a week, without creating the object). The deadline and stall timeout are kept.
+ * @param operation The operation.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Operation_Struct
+ */
+int GCP_Client_Operation_Reset(struct GCP_Client_Operation_Struct *operation)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 9;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Reset:operation was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(operation->Mutex));
+	if(operation->State == GCP_CLIENT_OPERATION_STATE_RUNNING)
+	{
+		pthread_mutex_unlock(&(operation->Mutex));
+		Operation_Error_Number = 10;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Reset:Operation is still running.");
+		return FALSE;
+	}
+	operation->State = GCP_CLIENT_OPERATION_STATE_IDLE;
+	operation->Cancelled = FALSE;
+	operation->Pause_Requested = FALSE;
+	operation->Byte_Count = 0;
+	if(operation->Session_Id != NULL)
+		free(operation->Session_Id);
+	operation->Session_Id = NULL;
+	pthread_mutex_unlock(&(operation->Mutex));
+	return TRUE;
+}
+
+/**
+ * Destroy an operation. It must not be in use by a transfer.
+ * @param operation The operation.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Operation_Struct
+ * @see #GCP_Client_Operation_Create
+ */
+int GCP_Client_Operation_Destroy(struct GCP_Client_Operation_Struct *operation)
+{
+	Operation_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Operation_Error_Number = 11;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Destroy:operation was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(operation->Mutex));
+	if(operation->State == GCP_CLIENT_OPERATION_STATE_RUNNING)
+	{
+		pthread_mutex_unlock(&(operation->Mutex));
+		Operation_Error_Number = 12;
+		sprintf(Operation_Error_String,"GCP_Client_Operation_Destroy:Operation is still running.");
+		return FALSE;
+	}
+	pthread_mutex_unlock(&(operation->Mutex));
+	pthread_mutex_destroy(&(operation->Mutex));
+	if(operation->Session_Id != NULL)
+		free(operation->Session_Id);
+	free(operation);
+	return TRUE;
+}
+
+/**
+ * Return a string describing an operation state.
+ * @param state The state, one of GCP_CLIENT_OPERATION_STATE_*.
+ * @return A constant string describing the state.
+ * @see #GCP_CLIENT_OPERATION_STATE_IDLE
+ */
+const char *GCP_Client_Operation_State_To_String(int state)
+{
+	switch(state)
+	{
+		case GCP_CLIENT_OPERATION_STATE_IDLE:
+			return "IDLE";
+		case GCP_CLIENT_OPERATION_STATE_RUNNING:
+			return "RUNNING";
+		case GCP_CLIENT_OPERATION_STATE_COMPLETED:
+			return "COMPLETED";
+		case GCP_CLIENT_OPERATION_STATE_FAILED:
+			return "FAILED";
+		case GCP_CLIENT_OPERATION_STATE_CANCELLED:
+			return "CANCELLED";
+		case GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED:
+			return "DEADLINE_EXCEEDED";
+		case GCP_CLIENT_OPERATION_STATE_STALLED:
+			return "STALLED";
+		case GCP_CLIENT_OPERATION_STATE_PAUSED:
+			return "PAUSED";
+		default:
+			return "UNKNOWN";
+	}
+}
+
+/**
+ * Called by a transfer routine when it starts a transfer using the operation. The operation is marked as running,
+ * and it's start and progress times set. A cancel made before the transfer started is kept, so the transfer's first
+ * GCP_Client_Operation_Check fails it.
+ * @param operation The operation, or NULL if the transfer has none.
+ * @return The routine returns TRUE on success, and FALSE if the operation is already in use by another transfer.
+ * @see #GCP_Client_Operation_Struct
+ */
+int GCP_Client_Operation_Begin(struct GCP_Client_Operation_Struct *operation)
+{
+	if(operation == NULL)
+		return TRUE;
+	pthread_mutex_lock(&(operation->Mutex));
+	if(operation->State == GCP_CLIENT_OPERATION_STATE_RUNNING)
+	{
+		pthread_mutex_unlock(&(operation->Mutex));
+		return FALSE;
+	}
+	operation->State = GCP_CLIENT_OPERATION_STATE_RUNNING;
+	operation->Byte_Count = 0;
+	clock_gettime(CLOCK_MONOTONIC,&(operation->Start_Time));
+	operation->Last_Progress_Time = operation->Start_Time;
+	pthread_mutex_unlock(&(operation->Mutex));
+	return TRUE;
+}
+
+/**
+ * Called by a transfer routine between chunks (and when a request fails), to see whether it should carry on.
+ * A cancel takes precedence, then a pause, then a passed deadline. The transfer is reported as stalled when the request failed
+ * and no bytes have moved for the stall timeout (google-cloud-cpp having given up on the hung connection).
+ * Once the operation has reached an end state, it stays in it.
+ * @param operation The operation, or NULL if the transfer has none.
+ * @param transfer_failed A boolean, TRUE if the request being checked has failed.
+ * @return GCP_CLIENT_OPERATION_STATE_RUNNING if the transfer should carry on, otherwise
+ *         GCP_CLIENT_OPERATION_STATE_CANCELLED, GCP_CLIENT_OPERATION_STATE_PAUSED,
+ *         GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED or GCP_CLIENT_OPERATION_STATE_STALLED.
+ * @see #GCP_Client_Operation_Struct
+ * @see #Operation_Is_Terminal
+ * @see gcp_client_general.html#fdifftime
+ */
+int GCP_Client_Operation_Check(struct GCP_Client_Operation_Struct *operation,int transfer_failed)
+{
+	struct timespec current_time;
+	int state;
+
+	if(operation == NULL)
+		return GCP_CLIENT_OPERATION_STATE_RUNNING;
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	pthread_mutex_lock(&(operation->Mutex));
+	if(Operation_Is_Terminal(operation->State))
+	{
+		state = operation->State;
+		pthread_mutex_unlock(&(operation->Mutex));
+		return state;
+	}
+	if(operation->Cancelled)
+		operation->State = GCP_CLIENT_OPERATION_STATE_CANCELLED;
+	else if(operation->Pause_Requested)
+		operation->State = GCP_CLIENT_OPERATION_STATE_PAUSED;
+	else if((operation->Deadline_Ms > 0)&&
+		((fdifftime(current_time,operation->Start_Time)*1000.0) >= operation->Deadline_Ms))
+		operation->State = GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED;
+	else if(transfer_failed&&(operation->Stall_Timeout_Ms > 0)&&
+		((fdifftime(current_time,operation->Last_Progress_Time)*1000.0) >= operation->Stall_Timeout_Ms))
+		operation->State = GCP_CLIENT_OPERATION_STATE_STALLED;
+	state = operation->State;
+	pthread_mutex_unlock(&(operation->Mutex));
+#if LOGGING > 1
+	if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+	{
+		GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_OPERATION,LOG_VERBOSITY_TERSE,
+						     "GCP_Client_Operation_Check:Operation %p stopped:%s.",
+						     (void*)operation,GCP_Client_Operation_State_To_String(state));
+	}
+#endif
+	return state;
+}
+
+/**
+ * Called by a transfer routine when bytes have moved.
+ * @param operation The operation, or NULL if the transfer has none.
+ * @param byte_count The number of bytes that have moved since the last call.
+ * @see #GCP_Client_Operation_Struct
+ */
+void GCP_Client_Operation_Progress(struct GCP_Client_Operation_Struct *operation,unsigned long long byte_count)
+{
+	if((operation == NULL)||(byte_count == 0))
+		return;
+	pthread_mutex_lock(&(operation->Mutex));
+	operation->Byte_Count += byte_count;
+	clock_gettime(CLOCK_MONOTONIC,&(operation->Last_Progress_Time));
+	pthread_mutex_unlock(&(operation->Mutex));
+}
+
+/**
+ * Called by a transfer routine when the transfer has finished. If the operation has not already reached an end
+ * state (by being cancelled, passing it's deadline or stalling), it is marked as completed or failed.
+ * @param operation The operation, or NULL if the transfer has none.
+ * @param success A boolean, TRUE if the transfer succeeded.
+ * @see #GCP_Client_Operation_Struct
+ * @see #Operation_Is_Terminal
+ */
+void GCP_Client_Operation_End(struct GCP_Client_Operation_Struct *operation,int success)
+{
+	if(operation == NULL)
+		return;
+	pthread_mutex_lock(&(operation->Mutex));
+	if(!Operation_Is_Terminal(operation->State))
+	{
+		if(success)
+			operation->State = GCP_CLIENT_OPERATION_STATE_COMPLETED;
+		else
+			operation->State = GCP_CLIENT_OPERATION_STATE_FAILED;
+	}
+	pthread_mutex_unlock(&(operation->Mutex));
+}
+
+/**
+ * Get the google-cloud-cpp options that apply the operation's limits to a request. The stall timeout is set as the
+ * download and transfer stall timeouts (rounded up to whole seconds), so a hung read() or Close() returns an error.
+ * If the operation has a deadline, the retry policy is limited to the time remaining before it, so retries of
+ * a failed request do not run past it, and the stall timeouts are limited to the time remaining too (at least
+ * one second), so a hung read() or Close() does not wait past it for the library's default stall timeout.
+ * @param operation The operation, or NULL if the transfer has none (in which case no options are set).
+ * @return The options.
+ * @see #GCP_Client_Operation_Struct
+ * @see gcp_client_general.html#fdifftime
+ */
+::google::cloud::Options GCP_Client_Operation_Get_Options(struct GCP_Client_Operation_Struct *operation)
+{
+	namespace gcs = ::google::cloud::storage;
+	::google::cloud::Options options;
+	struct timespec current_time;
+	double remaining_ms;
+	long long stall_timeout_ms;
+
+	if(operation == NULL)
+		return options;
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	pthread_mutex_lock(&(operation->Mutex));
+	stall_timeout_ms = operation->Stall_Timeout_Ms;
+	if(operation->Deadline_Ms > 0)
+	{
+		remaining_ms = operation->Deadline_Ms-(fdifftime(current_time,operation->Start_Time)*1000.0);
+		if(remaining_ms < 1.0)
+			remaining_ms = 1.0;
+		options.set<gcs::RetryPolicyOption>(gcs::LimitedTimeRetryPolicy(
+				       std::chrono::milliseconds((long long)remaining_ms)).clone());
+		if((stall_timeout_ms <= 0)||((long long)remaining_ms < stall_timeout_ms))
+			stall_timeout_ms = (long long)remaining_ms;
+	}
+	if(stall_timeout_ms > 0)
+	{
+		options.set<gcs::DownloadStallTimeoutOption>(std::chrono::seconds((stall_timeout_ms+999)/1000));
+		options.set<gcs::TransferStallTimeoutOption>(std::chrono::seconds((stall_timeout_ms+999)/1000));
+	}
+	pthread_mutex_unlock(&(operation->Mutex));
+	return options;
+}
+
+/**
+ * Called by an upload routine to keep (or clear) the operation's resumable upload session. A paused upload's
+ * session is kept until the upload is resumed and finished, or the operation is reset or destroyed.
+ * @param operation The operation, or NULL if the transfer has none (in which case nothing is kept).
+ * @param session_id The resumable upload session id, or an empty string to clear it.
+ * @see #GCP_Client_Operation_Struct
+ */
+void GCP_Client_Operation_Set_Session(struct GCP_Client_Operation_Struct *operation,std::string const &session_id)
+{
+	if(operation == NULL)
+		return;
+	pthread_mutex_lock(&(operation->Mutex));
+	if(operation->Session_Id != NULL)
+		free(operation->Session_Id);
+	operation->Session_Id = NULL;
+	if(session_id.empty() == FALSE)
+		operation->Session_Id = strdup(session_id.c_str());
+	pthread_mutex_unlock(&(operation->Mutex));
+}
+
+/**
+ * Get the resumable upload session a paused upload using the operation left behind.
+ * @param operation The operation, or NULL if the transfer has none.
+ * @return The resumable upload session id, or an empty string if there is none.
+ * @see #GCP_Client_Operation_Struct
+ */
+std::string GCP_Client_Operation_Get_Session(struct GCP_Client_Operation_Struct *operation)
+{
+	std::string session_id;
+
+	if(operation == NULL)
+		return session_id;
+	pthread_mutex_lock(&(operation->Mutex));
+	if(operation->Session_Id != NULL)
+		session_id = operation->Session_Id;
+	pthread_mutex_unlock(&(operation->Mutex));
+	return session_id;
+}
+
+/**
+ * Get the current value of the operation module's error number.
+ * @return The current value of the operation module's error number.
+ * @see #Operation_Error_Number
+ */
+int GCP_Client_Operation_Get_Error_Number(void)
+{
+	return Operation_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Operation_Error_Number
+ * @see #Operation_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Operation_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Operation_Error_Number == 0)
+		sprintf(Operation_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Operation:Error(%d) : %s\n",time_string,Operation_Error_Number,
+		Operation_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Operation_Error_Number
+ * @see #Operation_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Operation_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Operation_Error_Number == 0)
+		sprintf(Operation_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Operation:Error(%d) : %s\n",time_string,
+		Operation_Error_Number,Operation_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Return whether a state is an end state, that a transfer has stopped in.
+ * @param state The state, one of GCP_CLIENT_OPERATION_STATE_*.
+ * @return TRUE if the state is an end state, FALSE if the operation is idle or running.
+ */
+static int Operation_Is_Terminal(int state)
+{
+	return (state != GCP_CLIENT_OPERATION_STATE_IDLE)&&(state != GCP_CLIENT_OPERATION_STATE_RUNNING);
+}
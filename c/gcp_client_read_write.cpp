@@ -4,25 +4,190 @@
 */
 /**
  * Google Cloud Platform object (file) read/werite routines.
+ * <p>
+ * Reads (and range reads) into reallocated memory can optionally be hedged, to cut the tail latency of reading small
+ * objects. A hedged read is made from a thread of it's own. If it's first byte has not arrived within a percentile
+ * of the recent first byte latencies, a duplicate request is started, the first of the two to finish is returned,
+ * and the other is cancelled. The number of duplicate requests is capped at a percentage of the hedged reads.
+ * <p>
+ * Large objects can be read as several ranged parts in parallel. The part length, and how many parts are in
+ * progress at once, are chosen (and changed as the read progresses) by the adaptive controller in
+ * gcp_client_adaptive, from the throughput and round trip times of the parts already read.
  * @author Chris Mottram
  * @version $Revision$
  */
 #include "google/cloud/storage/client.h"
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <vector>
 #include "log_udp.h"
 #include "gcp_client_general.h"
+#include "gcp_client_adaptive.h"
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_budget.h"
+#include "gcp_client_buffer.h"
+#include "gcp_client_fits.h"
+#include "gcp_client_operation.h"
 #include "gcp_client_read_write.h"
+#include "gcp_client_stats.h"
+#include "gcp_client_trace.h"
 #include "gcp_client_connection_private.h"
+#include "gcp_client_fits_private.h"
+#include "gcp_client_operation_private.h"
+#include "gcp_client_read_write_private.h"
 
 /* defines */
 /**
  * Amount of bytes to grow buffers by.
  */
 #define READ_WRITE_BUFFER_RESIZE_LENGTH (1024*1024)
+/**
+ * The number of times a parallel read re-reads a part whose read failed, before failing the whole read.
+ */
+#define READ_WRITE_PARALLEL_PART_RETRY_COUNT (2)
+/**
+ * The number of requests a hedged read can make: the original (primary) request, and one duplicate (hedge).
+ */
+#define READ_WRITE_HEDGE_ATTEMPT_COUNT  (2)
+/**
+ * The number of recent first byte latencies the hedge threshold is calculated from.
+ */
+#define READ_WRITE_HEDGE_SAMPLE_COUNT   (1000)
+/**
+ * The number of first byte latencies needed before reads are hedged.
+ */
+#define READ_WRITE_HEDGE_MIN_SAMPLE_COUNT (20)
+/**
+ * The smallest hedge threshold, in milliseconds.
+ */
+#define READ_WRITE_HEDGE_MIN_THRESHOLD  (1.0)
+/**
+ * The stall timeout of each request of a hedged read, in seconds. Hedged reads are not part of an operation, so
+ * this bounds how long a request (in particular the one that lost the race) can wait for bytes that never come.
+ */
+#define READ_WRITE_HEDGE_STALL_TIMEOUT  (10)
 
 /* data types */
+/**
+ * Data type holding the state of one request of a hedged read. This consists of the following:
+ * <dl>
+ * <dt>Hedge</dt> <dd>A pointer to the hedged read this request is part of.</dd>
+ * <dt>Index</dt> <dd>The index of the request, 0 for the primary request and 1 for the hedge request.</dd>
+ * <dt>First_Byte</dt> <dd>A boolean, set to TRUE when the first byte of the response has arrived.</dd>
+ * <dt>Cancelled</dt> <dd>A boolean, set to TRUE when the other request has finished first. The request checks it
+ *     after the first byte arrives, and between each part it reads.</dd>
+ * <dt>Failed</dt> <dd>A boolean, set to TRUE when the request has failed (or been cancelled or abandoned).</dd>
+ * <dt>Error_Number</dt> <dd>The error number of the failure.</dd>
+ * <dt>Error_String</dt> <dd>The error string of the failure.</dd>
+ * </dl>
+ * @see #Read_Write_Hedge_Struct
+ */
+struct Read_Write_Hedge_Attempt_Struct
+{
+	struct Read_Write_Hedge_Struct *Hedge;
+	int Index;
+	int First_Byte;
+	int Cancelled;
+	int Failed;
+	int Error_Number;
+	char Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+};
+
+/**
+ * Data type holding the state of a hedged read, shared between the reading thread and the request threads.
+ * This consists of the following:
+ * <dl>
+ * <dt>Function_Name</dt> <dd>The name of the external routine making the read, used in error messages.</dd>
+ * <dt>Bucket_Name</dt> <dd>The name of the bucket.</dd>
+ * <dt>Filename</dt> <dd>The object name.</dd>
+ * <dt>Ranged</dt> <dd>A boolean, TRUE if only Length bytes from Offset are read.</dd>
+ * <dt>Offset</dt> <dd>The offset of a ranged read, in bytes.</dd>
+ * <dt>Length</dt> <dd>The length of a ranged read, in bytes.</dd>
+ * <dt>Max_Length</dt> <dd>The longest object a hedge request continues reading.</dd>
+ * <dt>Start_Time</dt> <dd>The (monotonic) time the read started.</dd>
+ * <dt>Priority</dt> <dd>The bandwidth priority class of the reading thread, which the request threads inherit.</dd>
+ * <dt>Mutex</dt> <dd>Mutex protecting the rest of the structure.</dd>
+ * <dt>Condition</dt> <dd>Condition variable, broadcast when a request gets it's first byte, finishes or fails.</dd>
+ * <dt>Reference_Count</dt> <dd>The number of threads (reader and requests) still using the structure. The last
+ *     one frees it.</dd>
+ * <dt>Attempt_Count</dt> <dd>The number of requests started.</dd>
+ * <dt>Generation</dt> <dd>The object generation, from the first request to get a response (0 until then). A hedge
+ *     request started afterwards reads this generation, and a request that gets a different one fails, so the
+ *     two requests can't return different generations of the object.</dd>
+ * <dt>Done</dt> <dd>A boolean, set to TRUE when a request has finished reading the object.</dd>
+ * <dt>Winner</dt> <dd>The index of the request that finished first.</dd>
+ * <dt>Contents</dt> <dd>The winning request's object contents.</dd>
+ * <dt>Contents_Length</dt> <dd>The number of bytes in Contents.</dd>
+ * <dt>Attempt</dt> <dd>The state of each request.</dd>
+ * </dl>
+ * @see #READ_WRITE_HEDGE_ATTEMPT_COUNT
+ * @see #Read_Write_Hedge_Attempt_Struct
+ */
+struct Read_Write_Hedge_Struct
+{
+	const char *Function_Name;
+	std::string Bucket_Name;
+	std::string Filename;
+	int Ranged;
+	unsigned long long Offset;
+	size_t Length;
+	size_t Max_Length;
+	struct timespec Start_Time;
+	int Priority;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Condition;
+	int Reference_Count;
+	int Attempt_Count;
+	long long Generation;
+	int Done;
+	int Winner;
+	void *Contents;
+	size_t Contents_Length;
+	struct Read_Write_Hedge_Attempt_Struct Attempt[READ_WRITE_HEDGE_ATTEMPT_COUNT];
+};
+
+/**
+ * Data type holding the state of a parallel read, shared between the part reading threads.
+ * This consists of the following:
+ * <dl>
+ * <dt>Bucket_Name</dt> <dd>The name of the bucket.</dd>
+ * <dt>Filename</dt> <dd>The object name.</dd>
+ * <dt>Generation</dt> <dd>The generation of the object being read, so every part is read from the same
+ *     version of the object.</dd>
+ * <dt>Contents</dt> <dd>The memory the object is read into.</dd>
+ * <dt>Length</dt> <dd>The object length, in bytes.</dd>
+ * <dt>Mutex</dt> <dd>Mutex protecting the rest of the structure.</dd>
+ * <dt>Condition</dt> <dd>Condition variable, broadcast when a part finishes.</dd>
+ * <dt>Next_Offset</dt> <dd>The offset of the first byte not yet handed to a thread to read.</dd>
+ * <dt>Active_Count</dt> <dd>The number of parts being read.</dd>
+ * <dt>Failed</dt> <dd>A boolean, set to TRUE when a part has failed.</dd>
+ * <dt>Error_Number</dt> <dd>The error number of the first failure.</dd>
+ * <dt>Error_String</dt> <dd>The error string of the first failure.</dd>
+ * </dl>
+ */
+struct Read_Write_Parallel_Struct
+{
+	char *Bucket_Name;
+	char *Filename;
+	std::int64_t Generation;
+	char *Contents;
+	size_t Length;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Condition;
+	size_t Next_Offset;
+	int Active_Count;
+	int Failed;
+	int Error_Number;
+	char Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+};
 
 /* internal variables */
 /**
@@ -31,14 +196,74 @@
 static char rcsid[] = "$Id$";
 
 /**
- * Variable holding error code of last operation performed.
+ * Variable holding error code of last operation performed. This is per-thread, so objects can be read/written
+ * from several threads at once, and each thread reports it's own errors.
  */
-static int Read_Write_Error_Number = 0;
+static thread_local int Read_Write_Error_Number = 0;
 /**
- * Local variable holding description of the last error that occured.
+ * Local variable holding description of the last error that occured. This is per-thread.
  * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
  */
-static char Read_Write_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+static thread_local char Read_Write_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+/**
+ * Mutex protecting the hedge configuration, first byte latency samples and statistics.
+ */
+static pthread_mutex_t Read_Write_Hedge_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * A boolean, TRUE if reads into reallocated memory are hedged.
+ */
+static int Read_Write_Hedge_Enabled = FALSE;
+/**
+ * The first byte latency percentile a hedged read waits for before starting a hedge request.
+ * @see #GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_PERCENTILE
+ */
+static double Read_Write_Hedge_Percentile = GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_PERCENTILE;
+/**
+ * The cap on hedge requests, as a percentage of hedged reads.
+ * @see #GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_EXTRA_PERCENT
+ */
+static double Read_Write_Hedge_Max_Extra_Percent = GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_EXTRA_PERCENT;
+/**
+ * The longest read that is hedged, in bytes.
+ * @see #GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_LENGTH
+ */
+static size_t Read_Write_Hedge_Max_Length = GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_LENGTH;
+/**
+ * A circular list of the most recent first byte latencies of primary requests, in milliseconds.
+ * @see #READ_WRITE_HEDGE_SAMPLE_COUNT
+ */
+static double Read_Write_Hedge_Sample_List[READ_WRITE_HEDGE_SAMPLE_COUNT];
+/**
+ * The total number of first byte latencies added to Read_Write_Hedge_Sample_List.
+ */
+static unsigned long long Read_Write_Hedge_Sample_Total = 0;
+/**
+ * The hedged read statistics.
+ */
+static struct GCP_Client_Read_Write_Hedge_Stats_Struct Read_Write_Hedge_Stats = {0,0,0,0,0,0,0,0.0};
+
+/* internal functions */
+static int Read_Write_Read(const char *function_name,char *bucket_name,char *filename,int pooled,int ranged,
+			   unsigned long long offset,size_t length,void **file_contents_ptr,size_t *file_contents_length,
+			   struct GCP_Client_Operation_Struct *operation);
+static int Read_Write_Write(const char *function_name,char *bucket_name,char *filename,
+			    void *file_contents_ptr,size_t file_contents_length,
+			    struct GCP_Client_Operation_Struct *operation);
+static void Read_Write_Operation_Stopped(const char *function_name,int state,char *bucket_name,char *filename,
+					 unsigned long long byte_count);
+static int Read_Write_Read_Hedged(const char *function_name,char *bucket_name,char *filename,int ranged,
+				  unsigned long long offset,size_t length,
+				  void **file_contents_ptr,size_t *file_contents_length);
+static void *Read_Write_Hedge_Attempt_Thread(void *user_data);
+static int Read_Write_Hedge_Attempt(struct Read_Write_Hedge_Attempt_Struct *attempt,void **contents_ptr,
+				    size_t *contents_length,int *cancelled);
+static int Read_Write_Hedge_Attempt_Start(struct Read_Write_Hedge_Attempt_Struct *attempt);
+static void Read_Write_Hedge_Free(struct Read_Write_Hedge_Struct *hedge);
+static double Read_Write_Hedge_Threshold(void);
+static void Read_Write_Hedge_Add_Sample(double first_byte_ms);
+static void Read_Write_Parallel_Worker(int index,void *user_data);
+static int Read_Write_Parallel_Part(struct Read_Write_Parallel_Struct *parallel,size_t offset,size_t length,
+				    double *transfer_time,double *rtt);
 
 /* --------------------------------------------------------
 ** External Functions
@@ -56,214 +281,658 @@ static char Read_Write_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = ""
  *        (the amount of memory allocated).
  * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
  *         Read_Write_Error_String should contain details of the failure.
- * @see #READ_WRITE_BUFFER_RESIZE_LENGTH
- * @see #Read_Write_Error_Number
- * @see #Read_Write_Error_String
+ * @see #GCP_Client_Read_Write_Hedge_Set
+ * @see #Read_Write_Read
  */
 int GCP_Client_Read_Write_Read(char* bucket_name,char* filename,
 				      void **file_contents_ptr,size_t *file_contents_length)
 {
-	::google::cloud::storage::Client client;
-	char *ch_ptr;
-	int done;
-	
+	return Read_Write_Read("GCP_Client_Read_Write_Read",bucket_name,filename,FALSE,FALSE,0,0,file_contents_ptr,
+			       file_contents_length,NULL);
+}
+
+/**
+ * Routine to read the contents of the file filename in the specified google cloud platform bucket into a buffer
+ * from the library's buffer pool, rather than newly allocated memory. The buffer is sized from the object's
+ * length (when the server reports it), so it is not grown and copied as the object is read. Programs reading
+ * many objects should use this routine, so the same (already faulted in) memory is re-used for each object.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param buffer_ptr The address of a void pointer, on a successful return from this routine set to a pool
+ *        buffer containing the contents of the file. The buffer must be returned with GCP_Client_Buffer_Release
+ *        (not free) when it has been finished with. If the read fails, no buffer is returned.
+ * @param buffer_length The address of a size_t variable, on a successful return from this routine set to the
+ *        number of bytes in the file (the buffer may be longer).
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number /
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #Read_Write_Read
+ * @see gcp_client_buffer.html#GCP_Client_Buffer_Release
+ */
+int GCP_Client_Read_Write_Read_Buffer(char* bucket_name,char* filename,void **buffer_ptr,size_t *buffer_length)
+{
+	return Read_Write_Read("GCP_Client_Read_Write_Read_Buffer",bucket_name,filename,TRUE,FALSE,0,0,buffer_ptr,
+			       buffer_length,NULL);
+}
+
+/**
+ * Routine to read part of the file filename in the specified google cloud platform bucket: length bytes
+ * starting offset bytes into the file (or fewer, if the file ends first). The bytes are read into a reallocatable
+ * memory area pointer (file_contents_ptr) which should be freed when it has been finished being used.
+ * If hedging is enabled, and length is no longer than the maximum hedged length, the read is hedged.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param offset The offset in the file of the first byte to read.
+ * @param length The number of bytes to read.
+ * @param file_contents_ptr The address of a void pointer, on a successful return from this routine a pointer to an
+ *         allocated area of memory containing the bytes read.
+ * @param file_contents_length The address of a size_t variable, on a successful return from this routine
+ *        set to the number of bytes read.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #GCP_Client_Read_Write_Hedge_Set
+ * @see #Read_Write_Read
+ */
+int GCP_Client_Read_Write_Read_Range(char* bucket_name,char* filename,unsigned long long offset,
+				     size_t length,void **file_contents_ptr,size_t *file_contents_length)
+{
 	Read_Write_Error_Number = 0;
-#if LOGGING > 1
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_TERSE,"GCP_Client_Read_Write_Read(bucket=%s,filename=%s):Started.",
-				      bucket_name,filename);
-#endif
-	if(bucket_name == NULL)
+	if(length == 0)
 	{
-		Read_Write_Error_Number = 1;
-		sprintf(Read_Write_Error_String, "GCP_Client_Read_Write_Read: bucket_name was NULL.");
+		Read_Write_Error_Number = 22;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read_Range: length was 0.");
 		return FALSE;
 	}
-	if(filename == NULL)
+	return Read_Write_Read("GCP_Client_Read_Write_Read_Range",bucket_name,filename,FALSE,TRUE,offset,length,
+			       file_contents_ptr,file_contents_length,NULL);
+}
+
+/**
+ * Routine to read the contents of the file filename in the specified google cloud platform bucket, as part of an
+ * operation. The read is bounded by the operation's deadline and stall timeout, and can be cancelled from another
+ * thread with GCP_Client_Operation_Cancel. The operation is checked between each READ_WRITE_BUFFER_RESIZE_LENGTH
+ * bytes read, and a request that hangs is ended by the stall timeout. If the read is stopped, the memory read so
+ * far is freed, and the routine fails with error 31 (cancelled), 32 (deadline exceeded), 33 (stalled) or
+ * 37 (paused, after which the read has to start again). The operation's state is set to how the read ended.
+ * Reads that are part of an operation are not hedged.
+ * @param operation The operation, created with GCP_Client_Operation_Create. It must not be in use by another
+ *        transfer.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param file_contents_ptr The address of a void pointer, on a successful return from this routine a pointer to an
+ *         allocated area of memory is returned, with the contents of the file in memory, which should be freed.
+ * @param file_contents_length The address of a size_t variable, on a successful return from this routine
+ *        set to the number of bytes in the file.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #Read_Write_Read
+ * @see gcp_client_operation.html#GCP_Client_Operation_Begin
+ * @see gcp_client_operation.html#GCP_Client_Operation_End
+ */
+int GCP_Client_Read_Write_Read_Operation(struct GCP_Client_Operation_Struct *operation,char* bucket_name,
+					 char* filename,void **file_contents_ptr,size_t *file_contents_length)
+{
+	int retval;
+
+	Read_Write_Error_Number = 0;
+	if(operation == NULL)
 	{
-		Read_Write_Error_Number = 2;
-		sprintf(Read_Write_Error_String, "GCP_Client_Read_Write_Read: filename was NULL.");
+		Read_Write_Error_Number = 35;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read_Operation: operation was NULL.");
 		return FALSE;
 	}
-	if(file_contents_ptr == NULL)
+	if(!GCP_Client_Operation_Begin(operation))
 	{
-		Read_Write_Error_Number = 3;
-		sprintf(Read_Write_Error_String, "GCP_Client_Read_Write_Read: file_contents_ptr was NULL.");
+		Read_Write_Error_Number = 34;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read_Operation: operation is already in use.");
 		return FALSE;
 	}
-	if(file_contents_length == NULL)
+	retval = Read_Write_Read("GCP_Client_Read_Write_Read_Operation",bucket_name,filename,FALSE,FALSE,0,0,
+				 file_contents_ptr,file_contents_length,operation);
+	GCP_Client_Operation_End(operation,retval);
+	return retval;
+}
+
+/**
+ * Routine to read the contents of the file filename in the specified google cloud platform bucket, as several
+ * ranged parts read in parallel. The object's length and generation are fetched first, the memory for the whole
+ * object is allocated, and then each part is read straight into it's place in the memory. Each part is reserved
+ * from the memory budget whilst it is being read, so an object larger than the budget can still be read. The part
+ * length and the number of parts in progress at once are taken from the adaptive controller
+ * (GCP_CLIENT_ADAPTIVE_DIRECTION_READ) before each part is started, and each part's throughput and round trip time
+ * are recorded with it, so the settings follow the conditions as the read progresses. The memory returned
+ * (file_contents_ptr) should be freed when it has been finished being used.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param file_contents_ptr The address of a void pointer, on a successful return from this routine a pointer to an
+ *         allocated area of memory is returned, with the contents of the file in memory.
+ * @param file_contents_length The address of a size_t variable, on a successful return from this routine
+ *        set to the number of bytes in the file.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure (of the first part to fail, if a part
+ *         failed).
+ * @see #Read_Write_Parallel_Struct
+ * @see #Read_Write_Parallel_Worker
+ * @see #Read_Write_Error_Number
+ * @see #Read_Write_Error_String
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get_Limits
+ * @see gcp_client_batch.html#GCP_Client_Batch_Run
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ * @see gcp_client_budget.html#GCP_Client_Budget_Release
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Read_Write_Read_Parallel(char* bucket_name,char* filename,
+					void **file_contents_ptr,size_t *file_contents_length)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	struct Read_Write_Parallel_Struct parallel;
+	struct timespec start_time,trace_start_time,trace_phase_start_time;
+	char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+	size_t min_chunk_length;
+	int max_parallelism,thread_count;
+
+	Read_Write_Error_Number = 0;
+	if((bucket_name == NULL)||(filename == NULL)||(file_contents_ptr == NULL)||(file_contents_length == NULL))
 	{
-		Read_Write_Error_Number = 4;
-		sprintf(Read_Write_Error_String, "GCP_Client_Read_Write_Read: file_contents_length was NULL.");
+		Read_Write_Error_Number = 24;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read_Parallel: bucket_name, filename, "
+			"file_contents_ptr or file_contents_length was NULL.");
 		return FALSE;
 	}
-	/* get client from connection module */
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Read_Write_Read_Parallel(bucket=%s,filename=%s):Started.",
+					     bucket_name,filename);
+#endif
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
 	client = GCP_Client_Connection_Get_Client();
-	/* create a reader to start reading the specified object */
+	/* get the object's length, and the generation to read all the parts from */
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	auto metadata = client.GetObjectMetadata(bucket_name,filename);
+	GCP_Client_Trace_Span_End("metadata",bucket_name,filename,&trace_phase_start_time,0,(bool)metadata);
+	if(!metadata)
+	{
+		Read_Write_Error_Number = 25;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read_Parallel: Failed to get the metadata of "
+			"'%s' in '%s' with status '%s'.",filename,bucket_name,metadata.status().message().c_str());
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("read_parallel",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	parallel.Bucket_Name = bucket_name;
+	parallel.Filename = filename;
+	parallel.Generation = metadata->generation();
+	parallel.Length = (size_t)(metadata->size());
+	/* allocate at least one byte, so an empty object still returns memory to free */
+	parallel.Contents = (char*)malloc((parallel.Length > 0) ? parallel.Length : 1);
+	if(parallel.Contents == NULL)
+	{
+		Read_Write_Error_Number = 27;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read_Parallel: Failed to read '%s' from '%s' : "
+			"memory allocation error with size %lu.",filename,bucket_name,(unsigned long)parallel.Length);
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("read_parallel",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	parallel.Next_Offset = 0;
+	parallel.Active_Count = 0;
+	parallel.Failed = FALSE;
+	parallel.Error_Number = 0;
+	parallel.Error_String[0] = '\0';
+	pthread_mutex_init(&(parallel.Mutex),NULL);
+	pthread_cond_init(&(parallel.Condition),NULL);
+	/* enough threads for the most parts the controller could have in progress at once, but no more than the
+	** object has parts of the smallest length */
+	GCP_Client_Adaptive_Get_Limits(GCP_CLIENT_ADAPTIVE_DIRECTION_READ,&min_chunk_length,NULL,NULL,
+				       &max_parallelism);
+	thread_count = max_parallelism;
+	if(((parallel.Length+min_chunk_length-1)/min_chunk_length) < (size_t)thread_count)
+		thread_count = (int)((parallel.Length+min_chunk_length-1)/min_chunk_length);
+	if(thread_count < 1)
+		thread_count = 1;
+	if(!GCP_Client_Batch_Run(thread_count,thread_count,Read_Write_Parallel_Worker,&parallel))
+	{
+		error_string[0] = '\0';
+		GCP_Client_Batch_Error_String(error_string);
+		parallel.Failed = TRUE;
+		parallel.Error_Number = 28;
+		snprintf(parallel.Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Read_Write_Read_Parallel: Failed to run part threads:%s",error_string);
+	}
+	pthread_cond_destroy(&(parallel.Condition));
+	pthread_mutex_destroy(&(parallel.Mutex));
+	if(parallel.Failed)
+	{
+		free(parallel.Contents);
+		Read_Write_Error_Number = parallel.Error_Number;
+		strcpy(Read_Write_Error_String,parallel.Error_String);
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("read_parallel",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	(*file_contents_ptr) = parallel.Contents;
+	(*file_contents_length) = parallel.Length;
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,parallel.Length,TRUE);
+	GCP_Client_Trace_Span_End("read_parallel",bucket_name,filename,&trace_start_time,parallel.Length,TRUE);
 #if LOGGING > 1
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_VERBOSE,
-				      "GCP_Client_Read_Write_Read:ReadObject(bucket=%s,filename=%s).",
-				      bucket_name,filename);
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Read_Write_Read_Parallel(bucket=%s,filename=%s):"
+					     "Finished reading %lu bytes.",
+					     bucket_name,filename,(unsigned long)parallel.Length);
 #endif
-	auto reader = client.ReadObject(bucket_name,filename);
-	if(! reader)
+	return TRUE;
+}
+
+/**
+ * Routine to write the contents of the supplied memory pointer to the specified 
+ * filename in the specified google cloud platform bucket.
+ * The object is uploaded in chunks of the length chosen by the adaptive controller
+ * (GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD), and the upload's throughput and round trip time (the time taken to
+ * open the upload) are recorded with it.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param file_contents_ptr A void pointer, to an allocated area of memory of length file_contents_length,
+ *        containing the data to write into the specified google cloud platform file.
+ * @param file_contents_length A size_t containing the number of bytes in the memory area pointed to by file_contents_ptr.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #Read_Write_Write
+ */
+int GCP_Client_Read_Write_Write(char* bucket_name,char* filename,
+				       void *file_contents_ptr,size_t file_contents_length)
+{
+	return Read_Write_Write("GCP_Client_Read_Write_Write",bucket_name,filename,file_contents_ptr,
+				file_contents_length,NULL);
+}
+
+/**
+ * Routine to write the contents of the supplied memory pointer to the specified filename in the specified
+ * google cloud platform bucket, as part of an operation. The upload is bounded by the operation's deadline and
+ * stall timeout, and can be cancelled from another thread with GCP_Client_Operation_Cancel. The operation is
+ * checked between each READ_WRITE_BUFFER_RESIZE_LENGTH bytes written. If the upload is stopped, it's resumable
+ * upload session is deleted, and the routine fails with error 31 (cancelled), 32 (deadline exceeded) or
+ * 33 (stalled). The operation's state is set to how the upload ended. If the operation is paused
+ * (GCP_Client_Operation_Pause) the routine fails with error 37, but the session is kept: after
+ * GCP_Client_Operation_Resume, calling this routine again with the same operation and data carries on the upload
+ * from where it stopped.
+ * @param operation The operation, created with GCP_Client_Operation_Create. It must not be in use by another
+ *        transfer.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param file_contents_ptr A void pointer, to an allocated area of memory of length file_contents_length,
+ *        containing the data to write into the specified google cloud platform file.
+ * @param file_contents_length A size_t containing the number of bytes in the memory area pointed to by file_contents_ptr.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #Read_Write_Write
+ * @see gcp_client_operation.html#GCP_Client_Operation_Begin
+ * @see gcp_client_operation.html#GCP_Client_Operation_End
+ */
+int GCP_Client_Read_Write_Write_Operation(struct GCP_Client_Operation_Struct *operation,char* bucket_name,
+					  char* filename,void *file_contents_ptr,size_t file_contents_length)
+{
+	int retval;
+
+	Read_Write_Error_Number = 0;
+	if(operation == NULL)
+	{
+		Read_Write_Error_Number = 36;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Write_Operation: operation was NULL.");
+		return FALSE;
+	}
+	if(!GCP_Client_Operation_Begin(operation))
 	{
-		Read_Write_Error_Number = 9;
-		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read: Failed to read '%s' from '%s' "
-			"with status '%s'.",filename,bucket_name,reader.status().message().c_str());
+		Read_Write_Error_Number = 34;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Write_Operation: operation is already in use.");
 		return FALSE;
 	}
+	retval = Read_Write_Write("GCP_Client_Read_Write_Write_Operation",bucket_name,filename,file_contents_ptr,
+				  file_contents_length,operation);
+	GCP_Client_Operation_End(operation,retval);
+	return retval;
+}
+
+/**
+ * Read the contents of an input stream into a reallocatable memory area, growing it
+ * READ_WRITE_BUFFER_RESIZE_LENGTH bytes at a time. This is the in-memory part of GCP_Client_Read_Write_Read,
+ * seperated out so it can be fed by any std::istream (for instance, an in-memory stream in a microbenchmark).
+ * The first read is traced as the "first_byte" span, the remainder as the "stream" span.
+ * If an operation is supplied, it's progress is updated after each part, and it is checked before the next part
+ * is read. If it has been cancelled, passed it's deadline, or stalled, the read fails.
+ * If budget_length is supplied, the memory area is charged to the memory budget as it grows, so an object of
+ * unknown length is bounded by the budget: whenever the area grows beyond the bytes already reserved, the growth
+ * is reserved first, and if it cannot be reserved the read fails.
+ * @param stream The stream to read from, until end of file.
+ * @param bucket_name The name of the bucket the stream is reading from, used for error messages and tracing.
+ * @param filename The name of the object the stream is reading from, used for error messages and tracing.
+ * @param file_contents_ptr The address of a void pointer, on return a pointer to an allocated area of memory 
+ *        containing the stream contents, which should be freed by the caller. On failure the memory is freed,
+ *        and the pointer set to NULL.
+ * @param file_contents_length The address of a size_t variable, on return the number of bytes read.
+ * @param operation The operation the read is part of, or NULL.
+ * @param budget_length The address of the number of bytes of memory budget (GCP_CLIENT_BUDGET_USE_READ) already
+ *        reserved for the read, which is increased by any further bytes reserved, or NULL if the read is not
+ *        charged to the memory budget. The caller releases the bytes reserved once the read has returned.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #READ_WRITE_BUFFER_RESIZE_LENGTH
+ * @see #Read_Write_Error_Number
+ * @see #Read_Write_Error_String
+ * @see #Read_Write_Operation_Stopped
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Acquire
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ * @see gcp_client_operation.html#GCP_Client_Operation_Check
+ * @see gcp_client_operation.html#GCP_Client_Operation_Progress
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Read_Write_Read_Stream(std::istream &stream,char *bucket_name,char *filename,
+				      void **file_contents_ptr,size_t *file_contents_length,
+				      struct GCP_Client_Operation_Struct *operation,unsigned long long *budget_length)
+{
+	struct timespec trace_phase_start_time;
+	void *new_file_contents_ptr = NULL;
+	unsigned long long allocated_length;
+	char *ch_ptr;
+	int done,first_byte_traced,state;
+
 	(*file_contents_ptr) = NULL;
 	(*file_contents_length) = 0;
 	done = FALSE;
+	first_byte_traced = FALSE;
+	/* the first read call covers the time to first byte, subsequent calls are streaming */
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
 	while(done == FALSE)
 	{
-		/* allocate more memory for the file contents */
-		if((*file_contents_ptr) == NULL)
-		{
-			(*file_contents_ptr) = (void*)malloc(((*file_contents_length)+READ_WRITE_BUFFER_RESIZE_LENGTH)*
-							     sizeof(char));
-		}
-		else
+		/* reserve any memory the file contents are about to grow beyond, before allocating it */
+		allocated_length = (*file_contents_length)+READ_WRITE_BUFFER_RESIZE_LENGTH;
+		if((budget_length != NULL)&&(allocated_length > (*budget_length)))
 		{
-			(*file_contents_ptr) = (void*)realloc((*file_contents_ptr),
-							     ((*file_contents_length)+READ_WRITE_BUFFER_RESIZE_LENGTH)*
-							     sizeof(char));
+			if(!GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_READ,allocated_length-(*budget_length),
+						      GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT))
+			{
+				Read_Write_Error_Number = 39;
+				sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read: Failed to read '%s' from '%s' "
+					": failed to reserve memory budget to grow to %llu bytes.",filename,bucket_name,
+					allocated_length);
+				free(*file_contents_ptr);
+				(*file_contents_ptr) = NULL;
+				GCP_Client_Trace_Span_End(first_byte_traced ? "stream" : "first_byte",bucket_name,filename,
+							  &trace_phase_start_time,(*file_contents_length),FALSE);
+				return FALSE;
+			}
+			(*budget_length) = allocated_length;
 		}
-		if((*file_contents_ptr) == NULL)
+		/* allocate more memory for the file contents */
+		new_file_contents_ptr = (void*)realloc((*file_contents_ptr),allocated_length*sizeof(char));
+		if(new_file_contents_ptr == NULL)
 		{
 			Read_Write_Error_Number = 10;
 			sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read: Failed to read '%s' from '%s' "
 				": memory allocation error with size %ld.",filename,bucket_name,(*file_contents_length));
+			free(*file_contents_ptr);
+			(*file_contents_ptr) = NULL;
+			GCP_Client_Trace_Span_End(first_byte_traced ? "stream" : "first_byte",bucket_name,filename,
+						  &trace_phase_start_time,(*file_contents_length),FALSE);
 			return FALSE;
 		}
+		(*file_contents_ptr) = new_file_contents_ptr;
 		ch_ptr = ((char*)(*file_contents_ptr))+(*file_contents_length);
 		/* load the next part of the file into memory */
-		reader.read(ch_ptr,READ_WRITE_BUFFER_RESIZE_LENGTH);
-		if(! reader)
+		stream.read(ch_ptr,READ_WRITE_BUFFER_RESIZE_LENGTH);
+		GCP_Client_Bandwidth_Acquire(GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD,stream.gcount());
+		GCP_Client_Operation_Progress(operation,stream.gcount());
+		if(! stream)
 		{
-			if(reader.eof())
+			if(stream.eof())
 			{
 				done = TRUE;
-				(*file_contents_length) += reader.gcount();
+				(*file_contents_length) += stream.gcount();
 			}
 			else
 			{
 				done = TRUE;
-				Read_Write_Error_Number = 12;
-				sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read: Failed to read '%s' from '%s' "
-					": file read failed after %ld of %ld bytes (%s).",filename,bucket_name,
-					reader.gcount(),(*file_contents_length),reader.status().message().c_str());
+				state = GCP_Client_Operation_Check(operation,TRUE);
+				if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+				{
+					Read_Write_Operation_Stopped("GCP_Client_Read_Write_Read_Stream",state,bucket_name,
+								     filename,(*file_contents_length)+stream.gcount());
+				}
+				else
+				{
+					Read_Write_Error_Number = 12;
+					sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read: Failed to read '%s' "
+						"from '%s' : file read failed after %ld of %ld bytes.",filename,bucket_name,
+						stream.gcount(),(*file_contents_length));
+				}
+				free(*file_contents_ptr);
+				(*file_contents_ptr) = NULL;
+				GCP_Client_Trace_Span_End(first_byte_traced ? "stream" : "first_byte",bucket_name,filename,
+							  &trace_phase_start_time,(*file_contents_length),FALSE);
 				return FALSE;
 			}
 		}
-		if(reader.eof() == FALSE)
+		if(stream.eof() == FALSE)
+		{
 			(*file_contents_length) += READ_WRITE_BUFFER_RESIZE_LENGTH;
+			/* stop between parts if the operation has been cancelled, or it's deadline has passed */
+			state = GCP_Client_Operation_Check(operation,FALSE);
+			if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+			{
+				Read_Write_Operation_Stopped("GCP_Client_Read_Write_Read_Stream",state,bucket_name,filename,
+							     (*file_contents_length));
+				free(*file_contents_ptr);
+				(*file_contents_ptr) = NULL;
+				GCP_Client_Trace_Span_End(first_byte_traced ? "stream" : "first_byte",bucket_name,filename,
+							  &trace_phase_start_time,(*file_contents_length),FALSE);
+				return FALSE;
+			}
+		}
+		if(first_byte_traced == FALSE)
+		{
+			GCP_Client_Trace_Span_End("first_byte",bucket_name,filename,&trace_phase_start_time,
+						  (*file_contents_length),TRUE);
+			GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+			first_byte_traced = TRUE;
+		}
 	}/* end while not done */
-	reader.Close();
-	/* we could resize the (*file_contents_ptr) to preceisly match (*file_contents_length) if we wanted to here,
-	** this would prevent small files being returned in a 1 Meg buffer */
-#if LOGGING > 1
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_TERSE,
-				      "GCP_Client_Read_Write_Read(bucket=%s,filename=%s):Finished reading %ld bytes.",
-				      bucket_name,filename,(*file_contents_length));
-#endif
+	GCP_Client_Trace_Span_End("stream",bucket_name,filename,&trace_phase_start_time,(*file_contents_length),TRUE);
 	return TRUE;
 }
 
 /**
- * Routine to write the contents of the supplied memory pointer to the specified 
- * filename in the specified google cloud platform bucket.
- * @param bucket_name The name of the bucket.
- * @param filename The filename of the file within the google cloud storage bucket.
- * @param file_contents_ptr A void pointer, to an allocated area of memory of length file_contents_length,
- *        containing the data to write into the specified google cloud platform file.
- * @param file_contents_length A size_t containing the number of bytes in the memory area pointed to by file_contents_ptr.
+ * Read the contents of an input stream into a buffer from the library's buffer pool. The buffer is first acquired
+ * one byte longer than length_hint, so when the hint is the object's length the end of the stream is found without
+ * growing the buffer. Otherwise the buffer is grown to the next size class whenever it fills.
+ * The first read is traced as the "first_byte" span, the remainder as the "stream" span.
+ * @param stream The stream to read from, until end of file.
+ * @param bucket_name The name of the bucket the stream is reading from, used for error messages and tracing.
+ * @param filename The name of the object the stream is reading from, used for error messages and tracing.
+ * @param length_hint The expected length of the stream in bytes, or 0 if it is not known.
+ * @param buffer_ptr The address of a void pointer, on success set to a pool buffer containing the stream contents,
+ *        which should be returned with GCP_Client_Buffer_Release. On failure the buffer is released, and
+ *        the pointer set to NULL.
+ * @param buffer_length The address of a size_t variable, on return the number of bytes read.
+ * @param operation The operation the read is part of, or NULL. It is checked between parts, as in
+ *        GCP_Client_Read_Write_Read_Stream.
  * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
  *         Read_Write_Error_String should contain details of the failure.
+ * @see #READ_WRITE_BUFFER_RESIZE_LENGTH
  * @see #Read_Write_Error_Number
  * @see #Read_Write_Error_String
+ * @see #Read_Write_Operation_Stopped
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Acquire
+ * @see gcp_client_buffer.html#GCP_Client_Buffer_Grow
+ * @see gcp_client_buffer.html#GCP_Client_Buffer_Release
+ * @see gcp_client_operation.html#GCP_Client_Operation_Check
+ * @see gcp_client_operation.html#GCP_Client_Operation_Progress
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
  */
-int GCP_Client_Read_Write_Write(char* bucket_name,char* filename,
-				       void *file_contents_ptr,size_t file_contents_length)
+int GCP_Client_Read_Write_Read_Stream_Buffer(std::istream &stream,char *bucket_name,char *filename,
+					     size_t length_hint,void **buffer_ptr,size_t *buffer_length,
+					     struct GCP_Client_Operation_Struct *operation)
 {
-	namespace gcs = ::google::cloud::storage;
-	gcs::Client client;
+	struct timespec trace_phase_start_time;
+	size_t capacity,read_length;
+	int done,first_byte_traced,state;
 
-	Read_Write_Error_Number = 0;
-	if(bucket_name == NULL)
-	{
-		Read_Write_Error_Number = 5;
-		sprintf(Read_Write_Error_String, "GCP_Client_Read_Write_Write: bucket_name was NULL.");
-		return FALSE;
-	}
-	if(filename == NULL)
+	(*buffer_ptr) = NULL;
+	(*buffer_length) = 0;
+	capacity = 0;
+	done = FALSE;
+	first_byte_traced = FALSE;
+	/* the first read call covers the time to first byte, subsequent calls are streaming */
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	while(done == FALSE)
 	{
-		Read_Write_Error_Number = 6;
-		sprintf(Read_Write_Error_String, "GCP_Client_Read_Write_Write: filename was NULL.");
-		return FALSE;
-	}
-	if(file_contents_ptr == NULL)
+		/* acquire (or grow) the buffer when it is full */
+		if(((*buffer_ptr) == NULL)||((*buffer_length) == capacity))
+		{
+			if(!GCP_Client_Buffer_Grow(buffer_ptr,(*buffer_length),
+						   ((*buffer_ptr) == NULL) ? length_hint+1 : capacity+1,&capacity))
+			{
+				Read_Write_Error_Number = 13;
+				sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read_Stream_Buffer: Failed to read "
+					"'%s' from '%s' : failed to get a pool buffer after %lu bytes.",filename,bucket_name,
+					(unsigned long)(*buffer_length));
+				GCP_Client_Buffer_Release(*buffer_ptr);
+				(*buffer_ptr) = NULL;
+				GCP_Client_Trace_Span_End(first_byte_traced ? "stream" : "first_byte",bucket_name,filename,
+							  &trace_phase_start_time,(*buffer_length),FALSE);
+				return FALSE;
+			}
+		}
+		read_length = capacity-(*buffer_length);
+		if(read_length > READ_WRITE_BUFFER_RESIZE_LENGTH)
+			read_length = READ_WRITE_BUFFER_RESIZE_LENGTH;
+		/* load the next part of the file into memory */
+		stream.read(((char*)(*buffer_ptr))+(*buffer_length),read_length);
+		(*buffer_length) += stream.gcount();
+		GCP_Client_Bandwidth_Acquire(GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD,stream.gcount());
+		GCP_Client_Operation_Progress(operation,stream.gcount());
+		if(! stream)
+		{
+			if(stream.eof())
+				done = TRUE;
+			else
+			{
+				state = GCP_Client_Operation_Check(operation,TRUE);
+				if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+				{
+					Read_Write_Operation_Stopped("GCP_Client_Read_Write_Read_Stream_Buffer",state,
+								     bucket_name,filename,(*buffer_length));
+				}
+				else
+				{
+					Read_Write_Error_Number = 12;
+					sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Read: Failed to read '%s' "
+						"from '%s' : file read failed after %lu bytes.",filename,bucket_name,
+						(unsigned long)(*buffer_length));
+				}
+				GCP_Client_Buffer_Release(*buffer_ptr);
+				(*buffer_ptr) = NULL;
+				GCP_Client_Trace_Span_End(first_byte_traced ? "stream" : "first_byte",bucket_name,filename,
+							  &trace_phase_start_time,(*buffer_length),FALSE);
+				return FALSE;
+			}
+		}
+		/* stop between parts if the operation has been cancelled, or it's deadline has passed */
+		if(done == FALSE)
+		{
+			state = GCP_Client_Operation_Check(operation,FALSE);
+			if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+			{
+				Read_Write_Operation_Stopped("GCP_Client_Read_Write_Read_Stream_Buffer",state,bucket_name,
+							     filename,(*buffer_length));
+				GCP_Client_Buffer_Release(*buffer_ptr);
+				(*buffer_ptr) = NULL;
+				GCP_Client_Trace_Span_End(first_byte_traced ? "stream" : "first_byte",bucket_name,filename,
+							  &trace_phase_start_time,(*buffer_length),FALSE);
+				return FALSE;
+			}
+		}
+		if(first_byte_traced == FALSE)
+		{
+			GCP_Client_Trace_Span_End("first_byte",bucket_name,filename,&trace_phase_start_time,
+						  (*buffer_length),TRUE);
+			GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+			first_byte_traced = TRUE;
+		}
+	}/* end while not done */
+	GCP_Client_Trace_Span_End("stream",bucket_name,filename,&trace_phase_start_time,(*buffer_length),TRUE);
+	return TRUE;
+}
+
+/**
+ * Configure hedged reads. When enabled, GCP_Client_Read_Write_Read and GCP_Client_Read_Write_Read_Range (for
+ * ranges no longer than max_length) wait for the first byte of the response for the percentile of recent first
+ * byte latencies, and if it has not arrived start a duplicate request. Whichever request finishes first is
+ * returned, and the other is cancelled. Hedging starts once enough first byte latencies have been measured.
+ * Pooled reads (GCP_Client_Read_Write_Read_Buffer) are not hedged.
+ * @param enable A boolean, TRUE to hedge reads, FALSE not to.
+ * @param percentile The first byte latency percentile to wait for, between 0 and 100
+ *        (GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_PERCENTILE).
+ * @param max_extra_percent The cap on duplicate requests, as a percentage of hedged reads
+ *        (GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_EXTRA_PERCENT).
+ * @param max_length The longest read that is hedged, in bytes (GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_LENGTH).
+ *        A whole object read's length is not known until it's response arrives, so a hedge request for an object
+ *        longer than this is abandoned when it's response arrives.
+ * @see #Read_Write_Hedge_Mutex
+ * @see #Read_Write_Hedge_Enabled
+ * @see #Read_Write_Hedge_Percentile
+ * @see #Read_Write_Hedge_Max_Extra_Percent
+ * @see #Read_Write_Hedge_Max_Length
+ */
+void GCP_Client_Read_Write_Hedge_Set(int enable,double percentile,double max_extra_percent,size_t max_length)
+{
+	if(percentile < 0.0)
+		percentile = 0.0;
+	if(percentile > 100.0)
+		percentile = 100.0;
+	if(max_extra_percent < 0.0)
+		max_extra_percent = 0.0;
+	pthread_mutex_lock(&Read_Write_Hedge_Mutex);
+	Read_Write_Hedge_Enabled = enable;
+	Read_Write_Hedge_Percentile = percentile;
+	Read_Write_Hedge_Max_Extra_Percent = max_extra_percent;
+	Read_Write_Hedge_Max_Length = max_length;
+	pthread_mutex_unlock(&Read_Write_Hedge_Mutex);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Read_Write_Hedge_Set:Hedging %s at the p%.1f first byte latency, "
+					     "at most %.1f%% extra requests, for reads of up to %lu bytes.",
+					     enable ? "enabled" : "disabled",percentile,max_extra_percent,
+					     (unsigned long)max_length);
+#endif
+}
+
+/**
+ * Get a copy of the hedged read statistics.
+ * @param stats The address of a structure to copy the statistics into.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number /
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #Read_Write_Hedge_Stats
+ * @see #Read_Write_Hedge_Threshold
+ */
+int GCP_Client_Read_Write_Hedge_Get_Stats(struct GCP_Client_Read_Write_Hedge_Stats_Struct *stats)
+{
+	Read_Write_Error_Number = 0;
+	if(stats == NULL)
 	{
-		Read_Write_Error_Number = 7;
-		sprintf(Read_Write_Error_String, "GCP_Client_Read_Write_Write: file_contents_ptr was NULL.");
+		Read_Write_Error_Number = 23;
+		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Hedge_Get_Stats: stats was NULL.");
 		return FALSE;
 	}
-	if(file_contents_length == 0)
-	{
-		Read_Write_Error_Number = 8;
-		sprintf(Read_Write_Error_String, "GCP_Client_Read_Write_Read: file_contents_length was 0.");
-		return FALSE;
-	}
-#if LOGGING > 1
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_INTERMEDIATE,
-				      "GCP_Client_Read_Write_Write:Starting writing %ld bytes to bucket '%s' filename '%s'.",
-				      file_contents_length,bucket_name,filename);
-#endif
-	/* get client from connection module */
-	client = GCP_Client_Connection_Get_Client();
-	/* create a writer to write the specified object to the cloud */
-#if LOGGING > 1
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_VERBOSE,
-				      "GCP_Client_Read_Write_Write:WriteObject(bucket=%s,filename=%s).",
-				      bucket_name,filename);
-#endif
-	auto writer = client.WriteObject(bucket_name,filename);
-	if(! writer)
-	{
-		Read_Write_Error_Number = 11;
-		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Write: Failed to write '%s' to '%s'.",
-			filename,bucket_name);
-		return FALSE;
-	}
-	/* write data */
-#if LOGGING > 1
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_VERBOSE,
-		       "GCP_Client_Read_Write_Write:writing data of length %ld bytes to bucket '%s' filename '%s'.",
-				      file_contents_length,bucket_name,filename);
-#endif
-	writer.write((const char*)file_contents_ptr,file_contents_length);
-	/* close stream */
-#if LOGGING > 5
-	GCP_Client_General_Log(LOG_VERBOSITY_VERY_VERBOSE,"GCP_Client_Read_Write_Write:Closing stream.");
-#endif
-	writer.Close();
-	/* check for success/failure */
-#if LOGGING > 5
-	GCP_Client_General_Log(LOG_VERBOSITY_VERY_VERBOSE,"GCP_Client_Read_Write_Write:Checking metadata for success.");
-#endif
-	auto metadata = std::move(writer).metadata();
-	if (!metadata)
-	{
-		Read_Write_Error_Number = 12;
-		sprintf(Read_Write_Error_String,"GCP_Client_Read_Write_Write: Failed to write '%s' to '%s' "
-			"with status '%s'.",filename,bucket_name,std::move(metadata).status().message().c_str());
-		return FALSE;
-	}
-#if LOGGING > 1
-	GCP_Client_General_Log_Format(LOG_VERBOSITY_INTERMEDIATE,
-				      "GCP_Client_Read_Write_Write:Finished writing to bucket '%s' filename '%s'.",
-				      bucket_name,filename);
-#endif
+	pthread_mutex_lock(&Read_Write_Hedge_Mutex);
+	/* bring the threshold up to date */
+	Read_Write_Hedge_Threshold();
+	(*stats) = Read_Write_Hedge_Stats;
+	pthread_mutex_unlock(&Read_Write_Hedge_Mutex);
 	return TRUE;
 }
 
@@ -320,3 +989,1193 @@ void GCP_Client_Read_Write_Error_String(char *error_string)
 	sprintf(error_string+strlen(error_string),"%s GCP_Client_Read_Write:Error(%d) : %s\n",time_string,
 		Read_Write_Error_Number,Read_Write_Error_String);
 }
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Read the contents of the file filename in the specified google cloud platform bucket into memory, either
+ * a reallocatable memory area, or a buffer from the buffer pool.
+ * @param function_name The name of the calling external routine, used in log and error messages.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param pooled If TRUE, read the object into a pool buffer (GCP_Client_Read_Write_Read_Stream_Buffer), otherwise
+ *        into a reallocated memory area (GCP_Client_Read_Write_Read_Stream). A reallocated read reserves the
+ *        object's length (rounded up to the next READ_WRITE_BUFFER_RESIZE_LENGTH) from the memory budget, or
+ *        READ_WRITE_BUFFER_RESIZE_LENGTH if the length is not known, and reserves more as the memory area
+ *        grows beyond it. The reservation is held whilst the object is being read: the memory area is then the
+ *        caller's, freed with free() rather than through the library, so a caller that wants the object contents
+ *        charged until it has finished with them should read them pooled. If hedging is enabled, reads that are
+ *        not pooled (and not part of an operation) are hedged (Read_Write_Read_Hedged).
+ * @param ranged If TRUE, only read length bytes starting at offset.
+ * @param offset The offset of the first byte to read, for a ranged read.
+ * @param length The number of bytes to read, for a ranged read.
+ * @param file_contents_ptr The address of a void pointer, on a successful return set to the memory containing
+ *        the contents of the file.
+ * @param file_contents_length The address of a size_t variable, on a successful return set to the number of
+ *        bytes in the file.
+ * @param operation The operation the read is part of (already begun), or NULL. It's options are passed to the
+ *        request, and it is checked before the request and between parts of the object.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #GCP_Client_Read_Write_Read_Stream
+ * @see #GCP_Client_Read_Write_Read_Stream_Buffer
+ * @see #Read_Write_Read_Hedged
+ * @see #Read_Write_Hedge_Enabled
+ * @see #Read_Write_Operation_Stopped
+ * @see #READ_WRITE_BUFFER_RESIZE_LENGTH
+ * @see #Read_Write_Error_Number
+ * @see #Read_Write_Error_String
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ * @see gcp_client_budget.html#GCP_Client_Budget_Release
+ * @see gcp_client_operation.html#GCP_Client_Operation_Check
+ * @see gcp_client_operation.html#GCP_Client_Operation_Get_Options
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+static int Read_Write_Read(const char *function_name,char *bucket_name,char *filename,int pooled,int ranged,
+			   unsigned long long offset,size_t length,void **file_contents_ptr,size_t *file_contents_length,
+			   struct GCP_Client_Operation_Struct *operation)
+{
+	namespace gcs = ::google::cloud::storage;
+	::google::cloud::storage::Client client;
+	struct timespec start_time,trace_start_time,trace_phase_start_time;
+	unsigned long long budget_length;
+	size_t length_hint;
+	int retval,hedged,state;
+	
+	Read_Write_Error_Number = 0;
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+					     LOG_VERBOSITY_TERSE,
+				      "%s(bucket=%s,filename=%s):Started.",function_name,bucket_name,filename);
+#endif
+	if(bucket_name == NULL)
+	{
+		Read_Write_Error_Number = 1;
+		sprintf(Read_Write_Error_String,"%s: bucket_name was NULL.",function_name);
+		return FALSE;
+	}
+	if(filename == NULL)
+	{
+		Read_Write_Error_Number = 2;
+		sprintf(Read_Write_Error_String,"%s: filename was NULL.",function_name);
+		return FALSE;
+	}
+	if(file_contents_ptr == NULL)
+	{
+		Read_Write_Error_Number = 3;
+		sprintf(Read_Write_Error_String,"%s: file_contents_ptr was NULL.",function_name);
+		return FALSE;
+	}
+	if(file_contents_length == NULL)
+	{
+		Read_Write_Error_Number = 4;
+		sprintf(Read_Write_Error_String,"%s: file_contents_length was NULL.",function_name);
+		return FALSE;
+	}
+	if((pooled == FALSE)&&(operation == NULL))
+	{
+		pthread_mutex_lock(&Read_Write_Hedge_Mutex);
+		hedged = Read_Write_Hedge_Enabled && ((ranged == FALSE)||(length <= Read_Write_Hedge_Max_Length));
+		pthread_mutex_unlock(&Read_Write_Hedge_Mutex);
+		if(hedged)
+		{
+			return Read_Write_Read_Hedged(function_name,bucket_name,filename,ranged,offset,length,
+						      file_contents_ptr,file_contents_length);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	/* get client from connection module */
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	GCP_Client_Trace_Span_End("client",bucket_name,filename,&trace_phase_start_time,0,TRUE);
+	/* create a reader to start reading the specified object */
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+					     LOG_VERBOSITY_VERBOSE,
+				      "%s:ReadObject(bucket=%s,filename=%s).",function_name,
+				      bucket_name,filename);
+#endif
+	/* an operation cancelled before the read started fails straight away */
+	state = GCP_Client_Operation_Check(operation,FALSE);
+	if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+	{
+		Read_Write_Operation_Stopped(function_name,state,bucket_name,filename,0);
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("read",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	/* the operation's stall timeout and deadline (if any) are passed on as request options */
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	auto reader = ranged ? client.ReadObject(bucket_name,filename,gcs::ReadRange(offset,offset+length),
+						 GCP_Client_Operation_Get_Options(operation)) :
+		client.ReadObject(bucket_name,filename,GCP_Client_Operation_Get_Options(operation));
+	GCP_Client_Trace_Span_End("open",bucket_name,filename,&trace_phase_start_time,0,(bool)reader);
+	if(! reader)
+	{
+		state = GCP_Client_Operation_Check(operation,TRUE);
+		if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+			Read_Write_Operation_Stopped(function_name,state,bucket_name,filename,0);
+		else
+		{
+			Read_Write_Error_Number = 9;
+			sprintf(Read_Write_Error_String,"%s: Failed to read '%s' from '%s' "
+				"with status '%s'.",function_name,filename,bucket_name,reader.status().message().c_str());
+		}
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("read",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	/* the object length, if the server sent it */
+	auto object_size = reader.size();
+	if(ranged)
+		length_hint = length;
+	else
+		length_hint = object_size.has_value() ? (size_t)(*object_size) : 0;
+	/* read the object contents into memory */
+	if(pooled)
+	{
+		/* the pool buffer is sized from the object length, and charged to the memory budget by the pool */
+		retval = GCP_Client_Read_Write_Read_Stream_Buffer(reader,bucket_name,filename,length_hint,
+								  file_contents_ptr,file_contents_length,operation);
+	}
+	else
+	{
+		/* charge the memory the read will allocate to the memory budget, whilst the object is being read,
+		** the stream read reserves any growth beyond the object length */
+		budget_length = ((length_hint/READ_WRITE_BUFFER_RESIZE_LENGTH)+1)*READ_WRITE_BUFFER_RESIZE_LENGTH;
+		if(!GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_READ,budget_length,
+					      GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT))
+		{
+			Read_Write_Error_Number = 14;
+			sprintf(Read_Write_Error_String,"%s: Failed to reserve %llu bytes of memory budget "
+				"to read '%s' from '%s'.",function_name,budget_length,filename,bucket_name);
+			GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,0,FALSE);
+			GCP_Client_Trace_Span_End("read",bucket_name,filename,&trace_start_time,0,FALSE);
+			return FALSE;
+		}
+		retval = GCP_Client_Read_Write_Read_Stream(reader,bucket_name,filename,file_contents_ptr,
+							   file_contents_length,operation,&budget_length);
+		GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_READ,budget_length);
+	}
+	if(!retval)
+	{
+		/* add the object stream's status to a read failure */
+		if(Read_Write_Error_Number == 12)
+		{
+			snprintf(Read_Write_Error_String+strlen(Read_Write_Error_String),
+				 GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-strlen(Read_Write_Error_String),
+				 " (%s)",reader.status().message().c_str());
+		}
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,(*file_contents_length),FALSE);
+		GCP_Client_Trace_Span_End("read",bucket_name,filename,&trace_start_time,(*file_contents_length),FALSE);
+		return FALSE;
+	}
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	reader.Close();
+	GCP_Client_Trace_Span_End("close",bucket_name,filename,&trace_phase_start_time,0,TRUE);
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,(*file_contents_length),TRUE);
+	GCP_Client_Trace_Span_End("read",bucket_name,filename,&trace_start_time,(*file_contents_length),TRUE);
+	/* we could resize the (*file_contents_ptr) to preceisly match (*file_contents_length) if we wanted to here,
+	** this would prevent small files being returned in a 1 Meg buffer */
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+					     LOG_VERBOSITY_TERSE,
+				      "%s(bucket=%s,filename=%s):Finished reading %ld bytes.",
+				      function_name,bucket_name,filename,(*file_contents_length));
+#endif
+	return TRUE;
+}
+
+/**
+ * Write the contents of the supplied memory pointer to the specified filename in the specified google cloud
+ * platform bucket. The object is uploaded in chunks of the length chosen by the adaptive controller
+ * (GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD), and the upload's throughput and round trip time (the time taken to
+ * open the upload) are recorded with it. The data is written to the upload stream READ_WRITE_BUFFER_RESIZE_LENGTH
+ * bytes at a time, and if an operation is supplied it is checked between each part. If the operation has been
+ * cancelled, passed it's deadline or stalled, the upload is suspended and it's resumable upload session deleted.
+ * If the operation has been paused, the session is kept in the operation instead, and when the operation is
+ * resumed and passed in again the session is restored, and the upload carries on from the next byte the server
+ * expects.
+ * @param function_name The name of the calling external routine, used in log and error messages.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param file_contents_ptr A void pointer, to an allocated area of memory of length file_contents_length,
+ *        containing the data to write into the specified google cloud platform file.
+ * @param file_contents_length A size_t containing the number of bytes in the memory area pointed to by file_contents_ptr.
+ * @param operation The operation the upload is part of (already begun), or NULL. It's options are passed to the
+ *        request.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #READ_WRITE_BUFFER_RESIZE_LENGTH
+ * @see #Read_Write_Error_Number
+ * @see #Read_Write_Error_String
+ * @see #Read_Write_Operation_Stopped
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Record
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Acquire
+ * @see gcp_client_fits.html#GCP_Client_Fits_Index_Metadata
+ * @see gcp_client_operation.html#GCP_Client_Operation_Check
+ * @see gcp_client_operation.html#GCP_Client_Operation_Get_Options
+ * @see gcp_client_operation.html#GCP_Client_Operation_Get_Session
+ * @see gcp_client_operation.html#GCP_Client_Operation_Progress
+ * @see gcp_client_operation.html#GCP_Client_Operation_Set_Session
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+static int Read_Write_Write(const char *function_name,char *bucket_name,char *filename,
+			    void *file_contents_ptr,size_t file_contents_length,
+			    struct GCP_Client_Operation_Struct *operation)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	gcs::ObjectMetadata object_metadata;
+	struct timespec start_time,trace_start_time,trace_phase_start_time;
+	struct timespec open_start_time,open_end_time,end_time;
+	std::string session_id;
+	size_t chunk_length,write_length,byte_count;
+	int state,fits_keyword_count;
+
+	Read_Write_Error_Number = 0;
+	if(bucket_name == NULL)
+	{
+		Read_Write_Error_Number = 5;
+		sprintf(Read_Write_Error_String,"%s: bucket_name was NULL.",function_name);
+		return FALSE;
+	}
+	if(filename == NULL)
+	{
+		Read_Write_Error_Number = 6;
+		sprintf(Read_Write_Error_String,"%s: filename was NULL.",function_name);
+		return FALSE;
+	}
+	if(file_contents_ptr == NULL)
+	{
+		Read_Write_Error_Number = 7;
+		sprintf(Read_Write_Error_String,"%s: file_contents_ptr was NULL.",function_name);
+		return FALSE;
+	}
+	if(file_contents_length == 0)
+	{
+		Read_Write_Error_Number = 8;
+		sprintf(Read_Write_Error_String,"%s: file_contents_length was 0.",function_name);
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+					     LOG_VERBOSITY_INTERMEDIATE,
+				      "%s:Starting writing %ld bytes to bucket '%s' filename '%s'.",
+				      function_name,file_contents_length,bucket_name,filename);
+#endif
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	/* get client from connection module */
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	GCP_Client_Trace_Span_End("client",bucket_name,filename,&trace_phase_start_time,0,TRUE);
+	/* create a writer to write the specified object to the cloud */
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+					     LOG_VERBOSITY_VERBOSE,
+				      "%s:WriteObject(bucket=%s,filename=%s).",function_name,
+				      bucket_name,filename);
+#endif
+	/* an operation cancelled before the upload started fails straight away */
+	state = GCP_Client_Operation_Check(operation,FALSE);
+	if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+	{
+		Read_Write_Operation_Stopped(function_name,state,bucket_name,filename,0);
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_WRITE,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("write",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	GCP_Client_Adaptive_Get(GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD,&chunk_length,NULL);
+	clock_gettime(CLOCK_MONOTONIC,&open_start_time);
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	/* an upload paused earlier in the operation carries on in it's resumable upload session */
+	session_id = GCP_Client_Operation_Get_Session(operation);
+	/* if FITS indexing is enabled, the frame's header keywords are attached as custom metadata */
+	fits_keyword_count = GCP_Client_Fits_Index_Metadata(file_contents_ptr,file_contents_length,object_metadata);
+	/* the operation's stall timeout and deadline (if any) are passed on as request options */
+	auto writer = client.WriteObject(bucket_name,filename,(session_id.empty() == FALSE) ?
+				 gcs::RestoreResumableUploadSession(session_id) : gcs::NewResumableUploadSession(),
+				 (fits_keyword_count > 0) ? gcs::WithObjectMetadata(object_metadata) :
+				 gcs::WithObjectMetadata(),
+				 GCP_Client_Operation_Get_Options(operation).set<gcs::UploadBufferSizeOption>(chunk_length));
+	GCP_Client_Trace_Span_End("open",bucket_name,filename,&trace_phase_start_time,0,(bool)writer);
+	clock_gettime(CLOCK_MONOTONIC,&open_end_time);
+	if(! writer)
+	{
+		/* a restored session that can't be opened is forgotten, so the next attempt starts again */
+		GCP_Client_Operation_Set_Session(operation,"");
+		state = GCP_Client_Operation_Check(operation,TRUE);
+		if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+			Read_Write_Operation_Stopped(function_name,state,bucket_name,filename,0);
+		else
+		{
+			Read_Write_Error_Number = 11;
+			sprintf(Read_Write_Error_String,"%s: Failed to write '%s' to '%s'.",function_name,
+				filename,bucket_name);
+		}
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_WRITE,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("write",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	/* write data */
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+					     LOG_VERBOSITY_VERBOSE,
+		       "%s:writing data of length %ld bytes to bucket '%s' filename '%s'.",
+				      function_name,file_contents_length,bucket_name,filename);
+#endif
+	/* keep the session id, so an abandoned upload can be deleted (or a paused one resumed) */
+	session_id = writer.resumable_session_id();
+	/* a resumed upload starts from the next byte the server expects */
+	byte_count = 0;
+	if(writer.next_expected_byte() <= file_contents_length)
+		byte_count = writer.next_expected_byte();
+	GCP_Client_Operation_Progress(operation,byte_count);
+#if LOGGING > 1
+	if(byte_count > 0)
+	{
+		GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+						     LOG_VERBOSITY_INTERMEDIATE,
+						     "%s:Resuming upload of '%s' to '%s' at byte %ld.",
+						     function_name,filename,bucket_name,byte_count);
+	}
+#endif
+	/* write the data a part at a time, so the operation can be checked between parts */
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	state = GCP_CLIENT_OPERATION_STATE_RUNNING;
+	while(writer&&(byte_count < file_contents_length)&&(state == GCP_CLIENT_OPERATION_STATE_RUNNING))
+	{
+		write_length = file_contents_length-byte_count;
+		if(write_length > READ_WRITE_BUFFER_RESIZE_LENGTH)
+			write_length = READ_WRITE_BUFFER_RESIZE_LENGTH;
+		GCP_Client_Bandwidth_Acquire(GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD,write_length);
+		writer.write(((const char*)file_contents_ptr)+byte_count,write_length);
+		if(writer)
+		{
+			byte_count += write_length;
+			GCP_Client_Operation_Progress(operation,write_length);
+		}
+		state = GCP_Client_Operation_Check(operation,!writer);
+	}
+	GCP_Client_Trace_Span_End("stream",bucket_name,filename,&trace_phase_start_time,byte_count,
+				  ((bool)writer)&&(state == GCP_CLIENT_OPERATION_STATE_RUNNING));
+	if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+	{
+		/* a paused upload keeps it's session in the operation, so it can carry on once resumed. Otherwise
+		** abandon the upload, and delete it's session so the server discards the parts already sent */
+		std::move(writer).Suspend();
+		if(state == GCP_CLIENT_OPERATION_STATE_PAUSED)
+			GCP_Client_Operation_Set_Session(operation,session_id);
+		else
+		{
+			GCP_Client_Operation_Set_Session(operation,"");
+			if(session_id.empty() == FALSE)
+				client.DeleteResumableUpload(session_id);
+		}
+		Read_Write_Operation_Stopped(function_name,state,bucket_name,filename,byte_count);
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_WRITE,start_time,byte_count,FALSE);
+		GCP_Client_Trace_Span_End("write",bucket_name,filename,&trace_start_time,byte_count,FALSE);
+		return FALSE;
+	}
+	/* close stream */
+#if LOGGING > 5
+	GCP_Client_General_Module_Log(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_VERY_VERBOSE,
+				      "Read_Write_Write:Closing stream.");
+#endif
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	writer.Close();
+	GCP_Client_Trace_Span_End("close",bucket_name,filename,&trace_phase_start_time,0,TRUE);
+	/* check for success/failure */
+#if LOGGING > 5
+	GCP_Client_General_Module_Log(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_VERY_VERBOSE,
+				      "Read_Write_Write:Checking metadata for success.");
+#endif
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	auto metadata = std::move(writer).metadata();
+	GCP_Client_Trace_Span_End("metadata",bucket_name,filename,&trace_phase_start_time,0,(bool)metadata);
+	if (!metadata)
+	{
+		/* a Close that stalled, or ran past the deadline, is reported as such */
+		state = GCP_Client_Operation_Check(operation,TRUE);
+		if(state == GCP_CLIENT_OPERATION_STATE_PAUSED)
+		{
+			GCP_Client_Operation_Set_Session(operation,session_id);
+			Read_Write_Operation_Stopped(function_name,state,bucket_name,filename,byte_count);
+		}
+		else if(state != GCP_CLIENT_OPERATION_STATE_RUNNING)
+		{
+			GCP_Client_Operation_Set_Session(operation,"");
+			if((operation != NULL)&&(session_id.empty() == FALSE))
+				client.DeleteResumableUpload(session_id);
+			Read_Write_Operation_Stopped(function_name,state,bucket_name,filename,byte_count);
+		}
+		else
+		{
+			GCP_Client_Operation_Set_Session(operation,"");
+			Read_Write_Error_Number = 12;
+			sprintf(Read_Write_Error_String,"%s: Failed to write '%s' to '%s' with status '%s'.",
+				function_name,filename,bucket_name,std::move(metadata).status().message().c_str());
+		}
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_WRITE,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("write",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	GCP_Client_Operation_Set_Session(operation,"");
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	GCP_Client_Adaptive_Record(GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD,file_contents_length,
+				   fdifftime(end_time,open_start_time),fdifftime(open_end_time,open_start_time));
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_WRITE,start_time,file_contents_length,TRUE);
+	GCP_Client_Trace_Span_End("write",bucket_name,filename,&trace_start_time,file_contents_length,TRUE);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+					     LOG_VERBOSITY_INTERMEDIATE,
+				      "%s:Finished writing to bucket '%s' filename '%s'.",
+				      function_name,bucket_name,filename);
+#endif
+	return TRUE;
+}
+
+/**
+ * Make a hedged read into reallocated memory. The primary request is started in a thread of it's own, and
+ * we wait for it's first byte for the hedge threshold. If the first byte has not arrived by then, and the cap on
+ * extra requests allows, a hedge request is started in another thread. We then wait for either request to finish
+ * reading the object (the other is cancelled when it next checks), or both to fail.
+ * The shared hedge state is freed by whichever thread (reader or request) uses it last, so a request that is
+ * still waiting for a response when the read returns cleans up after itself.
+ * @param function_name The name of the calling external routine, used in log and error messages.
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param ranged If TRUE, only read length bytes starting at offset.
+ * @param offset The offset of the first byte to read, for a ranged read.
+ * @param length The number of bytes to read, for a ranged read.
+ * @param file_contents_ptr The address of a void pointer, on a successful return set to the memory containing
+ *        the bytes read, which should be freed by the caller.
+ * @param file_contents_length The address of a size_t variable, on a successful return set to the number of
+ *        bytes read.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure (of the primary request, if both failed).
+ * @see #Read_Write_Hedge_Struct
+ * @see #Read_Write_Hedge_Attempt_Start
+ * @see #Read_Write_Hedge_Threshold
+ * @see #Read_Write_Hedge_Free
+ * @see #Read_Write_Hedge_Stats
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+static int Read_Write_Read_Hedged(const char *function_name,char *bucket_name,char *filename,int ranged,
+				  unsigned long long offset,size_t length,
+				  void **file_contents_ptr,size_t *file_contents_length)
+{
+	struct Read_Write_Hedge_Struct *hedge = NULL;
+	struct timespec start_time,trace_start_time,deadline;
+	double threshold;
+	long long threshold_ns;
+	int i,retval,running,wait_retval,start_hedge,winner,cancel_count,last_reference;
+
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	hedge = new Read_Write_Hedge_Struct();
+	hedge->Function_Name = function_name;
+	hedge->Bucket_Name = bucket_name;
+	hedge->Filename = filename;
+	hedge->Ranged = ranged;
+	hedge->Offset = offset;
+	hedge->Length = length;
+	pthread_mutex_init(&(hedge->Mutex),NULL);
+	pthread_cond_init(&(hedge->Condition),NULL);
+	/* the reader, and the primary request */
+	hedge->Reference_Count = 2;
+	hedge->Attempt_Count = 1;
+	hedge->Generation = 0;
+	hedge->Done = FALSE;
+	hedge->Winner = -1;
+	hedge->Contents = NULL;
+	hedge->Contents_Length = 0;
+	for(i = 0; i < READ_WRITE_HEDGE_ATTEMPT_COUNT; i++)
+	{
+		hedge->Attempt[i].Hedge = hedge;
+		hedge->Attempt[i].Index = i;
+		hedge->Attempt[i].First_Byte = FALSE;
+		hedge->Attempt[i].Cancelled = FALSE;
+		hedge->Attempt[i].Failed = FALSE;
+		hedge->Attempt[i].Error_Number = 0;
+		hedge->Attempt[i].Error_String[0] = '\0';
+	}
+	pthread_mutex_lock(&Read_Write_Hedge_Mutex);
+	Read_Write_Hedge_Stats.Read_Count++;
+	threshold = Read_Write_Hedge_Threshold();
+	hedge->Max_Length = Read_Write_Hedge_Max_Length;
+	pthread_mutex_unlock(&Read_Write_Hedge_Mutex);
+	clock_gettime(CLOCK_MONOTONIC,&(hedge->Start_Time));
+	hedge->Priority = GCP_Client_Bandwidth_Get_Thread_Priority();
+	clock_gettime(CLOCK_REALTIME,&deadline);
+	if(!Read_Write_Hedge_Attempt_Start(&(hedge->Attempt[0])))
+	{
+		Read_Write_Hedge_Free(hedge);
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("read",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	pthread_mutex_lock(&(hedge->Mutex));
+	/* wait for the primary request's first byte, for up to the threshold */
+	if(threshold > 0.0)
+	{
+		threshold_ns = (long long)(threshold*1000000.0);
+		deadline.tv_sec += (time_t)(threshold_ns/GCP_CLIENT_GENERAL_ONE_SECOND_NS);
+		deadline.tv_nsec += (long)(threshold_ns%GCP_CLIENT_GENERAL_ONE_SECOND_NS);
+		if(deadline.tv_nsec >= GCP_CLIENT_GENERAL_ONE_SECOND_NS)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= GCP_CLIENT_GENERAL_ONE_SECOND_NS;
+		}
+		wait_retval = 0;
+		while((hedge->Attempt[0].First_Byte == FALSE)&&(hedge->Attempt[0].Failed == FALSE)&&
+		      (hedge->Done == FALSE)&&(wait_retval != ETIMEDOUT))
+		{
+			wait_retval = pthread_cond_timedwait(&(hedge->Condition),&(hedge->Mutex),&deadline);
+		}
+		if((hedge->Attempt[0].First_Byte == FALSE)&&(hedge->Attempt[0].Failed == FALSE)&&
+		   (hedge->Done == FALSE))
+		{
+			/* the first byte is late, hedge if the cap on extra requests allows */
+			pthread_mutex_lock(&Read_Write_Hedge_Mutex);
+			start_hedge = (((double)(Read_Write_Hedge_Stats.Hedge_Count+1)) <=
+				       ((Read_Write_Hedge_Max_Extra_Percent*((double)Read_Write_Hedge_Stats.Read_Count))/100.0));
+			if(start_hedge)
+				Read_Write_Hedge_Stats.Hedge_Count++;
+			else
+				Read_Write_Hedge_Stats.Suppressed_Count++;
+			pthread_mutex_unlock(&Read_Write_Hedge_Mutex);
+			if(start_hedge)
+			{
+#if LOGGING > 5
+				GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+								     LOG_VERBOSITY_VERY_VERBOSE,
+						 "%s:No first byte from '%s' in bucket '%s' after %.3f ms, starting hedge request.",
+								     function_name,filename,bucket_name,threshold);
+#endif
+				hedge->Reference_Count++;
+				hedge->Attempt_Count++;
+				if(Read_Write_Hedge_Attempt_Start(&(hedge->Attempt[1])))
+					GCP_Client_Stats_Record_Retry(GCP_CLIENT_STATS_OPERATION_READ);
+				else
+				{
+					/* carry on with the primary request alone */
+					hedge->Reference_Count--;
+					hedge->Attempt_Count--;
+				}
+			}
+		}
+	}
+	/* wait for a request to finish reading the object, or all of them to fail */
+	while(hedge->Done == FALSE)
+	{
+		running = FALSE;
+		for(i = 0; i < hedge->Attempt_Count; i++)
+		{
+			if(hedge->Attempt[i].Failed == FALSE)
+				running = TRUE;
+		}
+		if(running == FALSE)
+			break;
+		pthread_cond_wait(&(hedge->Condition),&(hedge->Mutex));
+	}
+	retval = hedge->Done;
+	winner = hedge->Winner;
+	cancel_count = 0;
+	if(retval)
+	{
+		(*file_contents_ptr) = hedge->Contents;
+		(*file_contents_length) = hedge->Contents_Length;
+		hedge->Contents = NULL;
+		/* requests still running will see the read is done, and cancel themselves */
+		for(i = 0; i < hedge->Attempt_Count; i++)
+		{
+			if((i != winner)&&(hedge->Attempt[i].Failed == FALSE))
+				cancel_count++;
+		}
+	}
+	else
+	{
+		Read_Write_Error_Number = hedge->Attempt[0].Error_Number;
+		strcpy(Read_Write_Error_String,hedge->Attempt[0].Error_String);
+	}
+	hedge->Reference_Count--;
+	last_reference = (hedge->Reference_Count == 0);
+	pthread_mutex_unlock(&(hedge->Mutex));
+	if(last_reference)
+		Read_Write_Hedge_Free(hedge);
+	pthread_mutex_lock(&Read_Write_Hedge_Mutex);
+	if(winner > 0)
+		Read_Write_Hedge_Stats.Hedge_Win_Count++;
+	Read_Write_Hedge_Stats.Cancel_Count += cancel_count;
+	pthread_mutex_unlock(&Read_Write_Hedge_Mutex);
+	if(retval == FALSE)
+	{
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("read",bucket_name,filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_READ,start_time,(*file_contents_length),TRUE);
+	GCP_Client_Trace_Span_End("read",bucket_name,filename,&trace_start_time,(*file_contents_length),TRUE);
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+					     LOG_VERBOSITY_TERSE,
+				      "%s(bucket=%s,filename=%s):Finished reading %ld bytes (%s request).",
+				      function_name,bucket_name,filename,(*file_contents_length),
+				      (winner > 0) ? "hedge" : "primary");
+#endif
+	return TRUE;
+}
+
+/**
+ * Thread routine running one request of a hedged read (Read_Write_Hedge_Attempt). If it finishes reading the
+ * object first, the contents are handed to the reader, otherwise they are freed. On failure, the error is
+ * copied out of this thread's (thread local) error variables into the request state. The thread then drops it's
+ * reference to the hedge state, freeing it if it was the last.
+ * @param user_data A pointer to the request's Read_Write_Hedge_Attempt_Struct.
+ * @return The routine returns NULL.
+ * @see #Read_Write_Hedge_Attempt_Struct
+ * @see #Read_Write_Hedge_Attempt
+ * @see #Read_Write_Hedge_Free
+ */
+static void *Read_Write_Hedge_Attempt_Thread(void *user_data)
+{
+	struct Read_Write_Hedge_Attempt_Struct *attempt = (struct Read_Write_Hedge_Attempt_Struct *)user_data;
+	struct Read_Write_Hedge_Struct *hedge = attempt->Hedge;
+	void *contents = NULL;
+	size_t contents_length = 0;
+	int i,retval,cancelled,last_reference;
+
+	GCP_Client_Bandwidth_Set_Thread_Priority(hedge->Priority);
+	cancelled = FALSE;
+	retval = Read_Write_Hedge_Attempt(attempt,&contents,&contents_length,&cancelled);
+	pthread_mutex_lock(&(hedge->Mutex));
+	if(retval && (hedge->Done == FALSE))
+	{
+		hedge->Done = TRUE;
+		hedge->Winner = attempt->Index;
+		hedge->Contents = contents;
+		hedge->Contents_Length = contents_length;
+		contents = NULL;
+		/* the other request stops when it next checks */
+		for(i = 0; i < READ_WRITE_HEDGE_ATTEMPT_COUNT; i++)
+		{
+			if(i != attempt->Index)
+				hedge->Attempt[i].Cancelled = TRUE;
+		}
+	}
+	else if(retval == FALSE)
+	{
+		attempt->Failed = TRUE;
+		attempt->Error_Number = Read_Write_Error_Number;
+		strcpy(attempt->Error_String,Read_Write_Error_String);
+	}
+	pthread_cond_broadcast(&(hedge->Condition));
+	hedge->Reference_Count--;
+	last_reference = (hedge->Reference_Count == 0);
+	pthread_mutex_unlock(&(hedge->Mutex));
+	/* lost the race */
+	if(contents != NULL)
+		free(contents);
+	if(last_reference)
+		Read_Write_Hedge_Free(hedge);
+	return NULL;
+}
+
+/**
+ * Make one request of a hedged read. The object is opened, and we wait for the first byte of the response, which
+ * (for the primary request) is added to the first byte latency samples. A hedge request for a whole object that
+ * turns out to be longer than the maximum hedged length is abandoned. The object is then read
+ * READ_WRITE_BUFFER_RESIZE_LENGTH bytes at a time into reallocated memory, and
+ * the request is cancelled (it's stream closed) if the other request finishes first. Each request has a stall
+ * timeout (READ_WRITE_HEDGE_STALL_TIMEOUT), so one blocked waiting for bytes (for instance the loser, waiting for
+ * it's first byte) returns. A hedge request started after the other request got it's response is pinned to the
+ * same object generation, and a request that gets a different generation fails.
+ * The memory is reserved from the memory budget as for Read_Write_Read: the object's length up front (or
+ * READ_WRITE_BUFFER_RESIZE_LENGTH if it is not known), and any growth beyond that before it is allocated, so a
+ * request whose growth cannot be reserved fails. The reservation is released when the request returns.
+ * @param attempt The request state.
+ * @param contents_ptr The address of a void pointer, on success set to the allocated memory holding the bytes read.
+ * @param contents_length The address of a size_t, on success set to the number of bytes read.
+ * @param cancelled The address of an integer, set to TRUE if the request was cancelled or abandoned.
+ * @return The routine returns TRUE on success, and FALSE on failure (or cancellation). If it fails,
+ *         Read_Write_Error_Number / Read_Write_Error_String should contain details of the failure.
+ * @see #READ_WRITE_BUFFER_RESIZE_LENGTH
+ * @see #READ_WRITE_HEDGE_STALL_TIMEOUT
+ * @see #Read_Write_Hedge_Attempt_Struct
+ * @see #Read_Write_Hedge_Struct
+ * @see #Read_Write_Hedge_Add_Sample
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Acquire
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ * @see gcp_client_budget.html#GCP_Client_Budget_Release
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+static int Read_Write_Hedge_Attempt(struct Read_Write_Hedge_Attempt_Struct *attempt,void **contents_ptr,
+				    size_t *contents_length,int *cancelled)
+{
+	namespace gcs = ::google::cloud::storage;
+	struct Read_Write_Hedge_Struct *hedge = attempt->Hedge;
+	gcs::Client client;
+	struct timespec first_byte_time,trace_phase_start_time;
+	const char *bucket_name = hedge->Bucket_Name.c_str();
+	const char *filename = hedge->Filename.c_str();
+	void *new_contents = NULL;
+	unsigned long long budget_length,allocated_length;
+	long long generation;
+	size_t length_hint;
+	int done;
+
+	Read_Write_Error_Number = 0;
+	(*contents_ptr) = NULL;
+	(*contents_length) = 0;
+	(*cancelled) = FALSE;
+	client = GCP_Client_Connection_Get_Client();
+	/* an unset generation option is default constructed, and is not sent to the server */
+	pthread_mutex_lock(&(hedge->Mutex));
+	generation = hedge->Generation;
+	pthread_mutex_unlock(&(hedge->Mutex));
+	auto options = google::cloud::Options{}.set<gcs::DownloadStallTimeoutOption>(
+		std::chrono::seconds(READ_WRITE_HEDGE_STALL_TIMEOUT));
+	GCP_Client_Trace_Span_Begin(&trace_phase_start_time);
+	auto reader = hedge->Ranged ? client.ReadObject(hedge->Bucket_Name,hedge->Filename,
+							(generation > 0) ? gcs::Generation(generation) : gcs::Generation(),
+							gcs::ReadRange(hedge->Offset,hedge->Offset+hedge->Length),options) :
+		client.ReadObject(hedge->Bucket_Name,hedge->Filename,
+				  (generation > 0) ? gcs::Generation(generation) : gcs::Generation(),options);
+	if(! reader)
+	{
+		Read_Write_Error_Number = 15;
+		snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "%s: Failed to read '%s' from '%s' with status '%s'.",hedge->Function_Name,filename,
+			 bucket_name,reader.status().message().c_str());
+		GCP_Client_Trace_Span_End((attempt->Index == 0) ? "first_byte" : "hedge_first_byte",bucket_name,filename,
+					  &trace_phase_start_time,0,FALSE);
+		return FALSE;
+	}
+	/* wait for the first byte of the response (or the end of an empty object) */
+	reader.peek();
+	clock_gettime(CLOCK_MONOTONIC,&first_byte_time);
+	GCP_Client_Trace_Span_End((attempt->Index == 0) ? "first_byte" : "hedge_first_byte",bucket_name,filename,
+				  &trace_phase_start_time,0,TRUE);
+	if(attempt->Index == 0)
+		Read_Write_Hedge_Add_Sample(fdifftime(first_byte_time,hedge->Start_Time)*1000.0);
+	/* the first request to get a response sets the generation both must read */
+	auto reader_generation = reader.generation();
+	pthread_mutex_lock(&(hedge->Mutex));
+	attempt->First_Byte = TRUE;
+	if(reader_generation.has_value())
+	{
+		if(hedge->Generation == 0)
+			hedge->Generation = (long long)(*reader_generation);
+		generation = hedge->Generation;
+	}
+	else
+		generation = 0;
+	done = attempt->Cancelled;
+	pthread_cond_broadcast(&(hedge->Condition));
+	pthread_mutex_unlock(&(hedge->Mutex));
+	if(done)
+	{
+		(*cancelled) = TRUE;
+		Read_Write_Error_Number = 16;
+		sprintf(Read_Write_Error_String,"%s: Request %d cancelled, the other request finished first.",
+			hedge->Function_Name,attempt->Index);
+		return FALSE;
+	}
+	if(reader_generation.has_value()&&((long long)(*reader_generation) != generation))
+	{
+		Read_Write_Error_Number = 38;
+		snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "%s: Request %d read generation %lld of '%s' from '%s', the other request read %lld.",
+			 hedge->Function_Name,attempt->Index,(long long)(*reader_generation),filename,bucket_name,
+			 generation);
+		return FALSE;
+	}
+	/* the object length, if the server sent it */
+	auto object_size = reader.size();
+	if(hedge->Ranged)
+		length_hint = hedge->Length;
+	else
+		length_hint = object_size.has_value() ? (size_t)(*object_size) : 0;
+	if((attempt->Index > 0)&&(hedge->Ranged == FALSE)&&(length_hint > hedge->Max_Length))
+	{
+		pthread_mutex_lock(&Read_Write_Hedge_Mutex);
+		Read_Write_Hedge_Stats.Abandoned_Count++;
+		pthread_mutex_unlock(&Read_Write_Hedge_Mutex);
+		(*cancelled) = TRUE;
+		Read_Write_Error_Number = 17;
+		sprintf(Read_Write_Error_String,"%s: Hedge request abandoned, object length %lu is longer than %lu.",
+			hedge->Function_Name,(unsigned long)length_hint,(unsigned long)hedge->Max_Length);
+		return FALSE;
+	}
+	budget_length = ((length_hint/READ_WRITE_BUFFER_RESIZE_LENGTH)+1)*READ_WRITE_BUFFER_RESIZE_LENGTH;
+	if(!GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_READ,budget_length,GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT))
+	{
+		Read_Write_Error_Number = 18;
+		snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "%s: Failed to reserve %llu bytes of memory budget to read '%s' from '%s'.",
+			 hedge->Function_Name,budget_length,filename,bucket_name);
+		return FALSE;
+	}
+	done = FALSE;
+	while(done == FALSE)
+	{
+		/* reserve any memory the file contents are about to grow beyond, before allocating it */
+		allocated_length = (*contents_length)+READ_WRITE_BUFFER_RESIZE_LENGTH;
+		if(allocated_length > budget_length)
+		{
+			if(!GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_READ,allocated_length-budget_length,
+						      GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT))
+			{
+				Read_Write_Error_Number = 18;
+				snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+					 "%s: Failed to reserve %llu bytes of memory budget to read '%s' from '%s'.",
+					 hedge->Function_Name,allocated_length,filename,bucket_name);
+				break;
+			}
+			budget_length = allocated_length;
+		}
+		/* allocate more memory for the file contents */
+		new_contents = realloc((*contents_ptr),allocated_length);
+		if(new_contents == NULL)
+		{
+			Read_Write_Error_Number = 19;
+			snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "%s: Failed to read '%s' from '%s' : memory allocation error with size %lu.",
+				 hedge->Function_Name,filename,bucket_name,(unsigned long)(*contents_length));
+			break;
+		}
+		(*contents_ptr) = new_contents;
+		reader.read(((char*)(*contents_ptr))+(*contents_length),READ_WRITE_BUFFER_RESIZE_LENGTH);
+		(*contents_length) += reader.gcount();
+		GCP_Client_Bandwidth_Acquire(GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD,reader.gcount());
+		if(! reader)
+		{
+			if(reader.eof())
+				done = TRUE;
+			else
+			{
+				Read_Write_Error_Number = 20;
+				snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+					 "%s: Failed to read '%s' from '%s' : read failed after %lu bytes (%s).",
+					 hedge->Function_Name,filename,bucket_name,(unsigned long)(*contents_length),
+					 reader.status().message().c_str());
+				break;
+			}
+		}
+		if(done == FALSE)
+		{
+			/* stop if the other request has finished */
+			pthread_mutex_lock(&(hedge->Mutex));
+			if(attempt->Cancelled)
+			{
+				(*cancelled) = TRUE;
+				Read_Write_Error_Number = 16;
+				sprintf(Read_Write_Error_String,"%s: Request %d cancelled, the other request finished first.",
+					hedge->Function_Name,attempt->Index);
+			}
+			pthread_mutex_unlock(&(hedge->Mutex));
+			if(*cancelled)
+				break;
+		}
+	}
+	GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_READ,budget_length);
+	if(done == FALSE)
+	{
+		if((*contents_ptr) != NULL)
+			free(*contents_ptr);
+		(*contents_ptr) = NULL;
+		(*contents_length) = 0;
+		return FALSE;
+	}
+	reader.Close();
+	return TRUE;
+}
+
+/**
+ * Start a thread (detached) running one request of a hedged read. Called with the hedge mutex held (for the
+ * hedge request), or before any request has started (for the primary request).
+ * @param attempt The request state.
+ * @return The routine returns TRUE on success, and FALSE if the thread could not be started. If it fails,
+ *         Read_Write_Error_Number / Read_Write_Error_String should contain details of the failure.
+ * @see #Read_Write_Hedge_Attempt_Thread
+ */
+static int Read_Write_Hedge_Attempt_Start(struct Read_Write_Hedge_Attempt_Struct *attempt)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+	int retval;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr,PTHREAD_CREATE_DETACHED);
+	retval = pthread_create(&thread,&attr,Read_Write_Hedge_Attempt_Thread,(void*)attempt);
+	pthread_attr_destroy(&attr);
+	if(retval != 0)
+	{
+		Read_Write_Error_Number = 21;
+		snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "%s: Failed to start request %d thread (%s).",attempt->Hedge->Function_Name,attempt->Index,
+			 strerror(retval));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Free the state of a hedged read, once the reader and all it's requests have finished with it.
+ * @param hedge The hedge state.
+ * @see #Read_Write_Hedge_Struct
+ */
+static void Read_Write_Hedge_Free(struct Read_Write_Hedge_Struct *hedge)
+{
+	if(hedge->Contents != NULL)
+		free(hedge->Contents);
+	pthread_cond_destroy(&(hedge->Condition));
+	pthread_mutex_destroy(&(hedge->Mutex));
+	delete hedge;
+}
+
+/**
+ * Calculate the hedge threshold, the configured percentile of the recent first byte latencies, and store it (and
+ * the number of samples) in the statistics. Called with Read_Write_Hedge_Mutex held.
+ * @return The threshold in milliseconds, or 0 if there are not yet enough samples to hedge.
+ * @see #READ_WRITE_HEDGE_SAMPLE_COUNT
+ * @see #READ_WRITE_HEDGE_MIN_SAMPLE_COUNT
+ * @see #READ_WRITE_HEDGE_MIN_THRESHOLD
+ * @see #Read_Write_Hedge_Sample_List
+ * @see #Read_Write_Hedge_Percentile
+ * @see #Read_Write_Hedge_Stats
+ */
+static double Read_Write_Hedge_Threshold(void)
+{
+	std::vector<double> sample_list;
+	size_t sample_count,index;
+
+	if(Read_Write_Hedge_Sample_Total < READ_WRITE_HEDGE_SAMPLE_COUNT)
+		sample_count = (size_t)Read_Write_Hedge_Sample_Total;
+	else
+		sample_count = READ_WRITE_HEDGE_SAMPLE_COUNT;
+	Read_Write_Hedge_Stats.Sample_Count = sample_count;
+	if(sample_count < READ_WRITE_HEDGE_MIN_SAMPLE_COUNT)
+	{
+		Read_Write_Hedge_Stats.Threshold = 0.0;
+		return 0.0;
+	}
+	sample_list.assign(Read_Write_Hedge_Sample_List,Read_Write_Hedge_Sample_List+sample_count);
+	index = (size_t)((Read_Write_Hedge_Percentile*((double)(sample_count-1)))/100.0);
+	std::nth_element(sample_list.begin(),sample_list.begin()+index,sample_list.end());
+	Read_Write_Hedge_Stats.Threshold = std::max(sample_list[index],READ_WRITE_HEDGE_MIN_THRESHOLD);
+	return Read_Write_Hedge_Stats.Threshold;
+}
+
+/**
+ * Add a primary request's first byte latency to the circular list of recent latencies.
+ * @param first_byte_ms The time from the read starting to the first byte arriving, in milliseconds.
+ * @see #Read_Write_Hedge_Sample_List
+ * @see #Read_Write_Hedge_Sample_Total
+ */
+static void Read_Write_Hedge_Add_Sample(double first_byte_ms)
+{
+	pthread_mutex_lock(&Read_Write_Hedge_Mutex);
+	Read_Write_Hedge_Sample_List[Read_Write_Hedge_Sample_Total%READ_WRITE_HEDGE_SAMPLE_COUNT] = first_byte_ms;
+	Read_Write_Hedge_Sample_Total++;
+	pthread_mutex_unlock(&Read_Write_Hedge_Mutex);
+}
+
+/**
+ * Batch item function for a parallel read. Each thread repeatedly takes the next part of the object and reads it,
+ * until the whole object has been handed out (or a part has failed). Before taking a part, the thread gets the
+ * current part length and parallelism from the adaptive controller, and waits whilst as many parts as the
+ * controller wants in progress are already being read. Each part is reserved from the memory budget whilst it is
+ * read, and each part read is recorded with the controller. A part whose read fails is read again (up to
+ * READ_WRITE_PARALLEL_PART_RETRY_COUNT times, each counted as a retry in the statistics): the object generation
+ * is pinned, so the part is the same bytes, read into the same place.
+ * @param index The index of the batch item (thread), not used.
+ * @param user_data A pointer to the parallel read state, a Read_Write_Parallel_Struct.
+ * @see #Read_Write_Parallel_Struct
+ * @see #Read_Write_Parallel_Part
+ * @see #READ_WRITE_PARALLEL_PART_RETRY_COUNT
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Record
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ * @see gcp_client_budget.html#GCP_Client_Budget_Release
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record_Retry
+ */
+static void Read_Write_Parallel_Worker(int index,void *user_data)
+{
+	struct Read_Write_Parallel_Struct *parallel = (struct Read_Write_Parallel_Struct *)user_data;
+	double transfer_time,rtt;
+	size_t offset,part_length,chunk_length;
+	int parallelism,retval,retry_count;
+
+	(void)index;
+	while(TRUE)
+	{
+		pthread_mutex_lock(&(parallel->Mutex));
+		while(TRUE)
+		{
+			if(parallel->Failed||(parallel->Next_Offset >= parallel->Length))
+			{
+				pthread_mutex_unlock(&(parallel->Mutex));
+				return;
+			}
+			GCP_Client_Adaptive_Get(GCP_CLIENT_ADAPTIVE_DIRECTION_READ,&chunk_length,&parallelism);
+			if(parallel->Active_Count < parallelism)
+				break;
+			pthread_cond_wait(&(parallel->Condition),&(parallel->Mutex));
+		}
+		offset = parallel->Next_Offset;
+		part_length = parallel->Length-offset;
+		if(part_length > chunk_length)
+			part_length = chunk_length;
+		parallel->Next_Offset += part_length;
+		parallel->Active_Count++;
+		pthread_mutex_unlock(&(parallel->Mutex));
+		if(GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_READ,part_length,GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT))
+		{
+			retval = Read_Write_Parallel_Part(parallel,offset,part_length,&transfer_time,&rtt);
+			for(retry_count = 0; (retval == FALSE)&&(retry_count < READ_WRITE_PARALLEL_PART_RETRY_COUNT);
+			    retry_count++)
+			{
+				GCP_Client_Stats_Record_Retry(GCP_CLIENT_STATS_OPERATION_READ);
+				retval = Read_Write_Parallel_Part(parallel,offset,part_length,&transfer_time,&rtt);
+			}
+			GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_READ,part_length);
+			if(retval)
+			{
+				GCP_Client_Adaptive_Record(GCP_CLIENT_ADAPTIVE_DIRECTION_READ,part_length,transfer_time,rtt);
+			}
+		}
+		else
+		{
+			retval = FALSE;
+			Read_Write_Error_Number = 26;
+			snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+				 "GCP_Client_Read_Write_Read_Parallel: Failed to reserve %lu bytes of memory budget to "
+				 "read part at %lu of '%s' from '%s'.",(unsigned long)part_length,(unsigned long)offset,
+				 parallel->Filename,parallel->Bucket_Name);
+		}
+		pthread_mutex_lock(&(parallel->Mutex));
+		parallel->Active_Count--;
+		if((retval == FALSE)&&(parallel->Failed == FALSE))
+		{
+			parallel->Failed = TRUE;
+			parallel->Error_Number = Read_Write_Error_Number;
+			strcpy(parallel->Error_String,Read_Write_Error_String);
+		}
+		pthread_cond_broadcast(&(parallel->Condition));
+		pthread_mutex_unlock(&(parallel->Mutex));
+	}
+}
+
+/**
+ * Read one part of a parallel read, length bytes from offset, straight into it's place in the object's memory.
+ * @param parallel The parallel read state.
+ * @param offset The offset of the part in the object.
+ * @param length The length of the part.
+ * @param transfer_time The address of a double, on a successful return set to the time taken to read the part,
+ *        from the request to the last byte, in seconds.
+ * @param rtt The address of a double, on a successful return set to the time from the request to the first byte
+ *        of the response, in seconds.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Read_Write_Error_Number / 
+ *         Read_Write_Error_String should contain details of the failure.
+ * @see #Read_Write_Parallel_Struct
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Acquire
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+static int Read_Write_Parallel_Part(struct Read_Write_Parallel_Struct *parallel,size_t offset,size_t length,
+				    double *transfer_time,double *rtt)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	struct timespec start_time,first_byte_time,end_time,trace_start_time;
+	size_t byte_count,read_length;
+
+	Read_Write_Error_Number = 0;
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	auto reader = client.ReadObject(parallel->Bucket_Name,parallel->Filename,gcs::Generation(parallel->Generation),
+					gcs::ReadRange(offset,offset+length));
+	if(! reader)
+	{
+		Read_Write_Error_Number = 29;
+		snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Read_Write_Read_Parallel: Failed to read part at %lu of '%s' from '%s' "
+			 "with status '%s'.",(unsigned long)offset,parallel->Filename,parallel->Bucket_Name,
+			 reader.status().message().c_str());
+		GCP_Client_Trace_Span_End("part",parallel->Bucket_Name,parallel->Filename,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	/* wait for the first byte of the response, to measure the round trip time */
+	reader.peek();
+	clock_gettime(CLOCK_MONOTONIC,&first_byte_time);
+	/* read the part into place a slice at a time, so the bandwidth limiter can pace it */
+	byte_count = 0;
+	while(reader&&(byte_count < length))
+	{
+		read_length = length-byte_count;
+		if(read_length > READ_WRITE_BUFFER_RESIZE_LENGTH)
+			read_length = READ_WRITE_BUFFER_RESIZE_LENGTH;
+		reader.read(parallel->Contents+offset+byte_count,read_length);
+		byte_count += reader.gcount();
+		GCP_Client_Bandwidth_Acquire(GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD,reader.gcount());
+	}
+	if(byte_count != length)
+	{
+		Read_Write_Error_Number = 30;
+		snprintf(Read_Write_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Read_Write_Read_Parallel: Failed to read part at %lu of '%s' from '%s' : "
+			 "read %lu of %lu bytes (%s).",(unsigned long)offset,parallel->Filename,parallel->Bucket_Name,
+			 (unsigned long)byte_count,(unsigned long)length,reader.status().message().c_str());
+		GCP_Client_Trace_Span_End("part",parallel->Bucket_Name,parallel->Filename,&trace_start_time,
+					  byte_count,FALSE);
+		return FALSE;
+	}
+	reader.Close();
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	GCP_Client_Trace_Span_End("part",parallel->Bucket_Name,parallel->Filename,&trace_start_time,length,TRUE);
+	(*transfer_time) = fdifftime(end_time,start_time);
+	(*rtt) = fdifftime(first_byte_time,start_time);
+	return TRUE;
+}
+
+/**
+ * Set the error number and string for a transfer stopped by it's operation.
+ * @param function_name The name of the calling routine, used in the error message.
+ * @param state The state the operation stopped in: GCP_CLIENT_OPERATION_STATE_CANCELLED (error 31),
+ *        GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED (error 32), GCP_CLIENT_OPERATION_STATE_STALLED (error 33)
+ *        or GCP_CLIENT_OPERATION_STATE_PAUSED (error 37).
+ * @param bucket_name The name of the bucket.
+ * @param filename The filename of the file within the google cloud storage bucket.
+ * @param byte_count The number of bytes transferred before the transfer was stopped.
+ * @see #Read_Write_Error_Number
+ * @see #Read_Write_Error_String
+ * @see gcp_client_operation.html#GCP_Client_Operation_State_To_String
+ */
+static void Read_Write_Operation_Stopped(const char *function_name,int state,char *bucket_name,char *filename,
+					 unsigned long long byte_count)
+{
+	if(state == GCP_CLIENT_OPERATION_STATE_CANCELLED)
+		Read_Write_Error_Number = 31;
+	else if(state == GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED)
+		Read_Write_Error_Number = 32;
+	else if(state == GCP_CLIENT_OPERATION_STATE_PAUSED)
+		Read_Write_Error_Number = 37;
+	else
+		Read_Write_Error_Number = 33;
+	sprintf(Read_Write_Error_String,"%s: Transfer of '%s' in '%s' stopped after %llu bytes : operation %s.",
+		function_name,filename,bucket_name,byte_count,GCP_Client_Operation_State_To_String(state));
+}
@@ -0,0 +1,1014 @@
+/* gcp_client_scheduler.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Priority-aware transfer scheduler routines.
+*/
+/**
+ * Routines scheduling transfers (jobs) onto a pool of worker threads, so a backlog of old data does not hold up
+ * the newest frame a pipeline is waiting for. Jobs are submitted to queues, each with a priority class
+ * (GCP_CLIENT_BANDWIDTH_PRIORITY_*) and a weight. When a worker is free it runs:
+ * <ul>
+ * <li>A job from the highest priority class that has one waiting.
+ * <li>Within a class, a job from the queue with the fewest running jobs for it's weight, and then the least run
+ *     time for it's weight, so queues share the workers in proportion to their weights.
+ * <li>Within a queue, the job with the earliest deadline, then the job submitted first.
+ * </ul>
+ * Jobs for a bucket that already has the scheduler's per-bucket concurrency of jobs running are passed over until
+ * one finishes. A job still waiting when it's deadline passes is failed without running, and a running job is
+ * given the rest of it's deadline as it's operation's deadline.
+ * <p>
+ * When a job is submitted and can't run (because all the workers are busy, or it's bucket is at it's limit),
+ * a running preemptible job of a lower priority class is paused (GCP_Client_Operation_Pause). When it's transfer
+ * stops, the job is queued again and the worker picks the more urgent job up. A paused upload made with
+ * GCP_Client_Read_Write_Write_Operation keeps it's resumable upload session, and carries on from where it stopped
+ * when the job is next run.
+ * <p>
+ * Each job runs in a worker thread whose bandwidth priority (GCP_Client_Bandwidth_Set_Thread_Priority) is it's
+ * queue's priority, so the bandwidth limiter favours the same jobs as the scheduler.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_operation.h"
+#include "gcp_client_scheduler.h"
+
+/* data types */
+/**
+ * Data type holding a job. This consists of the following:
+ * <dl>
+ * <dt>Id</dt> <dd>The job's id, returned by GCP_Client_Scheduler_Submit.</dd>
+ * <dt>Queue_Index</dt> <dd>The index of the queue the job was submitted to.</dd>
+ * <dt>Bucket_Name</dt> <dd>The bucket the job transfers to or from, or an empty string if it is not limited.</dd>
+ * <dt>Flags</dt> <dd>The job's flags (GCP_CLIENT_SCHEDULER_FLAG_PREEMPTIBLE).</dd>
+ * <dt>Deadline_Ms</dt> <dd>How long after submission the job must finish by, in milliseconds, or 0.</dd>
+ * <dt>Submit_Time</dt> <dd>The (CLOCK_MONOTONIC) time the job was submitted.</dd>
+ * <dt>Queue_Time</dt> <dd>The (CLOCK_MONOTONIC) time the job was last queued (submitted, or preempted).</dd>
+ * <dt>Start_Time</dt> <dd>The (CLOCK_MONOTONIC) time the job last started running.</dd>
+ * <dt>Job_Function</dt> <dd>The function that runs the job.</dd>
+ * <dt>Done_Function</dt> <dd>The function called when the job has finished, or NULL.</dd>
+ * <dt>User_Data</dt> <dd>The user data passed to Job_Function and Done_Function.</dd>
+ * <dt>Operation</dt> <dd>The operation the job's transfer is made with.</dd>
+ * <dt>Pausing</dt> <dd>A boolean, TRUE when the running job has been paused to let a higher priority job run.</dd>
+ * <dt>Cancelled</dt> <dd>A boolean, TRUE when the running job has been cancelled.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_SCHEDULER_FLAG_PREEMPTIBLE
+ */
+struct Scheduler_Job_Struct
+{
+	unsigned long long Id;
+	int Queue_Index;
+	std::string Bucket_Name;
+	int Flags;
+	int Deadline_Ms;
+	struct timespec Submit_Time;
+	struct timespec Queue_Time;
+	struct timespec Start_Time;
+	GCP_Client_Scheduler_Job_Function_T Job_Function;
+	GCP_Client_Scheduler_Done_Function_T Done_Function;
+	void *User_Data;
+	struct GCP_Client_Operation_Struct *Operation;
+	int Pausing;
+	int Cancelled;
+};
+
+/**
+ * Data type holding a queue. This consists of the following:
+ * <dl>
+ * <dt>Stats</dt> <dd>The queue's name, priority, weight and statistics, as returned by
+ *     GCP_Client_Scheduler_Get_Queue_Stats (the mean and oldest wait times are worked out when they are
+ *     retrieved).</dd>
+ * <dt>Wait_Time_Sum</dt> <dd>The total time jobs have waited in the queue before (re)starting, in seconds.</dd>
+ * <dt>Virtual_Time</dt> <dd>The queue's run time divided by it's weight, used to share the workers fairly
+ *     between queues of the same priority.</dd>
+ * <dt>Job_List</dt> <dd>The jobs waiting to run.</dd>
+ * </dl>
+ */
+struct Scheduler_Queue_Struct
+{
+	struct GCP_Client_Scheduler_Queue_Stats_Struct Stats;
+	double Wait_Time_Sum;
+	double Virtual_Time;
+	std::vector<struct Scheduler_Job_Struct*> Job_List;
+};
+
+/**
+ * Data type holding a scheduler. This consists of the following:
+ * <dl>
+ * <dt>Mutex</dt> <dd>Mutex protecting the rest of the structure.</dd>
+ * <dt>Work_Condition</dt> <dd>Condition variable, broadcast when a job may have become runnable.</dd>
+ * <dt>Idle_Condition</dt> <dd>Condition variable, broadcast when a job has finished.</dd>
+ * <dt>Worker_List</dt> <dd>The worker threads.</dd>
+ * <dt>Bucket_Concurrency</dt> <dd>The most jobs that can run at once for one bucket, or 0 for no limit.</dd>
+ * <dt>Bucket_Running_Count</dt> <dd>The number of jobs running for each bucket.</dd>
+ * <dt>Queue_List</dt> <dd>The queues.</dd>
+ * <dt>Running_List</dt> <dd>The jobs running now.</dd>
+ * <dt>Next_Job_Id</dt> <dd>The id the next job submitted is given.</dd>
+ * <dt>Job_Count</dt> <dd>The number of jobs submitted that have not finished (waiting or running).</dd>
+ * <dt>Shutdown</dt> <dd>A boolean, TRUE once GCP_Client_Scheduler_Destroy has been called.</dd>
+ * </dl>
+ */
+struct GCP_Client_Scheduler_Struct
+{
+	pthread_mutex_t Mutex;
+	pthread_cond_t Work_Condition;
+	pthread_cond_t Idle_Condition;
+	std::vector<pthread_t> Worker_List;
+	int Bucket_Concurrency;
+	std::map<std::string,int> Bucket_Running_Count;
+	std::vector<struct Scheduler_Queue_Struct> Queue_List;
+	std::vector<struct Scheduler_Job_Struct*> Running_List;
+	unsigned long long Next_Job_Id;
+	int Job_Count;
+	int Shutdown;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread.
+ */
+static thread_local int Scheduler_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Scheduler_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static void *Scheduler_Worker_Thread(void *user_data);
+static struct Scheduler_Job_Struct *Scheduler_Pick(struct GCP_Client_Scheduler_Struct *scheduler,int check_bucket);
+static struct Scheduler_Job_Struct *Scheduler_Queue_Best_Job(struct GCP_Client_Scheduler_Struct *scheduler,
+							     struct Scheduler_Queue_Struct *queue,int check_bucket);
+static int Scheduler_Job_Before(struct Scheduler_Job_Struct *job,struct Scheduler_Job_Struct *other_job);
+static void Scheduler_Preempt(struct GCP_Client_Scheduler_Struct *scheduler);
+static int Scheduler_Bucket_Full(struct GCP_Client_Scheduler_Struct *scheduler,std::string const &bucket_name);
+static void Scheduler_Queue_Remove(struct Scheduler_Queue_Struct *queue,struct Scheduler_Job_Struct *job);
+static void Scheduler_Finish(struct GCP_Client_Scheduler_Struct *scheduler,struct Scheduler_Job_Struct *job,
+			     int state);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Create a scheduler, and start it's worker threads. Queues must be added (GCP_Client_Scheduler_Add_Queue)
+ * before jobs can be submitted.
+ * @param scheduler The address of a pointer to fill in with the new scheduler.
+ * @param worker_count The number of worker threads, which is the most jobs run at once. If 0,
+ *        GCP_CLIENT_SCHEDULER_DEFAULT_WORKER_COUNT is used.
+ * @param bucket_concurrency The most jobs that can run at once for one bucket, or 0 for no limit.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_CLIENT_SCHEDULER_DEFAULT_WORKER_COUNT
+ * @see #GCP_CLIENT_SCHEDULER_MAX_WORKER_COUNT
+ * @see #GCP_Client_Scheduler_Struct
+ * @see #GCP_Client_Scheduler_Destroy
+ * @see #Scheduler_Worker_Thread
+ */
+int GCP_Client_Scheduler_Create(struct GCP_Client_Scheduler_Struct **scheduler,int worker_count,
+				int bucket_concurrency)
+{
+	pthread_t thread;
+	int i,retval;
+
+	Scheduler_Error_Number = 0;
+	if(scheduler == NULL)
+	{
+		Scheduler_Error_Number = 1;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Create:scheduler was NULL.");
+		return FALSE;
+	}
+	if(worker_count == 0)
+		worker_count = GCP_CLIENT_SCHEDULER_DEFAULT_WORKER_COUNT;
+	if((worker_count < 1)||(worker_count > GCP_CLIENT_SCHEDULER_MAX_WORKER_COUNT))
+	{
+		Scheduler_Error_Number = 2;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Create:Illegal worker count %d (1..%d).",
+			worker_count,GCP_CLIENT_SCHEDULER_MAX_WORKER_COUNT);
+		return FALSE;
+	}
+	if(bucket_concurrency < 0)
+	{
+		Scheduler_Error_Number = 3;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Create:Illegal bucket concurrency %d.",
+			bucket_concurrency);
+		return FALSE;
+	}
+	(*scheduler) = new (std::nothrow) struct GCP_Client_Scheduler_Struct;
+	if((*scheduler) == NULL)
+	{
+		Scheduler_Error_Number = 4;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Create:Failed to allocate scheduler.");
+		return FALSE;
+	}
+	pthread_mutex_init(&((*scheduler)->Mutex),NULL);
+	pthread_cond_init(&((*scheduler)->Work_Condition),NULL);
+	pthread_cond_init(&((*scheduler)->Idle_Condition),NULL);
+	(*scheduler)->Bucket_Concurrency = bucket_concurrency;
+	(*scheduler)->Next_Job_Id = 1;
+	(*scheduler)->Job_Count = 0;
+	(*scheduler)->Shutdown = FALSE;
+	for(i=0; i < worker_count; i++)
+	{
+		retval = pthread_create(&thread,NULL,Scheduler_Worker_Thread,(void*)(*scheduler));
+		if(retval != 0)
+		{
+			/* stop the workers already started */
+			pthread_mutex_lock(&((*scheduler)->Mutex));
+			(*scheduler)->Shutdown = TRUE;
+			pthread_cond_broadcast(&((*scheduler)->Work_Condition));
+			pthread_mutex_unlock(&((*scheduler)->Mutex));
+			for(auto &worker : (*scheduler)->Worker_List)
+				pthread_join(worker,NULL);
+			pthread_cond_destroy(&((*scheduler)->Idle_Condition));
+			pthread_cond_destroy(&((*scheduler)->Work_Condition));
+			pthread_mutex_destroy(&((*scheduler)->Mutex));
+			delete (*scheduler);
+			(*scheduler) = NULL;
+			Scheduler_Error_Number = 5;
+			sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Create:Failed to create worker thread %d (%d).",
+				i,retval);
+			return FALSE;
+		}
+		(*scheduler)->Worker_List.push_back(thread);
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SCHEDULER,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Scheduler_Create:Scheduler %p started with %d workers, "
+					     "bucket concurrency %d.",(void*)(*scheduler),worker_count,bucket_concurrency);
+#endif
+	return TRUE;
+}
+
+/**
+ * Add a queue to a scheduler. Queues can be added at any time.
+ * @param scheduler The scheduler.
+ * @param name The name of the queue, used in log messages and the queue's statistics.
+ * @param priority The priority class of the queue's jobs: GCP_CLIENT_BANDWIDTH_PRIORITY_HIGH,
+ *        GCP_CLIENT_BANDWIDTH_PRIORITY_NORMAL or GCP_CLIENT_BANDWIDTH_PRIORITY_BULK.
+ * @param weight The queue's share of the workers, relative to the other queues of the same priority (at least 1).
+ * @param queue_index The address of an integer to fill in with the queue's index, passed to
+ *        GCP_Client_Scheduler_Submit.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_CLIENT_SCHEDULER_MAX_QUEUE_COUNT
+ * @see #GCP_CLIENT_SCHEDULER_QUEUE_NAME_LENGTH
+ * @see #Scheduler_Queue_Struct
+ */
+int GCP_Client_Scheduler_Add_Queue(struct GCP_Client_Scheduler_Struct *scheduler,const char *name,
+				   int priority,int weight,int *queue_index)
+{
+	struct Scheduler_Queue_Struct queue;
+
+	Scheduler_Error_Number = 0;
+	if(scheduler == NULL)
+	{
+		Scheduler_Error_Number = 6;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Add_Queue:scheduler was NULL.");
+		return FALSE;
+	}
+	if(name == NULL)
+	{
+		Scheduler_Error_Number = 7;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Add_Queue:name was NULL.");
+		return FALSE;
+	}
+	if((priority < 0)||(priority >= GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT))
+	{
+		Scheduler_Error_Number = 8;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Add_Queue:Illegal priority %d.",priority);
+		return FALSE;
+	}
+	if(weight < 1)
+	{
+		Scheduler_Error_Number = 9;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Add_Queue:Illegal weight %d.",weight);
+		return FALSE;
+	}
+	if(queue_index == NULL)
+	{
+		Scheduler_Error_Number = 10;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Add_Queue:queue_index was NULL.");
+		return FALSE;
+	}
+	memset(&(queue.Stats),0,sizeof(struct GCP_Client_Scheduler_Queue_Stats_Struct));
+	strncpy(queue.Stats.Name,name,GCP_CLIENT_SCHEDULER_QUEUE_NAME_LENGTH-1);
+	queue.Stats.Name[GCP_CLIENT_SCHEDULER_QUEUE_NAME_LENGTH-1] = '\0';
+	queue.Stats.Priority = priority;
+	queue.Stats.Weight = weight;
+	queue.Wait_Time_Sum = 0.0;
+	queue.Virtual_Time = 0.0;
+	pthread_mutex_lock(&(scheduler->Mutex));
+	if(scheduler->Queue_List.size() >= GCP_CLIENT_SCHEDULER_MAX_QUEUE_COUNT)
+	{
+		pthread_mutex_unlock(&(scheduler->Mutex));
+		Scheduler_Error_Number = 11;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Add_Queue:Too many queues (%d).",
+			GCP_CLIENT_SCHEDULER_MAX_QUEUE_COUNT);
+		return FALSE;
+	}
+	(*queue_index) = scheduler->Queue_List.size();
+	scheduler->Queue_List.push_back(queue);
+	pthread_mutex_unlock(&(scheduler->Mutex));
+	return TRUE;
+}
+
+/**
+ * Submit a job to a scheduler queue. The job is given an operation of it's own, which is passed to job_fn when
+ * the job runs, and which is used to cancel, bound and pause the job's transfer. A job that can't run straight
+ * away may preempt a running preemptible job of a lower priority class (Scheduler_Preempt).
+ * @param scheduler The scheduler.
+ * @param queue_index The index of the queue, returned by GCP_Client_Scheduler_Add_Queue.
+ * @param bucket_name The name of the bucket the job transfers to or from, used to limit the jobs running at once for
+ *        one bucket. Can be NULL, in which case the job is not limited.
+ * @param flags The job's flags: 0, or GCP_CLIENT_SCHEDULER_FLAG_PREEMPTIBLE.
+ * @param deadline_ms How long after submission the job must finish by, in milliseconds, or 0 for no deadline.
+ *        Jobs with a deadline run before jobs without one in the same queue, earliest deadline first.
+ * @param job_fn The function that runs the job.
+ * @param done_fn A function called when the job has finished (succeeded, failed, been cancelled or missed it's
+ *        deadline), or NULL.
+ * @param user_data A pointer passed to job_fn and done_fn.
+ * @param job_id The address of an integer to fill in with the job's id, or NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Scheduler_Job_Struct
+ * @see #Scheduler_Preempt
+ * @see gcp_client_operation.html#GCP_Client_Operation_Create
+ */
+int GCP_Client_Scheduler_Submit(struct GCP_Client_Scheduler_Struct *scheduler,int queue_index,
+				const char *bucket_name,int flags,int deadline_ms,
+				GCP_Client_Scheduler_Job_Function_T job_fn,
+				GCP_Client_Scheduler_Done_Function_T done_fn,void *user_data,
+				unsigned long long *job_id)
+{
+	struct Scheduler_Job_Struct *job = NULL;
+	struct Scheduler_Queue_Struct *queue = NULL;
+
+	Scheduler_Error_Number = 0;
+	if(scheduler == NULL)
+	{
+		Scheduler_Error_Number = 12;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Submit:scheduler was NULL.");
+		return FALSE;
+	}
+	if(job_fn == NULL)
+	{
+		Scheduler_Error_Number = 13;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Submit:job_fn was NULL.");
+		return FALSE;
+	}
+	if(deadline_ms < 0)
+	{
+		Scheduler_Error_Number = 14;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Submit:Illegal deadline %d ms.",deadline_ms);
+		return FALSE;
+	}
+	job = new (std::nothrow) struct Scheduler_Job_Struct;
+	if(job == NULL)
+	{
+		Scheduler_Error_Number = 15;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Submit:Failed to allocate job.");
+		return FALSE;
+	}
+	if(!GCP_Client_Operation_Create(&(job->Operation)))
+	{
+		delete job;
+		Scheduler_Error_Number = 16;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Submit:Failed to create operation.");
+		return FALSE;
+	}
+	job->Queue_Index = queue_index;
+	if(bucket_name != NULL)
+		job->Bucket_Name = bucket_name;
+	job->Flags = flags;
+	job->Deadline_Ms = deadline_ms;
+	clock_gettime(CLOCK_MONOTONIC,&(job->Submit_Time));
+	job->Queue_Time = job->Submit_Time;
+	job->Start_Time = job->Submit_Time;
+	job->Job_Function = job_fn;
+	job->Done_Function = done_fn;
+	job->User_Data = user_data;
+	job->Pausing = FALSE;
+	job->Cancelled = FALSE;
+	pthread_mutex_lock(&(scheduler->Mutex));
+	if((queue_index < 0)||(queue_index >= (int)scheduler->Queue_List.size())||scheduler->Shutdown)
+	{
+		pthread_mutex_unlock(&(scheduler->Mutex));
+		GCP_Client_Operation_Destroy(job->Operation);
+		delete job;
+		Scheduler_Error_Number = 17;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Submit:Illegal queue index %d, "
+			"or the scheduler is shutting down.",queue_index);
+		return FALSE;
+	}
+	queue = &(scheduler->Queue_List[queue_index]);
+	/* a queue that has been idle starts level with the busiest of it's priority, rather than catching up on
+	** the run time it did not use */
+	if((queue->Job_List.size() == 0)&&(queue->Stats.Running_Count == 0))
+	{
+		for(auto &other_queue : scheduler->Queue_List)
+		{
+			if((other_queue.Stats.Priority == queue->Stats.Priority)&&
+			   ((other_queue.Job_List.size() > 0)||(other_queue.Stats.Running_Count > 0))&&
+			   (other_queue.Virtual_Time > queue->Virtual_Time))
+				queue->Virtual_Time = other_queue.Virtual_Time;
+		}
+	}
+	job->Id = scheduler->Next_Job_Id++;
+	queue->Job_List.push_back(job);
+	queue->Stats.Submitted_Count++;
+	scheduler->Job_Count++;
+	if(job_id != NULL)
+		(*job_id) = job->Id;
+	/* logged before the mutex is released, a worker can run and free the job as soon as it is */
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SCHEDULER,LOG_VERBOSITY_VERY_VERBOSE,
+					     "GCP_Client_Scheduler_Submit:Job %llu submitted to queue '%s' "
+					     "(bucket '%s', flags %d, deadline %d ms).",job->Id,queue->Stats.Name,
+					     job->Bucket_Name.c_str(),flags,deadline_ms);
+#endif
+	Scheduler_Preempt(scheduler);
+	pthread_cond_broadcast(&(scheduler->Work_Condition));
+	pthread_mutex_unlock(&(scheduler->Mutex));
+	return TRUE;
+}
+
+/**
+ * Cancel a job. A waiting job is removed from it's queue, and it's done function called (from this thread) with
+ * GCP_CLIENT_OPERATION_STATE_CANCELLED. A running job's operation is cancelled (GCP_Client_Operation_Cancel), so it's
+ * transfer stops after the chunk in progress, and it's done function is called from it's worker.
+ * @param scheduler The scheduler.
+ * @param job_id The id of the job, returned by GCP_Client_Scheduler_Submit.
+ * @return The routine returns TRUE on success, and FALSE on failure (including when the job has already
+ *         finished).
+ * @see #Scheduler_Finish
+ * @see #Scheduler_Queue_Remove
+ * @see gcp_client_operation.html#GCP_Client_Operation_Cancel
+ */
+int GCP_Client_Scheduler_Cancel(struct GCP_Client_Scheduler_Struct *scheduler,unsigned long long job_id)
+{
+	Scheduler_Error_Number = 0;
+	if(scheduler == NULL)
+	{
+		Scheduler_Error_Number = 18;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Cancel:scheduler was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(scheduler->Mutex));
+	for(auto &job : scheduler->Running_List)
+	{
+		if(job->Id == job_id)
+		{
+			job->Cancelled = TRUE;
+			GCP_Client_Operation_Cancel(job->Operation);
+			pthread_mutex_unlock(&(scheduler->Mutex));
+			return TRUE;
+		}
+	}
+	for(auto &queue : scheduler->Queue_List)
+	{
+		for(auto job : queue.Job_List)
+		{
+			if(job->Id == job_id)
+			{
+				Scheduler_Queue_Remove(&queue,job);
+				/* the done function is called with the mutex unlocked */
+				Scheduler_Finish(scheduler,job,GCP_CLIENT_OPERATION_STATE_CANCELLED);
+				pthread_mutex_unlock(&(scheduler->Mutex));
+				return TRUE;
+			}
+		}
+	}
+	pthread_mutex_unlock(&(scheduler->Mutex));
+	Scheduler_Error_Number = 19;
+	sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Cancel:Job %llu not found (it may have finished).",
+		job_id);
+	return FALSE;
+}
+
+/**
+ * Wait until all the jobs submitted to the scheduler have finished, and their done functions have returned.
+ * This must not be called from a job or done function.
+ * @param scheduler The scheduler.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Scheduler_Struct
+ */
+int GCP_Client_Scheduler_Wait(struct GCP_Client_Scheduler_Struct *scheduler)
+{
+	Scheduler_Error_Number = 0;
+	if(scheduler == NULL)
+	{
+		Scheduler_Error_Number = 20;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Wait:scheduler was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(scheduler->Mutex));
+	while(scheduler->Job_Count > 0)
+		pthread_cond_wait(&(scheduler->Idle_Condition),&(scheduler->Mutex));
+	pthread_mutex_unlock(&(scheduler->Mutex));
+	return TRUE;
+}
+
+/**
+ * Get the statistics of a scheduler queue, including the time jobs have waited in it.
+ * @param scheduler The scheduler.
+ * @param queue_index The index of the queue, returned by GCP_Client_Scheduler_Add_Queue.
+ * @param stats The address of a structure to fill in with the queue's statistics.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Scheduler_Queue_Struct
+ * @see gcp_client_general.html#fdifftime
+ */
+int GCP_Client_Scheduler_Get_Queue_Stats(struct GCP_Client_Scheduler_Struct *scheduler,int queue_index,
+					 struct GCP_Client_Scheduler_Queue_Stats_Struct *stats)
+{
+	struct Scheduler_Queue_Struct *queue = NULL;
+	struct timespec current_time;
+	double wait_time;
+
+	Scheduler_Error_Number = 0;
+	if(scheduler == NULL)
+	{
+		Scheduler_Error_Number = 21;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Get_Queue_Stats:scheduler was NULL.");
+		return FALSE;
+	}
+	if(stats == NULL)
+	{
+		Scheduler_Error_Number = 22;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Get_Queue_Stats:stats was NULL.");
+		return FALSE;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	pthread_mutex_lock(&(scheduler->Mutex));
+	if((queue_index < 0)||(queue_index >= (int)scheduler->Queue_List.size()))
+	{
+		pthread_mutex_unlock(&(scheduler->Mutex));
+		Scheduler_Error_Number = 23;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Get_Queue_Stats:Illegal queue index %d.",
+			queue_index);
+		return FALSE;
+	}
+	queue = &(scheduler->Queue_List[queue_index]);
+	(*stats) = queue->Stats;
+	stats->Queued_Count = queue->Job_List.size();
+	if(stats->Start_Count > 0)
+		stats->Wait_Time_Mean = queue->Wait_Time_Sum/((double)stats->Start_Count);
+	else
+		stats->Wait_Time_Mean = 0.0;
+	stats->Oldest_Wait_Time = 0.0;
+	for(auto &job : queue->Job_List)
+	{
+		wait_time = fdifftime(current_time,job->Queue_Time);
+		if(wait_time > stats->Oldest_Wait_Time)
+			stats->Oldest_Wait_Time = wait_time;
+	}
+	pthread_mutex_unlock(&(scheduler->Mutex));
+	return TRUE;
+}
+
+/**
+ * Destroy a scheduler. No more jobs can be submitted, the jobs already submitted are run (cancel them first
+ * to stop them), and the worker threads are stopped once they have finished. This must not be called from a job
+ * or done function.
+ * @param scheduler The scheduler.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #GCP_Client_Scheduler_Struct
+ * @see #GCP_Client_Scheduler_Create
+ */
+int GCP_Client_Scheduler_Destroy(struct GCP_Client_Scheduler_Struct *scheduler)
+{
+	Scheduler_Error_Number = 0;
+	if(scheduler == NULL)
+	{
+		Scheduler_Error_Number = 24;
+		sprintf(Scheduler_Error_String,"GCP_Client_Scheduler_Destroy:scheduler was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(scheduler->Mutex));
+	scheduler->Shutdown = TRUE;
+	while(scheduler->Job_Count > 0)
+		pthread_cond_wait(&(scheduler->Idle_Condition),&(scheduler->Mutex));
+	pthread_cond_broadcast(&(scheduler->Work_Condition));
+	pthread_mutex_unlock(&(scheduler->Mutex));
+	for(auto &worker : scheduler->Worker_List)
+		pthread_join(worker,NULL);
+	pthread_cond_destroy(&(scheduler->Idle_Condition));
+	pthread_cond_destroy(&(scheduler->Work_Condition));
+	pthread_mutex_destroy(&(scheduler->Mutex));
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SCHEDULER,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Scheduler_Destroy:Scheduler %p stopped.",(void*)scheduler);
+#endif
+	delete scheduler;
+	return TRUE;
+}
+
+/**
+ * Get the current value of the scheduler module's error number.
+ * @return The current value of the scheduler module's error number.
+ * @see #Scheduler_Error_Number
+ */
+int GCP_Client_Scheduler_Get_Error_Number(void)
+{
+	return Scheduler_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Scheduler_Error_Number
+ * @see #Scheduler_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Scheduler_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Scheduler_Error_Number == 0)
+		sprintf(Scheduler_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Scheduler:Error(%d) : %s\n",time_string,Scheduler_Error_Number,
+		Scheduler_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Scheduler_Error_Number
+ * @see #Scheduler_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Scheduler_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Scheduler_Error_Number == 0)
+		sprintf(Scheduler_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Scheduler:Error(%d) : %s\n",time_string,
+		Scheduler_Error_Number,Scheduler_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Worker thread. Repeatedly picks the next job to run (Scheduler_Pick), and runs it in this thread at it's queue's
+ * bandwidth priority, with the rest of it's deadline as it's operation's deadline. A job still waiting when it's
+ * deadline has passed is failed without running. A job that stopped because it was preempted is resumed
+ * (GCP_Client_Operation_Resume) and queued again, otherwise the job is finished (Scheduler_Finish).
+ * The thread exits when the scheduler is shutting down and has no jobs left.
+ * @param user_data The scheduler, cast to a void pointer.
+ * @return The routine returns NULL.
+ * @see #Scheduler_Pick
+ * @see #Scheduler_Finish
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Set_Thread_Priority
+ * @see gcp_client_general.html#fdifftime
+ * @see gcp_client_operation.html#GCP_Client_Operation_Get_State
+ * @see gcp_client_operation.html#GCP_Client_Operation_Resume
+ * @see gcp_client_operation.html#GCP_Client_Operation_Set_Deadline
+ */
+static void *Scheduler_Worker_Thread(void *user_data)
+{
+	struct GCP_Client_Scheduler_Struct *scheduler = (struct GCP_Client_Scheduler_Struct *)user_data;
+	struct Scheduler_Job_Struct *job = NULL;
+	struct Scheduler_Queue_Struct *queue = NULL;
+	struct timespec current_time;
+	double wait_time,run_time,remaining_ms;
+	int priority,retval,state;
+
+	pthread_mutex_lock(&(scheduler->Mutex));
+	while(TRUE)
+	{
+		job = Scheduler_Pick(scheduler,TRUE);
+		if(job == NULL)
+		{
+			if(scheduler->Shutdown&&(scheduler->Job_Count == 0))
+				break;
+			pthread_cond_wait(&(scheduler->Work_Condition),&(scheduler->Mutex));
+			continue;
+		}
+		queue = &(scheduler->Queue_List[job->Queue_Index]);
+		Scheduler_Queue_Remove(queue,job);
+		clock_gettime(CLOCK_MONOTONIC,&current_time);
+		remaining_ms = 0.0;
+		if(job->Deadline_Ms > 0)
+		{
+			remaining_ms = job->Deadline_Ms-(fdifftime(current_time,job->Submit_Time)*1000.0);
+			if(remaining_ms < 1.0)
+			{
+				/* too late to start: fail the job without running it */
+				Scheduler_Finish(scheduler,job,GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED);
+				continue;
+			}
+		}
+		wait_time = fdifftime(current_time,job->Queue_Time);
+		queue->Wait_Time_Sum += wait_time;
+		if(wait_time > queue->Stats.Wait_Time_Max)
+			queue->Stats.Wait_Time_Max = wait_time;
+		queue->Stats.Start_Count++;
+		queue->Stats.Running_Count++;
+		scheduler->Bucket_Running_Count[job->Bucket_Name]++;
+		scheduler->Running_List.push_back(job);
+		job->Start_Time = current_time;
+		priority = queue->Stats.Priority;
+		pthread_mutex_unlock(&(scheduler->Mutex));
+#if LOGGING > 5
+		GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SCHEDULER,
+						     LOG_VERBOSITY_VERY_VERBOSE,
+						     "Scheduler_Worker_Thread:Starting job %llu after waiting %.3f s.",
+						     job->Id,wait_time);
+#endif
+		/* run the job */
+		GCP_Client_Bandwidth_Set_Thread_Priority(priority);
+		if(job->Deadline_Ms > 0)
+			GCP_Client_Operation_Set_Deadline(job->Operation,(int)remaining_ms);
+		retval = job->Job_Function(job->Operation,job->User_Data);
+		GCP_Client_Operation_Get_State(job->Operation,&state,NULL);
+		clock_gettime(CLOCK_MONOTONIC,&current_time);
+		run_time = fdifftime(current_time,job->Start_Time);
+		pthread_mutex_lock(&(scheduler->Mutex));
+		queue = &(scheduler->Queue_List[job->Queue_Index]);
+		queue->Stats.Running_Count--;
+		queue->Stats.Run_Time += run_time;
+		queue->Virtual_Time += run_time/((double)queue->Stats.Weight);
+		scheduler->Bucket_Running_Count[job->Bucket_Name]--;
+		for(auto it = scheduler->Running_List.begin(); it != scheduler->Running_List.end(); it++)
+		{
+			if((*it) == job)
+			{
+				scheduler->Running_List.erase(it);
+				break;
+			}
+		}
+		if((retval == FALSE)&&(state == GCP_CLIENT_OPERATION_STATE_PAUSED)&&(job->Cancelled == FALSE))
+		{
+			/* preempted: queue the job again, to carry on when it is next picked */
+			GCP_Client_Operation_Resume(job->Operation);
+			job->Pausing = FALSE;
+			job->Queue_Time = current_time;
+			queue->Job_List.push_back(job);
+			queue->Stats.Preempted_Count++;
+#if LOGGING > 1
+			GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SCHEDULER,
+							     LOG_VERBOSITY_INTERMEDIATE,
+							     "Scheduler_Worker_Thread:Job %llu in queue '%s' preempted.",
+							     job->Id,queue->Stats.Name);
+#endif
+			pthread_cond_broadcast(&(scheduler->Work_Condition));
+			continue;
+		}
+		if(retval)
+			state = GCP_CLIENT_OPERATION_STATE_COMPLETED;
+		else if(job->Cancelled)
+			state = GCP_CLIENT_OPERATION_STATE_CANCELLED;
+		else if((state != GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED)&&
+			(state != GCP_CLIENT_OPERATION_STATE_STALLED))
+			state = GCP_CLIENT_OPERATION_STATE_FAILED;
+		Scheduler_Finish(scheduler,job,state);
+	}
+	pthread_mutex_unlock(&(scheduler->Mutex));
+	return NULL;
+}
+
+/**
+ * Pick the job to run next. The scheduler's mutex must be locked. Priority classes are searched in order, and
+ * within a class the queue with the fewest running jobs for it's weight is chosen (then the least virtual time,
+ * then the lowest index), from the queues with a job that can run. The queue's best job is returned.
+ * @param scheduler The scheduler.
+ * @param check_bucket A boolean, if TRUE jobs whose bucket already has Bucket_Concurrency jobs running are
+ *        passed over.
+ * @return The job to run next (left in it's queue), or NULL if there is none.
+ * @see #Scheduler_Queue_Best_Job
+ */
+static struct Scheduler_Job_Struct *Scheduler_Pick(struct GCP_Client_Scheduler_Struct *scheduler,int check_bucket)
+{
+	struct Scheduler_Job_Struct *best_job = NULL;
+	struct Scheduler_Job_Struct *job = NULL;
+	struct Scheduler_Queue_Struct *best_queue = NULL;
+	double share,best_share = 0.0;
+	int priority;
+
+	for(priority = 0; priority < GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT; priority++)
+	{
+		for(auto &queue : scheduler->Queue_List)
+		{
+			if(queue.Stats.Priority != priority)
+				continue;
+			job = Scheduler_Queue_Best_Job(scheduler,&queue,check_bucket);
+			if(job == NULL)
+				continue;
+			share = ((double)(queue.Stats.Running_Count+1))/((double)queue.Stats.Weight);
+			if((best_job == NULL)||(share < best_share)||
+			   ((share == best_share)&&(queue.Virtual_Time < best_queue->Virtual_Time)))
+			{
+				best_job = job;
+				best_queue = &queue;
+				best_share = share;
+			}
+		}
+		if(best_job != NULL)
+			return best_job;
+	}
+	return NULL;
+}
+
+/**
+ * Find the job in a queue that should run first: the one with the earliest deadline, and then the one submitted
+ * first (jobs without a deadline come after those with one). The scheduler's mutex must be locked.
+ * @param scheduler The scheduler.
+ * @param queue The queue.
+ * @param check_bucket A boolean, if TRUE jobs whose bucket is full (Scheduler_Bucket_Full) are passed over.
+ * @return The job, or NULL if the queue has no job that can run.
+ * @see #Scheduler_Job_Before
+ * @see #Scheduler_Bucket_Full
+ */
+static struct Scheduler_Job_Struct *Scheduler_Queue_Best_Job(struct GCP_Client_Scheduler_Struct *scheduler,
+							     struct Scheduler_Queue_Struct *queue,int check_bucket)
+{
+	struct Scheduler_Job_Struct *best_job = NULL;
+
+	for(auto &job : queue->Job_List)
+	{
+		if(check_bucket&&Scheduler_Bucket_Full(scheduler,job->Bucket_Name))
+			continue;
+		if((best_job == NULL)||Scheduler_Job_Before(job,best_job))
+			best_job = job;
+	}
+	return best_job;
+}
+
+/**
+ * Return whether a job should run before another job in the same queue.
+ * @param job The job.
+ * @param other_job The other job.
+ * @return TRUE if job has a deadline and other_job does not, or both have deadlines and job's is earlier, or
+ *         neither has an earlier deadline and job was submitted first. FALSE otherwise.
+ * @see gcp_client_general.html#fdifftime
+ */
+static int Scheduler_Job_Before(struct Scheduler_Job_Struct *job,struct Scheduler_Job_Struct *other_job)
+{
+	double deadline_diff;
+
+	if((job->Deadline_Ms > 0)&&(other_job->Deadline_Ms == 0))
+		return TRUE;
+	if((job->Deadline_Ms == 0)&&(other_job->Deadline_Ms > 0))
+		return FALSE;
+	if(job->Deadline_Ms > 0)
+	{
+		/* the difference in absolute deadlines, in milliseconds */
+		deadline_diff = (fdifftime(other_job->Submit_Time,job->Submit_Time)*1000.0)+
+			(job->Deadline_Ms-other_job->Deadline_Ms);
+		if(deadline_diff != 0.0)
+			return (deadline_diff < 0.0);
+	}
+	return (job->Id < other_job->Id);
+}
+
+/**
+ * Preempt a running job if a more urgent job is waiting. The scheduler's mutex must be locked. If the best
+ * waiting job can't run now, because all the workers are busy or it's bucket is at it's limit, the running
+ * preemptible job with the lowest priority class below the waiting job's (in the same bucket, if the bucket is full)
+ * is paused, most recently started first. Only one job is paused at a time, so a burst of urgent jobs does not
+ * stop more lower priority jobs than it needs.
+ * @param scheduler The scheduler.
+ * @see #Scheduler_Pick
+ * @see #Scheduler_Bucket_Full
+ * @see gcp_client_operation.html#GCP_Client_Operation_Pause
+ */
+static void Scheduler_Preempt(struct GCP_Client_Scheduler_Struct *scheduler)
+{
+	struct Scheduler_Job_Struct *waiting_job = NULL;
+	struct Scheduler_Job_Struct *victim_job = NULL;
+	int waiting_priority,victim_priority = 0,priority,bucket_full;
+
+	for(auto &job : scheduler->Running_List)
+	{
+		if(job->Pausing)
+			return;
+	}
+	waiting_job = Scheduler_Pick(scheduler,FALSE);
+	if(waiting_job == NULL)
+		return;
+	bucket_full = Scheduler_Bucket_Full(scheduler,waiting_job->Bucket_Name);
+	if((scheduler->Running_List.size() < scheduler->Worker_List.size())&&(bucket_full == FALSE))
+		return;
+	waiting_priority = scheduler->Queue_List[waiting_job->Queue_Index].Stats.Priority;
+	for(auto &job : scheduler->Running_List)
+	{
+		if((job->Flags & GCP_CLIENT_SCHEDULER_FLAG_PREEMPTIBLE) == 0)
+			continue;
+		if(bucket_full&&(job->Bucket_Name != waiting_job->Bucket_Name))
+			continue;
+		priority = scheduler->Queue_List[job->Queue_Index].Stats.Priority;
+		if(priority <= waiting_priority)
+			continue;
+		if((victim_job == NULL)||(priority > victim_priority)||
+		   ((priority == victim_priority)&&(fdifftime(victim_job->Start_Time,job->Start_Time) > 0.0)))
+		{
+			victim_job = job;
+			victim_priority = priority;
+		}
+	}
+	if(victim_job == NULL)
+		return;
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SCHEDULER,LOG_VERBOSITY_INTERMEDIATE,
+					     "Scheduler_Preempt:Pausing job %llu for job %llu.",victim_job->Id,
+					     waiting_job->Id);
+#endif
+	victim_job->Pausing = TRUE;
+	GCP_Client_Operation_Pause(victim_job->Operation);
+}
+
+/**
+ * Return whether a bucket already has the most jobs running that it can. The scheduler's mutex must be locked.
+ * @param scheduler The scheduler.
+ * @param bucket_name The bucket name (an empty string for jobs that are not limited).
+ * @return TRUE if the bucket has Bucket_Concurrency jobs running, FALSE otherwise.
+ */
+static int Scheduler_Bucket_Full(struct GCP_Client_Scheduler_Struct *scheduler,std::string const &bucket_name)
+{
+	if((scheduler->Bucket_Concurrency == 0)||bucket_name.empty())
+		return FALSE;
+	auto it = scheduler->Bucket_Running_Count.find(bucket_name);
+	if(it == scheduler->Bucket_Running_Count.end())
+		return FALSE;
+	return (it->second >= scheduler->Bucket_Concurrency);
+}
+
+/**
+ * Remove a job from a queue's list of waiting jobs. The scheduler's mutex must be locked.
+ * @param queue The queue.
+ * @param job The job.
+ */
+static void Scheduler_Queue_Remove(struct Scheduler_Queue_Struct *queue,struct Scheduler_Job_Struct *job)
+{
+	for(auto it = queue->Job_List.begin(); it != queue->Job_List.end(); it++)
+	{
+		if((*it) == job)
+		{
+			queue->Job_List.erase(it);
+			return;
+		}
+	}
+}
+
+/**
+ * Finish a job that is no longer queued or running. It's queue's statistics are updated, and the mutex unlocked
+ * while it's done function is called and it is freed. The mutex is locked again before the scheduler's job count is
+ * decremented, so GCP_Client_Scheduler_Wait does not return before the done function has. The scheduler's mutex
+ * must be locked on entry, and is locked on return.
+ * @param scheduler The scheduler.
+ * @param job The job.
+ * @param state The state the job finished in (GCP_CLIENT_OPERATION_STATE_COMPLETED etc).
+ * @see gcp_client_operation.html#GCP_Client_Operation_Destroy
+ */
+static void Scheduler_Finish(struct GCP_Client_Scheduler_Struct *scheduler,struct Scheduler_Job_Struct *job,
+			     int state)
+{
+	struct Scheduler_Queue_Struct *queue = NULL;
+
+	queue = &(scheduler->Queue_List[job->Queue_Index]);
+	if(state == GCP_CLIENT_OPERATION_STATE_COMPLETED)
+		queue->Stats.Completed_Count++;
+	else if(state == GCP_CLIENT_OPERATION_STATE_CANCELLED)
+		queue->Stats.Cancelled_Count++;
+	else if(state == GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED)
+		queue->Stats.Deadline_Missed_Count++;
+	else
+		queue->Stats.Failed_Count++;
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SCHEDULER,LOG_VERBOSITY_VERY_VERBOSE,
+					     "Scheduler_Finish:Job %llu in queue '%s' finished:%s.",job->Id,
+					     queue->Stats.Name,GCP_Client_Operation_State_To_String(state));
+#endif
+	pthread_mutex_unlock(&(scheduler->Mutex));
+	if(job->Done_Function != NULL)
+		job->Done_Function(job->Id,state,job->User_Data);
+	GCP_Client_Operation_Destroy(job->Operation);
+	delete job;
+	pthread_mutex_lock(&(scheduler->Mutex));
+	scheduler->Job_Count--;
+	pthread_cond_broadcast(&(scheduler->Idle_Condition));
+	pthread_cond_broadcast(&(scheduler->Work_Condition));
+}
@@ -0,0 +1,522 @@
+/* gcp_client_stats.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Operation statistics.
+*/
+/**
+ * Per-operation statistics (counts, bytes, errors, retries, and latency and throughput histograms) for the
+ * operations performed by the library. Each thread updates its own shard of counters without locking
+ * (each counter has a single writer), and GCP_Client_Stats_Get sums the shards.
+ * Histograms are log-linear (in the style of HDR histograms): 16 sub-buckets per power of two.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <new>
+#include "gcp_client_general.h"
+#include "gcp_client_stats.h"
+
+/* defines */
+/**
+ * The number of sub-buckets in each power of two range of a histogram.
+ * @see gcp_client_stats.html#GCP_CLIENT_STATS_HISTOGRAM_SUB_BUCKET_BITS
+ */
+#define STATS_SUB_BUCKET_COUNT         (1<<GCP_CLIENT_STATS_HISTOGRAM_SUB_BUCKET_BITS)
+
+/* data types */
+/**
+ * Data type holding one operation's counters in a per-thread shard. The fields mirror
+ * GCP_Client_Stats_Operation_Struct. They are atomic so other threads can read them whilst they are being updated,
+ * but as only the owning thread writes them, they are updated with a relaxed load and store rather than
+ * a locked read-modify-write. Max_Latency_US cannot be rebased by subtraction, so Max_Latency_Generation records
+ * which Stats_Reset_Generation it was set in, and it is restarted from 0 when a reset has happened since.
+ * @see gcp_client_stats.html#GCP_Client_Stats_Operation_Struct
+ * @see #Stats_Reset_Generation
+ */
+struct Stats_Shard_Operation_Struct
+{
+	std::atomic<unsigned long long> Count;
+	std::atomic<unsigned long long> Error_Count;
+	std::atomic<unsigned long long> Retry_Count;
+	std::atomic<unsigned long long> Byte_Count;
+	std::atomic<unsigned long long> Total_Latency_US;
+	std::atomic<unsigned long long> Max_Latency_US;
+	std::atomic<unsigned int> Max_Latency_Generation;
+	std::atomic<unsigned long long> Latency_Histogram[GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT];
+	std::atomic<unsigned long long> Throughput_Histogram[GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT];
+};
+
+/**
+ * Data type holding one thread's shard of statistics. Shards are never freed: when a thread exits its shard
+ * is marked as not in use (keeping its counts), and can be claimed by a new thread.
+ * This consists of the following:
+ * <dl>
+ * <dt>Operation_List</dt> <dd>The counters for each operation.</dd>
+ * <dt>In_Use</dt> <dd>Whether a thread currently owns this shard.</dd>
+ * <dt>Next</dt> <dd>The next shard in Stats_Shard_List.</dd>
+ * </dl>
+ * @see #Stats_Shard_List
+ */
+struct Stats_Shard_Struct
+{
+	struct Stats_Shard_Operation_Struct Operation_List[GCP_CLIENT_STATS_OPERATION_COUNT];
+	std::atomic<int> In_Use;
+	struct Stats_Shard_Struct *Next;
+};
+
+/**
+ * Class whose only purpose is to release the calling thread's statistics shard, via it's destructor,
+ * when the thread exits.
+ * @see #Stats_Thread_Shard
+ */
+class Stats_Thread_Shard_Holder
+{
+	public:
+		struct Stats_Shard_Struct *Shard = NULL;
+		~Stats_Thread_Shard_Holder()
+		{
+			if(Shard != NULL)
+				Shard->In_Use.store(FALSE,std::memory_order_release);
+		}
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The names of the operations, indexed by GCP_CLIENT_STATS_OPERATION_*.
+ */
+static const char *Stats_Operation_Name_List[GCP_CLIENT_STATS_OPERATION_COUNT] =
+{
+	"read","write","open","metadata","list","copy","delete"
+};
+/**
+ * Lock-free singly linked list of all the statistics shards ever created. New shards are pushed onto
+ * the head with a compare and swap.
+ * @see #Stats_Shard_Struct
+ */
+static std::atomic<struct Stats_Shard_Struct *> Stats_Shard_List(NULL);
+/**
+ * The calling thread's statistics shard.
+ * @see #Stats_Thread_Shard_Holder
+ * @see #Stats_Get_Thread_Shard
+ */
+static thread_local Stats_Thread_Shard_Holder Stats_Thread_Shard;
+/**
+ * The sum of the shards when GCP_Client_Stats_Reset was last called. GCP_Client_Stats_Get returns the current
+ * sum of the shards minus this baseline, so resetting never has to write to another thread's counters.
+ * @see #Stats_Baseline_Mutex
+ */
+static struct GCP_Client_Stats_Struct Stats_Baseline;
+/**
+ * Incremented by every GCP_Client_Stats_Reset, so shards know to restart their maximum latency.
+ * @see #Stats_Shard_Operation_Struct
+ */
+static std::atomic<unsigned int> Stats_Reset_Generation(0);
+/**
+ * Mutex protecting Stats_Baseline. Only GCP_Client_Stats_Get and GCP_Client_Stats_Reset lock it, the
+ * operations being measured do not.
+ * @see #Stats_Baseline
+ */
+static pthread_mutex_t Stats_Baseline_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * Variable holding error code of last operation performed.
+ */
+static int Stats_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static char Stats_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static struct Stats_Shard_Struct *Stats_Get_Thread_Shard(void);
+static void Stats_Sum_Shards(struct GCP_Client_Stats_Struct *stats);
+static int Stats_Histogram_Index(unsigned long long value);
+static unsigned long long Stats_Histogram_Value(int index);
+static inline void Stats_Increment(std::atomic<unsigned long long> &counter,unsigned long long value);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Get the library statistics accumulated since the last call to GCP_Client_Stats_Reset (or since the
+ * program started). The per-thread shards are summed, and the reset baseline subtracted.
+ * @param stats The address of a GCP_Client_Stats_Struct to fill in.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Stats_Error_Number /
+ *         Stats_Error_String should contain details of the failure.
+ * @see #Stats_Sum_Shards
+ * @see #Stats_Baseline
+ * @see #Stats_Baseline_Mutex
+ */
+int GCP_Client_Stats_Get(struct GCP_Client_Stats_Struct *stats)
+{
+	struct GCP_Client_Stats_Operation_Struct *operation = NULL;
+	struct GCP_Client_Stats_Operation_Struct *baseline = NULL;
+	int i,j;
+
+	Stats_Error_Number = 0;
+	if(stats == NULL)
+	{
+		Stats_Error_Number = 1;
+		sprintf(Stats_Error_String,"GCP_Client_Stats_Get:stats was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&Stats_Baseline_Mutex);
+	Stats_Sum_Shards(stats);
+	for(i = 0; i < GCP_CLIENT_STATS_OPERATION_COUNT; i++)
+	{
+		operation = &(stats->Operation_List[i]);
+		baseline = &(Stats_Baseline.Operation_List[i]);
+		operation->Count -= baseline->Count;
+		operation->Error_Count -= baseline->Error_Count;
+		operation->Retry_Count -= baseline->Retry_Count;
+		operation->Byte_Count -= baseline->Byte_Count;
+		operation->Total_Latency_US -= baseline->Total_Latency_US;
+		for(j = 0; j < GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT; j++)
+		{
+			operation->Latency_Histogram[j] -= baseline->Latency_Histogram[j];
+			operation->Throughput_Histogram[j] -= baseline->Throughput_Histogram[j];
+		}
+	}
+	pthread_mutex_unlock(&Stats_Baseline_Mutex);
+	return TRUE;
+}
+
+/**
+ * Reset the library statistics. The current sum of the per-thread shards is stored as a baseline, which
+ * is subtracted by subsequent calls to GCP_Client_Stats_Get. Stats_Reset_Generation is incremented, so the
+ * shards' maximum latencies restart.
+ * @see #Stats_Sum_Shards
+ * @see #Stats_Baseline
+ * @see #Stats_Baseline_Mutex
+ * @see #Stats_Reset_Generation
+ */
+void GCP_Client_Stats_Reset(void)
+{
+	pthread_mutex_lock(&Stats_Baseline_Mutex);
+	Stats_Reset_Generation.fetch_add(1,std::memory_order_relaxed);
+	Stats_Sum_Shards(&Stats_Baseline);
+	pthread_mutex_unlock(&Stats_Baseline_Mutex);
+}
+
+/**
+ * Record the completion of an operation in the calling thread's statistics shard. This is lock-free.
+ * @param operation Which operation completed, one of GCP_CLIENT_STATS_OPERATION_*. Out of range operations
+ *        are ignored.
+ * @param start_time When the operation started (CLOCK_MONOTONIC). The latency is measured from this time to now.
+ * @param byte_count The number of bytes transferred by the operation.
+ * @param success Whether the operation succeeded (TRUE) or failed (FALSE).
+ * @see #Stats_Get_Thread_Shard
+ * @see #Stats_Increment
+ * @see #Stats_Histogram_Index
+ */
+void GCP_Client_Stats_Record(int operation,struct timespec start_time,size_t byte_count,int success)
+{
+	struct Stats_Shard_Struct *shard = NULL;
+	struct Stats_Shard_Operation_Struct *shard_operation = NULL;
+	struct timespec end_time;
+	double elapsed_time;
+	unsigned long long latency_us;
+	unsigned int generation;
+
+	if((operation < 0)||(operation >= GCP_CLIENT_STATS_OPERATION_COUNT))
+		return;
+	shard = Stats_Get_Thread_Shard();
+	if(shard == NULL)
+		return;
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	elapsed_time = fdifftime(end_time,start_time);
+	if(elapsed_time < 0.0)
+		elapsed_time = 0.0;
+	latency_us = (unsigned long long)(elapsed_time*GCP_CLIENT_GENERAL_ONE_SECOND_US);
+	shard_operation = &(shard->Operation_List[operation]);
+	Stats_Increment(shard_operation->Count,1);
+	if(success == FALSE)
+		Stats_Increment(shard_operation->Error_Count,1);
+	Stats_Increment(shard_operation->Byte_Count,byte_count);
+	Stats_Increment(shard_operation->Total_Latency_US,latency_us);
+	generation = Stats_Reset_Generation.load(std::memory_order_relaxed);
+	if((generation != shard_operation->Max_Latency_Generation.load(std::memory_order_relaxed))||
+	   (latency_us > shard_operation->Max_Latency_US.load(std::memory_order_relaxed)))
+	{
+		shard_operation->Max_Latency_US.store(latency_us,std::memory_order_relaxed);
+		shard_operation->Max_Latency_Generation.store(generation,std::memory_order_relaxed);
+	}
+	Stats_Increment(shard_operation->Latency_Histogram[Stats_Histogram_Index(latency_us)],1);
+	if((byte_count > 0)&&(elapsed_time > 0.0))
+	{
+		Stats_Increment(shard_operation->Throughput_Histogram[Stats_Histogram_Index(
+					(unsigned long long)(((double)byte_count)/elapsed_time))],1);
+	}
+}
+
+/**
+ * Record that the library re-issued part or all of an operation, in the calling thread's statistics shard.
+ * @param operation Which operation was retried, one of GCP_CLIENT_STATS_OPERATION_*. Out of range operations
+ *        are ignored.
+ * @see #Stats_Get_Thread_Shard
+ * @see #Stats_Increment
+ */
+void GCP_Client_Stats_Record_Retry(int operation)
+{
+	struct Stats_Shard_Struct *shard = NULL;
+
+	if((operation < 0)||(operation >= GCP_CLIENT_STATS_OPERATION_COUNT))
+		return;
+	shard = Stats_Get_Thread_Shard();
+	if(shard == NULL)
+		return;
+	Stats_Increment(shard->Operation_List[operation].Retry_Count,1);
+}
+
+/**
+ * Return the value at the specified percentile of a histogram, as returned in a GCP_Client_Stats_Operation_Struct.
+ * The highest value that falls into the same bucket as the percentile is returned.
+ * @param histogram The histogram, an array of GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT counts.
+ * @param percentile The percentile to return, between 0.0 and 100.0.
+ * @return The value at the percentile, or 0 if the histogram is empty or NULL.
+ * @see #Stats_Histogram_Value
+ * @see gcp_client_stats.html#GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT
+ */
+unsigned long long GCP_Client_Stats_Histogram_Percentile(const unsigned long long *histogram,double percentile)
+{
+	unsigned long long total_count,target_count,cumulative_count;
+	int i;
+
+	if(histogram == NULL)
+		return 0;
+	total_count = 0;
+	for(i = 0; i < GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT; i++)
+		total_count += histogram[i];
+	if(total_count == 0)
+		return 0;
+	if(percentile < 0.0)
+		percentile = 0.0;
+	if(percentile > 100.0)
+		percentile = 100.0;
+	target_count = (unsigned long long)((percentile*((double)total_count)/100.0)+0.5);
+	if(target_count < 1)
+		target_count = 1;
+	cumulative_count = 0;
+	for(i = 0; i < GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT; i++)
+	{
+		cumulative_count += histogram[i];
+		if(cumulative_count >= target_count)
+			return Stats_Histogram_Value(i);
+	}
+	return Stats_Histogram_Value(GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT-1);
+}
+
+/**
+ * Return the name of an operation, suitable for printing.
+ * @param operation The operation, one of GCP_CLIENT_STATS_OPERATION_*.
+ * @return A string containing the operation name, or "unknown" if operation is out of range.
+ * @see #Stats_Operation_Name_List
+ */
+const char *GCP_Client_Stats_Operation_Name(int operation)
+{
+	if((operation < 0)||(operation >= GCP_CLIENT_STATS_OPERATION_COUNT))
+		return "unknown";
+	return Stats_Operation_Name_List[operation];
+}
+
+/**
+ * Routine to return the current value of the error number.
+ * @return The value of Stats_Error_Number.
+ * @see #Stats_Error_Number
+ */
+int GCP_Client_Stats_Get_Error_Number(void)
+{
+	return Stats_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Stats_Error_Number
+ * @see #Stats_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Stats_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Stats_Error_Number == 0)
+		sprintf(Stats_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Stats:Error(%d) : %s\n",time_string,
+		Stats_Error_Number,Stats_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Stats_Error_Number
+ * @see #Stats_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Stats_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Stats_Error_Number == 0)
+		sprintf(Stats_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Stats:Error(%d) : %s\n",time_string,
+		Stats_Error_Number,Stats_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Get the calling thread's statistics shard. The first time a thread calls this, it claims a shard
+ * no longer in use by an exited thread, or if there are none, allocates a new one and pushes it onto
+ * Stats_Shard_List.
+ * @return The calling thread's shard, or NULL if a new shard could not be allocated.
+ * @see #Stats_Thread_Shard
+ * @see #Stats_Shard_List
+ */
+static struct Stats_Shard_Struct *Stats_Get_Thread_Shard(void)
+{
+	struct Stats_Shard_Struct *shard = NULL;
+	int in_use;
+
+	if(Stats_Thread_Shard.Shard != NULL)
+		return Stats_Thread_Shard.Shard;
+	/* try to reuse a shard released by an exited thread */
+	for(shard = Stats_Shard_List.load(std::memory_order_acquire); shard != NULL; shard = shard->Next)
+	{
+		in_use = FALSE;
+		if(shard->In_Use.compare_exchange_strong(in_use,TRUE,std::memory_order_acquire))
+		{
+			Stats_Thread_Shard.Shard = shard;
+			return shard;
+		}
+	}
+	/* value-initialisation zeroes the counters */
+	shard = new (std::nothrow) struct Stats_Shard_Struct();
+	if(shard == NULL)
+		return NULL;
+	shard->In_Use.store(TRUE,std::memory_order_relaxed);
+	shard->Next = Stats_Shard_List.load(std::memory_order_relaxed);
+	while(!Stats_Shard_List.compare_exchange_weak(shard->Next,shard,std::memory_order_release,
+						       std::memory_order_relaxed))
+		;
+	Stats_Thread_Shard.Shard = shard;
+	return shard;
+}
+
+/**
+ * Sum all the statistics shards into stats. Shard maximum latencies set before the last reset are ignored.
+ * @param stats The address of a GCP_Client_Stats_Struct to fill in.
+ * @see #Stats_Shard_List
+ * @see #Stats_Reset_Generation
+ */
+static void Stats_Sum_Shards(struct GCP_Client_Stats_Struct *stats)
+{
+	struct Stats_Shard_Struct *shard = NULL;
+	struct Stats_Shard_Operation_Struct *shard_operation = NULL;
+	struct GCP_Client_Stats_Operation_Struct *operation = NULL;
+	unsigned long long max_latency_us;
+	unsigned int generation;
+	int i,j;
+
+	memset(stats,0,sizeof(struct GCP_Client_Stats_Struct));
+	generation = Stats_Reset_Generation.load(std::memory_order_relaxed);
+	for(shard = Stats_Shard_List.load(std::memory_order_acquire); shard != NULL; shard = shard->Next)
+	{
+		for(i = 0; i < GCP_CLIENT_STATS_OPERATION_COUNT; i++)
+		{
+			shard_operation = &(shard->Operation_List[i]);
+			operation = &(stats->Operation_List[i]);
+			operation->Count += shard_operation->Count.load(std::memory_order_relaxed);
+			operation->Error_Count += shard_operation->Error_Count.load(std::memory_order_relaxed);
+			operation->Retry_Count += shard_operation->Retry_Count.load(std::memory_order_relaxed);
+			operation->Byte_Count += shard_operation->Byte_Count.load(std::memory_order_relaxed);
+			operation->Total_Latency_US += shard_operation->Total_Latency_US.load(std::memory_order_relaxed);
+			max_latency_us = shard_operation->Max_Latency_US.load(std::memory_order_relaxed);
+			if((shard_operation->Max_Latency_Generation.load(std::memory_order_relaxed) == generation)&&
+			   (max_latency_us > operation->Max_Latency_US))
+				operation->Max_Latency_US = max_latency_us;
+			for(j = 0; j < GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT; j++)
+			{
+				operation->Latency_Histogram[j] +=
+					shard_operation->Latency_Histogram[j].load(std::memory_order_relaxed);
+				operation->Throughput_Histogram[j] +=
+					shard_operation->Throughput_Histogram[j].load(std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+/**
+ * Return the histogram bucket index a value is counted in. Values below STATS_SUB_BUCKET_COUNT have their own
+ * bucket. Above that, the position of the most significant bit selects a power of two range, and the next
+ * GCP_CLIENT_STATS_HISTOGRAM_SUB_BUCKET_BITS bits select the sub-bucket within it.
+ * @param value The value to find the bucket for.
+ * @return The bucket index, between 0 and GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT-1.
+ * @see #STATS_SUB_BUCKET_COUNT
+ * @see gcp_client_stats.html#GCP_CLIENT_STATS_HISTOGRAM_SUB_BUCKET_BITS
+ * @see gcp_client_stats.html#GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT
+ */
+static int Stats_Histogram_Index(unsigned long long value)
+{
+	int msb,shift,index;
+
+	if(value < STATS_SUB_BUCKET_COUNT)
+		return (int)value;
+	msb = 63-__builtin_clzll(value);
+	shift = msb-GCP_CLIENT_STATS_HISTOGRAM_SUB_BUCKET_BITS;
+	index = STATS_SUB_BUCKET_COUNT+(shift*STATS_SUB_BUCKET_COUNT)+
+		(int)((value >> shift) & (STATS_SUB_BUCKET_COUNT-1));
+	if(index >= GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT)
+		index = GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT-1;
+	return index;
+}
+
+/**
+ * Return the highest value counted in the specified histogram bucket. This is the inverse of
+ * Stats_Histogram_Index.
+ * @param index The bucket index.
+ * @return The highest value that would be counted in that bucket.
+ * @see #Stats_Histogram_Index
+ * @see #STATS_SUB_BUCKET_COUNT
+ */
+static unsigned long long Stats_Histogram_Value(int index)
+{
+	unsigned long long lower_value;
+	int shift,sub_bucket;
+
+	if(index < STATS_SUB_BUCKET_COUNT)
+		return (unsigned long long)index;
+	shift = (index-STATS_SUB_BUCKET_COUNT)/STATS_SUB_BUCKET_COUNT;
+	sub_bucket = (index-STATS_SUB_BUCKET_COUNT)%STATS_SUB_BUCKET_COUNT;
+	lower_value = ((unsigned long long)(STATS_SUB_BUCKET_COUNT+sub_bucket)) << shift;
+	return lower_value+(1ULL << shift)-1;
+}
+
+/**
+ * Increment a shard counter. Only the thread that owns the shard writes it's counters, so a relaxed load and
+ * store is sufficient (and cheaper than a locked fetch_add), while still allowing other threads to read it.
+ * @param counter The counter to increment.
+ * @param value The amount to increment it by.
+ */
+static inline void Stats_Increment(std::atomic<unsigned long long> &counter,unsigned long long value)
+{
+	counter.store(counter.load(std::memory_order_relaxed)+value,std::memory_order_relaxed);
+}
@@ -0,0 +1,1482 @@
+/* gcp_client_sync.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Local directory to bucket sync routines.
+*/
+/**
+ * Google Cloud Platform directory sync routines. A local directory tree is mirrored to objects under a prefix in
+ * a bucket, uploading only the files that are new, or differ from their object.
+ * <p>
+ * The local tree is walked one directory at a time, in the same (byte) order the bucket lists objects in,
+ * and the walk is merged with a streaming listing of the prefix. So the only lists held in memory are the
+ * entries of the directories on the current path, however many files the tree holds.
+ * Files are compared with their object by size, and then by the modification time stored in the object's
+ * GCP_CLIENT_SYNC_MTIME_METADATA_KEY custom metadata. Files whose size matches but whose modification time
+ * does not (or is not recorded) are compared by CRC32C checksum, so files that have only been touched are not
+ * uploaded again. When the checksum matches, the object's recorded modification time is patched to the file's,
+ * so the file is not checksummed again by the next sync. Checksums and uploads are done by a bounded number of
+ * transfer threads, fed from a queue by the merge, so one slow file does not hold up the rest. How many of the
+ * threads transfer at once, and the upload chunk length, are chosen by the adaptive controller in
+ * gcp_client_adaptive, from the throughput and round trip times of the uploads that have finished.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include "google/cloud/storage/client.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_adaptive.h"
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_budget.h"
+#include "gcp_client_list.h"
+#include "gcp_client_stats.h"
+#include "gcp_client_sync.h"
+#include "gcp_client_trace.h"
+#include "gcp_client_connection_private.h"
+#include "gcp_client_fits_private.h"
+#include "gcp_client_list_private.h"
+
+/* hash defines */
+/**
+ * The number of files the queue between the merge thread and the transfer threads can hold.
+ */
+#define SYNC_QUEUE_LENGTH                              (256)
+/**
+ * The length of the buffer each transfer thread reads files into, to checksum or upload them.
+ */
+#define SYNC_BUFFER_LENGTH                             (4*1024*1024)
+/**
+ * Internal queue action, used for files whose size matches their object but whose modification time does not.
+ * The transfer thread computes the file's checksum, and uploads it only if it differs (or if it matches, patches
+ * the object's recorded modification time).
+ */
+#define SYNC_QUEUE_ACTION_CHECKSUM                     (-1)
+/**
+ * The CRC32C (Castagnoli) polynomial, bit reversed.
+ */
+#define SYNC_CRC32C_POLYNOMIAL                         (0x82F63B78)
+
+/* data types */
+/**
+ * Data type holding one entry of a local directory.
+ * <dl>
+ * <dt>Name</dt> <dd>The entry name (allocated). Directory names have a '/' appended, so entries sort in the
+ *     same order as the object names they map to.</dd>
+ * <dt>Is_Directory</dt> <dd>A boolean, TRUE if the entry is a directory.</dd>
+ * <dt>Size</dt> <dd>The file size in bytes.</dd>
+ * <dt>Mtime</dt> <dd>The file modification time.</dd>
+ * </dl>
+ */
+struct Sync_Directory_Entry_Struct
+{
+	char *Name;
+	int Is_Directory;
+	unsigned long long Size;
+	time_t Mtime;
+};
+
+/**
+ * Data type holding the sorted entries of a local directory being walked.
+ * <dl>
+ * <dt>Relative_Path</dt> <dd>The path of the directory relative to the sync root, ending in '/'
+ *     (empty for the root itself).</dd>
+ * <dt>Entry_List</dt> <dd>The sorted list of entries.</dd>
+ * <dt>Entry_Count</dt> <dd>The number of entries in Entry_List.</dd>
+ * <dt>Entry_Index</dt> <dd>The index of the next entry to walk.</dd>
+ * </dl>
+ * @see #Sync_Directory_Entry_Struct
+ */
+struct Sync_Directory_Struct
+{
+	char Relative_Path[PATH_MAX];
+	struct Sync_Directory_Entry_Struct *Entry_List;
+	int Entry_Count;
+	int Entry_Index;
+};
+
+/**
+ * Data type holding one file in the transfer queue.
+ * <dl>
+ * <dt>Relative_Name</dt> <dd>The filename relative to the sync root (and the object name relative to the
+ *     prefix).</dd>
+ * <dt>Action</dt> <dd>GCP_CLIENT_SYNC_ACTION_NEW, GCP_CLIENT_SYNC_ACTION_CHANGED or
+ *     SYNC_QUEUE_ACTION_CHECKSUM.</dd>
+ * <dt>Size</dt> <dd>The file size in bytes.</dd>
+ * <dt>Mtime</dt> <dd>The file modification time.</dd>
+ * <dt>Remote_CRC32C</dt> <dd>The remote object's CRC32C checksum, for SYNC_QUEUE_ACTION_CHECKSUM.</dd>
+ * <dt>Remote_Generation</dt> <dd>The remote object's generation, for SYNC_QUEUE_ACTION_CHECKSUM.</dd>
+ * <dt>Patch_Mtime</dt> <dd>A boolean, for SYNC_QUEUE_ACTION_CHECKSUM. TRUE if the remote object's recorded
+ *     modification time differs from (or is missing for) the file's, so it should be patched if the checksum
+ *     matches.</dd>
+ * </dl>
+ * @see #SYNC_QUEUE_ACTION_CHECKSUM
+ */
+struct Sync_Queue_Entry_Struct
+{
+	char Relative_Name[PATH_MAX];
+	int Action;
+	unsigned long long Size;
+	time_t Mtime;
+	unsigned int Remote_CRC32C;
+	long long Remote_Generation;
+	int Patch_Mtime;
+};
+
+/**
+ * Data type holding the state of a sync, shared between the merge thread and the transfer threads.
+ * This consists of the following:
+ * <dl>
+ * <dt>Local_Directory</dt> <dd>The root of the local tree.</dd>
+ * <dt>Bucket_Name</dt> <dd>The bucket to sync to.</dd>
+ * <dt>Prefix</dt> <dd>The prefix prepended to relative filenames to make object names.</dd>
+ * <dt>Flags</dt> <dd>The sync flags (GCP_CLIENT_SYNC_FLAG_DRY_RUN etc).</dd>
+ * <dt>Callback</dt> <dd>The function to call with each file's action, or NULL.</dd>
+ * <dt>User_Data</dt> <dd>The pointer to pass to Callback.</dd>
+ * <dt>Mutex</dt> <dd>A mutex protecting the rest of the structure (and serialising Callback).</dd>
+ * <dt>Not_Empty_Condition</dt> <dd>Signalled when an entry is added to the queue, or the merge finishes.
+ *     Broadcast when a transfer finishes, as another transfer may now start.</dd>
+ * <dt>Not_Full_Condition</dt> <dd>Signalled when an entry is removed from the queue, or Stop is set.</dd>
+ * <dt>Queue</dt> <dd>The circular queue of SYNC_QUEUE_LENGTH files to checksum or upload.</dd>
+ * <dt>Queue_Start</dt> <dd>The index in Queue of the next file.</dd>
+ * <dt>Queue_Count</dt> <dd>The number of files in Queue.</dd>
+ * <dt>Active_Count</dt> <dd>The number of files being checksummed or uploaded.</dd>
+ * <dt>Merge_Done</dt> <dd>A boolean, set when the merge thread has finished adding files.</dd>
+ * <dt>Stop</dt> <dd>A boolean, set to make the merge thread stop (if the transfer threads can't be run).</dd>
+ * <dt>Merge_Success</dt> <dd>A boolean, whether the merge succeeded.</dd>
+ * <dt>Merge_Error_String</dt> <dd>The error string, if the merge failed.</dd>
+ * <dt>Stats</dt> <dd>The results of the sync.</dd>
+ * <dt>Error_Number</dt> <dd>The Sync_Error_Number of the first failed file.</dd>
+ * <dt>Error_String</dt> <dd>The Sync_Error_String of the first failed file.</dd>
+ * </dl>
+ * @see #SYNC_QUEUE_LENGTH
+ * @see #Sync_Queue_Entry_Struct
+ */
+struct Sync_Struct
+{
+	char *Local_Directory;
+	char *Bucket_Name;
+	char *Prefix;
+	int Flags;
+	GCP_Client_Sync_Callback_T Callback;
+	void *User_Data;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Not_Empty_Condition;
+	pthread_cond_t Not_Full_Condition;
+	struct Sync_Queue_Entry_Struct *Queue;
+	int Queue_Start;
+	int Queue_Count;
+	int Active_Count;
+	int Merge_Done;
+	int Stop;
+	int Merge_Success;
+	char Merge_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+	struct GCP_Client_Sync_Stats_Struct Stats;
+	int Error_Number;
+	char Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/**
+ * Variable holding error code of last operation performed. This is per-thread, as syncs transfer
+ * from several threads at once.
+ */
+static thread_local int Sync_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured. This is per-thread.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static thread_local char Sync_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+/**
+ * Slicing-by-8 CRC32C lookup tables, initialised once by Sync_CRC32C_Table_Initialise.
+ * @see #Sync_CRC32C_Table_Initialise
+ */
+static unsigned int Sync_CRC32C_Table[8][256];
+/**
+ * Once control making sure Sync_CRC32C_Table is only initialised once.
+ * @see #Sync_CRC32C_Table
+ * @see gcp_client_bandwidth.html#GCP_Client_Bandwidth_Acquire
+ */
+static pthread_once_t Sync_CRC32C_Table_Once = PTHREAD_ONCE_INIT;
+
+/* internal functions */
+static void *Sync_Merge_Thread(void *user_data);
+static int Sync_Merge(struct Sync_Struct *sync);
+static int Sync_Merge_Add(struct Sync_Struct *sync,struct Sync_Directory_Struct *directory,
+			  struct Sync_Directory_Entry_Struct *entry,int action,unsigned int remote_crc32c,
+			  long long remote_generation,int patch_mtime);
+static void Sync_Callback(struct Sync_Struct *sync,const char *relative_name,int action,unsigned long long size,
+			  int is_local);
+static void Sync_Transfer_Worker(int index,void *user_data);
+static void Sync_Transfer_Entry(struct Sync_Struct *sync,struct Sync_Queue_Entry_Struct *entry,char *buffer,
+				int reserved);
+static void Sync_Transfer_Failed(struct Sync_Struct *sync,const char *relative_name,unsigned long long size);
+static int Sync_Upload(char *bucket_name,char *local_filename,char *object_name,unsigned long long size,
+		       time_t mtime,char *buffer);
+static int Sync_Patch_Mtime(char *bucket_name,char *object_name,long long generation,time_t mtime);
+static int Sync_Local_Next(char *local_directory,struct Sync_Directory_Struct **directory_stack,
+			   int *directory_count,int *directory_stack_length,struct Sync_Directory_Struct **directory,
+			   struct Sync_Directory_Entry_Struct **entry);
+static int Sync_Directory_Read(char *local_directory,char *relative_path,struct Sync_Directory_Struct *directory);
+static void Sync_Directory_Free(struct Sync_Directory_Struct *directory);
+static int Sync_Directory_Entry_Compare(const void *p1,const void *p2);
+static int Sync_File_CRC32C(char *filename,char *buffer,size_t buffer_length,unsigned int *crc32c);
+static void Sync_CRC32C_Table_Initialise(void);
+static unsigned int Sync_CRC32C_Extend(unsigned int crc,const unsigned char *data,size_t length);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Routine to sync a local directory tree to a bucket. Every regular file under local_directory is compared with
+ * the object named prefix followed by the file's path relative to local_directory, and uploaded if there is no
+ * such object, or it differs. Objects under the prefix with no local file are reported, but not deleted.
+ * The merge of the local tree and the bucket listing runs on it's own thread, while up to concurrency
+ * transfer threads checksum and upload the files it finds need it. How many of them transfer at once is set by
+ * the adaptive controller's upload parallelism (GCP_Client_Adaptive_Set_Limits), up to concurrency.
+ * @param local_directory The root of the local directory tree to sync.
+ * @param bucket_name The name of the bucket to sync to.
+ * @param prefix The prefix to prepend to relative filenames to make object names, or NULL for none. The prefix
+ *        is used as is, so to sync into a pseudo-directory it should end in '/'.
+ * @param concurrency The maximum number of files checksummed / uploaded at once.
+ *        If 0, GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY is used.
+ * @param flags A bit mask of GCP_CLIENT_SYNC_FLAG_DRY_RUN (report what would be uploaded, without uploading),
+ *        and GCP_CLIENT_SYNC_FLAG_CHECKSUM (compare the checksum of files whose size and modification time
+ *        already match).
+ * @param callback A function called (serially) with the action decided for each file and remote only object,
+ *        which can be used to print the sync plan. Can be NULL.
+ * @param user_data A pointer passed to callback.
+ * @param stats The address of a structure to fill in with the results of the sync. Can be NULL.
+ * @return The routine returns TRUE if every file that needed it was uploaded, and FALSE if one or more files
+ *         failed, or the sync could not be run. If it fails, Sync_Error_Number / Sync_Error_String should
+ *         contain details of the (first) failure.
+ * @see #GCP_CLIENT_SYNC_FLAG_DRY_RUN
+ * @see #GCP_CLIENT_SYNC_FLAG_CHECKSUM
+ * @see #SYNC_QUEUE_LENGTH
+ * @see #Sync_Struct
+ * @see #Sync_Merge_Thread
+ * @see #Sync_Transfer_Worker
+ * @see #Sync_Error_Number
+ * @see #Sync_Error_String
+ * @see gcp_client_batch.html#GCP_Client_Batch_Run
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+int GCP_Client_Sync(char *local_directory,char *bucket_name,char *prefix,int concurrency,int flags,
+		    GCP_Client_Sync_Callback_T callback,void *user_data,struct GCP_Client_Sync_Stats_Struct *stats)
+{
+	struct Sync_Struct sync;
+	struct timespec start_time,end_time,trace_start_time;
+	pthread_t merge_thread;
+	char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH];
+	int retval,batch_retval;
+
+	Sync_Error_Number = 0;
+	if(local_directory == NULL)
+	{
+		Sync_Error_Number = 1;
+		sprintf(Sync_Error_String,"GCP_Client_Sync: local_directory was NULL.");
+		return FALSE;
+	}
+	if(bucket_name == NULL)
+	{
+		Sync_Error_Number = 2;
+		sprintf(Sync_Error_String,"GCP_Client_Sync: bucket_name was NULL.");
+		return FALSE;
+	}
+	if((concurrency < 0)||(concurrency > GCP_CLIENT_BATCH_MAX_CONCURRENCY))
+	{
+		Sync_Error_Number = 3;
+		sprintf(Sync_Error_String,"GCP_Client_Sync: concurrency %d out of range (0..%d).",concurrency,
+			GCP_CLIENT_BATCH_MAX_CONCURRENCY);
+		return FALSE;
+	}
+	if(concurrency == 0)
+		concurrency = GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY;
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SYNC,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Sync(local=%s,bucket=%s,prefix=%s):Started with concurrency %d "
+					     "and flags %#x.",local_directory,bucket_name,(prefix != NULL) ? prefix : "",
+					     concurrency,flags);
+#endif
+	sync.Queue = (struct Sync_Queue_Entry_Struct *)malloc(SYNC_QUEUE_LENGTH*sizeof(struct Sync_Queue_Entry_Struct));
+	if(sync.Queue == NULL)
+	{
+		Sync_Error_Number = 4;
+		sprintf(Sync_Error_String,"GCP_Client_Sync: Failed to allocate queue of %d files.",SYNC_QUEUE_LENGTH);
+		return FALSE;
+	}
+	sync.Local_Directory = local_directory;
+	sync.Bucket_Name = bucket_name;
+	sync.Prefix = (prefix != NULL) ? prefix : (char *)"";
+	sync.Flags = flags;
+	sync.Callback = callback;
+	sync.User_Data = user_data;
+	pthread_mutex_init(&(sync.Mutex),NULL);
+	pthread_cond_init(&(sync.Not_Empty_Condition),NULL);
+	pthread_cond_init(&(sync.Not_Full_Condition),NULL);
+	sync.Queue_Start = 0;
+	sync.Queue_Count = 0;
+	sync.Active_Count = 0;
+	sync.Merge_Done = FALSE;
+	sync.Stop = FALSE;
+	sync.Merge_Success = FALSE;
+	sync.Merge_Error_String[0] = '\0';
+	memset(&(sync.Stats),0,sizeof(struct GCP_Client_Sync_Stats_Struct));
+	sync.Error_Number = 0;
+	sync.Error_String[0] = '\0';
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	retval = pthread_create(&merge_thread,NULL,Sync_Merge_Thread,&sync);
+	if(retval != 0)
+	{
+		pthread_cond_destroy(&(sync.Not_Full_Condition));
+		pthread_cond_destroy(&(sync.Not_Empty_Condition));
+		pthread_mutex_destroy(&(sync.Mutex));
+		free(sync.Queue);
+		Sync_Error_Number = 5;
+		sprintf(Sync_Error_String,"GCP_Client_Sync: Failed to create merge thread (%d).",retval);
+		GCP_Client_Trace_Span_End("sync",bucket_name,sync.Prefix,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	/* each batch item is a transfer thread, which processes files from the queue until the merge is done */
+	batch_retval = GCP_Client_Batch_Run(concurrency,concurrency,Sync_Transfer_Worker,&sync);
+	if(batch_retval == FALSE)
+	{
+		error_string[0] = '\0';
+		GCP_Client_Batch_Error_String(error_string);
+		/* stop the merge thread, it may be waiting for the (full) queue to empty */
+		pthread_mutex_lock(&(sync.Mutex));
+		sync.Stop = TRUE;
+		pthread_cond_broadcast(&(sync.Not_Full_Condition));
+		pthread_mutex_unlock(&(sync.Mutex));
+	}
+	pthread_join(merge_thread,NULL);
+	pthread_cond_destroy(&(sync.Not_Full_Condition));
+	pthread_cond_destroy(&(sync.Not_Empty_Condition));
+	pthread_mutex_destroy(&(sync.Mutex));
+	free(sync.Queue);
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	sync.Stats.Elapsed_Time = fdifftime(end_time,start_time);
+	if(stats != NULL)
+		(*stats) = sync.Stats;
+	GCP_Client_Trace_Span_End("sync",bucket_name,sync.Prefix,&trace_start_time,
+				  (flags & GCP_CLIENT_SYNC_FLAG_DRY_RUN) ? 0 : sync.Stats.Transfer_Byte_Count,
+				  batch_retval&&sync.Merge_Success&&(sync.Stats.Failed_Count == 0));
+	if(batch_retval == FALSE)
+	{
+		Sync_Error_Number = 6;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Sync: Failed to run transfer threads:%s",error_string);
+		return FALSE;
+	}
+	if(!sync.Merge_Success)
+	{
+		Sync_Error_Number = 7;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Sync: Failed to compare '%s' with bucket '%s' prefix '%s':%s",local_directory,
+			 bucket_name,sync.Prefix,sync.Merge_Error_String);
+		return FALSE;
+	}
+	if(sync.Stats.Failed_Count > 0)
+	{
+		Sync_Error_Number = 8;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Sync: %llu files failed, the first failure was:Error(%d) : %s",
+			 sync.Stats.Failed_Count,sync.Error_Number,sync.Error_String);
+		return FALSE;
+	}
+#if LOGGING > 1
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SYNC,LOG_VERBOSITY_TERSE,
+					     "GCP_Client_Sync(local=%s,bucket=%s,prefix=%s):Finished %llu files "
+					     "(%llu new, %llu changed, %llu unchanged) in %.3f seconds.",local_directory,
+					     bucket_name,sync.Prefix,sync.Stats.Local_File_Count,sync.Stats.New_Count,
+					     sync.Stats.Changed_Count,sync.Stats.Unchanged_Count,sync.Stats.Elapsed_Time);
+#endif
+	return TRUE;
+}
+
+/**
+ * Routine to compute the CRC32C checksum of a local file, as used by google cloud storage to validate objects.
+ * @param filename The name of the file.
+ * @param crc32c The address of an unsigned int to set to the checksum.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Sync_Error_Number /
+ *         Sync_Error_String should contain details of the failure.
+ * @see #SYNC_BUFFER_LENGTH
+ * @see #Sync_File_CRC32C
+ * @see #Sync_Error_Number
+ * @see #Sync_Error_String
+ */
+int GCP_Client_Sync_File_CRC32C(char *filename,unsigned int *crc32c)
+{
+	char *buffer = NULL;
+	int retval;
+
+	Sync_Error_Number = 0;
+	if(filename == NULL)
+	{
+		Sync_Error_Number = 9;
+		sprintf(Sync_Error_String,"GCP_Client_Sync_File_CRC32C: filename was NULL.");
+		return FALSE;
+	}
+	if(crc32c == NULL)
+	{
+		Sync_Error_Number = 10;
+		sprintf(Sync_Error_String,"GCP_Client_Sync_File_CRC32C: crc32c was NULL.");
+		return FALSE;
+	}
+	buffer = (char *)malloc(SYNC_BUFFER_LENGTH);
+	if(buffer == NULL)
+	{
+		Sync_Error_Number = 11;
+		sprintf(Sync_Error_String,"GCP_Client_Sync_File_CRC32C: Failed to allocate buffer of %d bytes.",
+			SYNC_BUFFER_LENGTH);
+		return FALSE;
+	}
+	retval = Sync_File_CRC32C(filename,buffer,SYNC_BUFFER_LENGTH,crc32c);
+	free(buffer);
+	return retval;
+}
+
+/**
+ * Routine to upload a single local file to an object, streaming it from the file rather than loading it into
+ * memory. The file's modification time is recorded in the object's GCP_CLIENT_SYNC_MTIME_METADATA_KEY custom
+ * metadata, so a later GCP_Client_Sync of the directory sees the object as unchanged. If the file changes size
+ * while it is being uploaded, the upload is abandoned (and the object left as it was). The upload buffer is
+ * reserved from the memory budget, waiting (for the default budget timeout) if it is exhausted.
+ * @param local_filename The local filename.
+ * @param bucket_name The name of the bucket to upload to.
+ * @param object_name The name of the object to create (or replace).
+ * @param byte_count The address of an unsigned long long to set to the number of bytes uploaded. Can be NULL.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Sync_Error_Number /
+ *         Sync_Error_String should contain details of the failure.
+ * @see #SYNC_BUFFER_LENGTH
+ * @see #GCP_CLIENT_SYNC_MTIME_METADATA_KEY
+ * @see #Sync_Upload
+ * @see #Sync_Error_Number
+ * @see #Sync_Error_String
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ */
+int GCP_Client_Sync_Upload_File(char *local_filename,char *bucket_name,char *object_name,
+				unsigned long long *byte_count)
+{
+	struct stat stat_buffer;
+	char *buffer = NULL;
+	int retval;
+
+	Sync_Error_Number = 0;
+	if(byte_count != NULL)
+		(*byte_count) = 0;
+	if(local_filename == NULL)
+	{
+		Sync_Error_Number = 24;
+		sprintf(Sync_Error_String,"GCP_Client_Sync_Upload_File: local_filename was NULL.");
+		return FALSE;
+	}
+	if(bucket_name == NULL)
+	{
+		Sync_Error_Number = 25;
+		sprintf(Sync_Error_String,"GCP_Client_Sync_Upload_File: bucket_name was NULL.");
+		return FALSE;
+	}
+	if(object_name == NULL)
+	{
+		Sync_Error_Number = 26;
+		sprintf(Sync_Error_String,"GCP_Client_Sync_Upload_File: object_name was NULL.");
+		return FALSE;
+	}
+	if(stat(local_filename,&stat_buffer) != 0)
+	{
+		Sync_Error_Number = 27;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Sync_Upload_File: Failed to stat '%s' (%s).",local_filename,strerror(errno));
+		return FALSE;
+	}
+	if(!GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_UPLOAD,SYNC_BUFFER_LENGTH,GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT))
+	{
+		Sync_Error_Number = 30;
+		sprintf(Sync_Error_String,"GCP_Client_Sync_Upload_File: Failed to reserve %d bytes of memory budget.",
+			SYNC_BUFFER_LENGTH);
+		return FALSE;
+	}
+	buffer = (char *)malloc(SYNC_BUFFER_LENGTH);
+	if(buffer == NULL)
+	{
+		GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_UPLOAD,SYNC_BUFFER_LENGTH);
+		Sync_Error_Number = 28;
+		sprintf(Sync_Error_String,"GCP_Client_Sync_Upload_File: Failed to allocate buffer of %d bytes.",
+			SYNC_BUFFER_LENGTH);
+		return FALSE;
+	}
+	retval = Sync_Upload(bucket_name,local_filename,object_name,(unsigned long long)stat_buffer.st_size,
+			     stat_buffer.st_mtime,buffer);
+	free(buffer);
+	GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_UPLOAD,SYNC_BUFFER_LENGTH);
+	if(retval&&(byte_count != NULL))
+		(*byte_count) = (unsigned long long)stat_buffer.st_size;
+	return retval;
+}
+
+/**
+ * Get the current value of the gcp_client_sync error number.
+ * @return The current value of the gcp_client_sync error number.
+ * @see #Sync_Error_Number
+ */
+int GCP_Client_Sync_Get_Error_Number(void)
+{
+	return Sync_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Sync_Error_Number
+ * @see #Sync_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Sync_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Sync_Error_Number == 0)
+		sprintf(Sync_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Sync:Error(%d) : %s\n",time_string,Sync_Error_Number,Sync_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Sync_Error_Number
+ * @see #Sync_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Sync_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Sync_Error_Number == 0)
+		sprintf(Sync_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Sync:Error(%d) : %s\n",time_string,
+		Sync_Error_Number,Sync_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Sync merge thread. Runs the merge (Sync_Merge), saves it's result, sets Merge_Done, and wakes up the
+ * transfer threads.
+ * @param user_data A pointer to the Sync_Struct.
+ * @return The routine returns NULL.
+ * @see #Sync_Struct
+ * @see #Sync_Merge
+ */
+static void *Sync_Merge_Thread(void *user_data)
+{
+	struct Sync_Struct *sync = (struct Sync_Struct *)user_data;
+	int retval;
+
+	retval = Sync_Merge(sync);
+	pthread_mutex_lock(&(sync->Mutex));
+	sync->Merge_Success = retval;
+	if(retval == FALSE)
+	{
+		strncpy(sync->Merge_Error_String,Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1);
+		sync->Merge_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1] = '\0';
+	}
+	sync->Merge_Done = TRUE;
+	pthread_cond_broadcast(&(sync->Not_Empty_Condition));
+	pthread_mutex_unlock(&(sync->Mutex));
+	return NULL;
+}
+
+/**
+ * Merge the walk of the local tree with the listing of the prefix. Both are in byte order of the relative
+ * name, so each step takes whichever comes first (or both, if the names match):
+ * <ul>
+ * <li>A remote object with no local file is reported as GCP_CLIENT_SYNC_ACTION_REMOTE_ONLY.
+ * <li>A local file with no remote object is reported (and queued for upload) as GCP_CLIENT_SYNC_ACTION_NEW.
+ * <li>A local file whose size differs from it's object is reported (and queued for upload) as
+ *     GCP_CLIENT_SYNC_ACTION_CHANGED.
+ * <li>A local file whose size and modification time match it's object's is reported as
+ *     GCP_CLIENT_SYNC_ACTION_UNCHANGED, unless GCP_CLIENT_SYNC_FLAG_CHECKSUM is set.
+ * <li>Otherwise the file is queued for a checksum comparison (SYNC_QUEUE_ACTION_CHECKSUM), with the object's
+ *     generation, and whether it's recorded modification time needs patching if the checksum matches.
+ * </ul>
+ * @param sync The sync state.
+ * @return The routine returns TRUE on success, and FALSE on failure (Sync_Error_Number / Sync_Error_String
+ *         are set), or if Stop was set.
+ * @see #Sync_Struct
+ * @see #Sync_Local_Next
+ * @see #Sync_Merge_Add
+ * @see #Sync_Callback
+ * @see #Sync_Directory_Free
+ * @see #GCP_CLIENT_SYNC_MTIME_METADATA_KEY
+ * @see #SYNC_QUEUE_ACTION_CHECKSUM
+ * @see gcp_client_list.html#GCP_Client_List_Metadata_Copy
+ */
+static int Sync_Merge(struct Sync_Struct *sync)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	struct GCP_Client_Object_Metadata_Struct remote_metadata;
+	struct Sync_Directory_Struct *directory_stack = NULL;
+	struct Sync_Directory_Struct *directory = NULL;
+	struct Sync_Directory_Entry_Struct *entry = NULL;
+	char local_name[PATH_MAX];
+	const char *remote_name = NULL;
+	size_t prefix_length;
+	long long remote_mtime;
+	int directory_count,directory_stack_length,retval,have_remote,have_remote_mtime,compare,i;
+
+	prefix_length = strlen(sync->Prefix);
+	directory_count = 0;
+	directory_stack_length = 0;
+	/* start walking the local tree */
+	if(!Sync_Local_Next(sync->Local_Directory,&directory_stack,&directory_count,&directory_stack_length,
+			    &directory,&entry))
+	{
+		for(i = 0; i < directory_count; i++)
+			Sync_Directory_Free(&(directory_stack[i]));
+		if(directory_stack != NULL)
+			free(directory_stack);
+		return FALSE;
+	}
+	/* start listing the prefix */
+	client = GCP_Client_Connection_Get_Client();
+	auto reader = client.ListObjects(sync->Bucket_Name,gcs::Prefix(sync->Prefix));
+	auto remote_iterator = reader.begin();
+	remote_mtime = 0;
+	have_remote_mtime = FALSE;
+	have_remote = FALSE;
+	retval = TRUE;
+	while(retval)
+	{
+		/* get the next remote object, if we need one */
+		while((have_remote == FALSE)&&(remote_iterator != reader.end()))
+		{
+			auto &object_metadata = *remote_iterator;
+			if(!object_metadata)
+			{
+				Sync_Error_Number = 12;
+				snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+					 "Sync_Merge: Failed to list bucket '%s' prefix '%s' with status '%s'.",
+					 sync->Bucket_Name,sync->Prefix,object_metadata.status().message().c_str());
+				retval = FALSE;
+				break;
+			}
+			GCP_Client_List_Metadata_Copy(*object_metadata,&remote_metadata);
+			have_remote_mtime = object_metadata->has_metadata(GCP_CLIENT_SYNC_MTIME_METADATA_KEY);
+			if(have_remote_mtime)
+			{
+				remote_mtime = strtoll(object_metadata->metadata(GCP_CLIENT_SYNC_MTIME_METADATA_KEY).c_str(),
+						       NULL,10);
+			}
+			++remote_iterator;
+			/* the prefix itself (a directory placeholder) has no local file */
+			if(strlen(remote_metadata.Name) > prefix_length)
+			{
+				remote_name = remote_metadata.Name+prefix_length;
+				have_remote = TRUE;
+				pthread_mutex_lock(&(sync->Mutex));
+				sync->Stats.Remote_Object_Count++;
+				pthread_mutex_unlock(&(sync->Mutex));
+			}
+		}
+		if(retval == FALSE)
+			break;
+		if((entry == NULL)&&(have_remote == FALSE))
+			break;
+		if(entry != NULL)
+		{
+			snprintf(local_name,PATH_MAX,"%s%s",directory->Relative_Path,entry->Name);
+			if(have_remote)
+				compare = strcmp(local_name,remote_name);
+			else
+				compare = -1;
+		}
+		else
+			compare = 1;
+		if(compare > 0)
+		{
+			Sync_Callback(sync,remote_name,GCP_CLIENT_SYNC_ACTION_REMOTE_ONLY,remote_metadata.Size,FALSE);
+			have_remote = FALSE;
+			continue;
+		}
+		pthread_mutex_lock(&(sync->Mutex));
+		sync->Stats.Local_File_Count++;
+		pthread_mutex_unlock(&(sync->Mutex));
+		if(compare < 0)
+			retval = Sync_Merge_Add(sync,directory,entry,GCP_CLIENT_SYNC_ACTION_NEW,0,0,FALSE);
+		else if(entry->Size != remote_metadata.Size)
+			retval = Sync_Merge_Add(sync,directory,entry,GCP_CLIENT_SYNC_ACTION_CHANGED,0,0,FALSE);
+		else if(have_remote_mtime&&(remote_mtime == (long long)(entry->Mtime))&&
+			((sync->Flags & GCP_CLIENT_SYNC_FLAG_CHECKSUM) == 0))
+		{
+			Sync_Callback(sync,local_name,GCP_CLIENT_SYNC_ACTION_UNCHANGED,entry->Size,TRUE);
+		}
+		else
+		{
+			retval = Sync_Merge_Add(sync,directory,entry,SYNC_QUEUE_ACTION_CHECKSUM,
+						remote_metadata.CRC32C,remote_metadata.Generation,
+						(have_remote_mtime == FALSE)||(remote_mtime != (long long)(entry->Mtime)));
+		}
+		if(compare == 0)
+			have_remote = FALSE;
+		if(retval)
+		{
+			retval = Sync_Local_Next(sync->Local_Directory,&directory_stack,&directory_count,
+						 &directory_stack_length,&directory,&entry);
+		}
+	}
+	for(i = 0; i < directory_count; i++)
+		Sync_Directory_Free(&(directory_stack[i]));
+	if(directory_stack != NULL)
+		free(directory_stack);
+	return retval;
+}
+
+/**
+ * Count a local file, report it's action (unless it needs a checksum comparison first), and add it to the
+ * transfer queue, waiting for space if the queue is full. New and changed files are not queued on a dry run.
+ * @param sync The sync state.
+ * @param directory The directory containing the file.
+ * @param entry The file's directory entry.
+ * @param action GCP_CLIENT_SYNC_ACTION_NEW, GCP_CLIENT_SYNC_ACTION_CHANGED or SYNC_QUEUE_ACTION_CHECKSUM.
+ * @param remote_crc32c The remote object's checksum, for SYNC_QUEUE_ACTION_CHECKSUM.
+ * @param remote_generation The remote object's generation, for SYNC_QUEUE_ACTION_CHECKSUM.
+ * @param patch_mtime Whether the remote object's recorded modification time should be patched if the checksum
+ *        matches, for SYNC_QUEUE_ACTION_CHECKSUM.
+ * @return The routine returns TRUE on success, and FALSE if Stop has been set.
+ * @see #SYNC_QUEUE_LENGTH
+ * @see #SYNC_QUEUE_ACTION_CHECKSUM
+ * @see #Sync_Struct
+ * @see #Sync_Callback
+ */
+static int Sync_Merge_Add(struct Sync_Struct *sync,struct Sync_Directory_Struct *directory,
+			  struct Sync_Directory_Entry_Struct *entry,int action,unsigned int remote_crc32c,
+			  long long remote_generation,int patch_mtime)
+{
+	struct Sync_Queue_Entry_Struct *queue_entry = NULL;
+	char relative_name[PATH_MAX];
+
+	snprintf(relative_name,PATH_MAX,"%s%s",directory->Relative_Path,entry->Name);
+	if(action != SYNC_QUEUE_ACTION_CHECKSUM)
+	{
+		Sync_Callback(sync,relative_name,action,entry->Size,TRUE);
+		if(sync->Flags & GCP_CLIENT_SYNC_FLAG_DRY_RUN)
+			return TRUE;
+	}
+	pthread_mutex_lock(&(sync->Mutex));
+	while((sync->Queue_Count == SYNC_QUEUE_LENGTH)&&(sync->Stop == FALSE))
+		pthread_cond_wait(&(sync->Not_Full_Condition),&(sync->Mutex));
+	if(sync->Stop)
+	{
+		pthread_mutex_unlock(&(sync->Mutex));
+		Sync_Error_Number = 13;
+		sprintf(Sync_Error_String,"Sync_Merge_Add: Sync stopped.");
+		return FALSE;
+	}
+	queue_entry = &(sync->Queue[(sync->Queue_Start+sync->Queue_Count)%SYNC_QUEUE_LENGTH]);
+	strcpy(queue_entry->Relative_Name,relative_name);
+	queue_entry->Action = action;
+	queue_entry->Size = entry->Size;
+	queue_entry->Mtime = entry->Mtime;
+	queue_entry->Remote_CRC32C = remote_crc32c;
+	queue_entry->Remote_Generation = remote_generation;
+	queue_entry->Patch_Mtime = patch_mtime;
+	sync->Queue_Count++;
+	pthread_cond_signal(&(sync->Not_Empty_Condition));
+	pthread_mutex_unlock(&(sync->Mutex));
+	return TRUE;
+}
+
+/**
+ * Count a file's action in the sync statistics, and report it to the sync callback (if any).
+ * The sync mutex is held while doing so, so callbacks are serialised.
+ * @param sync The sync state.
+ * @param relative_name The relative filename / object name.
+ * @param action The action (GCP_CLIENT_SYNC_ACTION_NEW etc).
+ * @param size The size of the file or object.
+ * @param is_local A boolean, TRUE if there is a local file.
+ * @see #Sync_Struct
+ */
+static void Sync_Callback(struct Sync_Struct *sync,const char *relative_name,int action,unsigned long long size,
+			  int is_local)
+{
+	char local_filename[PATH_MAX];
+	char object_name[PATH_MAX];
+
+	pthread_mutex_lock(&(sync->Mutex));
+	switch(action)
+	{
+		case GCP_CLIENT_SYNC_ACTION_UNCHANGED:
+			sync->Stats.Unchanged_Count++;
+			break;
+		case GCP_CLIENT_SYNC_ACTION_NEW:
+			sync->Stats.New_Count++;
+			sync->Stats.Transfer_Byte_Count += size;
+			break;
+		case GCP_CLIENT_SYNC_ACTION_CHANGED:
+			sync->Stats.Changed_Count++;
+			sync->Stats.Transfer_Byte_Count += size;
+			break;
+		case GCP_CLIENT_SYNC_ACTION_REMOTE_ONLY:
+			sync->Stats.Remote_Only_Count++;
+			break;
+		case GCP_CLIENT_SYNC_ACTION_FAILED:
+			sync->Stats.Failed_Count++;
+			break;
+	}
+	if(sync->Callback != NULL)
+	{
+		snprintf(local_filename,PATH_MAX,"%s/%s",sync->Local_Directory,relative_name);
+		snprintf(object_name,PATH_MAX,"%s%s",sync->Prefix,relative_name);
+		sync->Callback(is_local ? local_filename : NULL,object_name,action,size,sync->User_Data);
+	}
+	pthread_mutex_unlock(&(sync->Mutex));
+}
+
+/**
+ * Sync transfer thread, run as a batch item. Takes files off the queue until it is empty and the merge is done.
+ * A file is only taken whilst fewer files are being transferred than the adaptive controller's upload
+ * parallelism, so the number of transfers in progress follows the controller (up to the number of threads).
+ * @param index The index of the transfer thread (unused).
+ * @param user_data A pointer to the Sync_Struct.
+ * @see #SYNC_BUFFER_LENGTH
+ * @see #Sync_Struct
+ * @see #Sync_Transfer_Entry
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get
+ * @see gcp_client_budget.html#GCP_Client_Budget_Reserve
+ * @see gcp_client_budget.html#GCP_Client_Budget_Release
+ */
+static void Sync_Transfer_Worker(int index,void *user_data)
+{
+	struct Sync_Struct *sync = (struct Sync_Struct *)user_data;
+	struct Sync_Queue_Entry_Struct entry;
+	char *buffer = NULL;
+	int reserved,parallelism,done;
+
+	(void)index;
+	/* the transfer buffer is charged to the memory budget, so with a budget set fewer transfers may run at once */
+	reserved = GCP_Client_Budget_Reserve(GCP_CLIENT_BUDGET_USE_UPLOAD,SYNC_BUFFER_LENGTH,
+					     GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT);
+	if(reserved)
+		buffer = (char *)malloc(SYNC_BUFFER_LENGTH);
+	done = FALSE;
+	while(done == FALSE)
+	{
+		pthread_mutex_lock(&(sync->Mutex));
+		while(TRUE)
+		{
+			if((sync->Queue_Count == 0)&&sync->Merge_Done)
+			{
+				done = TRUE;
+				break;
+			}
+			if(sync->Queue_Count > 0)
+			{
+				GCP_Client_Adaptive_Get(GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD,NULL,&parallelism);
+				if(sync->Active_Count < parallelism)
+					break;
+			}
+			pthread_cond_wait(&(sync->Not_Empty_Condition),&(sync->Mutex));
+		}
+		if(done)
+		{
+			pthread_mutex_unlock(&(sync->Mutex));
+			break;
+		}
+		entry = sync->Queue[sync->Queue_Start];
+		sync->Queue_Start = (sync->Queue_Start+1)%SYNC_QUEUE_LENGTH;
+		sync->Queue_Count--;
+		sync->Active_Count++;
+		pthread_cond_signal(&(sync->Not_Full_Condition));
+		pthread_mutex_unlock(&(sync->Mutex));
+		Sync_Transfer_Entry(sync,&entry,buffer,reserved);
+		pthread_mutex_lock(&(sync->Mutex));
+		sync->Active_Count--;
+		pthread_cond_broadcast(&(sync->Not_Empty_Condition));
+		pthread_mutex_unlock(&(sync->Mutex));
+	}
+	if(buffer != NULL)
+		free(buffer);
+	if(reserved)
+		GCP_Client_Budget_Release(GCP_CLIENT_BUDGET_USE_UPLOAD,SYNC_BUFFER_LENGTH);
+}
+
+/**
+ * Transfer one file taken off the queue. Files queued for a checksum comparison are checksummed, and reported as
+ * unchanged if the checksum matches the remote object's, or changed (and uploaded) if not. When an unchanged
+ * file's modification time differs from the one recorded in it's object, the object's is patched (unless this is
+ * a dry run), so the next sync does not checksum the file again. A failed patch is logged, but the file is
+ * still reported as unchanged. New and changed files are uploaded, unless this is a dry run.
+ * @param sync The sync state.
+ * @param entry The queue entry of the file.
+ * @param buffer The transfer thread's buffer of SYNC_BUFFER_LENGTH bytes, or NULL if it could not be allocated
+ *        (or reserved).
+ * @param reserved Whether the transfer thread reserved it's buffer from the memory budget.
+ * @see #SYNC_BUFFER_LENGTH
+ * @see #SYNC_QUEUE_ACTION_CHECKSUM
+ * @see #Sync_Struct
+ * @see #Sync_File_CRC32C
+ * @see #Sync_Upload
+ * @see #Sync_Patch_Mtime
+ * @see #Sync_Callback
+ * @see #Sync_Transfer_Failed
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record_Retry
+ */
+static void Sync_Transfer_Entry(struct Sync_Struct *sync,struct Sync_Queue_Entry_Struct *entry,char *buffer,
+				int reserved)
+{
+	char local_filename[PATH_MAX];
+	char object_name[PATH_MAX];
+	unsigned int crc32c;
+
+	if(buffer == NULL)
+	{
+		if(reserved)
+		{
+			Sync_Error_Number = 14;
+			sprintf(Sync_Error_String,"Sync_Transfer_Entry: Failed to allocate buffer of %d bytes.",
+				SYNC_BUFFER_LENGTH);
+		}
+		else
+		{
+			Sync_Error_Number = 29;
+			sprintf(Sync_Error_String,"Sync_Transfer_Entry: Failed to reserve %d bytes of memory budget.",
+				SYNC_BUFFER_LENGTH);
+		}
+		Sync_Transfer_Failed(sync,entry->Relative_Name,entry->Size);
+		return;
+	}
+	snprintf(local_filename,PATH_MAX,"%s/%s",sync->Local_Directory,entry->Relative_Name);
+	snprintf(object_name,PATH_MAX,"%s%s",sync->Prefix,entry->Relative_Name);
+	if(entry->Action == SYNC_QUEUE_ACTION_CHECKSUM)
+	{
+		pthread_mutex_lock(&(sync->Mutex));
+		sync->Stats.Checksum_Count++;
+		pthread_mutex_unlock(&(sync->Mutex));
+		if(!Sync_File_CRC32C(local_filename,buffer,SYNC_BUFFER_LENGTH,&crc32c))
+		{
+			Sync_Transfer_Failed(sync,entry->Relative_Name,entry->Size);
+			return;
+		}
+		if(crc32c == entry->Remote_CRC32C)
+		{
+			/* record the file's modification time, so the next sync doesn't checksum it again */
+			if(entry->Patch_Mtime&&((sync->Flags & GCP_CLIENT_SYNC_FLAG_DRY_RUN) == 0)&&
+			   (!Sync_Patch_Mtime(sync->Bucket_Name,object_name,entry->Remote_Generation,entry->Mtime)))
+			{
+#if LOGGING > 1
+				GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SYNC,LOG_VERBOSITY_TERSE,
+								     "Sync_Transfer_Entry:%s",Sync_Error_String);
+#endif
+			}
+			Sync_Callback(sync,entry->Relative_Name,GCP_CLIENT_SYNC_ACTION_UNCHANGED,entry->Size,TRUE);
+			return;
+		}
+		Sync_Callback(sync,entry->Relative_Name,GCP_CLIENT_SYNC_ACTION_CHANGED,entry->Size,TRUE);
+		if(sync->Flags & GCP_CLIENT_SYNC_FLAG_DRY_RUN)
+			return;
+		/* the object's size and time matched, but it's contents didn't, so it is written again */
+		GCP_Client_Stats_Record_Retry(GCP_CLIENT_STATS_OPERATION_WRITE);
+	}
+	if(!Sync_Upload(sync->Bucket_Name,local_filename,object_name,entry->Size,entry->Mtime,buffer))
+		Sync_Transfer_Failed(sync,entry->Relative_Name,entry->Size);
+}
+
+/**
+ * Record that a file failed to be checked or uploaded. The first failure's error is copied out of this thread's
+ * (thread local) error variables into the sync structure, and the failure is reported to the callback.
+ * @param sync The sync state.
+ * @param relative_name The relative filename.
+ * @param size The size of the file.
+ * @see #Sync_Struct
+ * @see #Sync_Callback
+ */
+static void Sync_Transfer_Failed(struct Sync_Struct *sync,const char *relative_name,unsigned long long size)
+{
+	pthread_mutex_lock(&(sync->Mutex));
+	if(sync->Stats.Failed_Count == 0)
+	{
+		sync->Error_Number = Sync_Error_Number;
+		strncpy(sync->Error_String,Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1);
+		sync->Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH-1] = '\0';
+	}
+	pthread_mutex_unlock(&(sync->Mutex));
+	Sync_Callback(sync,relative_name,GCP_CLIENT_SYNC_ACTION_FAILED,size,TRUE);
+}
+
+/**
+ * Upload a local file to an object, streaming it through buffer, and recording it's modification time in the
+ * object's GCP_CLIENT_SYNC_MTIME_METADATA_KEY custom metadata. If the file can't be read in full, the upload
+ * is suspended rather than closed, so a truncated object is not created. The upload is sent in chunks of the
+ * length chosen by the adaptive controller, and a successful upload's throughput and round trip time (the time
+ * taken to open the upload) are recorded with it. If FITS indexing is enabled, the header keywords of a FITS
+ * file are also recorded in the object's custom metadata (from the first buffer read).
+ * @param bucket_name The name of the bucket to upload to.
+ * @param local_filename The local filename.
+ * @param object_name The object name.
+ * @param size The size of the file, when it was walked (or stat'ed).
+ * @param mtime The modification time of the file, when it was walked (or stat'ed).
+ * @param buffer A buffer of SYNC_BUFFER_LENGTH bytes.
+ * @return The routine returns TRUE on success, and FALSE on failure (Sync_Error_Number / Sync_Error_String
+ *         are set).
+ * @see #SYNC_BUFFER_LENGTH
+ * @see #GCP_CLIENT_SYNC_MTIME_METADATA_KEY
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Get
+ * @see gcp_client_adaptive.html#GCP_Client_Adaptive_Record
+ * @see gcp_client_fits.html#GCP_Client_Fits_Index_Metadata
+ * @see gcp_client_stats.html#GCP_Client_Stats_Record
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_Begin
+ * @see gcp_client_trace.html#GCP_Client_Trace_Span_End
+ */
+static int Sync_Upload(char *bucket_name,char *local_filename,char *object_name,unsigned long long size,
+		       time_t mtime,char *buffer)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+	gcs::ObjectMetadata object_metadata;
+	struct timespec start_time,trace_start_time,open_start_time,open_end_time,end_time;
+	unsigned long long byte_count;
+	size_t read_count,chunk_length;
+	FILE *fp = NULL;
+	int read_error;
+
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SYNC,LOG_VERBOSITY_VERY_VERBOSE,
+					     "Sync_Upload:Uploading '%s' (%llu bytes) to '%s'.",local_filename,size,
+					     object_name);
+#endif
+	fp = fopen(local_filename,"rb");
+	if(fp == NULL)
+	{
+		Sync_Error_Number = 15;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "Sync_Upload: Failed to open '%s' (%s).",local_filename,strerror(errno));
+		return FALSE;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	GCP_Client_Trace_Span_Begin(&trace_start_time);
+	client = GCP_Client_Connection_Get_Client();
+	GCP_Client_Adaptive_Get(GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD,&chunk_length,NULL);
+	/* the first chunk is read before the upload is opened, so a FITS header in it can be indexed */
+	read_count = fread(buffer,1,SYNC_BUFFER_LENGTH,fp);
+	object_metadata.upsert_metadata(GCP_CLIENT_SYNC_MTIME_METADATA_KEY,std::to_string((long long)mtime));
+	GCP_Client_Fits_Index_Metadata(buffer,read_count,object_metadata);
+	clock_gettime(CLOCK_MONOTONIC,&open_start_time);
+	auto writer = client.WriteObject(bucket_name,object_name,gcs::WithObjectMetadata(object_metadata),
+				 google::cloud::Options{}.set<gcs::UploadBufferSizeOption>(chunk_length));
+	clock_gettime(CLOCK_MONOTONIC,&open_end_time);
+	byte_count = 0;
+	read_error = FALSE;
+	while(writer)
+	{
+		if(read_count == 0)
+		{
+			read_error = ferror(fp);
+			break;
+		}
+		GCP_Client_Bandwidth_Acquire(GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD,read_count);
+		writer.write(buffer,read_count);
+		byte_count += read_count;
+		read_count = fread(buffer,1,SYNC_BUFFER_LENGTH,fp);
+	}
+	fclose(fp);
+	if(writer&&(read_error||(byte_count != size)))
+	{
+		/* don't finalise the upload, the object would be truncated */
+		std::move(writer).Suspend();
+		Sync_Error_Number = 16;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "Sync_Upload: Failed to read '%s' (read %llu of %llu bytes%s).",local_filename,byte_count,size,
+			 read_error ? ", read error" : "");
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_WRITE,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("sync_upload",bucket_name,object_name,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	writer.Close();
+	auto metadata = std::move(writer).metadata();
+	if(!metadata)
+	{
+		Sync_Error_Number = 17;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "Sync_Upload: Failed to upload '%s' to '%s' in bucket '%s' with status '%s'.",local_filename,
+			 object_name,bucket_name,metadata.status().message().c_str());
+		GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_WRITE,start_time,0,FALSE);
+		GCP_Client_Trace_Span_End("sync_upload",bucket_name,object_name,&trace_start_time,0,FALSE);
+		return FALSE;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	GCP_Client_Adaptive_Record(GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD,byte_count,fdifftime(end_time,open_start_time),
+				   fdifftime(open_end_time,open_start_time));
+	GCP_Client_Stats_Record(GCP_CLIENT_STATS_OPERATION_WRITE,start_time,byte_count,TRUE);
+	GCP_Client_Trace_Span_End("sync_upload",bucket_name,object_name,&trace_start_time,byte_count,TRUE);
+	return TRUE;
+}
+
+/**
+ * Patch the modification time recorded in an object's GCP_CLIENT_SYNC_MTIME_METADATA_KEY custom metadata, after
+ * the file's checksum has been found to match the object's. The patch is conditional on the object still being
+ * the generation that was checksummed, so an object uploaded since is not given the file's modification time.
+ * @param bucket_name The name of the bucket.
+ * @param object_name The object name.
+ * @param generation The generation of the object whose checksum matched.
+ * @param mtime The modification time of the file.
+ * @return The routine returns TRUE on success, and FALSE on failure (Sync_Error_Number / Sync_Error_String
+ *         are set).
+ * @see #GCP_CLIENT_SYNC_MTIME_METADATA_KEY
+ */
+static int Sync_Patch_Mtime(char *bucket_name,char *object_name,long long generation,time_t mtime)
+{
+	namespace gcs = ::google::cloud::storage;
+	gcs::Client client;
+
+#if LOGGING > 5
+	GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_SYNC,LOG_VERBOSITY_VERY_VERBOSE,
+					     "Sync_Patch_Mtime:Patching '%s' generation %lld modification time to %lld.",
+					     object_name,generation,(long long)mtime);
+#endif
+	client = GCP_Client_Connection_Get_Client();
+	auto patch = gcs::ObjectMetadataPatchBuilder().SetMetadata(GCP_CLIENT_SYNC_MTIME_METADATA_KEY,
+								   std::to_string((long long)mtime));
+	auto metadata = client.PatchObject(bucket_name,object_name,patch,gcs::IfGenerationMatch(generation));
+	if(!metadata)
+	{
+		Sync_Error_Number = 31;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "Sync_Patch_Mtime: Failed to patch the modification time of '%s' in bucket '%s' "
+			 "with status '%s'.",object_name,bucket_name,metadata.status().message().c_str());
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Get the next regular file in the walk of the local tree. The walk is depth first, with each directory's
+ * entries sorted so the relative filenames come out in byte order. A stack holds the directories on the
+ * current path. When the walk is first started (directory_count is 0), the root directory is read.
+ * @param local_directory The root of the local tree.
+ * @param directory_stack The address of the (reallocated) directory stack.
+ * @param directory_count The address of the number of directories on the stack.
+ * @param directory_stack_length The address of the allocated length of the directory stack.
+ * @param directory The address of a pointer, set to the directory containing the next file.
+ * @param entry The address of a pointer, set to the next file's entry, or NULL when the walk is finished.
+ * @return The routine returns TRUE on success, and FALSE on failure (Sync_Error_Number / Sync_Error_String
+ *         are set).
+ * @see #Sync_Directory_Struct
+ * @see #Sync_Directory_Read
+ * @see #Sync_Directory_Free
+ */
+static int Sync_Local_Next(char *local_directory,struct Sync_Directory_Struct **directory_stack,
+			   int *directory_count,int *directory_stack_length,struct Sync_Directory_Struct **directory,
+			   struct Sync_Directory_Entry_Struct **entry)
+{
+	struct Sync_Directory_Struct *new_stack = NULL;
+	struct Sync_Directory_Struct *top = NULL;
+	struct Sync_Directory_Entry_Struct *top_entry = NULL;
+	char relative_path[PATH_MAX];
+	int first;
+
+	(*directory) = NULL;
+	(*entry) = NULL;
+	first = ((*directory_count) == 0)&&((*directory_stack_length) == 0);
+	while(TRUE)
+	{
+		if(first)
+		{
+			relative_path[0] = '\0';
+			first = FALSE;
+		}
+		else
+		{
+			if((*directory_count) == 0)
+				return TRUE;
+			top = &((*directory_stack)[(*directory_count)-1]);
+			if(top->Entry_Index >= top->Entry_Count)
+			{
+				Sync_Directory_Free(top);
+				(*directory_count)--;
+				continue;
+			}
+			top_entry = &(top->Entry_List[top->Entry_Index]);
+			top->Entry_Index++;
+			if(top_entry->Is_Directory == FALSE)
+			{
+				(*directory) = top;
+				(*entry) = top_entry;
+				return TRUE;
+			}
+			snprintf(relative_path,PATH_MAX,"%s%s",top->Relative_Path,top_entry->Name);
+		}
+		/* push the directory onto the stack */
+		if((*directory_count) >= (*directory_stack_length))
+		{
+			new_stack = (struct Sync_Directory_Struct *)realloc(*directory_stack,
+					((*directory_stack_length)+16)*sizeof(struct Sync_Directory_Struct));
+			if(new_stack == NULL)
+			{
+				Sync_Error_Number = 18;
+				sprintf(Sync_Error_String,"Sync_Local_Next: Failed to reallocate directory stack (%d).",
+					(*directory_stack_length)+16);
+				return FALSE;
+			}
+			(*directory_stack) = new_stack;
+			(*directory_stack_length) += 16;
+		}
+		if(!Sync_Directory_Read(local_directory,relative_path,&((*directory_stack)[(*directory_count)])))
+			return FALSE;
+		(*directory_count)++;
+	}
+}
+
+/**
+ * Read and sort the entries of a local directory. Regular files (and symbolic links to them) and
+ * directories are kept, symbolic links to directories are not followed (so the walk can't loop),
+ * and anything else is ignored.
+ * @param local_directory The root of the local tree.
+ * @param relative_path The path of the directory relative to local_directory, ending in '/', or empty.
+ * @param directory The directory structure to fill in.
+ * @return The routine returns TRUE on success, and FALSE on failure (Sync_Error_Number / Sync_Error_String
+ *         are set).
+ * @see #Sync_Directory_Struct
+ * @see #Sync_Directory_Entry_Compare
+ * @see #Sync_Directory_Free
+ */
+static int Sync_Directory_Read(char *local_directory,char *relative_path,struct Sync_Directory_Struct *directory)
+{
+	struct Sync_Directory_Entry_Struct *new_list = NULL;
+	struct Sync_Directory_Entry_Struct *entry = NULL;
+	struct dirent *directory_entry = NULL;
+	struct stat status;
+	char path[PATH_MAX];
+	char filename[PATH_MAX];
+	DIR *dir = NULL;
+	int entry_list_length,is_directory;
+
+	strcpy(directory->Relative_Path,relative_path);
+	directory->Entry_List = NULL;
+	directory->Entry_Count = 0;
+	directory->Entry_Index = 0;
+	snprintf(path,PATH_MAX,"%s/%s",local_directory,relative_path);
+	dir = opendir(path);
+	if(dir == NULL)
+	{
+		Sync_Error_Number = 19;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "Sync_Directory_Read: Failed to open directory '%s' (%s).",path,strerror(errno));
+		return FALSE;
+	}
+	entry_list_length = 0;
+	while((directory_entry = readdir(dir)) != NULL)
+	{
+		if((strcmp(directory_entry->d_name,".") == 0)||(strcmp(directory_entry->d_name,"..") == 0))
+			continue;
+		snprintf(filename,PATH_MAX,"%s%s",path,directory_entry->d_name);
+		if(lstat(filename,&status) != 0)
+			continue;
+		if(S_ISLNK(status.st_mode))
+		{
+			if((stat(filename,&status) != 0)||(!S_ISREG(status.st_mode)))
+				continue;
+		}
+		if(S_ISDIR(status.st_mode))
+			is_directory = TRUE;
+		else if(S_ISREG(status.st_mode))
+			is_directory = FALSE;
+		else
+			continue;
+		if(directory->Entry_Count >= entry_list_length)
+		{
+			new_list = (struct Sync_Directory_Entry_Struct *)realloc(directory->Entry_List,
+				  (entry_list_length+1024)*sizeof(struct Sync_Directory_Entry_Struct));
+			if(new_list == NULL)
+			{
+				closedir(dir);
+				Sync_Directory_Free(directory);
+				Sync_Error_Number = 20;
+				sprintf(Sync_Error_String,"Sync_Directory_Read: Failed to reallocate entry list (%d).",
+					entry_list_length+1024);
+				return FALSE;
+			}
+			directory->Entry_List = new_list;
+			entry_list_length += 1024;
+		}
+		entry = &(directory->Entry_List[directory->Entry_Count]);
+		entry->Name = (char *)malloc(strlen(directory_entry->d_name)+2);
+		if(entry->Name == NULL)
+		{
+			closedir(dir);
+			Sync_Directory_Free(directory);
+			Sync_Error_Number = 21;
+			sprintf(Sync_Error_String,"Sync_Directory_Read: Failed to allocate entry name.");
+			return FALSE;
+		}
+		strcpy(entry->Name,directory_entry->d_name);
+		/* directories sort as their object names will, with a trailing '/' */
+		if(is_directory)
+			strcat(entry->Name,"/");
+		entry->Is_Directory = is_directory;
+		entry->Size = status.st_size;
+		entry->Mtime = status.st_mtime;
+		directory->Entry_Count++;
+	}
+	closedir(dir);
+	qsort(directory->Entry_List,directory->Entry_Count,sizeof(struct Sync_Directory_Entry_Struct),
+	      Sync_Directory_Entry_Compare);
+	return TRUE;
+}
+
+/**
+ * Free the entries of a directory.
+ * @param directory The directory.
+ * @see #Sync_Directory_Struct
+ */
+static void Sync_Directory_Free(struct Sync_Directory_Struct *directory)
+{
+	int i;
+
+	for(i = 0; i < directory->Entry_Count; i++)
+		free(directory->Entry_List[i].Name);
+	if(directory->Entry_List != NULL)
+		free(directory->Entry_List);
+	directory->Entry_List = NULL;
+	directory->Entry_Count = 0;
+	directory->Entry_Index = 0;
+}
+
+/**
+ * qsort comparison function, sorting directory entries in byte order of their names.
+ * @param p1 A pointer to the first Sync_Directory_Entry_Struct.
+ * @param p2 A pointer to the second Sync_Directory_Entry_Struct.
+ * @return The strcmp of the entry names.
+ * @see #Sync_Directory_Entry_Struct
+ */
+static int Sync_Directory_Entry_Compare(const void *p1,const void *p2)
+{
+	const struct Sync_Directory_Entry_Struct *entry1 = (const struct Sync_Directory_Entry_Struct *)p1;
+	const struct Sync_Directory_Entry_Struct *entry2 = (const struct Sync_Directory_Entry_Struct *)p2;
+
+	return strcmp(entry1->Name,entry2->Name);
+}
+
+/**
+ * Compute the CRC32C checksum of a file, reading it through the supplied buffer.
+ * @param filename The name of the file.
+ * @param buffer The buffer to read the file into.
+ * @param buffer_length The length of the buffer.
+ * @param crc32c The address of an unsigned int to set to the checksum.
+ * @return The routine returns TRUE on success, and FALSE on failure (Sync_Error_Number / Sync_Error_String
+ *         are set).
+ * @see #Sync_CRC32C_Extend
+ */
+static int Sync_File_CRC32C(char *filename,char *buffer,size_t buffer_length,unsigned int *crc32c)
+{
+	size_t read_count;
+	FILE *fp = NULL;
+
+	fp = fopen(filename,"rb");
+	if(fp == NULL)
+	{
+		Sync_Error_Number = 22;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "Sync_File_CRC32C: Failed to open '%s' (%s).",filename,strerror(errno));
+		return FALSE;
+	}
+	(*crc32c) = 0;
+	while((read_count = fread(buffer,1,buffer_length,fp)) > 0)
+		(*crc32c) = Sync_CRC32C_Extend((*crc32c),(const unsigned char *)buffer,read_count);
+	if(ferror(fp))
+	{
+		fclose(fp);
+		Sync_Error_Number = 23;
+		snprintf(Sync_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "Sync_File_CRC32C: Failed to read '%s'.",filename);
+		return FALSE;
+	}
+	fclose(fp);
+	return TRUE;
+}
+
+/**
+ * Initialise the slicing-by-8 CRC32C lookup tables. Called once, by pthread_once.
+ * @see #Sync_CRC32C_Table
+ * @see #SYNC_CRC32C_POLYNOMIAL
+ */
+static void Sync_CRC32C_Table_Initialise(void)
+{
+	unsigned int crc;
+	int i,j;
+
+	for(i = 0; i < 256; i++)
+	{
+		crc = i;
+		for(j = 0; j < 8; j++)
+			crc = (crc & 1) ? ((crc >> 1) ^ SYNC_CRC32C_POLYNOMIAL) : (crc >> 1);
+		Sync_CRC32C_Table[0][i] = crc;
+	}
+	for(i = 0; i < 256; i++)
+	{
+		for(j = 1; j < 8; j++)
+		{
+			Sync_CRC32C_Table[j][i] = (Sync_CRC32C_Table[j-1][i] >> 8)^
+				Sync_CRC32C_Table[0][Sync_CRC32C_Table[j-1][i] & 0xff];
+		}
+	}
+}
+
+/**
+ * Extend a CRC32C checksum with some more data, 8 bytes at a time (slicing-by-8).
+ * @param crc The checksum of the data so far (0 to start).
+ * @param data The data to add.
+ * @param length The number of bytes of data.
+ * @return The checksum, including the new data.
+ * @see #Sync_CRC32C_Table
+ * @see #Sync_CRC32C_Table_Initialise
+ */
+static unsigned int Sync_CRC32C_Extend(unsigned int crc,const unsigned char *data,size_t length)
+{
+	pthread_once(&Sync_CRC32C_Table_Once,Sync_CRC32C_Table_Initialise);
+	crc = ~crc;
+	while(length >= 8)
+	{
+		crc ^= ((unsigned int)data[0])|(((unsigned int)data[1]) << 8)|(((unsigned int)data[2]) << 16)|
+			(((unsigned int)data[3]) << 24);
+		crc = Sync_CRC32C_Table[7][crc & 0xff]^Sync_CRC32C_Table[6][(crc >> 8) & 0xff]^
+			Sync_CRC32C_Table[5][(crc >> 16) & 0xff]^Sync_CRC32C_Table[4][crc >> 24]^
+			Sync_CRC32C_Table[3][data[4]]^Sync_CRC32C_Table[2][data[5]]^
+			Sync_CRC32C_Table[1][data[6]]^Sync_CRC32C_Table[0][data[7]];
+		data += 8;
+		length -= 8;
+	}
+	while(length > 0)
+	{
+		crc = (crc >> 8)^Sync_CRC32C_Table[0][(crc ^ (*data)) & 0xff];
+		data++;
+		length--;
+	}
+	return ~crc;
+}
@@ -0,0 +1,439 @@
+/* gcp_client_trace.c
+** google cloud platform C wrapper library around google-cloud-cpp c++ library.
+** Per-phase transfer tracing.
+*/
+/**
+ * Optional tracing of the phases of each transfer (getting the client, opening the stream, time to first byte,
+ * streaming, closing, checking metadata). Spans are recorded into a fixed size in-memory ring buffer, slots being
+ * claimed with an atomic increment, and can be dumped in the Chrome trace event JSON format
+ * (load into chrome://tracing or https://ui.perfetto.dev). When tracing is disabled, beginning and ending a span
+ * costs one relaxed atomic load.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <atomic>
+#include <new>
+#include "gcp_client_general.h"
+#include "gcp_client_trace.h"
+
+/* defines */
+/**
+ * The maximum length of the bucket name stored in a span. Longer names are truncated.
+ */
+#define TRACE_BUCKET_NAME_LENGTH       (64)
+/**
+ * The maximum length of the object name stored in a span. Longer names are truncated.
+ */
+#define TRACE_OBJECT_NAME_LENGTH       (128)
+
+/* data types */
+/**
+ * Data type holding one recorded span. This consists of the following:
+ * <dl>
+ * <dt>Sequence</dt> <dd>The span's position in the trace plus one, once the span has been completely written.
+ *     0 (or an out of date position) whilst the slot is being written.</dd>
+ * <dt>Name</dt> <dd>The name of the phase. This must be a string constant, only the pointer is stored.</dd>
+ * <dt>Bucket_Name</dt> <dd>The bucket being accessed.</dd>
+ * <dt>Object_Name</dt> <dd>The object being accessed.</dd>
+ * <dt>Start_Time</dt> <dd>When the phase started (CLOCK_MONOTONIC).</dd>
+ * <dt>End_Time</dt> <dd>When the phase ended (CLOCK_MONOTONIC).</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes transferred in the phase.</dd>
+ * <dt>Success</dt> <dd>Whether the phase succeeded.</dd>
+ * <dt>Thread_Id</dt> <dd>The (kernel) id of the thread the phase ran on.</dd>
+ * </dl>
+ */
+struct Trace_Span_Struct
+{
+	std::atomic<unsigned long> Sequence;
+	const char *Name;
+	char Bucket_Name[TRACE_BUCKET_NAME_LENGTH];
+	char Object_Name[TRACE_OBJECT_NAME_LENGTH];
+	struct timespec Start_Time;
+	struct timespec End_Time;
+	size_t Byte_Count;
+	int Success;
+	pid_t Thread_Id;
+};
+
+/**
+ * Data type holding local data to gcp_client_trace. This consists of the following:
+ * <dl>
+ * <dt>Enabled</dt> <dd>Whether spans are being recorded.</dd>
+ * <dt>Span_List</dt> <dd>The ring buffer of spans. Allocated by the first GCP_Client_Trace_Start and never freed,
+ *     so threads that saw tracing enabled just before it was stopped can still safely write to it.</dd>
+ * <dt>Span_Count</dt> <dd>The number of spans in Span_List.</dd>
+ * <dt>Next_Position</dt> <dd>The position of the next span to be recorded. Spans are stored at
+ *     Next_Position modulo Span_Count.</dd>
+ * </dl>
+ */
+struct Trace_Struct
+{
+	std::atomic<int> Enabled;
+	struct Trace_Span_Struct *Span_List;
+	unsigned long Span_Count;
+	std::atomic<unsigned long> Next_Position;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The instance of Trace_Struct that contains local data for this module. Being static, it is zero initialised
+ * i.e. tracing is disabled.
+ * @see #Trace_Struct
+ */
+static struct Trace_Struct Trace_Data;
+/**
+ * The calling thread's kernel thread id, cached on first use.
+ */
+static thread_local pid_t Trace_Thread_Id = 0;
+/**
+ * Variable holding error code of last operation performed.
+ */
+static int Trace_Error_Number = 0;
+/**
+ * Local variable holding description of the last error that occured.
+ * @see gcp_client_general.html#GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH
+ */
+static char Trace_Error_String[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH] = "";
+
+/* internal functions */
+static void Trace_Copy_String(char *destination,const char *source,size_t destination_length);
+static void Trace_Write_JSON_String(FILE *fp,const char *string);
+
+/* --------------------------------------------------------
+** External Functions
+** -------------------------------------------------------- */
+/**
+ * Start recording trace spans. The first time this is called, the span ring buffer is allocated.
+ * @param span_count The number of spans the ring buffer holds, or 0 to use GCP_CLIENT_TRACE_DEFAULT_SPAN_COUNT.
+ *        This is only used the first time tracing is started.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Trace_Error_Number /
+ *         Trace_Error_String should contain details of the failure.
+ * @see #Trace_Data
+ * @see gcp_client_trace.html#GCP_CLIENT_TRACE_DEFAULT_SPAN_COUNT
+ */
+int GCP_Client_Trace_Start(int span_count)
+{
+	Trace_Error_Number = 0;
+	if(span_count == 0)
+		span_count = GCP_CLIENT_TRACE_DEFAULT_SPAN_COUNT;
+	if(span_count < 0)
+	{
+		Trace_Error_Number = 1;
+		sprintf(Trace_Error_String,"GCP_Client_Trace_Start:Illegal span count %d.",span_count);
+		return FALSE;
+	}
+	if(Trace_Data.Span_List == NULL)
+	{
+		/* value-initialisation zeroes the sequence numbers */
+		Trace_Data.Span_List = new (std::nothrow) struct Trace_Span_Struct[span_count]();
+		if(Trace_Data.Span_List == NULL)
+		{
+			Trace_Error_Number = 2;
+			sprintf(Trace_Error_String,"GCP_Client_Trace_Start:Failed to allocate %d spans.",span_count);
+			return FALSE;
+		}
+		Trace_Data.Span_Count = span_count;
+		Trace_Data.Next_Position.store(0,std::memory_order_relaxed);
+	}
+	Trace_Data.Enabled.store(TRUE,std::memory_order_release);
+	return TRUE;
+}
+
+/**
+ * Stop recording trace spans. Spans already recorded are kept, and can be dumped with GCP_Client_Trace_Dump.
+ * @see #Trace_Data
+ */
+void GCP_Client_Trace_Stop(void)
+{
+	Trace_Data.Enabled.store(FALSE,std::memory_order_release);
+}
+
+/**
+ * Return whether trace spans are being recorded.
+ * @return TRUE if tracing is enabled, FALSE otherwise.
+ * @see #Trace_Data
+ */
+int GCP_Client_Trace_Is_Enabled(void)
+{
+	return Trace_Data.Enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Mark the start of a span. If tracing is enabled, the current time is stored in start_time, otherwise
+ * start_time is zeroed (and the matching GCP_Client_Trace_Span_End does nothing).
+ * @param start_time The address of a struct timespec to hold the span start time.
+ * @see #Trace_Data
+ * @see #GCP_Client_Trace_Span_End
+ */
+void GCP_Client_Trace_Span_Begin(struct timespec *start_time)
+{
+	if(Trace_Data.Enabled.load(std::memory_order_relaxed))
+		clock_gettime(CLOCK_MONOTONIC,start_time);
+	else
+	{
+		start_time->tv_sec = 0;
+		start_time->tv_nsec = 0;
+	}
+}
+
+/**
+ * Mark the end of a span, and record it in the ring buffer. Nothing is recorded if tracing is disabled,
+ * or was disabled when the matching GCP_Client_Trace_Span_Begin was called. A slot is claimed with an atomic
+ * increment of the next position, filled in, and then marked complete by storing it's sequence number.
+ * If the buffer is small enough that a writer is overtaken by a whole lap of other writers, that slot's span
+ * may be garbled; size the buffer to hold at least a few seconds of spans.
+ * @param name The name of the span. This must be a string constant, as only the pointer is stored.
+ * @param bucket_name The bucket being accessed, or NULL.
+ * @param object_name The object being accessed, or NULL.
+ * @param start_time The address of the struct timespec filled in by GCP_Client_Trace_Span_Begin.
+ * @param byte_count The number of bytes transferred during the span.
+ * @param success Whether the span's phase succeeded (TRUE) or failed (FALSE).
+ * @see #Trace_Data
+ * @see #Trace_Thread_Id
+ * @see #Trace_Copy_String
+ * @see #GCP_Client_Trace_Span_Begin
+ * @see #TRACE_BUCKET_NAME_LENGTH
+ * @see #TRACE_OBJECT_NAME_LENGTH
+ */
+void GCP_Client_Trace_Span_End(const char *name,const char *bucket_name,const char *object_name,
+			       struct timespec *start_time,size_t byte_count,int success)
+{
+	struct Trace_Span_Struct *span = NULL;
+	unsigned long position;
+
+	if(Trace_Data.Enabled.load(std::memory_order_relaxed) == FALSE)
+		return;
+	if((start_time == NULL)||((start_time->tv_sec == 0)&&(start_time->tv_nsec == 0)))
+		return;
+	if(Trace_Thread_Id == 0)
+		Trace_Thread_Id = (pid_t)syscall(SYS_gettid);
+	position = Trace_Data.Next_Position.fetch_add(1,std::memory_order_relaxed);
+	span = &(Trace_Data.Span_List[position%Trace_Data.Span_Count]);
+	span->Sequence.store(0,std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	clock_gettime(CLOCK_MONOTONIC,&(span->End_Time));
+	span->Name = name;
+	Trace_Copy_String(span->Bucket_Name,bucket_name,TRACE_BUCKET_NAME_LENGTH);
+	Trace_Copy_String(span->Object_Name,object_name,TRACE_OBJECT_NAME_LENGTH);
+	span->Start_Time = (*start_time);
+	span->Byte_Count = byte_count;
+	span->Success = success;
+	span->Thread_Id = Trace_Thread_Id;
+	span->Sequence.store(position+1,std::memory_order_release);
+}
+
+/**
+ * Write the recorded spans to a file in the Chrome trace event JSON format, oldest first. Each span is written as a
+ * complete ('X') event, with the bucket, object, byte count and success as arguments. Span times are taken from
+ * CLOCK_MONOTONIC, so they are unaffected by the system clock being stepped, and the event timestamps are relative
+ * to an arbitrary start (usually boot) rather than wall clock times.
+ * Tracing should be stopped before dumping; spans being written during the dump are skipped.
+ * @param filename The name of the file to write.
+ * @return The routine returns TRUE on success, and FALSE on failure. If it fails, Trace_Error_Number /
+ *         Trace_Error_String should contain details of the failure.
+ * @see #Trace_Data
+ * @see #Trace_Write_JSON_String
+ */
+int GCP_Client_Trace_Dump(const char *filename)
+{
+	struct Trace_Span_Struct *span = NULL;
+	FILE *fp = NULL;
+	unsigned long position,next_position,first_position;
+	long long start_us,end_us;
+	int first_event,open_errno;
+
+	Trace_Error_Number = 0;
+	if(filename == NULL)
+	{
+		Trace_Error_Number = 3;
+		sprintf(Trace_Error_String,"GCP_Client_Trace_Dump:filename was NULL.");
+		return FALSE;
+	}
+	fp = fopen(filename,"w");
+	if(fp == NULL)
+	{
+		open_errno = errno;
+		Trace_Error_Number = 4;
+		snprintf(Trace_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Trace_Dump:Failed to open '%s' (%d).",filename,open_errno);
+		return FALSE;
+	}
+	fprintf(fp,"{\"traceEvents\":[\n");
+	first_event = TRUE;
+	if(Trace_Data.Span_List != NULL)
+	{
+		next_position = Trace_Data.Next_Position.load(std::memory_order_acquire);
+		if(next_position > Trace_Data.Span_Count)
+			first_position = next_position-Trace_Data.Span_Count;
+		else
+			first_position = 0;
+		for(position = first_position; position < next_position; position++)
+		{
+			span = &(Trace_Data.Span_List[position%Trace_Data.Span_Count]);
+			if(span->Sequence.load(std::memory_order_acquire) != (position+1))
+				continue;
+			start_us = (((long long)span->Start_Time.tv_sec)*GCP_CLIENT_GENERAL_ONE_SECOND_US)+
+				(span->Start_Time.tv_nsec/GCP_CLIENT_GENERAL_ONE_MICROSECOND_NS);
+			end_us = (((long long)span->End_Time.tv_sec)*GCP_CLIENT_GENERAL_ONE_SECOND_US)+
+				(span->End_Time.tv_nsec/GCP_CLIENT_GENERAL_ONE_MICROSECOND_NS);
+			if(first_event == FALSE)
+				fprintf(fp,",\n");
+			fprintf(fp,"{\"name\":");
+			Trace_Write_JSON_String(fp,span->Name);
+			fprintf(fp,",\"cat\":\"gcp_client\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d,"
+				"\"args\":{\"bucket\":",start_us,end_us-start_us,(int)getpid(),(int)span->Thread_Id);
+			Trace_Write_JSON_String(fp,span->Bucket_Name);
+			fprintf(fp,",\"object\":");
+			Trace_Write_JSON_String(fp,span->Object_Name);
+			fprintf(fp,",\"bytes\":%lu,\"success\":%s}}",(unsigned long)span->Byte_Count,
+				span->Success ? "true" : "false");
+			first_event = FALSE;
+		}
+	}
+	fprintf(fp,"\n],\"displayTimeUnit\":\"ms\"}\n");
+	if(fclose(fp) != 0)
+	{
+		open_errno = errno;
+		Trace_Error_Number = 5;
+		snprintf(Trace_Error_String,GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH,
+			 "GCP_Client_Trace_Dump:Failed to close '%s' (%d).",filename,open_errno);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Discard all recorded spans. This should only be called when tracing is stopped.
+ * @see #Trace_Data
+ */
+void GCP_Client_Trace_Clear(void)
+{
+	unsigned long i;
+
+	if(Trace_Data.Span_List == NULL)
+		return;
+	for(i = 0; i < Trace_Data.Span_Count; i++)
+		Trace_Data.Span_List[i].Sequence.store(0,std::memory_order_relaxed);
+	Trace_Data.Next_Position.store(0,std::memory_order_release);
+}
+
+/**
+ * Routine to return the current value of the error number.
+ * @return The value of Trace_Error_Number.
+ * @see #Trace_Error_Number
+ */
+int GCP_Client_Trace_Get_Error_Number(void)
+{
+	return Trace_Error_Number;
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way.
+ * @see #Trace_Error_Number
+ * @see #Trace_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Trace_Error(void)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Trace_Error_Number == 0)
+		sprintf(Trace_Error_String,"Logic Error:No Error defined");
+	fprintf(stderr,"%s GCP_Client_Trace:Error(%d) : %s\n",time_string,
+		Trace_Error_Number,Trace_Error_String);
+}
+
+/**
+ * The error routine that reports any errors occuring in a standard way. This routine places the
+ * generated error string at the end of a passed in string argument.
+ * @param error_string A string to put the generated error in. This string should be initialised before
+ * being passed to this routine. The routine will try to concatenate it's error string onto the end
+ * of any string already in existance.
+ * @see #Trace_Error_Number
+ * @see #Trace_Error_String
+ * @see gcp_client_general.html#GCP_Client_General_Get_Current_Time_String
+ */
+void GCP_Client_Trace_Error_String(char *error_string)
+{
+	char time_string[32];
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	/* if the error number is zero an error message has not been set up
+	** This is in itself an error as we should not be calling this routine
+	** without there being an error to display */
+	if(Trace_Error_Number == 0)
+		sprintf(Trace_Error_String,"Logic Error:No Error defined");
+	sprintf(error_string+strlen(error_string),"%s GCP_Client_Trace:Error(%d) : %s\n",time_string,
+		Trace_Error_Number,Trace_Error_String);
+}
+
+/* --------------------------------------------------------
+** Internal Functions
+** -------------------------------------------------------- */
+/**
+ * Copy a (UTF-8) string into a fixed length buffer, truncating it if necessary. A truncated string is cut at a
+ * character boundary, so the dump never contains part of a multi-byte character (which is not valid JSON).
+ * @param destination The buffer to copy into.
+ * @param source The string to copy. NULL is copied as an empty string.
+ * @param destination_length The length of the buffer, including the terminating NUL.
+ */
+static void Trace_Copy_String(char *destination,const char *source,size_t destination_length)
+{
+	size_t length;
+
+	if(source == NULL)
+	{
+		destination[0] = '\0';
+		return;
+	}
+	length = strlen(source);
+	if(length >= destination_length)
+	{
+		length = destination_length-1;
+		/* don't cut before a continuation byte (10xxxxxx) */
+		while((length > 0)&&((((unsigned char)source[length]) & 0xC0) == 0x80))
+			length--;
+	}
+	memcpy(destination,source,length);
+	destination[length] = '\0';
+}
+
+/**
+ * Write a string to a file as a quoted JSON string, escaping characters as necessary.
+ * @param fp The file to write to.
+ * @param string The string to write. NULL is written as an empty string.
+ */
+static void Trace_Write_JSON_String(FILE *fp,const char *string)
+{
+	const char *ch_ptr = NULL;
+
+	fputc('"',fp);
+	for(ch_ptr = string; (ch_ptr != NULL)&&((*ch_ptr) != '\0'); ch_ptr++)
+	{
+		if(((*ch_ptr) == '"')||((*ch_ptr) == '\\'))
+		{
+			fputc('\\',fp);
+			fputc((*ch_ptr),fp);
+		}
+		else if(((unsigned char)(*ch_ptr)) < 0x20)
+			fprintf(fp,"\\u%04x",(unsigned int)(unsigned char)(*ch_ptr));
+		else
+			fputc((*ch_ptr),fp);
+	}
+	fputc('"',fp);
+}
@@ -0,0 +1,715 @@
+/* gcp_client.hpp */
+#ifndef GCP_CLIENT_HPP
+#define GCP_CLIENT_HPP
+
+/* c++ only header providing a future / coroutine based asynchronous interface to the gcp_client library.
+** The header is self contained (no extra library objects are needed), and each asynchronous operation calls
+** the library's C routines on an executor's thread, so it shares the connection (GCP_Client_Connection_Open),
+** bandwidth limits, buffer pool and statistics with code calling the C routines directly.
+** Futures need C++11, the coroutine awaitables C++20. */
+#include <stdlib.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#if (__cplusplus >= 202002L) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <optional>
+/**
+ * Defined when the compiler supports C++20 coroutines, and the awaitable operations (Read_Co etc) are available.
+ */
+#define GCP_CLIENT_HPP_COROUTINES      (1)
+#endif
+#endif
+#include "gcp_client_general.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_list.h"
+#include "gcp_client_operation.h"
+#include "gcp_client_read_write.h"
+#include "gcp_client_scheduler.h"
+
+namespace gcp_client
+{
+	/**
+	 * Exception thrown (through the future, or from co_await) when an asynchronous operation fails. It holds
+	 * the failing module's error number, and it's error string as the exception's what().
+	 */
+	class Error : public std::runtime_error
+	{
+	public:
+		/**
+		 * Constructor.
+		 * @param error_string The module's error string.
+		 * @param error_number The module's error number.
+		 */
+		Error(const std::string &error_string,int error_number) :
+			std::runtime_error(error_string),Error_Number_Value(error_number) {}
+		/**
+		 * Get the failing module's error number.
+		 * @return The error number.
+		 */
+		int Error_Number(void) const { return Error_Number_Value; }
+	private:
+		/**
+		 * The failing module's error number.
+		 */
+		int Error_Number_Value;
+	};
+
+	/**
+	 * The contents of an object (or a range of it) read by Read_Async / Read_Range_Async. It owns the memory the
+	 * library allocated for the read, and frees it when destroyed. It can be moved, but not copied.
+	 */
+	class Object_Data
+	{
+	public:
+		/**
+		 * Constructor, taking ownership of memory allocated by the library (with malloc / realloc).
+		 * @param ptr The memory, or NULL.
+		 * @param length The number of bytes in the memory.
+		 */
+		explicit Object_Data(void *ptr = NULL,size_t length = 0) : Ptr(ptr),Length_Value(length) {}
+		Object_Data(const Object_Data &) = delete;
+		Object_Data &operator=(const Object_Data &) = delete;
+		/**
+		 * Move constructor.
+		 * @param other The object data to take the memory from.
+		 */
+		Object_Data(Object_Data &&other) noexcept : Ptr(other.Ptr),Length_Value(other.Length_Value)
+		{
+			other.Ptr = NULL;
+			other.Length_Value = 0;
+		}
+		/**
+		 * Move assignment.
+		 * @param other The object data to take the memory from.
+		 * @return This object data.
+		 */
+		Object_Data &operator=(Object_Data &&other) noexcept
+		{
+			if(this != &other)
+			{
+				if(Ptr != NULL)
+					free(Ptr);
+				Ptr = other.Ptr;
+				Length_Value = other.Length_Value;
+				other.Ptr = NULL;
+				other.Length_Value = 0;
+			}
+			return *this;
+		}
+		/**
+		 * Destructor, frees the memory.
+		 */
+		~Object_Data()
+		{
+			if(Ptr != NULL)
+				free(Ptr);
+		}
+		/**
+		 * Get the bytes read.
+		 * @return A pointer to the bytes read, or NULL if there are none.
+		 */
+		const char *Data(void) const { return (const char *)Ptr; }
+		/**
+		 * Get the number of bytes read.
+		 * @return The number of bytes.
+		 */
+		size_t Length(void) const { return Length_Value; }
+		/**
+		 * Give up ownership of the memory, which the caller must then free.
+		 * @return The memory.
+		 */
+		void *Release(void)
+		{
+			void *ptr = Ptr;
+
+			Ptr = NULL;
+			Length_Value = 0;
+			return ptr;
+		}
+	private:
+		/**
+		 * The memory allocated by the library, or NULL.
+		 */
+		void *Ptr;
+		/**
+		 * The number of bytes in the memory.
+		 */
+		size_t Length_Value;
+	};
+
+	/**
+	 * Interface of the executors asynchronous operations run on. An executor runs each piece of work it is
+	 * posted once, on a thread of it's choosing. The library's C routines block, so the number of threads an
+	 * executor has is the number of transfers that overlap.
+	 */
+	class Executor
+	{
+	public:
+		virtual ~Executor() {}
+		/**
+		 * Run a piece of work. Post should not block waiting for the work to run.
+		 * @param work The work.
+		 */
+		virtual void Post(std::function<void()> work) = 0;
+	};
+
+	/**
+	 * Executor running work on a fixed pool of threads, in the order it was posted. The destructor runs the work
+	 * already posted, then stops the threads.
+	 */
+	class Thread_Pool_Executor : public Executor
+	{
+	public:
+		/**
+		 * Constructor, starts the threads.
+		 * @param thread_count The number of threads. If 0, GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY is used.
+		 */
+		explicit Thread_Pool_Executor(int thread_count = 0) : Stopping(false)
+		{
+			if(thread_count < 1)
+				thread_count = GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY;
+			for(int i = 0; i < thread_count; i++)
+				Thread_List.emplace_back([this] { Run(); });
+		}
+		Thread_Pool_Executor(const Thread_Pool_Executor &) = delete;
+		Thread_Pool_Executor &operator=(const Thread_Pool_Executor &) = delete;
+		/**
+		 * Destructor, waits for the work already posted, then stops the threads.
+		 */
+		~Thread_Pool_Executor() override
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				Stopping = true;
+			}
+			Condition.notify_all();
+			for(auto &thread : Thread_List)
+				thread.join();
+		}
+		/**
+		 * Queue a piece of work for the next free thread.
+		 * @param work The work.
+		 */
+		void Post(std::function<void()> work) override
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				Work_List.push_back(std::move(work));
+			}
+			Condition.notify_one();
+		}
+	private:
+		/**
+		 * Thread routine, runs queued work until the executor is stopping and no work is left.
+		 */
+		void Run(void)
+		{
+			std::function<void()> work;
+
+			while(true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(Mutex);
+					Condition.wait(lock,[this] { return Stopping||(Work_List.empty() == false); });
+					if(Work_List.empty())
+						return;
+					work = std::move(Work_List.front());
+					Work_List.pop_front();
+				}
+				work();
+			}
+		}
+		/**
+		 * Mutex protecting Work_List and Stopping.
+		 */
+		std::mutex Mutex;
+		/**
+		 * Condition variable notified when work is posted, or the executor is stopping.
+		 */
+		std::condition_variable Condition;
+		/**
+		 * The work waiting for a thread.
+		 */
+		std::deque<std::function<void()>> Work_List;
+		/**
+		 * Set when the executor is being destroyed.
+		 */
+		bool Stopping;
+		/**
+		 * The threads.
+		 */
+		std::vector<std::thread> Thread_List;
+	};
+
+	/**
+	 * Executor running work as jobs on one queue of a GCP_Client_Scheduler, so asynchronous operations get the
+	 * queue's priority, fair share, bucket limit and bandwidth priority. The scheduler must outlive the executor's
+	 * work.
+	 */
+	class Scheduler_Executor : public Executor
+	{
+	public:
+		/**
+		 * Constructor.
+		 * @param scheduler The scheduler, created with GCP_Client_Scheduler_Create.
+		 * @param queue_index The index of the queue to submit work to (GCP_Client_Scheduler_Add_Queue).
+		 * @param bucket_name The bucket the work is counted against for the scheduler's per-bucket limit, or an
+		 *        empty string if it is not limited.
+		 */
+		Scheduler_Executor(struct GCP_Client_Scheduler_Struct *scheduler,int queue_index,
+				   const std::string &bucket_name = "") :
+			Scheduler(scheduler),Queue_Index(queue_index),Bucket_Name(bucket_name) {}
+		/**
+		 * Submit a piece of work to the scheduler queue.
+		 * @param work The work.
+		 * @exception Error Thrown if the scheduler refuses the job.
+		 * @see gcp_client_scheduler.html#GCP_Client_Scheduler_Submit
+		 */
+		void Post(std::function<void()> work) override
+		{
+			std::function<void()> *job_work = new std::function<void()>(std::move(work));
+			char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH*2] = "";
+
+			if(!GCP_Client_Scheduler_Submit(Scheduler,Queue_Index,
+							(Bucket_Name.empty() ? NULL : Bucket_Name.c_str()),0,0,
+							Scheduler_Executor::Job,Scheduler_Executor::Done,job_work,NULL))
+			{
+				delete job_work;
+				GCP_Client_Scheduler_Error_String(error_string);
+				throw Error(error_string,GCP_Client_Scheduler_Get_Error_Number());
+			}
+		}
+	private:
+		/**
+		 * Scheduler job function, runs the work.
+		 * @param operation The job's operation (unused, the work makes it's own transfer).
+		 * @param user_data The work, a heap allocated std::function.
+		 * @return TRUE.
+		 */
+		static int Job(struct GCP_Client_Operation_Struct * /*operation*/,void *user_data)
+		{
+			(*(std::function<void()> *)user_data)();
+			return TRUE;
+		}
+		/**
+		 * Scheduler done function, frees the work.
+		 * @param job_id The job's id (unused).
+		 * @param state The state the job finished in (unused).
+		 * @param user_data The work, a heap allocated std::function.
+		 */
+		static void Done(unsigned long long /*job_id*/,int /*state*/,void *user_data)
+		{
+			delete (std::function<void()> *)user_data;
+		}
+		/**
+		 * The scheduler.
+		 */
+		struct GCP_Client_Scheduler_Struct *Scheduler;
+		/**
+		 * The index of the scheduler queue.
+		 */
+		int Queue_Index;
+		/**
+		 * The bucket name, or an empty string.
+		 */
+		std::string Bucket_Name;
+	};
+
+	/**
+	 * Get a reference to the executor set with Set_Default_Executor (NULL if none has been set).
+	 * @return A reference to the executor pointer.
+	 */
+	inline Executor *&Default_Executor_Pointer(void)
+	{
+		static Executor *executor = NULL;
+
+		return executor;
+	}
+
+	/**
+	 * Set the executor asynchronous operations not passed one run on. It must outlive the operations.
+	 * @param executor The executor, or NULL to go back to the built in thread pool.
+	 */
+	inline void Set_Default_Executor(Executor *executor)
+	{
+		Default_Executor_Pointer() = executor;
+	}
+
+	/**
+	 * Get the executor asynchronous operations not passed one run on. Unless another executor has been set with
+	 * Set_Default_Executor, this is a Thread_Pool_Executor with GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY threads,
+	 * created the first time it is needed.
+	 * @return The executor.
+	 */
+	inline Executor &Default_Executor(void)
+	{
+		static Thread_Pool_Executor thread_pool_executor;
+
+		if(Default_Executor_Pointer() != NULL)
+			return *Default_Executor_Pointer();
+		return thread_pool_executor;
+	}
+
+	namespace detail
+	{
+		/**
+		 * Run work on an executor, returning a future for it's result (or the exception it threw).
+		 * @param executor The executor.
+		 * @param work The work.
+		 * @return The future.
+		 */
+		template<class T> std::future<T> Post_Future(Executor &executor,std::function<T()> work)
+		{
+			auto task = std::make_shared<std::packaged_task<T()>>(std::move(work));
+			std::future<T> future = task->get_future();
+
+			executor.Post([task] { (*task)(); });
+			return future;
+		}
+
+		/**
+		 * Throw an Error holding the read_write module's error.
+		 * @exception Error Always thrown.
+		 */
+		inline void Throw_Read_Write_Error(void)
+		{
+			char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH*2] = "";
+
+			GCP_Client_Read_Write_Error_String(error_string);
+			throw Error(error_string,GCP_Client_Read_Write_Get_Error_Number());
+		}
+
+		/**
+		 * Read an object (or, if length is non-zero, a range of it), on the calling thread.
+		 * @param bucket_name The name of the bucket.
+		 * @param object_name The name of the object.
+		 * @param offset The offset of the first byte of the range.
+		 * @param length The length of the range, or 0 to read the whole object.
+		 * @param operation The operation to read with, or NULL. Ranges are not read with an operation.
+		 * @return The bytes read.
+		 * @exception Error Thrown if the read fails.
+		 */
+		inline Object_Data Read(const std::string &bucket_name,const std::string &object_name,
+					unsigned long long offset,size_t length,
+					struct GCP_Client_Operation_Struct *operation)
+		{
+			void *ptr = NULL;
+			size_t ptr_length = 0;
+			int retval;
+
+			if(length > 0)
+				retval = GCP_Client_Read_Write_Read_Range((char*)bucket_name.c_str(),
+									  (char*)object_name.c_str(),offset,length,
+									  &ptr,&ptr_length);
+			else if(operation != NULL)
+				retval = GCP_Client_Read_Write_Read_Operation(operation,(char*)bucket_name.c_str(),
+									      (char*)object_name.c_str(),&ptr,&ptr_length);
+			else
+				retval = GCP_Client_Read_Write_Read((char*)bucket_name.c_str(),(char*)object_name.c_str(),
+								    &ptr,&ptr_length);
+			if(!retval)
+				Throw_Read_Write_Error();
+			return Object_Data(ptr,ptr_length);
+		}
+
+		/**
+		 * Write an object, on the calling thread.
+		 * @param bucket_name The name of the bucket.
+		 * @param object_name The name of the object.
+		 * @param data The bytes to write.
+		 * @param length The number of bytes to write.
+		 * @param operation The operation to write with, or NULL.
+		 * @exception Error Thrown if the write fails.
+		 */
+		inline void Write(const std::string &bucket_name,const std::string &object_name,const void *data,
+				  size_t length,struct GCP_Client_Operation_Struct *operation)
+		{
+			int retval;
+
+			if(operation != NULL)
+				retval = GCP_Client_Read_Write_Write_Operation(operation,(char*)bucket_name.c_str(),
+									       (char*)object_name.c_str(),(void*)data,length);
+			else
+				retval = GCP_Client_Read_Write_Write((char*)bucket_name.c_str(),(char*)object_name.c_str(),
+								     (void*)data,length);
+			if(!retval)
+				Throw_Read_Write_Error();
+		}
+
+		/**
+		 * List callback, appends a page of objects to the std::vector passed as user_data.
+		 * @param object_list The page of objects.
+		 * @param object_count The number of objects in the page.
+		 * @param user_data The std::vector of GCP_Client_Object_Metadata_Struct to append to.
+		 * @return TRUE, to carry on listing.
+		 */
+		inline int List_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+					 void *user_data)
+		{
+			auto *list = (std::vector<struct GCP_Client_Object_Metadata_Struct> *)user_data;
+
+			list->insert(list->end(),object_list,object_list+object_count);
+			return TRUE;
+		}
+
+		/**
+		 * List the objects in a bucket, on the calling thread.
+		 * @param bucket_name The name of the bucket.
+		 * @param prefix Only objects whose names start with the prefix are listed ("" for all).
+		 * @param delimiter If not "", objects below the next delimiter are returned as prefixes.
+		 * @return The objects (and prefixes) listed.
+		 * @exception Error Thrown if the listing fails.
+		 */
+		inline std::vector<struct GCP_Client_Object_Metadata_Struct> List(const std::string &bucket_name,
+										  const std::string &prefix,
+										  const std::string &delimiter)
+		{
+			std::vector<struct GCP_Client_Object_Metadata_Struct> list;
+			char error_string[GCP_CLIENT_GENERAL_ERROR_STRING_LENGTH*2] = "";
+
+			if(!GCP_Client_List((char*)bucket_name.c_str(),(prefix.empty() ? NULL : (char*)prefix.c_str()),
+					    (delimiter.empty() ? NULL : (char*)delimiter.c_str()),NULL,NULL,0,
+					    List_Callback,&list))
+			{
+				GCP_Client_List_Error_String(error_string);
+				throw Error(error_string,GCP_Client_List_Get_Error_Number());
+			}
+			return list;
+		}
+	}
+
+	/**
+	 * Read an object asynchronously.
+	 * @param bucket_name The name of the bucket.
+	 * @param object_name The name of the object.
+	 * @param executor The executor to read on.
+	 * @param operation An operation to read with (GCP_Client_Operation_Create), to bound or cancel the read,
+	 *        or NULL.
+	 * @return A future for the bytes read. It throws Error if the read failed.
+	 * @see gcp_client_read_write.html#GCP_Client_Read_Write_Read
+	 * @see gcp_client_read_write.html#GCP_Client_Read_Write_Read_Operation
+	 */
+	inline std::future<Object_Data> Read_Async(const std::string &bucket_name,const std::string &object_name,
+						   Executor &executor = Default_Executor(),
+						   struct GCP_Client_Operation_Struct *operation = NULL)
+	{
+		return detail::Post_Future<Object_Data>(executor,[=] {
+			return detail::Read(bucket_name,object_name,0,0,operation); });
+	}
+
+	/**
+	 * Read part of an object asynchronously.
+	 * @param bucket_name The name of the bucket.
+	 * @param object_name The name of the object.
+	 * @param offset The offset of the first byte to read.
+	 * @param length The number of bytes to read (fewer are returned if the object ends first).
+	 * @param executor The executor to read on.
+	 * @return A future for the bytes read. It throws Error if the read failed.
+	 * @see gcp_client_read_write.html#GCP_Client_Read_Write_Read_Range
+	 */
+	inline std::future<Object_Data> Read_Range_Async(const std::string &bucket_name,const std::string &object_name,
+							 unsigned long long offset,size_t length,
+							 Executor &executor = Default_Executor())
+	{
+		return detail::Post_Future<Object_Data>(executor,[=] {
+			return detail::Read(bucket_name,object_name,offset,length,NULL); });
+	}
+
+	/**
+	 * Write an object asynchronously. The data is not copied, and must not be changed or freed until the
+	 * future is ready.
+	 * @param bucket_name The name of the bucket.
+	 * @param object_name The name of the object.
+	 * @param data The bytes to write.
+	 * @param length The number of bytes to write.
+	 * @param executor The executor to write on.
+	 * @param operation An operation to write with (GCP_Client_Operation_Create), to bound, cancel or pause the
+	 *        upload, or NULL.
+	 * @return A future that is ready when the write has finished. It throws Error if the write failed.
+	 * @see gcp_client_read_write.html#GCP_Client_Read_Write_Write
+	 * @see gcp_client_read_write.html#GCP_Client_Read_Write_Write_Operation
+	 */
+	inline std::future<void> Write_Async(const std::string &bucket_name,const std::string &object_name,
+					     const void *data,size_t length,Executor &executor = Default_Executor(),
+					     struct GCP_Client_Operation_Struct *operation = NULL)
+	{
+		return detail::Post_Future<void>(executor,[=] {
+			detail::Write(bucket_name,object_name,data,length,operation); });
+	}
+
+	/**
+	 * List the objects in a bucket asynchronously.
+	 * @param bucket_name The name of the bucket.
+	 * @param prefix Only objects whose names start with the prefix are listed ("" for all).
+	 * @param delimiter If not "", objects below the next delimiter are returned as prefixes (Is_Prefix set).
+	 * @param executor The executor to list on.
+	 * @return A future for the objects listed. It throws Error if the listing failed.
+	 * @see gcp_client_list.html#GCP_Client_List
+	 */
+	inline std::future<std::vector<struct GCP_Client_Object_Metadata_Struct>> List_Async(
+		const std::string &bucket_name,const std::string &prefix = "",const std::string &delimiter = "",
+		Executor &executor = Default_Executor())
+	{
+		return detail::Post_Future<std::vector<struct GCP_Client_Object_Metadata_Struct>>(executor,[=] {
+			return detail::List(bucket_name,prefix,delimiter); });
+	}
+
+#ifdef GCP_CLIENT_HPP_COROUTINES
+	/**
+	 * Awaitable returned by the coroutine operations (Read_Co etc). co_await posts the operation to it's executor
+	 * and suspends the coroutine, which is resumed on the executor's thread when the operation has finished.
+	 * co_await returns the operation's result, or throws Error if it failed. Each awaitable should be awaited
+	 * once.
+	 */
+	template<class T> class Awaitable
+	{
+	public:
+		/**
+		 * Constructor.
+		 * @param executor The executor to run the operation on.
+		 * @param work The operation.
+		 */
+		Awaitable(Executor &executor,std::function<T()> work) : Executor_Ref(executor),Work(std::move(work)) {}
+		/**
+		 * The operation has not started, so the coroutine always suspends.
+		 * @return false.
+		 */
+		bool await_ready(void) const noexcept { return false; }
+		/**
+		 * Post the operation to the executor, resuming the coroutine when it has finished.
+		 * @param handle The suspended coroutine.
+		 */
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			Executor_Ref.Post([this,handle] {
+				try
+				{
+					if constexpr (std::is_void<T>::value)
+						Work();
+					else
+						Result.emplace(Work());
+				}
+				catch(...)
+				{
+					Exception = std::current_exception();
+				}
+				handle.resume();
+			});
+		}
+		/**
+		 * Return the operation's result.
+		 * @return The result.
+		 * @exception Error Rethrown if the operation failed.
+		 */
+		T await_resume(void)
+		{
+			if(Exception)
+				std::rethrow_exception(Exception);
+			if constexpr (std::is_void<T>::value)
+				return;
+			else
+				return std::move(*Result);
+		}
+	private:
+		/**
+		 * The executor the operation runs on.
+		 */
+		Executor &Executor_Ref;
+		/**
+		 * The operation.
+		 */
+		std::function<T()> Work;
+		/**
+		 * The operation's result, once it has finished (unused for void operations).
+		 */
+		std::optional<typename std::conditional<std::is_void<T>::value,bool,T>::type> Result;
+		/**
+		 * The exception the operation threw, if it failed.
+		 */
+		std::exception_ptr Exception;
+	};
+
+	/**
+	 * Read an object in a coroutine: co_await Read_Co(bucket_name,object_name).
+	 * @param bucket_name The name of the bucket.
+	 * @param object_name The name of the object.
+	 * @param executor The executor to read on.
+	 * @param operation An operation to read with, or NULL.
+	 * @return An awaitable for the bytes read.
+	 * @see #Read_Async
+	 */
+	inline Awaitable<Object_Data> Read_Co(const std::string &bucket_name,const std::string &object_name,
+					      Executor &executor = Default_Executor(),
+					      struct GCP_Client_Operation_Struct *operation = NULL)
+	{
+		return Awaitable<Object_Data>(executor,[=] {
+			return detail::Read(bucket_name,object_name,0,0,operation); });
+	}
+
+	/**
+	 * Read part of an object in a coroutine.
+	 * @param bucket_name The name of the bucket.
+	 * @param object_name The name of the object.
+	 * @param offset The offset of the first byte to read.
+	 * @param length The number of bytes to read.
+	 * @param executor The executor to read on.
+	 * @return An awaitable for the bytes read.
+	 * @see #Read_Range_Async
+	 */
+	inline Awaitable<Object_Data> Read_Range_Co(const std::string &bucket_name,const std::string &object_name,
+						    unsigned long long offset,size_t length,
+						    Executor &executor = Default_Executor())
+	{
+		return Awaitable<Object_Data>(executor,[=] {
+			return detail::Read(bucket_name,object_name,offset,length,NULL); });
+	}
+
+	/**
+	 * Write an object in a coroutine. The data must not be changed or freed until the co_await returns.
+	 * @param bucket_name The name of the bucket.
+	 * @param object_name The name of the object.
+	 * @param data The bytes to write.
+	 * @param length The number of bytes to write.
+	 * @param executor The executor to write on.
+	 * @param operation An operation to write with, or NULL.
+	 * @return An awaitable that completes when the write has finished.
+	 * @see #Write_Async
+	 */
+	inline Awaitable<void> Write_Co(const std::string &bucket_name,const std::string &object_name,const void *data,
+					size_t length,Executor &executor = Default_Executor(),
+					struct GCP_Client_Operation_Struct *operation = NULL)
+	{
+		return Awaitable<void>(executor,[=] { detail::Write(bucket_name,object_name,data,length,operation); });
+	}
+
+	/**
+	 * List the objects in a bucket in a coroutine.
+	 * @param bucket_name The name of the bucket.
+	 * @param prefix Only objects whose names start with the prefix are listed ("" for all).
+	 * @param delimiter If not "", objects below the next delimiter are returned as prefixes.
+	 * @param executor The executor to list on.
+	 * @return An awaitable for the objects listed.
+	 * @see #List_Async
+	 */
+	inline Awaitable<std::vector<struct GCP_Client_Object_Metadata_Struct>> List_Co(
+		const std::string &bucket_name,const std::string &prefix = "",const std::string &delimiter = "",
+		Executor &executor = Default_Executor())
+	{
+		return Awaitable<std::vector<struct GCP_Client_Object_Metadata_Struct>>(executor,[=] {
+			return detail::List(bucket_name,prefix,delimiter); });
+	}
+#endif
+}
+
+#endif
@@ -0,0 +1,105 @@
+/* gcp_client_adaptive.h */
+#ifndef GCP_CLIENT_ADAPTIVE_H
+#define GCP_CLIENT_ADAPTIVE_H
+
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * Transfer direction : ranged parts of parallel reads (GCP_Client_Read_Write_Read_Parallel).
+ */
+#define GCP_CLIENT_ADAPTIVE_DIRECTION_READ             (0)
+/**
+ * Transfer direction : uploads (GCP_Client_Read_Write_Write and the sync uploads).
+ */
+#define GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD           (1)
+/**
+ * The number of transfer directions.
+ */
+#define GCP_CLIENT_ADAPTIVE_DIRECTION_COUNT            (2)
+/**
+ * The number of decisions kept in each direction's history.
+ */
+#define GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH             (256)
+/**
+ * Resumable uploads are sent in multiples of this length (256 KB), so upload chunk lengths are rounded up to it.
+ */
+#define GCP_CLIENT_ADAPTIVE_UPLOAD_CHUNK_QUANTUM       (256*1024)
+/**
+ * The default smallest read part length (1 MB).
+ */
+#define GCP_CLIENT_ADAPTIVE_DEFAULT_READ_MIN_CHUNK     (1024*1024)
+/**
+ * The default largest read part length (64 MB).
+ */
+#define GCP_CLIENT_ADAPTIVE_DEFAULT_READ_MAX_CHUNK     (64*1024*1024)
+/**
+ * The default largest number of read parts in progress at once.
+ */
+#define GCP_CLIENT_ADAPTIVE_DEFAULT_READ_MAX_PARALLEL  (16)
+/**
+ * The default smallest upload chunk length (256 KB).
+ */
+#define GCP_CLIENT_ADAPTIVE_DEFAULT_UPLOAD_MIN_CHUNK   (256*1024)
+/**
+ * The default largest upload chunk length (32 MB).
+ */
+#define GCP_CLIENT_ADAPTIVE_DEFAULT_UPLOAD_MAX_CHUNK   (32*1024*1024)
+/**
+ * The default largest number of uploads in progress at once.
+ */
+#define GCP_CLIENT_ADAPTIVE_DEFAULT_UPLOAD_MAX_PARALLEL (64)
+
+/* data types */
+/**
+ * Structure holding a decision made by the controller, and the measurements it was made from.
+ * This consists of the following:
+ * <dl>
+ * <dt>Time</dt> <dd>When the decision was made, in seconds since the controller was started (or reset).</dd>
+ * <dt>Throughput</dt> <dd>The aggregate throughput over the measurement window, in bytes per second.</dd>
+ * <dt>Stream_Throughput</dt> <dd>The average throughput of a single transfer over the window,
+ *     in bytes per second.</dd>
+ * <dt>RTT</dt> <dd>The smoothed round trip time (request to first byte), in seconds.</dd>
+ * <dt>Min_RTT</dt> <dd>The smallest round trip time seen, in seconds.</dd>
+ * <dt>Chunk_Length</dt> <dd>The chunk (or part) length chosen, in bytes.</dd>
+ * <dt>Parallelism</dt> <dd>The number of transfers in progress at once chosen.</dd>
+ * <dt>Sample_Count</dt> <dd>The number of transfers measured in the window.</dd>
+ * </dl>
+ */
+struct GCP_Client_Adaptive_Decision_Struct
+{
+	double Time;
+	double Throughput;
+	double Stream_Throughput;
+	double RTT;
+	double Min_RTT;
+	size_t Chunk_Length;
+	int Parallelism;
+	int Sample_Count;
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Adaptive_Set_Limits(int direction,size_t min_chunk_length,size_t max_chunk_length,
+					  int min_parallelism,int max_parallelism);
+extern int GCP_Client_Adaptive_Get_Limits(int direction,size_t *min_chunk_length,size_t *max_chunk_length,
+					  int *min_parallelism,int *max_parallelism);
+extern int GCP_Client_Adaptive_Get(int direction,size_t *chunk_length,int *parallelism);
+extern void GCP_Client_Adaptive_Record(int direction,unsigned long long byte_count,double transfer_time,
+				       double rtt);
+extern int GCP_Client_Adaptive_Get_History(int direction,struct GCP_Client_Adaptive_Decision_Struct *decision_list,
+					   int max_count,int *count);
+extern int GCP_Client_Adaptive_Reset(int direction);
+
+extern int GCP_Client_Adaptive_Get_Error_Number(void);
+extern void GCP_Client_Adaptive_Error(void);
+extern void GCP_Client_Adaptive_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/* gcp_client_bandwidth.h */
+#ifndef GCP_CLIENT_BANDWIDTH_H
+#define GCP_CLIENT_BANDWIDTH_H
+
+/* hash defines */
+/**
+ * Transfer direction : bytes sent to google cloud storage (uploads).
+ */
+#define GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD          (0)
+/**
+ * Transfer direction : bytes received from google cloud storage (downloads).
+ */
+#define GCP_CLIENT_BANDWIDTH_DIRECTION_DOWNLOAD        (1)
+/**
+ * The number of transfer directions.
+ */
+#define GCP_CLIENT_BANDWIDTH_DIRECTION_COUNT           (2)
+/**
+ * Priority class : transfers that must go first (for instance, science frames as they are taken).
+ */
+#define GCP_CLIENT_BANDWIDTH_PRIORITY_HIGH             (0)
+/**
+ * Priority class : ordinary transfers. Threads start in this class.
+ */
+#define GCP_CLIENT_BANDWIDTH_PRIORITY_NORMAL           (1)
+/**
+ * Priority class : transfers that only use bandwidth the other classes leave (for instance, archive backfill).
+ */
+#define GCP_CLIENT_BANDWIDTH_PRIORITY_BULK             (2)
+/**
+ * The number of priority classes.
+ */
+#define GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT            (3)
+/**
+ * Limit value meaning the direction's bandwidth is not limited.
+ */
+#define GCP_CLIENT_BANDWIDTH_UNLIMITED                 (0)
+
+/* data types */
+/**
+ * Structure holding the bandwidth statistics of one transfer direction. This consists of the following:
+ * <dl>
+ * <dt>Limit</dt> <dd>The bandwidth limit in bytes per second, or GCP_CLIENT_BANDWIDTH_UNLIMITED.</dd>
+ * <dt>Burst</dt> <dd>The token bucket size in bytes: how many bytes can be sent at once after an idle period.</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes transferred by each priority class.</dd>
+ * <dt>Rate</dt> <dd>The rate each priority class achieved over the last measurement window, in bytes per
+ *     second.</dd>
+ * <dt>Wait_Time</dt> <dd>The total time each priority class has spent waiting for bandwidth, in seconds.</dd>
+ * <dt>Waiting_Count</dt> <dd>The number of transfers in each priority class waiting for bandwidth now.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT
+ */
+struct GCP_Client_Bandwidth_Stats_Struct
+{
+	unsigned long long Limit;
+	unsigned long long Burst;
+	unsigned long long Byte_Count[GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT];
+	double Rate[GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT];
+	double Wait_Time[GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT];
+	int Waiting_Count[GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT];
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Bandwidth_Set_Limit(int direction,unsigned long long limit,unsigned long long burst);
+extern int GCP_Client_Bandwidth_Get_Limit(int direction,unsigned long long *limit,unsigned long long *burst);
+extern int GCP_Client_Bandwidth_Set_Thread_Priority(int priority);
+extern int GCP_Client_Bandwidth_Get_Thread_Priority(void);
+extern int GCP_Client_Bandwidth_Acquire(int direction,unsigned long long byte_count);
+extern int GCP_Client_Bandwidth_Get_Stats(int direction,struct GCP_Client_Bandwidth_Stats_Struct *stats);
+extern int GCP_Client_Bandwidth_Reset_Stats(int direction);
+extern const char *GCP_Client_Bandwidth_Priority_To_String(int priority);
+extern int GCP_Client_Bandwidth_Priority_Parse(const char *string,int *priority);
+
+extern int GCP_Client_Bandwidth_Get_Error_Number(void);
+extern void GCP_Client_Bandwidth_Error(void);
+extern void GCP_Client_Bandwidth_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
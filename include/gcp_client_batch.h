@@ -0,0 +1,39 @@
+/* gcp_client_batch.h */
+#ifndef GCP_CLIENT_BATCH_H
+#define GCP_CLIENT_BATCH_H
+
+/* hash defines */
+/**
+ * The default number of threads used to process a batch, if a concurrency of 0 is passed in.
+ */
+#define GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY           (16)
+/**
+ * The maximum number of threads used to process a batch.
+ */
+#define GCP_CLIENT_BATCH_MAX_CONCURRENCY               (256)
+
+/* data types */
+/**
+ * Type of the function called by the batch runner for each item in a batch. The function is passed the
+ * index of the item to process, and the user_data pointer passed to GCP_Client_Batch_Run. It is called from
+ * several threads at once, each with a different index.
+ */
+typedef void (*GCP_Client_Batch_Item_Function_T)(int index,void *user_data);
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Batch_Run(int item_count,int concurrency,GCP_Client_Batch_Item_Function_T item_fn,
+				void *user_data);
+
+extern int GCP_Client_Batch_Get_Error_Number(void);
+extern void GCP_Client_Batch_Error(void);
+extern void GCP_Client_Batch_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+/* gcp_client_budget.h */
+#ifndef GCP_CLIENT_BUDGET_H
+#define GCP_CLIENT_BUDGET_H
+
+/* hash defines */
+/**
+ * Budget use : buffers handed out by the buffer pool (GCP_Client_Buffer_Acquire, GCP_Client_Read_Write_Read_Buffer),
+ * from acquire until release.
+ */
+#define GCP_CLIENT_BUDGET_USE_BUFFER                   (0)
+/**
+ * Budget use : memory allocated by GCP_Client_Read_Write_Read, whilst the object is being read. The reservation
+ * grows with the memory allocated, so a read of unknown length is bounded by the budget.
+ */
+#define GCP_CLIENT_BUDGET_USE_READ                     (1)
+/**
+ * Budget use : buffers files are uploaded (or checksummed) through.
+ */
+#define GCP_CLIENT_BUDGET_USE_UPLOAD                   (2)
+/**
+ * Budget use : cached data (for instance, object contents a program keeps in memory for re-use).
+ */
+#define GCP_CLIENT_BUDGET_USE_CACHE                    (3)
+/**
+ * The number of budget uses.
+ */
+#define GCP_CLIENT_BUDGET_USE_COUNT                    (4)
+/**
+ * Reservation timeout : wait for as long as it takes for the budget to become available.
+ */
+#define GCP_CLIENT_BUDGET_WAIT_FOREVER                 (-1)
+/**
+ * Reservation timeout : use the default timeout set with GCP_Client_Budget_Set_Default_Timeout.
+ */
+#define GCP_CLIENT_BUDGET_TIMEOUT_DEFAULT              (-2)
+
+/* data types */
+/**
+ * Type of the function called when an asynchronous reservation (GCP_Client_Budget_Reserve_Async) is granted.
+ * It is passed the user_data pointer passed to GCP_Client_Budget_Reserve_Async. It is called either from the
+ * reserving thread (if the budget was available straight away), or from the thread whose release made the
+ * budget available, so it should start the transfer (or hand it to another thread) rather than perform it.
+ */
+typedef void (*GCP_Client_Budget_Callback_T)(void *user_data);
+
+/**
+ * Structure holding the memory budget statistics. This consists of the following:
+ * <dl>
+ * <dt>Limit</dt> <dd>The budget, in bytes, or 0 for no limit.</dd>
+ * <dt>In_Use</dt> <dd>The number of bytes currently reserved.</dd>
+ * <dt>High_Water</dt> <dd>The largest number of bytes reserved at once.</dd>
+ * <dt>Use_In_Use</dt> <dd>The number of bytes currently reserved for each use (GCP_CLIENT_BUDGET_USE_*).</dd>
+ * <dt>Reserve_Count</dt> <dd>The number of reservations requested.</dd>
+ * <dt>Wait_Count</dt> <dd>The number of reservations that had to wait for budget.</dd>
+ * <dt>Timeout_Count</dt> <dd>The number of reservations that gave up waiting (or could not wait, including
+ *     those larger than the whole budget).</dd>
+ * <dt>Over_Limit_Count</dt> <dd>The number of reservations granted beyond the limit, because waiting could not
+ *     help (everything in use was reserved by the caller).</dd>
+ * <dt>Waiting_Count</dt> <dd>The number of reservations currently waiting.</dd>
+ * <dt>Wait_Time</dt> <dd>The total time reservations have spent waiting, in seconds.</dd>
+ * </dl>
+ */
+struct GCP_Client_Budget_Stats_Struct
+{
+	unsigned long long Limit;
+	unsigned long long In_Use;
+	unsigned long long High_Water;
+	unsigned long long Use_In_Use[GCP_CLIENT_BUDGET_USE_COUNT];
+	unsigned long long Reserve_Count;
+	unsigned long long Wait_Count;
+	unsigned long long Timeout_Count;
+	unsigned long long Over_Limit_Count;
+	unsigned long long Waiting_Count;
+	double Wait_Time;
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void GCP_Client_Budget_Set_Limit(unsigned long long limit);
+extern void GCP_Client_Budget_Set_Default_Timeout(int timeout_ms);
+extern int GCP_Client_Budget_Reserve(int use,unsigned long long length,int timeout_ms);
+extern int GCP_Client_Budget_Reserve_Async(int use,unsigned long long length,GCP_Client_Budget_Callback_T callback,
+					   void *user_data);
+extern void GCP_Client_Budget_Release(int use,unsigned long long length);
+extern int GCP_Client_Budget_Get_Stats(struct GCP_Client_Budget_Stats_Struct *stats);
+
+extern int GCP_Client_Budget_Get_Error_Number(void);
+extern void GCP_Client_Budget_Error(void);
+extern void GCP_Client_Budget_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
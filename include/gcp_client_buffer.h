@@ -0,0 +1,81 @@
+/* gcp_client_buffer.h */
+#ifndef GCP_CLIENT_BUFFER_H
+#define GCP_CLIENT_BUFFER_H
+
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * The length of the smallest buffer size class, in bytes (64 KB). Each size class is twice the length of the
+ * one below it.
+ */
+#define GCP_CLIENT_BUFFER_MIN_CLASS_LENGTH             (64*1024)
+/**
+ * The number of buffer size classes, 64 KB to 1 GB. Buffers longer than the largest class are mapped for the
+ * caller and unmapped on release, rather than pooled.
+ */
+#define GCP_CLIENT_BUFFER_CLASS_COUNT                  (15)
+/**
+ * The length of a huge page, in bytes (2 MB). Buffers of this length or longer are mapped aligned to it, and
+ * advised to be backed by transparent huge pages.
+ */
+#define GCP_CLIENT_BUFFER_HUGE_PAGE_LENGTH             (2*1024*1024)
+/**
+ * The default maximum number of bytes of released buffers the pool retains for re-use (256 MB).
+ */
+#define GCP_CLIENT_BUFFER_DEFAULT_MAX_RETAINED_LENGTH  (256*1024*1024)
+
+/* data types */
+/**
+ * Structure holding the buffer pool statistics. This consists of the following:
+ * <dl>
+ * <dt>Acquire_Count</dt> <dd>The number of buffers handed out.</dd>
+ * <dt>Reuse_Count</dt> <dd>The number of buffers handed out from the pool, rather than newly mapped.</dd>
+ * <dt>Map_Count</dt> <dd>The number of buffers newly mapped.</dd>
+ * <dt>Release_Count</dt> <dd>The number of buffers released.</dd>
+ * <dt>Unmap_Count</dt> <dd>The number of buffers unmapped, because they were released when the pool
+ *     already retained it's maximum, were too large to pool, or the pool was trimmed.</dd>
+ * <dt>Outstanding_Count</dt> <dd>The number of buffers handed out and not yet released.</dd>
+ * <dt>Outstanding_Length</dt> <dd>The number of bytes in the outstanding buffers.</dd>
+ * <dt>Retained_Count</dt> <dd>The number of released buffers held in the pool.</dd>
+ * <dt>Retained_Length</dt> <dd>The number of bytes in the released buffers held in the pool.</dd>
+ * <dt>Max_Retained_Length</dt> <dd>The maximum number of bytes the pool will retain.</dd>
+ * <dt>Peak_Mapped_Length</dt> <dd>The largest number of bytes mapped (outstanding and retained) at once.</dd>
+ * </dl>
+ */
+struct GCP_Client_Buffer_Stats_Struct
+{
+	unsigned long long Acquire_Count;
+	unsigned long long Reuse_Count;
+	unsigned long long Map_Count;
+	unsigned long long Release_Count;
+	unsigned long long Unmap_Count;
+	unsigned long long Outstanding_Count;
+	unsigned long long Outstanding_Length;
+	unsigned long long Retained_Count;
+	unsigned long long Retained_Length;
+	unsigned long long Max_Retained_Length;
+	unsigned long long Peak_Mapped_Length;
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Buffer_Acquire(size_t length,void **buffer_ptr,size_t *capacity);
+extern int GCP_Client_Buffer_Grow(void **buffer_ptr,size_t used_length,size_t length,size_t *capacity);
+extern int GCP_Client_Buffer_Release(void *buffer);
+extern void GCP_Client_Buffer_Set_Max_Retained_Length(size_t max_retained_length);
+extern void GCP_Client_Buffer_Trim(void);
+extern int GCP_Client_Buffer_Get_Stats(struct GCP_Client_Buffer_Stats_Struct *stats);
+
+extern int GCP_Client_Buffer_Get_Error_Number(void);
+extern void GCP_Client_Buffer_Error(void);
+extern void GCP_Client_Buffer_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,110 @@
+/* gcp_client_completions.h */
+#ifndef GCP_CLIENT_COMPLETIONS_H
+#define GCP_CLIENT_COMPLETIONS_H
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * The default number of transfer threads (transfers run at once), if a thread count of 0 is passed to
+ * GCP_Client_Completions_Create.
+ */
+#define GCP_CLIENT_COMPLETIONS_DEFAULT_THREAD_COUNT    (8)
+/**
+ * The maximum number of transfer threads.
+ */
+#define GCP_CLIENT_COMPLETIONS_MAX_THREAD_COUNT        (256)
+/**
+ * The length of the error string in a completion, including the terminating NUL.
+ */
+#define GCP_CLIENT_COMPLETIONS_ERROR_STRING_LENGTH     (1024)
+/**
+ * Transfer type : an object read with GCP_Client_Completions_Read_Start.
+ */
+#define GCP_CLIENT_COMPLETIONS_TYPE_READ               (0)
+/**
+ * Transfer type : part of an object read with GCP_Client_Completions_Read_Range_Start.
+ */
+#define GCP_CLIENT_COMPLETIONS_TYPE_READ_RANGE         (1)
+/**
+ * Transfer type : an object written with GCP_Client_Completions_Write_Start.
+ */
+#define GCP_CLIENT_COMPLETIONS_TYPE_WRITE              (2)
+/**
+ * Transfer type : an object deleted with GCP_Client_Completions_Delete_Start.
+ */
+#define GCP_CLIENT_COMPLETIONS_TYPE_DELETE             (3)
+
+/* data types */
+/**
+ * Opaque completion queue handle, created with GCP_Client_Completions_Create.
+ */
+struct GCP_Client_Completions_Struct;
+
+/**
+ * Structure holding a finished transfer, returned by GCP_Client_Completions_Drain. This consists of the following:
+ * <dl>
+ * <dt>Id</dt> <dd>The transfer's id, returned by the routine that started it.</dd>
+ * <dt>Type</dt> <dd>The transfer type (GCP_CLIENT_COMPLETIONS_TYPE_*).</dd>
+ * <dt>Success</dt> <dd>A boolean, TRUE if the transfer succeeded.</dd>
+ * <dt>State</dt> <dd>The state the transfer finished in: GCP_CLIENT_OPERATION_STATE_COMPLETED, FAILED, CANCELLED,
+ *     DEADLINE_EXCEEDED or STALLED.</dd>
+ * <dt>Data</dt> <dd>For reads, the bytes read, allocated with malloc, which the caller must free (NULL if the read
+ *     failed). For writes, the caller's data pointer, which can now be reused. NULL for deletes.</dd>
+ * <dt>Length</dt> <dd>The number of bytes read or written.</dd>
+ * <dt>Delete_Status</dt> <dd>For deletes, the delete status (GCP_CLIENT_DELETE_STATUS_*).</dd>
+ * <dt>User_Data</dt> <dd>The user data passed to the routine that started the transfer.</dd>
+ * <dt>Error_Number</dt> <dd>If the transfer failed, the failing module's error number, otherwise 0.</dd>
+ * <dt>Error_String</dt> <dd>If the transfer failed, the failing module's error string, otherwise an empty
+ *     string.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_COMPLETIONS_ERROR_STRING_LENGTH
+ */
+struct GCP_Client_Completion_Struct
+{
+	unsigned long long Id;
+	int Type;
+	int Success;
+	int State;
+	void *Data;
+	size_t Length;
+	int Delete_Status;
+	void *User_Data;
+	int Error_Number;
+	char Error_String[GCP_CLIENT_COMPLETIONS_ERROR_STRING_LENGTH];
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Completions_Create(struct GCP_Client_Completions_Struct **completions,int thread_count);
+extern int GCP_Client_Completions_Get_Fd(struct GCP_Client_Completions_Struct *completions,int *fd);
+extern int GCP_Client_Completions_Read_Start(struct GCP_Client_Completions_Struct *completions,char *bucket_name,
+					     char *object_name,void *user_data,unsigned long long *id);
+extern int GCP_Client_Completions_Read_Range_Start(struct GCP_Client_Completions_Struct *completions,
+						   char *bucket_name,char *object_name,unsigned long long offset,
+						   size_t length,void *user_data,unsigned long long *id);
+extern int GCP_Client_Completions_Write_Start(struct GCP_Client_Completions_Struct *completions,char *bucket_name,
+					      char *object_name,void *data,size_t length,void *user_data,
+					      unsigned long long *id);
+extern int GCP_Client_Completions_Delete_Start(struct GCP_Client_Completions_Struct *completions,char *bucket_name,
+					       char *object_name,long long generation,void *user_data,
+					       unsigned long long *id);
+extern int GCP_Client_Completions_Cancel(struct GCP_Client_Completions_Struct *completions,unsigned long long id);
+extern int GCP_Client_Completions_Drain(struct GCP_Client_Completions_Struct *completions,
+					struct GCP_Client_Completion_Struct *completion_list,int max_count,
+					int *completion_count);
+extern int GCP_Client_Completions_Get_Pending_Count(struct GCP_Client_Completions_Struct *completions,
+						    int *pending_count);
+extern int GCP_Client_Completions_Destroy(struct GCP_Client_Completions_Struct *completions);
+
+extern int GCP_Client_Completions_Get_Error_Number(void);
+extern void GCP_Client_Completions_Error(void);
+extern void GCP_Client_Completions_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/* gcp_client_copy.h */
+#ifndef GCP_CLIENT_COPY_H
+#define GCP_CLIENT_COPY_H
+
+#include "gcp_client_list.h"
+
+/* hash defines */
+/**
+ * The maximum length of a rewrite token. Tokens returned by the cloud are opaque, and typically a few hundred
+ * characters long.
+ */
+#define GCP_CLIENT_COPY_REWRITE_TOKEN_LENGTH           (1024)
+
+/* data types */
+/**
+ * Structure describing one copy in a batch of copies, and returning it's result. This consists of the following:
+ * <dl>
+ * <dt>Source_Bucket_Name</dt> <dd>The bucket to copy from (input).</dd>
+ * <dt>Source_Object_Name</dt> <dd>The object to copy (input).</dd>
+ * <dt>Destination_Bucket_Name</dt> <dd>The bucket to copy to (input).</dd>
+ * <dt>Destination_Object_Name</dt> <dd>The name of the new object (input).</dd>
+ * <dt>Storage_Class</dt> <dd>The storage class of the new object (e.g. "ARCHIVE"), or NULL to use the
+ *     destination bucket's default (input).</dd>
+ * <dt>Success</dt> <dd>A boolean, TRUE if the copy succeeded (output).</dd>
+ * <dt>Error_Number</dt> <dd>The gcp_client_copy error number if the copy failed, 0 otherwise (output).</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes copied (output).</dd>
+ * </dl>
+ */
+struct GCP_Client_Copy_Request_Struct
+{
+	char *Source_Bucket_Name;
+	char *Source_Object_Name;
+	char *Destination_Bucket_Name;
+	char *Destination_Object_Name;
+	char *Storage_Class;
+	int Success;
+	int Error_Number;
+	unsigned long long Byte_Count;
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Copy(char *source_bucket_name,char *source_object_name,char *destination_bucket_name,
+			   char *destination_object_name,char *storage_class,
+			   struct GCP_Client_Object_Metadata_Struct *metadata);
+extern int GCP_Client_Rewrite(char *source_bucket_name,char *source_object_name,char *destination_bucket_name,
+			      char *destination_object_name,char *storage_class,char *rewrite_token,
+			      struct GCP_Client_Object_Metadata_Struct *metadata);
+extern int GCP_Client_Rewrite_Batch(struct GCP_Client_Copy_Request_Struct *request_list,int request_count,
+				    int concurrency);
+
+extern int GCP_Client_Copy_Get_Error_Number(void);
+extern void GCP_Client_Copy_Error(void);
+extern void GCP_Client_Copy_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+/* gcp_client_delete.h */
+#ifndef GCP_CLIENT_DELETE_H
+#define GCP_CLIENT_DELETE_H
+
+/* hash defines */
+/**
+ * Delete status value : the object was deleted.
+ */
+#define GCP_CLIENT_DELETE_STATUS_DELETED               (0)
+/**
+ * Delete status value : the object did not exist (it may already have been deleted).
+ */
+#define GCP_CLIENT_DELETE_STATUS_NOT_FOUND             (1)
+/**
+ * Delete status value : the object was not deleted, as it's generation did not match the one specified
+ * (it has been overwritten since the generation was retrieved).
+ */
+#define GCP_CLIENT_DELETE_STATUS_PRECONDITION_FAILED   (2)
+/**
+ * Delete status value : the delete failed for some other reason.
+ */
+#define GCP_CLIENT_DELETE_STATUS_FAILED                (3)
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Delete(char *bucket_name,char *object_name,long long generation,int *status);
+extern int GCP_Client_Delete_Batch(char *bucket_name,char **object_name_list,long long *generation_list,
+				   int object_count,int concurrency,double max_rate,unsigned char *status_list);
+extern int GCP_Client_Delete_Prefix(char *bucket_name,char *prefix,int concurrency,double max_rate,
+				    unsigned long long *deleted_count,unsigned long long *failed_count);
+
+extern int GCP_Client_Delete_Get_Error_Number(void);
+extern void GCP_Client_Delete_Error(void);
+extern void GCP_Client_Delete_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
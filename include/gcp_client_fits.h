@@ -0,0 +1,131 @@
+/* gcp_client_fits.h */
+#ifndef GCP_CLIENT_FITS_H
+#define GCP_CLIENT_FITS_H
+#include <stddef.h>
+#include "gcp_client_list.h"
+
+/* hash defines */
+/**
+ * The prefix of the custom metadata keys FITS header keywords are indexed under. The rest of the key is the
+ * keyword in lower case, for instance "fits-exptime".
+ */
+#define GCP_CLIENT_FITS_METADATA_PREFIX                "fits-"
+/**
+ * The keywords indexed if GCP_Client_Fits_Index_Set is passed a NULL keyword list.
+ */
+#define GCP_CLIENT_FITS_DEFAULT_KEYWORD_LIST           "OBJECT,EXPTIME,DATE-OBS,MJD,INSTRUME,FILTER1,RA,DEC"
+/**
+ * The maximum number of keywords that can be indexed.
+ */
+#define GCP_CLIENT_FITS_MAX_KEYWORD_COUNT              (32)
+/**
+ * The length of a keyword name, including the terminating NUL (cfitsio's FLEN_KEYWORD).
+ */
+#define GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH            (75)
+/**
+ * The length of a keyword value, including the terminating NUL (cfitsio's FLEN_VALUE).
+ */
+#define GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH           (71)
+/**
+ * The maximum number of conditions in a query.
+ */
+#define GCP_CLIENT_FITS_MAX_CONDITION_COUNT            (16)
+/**
+ * Query condition operator : the keyword's value equals the condition's value.
+ */
+#define GCP_CLIENT_FITS_OPERATOR_EQ                    (0)
+/**
+ * Query condition operator : the keyword's value does not equal the condition's value.
+ */
+#define GCP_CLIENT_FITS_OPERATOR_NE                    (1)
+/**
+ * Query condition operator : the keyword's value is less than the condition's value.
+ */
+#define GCP_CLIENT_FITS_OPERATOR_LT                    (2)
+/**
+ * Query condition operator : the keyword's value is less than or equal to the condition's value.
+ */
+#define GCP_CLIENT_FITS_OPERATOR_LE                    (3)
+/**
+ * Query condition operator : the keyword's value is greater than the condition's value.
+ */
+#define GCP_CLIENT_FITS_OPERATOR_GT                    (4)
+/**
+ * Query condition operator : the keyword's value is greater than or equal to the condition's value.
+ */
+#define GCP_CLIENT_FITS_OPERATOR_GE                    (5)
+
+/* data types */
+/**
+ * Structure holding one FITS header keyword and it's value. This consists of the following:
+ * <dl>
+ * <dt>Name</dt> <dd>The keyword name, in upper case (e.g. "EXPTIME").</dd>
+ * <dt>Value</dt> <dd>The keyword value, as a string. String values have their quotes and trailing spaces
+ *     removed.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH
+ * @see #GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH
+ */
+struct GCP_Client_Fits_Keyword_Struct
+{
+	char Name[GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH];
+	char Value[GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH];
+};
+
+/**
+ * Structure holding one query condition, for instance EXPTIME > 60. This consists of the following:
+ * <dl>
+ * <dt>Keyword</dt> <dd>The keyword name (case is ignored).</dd>
+ * <dt>Operator</dt> <dd>The comparison (GCP_CLIENT_FITS_OPERATOR_*).</dd>
+ * <dt>Value</dt> <dd>The value to compare the keyword's value with. If both are numbers they are compared
+ *     numerically, otherwise they are compared as strings (which orders ISO 8601 dates correctly).</dd>
+ * </dl>
+ * @see #GCP_CLIENT_FITS_OPERATOR_EQ
+ */
+struct GCP_Client_Fits_Condition_Struct
+{
+	char Keyword[GCP_CLIENT_FITS_KEYWORD_NAME_LENGTH];
+	int Operator;
+	char Value[GCP_CLIENT_FITS_KEYWORD_VALUE_LENGTH];
+};
+
+/**
+ * Type of the callback function invoked with each object matching a query. The callback is passed the object's
+ * metadata, it's indexed keywords (keyword_count of them), and the user_data pointer passed to
+ * GCP_Client_Fits_Query. The pointers are only valid for the duration of the call. The callback should return
+ * TRUE to continue the query, or FALSE to stop it early.
+ * @see gcp_client_list.html#GCP_Client_Object_Metadata_Struct
+ * @see #GCP_Client_Fits_Keyword_Struct
+ */
+typedef int (*GCP_Client_Fits_Query_Callback_T)(const struct GCP_Client_Object_Metadata_Struct *object,
+						const struct GCP_Client_Fits_Keyword_Struct *keyword_list,
+						int keyword_count,void *user_data);
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Fits_Index_Set(int enable,const char *keyword_list);
+extern int GCP_Client_Fits_Index_Get(int *enable,char *keyword_list,size_t keyword_list_length);
+extern int GCP_Client_Fits_Header_Parse(const void *data,size_t length,
+					struct GCP_Client_Fits_Keyword_Struct *keyword_list,int max_count,
+					int *keyword_count);
+extern int GCP_Client_Fits_Get_Keywords(char *bucket_name,char *object_name,
+					struct GCP_Client_Fits_Keyword_Struct *keyword_list,int max_count,
+					int *keyword_count);
+extern int GCP_Client_Fits_Condition_Parse(const char *string,struct GCP_Client_Fits_Condition_Struct *condition_list,
+					   int max_count,int *condition_count);
+extern int GCP_Client_Fits_Query(char *bucket_name,char *prefix,
+				 struct GCP_Client_Fits_Condition_Struct *condition_list,int condition_count,
+				 GCP_Client_Fits_Query_Callback_T callback,void *user_data);
+
+extern int GCP_Client_Fits_Get_Error_Number(void);
+extern void GCP_Client_Fits_Error(void);
+extern void GCP_Client_Fits_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
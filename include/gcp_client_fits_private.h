@@ -0,0 +1,13 @@
+/* gcp_client_fits_private.h */
+#ifndef GCP_CLIENT_FITS_PRIVATE_H
+#define GCP_CLIENT_FITS_PRIVATE_H
+
+#include "google/cloud/storage/client.h"
+
+/* c++ only header providing mangled c++ interfaces between c++ modules in the gcp_client library
+** This header cannot be included in C client programs, or the exposed functions called from C code */
+extern int GCP_Client_Fits_Index_Metadata(const void *data,size_t length,
+					  ::google::cloud::storage::ObjectMetadata &object_metadata);
+
+
+#endif
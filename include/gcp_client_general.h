@@ -53,6 +53,100 @@
  */
 #define GCP_CLIENT_GENERAL_ONE_MICROSECOND_NS	       (1000)
 
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_general.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_GENERAL          (0)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_connection.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_CONNECTION       (1)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_read_write.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE       (2)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_list.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_LIST             (3)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_metadata.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_METADATA         (4)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_manifest.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_MANIFEST         (5)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_copy.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_COPY             (6)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_delete.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_DELETE           (7)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_sync.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_SYNC             (8)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_buffer.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_BUFFER           (9)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_budget.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_BUDGET           (10)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_adaptive.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_ADAPTIVE         (11)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_operation.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_OPERATION        (12)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_bandwidth.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_BANDWIDTH        (13)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_scheduler.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_SCHEDULER        (14)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_completions.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_COMPLETIONS      (15)
+/**
+ * Log module identifier, used to select the runtime log level of messages logged by gcp_client_fits.
+ * @see #GCP_CLIENT_GENERAL_LOG_MODULE_COUNT
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_FITS             (16)
+/**
+ * The number of log modules.
+ */
+#define GCP_CLIENT_GENERAL_LOG_MODULE_COUNT            (17)
+/**
+ * A module log level that passes messages of any level on to the log filter. This is the default.
+ */
+#define GCP_CLIENT_GENERAL_LOG_LEVEL_ALL               (0x7fffffff)
+
 #ifndef fdifftime
 /**
  * Return double difference (in seconds) between two struct timespec's.
@@ -61,7 +155,8 @@
  * @return A double, in seconds, representing the time elapsed from t0 to t1.
  * @see #GCP_CLIENT_GENERAL_ONE_SECOND_NS
  */
-#define fdifftime(t1, t0) (((double)(((t1).tv_sec)-((t0).tv_sec))+(double)(((t1).tv_nsec)-((t0).tv_nsec))/GCP_CLIENT_GENERAL_ONE_SECOND_NS))
+#define fdifftime(t1, t0) (((double)(((t1).tv_sec)-((t0).tv_sec))+ \
+			  (double)(((t1).tv_nsec)-((t0).tv_nsec))/GCP_CLIENT_GENERAL_ONE_SECOND_NS))
 #endif
 
 /*  the following 3 lines are needed to support C++ compilers */
@@ -75,15 +170,26 @@ extern void GCP_Client_General_Error(void);
 extern void GCP_Client_General_Error_To_String(char *error_string);
 extern int GCP_Client_General_Get_Error_Number(void);
 extern void GCP_Client_General_Get_Current_Time_String(char *time_string,int string_length);
+extern void GCP_Client_General_Get_Log_Time_String(char *time_string,int string_length);
 
 extern void GCP_Client_General_Log_Format(int level,const char *format,...);
 extern void GCP_Client_General_Log(int level,const char *string);
+extern void GCP_Client_General_Module_Log_Format(int module,int level,const char *format,...);
+extern void GCP_Client_General_Module_Log(int module,int level,const char *string);
+extern int GCP_Client_General_Log_Is_Enabled(int module,int level);
 extern void GCP_Client_General_Set_Log_Handler_Function(void (*log_fn)(int level,const char *string));
 extern void GCP_Client_General_Set_Log_Filter_Function(int (*filter_fn)(int level,const char *string));
 extern void GCP_Client_General_Log_Handler_Stdout(int level,const char *string);
 extern void GCP_Client_General_Set_Log_Filter_Level(int level);
 extern int GCP_Client_General_Log_Filter_Level_Absolute(int level,const char *string);
 extern int GCP_Client_General_Log_Filter_Level_Bitwise(int level,const char *string);
+extern int GCP_Client_General_Set_Module_Log_Level(int module,int level);
+extern int GCP_Client_General_Get_Module_Log_Level(int module);
+extern int GCP_Client_General_Set_Module_Log_Levels(const char *level_string);
+extern int GCP_Client_General_Log_Async_Start(int record_count);
+extern int GCP_Client_General_Log_Async_Stop(int flush_timeout_ms);
+extern void GCP_Client_General_Log_Async_Get_Statistics(unsigned long long *logged_count,
+							unsigned long long *dropped_count);
 
 #ifdef __cplusplus
 }
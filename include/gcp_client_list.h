@@ -0,0 +1,71 @@
+/* gcp_client_list.h */
+#ifndef GCP_CLIENT_LIST_H
+#define GCP_CLIENT_LIST_H
+
+#include <time.h>
+
+/* hash defines */
+/**
+ * The maximum length of an object name (Google Cloud Storage object names are at most 1024 bytes of UTF-8).
+ */
+#define GCP_CLIENT_LIST_NAME_LENGTH                    (1024)
+/**
+ * The default number of objects returned to the callback per page, if a page size of 0 is passed in.
+ * This is also the maximum page size the cloud storage JSON API will return.
+ */
+#define GCP_CLIENT_LIST_DEFAULT_PAGE_SIZE              (1000)
+
+/* data types */
+/**
+ * Structure holding a compact copy of the metadata of one object, as returned by a listing.
+ * This consists of the following:
+ * <dl>
+ * <dt>Name</dt> <dd>The object name (filename within the bucket), NULL terminated.</dd>
+ * <dt>Size</dt> <dd>The size of the object in bytes.</dd>
+ * <dt>Generation</dt> <dd>The generation number of the object.</dd>
+ * <dt>CRC32C</dt> <dd>The CRC32C checksum of the object contents.</dd>
+ * <dt>Is_Prefix</dt> <dd>A boolean, TRUE if this entry is a common prefix ("directory") returned by a
+ *     delimited listing rather than an object. Only Name is set for prefixes.</dd>
+ * <dt>Updated</dt> <dd>The time the object metadata was last updated.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_LIST_NAME_LENGTH
+ */
+struct GCP_Client_Object_Metadata_Struct
+{
+	char Name[GCP_CLIENT_LIST_NAME_LENGTH+1];
+	unsigned long long Size;
+	long long Generation;
+	unsigned int CRC32C;
+	int Is_Prefix;
+	struct timespec Updated;
+};
+
+/**
+ * Type of the callback function invoked with each page of a listing. The callback is passed a pointer to
+ * a list of object_count metadata structures (only valid for the duration of the call), and the user_data
+ * pointer passed into the listing routine. The callback should return TRUE to continue the listing,
+ * or FALSE to stop it early.
+ * @see #GCP_Client_Object_Metadata_Struct
+ */
+typedef int (*GCP_Client_List_Callback_T)(const struct GCP_Client_Object_Metadata_Struct *object_list,
+					  int object_count,void *user_data);
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_List(char *bucket_name,char *prefix,char *delimiter,char *start_offset,char *end_offset,
+			   int page_size,GCP_Client_List_Callback_T callback,void *user_data);
+extern int GCP_Client_List_Parallel(char *bucket_name,char *prefix,char **boundary_list,int boundary_count,
+				    int page_size,GCP_Client_List_Callback_T callback,void *user_data);
+
+extern int GCP_Client_List_Get_Error_Number(void);
+extern void GCP_Client_List_Error(void);
+extern void GCP_Client_List_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,14 @@
+/* gcp_client_list_private.h */
+#ifndef GCP_CLIENT_LIST_PRIVATE_H
+#define GCP_CLIENT_LIST_PRIVATE_H
+
+#include "google/cloud/storage/client.h"
+#include "gcp_client_list.h"
+
+/* c++ only header providing mangled c++ interfaces between c++ modules in the gcp_client library
+** This header cannot be included in C client programs, or the exposed functions called from C code */
+extern void GCP_Client_List_Metadata_Copy(const ::google::cloud::storage::ObjectMetadata &object_metadata,
+					  struct GCP_Client_Object_Metadata_Struct *metadata);
+
+
+#endif
@@ -0,0 +1,43 @@
+/* gcp_client_log_udp.h */
+#ifndef GCP_CLIENT_LOG_UDP_H
+#define GCP_CLIENT_LOG_UDP_H
+
+/* hash defines */
+/**
+ * The default maximum length of a batched log datagram, in bytes.
+ * This fits in a standard ethernet MTU without IP fragmentation.
+ */
+#define GCP_CLIENT_LOG_UDP_DEFAULT_DATAGRAM_LENGTH     (1400)
+/**
+ * The default maximum time a log message waits in a partially filled batch before the batch is sent,
+ * in milliseconds.
+ */
+#define GCP_CLIENT_LOG_UDP_DEFAULT_FLUSH_MS            (250)
+/**
+ * The string that starts the header line of each batched log datagram. The header line is of the form:
+ * "GCP_CLIENT_LOG_UDP &lt;first sequence number&gt; &lt;message count&gt; &lt;dropped count&gt;\n",
+ * and is followed by &lt;message count&gt; lines of the form
+ * "&lt;sequence number&gt; &lt;level&gt; &lt;timestamp&gt; &lt;message&gt;\n".
+ */
+#define GCP_CLIENT_LOG_UDP_DATAGRAM_HEADER             "GCP_CLIENT_LOG_UDP"
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Log_UDP_Open(const char *hostname,int port_number,int datagram_length,int flush_ms);
+extern void GCP_Client_Log_UDP_Handler(int level,const char *string);
+extern int GCP_Client_Log_UDP_Close(void);
+extern void GCP_Client_Log_UDP_Get_Statistics(unsigned long long *message_count,unsigned long long *sent_count,
+					      unsigned long long *dropped_count,unsigned long long *datagram_count);
+
+extern int GCP_Client_Log_UDP_Get_Error_Number(void);
+extern void GCP_Client_Log_UDP_Error(void);
+extern void GCP_Client_Log_UDP_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
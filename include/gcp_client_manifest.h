@@ -0,0 +1,38 @@
+/* gcp_client_manifest.h */
+#ifndef GCP_CLIENT_MANIFEST_H
+#define GCP_CLIENT_MANIFEST_H
+
+#include "gcp_client_list.h"
+
+/* data types */
+/**
+ * Opaque handle to an open (memory mapped) manifest file. Created by GCP_Client_Manifest_Open, and
+ * released by GCP_Client_Manifest_Close.
+ */
+struct GCP_Client_Manifest_Struct;
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Manifest_Refresh(char *filename,char *bucket_name,char *prefix,char *start_offset,
+				       char *end_offset);
+extern int GCP_Client_Manifest_Open(char *filename,struct GCP_Client_Manifest_Struct **manifest);
+extern int GCP_Client_Manifest_Close(struct GCP_Client_Manifest_Struct **manifest);
+extern unsigned long long GCP_Client_Manifest_Get_Object_Count(struct GCP_Client_Manifest_Struct *manifest);
+extern const char *GCP_Client_Manifest_Get_Bucket_Name(struct GCP_Client_Manifest_Struct *manifest);
+extern int GCP_Client_Manifest_Lookup(struct GCP_Client_Manifest_Struct *manifest,char *object_name,
+				      struct GCP_Client_Object_Metadata_Struct *metadata,int *found);
+extern int GCP_Client_Manifest_Scan(struct GCP_Client_Manifest_Struct *manifest,char *prefix,
+				    GCP_Client_List_Callback_T callback,void *user_data);
+
+extern int GCP_Client_Manifest_Get_Error_Number(void);
+extern void GCP_Client_Manifest_Error(void);
+extern void GCP_Client_Manifest_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
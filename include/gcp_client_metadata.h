@@ -0,0 +1,25 @@
+/* gcp_client_metadata.h */
+#ifndef GCP_CLIENT_METADATA_H
+#define GCP_CLIENT_METADATA_H
+
+#include "gcp_client_list.h"
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Metadata_Get(char *bucket_name,char *object_name,
+				   struct GCP_Client_Object_Metadata_Struct *metadata);
+extern int GCP_Client_Metadata_Get_Batch(char *bucket_name,char **object_name_list,int object_count,int concurrency,
+					 struct GCP_Client_Object_Metadata_Struct *metadata_list,int *success_list);
+
+extern int GCP_Client_Metadata_Get_Error_Number(void);
+extern void GCP_Client_Metadata_Error(void);
+extern void GCP_Client_Metadata_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
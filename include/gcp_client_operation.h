@@ -0,0 +1,73 @@
+/* gcp_client_operation.h */
+#ifndef GCP_CLIENT_OPERATION_H
+#define GCP_CLIENT_OPERATION_H
+
+/* hash defines */
+/**
+ * Operation state : created (or reset), and not yet used for a transfer.
+ */
+#define GCP_CLIENT_OPERATION_STATE_IDLE                (0)
+/**
+ * Operation state : a transfer is in progress.
+ */
+#define GCP_CLIENT_OPERATION_STATE_RUNNING             (1)
+/**
+ * Operation state : the transfer completed successfully.
+ */
+#define GCP_CLIENT_OPERATION_STATE_COMPLETED           (2)
+/**
+ * Operation state : the transfer failed, for a reason other than those below.
+ */
+#define GCP_CLIENT_OPERATION_STATE_FAILED              (3)
+/**
+ * Operation state : the transfer was cancelled with GCP_Client_Operation_Cancel.
+ */
+#define GCP_CLIENT_OPERATION_STATE_CANCELLED           (4)
+/**
+ * Operation state : the transfer was stopped because it's deadline passed.
+ */
+#define GCP_CLIENT_OPERATION_STATE_DEADLINE_EXCEEDED   (5)
+/**
+ * Operation state : the transfer was stopped because no bytes moved for the stall timeout.
+ */
+#define GCP_CLIENT_OPERATION_STATE_STALLED             (6)
+/**
+ * Operation state : the transfer was stopped by GCP_Client_Operation_Pause. After GCP_Client_Operation_Resume,
+ * an upload passed the same operation carries on from where it stopped.
+ */
+#define GCP_CLIENT_OPERATION_STATE_PAUSED              (7)
+
+/* data types */
+/**
+ * Opaque operation handle, created with GCP_Client_Operation_Create and passed to the *_Operation transfer
+ * routines (for instance GCP_Client_Read_Write_Read_Operation).
+ */
+struct GCP_Client_Operation_Struct;
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Operation_Create(struct GCP_Client_Operation_Struct **operation);
+extern int GCP_Client_Operation_Set_Deadline(struct GCP_Client_Operation_Struct *operation,int deadline_ms);
+extern int GCP_Client_Operation_Set_Stall_Timeout(struct GCP_Client_Operation_Struct *operation,
+						  int stall_timeout_ms);
+extern int GCP_Client_Operation_Cancel(struct GCP_Client_Operation_Struct *operation);
+extern int GCP_Client_Operation_Pause(struct GCP_Client_Operation_Struct *operation);
+extern int GCP_Client_Operation_Resume(struct GCP_Client_Operation_Struct *operation);
+extern int GCP_Client_Operation_Get_State(struct GCP_Client_Operation_Struct *operation,int *state,
+					  unsigned long long *byte_count);
+extern int GCP_Client_Operation_Reset(struct GCP_Client_Operation_Struct *operation);
+extern int GCP_Client_Operation_Destroy(struct GCP_Client_Operation_Struct *operation);
+extern const char *GCP_Client_Operation_State_To_String(int state);
+
+extern int GCP_Client_Operation_Get_Error_Number(void);
+extern void GCP_Client_Operation_Error(void);
+extern void GCP_Client_Operation_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
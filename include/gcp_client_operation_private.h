@@ -0,0 +1,18 @@
+/* gcp_client_operation_private.h */
+#ifndef GCP_CLIENT_OPERATION_PRIVATE_H
+#define GCP_CLIENT_OPERATION_PRIVATE_H
+
+/* c++ only header providing mangled c++ interfaces between c++ modules in the gcp_client library
+** This header cannot be included in C client programs, or the exposed functions called from C code */
+extern int GCP_Client_Operation_Begin(struct GCP_Client_Operation_Struct *operation);
+extern int GCP_Client_Operation_Check(struct GCP_Client_Operation_Struct *operation,int transfer_failed);
+extern void GCP_Client_Operation_Progress(struct GCP_Client_Operation_Struct *operation,
+					  unsigned long long byte_count);
+extern void GCP_Client_Operation_End(struct GCP_Client_Operation_Struct *operation,int success);
+extern ::google::cloud::Options GCP_Client_Operation_Get_Options(struct GCP_Client_Operation_Struct *operation);
+extern void GCP_Client_Operation_Set_Session(struct GCP_Client_Operation_Struct *operation,
+					     std::string const &session_id);
+extern std::string GCP_Client_Operation_Get_Session(struct GCP_Client_Operation_Struct *operation);
+
+
+#endif
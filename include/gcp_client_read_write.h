@@ -2,6 +2,52 @@
 #ifndef GCP_CLIENT_READ_WRITE_H
 #define GCP_CLIENT_READ_WRITE_H
 
+#include "gcp_client_operation.h"
+
+/* hash defines */
+/**
+ * The default first byte latency percentile a hedged read waits for, before starting a duplicate request.
+ */
+#define GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_PERCENTILE        (95.0)
+/**
+ * The default cap on duplicate (hedge) requests, as a percentage of hedged reads.
+ */
+#define GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_EXTRA_PERCENT (5.0)
+/**
+ * The default length of the longest read that is hedged, in bytes (1 MB).
+ */
+#define GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_LENGTH        (1024*1024)
+
+/* data types */
+/**
+ * Structure holding the hedged read statistics. This consists of the following:
+ * <dl>
+ * <dt>Read_Count</dt> <dd>The number of reads made with hedging enabled.</dd>
+ * <dt>Hedge_Count</dt> <dd>The number of duplicate (hedge) requests started. Hedge_Count / Read_Count is the
+ *     hedge rate.</dd>
+ * <dt>Hedge_Win_Count</dt> <dd>The number of reads where the hedge request finished first.</dd>
+ * <dt>Suppressed_Count</dt> <dd>The number of reads whose first byte was late, but were not hedged as the cap on
+ *     extra requests had been reached.</dd>
+ * <dt>Abandoned_Count</dt> <dd>The number of hedge requests abandoned because the object turned out to be longer
+ *     than the maximum hedged length.</dd>
+ * <dt>Cancel_Count</dt> <dd>The number of requests cancelled because the other request of the pair won.</dd>
+ * <dt>Sample_Count</dt> <dd>The number of first byte latencies the threshold is calculated from.</dd>
+ * <dt>Threshold</dt> <dd>The current hedge threshold (the configured percentile of the recent first byte
+ *     latencies), in milliseconds, or 0 if there are not yet enough samples to hedge.</dd>
+ * </dl>
+ */
+struct GCP_Client_Read_Write_Hedge_Stats_Struct
+{
+	unsigned long long Read_Count;
+	unsigned long long Hedge_Count;
+	unsigned long long Hedge_Win_Count;
+	unsigned long long Suppressed_Count;
+	unsigned long long Abandoned_Count;
+	unsigned long long Cancel_Count;
+	unsigned long long Sample_Count;
+	double Threshold;
+};
+
 /*  the following 3 lines are needed to support C++ compilers */
 #ifdef __cplusplus
 extern "C" {
@@ -9,8 +55,20 @@ extern "C" {
 
 extern int GCP_Client_Read_Write_Read(char* bucket_name,char* filename,
 				      void **file_contents_ptr,size_t *file_contents_length);
+extern int GCP_Client_Read_Write_Read_Buffer(char* bucket_name,char* filename,
+					     void **buffer_ptr,size_t *buffer_length);
+extern int GCP_Client_Read_Write_Read_Range(char* bucket_name,char* filename,unsigned long long offset,
+					    size_t length,void **file_contents_ptr,size_t *file_contents_length);
+extern int GCP_Client_Read_Write_Read_Parallel(char* bucket_name,char* filename,
+					       void **file_contents_ptr,size_t *file_contents_length);
 extern int GCP_Client_Read_Write_Write(char* bucket_name,char* filename,
 				       void *file_contents_ptr,size_t file_contents_length);
+extern int GCP_Client_Read_Write_Read_Operation(struct GCP_Client_Operation_Struct *operation,char* bucket_name,
+						char* filename,void **file_contents_ptr,size_t *file_contents_length);
+extern int GCP_Client_Read_Write_Write_Operation(struct GCP_Client_Operation_Struct *operation,char* bucket_name,
+						 char* filename,void *file_contents_ptr,size_t file_contents_length);
+extern void GCP_Client_Read_Write_Hedge_Set(int enable,double percentile,double max_extra_percent,size_t max_length);
+extern int GCP_Client_Read_Write_Hedge_Get_Stats(struct GCP_Client_Read_Write_Hedge_Stats_Struct *stats);
 	
 extern int GCP_Client_Read_Write_Get_Error_Number(void);
 extern void GCP_Client_Read_Write_Error(void);
@@ -0,0 +1,19 @@
+/* gcp_client_read_write_private.h */
+#ifndef GCP_CLIENT_READ_WRITE_PRIVATE_H
+#define GCP_CLIENT_READ_WRITE_PRIVATE_H
+
+#include <istream>
+#include "gcp_client_operation.h"
+
+/* c++ only header providing mangled c++ interfaces between c++ modules in the gcp_client library
+** This header cannot be included in C client programs, or the exposed functions called from C code */
+extern int GCP_Client_Read_Write_Read_Stream(std::istream &stream,char *bucket_name,char *filename,
+					     void **file_contents_ptr,size_t *file_contents_length,
+					     struct GCP_Client_Operation_Struct *operation,
+					     unsigned long long *budget_length);
+extern int GCP_Client_Read_Write_Read_Stream_Buffer(std::istream &stream,char *bucket_name,char *filename,
+						    size_t length_hint,void **buffer_ptr,size_t *buffer_length,
+						    struct GCP_Client_Operation_Struct *operation);
+
+
+#endif
@@ -0,0 +1,127 @@
+/* gcp_client_scheduler.h */
+#ifndef GCP_CLIENT_SCHEDULER_H
+#define GCP_CLIENT_SCHEDULER_H
+
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_operation.h"
+
+/* hash defines */
+/**
+ * The default number of worker threads (transfers run at once), if a worker count of 0 is passed to
+ * GCP_Client_Scheduler_Create.
+ */
+#define GCP_CLIENT_SCHEDULER_DEFAULT_WORKER_COUNT      (8)
+/**
+ * The maximum number of worker threads.
+ */
+#define GCP_CLIENT_SCHEDULER_MAX_WORKER_COUNT          (256)
+/**
+ * The maximum number of queues a scheduler can have.
+ */
+#define GCP_CLIENT_SCHEDULER_MAX_QUEUE_COUNT           (16)
+/**
+ * The length of a queue name, including the terminating NUL.
+ */
+#define GCP_CLIENT_SCHEDULER_QUEUE_NAME_LENGTH         (32)
+/**
+ * Job flag : the job can be paused (with GCP_Client_Operation_Pause) to let a higher priority job run, and is
+ * queued again to carry on later. Only set this for jobs whose transfer copes with being paused, for instance
+ * GCP_Client_Read_Write_Write_Operation, which resumes the upload where it stopped.
+ */
+#define GCP_CLIENT_SCHEDULER_FLAG_PREEMPTIBLE          (1<<0)
+
+/* data types */
+/**
+ * Opaque scheduler handle, created with GCP_Client_Scheduler_Create.
+ */
+struct GCP_Client_Scheduler_Struct;
+
+/**
+ * Type of the function the scheduler calls to run a job. It is called from one of the scheduler's worker
+ * threads, whose bandwidth priority is set to the job's queue priority. The function should make it's transfer
+ * with the supplied operation (for instance with GCP_Client_Read_Write_Write_Operation), so the job can be
+ * cancelled, bounded by it's deadline and (if preemptible) paused. A preempted job's function is called again,
+ * with the same operation, when the job is next scheduled. It should return TRUE if the job succeeded, and FALSE
+ * if it failed.
+ */
+typedef int (*GCP_Client_Scheduler_Job_Function_T)(struct GCP_Client_Operation_Struct *operation,void *user_data);
+/**
+ * Type of the function called when a job has finished, with the job's id, the state it finished in (one of
+ * GCP_CLIENT_OPERATION_STATE_COMPLETED, FAILED, CANCELLED, DEADLINE_EXCEEDED or STALLED), and the user_data
+ * passed to GCP_Client_Scheduler_Submit. It is called from a worker thread, or from the thread cancelling
+ * a queued job.
+ */
+typedef void (*GCP_Client_Scheduler_Done_Function_T)(unsigned long long job_id,int state,void *user_data);
+
+/**
+ * Structure holding the statistics of one scheduler queue. This consists of the following:
+ * <dl>
+ * <dt>Name</dt> <dd>The name of the queue.</dd>
+ * <dt>Priority</dt> <dd>The queue's priority class (GCP_CLIENT_BANDWIDTH_PRIORITY_*).</dd>
+ * <dt>Weight</dt> <dd>The queue's share of the workers, relative to other queues of the same priority.</dd>
+ * <dt>Queued_Count</dt> <dd>The number of jobs waiting to run now.</dd>
+ * <dt>Running_Count</dt> <dd>The number of jobs running now.</dd>
+ * <dt>Submitted_Count</dt> <dd>The number of jobs submitted to the queue.</dd>
+ * <dt>Completed_Count</dt> <dd>The number of jobs that succeeded.</dd>
+ * <dt>Failed_Count</dt> <dd>The number of jobs that failed (not including those cancelled or that missed their
+ *     deadline).</dd>
+ * <dt>Cancelled_Count</dt> <dd>The number of jobs cancelled.</dd>
+ * <dt>Deadline_Missed_Count</dt> <dd>The number of jobs that missed their deadline, either waiting or running.</dd>
+ * <dt>Preempted_Count</dt> <dd>The number of times a job was paused to let a higher priority job run.</dd>
+ * <dt>Start_Count</dt> <dd>The number of times a job was started (or restarted after being preempted).</dd>
+ * <dt>Wait_Time_Mean</dt> <dd>The mean time jobs waited in the queue before (re)starting, in seconds.</dd>
+ * <dt>Wait_Time_Max</dt> <dd>The longest time a job waited in the queue before (re)starting, in seconds.</dd>
+ * <dt>Oldest_Wait_Time</dt> <dd>How long the job that has been waiting longest has waited so far, in seconds.</dd>
+ * <dt>Run_Time</dt> <dd>The total time the queue's jobs have spent running, in seconds.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_SCHEDULER_QUEUE_NAME_LENGTH
+ */
+struct GCP_Client_Scheduler_Queue_Stats_Struct
+{
+	char Name[GCP_CLIENT_SCHEDULER_QUEUE_NAME_LENGTH];
+	int Priority;
+	int Weight;
+	int Queued_Count;
+	int Running_Count;
+	unsigned long long Submitted_Count;
+	unsigned long long Completed_Count;
+	unsigned long long Failed_Count;
+	unsigned long long Cancelled_Count;
+	unsigned long long Deadline_Missed_Count;
+	unsigned long long Preempted_Count;
+	unsigned long long Start_Count;
+	double Wait_Time_Mean;
+	double Wait_Time_Max;
+	double Oldest_Wait_Time;
+	double Run_Time;
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Scheduler_Create(struct GCP_Client_Scheduler_Struct **scheduler,int worker_count,
+				       int bucket_concurrency);
+extern int GCP_Client_Scheduler_Add_Queue(struct GCP_Client_Scheduler_Struct *scheduler,const char *name,
+					  int priority,int weight,int *queue_index);
+extern int GCP_Client_Scheduler_Submit(struct GCP_Client_Scheduler_Struct *scheduler,int queue_index,
+				       const char *bucket_name,int flags,int deadline_ms,
+				       GCP_Client_Scheduler_Job_Function_T job_fn,
+				       GCP_Client_Scheduler_Done_Function_T done_fn,void *user_data,
+				       unsigned long long *job_id);
+extern int GCP_Client_Scheduler_Cancel(struct GCP_Client_Scheduler_Struct *scheduler,unsigned long long job_id);
+extern int GCP_Client_Scheduler_Wait(struct GCP_Client_Scheduler_Struct *scheduler);
+extern int GCP_Client_Scheduler_Get_Queue_Stats(struct GCP_Client_Scheduler_Struct *scheduler,int queue_index,
+						struct GCP_Client_Scheduler_Queue_Stats_Struct *stats);
+extern int GCP_Client_Scheduler_Destroy(struct GCP_Client_Scheduler_Struct *scheduler);
+
+extern int GCP_Client_Scheduler_Get_Error_Number(void);
+extern void GCP_Client_Scheduler_Error(void);
+extern void GCP_Client_Scheduler_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+/* gcp_client_stats.h */
+#ifndef GCP_CLIENT_STATS_H
+#define GCP_CLIENT_STATS_H
+
+#include <stddef.h>
+#include <time.h>
+
+/* hash defines */
+/**
+ * Statistics operation index for object reads (GCP_Client_Read_Write_Read).
+ */
+#define GCP_CLIENT_STATS_OPERATION_READ                (0)
+/**
+ * Statistics operation index for object writes (GCP_Client_Read_Write_Write).
+ */
+#define GCP_CLIENT_STATS_OPERATION_WRITE               (1)
+/**
+ * Statistics operation index for opening client connections (GCP_Client_Connection_Open).
+ */
+#define GCP_CLIENT_STATS_OPERATION_OPEN                (2)
+/**
+ * Statistics operation index for object metadata operations.
+ */
+#define GCP_CLIENT_STATS_OPERATION_METADATA            (3)
+/**
+ * Statistics operation index for object listings (GCP_Client_List).
+ */
+#define GCP_CLIENT_STATS_OPERATION_LIST                (4)
+/**
+ * Statistics operation index for server-side object copies and rewrites (GCP_Client_Copy, GCP_Client_Rewrite).
+ */
+#define GCP_CLIENT_STATS_OPERATION_COPY                (5)
+/**
+ * Statistics operation index for object deletes (GCP_Client_Delete).
+ */
+#define GCP_CLIENT_STATS_OPERATION_DELETE              (6)
+/**
+ * The number of operations statistics are kept for.
+ */
+#define GCP_CLIENT_STATS_OPERATION_COUNT               (7)
+/**
+ * The number of bits of sub-bucket resolution in each power of two range of a histogram.
+ * Histogram values are accurate to 1 part in 2^GCP_CLIENT_STATS_HISTOGRAM_SUB_BUCKET_BITS (about 6%).
+ */
+#define GCP_CLIENT_STATS_HISTOGRAM_SUB_BUCKET_BITS     (4)
+/**
+ * The number of buckets in a histogram. Values 0..15 have their own bucket, and each power of two range
+ * above that up to 2^43 is split into 16 sub-buckets. Larger values are counted in the last bucket.
+ */
+#define GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT        (640)
+
+/* data types */
+/**
+ * Structure holding the statistics for one type of operation. This consists of the following:
+ * <dl>
+ * <dt>Count</dt> <dd>The number of operations completed (successfully or not).</dd>
+ * <dt>Error_Count</dt> <dd>The number of operations that failed.</dd>
+ * <dt>Retry_Count</dt> <dd>The number of times the library re-issued part or all of an operation.</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes transferred by the operations.</dd>
+ * <dt>Total_Latency_US</dt> <dd>The sum of the operation latencies, in microseconds.</dd>
+ * <dt>Max_Latency_US</dt> <dd>The largest operation latency, in microseconds.</dd>
+ * <dt>Latency_Histogram</dt> <dd>A log-linear histogram of operation latency, in microseconds.</dd>
+ * <dt>Throughput_Histogram</dt> <dd>A log-linear histogram of operation throughput, in bytes per second,
+ *     for operations that transferred data.</dd>
+ * </dl>
+ * @see #GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT
+ */
+struct GCP_Client_Stats_Operation_Struct
+{
+	unsigned long long Count;
+	unsigned long long Error_Count;
+	unsigned long long Retry_Count;
+	unsigned long long Byte_Count;
+	unsigned long long Total_Latency_US;
+	unsigned long long Max_Latency_US;
+	unsigned long long Latency_Histogram[GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT];
+	unsigned long long Throughput_Histogram[GCP_CLIENT_STATS_HISTOGRAM_BUCKET_COUNT];
+};
+
+/**
+ * Structure holding the library statistics, one GCP_Client_Stats_Operation_Struct per operation type,
+ * indexed by GCP_CLIENT_STATS_OPERATION_*.
+ * @see #GCP_Client_Stats_Operation_Struct
+ * @see #GCP_CLIENT_STATS_OPERATION_COUNT
+ */
+struct GCP_Client_Stats_Struct
+{
+	struct GCP_Client_Stats_Operation_Struct Operation_List[GCP_CLIENT_STATS_OPERATION_COUNT];
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Stats_Get(struct GCP_Client_Stats_Struct *stats);
+extern void GCP_Client_Stats_Reset(void);
+extern void GCP_Client_Stats_Record(int operation,struct timespec start_time,size_t byte_count,int success);
+extern void GCP_Client_Stats_Record_Retry(int operation);
+extern unsigned long long GCP_Client_Stats_Histogram_Percentile(const unsigned long long *histogram,double percentile);
+extern const char *GCP_Client_Stats_Operation_Name(int operation);
+
+extern int GCP_Client_Stats_Get_Error_Number(void);
+extern void GCP_Client_Stats_Error(void);
+extern void GCP_Client_Stats_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/* gcp_client_sync.h */
+#ifndef GCP_CLIENT_SYNC_H
+#define GCP_CLIENT_SYNC_H
+
+/* hash defines */
+/**
+ * Sync flag : compare and report only, do not upload anything.
+ */
+#define GCP_CLIENT_SYNC_FLAG_DRY_RUN                   (1<<0)
+/**
+ * Sync flag : compare the CRC32C checksum of files whose size and modification time match the remote object too,
+ * rather than assuming they are unchanged.
+ */
+#define GCP_CLIENT_SYNC_FLAG_CHECKSUM                  (1<<1)
+/**
+ * Sync action : the local file is the same as the remote object, and is not uploaded.
+ */
+#define GCP_CLIENT_SYNC_ACTION_UNCHANGED               (0)
+/**
+ * Sync action : the local file has no remote object, and is uploaded.
+ */
+#define GCP_CLIENT_SYNC_ACTION_NEW                     (1)
+/**
+ * Sync action : the local file differs from the remote object, and is uploaded.
+ */
+#define GCP_CLIENT_SYNC_ACTION_CHANGED                 (2)
+/**
+ * Sync action : the remote object has no local file. It is left alone.
+ */
+#define GCP_CLIENT_SYNC_ACTION_REMOTE_ONLY             (3)
+/**
+ * Sync action : the local file failed to be checked or uploaded.
+ */
+#define GCP_CLIENT_SYNC_ACTION_FAILED                  (4)
+/**
+ * The name of the object custom metadata key the local file's modification time (in seconds since the epoch)
+ * is stored in. This is the key gsutil rsync uses, so objects uploaded by either can be compared by the other.
+ */
+#define GCP_CLIENT_SYNC_MTIME_METADATA_KEY             "goog-reserved-file-mtime"
+
+/* data types */
+/**
+ * Type of the function called by GCP_Client_Sync as it decides what to do with each file / object. It is passed
+ * the local filename (NULL for a remote only object), the object name, the action (GCP_CLIENT_SYNC_ACTION_NEW
+ * etc), the size of the file (or object) in bytes, and the user_data pointer passed to GCP_Client_Sync.
+ * Calls are serialised, but may be made from the sync's transfer threads.
+ */
+typedef void (*GCP_Client_Sync_Callback_T)(const char *local_filename,const char *object_name,int action,
+					   unsigned long long size,void *user_data);
+
+/**
+ * Structure returning the results of a sync. This consists of the following:
+ * <dl>
+ * <dt>Local_File_Count</dt> <dd>The number of local files found.</dd>
+ * <dt>Remote_Object_Count</dt> <dd>The number of remote objects listed.</dd>
+ * <dt>Unchanged_Count</dt> <dd>The number of local files that were the same as their remote object.</dd>
+ * <dt>New_Count</dt> <dd>The number of local files with no remote object.</dd>
+ * <dt>Changed_Count</dt> <dd>The number of local files that differed from their remote object.</dd>
+ * <dt>Remote_Only_Count</dt> <dd>The number of remote objects with no local file.</dd>
+ * <dt>Checksum_Count</dt> <dd>The number of local files whose CRC32C checksum had to be computed.</dd>
+ * <dt>Failed_Count</dt> <dd>The number of local files that failed to be checked or uploaded.</dd>
+ * <dt>Transfer_Byte_Count</dt> <dd>The number of bytes in the new and changed files
+ *     (uploaded, unless a dry run).</dd>
+ * <dt>Elapsed_Time</dt> <dd>The elapsed time of the sync, in seconds.</dd>
+ * </dl>
+ */
+struct GCP_Client_Sync_Stats_Struct
+{
+	unsigned long long Local_File_Count;
+	unsigned long long Remote_Object_Count;
+	unsigned long long Unchanged_Count;
+	unsigned long long New_Count;
+	unsigned long long Changed_Count;
+	unsigned long long Remote_Only_Count;
+	unsigned long long Checksum_Count;
+	unsigned long long Failed_Count;
+	unsigned long long Transfer_Byte_Count;
+	double Elapsed_Time;
+};
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Sync(char *local_directory,char *bucket_name,char *prefix,int concurrency,int flags,
+			   GCP_Client_Sync_Callback_T callback,void *user_data,
+			   struct GCP_Client_Sync_Stats_Struct *stats);
+extern int GCP_Client_Sync_File_CRC32C(char *filename,unsigned int *crc32c);
+extern int GCP_Client_Sync_Upload_File(char *local_filename,char *bucket_name,char *object_name,
+				       unsigned long long *byte_count);
+
+extern int GCP_Client_Sync_Get_Error_Number(void);
+extern void GCP_Client_Sync_Error(void);
+extern void GCP_Client_Sync_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
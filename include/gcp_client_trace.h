@@ -0,0 +1,36 @@
+/* gcp_client_trace.h */
+#ifndef GCP_CLIENT_TRACE_H
+#define GCP_CLIENT_TRACE_H
+
+#include <stddef.h>
+#include <time.h>
+
+/* hash defines */
+/**
+ * The default number of spans held in the trace buffer. When the buffer is full the oldest spans are overwritten.
+ */
+#define GCP_CLIENT_TRACE_DEFAULT_SPAN_COUNT            (65536)
+
+/*  the following 3 lines are needed to support C++ compilers */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int GCP_Client_Trace_Start(int span_count);
+extern void GCP_Client_Trace_Stop(void);
+extern int GCP_Client_Trace_Is_Enabled(void);
+extern void GCP_Client_Trace_Span_Begin(struct timespec *start_time);
+extern void GCP_Client_Trace_Span_End(const char *name,const char *bucket_name,const char *object_name,
+				      struct timespec *start_time,size_t byte_count,int success);
+extern int GCP_Client_Trace_Dump(const char *filename);
+extern void GCP_Client_Trace_Clear(void);
+
+extern int GCP_Client_Trace_Get_Error_Number(void);
+extern void GCP_Client_Trace_Error(void);
+extern void GCP_Client_Trace_Error_String(char *error_string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,336 @@
+/* test_async.cpp
+*/
+/**
+ * Test the future / coroutine interface in gcp_client.hpp, e.g. test_async -bucket test-bucket -object async.dat.
+ * A test object is written with Write_Async, then read back with Read_Async (a future) and, when the program is
+ * built with C++20 (test_async_cpp20), with co_await Read_Co in a coroutine. Each read is compared with the bytes
+ * written. The Makefile builds this source twice, with -std=c++11 (futures only) and with -std=c++20.
+ * Normally run against a local storage emulator.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <future>
+#include <string>
+#include <vector>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_connection.h"
+#include "gcp_client.hpp"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH           (256)
+/**
+ * The default length of the test object, in bytes.
+ */
+#define DEFAULT_OBJECT_LENGTH   (1024*1024)
+
+/**
+ * Verbosity log level : initialised to 0 (no library logging).
+ */
+static int Log_Level = 0;
+/**
+ * The name of the google cloud storage bucket to write the test object to.
+ */
+static char Bucket_Name[STRING_LENGTH];
+/**
+ * The name of the test object.
+ */
+static char Object_Name[STRING_LENGTH] = "test_async.dat";
+/**
+ * The storage emulator endpoint URL (e.g. http://localhost:9000), or an empty string to use google cloud storage.
+ */
+static char Endpoint[STRING_LENGTH] = "";
+/**
+ * The length of the test object, in bytes.
+ */
+static size_t Object_Length = DEFAULT_OBJECT_LENGTH;
+
+static int Check_Data(const char *test_name,const std::vector<char> &data,const gcp_client::Object_Data &object_data);
+#ifdef GCP_CLIENT_HPP_COROUTINES
+/**
+ * Minimal coroutine return type for Coroutine_Read. The coroutine starts at once and runs to completion on the
+ * executor's thread, reporting it's result through a std::promise rather than this object.
+ */
+struct Test_Task
+{
+	struct promise_type
+	{
+		Test_Task get_return_object(void) { return Test_Task(); }
+		std::suspend_never initial_suspend(void) noexcept { return {}; }
+		std::suspend_never final_suspend(void) noexcept { return {}; }
+		void return_void(void) {}
+		void unhandled_exception(void) { std::terminate(); }
+	};
+};
+static Test_Task Coroutine_Read(const std::vector<char> &data,std::promise<int> &result);
+#endif
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>If an emulator endpoint was specified, we set the CLOUD_STORAGE_EMULATOR_ENDPOINT environment variable.
+ * <li>We connect to the google cloud by calling GCP_Client_Connection_Open.
+ * <li>We fill Object_Length bytes with a test pattern, and write them to the test object with Write_Async.
+ * <li>We read the object back with Read_Async, waiting on the future, and check the bytes with Check_Data.
+ * <li>If coroutines are supported, we read the object with co_await Read_Co in Coroutine_Read, and wait for it's
+ *     result.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @see #Parse_Arguments
+ * @see #Check_Data
+ * @see #Coroutine_Read
+ * @see #Bucket_Name
+ * @see #Object_Name
+ * @see #Object_Length
+ * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
+ */
+int main(int argc, char *argv[])
+{
+	std::vector<char> data;
+	size_t i;
+
+	fprintf(stderr,"test_async : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	if(strlen(Bucket_Name) == 0)
+	{
+		fprintf(stderr,"test_async : No bucket specified.\n");
+		return 1;
+	}
+	if(Log_Level > 0)
+	{
+		GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+		GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+		GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+	}
+	if(strlen(Endpoint) > 0)
+	{
+		fprintf(stderr,"test_async : Using emulator endpoint '%s'.\n",Endpoint);
+		setenv("CLOUD_STORAGE_EMULATOR_ENDPOINT",Endpoint,1);
+	}
+	fprintf(stderr,"test_async : Opening client connection.\n");
+	if(!GCP_Client_Connection_Open())
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	data.resize(Object_Length);
+	for(i = 0; i < Object_Length; i++)
+		data[i] = (char)((i*31)+(i>>8));
+	try
+	{
+		fprintf(stderr,"test_async : Writing %lu bytes to '%s' in bucket '%s'.\n",Object_Length,Object_Name,
+			Bucket_Name);
+		gcp_client::Write_Async(Bucket_Name,Object_Name,data.data(),data.size()).get();
+		fprintf(stderr,"test_async : Reading '%s' with Read_Async.\n",Object_Name);
+		gcp_client::Object_Data object_data = gcp_client::Read_Async(Bucket_Name,Object_Name).get();
+		if(!Check_Data("Read_Async",data,object_data))
+			return 3;
+	}
+	catch(const gcp_client::Error &error)
+	{
+		fprintf(stderr,"test_async : Failed with error %d : %s\n",error.Error_Number(),error.what());
+		return 3;
+	}
+#ifdef GCP_CLIENT_HPP_COROUTINES
+	std::promise<int> result;
+	std::future<int> result_future = result.get_future();
+
+	fprintf(stderr,"test_async : Reading '%s' with co_await Read_Co.\n",Object_Name);
+	Coroutine_Read(data,result);
+	if(!result_future.get())
+		return 4;
+#else
+	fprintf(stderr,"test_async : Coroutines not supported by this build, co_await read not tested.\n");
+#endif
+	fprintf(stderr,"test_async : finished.\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Check the bytes read from the test object are the bytes written.
+ * @param test_name The name of the read tested, printed in the result.
+ * @param data The bytes written.
+ * @param object_data The bytes read.
+ * @return TRUE if they match, FALSE if they don't.
+ */
+static int Check_Data(const char *test_name,const std::vector<char> &data,const gcp_client::Object_Data &object_data)
+{
+	if(object_data.Length() != data.size())
+	{
+		fprintf(stderr,"test_async : %s read %lu bytes, expected %lu.\n",test_name,object_data.Length(),
+			data.size());
+		return FALSE;
+	}
+	if((data.size() > 0)&&(memcmp(object_data.Data(),data.data(),data.size()) != 0))
+	{
+		fprintf(stderr,"test_async : %s read different bytes to those written.\n",test_name);
+		return FALSE;
+	}
+	fprintf(stderr,"test_async : %s read %lu bytes OK.\n",test_name,object_data.Length());
+	return TRUE;
+}
+
+#ifdef GCP_CLIENT_HPP_COROUTINES
+/**
+ * Coroutine reading the test object with co_await Read_Co, and checking it with Check_Data.
+ * @param data The bytes written.
+ * @param result A promise set to TRUE if the read succeeded and matched, FALSE otherwise.
+ * @see #Check_Data
+ */
+static Test_Task Coroutine_Read(const std::vector<char> &data,std::promise<int> &result)
+{
+	try
+	{
+		gcp_client::Object_Data object_data = co_await gcp_client::Read_Co(Bucket_Name,Object_Name);
+
+		result.set_value(Check_Data("Read_Co",data,object_data));
+	}
+	catch(const gcp_client::Error &error)
+	{
+		fprintf(stderr,"test_async : Read_Co failed with error %d : %s\n",error.Error_Number(),error.what());
+		result.set_value(FALSE);
+	}
+}
+#endif
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #Bucket_Name
+ * @see #Object_Name
+ * @see #Object_Length
+ * @see #Endpoint
+ * @see #Log_Level
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Bucket_Name,argv[i+1],STRING_LENGTH);
+				Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-e")==0)||(strcmp(argv[i],"-endpoint")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Endpoint,argv[i+1],STRING_LENGTH);
+				Endpoint[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-endpoint requires an emulator URL.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-length")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%lu",&Object_Length);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse length %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-length requires a number of bytes.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-o")==0)||(strcmp(argv[i],"-object")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Object_Name,argv[i+1],STRING_LENGTH);
+				Object_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-object requires an object name.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test Async:Help.\n");
+	fprintf(stdout,"This program writes a test object, and reads it back with the gcp_client.hpp future and\n");
+	fprintf(stdout,"\tcoroutine interfaces (coroutines only in the C++20 build, test_async_cpp20).\n");
+	fprintf(stdout,"test_async -b[ucket] <bucket name> [-o[bject] <object name>][-length <bytes>]\n");
+	fprintf(stdout,"\t[-e[ndpoint] <url>][-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\t-bucket selects which google cloud bucket to use.\n");
+	fprintf(stdout,"\t-object sets the name of the test object (default test_async.dat), which is overwritten.\n");
+	fprintf(stdout,"\t-length sets the length of the test object in bytes (default %d).\n",DEFAULT_OBJECT_LENGTH);
+	fprintf(stdout,"\t-endpoint sets a storage emulator URL (CLOUD_STORAGE_EMULATOR_ENDPOINT).\n");
+}
@@ -0,0 +1,1385 @@
+/* test_benchmark.c
+*/
+/**
+ * Throughput benchmark for the gcp_client library. A matrix of object sizes, concurrency levels and API modes
+ * (write, read, read_pooled, read_hedged, read_parallel, read_completions) is run, normally against a local storage emulator. For each combination the throughput
+ * (MB/s, ops/s), latency percentiles (p50/p95/p99, from the library statistics histograms), CPU time, peak resident
+ * set size and minor page faults are reported as CSV or JSON. The results can be compared against a previous CSV run, to catch performance
+ * regressions between library versions.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_connection.h"
+#include "gcp_client_adaptive.h"
+#include "gcp_client_budget.h"
+#include "gcp_client_buffer.h"
+#include "gcp_client_completions.h"
+#include "gcp_client_read_write.h"
+#include "gcp_client_stats.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH           (256)
+/**
+ * The maximum number of entries in the size, concurrency and mode lists.
+ */
+#define MAX_LIST_COUNT          (32)
+/**
+ * The maximum number of results (combinations) that can be benchmarked or loaded from a baseline file.
+ */
+#define MAX_RESULT_COUNT        (1024)
+/**
+ * Benchmark mode : write objects using GCP_Client_Read_Write_Write.
+ */
+#define MODE_WRITE              (0)
+/**
+ * Benchmark mode : read objects using GCP_Client_Read_Write_Read.
+ */
+#define MODE_READ               (1)
+/**
+ * Benchmark mode : read objects into pool buffers using GCP_Client_Read_Write_Read_Buffer.
+ */
+#define MODE_READ_POOLED        (2)
+/**
+ * Benchmark mode : read objects using GCP_Client_Read_Write_Read, with hedged reads enabled.
+ */
+#define MODE_READ_HEDGED        (3)
+/**
+ * Benchmark mode : read objects as adaptively sized ranged parts in parallel, using
+ * GCP_Client_Read_Write_Read_Parallel.
+ */
+#define MODE_READ_PARALLEL      (4)
+/**
+ * Benchmark mode : read objects from a single poll loop, using a GCP_Client_Completions queue with a transfer
+ * thread per concurrent read.
+ */
+#define MODE_READ_COMPLETIONS   (5)
+/**
+ * Output format : comma separated values, one line per combination after a header line.
+ */
+#define OUTPUT_FORMAT_CSV       (0)
+/**
+ * Output format : a JSON object containing a list of results.
+ */
+#define OUTPUT_FORMAT_JSON      (1)
+/**
+ * The header line written at the start of CSV output. The column order must match Print_Result_CSV and
+ * Load_Baseline.
+ */
+#define CSV_HEADER "mode,size_bytes,concurrency,operations,errors,elapsed_s,mb_per_s,ops_per_s,p50_ms,p95_ms,p99_ms,"\
+	"cpu_user_s,cpu_system_s,max_rss_kb,minor_faults"
+
+/**
+ * Structure holding the results of benchmarking one combination of mode, object size and concurrency.
+ * <dl>
+ * <dt>Mode</dt> <dd>The API mode benchmarked, MODE_WRITE, MODE_READ, MODE_READ_POOLED, MODE_READ_HEDGED,
+ * MODE_READ_PARALLEL or MODE_READ_COMPLETIONS.</dd>
+ * <dt>Size</dt> <dd>The object size, in bytes.</dd>
+ * <dt>Concurrency</dt> <dd>The number of threads transferring objects at once.</dd>
+ * <dt>Operation_Count</dt> <dd>The number of transfers attempted.</dd>
+ * <dt>Error_Count</dt> <dd>The number of transfers that failed.</dd>
+ * <dt>Elapsed</dt> <dd>The wall clock time taken, in seconds.</dd>
+ * <dt>MB_Per_S</dt> <dd>Successfully transferred megabytes (10^6 bytes) per second.</dd>
+ * <dt>Ops_Per_S</dt> <dd>Successful transfers per second.</dd>
+ * <dt>P50_MS</dt> <dd>The median transfer latency, in milliseconds.</dd>
+ * <dt>P95_MS</dt> <dd>The 95th percentile transfer latency, in milliseconds.</dd>
+ * <dt>P99_MS</dt> <dd>The 99th percentile transfer latency, in milliseconds.</dd>
+ * <dt>CPU_User_S</dt> <dd>The user CPU time used by the process whilst benchmarking, in seconds.</dd>
+ * <dt>CPU_System_S</dt> <dd>The system CPU time used by the process whilst benchmarking, in seconds.</dd>
+ * <dt>Max_RSS_KB</dt> <dd>The peak resident set size of the process so far, in kilobytes.</dd>
+ * <dt>Minor_Faults</dt> <dd>The number of minor page faults (pages faulted in without I/O, e.g. newly allocated
+ *     memory) the process took whilst benchmarking.</dd>
+ * </dl>
+ */
+struct Benchmark_Result_Struct
+{
+	int Mode;
+	size_t Size;
+	int Concurrency;
+	int Operation_Count;
+	int Error_Count;
+	double Elapsed;
+	double MB_Per_S;
+	double Ops_Per_S;
+	double P50_MS;
+	double P95_MS;
+	double P99_MS;
+	double CPU_User_S;
+	double CPU_System_S;
+	long Max_RSS_KB;
+	long Minor_Faults;
+};
+
+/**
+ * Structure holding the arguments and results of one benchmark thread.
+ * <dl>
+ * <dt>Mode</dt> <dd>The API mode to benchmark, MODE_WRITE, MODE_READ, MODE_READ_POOLED, MODE_READ_HEDGED,
+ * MODE_READ_PARALLEL or MODE_READ_COMPLETIONS.</dd>
+ * <dt>Thread_Index</dt> <dd>The index of the thread, used to construct the object name.</dd>
+ * <dt>Size</dt> <dd>The object size, in bytes.</dd>
+ * <dt>Buffer</dt> <dd>The data to write, Size bytes long (shared between threads, and only read).</dd>
+ * <dt>Operation_Count</dt> <dd>The number of transfers performed.</dd>
+ * <dt>Error_Count</dt> <dd>The number of transfers that failed.</dd>
+ * </dl>
+ */
+struct Benchmark_Thread_Struct
+{
+	int Mode;
+	int Thread_Index;
+	size_t Size;
+	void *Buffer;
+	int Operation_Count;
+	int Error_Count;
+};
+
+/**
+ * Verbosity log level : initialised to 0 (no library logging whilst benchmarking).
+ */
+static int Log_Level = 0;
+/**
+ * The name of the google cloud storage bucket to benchmark against.
+ */
+static char Bucket_Name[STRING_LENGTH];
+/**
+ * The storage emulator endpoint URL (e.g. http://localhost:9000), or an empty string to use google cloud storage.
+ */
+static char Endpoint[STRING_LENGTH] = "";
+/**
+ * The prefix of the object names created by the benchmark.
+ */
+static char Object_Prefix[STRING_LENGTH] = "gcp_client_benchmark";
+/**
+ * The list of object sizes to benchmark, in bytes.
+ */
+static size_t Size_List[MAX_LIST_COUNT];
+/**
+ * The number of object sizes in Size_List.
+ */
+static int Size_Count = 0;
+/**
+ * The list of concurrency levels (numbers of threads) to benchmark.
+ */
+static int Concurrency_List[MAX_LIST_COUNT];
+/**
+ * The number of concurrency levels in Concurrency_List.
+ */
+static int Concurrency_Count = 0;
+/**
+ * The list of API modes to benchmark.
+ */
+static int Mode_List[MAX_LIST_COUNT];
+/**
+ * The number of API modes in Mode_List.
+ */
+static int Mode_Count = 0;
+/**
+ * The number of transfers each thread performs for each combination.
+ */
+static int Iteration_Count = 10;
+/**
+ * Combinations where object size multiplied by concurrency exceeds this number of bytes are skipped,
+ * as reads hold a copy of each object in memory per thread.
+ */
+static size_t Max_Memory = 4LL*1024LL*1024LL*1024LL;
+/**
+ * The library memory budget to set, in bytes, or 0 for no budget. When a budget is set, combinations are not
+ * skipped for exceeding Max_Memory, as reads wait for the budget instead.
+ */
+static unsigned long long Budget = 0;
+/**
+ * The output format, OUTPUT_FORMAT_CSV or OUTPUT_FORMAT_JSON.
+ */
+static int Output_Format = OUTPUT_FORMAT_CSV;
+/**
+ * The filename to write results to, or an empty string to write them to stdout.
+ */
+static char Output_Filename[STRING_LENGTH] = "";
+/**
+ * The filename of a previous CSV output to compare the results against, or an empty string for no comparison.
+ */
+static char Baseline_Filename[STRING_LENGTH] = "";
+/**
+ * The percentage a combination's throughput can drop by (or it's p99 latency rise by) compared with the baseline,
+ * before it is reported as a regression.
+ */
+static double Regression_Threshold = 10.0;
+/**
+ * The list of benchmark results.
+ */
+static struct Benchmark_Result_Struct Result_List[MAX_RESULT_COUNT];
+/**
+ * The number of results in Result_List.
+ */
+static int Result_Count = 0;
+
+static int Run_Combination(int mode,size_t size,int concurrency,void *buffer,struct Benchmark_Result_Struct *result);
+static void *Benchmark_Thread(void *arg);
+static int Run_Completions(size_t size,int concurrency,struct Benchmark_Thread_Struct *thread_data_list);
+static void Get_Object_Name(size_t size,int thread_index,char *object_name);
+static int Write_Results(void);
+static void Print_Result_CSV(FILE *fp,struct Benchmark_Result_Struct *result);
+static void Print_Result_JSON(FILE *fp,struct Benchmark_Result_Struct *result);
+static int Compare_Baseline(int *regression_count);
+static int Load_Baseline(char *filename,struct Benchmark_Result_Struct *baseline_list,int *baseline_count);
+static const char *Mode_To_String(int mode);
+static int Parse_Size_List(char *string);
+static int Parse_Concurrency_List(char *string);
+static int Parse_Mode_List(char *string);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments, and fill in default size/concurrency/mode lists.
+ * <li>If an emulator endpoint was specified, we set the CLOUD_STORAGE_EMULATOR_ENDPOINT environment variable,
+ *     which google-cloud-cpp uses to redirect requests (with anonymous credentials).
+ * <li>If a memory budget was specified, we set it with GCP_Client_Budget_Set_Limit.
+ * <li>We connect by calling GCP_Client_Connection_Open.
+ * <li>For each object size we allocate and fill a buffer, and for each mode and concurrency level
+ *     call Run_Combination.
+ * <li>If a memory budget was specified, we report it's high water mark and waits.
+ * <li>We write the results (Write_Results).
+ * <li>If a baseline file was specified, we compare the results against it (Compare_Baseline).
+ * </ul>
+ * Progress messages are written to stderr, so CSV/JSON results written to stdout can be redirected.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return The program returns 0 on success, 6 if a regression against the baseline was found, and
+ *         other non-zero values on failure.
+ * @see #Parse_Arguments
+ * @see #Run_Combination
+ * @see #Write_Results
+ * @see #Compare_Baseline
+ * @see ../cdocs/gcp_client_budget.html#GCP_Client_Budget_Set_Limit
+ * @see ../cdocs/gcp_client_budget.html#GCP_Client_Budget_Get_Stats
+ * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
+ */
+int main(int argc, char *argv[])
+{
+	struct GCP_Client_Budget_Stats_Struct budget_stats;
+	void *buffer = NULL;
+	size_t j;
+	int size_index,mode_index,concurrency_index,regression_count;
+
+	fprintf(stderr,"test_benchmark : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	if(strlen(Bucket_Name) == 0)
+	{
+		fprintf(stderr,"test_benchmark : No bucket specified.\n");
+		return 1;
+	}
+	if(Size_Count == 0)
+		Parse_Size_List((char*)"1k,64k,1m,16m,256m,1g");
+	if(Concurrency_Count == 0)
+		Parse_Concurrency_List((char*)"1,4,16");
+	if(Mode_Count == 0)
+		Parse_Mode_List((char*)"write,read");
+	if(Log_Level > 0)
+	{
+		GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+		GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+		GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+	}
+	if(strlen(Endpoint) > 0)
+	{
+		fprintf(stderr,"test_benchmark : Using emulator endpoint '%s'.\n",Endpoint);
+		setenv("CLOUD_STORAGE_EMULATOR_ENDPOINT",Endpoint,1);
+	}
+	if(Budget > 0)
+	{
+		fprintf(stderr,"test_benchmark : Setting memory budget to %llu bytes.\n",Budget);
+		GCP_Client_Budget_Set_Limit(Budget);
+	}
+	fprintf(stderr,"test_benchmark : Opening client connection.\n");
+	if(!GCP_Client_Connection_Open())
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	for(size_index = 0; size_index < Size_Count; size_index++)
+	{
+		buffer = malloc(Size_List[size_index]);
+		if(buffer == NULL)
+		{
+			fprintf(stderr,"test_benchmark : Failed to allocate %lu bytes.\n",
+				(unsigned long)Size_List[size_index]);
+			return 3;
+		}
+		for(j = 0; j < Size_List[size_index]; j++)
+			((unsigned char*)buffer)[j] = (unsigned char)((j*31)+7);
+		for(mode_index = 0; mode_index < Mode_Count; mode_index++)
+		{
+			for(concurrency_index = 0; concurrency_index < Concurrency_Count; concurrency_index++)
+			{
+				if((Budget == 0)&&((Size_List[size_index]*Concurrency_List[concurrency_index]) > Max_Memory))
+				{
+					fprintf(stderr,"test_benchmark : Skipping %s size %lu concurrency %d: "
+						"exceeds maximum memory %lu.\n",Mode_To_String(Mode_List[mode_index]),
+						(unsigned long)Size_List[size_index],Concurrency_List[concurrency_index],
+						(unsigned long)Max_Memory);
+					continue;
+				}
+				if(Result_Count >= MAX_RESULT_COUNT)
+				{
+					fprintf(stderr,"test_benchmark : Too many combinations (maximum %d).\n",
+						MAX_RESULT_COUNT);
+					return 3;
+				}
+				if(!Run_Combination(Mode_List[mode_index],Size_List[size_index],
+						    Concurrency_List[concurrency_index],buffer,&(Result_List[Result_Count])))
+				{
+					free(buffer);
+					return 4;
+				}
+				Result_Count++;
+			}
+		}
+		free(buffer);
+	}
+	if(Budget > 0)
+	{
+		GCP_Client_Budget_Get_Stats(&budget_stats);
+		fprintf(stderr,"test_benchmark : Memory budget high water %llu of %llu bytes, %llu reservations waited "
+			"(%.3f s in total), %llu granted over the limit.\n",budget_stats.High_Water,budget_stats.Limit,
+			budget_stats.Wait_Count,budget_stats.Wait_Time,budget_stats.Over_Limit_Count);
+	}
+	if(!Write_Results())
+		return 5;
+	if(strlen(Baseline_Filename) > 0)
+	{
+		if(!Compare_Baseline(&regression_count))
+			return 5;
+		if(regression_count > 0)
+		{
+			fprintf(stderr,"test_benchmark : %d regressions found against baseline '%s'.\n",
+				regression_count,Baseline_Filename);
+			return 6;
+		}
+		fprintf(stderr,"test_benchmark : No regressions found against baseline '%s'.\n",Baseline_Filename);
+	}
+	fprintf(stderr,"test_benchmark : finished.\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Benchmark one combination of mode, object size and concurrency.
+ * <ul>
+ * <li>In read mode, one object per thread is written first (untimed), so there is something to read.
+ * <li>In read_hedged mode, hedged reads are enabled for the combination (and their statistics reported after).
+ * <li>In read_parallel mode, the adaptive read controller is reset before the combination, and the part length
+ *     and parallelism it converged on are reported after.
+ * <li>The library statistics are reset, and the process resource usage retrieved.
+ * <li>concurrency Benchmark_Thread threads are started, each performing Iteration_Count transfers, and joined.
+ *     In read_completions mode, Run_Completions performs the same reads from this thread instead.
+ * <li>The elapsed time, resource usage and library statistics are used to fill in the result.
+ * </ul>
+ * @param mode The API mode to benchmark, MODE_WRITE, MODE_READ, MODE_READ_POOLED, MODE_READ_HEDGED,
+ * MODE_READ_PARALLEL or MODE_READ_COMPLETIONS.
+ * @param size The object size, in bytes.
+ * @param concurrency The number of threads to use.
+ * @param buffer A buffer of size bytes to write.
+ * @param result The address of a structure to fill in with the results.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Benchmark_Thread
+ * @see #Run_Completions
+ * @see #Get_Object_Name
+ * @see #Iteration_Count
+ * @see ../cdocs/gcp_client_stats.html#GCP_Client_Stats_Reset
+ * @see ../cdocs/gcp_client_stats.html#GCP_Client_Stats_Get
+ * @see ../cdocs/gcp_client_stats.html#GCP_Client_Stats_Histogram_Percentile
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Hedge_Set
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Hedge_Get_Stats
+ * @see ../cdocs/gcp_client_adaptive.html#GCP_Client_Adaptive_Reset
+ * @see ../cdocs/gcp_client_adaptive.html#GCP_Client_Adaptive_Get
+ */
+static int Run_Combination(int mode,size_t size,int concurrency,void *buffer,struct Benchmark_Result_Struct *result)
+{
+	struct Benchmark_Thread_Struct thread_data_list[MAX_LIST_COUNT*8];
+	pthread_t thread_list[MAX_LIST_COUNT*8];
+	struct GCP_Client_Stats_Struct stats;
+	struct GCP_Client_Read_Write_Hedge_Stats_Struct start_hedge_stats,end_hedge_stats;
+	struct GCP_Client_Stats_Operation_Struct *operation_stats = NULL;
+	struct rusage start_usage,end_usage;
+	struct timespec start_time,end_time;
+	char object_name[STRING_LENGTH];
+	size_t chunk_length;
+	int i,operation,parallelism;
+
+	if((concurrency < 1)||(concurrency > (MAX_LIST_COUNT*8)))
+	{
+		fprintf(stderr,"Run_Combination:Illegal concurrency %d.\n",concurrency);
+		return FALSE;
+	}
+	fprintf(stderr,"test_benchmark : Benchmarking %s size %lu concurrency %d.\n",Mode_To_String(mode),
+		(unsigned long)size,concurrency);
+	if((mode == MODE_READ)||(mode == MODE_READ_POOLED)||(mode == MODE_READ_HEDGED)||(mode == MODE_READ_PARALLEL)||
+	   (mode == MODE_READ_COMPLETIONS))
+	{
+		for(i = 0; i < concurrency; i++)
+		{
+			Get_Object_Name(size,i,object_name);
+			if(!GCP_Client_Read_Write_Write(Bucket_Name,object_name,buffer,size))
+			{
+				GCP_Client_General_Error();
+				return FALSE;
+			}
+		}
+		operation = GCP_CLIENT_STATS_OPERATION_READ;
+	}
+	else
+		operation = GCP_CLIENT_STATS_OPERATION_WRITE;
+	if(mode == MODE_READ_HEDGED)
+	{
+		GCP_Client_Read_Write_Hedge_Set(TRUE,GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_PERCENTILE,
+						GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_EXTRA_PERCENT,
+						GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_LENGTH);
+		GCP_Client_Read_Write_Hedge_Get_Stats(&start_hedge_stats);
+	}
+	if(mode == MODE_READ_PARALLEL)
+		GCP_Client_Adaptive_Reset(GCP_CLIENT_ADAPTIVE_DIRECTION_READ);
+	GCP_Client_Stats_Reset();
+	getrusage(RUSAGE_SELF,&start_usage);
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	for(i = 0; i < concurrency; i++)
+	{
+		thread_data_list[i].Mode = mode;
+		thread_data_list[i].Thread_Index = i;
+		thread_data_list[i].Size = size;
+		thread_data_list[i].Buffer = buffer;
+		thread_data_list[i].Operation_Count = 0;
+		thread_data_list[i].Error_Count = 0;
+		if(mode == MODE_READ_COMPLETIONS)
+			continue;
+		if(pthread_create(&(thread_list[i]),NULL,Benchmark_Thread,&(thread_data_list[i])) != 0)
+		{
+			fprintf(stderr,"Run_Combination:Failed to create thread %d.\n",i);
+			concurrency = i;
+			break;
+		}
+	}
+	if(mode == MODE_READ_COMPLETIONS)
+	{
+		if(!Run_Completions(size,concurrency,thread_data_list))
+			return FALSE;
+	}
+	else
+	{
+		for(i = 0; i < concurrency; i++)
+			pthread_join(thread_list[i],NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	getrusage(RUSAGE_SELF,&end_usage);
+	if(mode == MODE_READ_HEDGED)
+	{
+		GCP_Client_Read_Write_Hedge_Get_Stats(&end_hedge_stats);
+		GCP_Client_Read_Write_Hedge_Set(FALSE,GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_PERCENTILE,
+						GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_EXTRA_PERCENT,
+						GCP_CLIENT_READ_WRITE_HEDGE_DEFAULT_MAX_LENGTH);
+		fprintf(stderr,"test_benchmark : %llu reads, %llu hedged (%llu won by the hedge), %llu suppressed by the "
+			"cap, threshold %.3f ms.\n",end_hedge_stats.Read_Count-start_hedge_stats.Read_Count,
+			end_hedge_stats.Hedge_Count-start_hedge_stats.Hedge_Count,
+			end_hedge_stats.Hedge_Win_Count-start_hedge_stats.Hedge_Win_Count,
+			end_hedge_stats.Suppressed_Count-start_hedge_stats.Suppressed_Count,end_hedge_stats.Threshold);
+	}
+	if(mode == MODE_READ_PARALLEL)
+	{
+		GCP_Client_Adaptive_Get(GCP_CLIENT_ADAPTIVE_DIRECTION_READ,&chunk_length,&parallelism);
+		fprintf(stderr,"test_benchmark : Parallel reads finished with part length %lu bytes, %d parts at once.\n",
+			(unsigned long)chunk_length,parallelism);
+	}
+	if(!GCP_Client_Stats_Get(&stats))
+	{
+		GCP_Client_General_Error();
+		return FALSE;
+	}
+	operation_stats = &(stats.Operation_List[operation]);
+	result->Mode = mode;
+	result->Size = size;
+	result->Concurrency = concurrency;
+	result->Operation_Count = 0;
+	result->Error_Count = 0;
+	for(i = 0; i < concurrency; i++)
+	{
+		result->Operation_Count += thread_data_list[i].Operation_Count;
+		result->Error_Count += thread_data_list[i].Error_Count;
+	}
+	result->Elapsed = fdifftime(end_time,start_time);
+	if(result->Elapsed > 0.0)
+	{
+		result->MB_Per_S = ((double)operation_stats->Byte_Count)/(1000000.0*result->Elapsed);
+		result->Ops_Per_S = ((double)(result->Operation_Count-result->Error_Count))/result->Elapsed;
+	}
+	else
+	{
+		result->MB_Per_S = 0.0;
+		result->Ops_Per_S = 0.0;
+	}
+	result->P50_MS = ((double)GCP_Client_Stats_Histogram_Percentile(operation_stats->Latency_Histogram,50.0))/
+		((double)GCP_CLIENT_GENERAL_ONE_MILLISECOND_US);
+	result->P95_MS = ((double)GCP_Client_Stats_Histogram_Percentile(operation_stats->Latency_Histogram,95.0))/
+		((double)GCP_CLIENT_GENERAL_ONE_MILLISECOND_US);
+	result->P99_MS = ((double)GCP_Client_Stats_Histogram_Percentile(operation_stats->Latency_Histogram,99.0))/
+		((double)GCP_CLIENT_GENERAL_ONE_MILLISECOND_US);
+	result->CPU_User_S = ((double)(end_usage.ru_utime.tv_sec-start_usage.ru_utime.tv_sec))+
+		(((double)(end_usage.ru_utime.tv_usec-start_usage.ru_utime.tv_usec))/GCP_CLIENT_GENERAL_ONE_SECOND_US);
+	result->CPU_System_S = ((double)(end_usage.ru_stime.tv_sec-start_usage.ru_stime.tv_sec))+
+		(((double)(end_usage.ru_stime.tv_usec-start_usage.ru_stime.tv_usec))/GCP_CLIENT_GENERAL_ONE_SECOND_US);
+	result->Max_RSS_KB = end_usage.ru_maxrss;
+	result->Minor_Faults = end_usage.ru_minflt-start_usage.ru_minflt;
+	fprintf(stderr,"test_benchmark : %s size %lu concurrency %d: %.2f MB/s %.2f ops/s p99 %.3f ms errors %d "
+		"minor faults %ld.\n",Mode_To_String(mode),(unsigned long)size,concurrency,result->MB_Per_S,
+		result->Ops_Per_S,result->P99_MS,result->Error_Count,result->Minor_Faults);
+	return TRUE;
+}
+
+/**
+ * Benchmark thread. Performs Iteration_Count writes or reads of this thread's object.
+ * @param arg A pointer to this thread's Benchmark_Thread_Struct.
+ * @return The routine returns NULL.
+ * @see #Benchmark_Thread_Struct
+ * @see #Get_Object_Name
+ * @see #Iteration_Count
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Read
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Read_Buffer
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Write
+ * @see ../cdocs/gcp_client_buffer.html#GCP_Client_Buffer_Release
+ */
+static void *Benchmark_Thread(void *arg)
+{
+	struct Benchmark_Thread_Struct *thread_data = (struct Benchmark_Thread_Struct *)arg;
+	char object_name[STRING_LENGTH];
+	void *file_contents = NULL;
+	size_t file_contents_length;
+	int i,retval;
+
+	Get_Object_Name(thread_data->Size,thread_data->Thread_Index,object_name);
+	for(i = 0; i < Iteration_Count; i++)
+	{
+		if((thread_data->Mode == MODE_READ)||(thread_data->Mode == MODE_READ_POOLED)||
+		   (thread_data->Mode == MODE_READ_HEDGED)||(thread_data->Mode == MODE_READ_PARALLEL))
+		{
+			file_contents = NULL;
+			if(thread_data->Mode == MODE_READ_POOLED)
+			{
+				retval = GCP_Client_Read_Write_Read_Buffer(Bucket_Name,object_name,&file_contents,
+									   &file_contents_length);
+				GCP_Client_Buffer_Release(file_contents);
+			}
+			else if(thread_data->Mode == MODE_READ_PARALLEL)
+			{
+				retval = GCP_Client_Read_Write_Read_Parallel(Bucket_Name,object_name,&file_contents,
+									     &file_contents_length);
+				if(file_contents != NULL)
+					free(file_contents);
+			}
+			else
+			{
+				retval = GCP_Client_Read_Write_Read(Bucket_Name,object_name,&file_contents,
+								    &file_contents_length);
+				if(file_contents != NULL)
+					free(file_contents);
+			}
+			if(retval && (file_contents_length != thread_data->Size))
+			{
+				fprintf(stderr,"Benchmark_Thread:Read '%s' returned %lu bytes, expected %lu.\n",object_name,
+					(unsigned long)file_contents_length,(unsigned long)thread_data->Size);
+				retval = FALSE;
+			}
+		}
+		else
+		{
+			retval = GCP_Client_Read_Write_Write(Bucket_Name,object_name,thread_data->Buffer,
+							     thread_data->Size);
+		}
+		thread_data->Operation_Count++;
+		if(retval == FALSE)
+		{
+			thread_data->Error_Count++;
+			if(GCP_Client_General_Is_Error())
+				GCP_Client_General_Error();
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Perform the reads of read_completions mode from the calling thread. A completion queue with concurrency transfer
+ * threads is created, and a read of each benchmark thread's object is started. The routine then polls the queue's
+ * file descriptor, draining finished reads and starting the next read of the same object, until each object has
+ * been read Iteration_Count times. The counts are put in thread_data_list, as Benchmark_Thread would have.
+ * @param size The object size, in bytes.
+ * @param concurrency The number of reads to keep running at once.
+ * @param thread_data_list The list of concurrency thread structures, to fill in with the operation and error counts.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Benchmark_Thread_Struct
+ * @see #Get_Object_Name
+ * @see #Iteration_Count
+ * @see ../cdocs/gcp_client_completions.html#GCP_Client_Completions_Create
+ * @see ../cdocs/gcp_client_completions.html#GCP_Client_Completions_Get_Fd
+ * @see ../cdocs/gcp_client_completions.html#GCP_Client_Completions_Read_Start
+ * @see ../cdocs/gcp_client_completions.html#GCP_Client_Completions_Drain
+ * @see ../cdocs/gcp_client_completions.html#GCP_Client_Completions_Get_Pending_Count
+ * @see ../cdocs/gcp_client_completions.html#GCP_Client_Completions_Destroy
+ */
+static int Run_Completions(size_t size,int concurrency,struct Benchmark_Thread_Struct *thread_data_list)
+{
+	struct GCP_Client_Completions_Struct *completions = NULL;
+	struct GCP_Client_Completion_Struct completion_list[MAX_LIST_COUNT];
+	struct Benchmark_Thread_Struct *thread_data = NULL;
+	struct pollfd poll_fd;
+	char object_name[STRING_LENGTH];
+	int i,fd,completion_count,pending_count,retval;
+
+	if(!GCP_Client_Completions_Create(&completions,concurrency))
+	{
+		GCP_Client_General_Error();
+		return FALSE;
+	}
+	GCP_Client_Completions_Get_Fd(completions,&fd);
+	for(i = 0; i < concurrency; i++)
+	{
+		Get_Object_Name(size,i,object_name);
+		if(!GCP_Client_Completions_Read_Start(completions,Bucket_Name,object_name,&(thread_data_list[i]),NULL))
+		{
+			GCP_Client_General_Error();
+			GCP_Client_Completions_Destroy(completions);
+			return FALSE;
+		}
+	}
+	poll_fd.fd = fd;
+	poll_fd.events = POLLIN;
+	pending_count = concurrency;
+	while(pending_count > 0)
+	{
+		retval = poll(&poll_fd,1,-1);
+		if(retval < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			fprintf(stderr,"Run_Completions:poll failed (%d:%s).\n",errno,strerror(errno));
+			GCP_Client_Completions_Destroy(completions);
+			return FALSE;
+		}
+		GCP_Client_Completions_Drain(completions,completion_list,MAX_LIST_COUNT,&completion_count);
+		for(i = 0; i < completion_count; i++)
+		{
+			thread_data = (struct Benchmark_Thread_Struct *)(completion_list[i].User_Data);
+			thread_data->Operation_Count++;
+			if(completion_list[i].Success && (completion_list[i].Length != size))
+			{
+				fprintf(stderr,"Run_Completions:Read returned %lu bytes, expected %lu.\n",
+					(unsigned long)completion_list[i].Length,(unsigned long)size);
+				completion_list[i].Success = FALSE;
+			}
+			if(completion_list[i].Success == FALSE)
+			{
+				thread_data->Error_Count++;
+				fprintf(stderr,"%s",completion_list[i].Error_String);
+			}
+			if(completion_list[i].Data != NULL)
+				free(completion_list[i].Data);
+			if(thread_data->Operation_Count < Iteration_Count)
+			{
+				Get_Object_Name(size,thread_data->Thread_Index,object_name);
+				if(!GCP_Client_Completions_Read_Start(completions,Bucket_Name,object_name,thread_data,NULL))
+				{
+					thread_data->Error_Count++;
+					GCP_Client_General_Error();
+				}
+			}
+		}
+		GCP_Client_Completions_Get_Pending_Count(completions,&pending_count);
+	}
+	GCP_Client_Completions_Destroy(completions);
+	return TRUE;
+}
+
+/**
+ * Construct the name of the object a benchmark thread transfers.
+ * @param size The object size, in bytes.
+ * @param thread_index The index of the thread.
+ * @param object_name A string of at least STRING_LENGTH characters to put the object name in.
+ * @see #Object_Prefix
+ */
+static void Get_Object_Name(size_t size,int thread_index,char *object_name)
+{
+	snprintf(object_name,STRING_LENGTH,"%s/%lu/%d",Object_Prefix,(unsigned long)size,thread_index);
+}
+
+/**
+ * Write the benchmark results to Output_Filename (or stdout) in the selected Output_Format.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Result_List
+ * @see #Output_Filename
+ * @see #Output_Format
+ * @see #Print_Result_CSV
+ * @see #Print_Result_JSON
+ */
+static int Write_Results(void)
+{
+	FILE *fp = NULL;
+	int i;
+
+	if(strlen(Output_Filename) > 0)
+	{
+		fp = fopen(Output_Filename,"w");
+		if(fp == NULL)
+		{
+			fprintf(stderr,"Write_Results:Failed to open '%s' (%d).\n",Output_Filename,errno);
+			return FALSE;
+		}
+	}
+	else
+		fp = stdout;
+	if(Output_Format == OUTPUT_FORMAT_JSON)
+	{
+		fprintf(fp,"{\"results\":[\n");
+		for(i = 0; i < Result_Count; i++)
+		{
+			Print_Result_JSON(fp,&(Result_List[i]));
+			fprintf(fp,"%s\n",(i < (Result_Count-1)) ? "," : "");
+		}
+		fprintf(fp,"]}\n");
+	}
+	else
+	{
+		fprintf(fp,"%s\n",CSV_HEADER);
+		for(i = 0; i < Result_Count; i++)
+			Print_Result_CSV(fp,&(Result_List[i]));
+	}
+	if(fp != stdout)
+		fclose(fp);
+	else
+		fflush(fp);
+	return TRUE;
+}
+
+/**
+ * Print one result as a line of CSV.
+ * @param fp The file to print to.
+ * @param result The result to print.
+ * @see #CSV_HEADER
+ */
+static void Print_Result_CSV(FILE *fp,struct Benchmark_Result_Struct *result)
+{
+	fprintf(fp,"%s,%lu,%d,%d,%d,%.6f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%ld,%ld\n",Mode_To_String(result->Mode),
+		(unsigned long)result->Size,result->Concurrency,result->Operation_Count,result->Error_Count,
+		result->Elapsed,result->MB_Per_S,result->Ops_Per_S,result->P50_MS,result->P95_MS,result->P99_MS,
+		result->CPU_User_S,result->CPU_System_S,result->Max_RSS_KB,result->Minor_Faults);
+}
+
+/**
+ * Print one result as a JSON object (without a trailing newline or comma).
+ * @param fp The file to print to.
+ * @param result The result to print.
+ */
+static void Print_Result_JSON(FILE *fp,struct Benchmark_Result_Struct *result)
+{
+	fprintf(fp,"{\"mode\":\"%s\",\"size_bytes\":%lu,\"concurrency\":%d,\"operations\":%d,\"errors\":%d,"
+		"\"elapsed_s\":%.6f,\"mb_per_s\":%.3f,\"ops_per_s\":%.3f,\"p50_ms\":%.3f,\"p95_ms\":%.3f,"
+		"\"p99_ms\":%.3f,\"cpu_user_s\":%.3f,\"cpu_system_s\":%.3f,\"max_rss_kb\":%ld,"
+		"\"minor_faults\":%ld}",
+		Mode_To_String(result->Mode),(unsigned long)result->Size,result->Concurrency,result->Operation_Count,
+		result->Error_Count,result->Elapsed,result->MB_Per_S,result->Ops_Per_S,result->P50_MS,result->P95_MS,
+		result->P99_MS,result->CPU_User_S,result->CPU_System_S,result->Max_RSS_KB,result->Minor_Faults);
+}
+
+/**
+ * Compare the benchmark results against the baseline file. For each result with a matching mode, size and
+ * concurrency in the baseline, a regression is reported if the throughput has dropped, or the p99 latency risen,
+ * by more than Regression_Threshold percent. Combinations that now have errors but did not in the baseline
+ * are also reported as regressions.
+ * @param regression_count The address of an integer, on return set to the number of regressions found.
+ * @return The routine returns TRUE on success, and FALSE if the baseline could not be loaded.
+ * @see #Baseline_Filename
+ * @see #Regression_Threshold
+ * @see #Load_Baseline
+ */
+static int Compare_Baseline(int *regression_count)
+{
+	static struct Benchmark_Result_Struct baseline_list[MAX_RESULT_COUNT];
+	struct Benchmark_Result_Struct *baseline = NULL;
+	struct Benchmark_Result_Struct *result = NULL;
+	double throughput_change,latency_change;
+	int baseline_count,i,j,regression;
+
+	(*regression_count) = 0;
+	if(!Load_Baseline(Baseline_Filename,baseline_list,&baseline_count))
+		return FALSE;
+	for(i = 0; i < Result_Count; i++)
+	{
+		result = &(Result_List[i]);
+		baseline = NULL;
+		for(j = 0; j < baseline_count; j++)
+		{
+			if((baseline_list[j].Mode == result->Mode)&&(baseline_list[j].Size == result->Size)&&
+			   (baseline_list[j].Concurrency == result->Concurrency))
+			{
+				baseline = &(baseline_list[j]);
+				break;
+			}
+		}
+		if(baseline == NULL)
+		{
+			fprintf(stderr,"test_benchmark : %s size %lu concurrency %d: not in baseline.\n",
+				Mode_To_String(result->Mode),(unsigned long)result->Size,result->Concurrency);
+			continue;
+		}
+		throughput_change = 0.0;
+		if(baseline->MB_Per_S > 0.0)
+			throughput_change = 100.0*(result->MB_Per_S-baseline->MB_Per_S)/baseline->MB_Per_S;
+		latency_change = 0.0;
+		if(baseline->P99_MS > 0.0)
+			latency_change = 100.0*(result->P99_MS-baseline->P99_MS)/baseline->P99_MS;
+		regression = FALSE;
+		if(throughput_change < -Regression_Threshold)
+			regression = TRUE;
+		if(latency_change > Regression_Threshold)
+			regression = TRUE;
+		if((result->Error_Count > 0)&&(baseline->Error_Count == 0))
+			regression = TRUE;
+		if(regression)
+			(*regression_count)++;
+		fprintf(stderr,"test_benchmark : %s size %lu concurrency %d: MB/s %.3f -> %.3f (%+.1f%%) "
+			"p99 %.3f -> %.3f ms (%+.1f%%) errors %d -> %d%s.\n",Mode_To_String(result->Mode),
+			(unsigned long)result->Size,result->Concurrency,baseline->MB_Per_S,result->MB_Per_S,
+			throughput_change,baseline->P99_MS,result->P99_MS,latency_change,baseline->Error_Count,
+			result->Error_Count,regression ? " REGRESSION" : "");
+	}
+	return TRUE;
+}
+
+/**
+ * Load a previous CSV output file of this program.
+ * @param filename The filename of the CSV file.
+ * @param baseline_list An array of MAX_RESULT_COUNT results to fill in.
+ * @param baseline_count The address of an integer, on return set to the number of results loaded.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #CSV_HEADER
+ * @see #MAX_RESULT_COUNT
+ */
+static int Load_Baseline(char *filename,struct Benchmark_Result_Struct *baseline_list,int *baseline_count)
+{
+	struct Benchmark_Result_Struct *baseline = NULL;
+	FILE *fp = NULL;
+	char line[1024];
+	char mode_string[STRING_LENGTH];
+	unsigned long size;
+	int line_number,retval;
+
+	(*baseline_count) = 0;
+	fp = fopen(filename,"r");
+	if(fp == NULL)
+	{
+		fprintf(stderr,"Load_Baseline:Failed to open '%s' (%d).\n",filename,errno);
+		return FALSE;
+	}
+	line_number = 0;
+	while(fgets(line,1024,fp) != NULL)
+	{
+		line_number++;
+		if(strncmp(line,"mode,",5) == 0)
+			continue;
+		if((*baseline_count) >= MAX_RESULT_COUNT)
+			break;
+		baseline = &(baseline_list[(*baseline_count)]);
+		/* baselines saved before the minor_faults column was added have 14 columns */
+		baseline->Minor_Faults = 0;
+		retval = sscanf(line,"%255[^,],%lu,%d,%d,%d,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%ld,%ld",mode_string,&size,
+				&(baseline->Concurrency),&(baseline->Operation_Count),&(baseline->Error_Count),
+				&(baseline->Elapsed),&(baseline->MB_Per_S),&(baseline->Ops_Per_S),&(baseline->P50_MS),
+				&(baseline->P95_MS),&(baseline->P99_MS),&(baseline->CPU_User_S),&(baseline->CPU_System_S),
+				&(baseline->Max_RSS_KB),&(baseline->Minor_Faults));
+		if((retval != 14)&&(retval != 15))
+		{
+			fprintf(stderr,"Load_Baseline:Failed to parse '%s' line %d.\n",filename,line_number);
+			fclose(fp);
+			return FALSE;
+		}
+		if(strcmp(mode_string,"read") == 0)
+			baseline->Mode = MODE_READ;
+		else if(strcmp(mode_string,"read_pooled") == 0)
+			baseline->Mode = MODE_READ_POOLED;
+		else if(strcmp(mode_string,"read_hedged") == 0)
+			baseline->Mode = MODE_READ_HEDGED;
+		else if(strcmp(mode_string,"read_parallel") == 0)
+			baseline->Mode = MODE_READ_PARALLEL;
+		else if(strcmp(mode_string,"read_completions") == 0)
+			baseline->Mode = MODE_READ_COMPLETIONS;
+		else if(strcmp(mode_string,"write") == 0)
+			baseline->Mode = MODE_WRITE;
+		else
+		{
+			fprintf(stderr,"Load_Baseline:Unknown mode '%s' in '%s' line %d.\n",mode_string,filename,
+				line_number);
+			fclose(fp);
+			return FALSE;
+		}
+		baseline->Size = size;
+		(*baseline_count)++;
+	}
+	fclose(fp);
+	return TRUE;
+}
+
+/**
+ * Return a string describing a benchmark mode.
+ * @param mode The mode, MODE_WRITE, MODE_READ, MODE_READ_POOLED, MODE_READ_HEDGED
+ * or MODE_READ_PARALLEL.
+ * @return A string constant.
+ */
+static const char *Mode_To_String(int mode)
+{
+	if(mode == MODE_READ)
+		return "read";
+	if(mode == MODE_READ_POOLED)
+		return "read_pooled";
+	if(mode == MODE_READ_HEDGED)
+		return "read_hedged";
+	if(mode == MODE_READ_PARALLEL)
+		return "read_parallel";
+	if(mode == MODE_READ_COMPLETIONS)
+		return "read_completions";
+	return "write";
+}
+
+/**
+ * Parse a comma separated list of object sizes into Size_List. Each size is a number of bytes, with an optional
+ * k, m or g suffix (multiples of 1024).
+ * @param string The string to parse, e.g. "1k,64k,1m,16m,256m,1g".
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Size_List
+ * @see #Size_Count
+ */
+static int Parse_Size_List(char *string)
+{
+	char list_string[STRING_LENGTH];
+	char *token = NULL;
+	char *save_ptr = NULL;
+	char *end_ptr = NULL;
+	unsigned long long size;
+
+	strncpy(list_string,string,STRING_LENGTH-1);
+	list_string[STRING_LENGTH-1] = '\0';
+	Size_Count = 0;
+	for(token = strtok_r(list_string,",",&save_ptr); token != NULL; token = strtok_r(NULL,",",&save_ptr))
+	{
+		size = strtoull(token,&end_ptr,10);
+		if((*end_ptr == 'k')||(*end_ptr == 'K'))
+			size *= 1024ULL;
+		else if((*end_ptr == 'm')||(*end_ptr == 'M'))
+			size *= 1024ULL*1024ULL;
+		else if((*end_ptr == 'g')||(*end_ptr == 'G'))
+			size *= 1024ULL*1024ULL*1024ULL;
+		else if(*end_ptr != '\0')
+		{
+			fprintf(stderr,"Parse_Size_List:Failed to parse size '%s'.\n",token);
+			return FALSE;
+		}
+		if((size == 0)||(Size_Count >= MAX_LIST_COUNT))
+		{
+			fprintf(stderr,"Parse_Size_List:Illegal size '%s' or too many sizes.\n",token);
+			return FALSE;
+		}
+		Size_List[Size_Count++] = (size_t)size;
+	}
+	return TRUE;
+}
+
+/**
+ * Parse a comma separated list of concurrency levels into Concurrency_List.
+ * @param string The string to parse, e.g. "1,4,16".
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Concurrency_List
+ * @see #Concurrency_Count
+ */
+static int Parse_Concurrency_List(char *string)
+{
+	char list_string[STRING_LENGTH];
+	char *token = NULL;
+	char *save_ptr = NULL;
+	int concurrency;
+
+	strncpy(list_string,string,STRING_LENGTH-1);
+	list_string[STRING_LENGTH-1] = '\0';
+	Concurrency_Count = 0;
+	for(token = strtok_r(list_string,",",&save_ptr); token != NULL; token = strtok_r(NULL,",",&save_ptr))
+	{
+		if((sscanf(token,"%d",&concurrency) != 1)||(concurrency < 1)||(concurrency > (MAX_LIST_COUNT*8))||
+		   (Concurrency_Count >= MAX_LIST_COUNT))
+		{
+			fprintf(stderr,"Parse_Concurrency_List:Illegal concurrency '%s' or too many levels.\n",token);
+			return FALSE;
+		}
+		Concurrency_List[Concurrency_Count++] = concurrency;
+	}
+	return TRUE;
+}
+
+/**
+ * Parse a comma separated list of API modes ("write", "read", "read_pooled", "read_hedged",
+ * "read_parallel", "read_completions") into Mode_List.
+ * @param string The string to parse, e.g. "write,read".
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #Mode_List
+ * @see #Mode_Count
+ */
+static int Parse_Mode_List(char *string)
+{
+	char list_string[STRING_LENGTH];
+	char *token = NULL;
+	char *save_ptr = NULL;
+
+	strncpy(list_string,string,STRING_LENGTH-1);
+	list_string[STRING_LENGTH-1] = '\0';
+	Mode_Count = 0;
+	for(token = strtok_r(list_string,",",&save_ptr); token != NULL; token = strtok_r(NULL,",",&save_ptr))
+	{
+		if(Mode_Count >= MAX_LIST_COUNT)
+		{
+			fprintf(stderr,"Parse_Mode_List:Too many modes.\n");
+			return FALSE;
+		}
+		if(strcmp(token,"write") == 0)
+			Mode_List[Mode_Count++] = MODE_WRITE;
+		else if(strcmp(token,"read") == 0)
+			Mode_List[Mode_Count++] = MODE_READ;
+		else if(strcmp(token,"read_pooled") == 0)
+			Mode_List[Mode_Count++] = MODE_READ_POOLED;
+		else if(strcmp(token,"read_hedged") == 0)
+			Mode_List[Mode_Count++] = MODE_READ_HEDGED;
+		else if(strcmp(token,"read_parallel") == 0)
+			Mode_List[Mode_Count++] = MODE_READ_PARALLEL;
+		else if(strcmp(token,"read_completions") == 0)
+			Mode_List[Mode_Count++] = MODE_READ_COMPLETIONS;
+		else
+		{
+			fprintf(stderr,"Parse_Mode_List:Unknown mode '%s'.\n",token);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #Bucket_Name
+ * @see #Endpoint
+ * @see #Object_Prefix
+ * @see #Iteration_Count
+ * @see #Max_Memory
+ * @see #Budget
+ * @see #Output_Format
+ * @see #Output_Filename
+ * @see #Baseline_Filename
+ * @see #Regression_Threshold
+ * @see #Log_Level
+ * @see #Parse_Size_List
+ * @see #Parse_Concurrency_List
+ * @see #Parse_Mode_List
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	unsigned long long max_memory_mb,budget_mb;
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Bucket_Name,argv[i+1],STRING_LENGTH);
+				Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-baseline")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Baseline_Filename,argv[i+1],STRING_LENGTH);
+				Baseline_Filename[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-baseline requires a CSV filename.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-budget")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%llu",&budget_mb);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse memory budget %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				Budget = budget_mb*1024ULL*1024ULL;
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-budget requires a number of megabytes.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-c")==0)||(strcmp(argv[i],"-concurrency")==0))
+		{
+			if((i+1)<argc)
+			{
+				if(!Parse_Concurrency_List(argv[i+1]))
+					return FALSE;
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-concurrency requires a list of thread counts.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-e")==0)||(strcmp(argv[i],"-endpoint")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Endpoint,argv[i+1],STRING_LENGTH);
+				Endpoint[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-endpoint requires an emulator URL.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-f")==0)||(strcmp(argv[i],"-format")==0))
+		{
+			if((i+1)<argc)
+			{
+				if(strcmp(argv[i+1],"csv") == 0)
+					Output_Format = OUTPUT_FORMAT_CSV;
+				else if(strcmp(argv[i+1],"json") == 0)
+					Output_Format = OUTPUT_FORMAT_JSON;
+				else
+				{
+					fprintf(stderr,"Parse_Arguments:Unknown format '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-format requires csv or json.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-i")==0)||(strcmp(argv[i],"-iterations")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Iteration_Count);
+				if((retval != 1)||(Iteration_Count < 1))
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse iterations %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-iterations requires a number of transfers per thread.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-m")==0)||(strcmp(argv[i],"-modes")==0))
+		{
+			if((i+1)<argc)
+			{
+				if(!Parse_Mode_List(argv[i+1]))
+					return FALSE;
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-modes requires a list of modes "
+					"(write,read,read_pooled,read_hedged,read_parallel,read_completions).\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-max_memory")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%llu",&max_memory_mb);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse maximum memory %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				Max_Memory = (size_t)(max_memory_mb*1024ULL*1024ULL);
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-max_memory requires a number of megabytes.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-o")==0)||(strcmp(argv[i],"-output_filename")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Output_Filename,argv[i+1],STRING_LENGTH);
+				Output_Filename[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-output_filename requires a filename.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-p")==0)||(strcmp(argv[i],"-prefix")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Object_Prefix,argv[i+1],STRING_LENGTH);
+				Object_Prefix[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-prefix requires an object name prefix.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-s")==0)||(strcmp(argv[i],"-sizes")==0))
+		{
+			if((i+1)<argc)
+			{
+				if(!Parse_Size_List(argv[i+1]))
+					return FALSE;
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-sizes requires a list of object sizes.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-t")==0)||(strcmp(argv[i],"-threshold")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%lf",&Regression_Threshold);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse threshold %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-threshold requires a percentage.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test Benchmark:Help.\n");
+	fprintf(stdout,"This program benchmarks reading and writing objects, for a matrix of object sizes,\n");
+	fprintf(stdout,"concurrency levels and modes.\n");
+	fprintf(stdout,"test_benchmark -b[ucket] <bucket name> [-e[ndpoint] <url>][-s[izes] <size list>]\n");
+	fprintf(stdout,"\t[-c[oncurrency] <thread count list>][-m[odes] <mode list>][-i[terations] <n>]\n");
+	fprintf(stdout,"\t[-max_memory <MB>][-f[ormat] csv|json][-o[utput_filename] <filename>][-p[refix] <prefix>]\n");
+	fprintf(stdout,"\t[-budget <MB>][-baseline <csv filename>][-t[hreshold] <percent>][-l[og_level] <0..5>][-help].\n");
+	fprintf(stdout,"\t-bucket selects which bucket to benchmark against.\n");
+	fprintf(stdout,"\t-endpoint sets a storage emulator URL (CLOUD_STORAGE_EMULATOR_ENDPOINT), "
+		"e.g. http://localhost:9000.\n");
+	fprintf(stdout,"\t-sizes is a comma separated list of object sizes, with optional k/m/g suffix "
+		"(default 1k,64k,1m,16m,256m,1g).\n");
+	fprintf(stdout,"\t-concurrency is a comma separated list of thread counts (default 1,4,16).\n");
+	fprintf(stdout,"\t-modes is a comma separated list of write, read, read_pooled, read_hedged, read_parallel "
+		"and/or read_completions (default write,read).\n");
+	fprintf(stdout,"\t\tread_pooled reads into re-used pool buffers, compare it's minor_faults with read.\n");
+	fprintf(stdout,"\t\tread_hedged hedges reads with late first bytes, compare it's p99_ms with read.\n");
+	fprintf(stdout,"\t\tread_parallel reads adaptively sized parts in parallel, compare it's mb_per_s with read.\n");
+	fprintf(stdout,"\t\tread_completions reads from one poll loop via a completion queue, compare it with read.\n");
+	fprintf(stdout,"\t-iterations is the number of transfers per thread per combination (default 10).\n");
+	fprintf(stdout,"\t-max_memory skips combinations where size x concurrency exceeds this (default 4096 MB).\n");
+	fprintf(stdout,"\t-budget sets the library memory budget, reads wait for it rather than exceed it,\n");
+	fprintf(stdout,"\t\tand no combinations are skipped for -max_memory.\n");
+	fprintf(stdout,"\t-format selects CSV (default) or JSON results, written to stdout or -output_filename.\n");
+	fprintf(stdout,"\t-baseline compares the results with a previous CSV output, and exits with status 6\n");
+	fprintf(stdout,"\t\tif throughput dropped or p99 latency rose by more than -threshold percent (default 10).\n");
+}
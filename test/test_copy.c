@@ -0,0 +1,291 @@
+/* test_copy.c
+*/
+/**
+ * Test server-side copying of an object, optionally changing it's storage class.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_connection.h"
+#include "gcp_client_copy.h"
+#include "gcp_client_list.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH        (256)
+/**
+ * Verbosity log level : initialised to LOG_VERBOSITY_VERY_VERBOSE.
+ */
+static int Log_Level = LOG_VERBOSITY_VERY_VERBOSE;
+/**
+ * The name of the google cloud storage bucket to copy from.
+ */
+static char Source_Bucket_Name[STRING_LENGTH];
+/**
+ * The name of the object to copy.
+ */
+static char Source_Filename[STRING_LENGTH];
+/**
+ * The name of the google cloud storage bucket to copy to. Defaults to the source bucket.
+ */
+static char Destination_Bucket_Name[STRING_LENGTH];
+/**
+ * The name of the new object.
+ */
+static char Destination_Filename[STRING_LENGTH];
+/**
+ * The storage class of the new object, or NULL to use the destination bucket's default.
+ */
+static char *Storage_Class = NULL;
+/**
+ * If TRUE, copy using GCP_Client_Rewrite, otherwise use GCP_Client_Copy.
+ */
+static int Rewrite = FALSE;
+/**
+ * A rewrite token to resume a rewrite from. Updated by GCP_Client_Rewrite.
+ */
+static char Rewrite_Token[GCP_CLIENT_COPY_REWRITE_TOKEN_LENGTH+1] = "";
+
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>We setup logging, and open a connection.
+ * <li>We copy the object, with GCP_Client_Rewrite if -rewrite was specified, otherwise with GCP_Client_Copy.
+ *     If a rewrite fails, the token to resume it with (using -token) is printed.
+ * <li>We print the new object's metadata, and the time taken.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @see #Parse_Arguments
+ * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
+ * @see ../cdocs/gcp_client_copy.html#GCP_Client_Copy
+ * @see ../cdocs/gcp_client_copy.html#GCP_Client_Rewrite
+ */
+int main(int argc, char *argv[])
+{
+	struct GCP_Client_Object_Metadata_Struct metadata;
+	struct timespec start_time,end_time;
+	double elapsed_time;
+	int retval;
+
+	fprintf(stdout,"test_copy : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	if((strlen(Source_Bucket_Name) == 0)||(strlen(Source_Filename) == 0)||(strlen(Destination_Filename) == 0))
+	{
+		fprintf(stderr,"test_copy : The source bucket, source filename and destination filename "
+			"must be specified.\n");
+		return 1;
+	}
+	if(strlen(Destination_Bucket_Name) == 0)
+		strcpy(Destination_Bucket_Name,Source_Bucket_Name);
+	GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+	GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+	GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+	fprintf(stdout,"test_copy : Opening client connection.\n");
+	if(!GCP_Client_Connection_Open())
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	fprintf(stdout,"test_copy : %s '%s/%s' to '%s/%s' (storage class %s).\n",Rewrite ? "Rewriting" : "Copying",
+		Source_Bucket_Name,Source_Filename,Destination_Bucket_Name,Destination_Filename,
+		(Storage_Class != NULL) ? Storage_Class : "default");
+	clock_gettime(CLOCK_REALTIME,&start_time);
+	if(Rewrite)
+	{
+		retval = GCP_Client_Rewrite(Source_Bucket_Name,Source_Filename,Destination_Bucket_Name,
+					    Destination_Filename,Storage_Class,Rewrite_Token,&metadata);
+	}
+	else
+	{
+		retval = GCP_Client_Copy(Source_Bucket_Name,Source_Filename,Destination_Bucket_Name,
+					 Destination_Filename,Storage_Class,&metadata);
+	}
+	clock_gettime(CLOCK_REALTIME,&end_time);
+	if(!retval)
+	{
+		GCP_Client_General_Error();
+		if(strlen(Rewrite_Token) > 0)
+			fprintf(stdout,"test_copy : Resume the rewrite with -token %s\n",Rewrite_Token);
+		return 3;
+	}
+	elapsed_time = fdifftime(end_time,start_time);
+	fprintf(stdout,"test_copy : Copied %llu bytes to '%s/%s' (generation %lld) in %.3f seconds (%.3f MB/s).\n",
+		metadata.Size,Destination_Bucket_Name,metadata.Name,metadata.Generation,elapsed_time,
+		(elapsed_time > 0.0) ? ((double)metadata.Size)/(elapsed_time*1000000.0) : 0.0);
+	fprintf(stdout,"test_copy : finished.\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #Source_Bucket_Name
+ * @see #Source_Filename
+ * @see #Destination_Bucket_Name
+ * @see #Destination_Filename
+ * @see #Storage_Class
+ * @see #Rewrite
+ * @see #Rewrite_Token
+ * @see #Log_Level
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-db")==0)||(strcmp(argv[i],"-destination_bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Destination_Bucket_Name,argv[i+1],STRING_LENGTH);
+				Destination_Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-destination_bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-df")==0)||(strcmp(argv[i],"-destination_filename")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Destination_Filename,argv[i+1],STRING_LENGTH);
+				Destination_Filename[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-destination_filename requires a filename.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-r")==0)||(strcmp(argv[i],"-rewrite")==0))
+		{
+			Rewrite = TRUE;
+		}
+		else if((strcmp(argv[i],"-sb")==0)||(strcmp(argv[i],"-source_bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Source_Bucket_Name,argv[i+1],STRING_LENGTH);
+				Source_Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-source_bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-sc")==0)||(strcmp(argv[i],"-storage_class")==0))
+		{
+			if((i+1)<argc)
+			{
+				Storage_Class = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-storage_class requires a storage class.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-sf")==0)||(strcmp(argv[i],"-source_filename")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Source_Filename,argv[i+1],STRING_LENGTH);
+				Source_Filename[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-source_filename requires a filename.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-t")==0)||(strcmp(argv[i],"-token")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Rewrite_Token,argv[i+1],GCP_CLIENT_COPY_REWRITE_TOKEN_LENGTH);
+				Rewrite_Token[GCP_CLIENT_COPY_REWRITE_TOKEN_LENGTH] = '\0';
+				Rewrite = TRUE;
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-token requires a rewrite token.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test Copy:Help.\n");
+	fprintf(stdout,"This program copies an object within google cloud storage, without downloading it.\n");
+	fprintf(stdout,"test_copy -s[ource_]b[ucket] <bucket name> -s[ource_]f[ilename] <filename>\n");
+	fprintf(stdout,"\t[-d[estination_]b[ucket] <bucket name>] -d[estination_]f[ilename] <filename>\n");
+	fprintf(stdout,"\t[-s[torage_]c[lass] <STANDARD|NEARLINE|COLDLINE|ARCHIVE>][-r[ewrite]][-t[oken] <token>]\n");
+	fprintf(stdout,"\t[-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\t-rewrite copies using (possibly several) rewrite calls, which works for any object size\n");
+	fprintf(stdout,"\t\tand between locations and storage classes.\n");
+	fprintf(stdout,"\t-token resumes a failed rewrite, using the token printed when it failed.\n");
+}
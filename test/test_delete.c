@@ -0,0 +1,454 @@
+/* test_delete.c
+*/
+/**
+ * Test/benchmark deleting a set of objects, either as a batch of named objects (GCP_Client_Delete_Batch), or
+ * by deleting everything under their prefix (GCP_Client_Delete_Prefix). Optionally the objects are created first.
+ * The wall clock time, objects deleted per second and per-object latency percentiles (from the library
+ * statistics) are printed.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_connection.h"
+#include "gcp_client_delete.h"
+#include "gcp_client_read_write.h"
+#include "gcp_client_stats.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH           (256)
+/**
+ * Verbosity log level : initialised to 0 (no library logging).
+ */
+static int Log_Level = 0;
+/**
+ * The name of the google cloud storage bucket containing the objects.
+ */
+static char Bucket_Name[STRING_LENGTH];
+/**
+ * The storage emulator endpoint URL (e.g. http://localhost:9000), or an empty string to use google cloud storage.
+ */
+static char Endpoint[STRING_LENGTH] = "";
+/**
+ * The prefix of the object names. Object i is called <prefix>/<i>.
+ */
+static char Object_Prefix[STRING_LENGTH] = "gcp_client_delete";
+/**
+ * The number of objects to create, and delete with -batch.
+ */
+static int Object_Count = 10000;
+/**
+ * The size of the objects created with -create, in bytes.
+ */
+static size_t Object_Size = 1024;
+/**
+ * If TRUE, create the objects before deleting them.
+ */
+static int Create_Objects = FALSE;
+/**
+ * If TRUE, delete the named objects with GCP_Client_Delete_Batch, otherwise delete everything under
+ * <prefix>/ with GCP_Client_Delete_Prefix.
+ */
+static int Batch = FALSE;
+/**
+ * The number of deletes in progress at once.
+ */
+static int Concurrency = GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY;
+/**
+ * The maximum number of deletes started per second, or 0.0 for no limit.
+ */
+static double Max_Rate = 0.0;
+/**
+ * The list of object names.
+ */
+static char **Object_Name_List = NULL;
+/**
+ * A buffer holding the contents of created objects.
+ */
+static void *Object_Buffer = NULL;
+
+static void Create_Object(int index,void *user_data);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>If an emulator endpoint was specified, we set the CLOUD_STORAGE_EMULATOR_ENDPOINT environment variable.
+ * <li>We connect to the google cloud by calling GCP_Client_Connection_Open.
+ * <li>We generate the list of object names, and if Create_Objects is set write them (Create_Object).
+ * <li>We reset the library statistics, and delete the objects with GCP_Client_Delete_Batch (-batch), or
+ *     GCP_Client_Delete_Prefix.
+ * <li>We print the time taken, the number of objects deleted, not found and failed, objects deleted per second,
+ *     and the per-object latency percentiles from the delete operation's histogram.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @see #Parse_Arguments
+ * @see #Create_Object
+ * @see #Object_Count
+ * @see #Batch
+ * @see ../cdocs/gcp_client_batch.html#GCP_Client_Batch_Run
+ * @see ../cdocs/gcp_client_delete.html#GCP_Client_Delete_Batch
+ * @see ../cdocs/gcp_client_delete.html#GCP_Client_Delete_Prefix
+ * @see ../cdocs/gcp_client_stats.html#GCP_Client_Stats_Get
+ * @see ../cdocs/gcp_client_stats.html#GCP_Client_Stats_Histogram_Percentile
+ */
+int main(int argc, char *argv[])
+{
+	struct GCP_Client_Stats_Struct stats;
+	struct GCP_Client_Stats_Operation_Struct *operation_stats = NULL;
+	struct timespec start_time,end_time;
+	unsigned char *status_list = NULL;
+	unsigned long long deleted_count,not_found_count,failed_count;
+	char prefix[STRING_LENGTH+1];
+	double elapsed;
+	int i;
+
+	fprintf(stderr,"test_delete : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	if(strlen(Bucket_Name) == 0)
+	{
+		fprintf(stderr,"test_delete : No bucket specified.\n");
+		return 1;
+	}
+	if(Log_Level > 0)
+	{
+		GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+		GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+		GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+	}
+	if(strlen(Endpoint) > 0)
+	{
+		fprintf(stderr,"test_delete : Using emulator endpoint '%s'.\n",Endpoint);
+		setenv("CLOUD_STORAGE_EMULATOR_ENDPOINT",Endpoint,1);
+	}
+	fprintf(stderr,"test_delete : Opening client connection.\n");
+	if(!GCP_Client_Connection_Open())
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	Object_Name_List = (char **)malloc(Object_Count*sizeof(char *));
+	status_list = (unsigned char *)malloc(Object_Count*sizeof(unsigned char));
+	if((Object_Name_List == NULL)||(status_list == NULL))
+	{
+		fprintf(stderr,"test_delete : Failed to allocate lists for %d objects.\n",Object_Count);
+		return 3;
+	}
+	for(i = 0; i < Object_Count; i++)
+	{
+		Object_Name_List[i] = (char *)malloc(STRING_LENGTH*sizeof(char));
+		if(Object_Name_List[i] == NULL)
+		{
+			fprintf(stderr,"test_delete : Failed to allocate object name %d.\n",i);
+			return 3;
+		}
+		snprintf(Object_Name_List[i],STRING_LENGTH,"%s/%08d",Object_Prefix,i);
+	}
+	if(Create_Objects)
+	{
+		Object_Buffer = malloc(Object_Size);
+		if(Object_Buffer == NULL)
+		{
+			fprintf(stderr,"test_delete : Failed to allocate %lu bytes.\n",(unsigned long)Object_Size);
+			return 3;
+		}
+		memset(Object_Buffer,0x5a,Object_Size);
+		fprintf(stderr,"test_delete : Creating %d objects of size %lu.\n",Object_Count,
+			(unsigned long)Object_Size);
+		if(!GCP_Client_Batch_Run(Object_Count,0,Create_Object,NULL))
+		{
+			GCP_Client_General_Error();
+			return 4;
+		}
+	}
+	GCP_Client_Stats_Reset();
+	deleted_count = 0;
+	not_found_count = 0;
+	failed_count = 0;
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	if(Batch)
+	{
+		fprintf(stderr,"test_delete : Deleting %d objects with concurrency %d.\n",Object_Count,Concurrency);
+		if(!GCP_Client_Delete_Batch(Bucket_Name,Object_Name_List,NULL,Object_Count,Concurrency,Max_Rate,
+					    status_list))
+		{
+			/* report, but carry on, individual object failures are counted below */
+			GCP_Client_General_Error();
+		}
+		for(i = 0; i < Object_Count; i++)
+		{
+			if(status_list[i] == GCP_CLIENT_DELETE_STATUS_DELETED)
+				deleted_count++;
+			else if(status_list[i] == GCP_CLIENT_DELETE_STATUS_NOT_FOUND)
+				not_found_count++;
+			else
+				failed_count++;
+		}
+	}
+	else
+	{
+		snprintf(prefix,STRING_LENGTH+1,"%s/",Object_Prefix);
+		fprintf(stderr,"test_delete : Deleting objects under '%s' with concurrency %d.\n",prefix,Concurrency);
+		if(!GCP_Client_Delete_Prefix(Bucket_Name,prefix,Concurrency,Max_Rate,&deleted_count,&failed_count))
+			GCP_Client_General_Error();
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	elapsed = fdifftime(end_time,start_time);
+	if(!GCP_Client_Stats_Get(&stats))
+	{
+		GCP_Client_General_Error();
+		return 5;
+	}
+	operation_stats = &(stats.Operation_List[GCP_CLIENT_STATS_OPERATION_DELETE]);
+	fprintf(stdout,"mode,concurrency,max_rate,deleted,not_found,failed,elapsed_s,objects_per_s,"
+		"p50_ms,p95_ms,p99_ms\n");
+	fprintf(stdout,"%s,%d,%.1f,%llu,%llu,%llu,%.6f,%.3f,%.3f,%.3f,%.3f\n",Batch ? "batch" : "prefix",Concurrency,
+		Max_Rate,deleted_count,not_found_count,failed_count,elapsed,
+		(elapsed > 0.0) ? ((double)deleted_count)/elapsed : 0.0,
+		((double)GCP_Client_Stats_Histogram_Percentile(operation_stats->Latency_Histogram,50.0))/
+		((double)GCP_CLIENT_GENERAL_ONE_MILLISECOND_US),
+		((double)GCP_Client_Stats_Histogram_Percentile(operation_stats->Latency_Histogram,95.0))/
+		((double)GCP_CLIENT_GENERAL_ONE_MILLISECOND_US),
+		((double)GCP_Client_Stats_Histogram_Percentile(operation_stats->Latency_Histogram,99.0))/
+		((double)GCP_CLIENT_GENERAL_ONE_MILLISECOND_US));
+	for(i = 0; i < Object_Count; i++)
+		free(Object_Name_List[i]);
+	free(Object_Name_List);
+	free(status_list);
+	if(Object_Buffer != NULL)
+		free(Object_Buffer);
+	fprintf(stderr,"test_delete : finished.\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Batch item function used to create the objects. Writes Object_Buffer to the index'th object.
+ * @param index The index of the object to create.
+ * @param user_data Unused.
+ * @see #Object_Name_List
+ * @see #Object_Buffer
+ * @see #Object_Size
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Write
+ */
+static void Create_Object(int index,void *user_data)
+{
+	if(!GCP_Client_Read_Write_Write(Bucket_Name,Object_Name_List[index],Object_Buffer,Object_Size))
+		GCP_Client_Read_Write_Error();
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #Bucket_Name
+ * @see #Endpoint
+ * @see #Object_Prefix
+ * @see #Object_Count
+ * @see #Object_Size
+ * @see #Create_Objects
+ * @see #Batch
+ * @see #Concurrency
+ * @see #Max_Rate
+ * @see #Log_Level
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	unsigned long size;
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Bucket_Name,argv[i+1],STRING_LENGTH);
+				Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-batch")==0)
+		{
+			Batch = TRUE;
+		}
+		else if((strcmp(argv[i],"-c")==0)||(strcmp(argv[i],"-concurrency")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Concurrency);
+				if((retval != 1)||(Concurrency < 1)||(Concurrency > GCP_CLIENT_BATCH_MAX_CONCURRENCY))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal concurrency %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-concurrency requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-count")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Object_Count);
+				if((retval != 1)||(Object_Count < 1))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal object count %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-count requires a number of objects.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-create")==0)
+		{
+			Create_Objects = TRUE;
+		}
+		else if((strcmp(argv[i],"-e")==0)||(strcmp(argv[i],"-endpoint")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Endpoint,argv[i+1],STRING_LENGTH);
+				Endpoint[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-endpoint requires an emulator URL.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-p")==0)||(strcmp(argv[i],"-prefix")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Object_Prefix,argv[i+1],STRING_LENGTH);
+				Object_Prefix[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-prefix requires an object name prefix.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-r")==0)||(strcmp(argv[i],"-rate")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%lf",&Max_Rate);
+				if((retval != 1)||(Max_Rate < 0.0))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal rate %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-rate requires a number of deletes per second.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-size")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%lu",&size);
+				if((retval != 1)||(size < 1))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal object size %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				Object_Size = size;
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-size requires a number of bytes.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test Delete:Help.\n");
+	fprintf(stdout,"This program deletes a set of objects, and reports the time taken.\n");
+	fprintf(stdout,"test_delete -b[ucket] <bucket name> [-e[ndpoint] <url>][-p[refix] <prefix>][-count <n>]\n");
+	fprintf(stdout,"\t[-batch][-c[oncurrency] <n>][-r[ate] <deletes/s>][-create][-size <bytes>]\n");
+	fprintf(stdout,"\t[-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\t-bucket selects which google cloud bucket to use.\n");
+	fprintf(stdout,"\t-endpoint sets a storage emulator URL (CLOUD_STORAGE_EMULATOR_ENDPOINT).\n");
+	fprintf(stdout,"\t-prefix and -count select the objects: <prefix>/00000000 .. <prefix>/<count-1>.\n");
+	fprintf(stdout,"\t-batch deletes the named objects, otherwise everything under <prefix>/ is deleted.\n");
+	fprintf(stdout,"\t-concurrency is the number of deletes in progress at once (default %d).\n",
+		GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY);
+	fprintf(stdout,"\t-rate limits the number of deletes started per second (default no limit).\n");
+	fprintf(stdout,"\t-create writes the objects (of -size bytes, default 1024) first.\n");
+	fprintf(stdout,"\tThe results are printed to stdout as CSV.\n");
+}
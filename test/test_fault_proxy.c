@@ -0,0 +1,960 @@
+/* test_fault_proxy.c
+*/
+/**
+ * Fault and latency injecting HTTP proxy, to be placed between the gcp_client library and a local storage emulator
+ * (e.g. fake-gcs-server or the google-cloud-cpp testbench), so retry and timeout behaviour can be measured under
+ * repeatable slow and faulty conditions. The library is pointed at the proxy by setting the
+ * CLOUD_STORAGE_EMULATOR_ENDPOINT environment variable (or test_benchmark's -endpoint argument) to
+ * http://localhost:&lt;port&gt;.
+ * <p>
+ * Each client connection is handled by it's own thread, which connects to the upstream emulator and relays data in
+ * both directions. Requests on the connection are parsed (header, then a Content-Length body) so faults
+ * can be chosen per request:
+ * <ul>
+ * <li>Latency (plus random jitter) before the first byte of each response.
+ * <li>A bandwidth cap, in each direction, per connection.
+ * <li>A 429 or 503 error response instead of forwarding the request.
+ * <li>A connection reset (RST, using SO_LINGER 0) part way through the response.
+ * <li>A truncated response (the connection is closed cleanly part way through the response).
+ * </ul>
+ * Requests with a chunked body are relayed without further parsing of that connection.
+ * Fault counts are printed when the proxy is stopped with SIGINT or SIGTERM.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include "gcp_client_general.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH           (256)
+/**
+ * The length of the buffer used to relay data.
+ */
+#define RELAY_BUFFER_LENGTH     (65536)
+/**
+ * The maximum length of a request header block.
+ */
+#define HEADER_BUFFER_LENGTH    (65536)
+/**
+ * The number of milliseconds poll waits, before checking whether the proxy is stopping.
+ */
+#define POLL_TIMEOUT_MS         (500)
+/**
+ * Request parse state : reading the request header block.
+ */
+#define REQUEST_STATE_HEADER    (0)
+/**
+ * Request parse state : relaying a request body of known length.
+ */
+#define REQUEST_STATE_BODY      (1)
+/**
+ * Request parse state : relaying without parsing (chunked request body seen).
+ */
+#define REQUEST_STATE_PASSTHROUGH (2)
+
+/**
+ * Structure holding the state of one proxied connection.
+ * <dl>
+ * <dt>Client_Socket_Fd</dt> <dd>The socket connected to the library (client).</dd>
+ * <dt>Upstream_Socket_Fd</dt> <dd>The socket connected to the upstream emulator.</dd>
+ * <dt>Random_Seed</dt> <dd>The seed for this connection's rand_r calls.</dd>
+ * <dt>Request_State</dt> <dd>The request parse state, one of REQUEST_STATE_*.</dd>
+ * <dt>Header_Buffer</dt> <dd>The request header block being accumulated.</dd>
+ * <dt>Header_Length</dt> <dd>The number of bytes in Header_Buffer.</dd>
+ * <dt>Body_Remaining</dt> <dd>The number of request body bytes still to relay.</dd>
+ * <dt>Response_Delay_MS</dt> <dd>Latency to inject before the next response byte is relayed, or 0.</dd>
+ * <dt>Response_Byte_Count</dt> <dd>The number of response bytes relayed since the last request was forwarded.</dd>
+ * <dt>Response_Reset_At</dt> <dd>Reset the connection after this many response bytes, or -1.</dd>
+ * <dt>Response_Truncate_At</dt> <dd>Close the connection after this many response bytes, or -1.</dd>
+ * <dt>Start_Time</dt> <dd>When the connection was accepted, used for bandwidth pacing.</dd>
+ * <dt>Upload_Byte_Count</dt> <dd>Total bytes relayed from client to upstream, used for bandwidth pacing.</dd>
+ * <dt>Download_Byte_Count</dt> <dd>Total bytes relayed from upstream to client, used for bandwidth pacing.</dd>
+ * </dl>
+ */
+struct Connection_Struct
+{
+	int Client_Socket_Fd;
+	int Upstream_Socket_Fd;
+	unsigned int Random_Seed;
+	int Request_State;
+	char Header_Buffer[HEADER_BUFFER_LENGTH];
+	int Header_Length;
+	long long Body_Remaining;
+	int Response_Delay_MS;
+	long long Response_Byte_Count;
+	long long Response_Reset_At;
+	long long Response_Truncate_At;
+	struct timespec Start_Time;
+	long long Upload_Byte_Count;
+	long long Download_Byte_Count;
+};
+
+/**
+ * The port number to listen on.
+ */
+static int Listen_Port = 9001;
+/**
+ * The upstream emulator hostname.
+ */
+static char Upstream_Hostname[STRING_LENGTH] = "localhost";
+/**
+ * The upstream emulator port number.
+ */
+static int Upstream_Port = 9000;
+/**
+ * Latency added before the first byte of each response, in milliseconds.
+ */
+static int Latency_MS = 0;
+/**
+ * A random amount of extra latency, up to this many milliseconds, is added to Latency_MS.
+ */
+static int Jitter_MS = 0;
+/**
+ * Bandwidth cap per connection and direction, in bytes per second, or 0 for no cap.
+ */
+static long long Bandwidth = 0;
+/**
+ * Probability (0..1) of replying to a request with an error response, instead of forwarding it.
+ */
+static double Error_Rate = 0.0;
+/**
+ * The HTTP status code of injected error responses, 429 or 503, or 0 to choose between them at random.
+ */
+static int Error_Code = 0;
+/**
+ * Probability (0..1) of resetting the connection part way through a response.
+ */
+static double Reset_Rate = 0.0;
+/**
+ * Probability (0..1) of closing the connection part way through a response (a truncated body).
+ */
+static double Truncate_Rate = 0.0;
+/**
+ * Resets and truncations happen after a random number of response bytes, up to this many.
+ */
+static long long Fault_Byte_Range = 65536;
+/**
+ * The random seed. Each connection's seed is derived from this and the connection number, so a run with
+ * the same seed and request sequence injects the same faults.
+ */
+static unsigned int Random_Seed = 1;
+/**
+ * Whether to print a line for each request and injected fault.
+ */
+static int Verbose = FALSE;
+/**
+ * Set to TRUE when a SIGINT or SIGTERM is received.
+ */
+static volatile sig_atomic_t Stop = FALSE;
+/**
+ * Mutex protecting the statistics counters.
+ */
+static pthread_mutex_t Statistics_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * The number of connections accepted.
+ */
+static unsigned long long Connection_Count = 0;
+/**
+ * The number of requests parsed.
+ */
+static unsigned long long Request_Count = 0;
+/**
+ * The number of injected error responses.
+ */
+static unsigned long long Error_Count = 0;
+/**
+ * The number of injected connection resets.
+ */
+static unsigned long long Reset_Count = 0;
+/**
+ * The number of injected truncated responses.
+ */
+static unsigned long long Truncate_Count = 0;
+
+static void *Connection_Thread(void *arg);
+static int Relay_From_Client(struct Connection_Struct *connection,char *buffer,int length);
+static int Relay_Request_Header(struct Connection_Struct *connection);
+static int Relay_From_Upstream(struct Connection_Struct *connection,char *buffer,int length);
+static int Send_All(int socket_fd,char *buffer,int length);
+static void Pace(struct Connection_Struct *connection,long long byte_count);
+static void Send_Error_Response(struct Connection_Struct *connection);
+static void Reset_Connection(int socket_fd);
+static int Connect_Upstream(void);
+static double Random_Double(struct Connection_Struct *connection);
+static void Increment_Statistic(unsigned long long *statistic);
+static void Signal_Handler(int signal_number);
+static int Parse_Probability(char *string,double *value);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>We install SIGINT/SIGTERM handlers, and ignore SIGPIPE.
+ * <li>We listen on Listen_Port on the loopback interface.
+ * <li>For each accepted connection, we start a detached Connection_Thread.
+ * <li>When stopped, we print the fault statistics.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return The program returns 0 on success, and non-zero on failure.
+ * @see #Parse_Arguments
+ * @see #Connection_Thread
+ * @see #Signal_Handler
+ */
+int main(int argc, char *argv[])
+{
+	struct Connection_Struct *connection = NULL;
+	struct sockaddr_in address;
+	struct sigaction signal_action;
+	struct pollfd poll_fd;
+	pthread_attr_t thread_attr;
+	pthread_t thread;
+	int listen_socket_fd,client_socket_fd,value;
+
+	fprintf(stdout,"test_fault_proxy : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	memset(&signal_action,0,sizeof(struct sigaction));
+	signal_action.sa_handler = Signal_Handler;
+	sigaction(SIGINT,&signal_action,NULL);
+	sigaction(SIGTERM,&signal_action,NULL);
+	signal(SIGPIPE,SIG_IGN);
+	listen_socket_fd = socket(AF_INET,SOCK_STREAM,0);
+	if(listen_socket_fd < 0)
+	{
+		fprintf(stderr,"test_fault_proxy : Failed to create listen socket (%d).\n",errno);
+		return 2;
+	}
+	value = 1;
+	setsockopt(listen_socket_fd,SOL_SOCKET,SO_REUSEADDR,&value,sizeof(int));
+	memset(&address,0,sizeof(struct sockaddr_in));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(Listen_Port);
+	if(bind(listen_socket_fd,(struct sockaddr *)&address,sizeof(struct sockaddr_in)) != 0)
+	{
+		fprintf(stderr,"test_fault_proxy : Failed to bind to port %d (%d).\n",Listen_Port,errno);
+		return 2;
+	}
+	if(listen(listen_socket_fd,64) != 0)
+	{
+		fprintf(stderr,"test_fault_proxy : Failed to listen on port %d (%d).\n",Listen_Port,errno);
+		return 2;
+	}
+	fprintf(stdout,"test_fault_proxy : Proxying port %d to %s:%d.\n",Listen_Port,Upstream_Hostname,Upstream_Port);
+	fprintf(stdout,"test_fault_proxy : latency %d+%d ms, bandwidth %lld bytes/s, error rate %.3f (code %d), "
+		"reset rate %.3f, truncate rate %.3f.\n",Latency_MS,Jitter_MS,Bandwidth,Error_Rate,Error_Code,
+		Reset_Rate,Truncate_Rate);
+	fflush(stdout);
+	pthread_attr_init(&thread_attr);
+	pthread_attr_setdetachstate(&thread_attr,PTHREAD_CREATE_DETACHED);
+	while(Stop == FALSE)
+	{
+		poll_fd.fd = listen_socket_fd;
+		poll_fd.events = POLLIN;
+		if(poll(&poll_fd,1,POLL_TIMEOUT_MS) <= 0)
+			continue;
+		client_socket_fd = accept(listen_socket_fd,NULL,NULL);
+		if(client_socket_fd < 0)
+			continue;
+		connection = (struct Connection_Struct *)calloc(1,sizeof(struct Connection_Struct));
+		if(connection == NULL)
+		{
+			close(client_socket_fd);
+			continue;
+		}
+		connection->Client_Socket_Fd = client_socket_fd;
+		connection->Upstream_Socket_Fd = -1;
+		pthread_mutex_lock(&Statistics_Mutex);
+		Connection_Count++;
+		connection->Random_Seed = Random_Seed+(unsigned int)(Connection_Count*2654435761U);
+		pthread_mutex_unlock(&Statistics_Mutex);
+		if(pthread_create(&thread,&thread_attr,Connection_Thread,connection) != 0)
+		{
+			fprintf(stderr,"test_fault_proxy : Failed to create connection thread.\n");
+			close(client_socket_fd);
+			free(connection);
+		}
+	}
+	close(listen_socket_fd);
+	pthread_mutex_lock(&Statistics_Mutex);
+	fprintf(stdout,"test_fault_proxy : connections %llu requests %llu errors %llu resets %llu truncations %llu.\n",
+		Connection_Count,Request_Count,Error_Count,Reset_Count,Truncate_Count);
+	pthread_mutex_unlock(&Statistics_Mutex);
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Connection thread. Connects to the upstream emulator, then relays data in both directions until either side
+ * closes, a fault closes the connection, or the proxy is stopped.
+ * @param arg A pointer to an allocated Connection_Struct, freed by this thread.
+ * @return The routine returns NULL.
+ * @see #Connection_Struct
+ * @see #Connect_Upstream
+ * @see #Relay_From_Client
+ * @see #Relay_From_Upstream
+ */
+static void *Connection_Thread(void *arg)
+{
+	struct Connection_Struct *connection = (struct Connection_Struct *)arg;
+	struct pollfd poll_fd_list[2];
+	char buffer[RELAY_BUFFER_LENGTH];
+	ssize_t length;
+	int value,done;
+
+	value = 1;
+	setsockopt(connection->Client_Socket_Fd,IPPROTO_TCP,TCP_NODELAY,&value,sizeof(int));
+	connection->Upstream_Socket_Fd = Connect_Upstream();
+	if(connection->Upstream_Socket_Fd < 0)
+	{
+		close(connection->Client_Socket_Fd);
+		free(connection);
+		return NULL;
+	}
+	connection->Request_State = REQUEST_STATE_HEADER;
+	connection->Header_Length = 0;
+	connection->Response_Reset_At = -1;
+	connection->Response_Truncate_At = -1;
+	clock_gettime(CLOCK_MONOTONIC,&(connection->Start_Time));
+	done = FALSE;
+	while((done == FALSE)&&(Stop == FALSE))
+	{
+		poll_fd_list[0].fd = connection->Client_Socket_Fd;
+		poll_fd_list[0].events = POLLIN;
+		poll_fd_list[1].fd = connection->Upstream_Socket_Fd;
+		poll_fd_list[1].events = POLLIN;
+		if(poll(poll_fd_list,2,POLL_TIMEOUT_MS) <= 0)
+			continue;
+		if(poll_fd_list[0].revents & (POLLIN|POLLHUP|POLLERR))
+		{
+			length = recv(connection->Client_Socket_Fd,buffer,RELAY_BUFFER_LENGTH,0);
+			if(length <= 0)
+				done = TRUE;
+			else if(!Relay_From_Client(connection,buffer,length))
+				done = TRUE;
+		}
+		if((done == FALSE)&&(poll_fd_list[1].revents & (POLLIN|POLLHUP|POLLERR)))
+		{
+			length = recv(connection->Upstream_Socket_Fd,buffer,RELAY_BUFFER_LENGTH,0);
+			if(length <= 0)
+				done = TRUE;
+			else if(!Relay_From_Upstream(connection,buffer,length))
+				done = TRUE;
+		}
+	}
+	if(connection->Client_Socket_Fd >= 0)
+		close(connection->Client_Socket_Fd);
+	if(connection->Upstream_Socket_Fd >= 0)
+		close(connection->Upstream_Socket_Fd);
+	free(connection);
+	return NULL;
+}
+
+/**
+ * Relay data received from the client to the upstream emulator, parsing request headers so faults can be
+ * chosen per request.
+ * @param connection The connection.
+ * @param buffer The data received.
+ * @param length The number of bytes received.
+ * @return The routine returns TRUE if the connection should continue, and FALSE if it should be closed.
+ * @see #Relay_Request_Header
+ * @see #Send_All
+ * @see #Pace
+ * @see #HEADER_BUFFER_LENGTH
+ */
+static int Relay_From_Client(struct Connection_Struct *connection,char *buffer,int length)
+{
+	char *header_end_ptr = NULL;
+	int count,header_bytes;
+
+	while(length > 0)
+	{
+		if(connection->Request_State == REQUEST_STATE_HEADER)
+		{
+			count = length;
+			if(count > (HEADER_BUFFER_LENGTH-1-connection->Header_Length))
+				count = HEADER_BUFFER_LENGTH-1-connection->Header_Length;
+			if(count <= 0)
+			{
+				fprintf(stderr,"Relay_From_Client:Request header too long.\n");
+				return FALSE;
+			}
+			memcpy(connection->Header_Buffer+connection->Header_Length,buffer,count);
+			connection->Header_Length += count;
+			connection->Header_Buffer[connection->Header_Length] = '\0';
+			header_end_ptr = strstr(connection->Header_Buffer,"\r\n\r\n");
+			if(header_end_ptr == NULL)
+			{
+				buffer += count;
+				length -= count;
+				continue;
+			}
+			/* the header is complete. Any bytes copied past the header end belong to the body,
+			** so put them back into the input */
+			header_bytes = (header_end_ptr+4)-connection->Header_Buffer;
+			buffer += count-(connection->Header_Length-header_bytes);
+			length -= count-(connection->Header_Length-header_bytes);
+			connection->Header_Length = header_bytes;
+			if(!Relay_Request_Header(connection))
+				return FALSE;
+			connection->Header_Length = 0;
+		}
+		else if(connection->Request_State == REQUEST_STATE_BODY)
+		{
+			count = length;
+			if(count > connection->Body_Remaining)
+				count = (int)connection->Body_Remaining;
+			Pace(connection,count);
+			if(!Send_All(connection->Upstream_Socket_Fd,buffer,count))
+				return FALSE;
+			connection->Upload_Byte_Count += count;
+			connection->Body_Remaining -= count;
+			buffer += count;
+			length -= count;
+			if(connection->Body_Remaining == 0)
+				connection->Request_State = REQUEST_STATE_HEADER;
+		}
+		else /* REQUEST_STATE_PASSTHROUGH */
+		{
+			Pace(connection,length);
+			if(!Send_All(connection->Upstream_Socket_Fd,buffer,length))
+				return FALSE;
+			connection->Upload_Byte_Count += length;
+			length = 0;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * A complete request header block is in the connection's Header_Buffer. Choose the faults for this request:
+ * either reply with an error response (and close), or forward the header to the upstream emulator and set up
+ * the latency, reset and truncation to apply to the response. The request body length is found from the
+ * Content-Length header, and a chunked Transfer-Encoding puts the connection into passthrough.
+ * @param connection The connection.
+ * @return The routine returns TRUE if the connection should continue, and FALSE if it should be closed.
+ * @see #Send_Error_Response
+ * @see #Random_Double
+ * @see #Latency_MS
+ * @see #Jitter_MS
+ * @see #Error_Rate
+ * @see #Reset_Rate
+ * @see #Truncate_Rate
+ * @see #Fault_Byte_Range
+ */
+static int Relay_Request_Header(struct Connection_Struct *connection)
+{
+	char request_line[STRING_LENGTH];
+	char *line_ptr = NULL;
+	char *line_end_ptr = NULL;
+	long long content_length;
+	int chunked;
+
+	Increment_Statistic(&Request_Count);
+	/* parse the headers we need */
+	content_length = 0;
+	chunked = FALSE;
+	line_end_ptr = strstr(connection->Header_Buffer,"\r\n");
+	snprintf(request_line,STRING_LENGTH,"%.*s",(int)(line_end_ptr-connection->Header_Buffer),
+		 connection->Header_Buffer);
+	for(line_ptr = line_end_ptr+2; (line_ptr-connection->Header_Buffer) < connection->Header_Length;
+	    line_ptr = line_end_ptr+2)
+	{
+		line_end_ptr = strstr(line_ptr,"\r\n");
+		if((line_end_ptr == NULL)||(line_end_ptr == line_ptr))
+			break;
+		if(strncasecmp(line_ptr,"Content-Length:",15) == 0)
+			content_length = strtoll(line_ptr+15,NULL,10);
+		else if((strncasecmp(line_ptr,"Transfer-Encoding:",18) == 0)&&
+			(strstr(line_ptr,"chunked") != NULL)&&(strstr(line_ptr,"chunked") < line_end_ptr))
+			chunked = TRUE;
+	}
+	/* error response fault */
+	if(Random_Double(connection) < Error_Rate)
+	{
+		Increment_Statistic(&Error_Count);
+		if(Verbose)
+			fprintf(stdout,"test_fault_proxy : %s : injecting error response.\n",request_line);
+		Send_Error_Response(connection);
+		return FALSE;
+	}
+	/* response faults */
+	connection->Response_Byte_Count = 0;
+	connection->Response_Reset_At = -1;
+	connection->Response_Truncate_At = -1;
+	connection->Response_Delay_MS = Latency_MS;
+	if(Jitter_MS > 0)
+		connection->Response_Delay_MS += (int)(Random_Double(connection)*Jitter_MS);
+	if(Random_Double(connection) < Reset_Rate)
+		connection->Response_Reset_At = (long long)(Random_Double(connection)*Fault_Byte_Range);
+	else if(Random_Double(connection) < Truncate_Rate)
+		connection->Response_Truncate_At = (long long)(Random_Double(connection)*Fault_Byte_Range);
+	if(Verbose)
+	{
+		fprintf(stdout,"test_fault_proxy : %s : body %lld%s delay %d ms reset at %lld truncate at %lld.\n",
+			request_line,content_length,chunked ? " (chunked)" : "",connection->Response_Delay_MS,
+			connection->Response_Reset_At,connection->Response_Truncate_At);
+	}
+	if(!Send_All(connection->Upstream_Socket_Fd,connection->Header_Buffer,connection->Header_Length))
+		return FALSE;
+	connection->Upload_Byte_Count += connection->Header_Length;
+	if(chunked)
+		connection->Request_State = REQUEST_STATE_PASSTHROUGH;
+	else if(content_length > 0)
+	{
+		connection->Request_State = REQUEST_STATE_BODY;
+		connection->Body_Remaining = content_length;
+	}
+	else
+		connection->Request_State = REQUEST_STATE_HEADER;
+	return TRUE;
+}
+
+/**
+ * Relay data received from the upstream emulator to the client, applying the current request's latency,
+ * reset and truncation faults, and the bandwidth cap.
+ * @param connection The connection.
+ * @param buffer The data received.
+ * @param length The number of bytes received.
+ * @return The routine returns TRUE if the connection should continue, and FALSE if it should be closed.
+ * @see #Reset_Connection
+ * @see #Send_All
+ * @see #Pace
+ */
+static int Relay_From_Upstream(struct Connection_Struct *connection,char *buffer,int length)
+{
+	long long fault_at;
+	int count;
+
+	if(connection->Response_Delay_MS > 0)
+	{
+		usleep(connection->Response_Delay_MS*GCP_CLIENT_GENERAL_ONE_MILLISECOND_US);
+		connection->Response_Delay_MS = 0;
+	}
+	fault_at = -1;
+	if(connection->Response_Reset_At >= 0)
+		fault_at = connection->Response_Reset_At;
+	else if(connection->Response_Truncate_At >= 0)
+		fault_at = connection->Response_Truncate_At;
+	count = length;
+	if((fault_at >= 0)&&((connection->Response_Byte_Count+count) > fault_at))
+		count = (int)(fault_at-connection->Response_Byte_Count);
+	Pace(connection,-count);
+	if(!Send_All(connection->Client_Socket_Fd,buffer,count))
+		return FALSE;
+	connection->Download_Byte_Count += count;
+	connection->Response_Byte_Count += count;
+	if(count < length)
+	{
+		if(connection->Response_Reset_At >= 0)
+		{
+			Increment_Statistic(&Reset_Count);
+			if(Verbose)
+			{
+				fprintf(stdout,"test_fault_proxy : resetting connection after %lld response bytes.\n",
+					connection->Response_Byte_Count);
+			}
+			Reset_Connection(connection->Client_Socket_Fd);
+			connection->Client_Socket_Fd = -1;
+		}
+		else
+		{
+			Increment_Statistic(&Truncate_Count);
+			if(Verbose)
+			{
+				fprintf(stdout,"test_fault_proxy : truncating response after %lld bytes.\n",
+					connection->Response_Byte_Count);
+			}
+		}
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Send all of a buffer to a socket.
+ * @param socket_fd The socket.
+ * @param buffer The data to send.
+ * @param length The number of bytes to send.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ */
+static int Send_All(int socket_fd,char *buffer,int length)
+{
+	ssize_t sent_length;
+
+	while(length > 0)
+	{
+		sent_length = send(socket_fd,buffer,length,MSG_NOSIGNAL);
+		if(sent_length < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			return FALSE;
+		}
+		buffer += sent_length;
+		length -= sent_length;
+	}
+	return TRUE;
+}
+
+/**
+ * Apply the bandwidth cap. If sending byte_count more bytes in a direction would exceed Bandwidth bytes per second
+ * averaged since the connection started, sleep until it would not.
+ * @param connection The connection.
+ * @param byte_count The number of bytes about to be sent: positive from the client to upstream (upload),
+ *        negative from upstream to the client (download).
+ * @see #Bandwidth
+ */
+static void Pace(struct Connection_Struct *connection,long long byte_count)
+{
+	struct timespec current_time;
+	double elapsed,required;
+	long long total;
+
+	if(Bandwidth <= 0)
+		return;
+	if(byte_count >= 0)
+		total = connection->Upload_Byte_Count+byte_count;
+	else
+		total = connection->Download_Byte_Count-byte_count;
+	required = ((double)total)/((double)Bandwidth);
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	elapsed = fdifftime(current_time,connection->Start_Time);
+	if(required > elapsed)
+		usleep((useconds_t)((required-elapsed)*GCP_CLIENT_GENERAL_ONE_SECOND_US));
+}
+
+/**
+ * Send an injected error response (429 Too Many Requests or 503 Service Unavailable) to the client,
+ * with a JSON body in the format google cloud storage uses, and "Connection: close".
+ * @param connection The connection.
+ * @see #Error_Code
+ */
+static void Send_Error_Response(struct Connection_Struct *connection)
+{
+	char body[STRING_LENGTH];
+	char response[STRING_LENGTH*2];
+	const char *reason = NULL;
+	int code,length;
+
+	code = Error_Code;
+	if(code == 0)
+		code = (Random_Double(connection) < 0.5) ? 429 : 503;
+	if(code == 429)
+		reason = "Too Many Requests";
+	else
+		reason = "Service Unavailable";
+	snprintf(body,STRING_LENGTH,"{\"error\":{\"code\":%d,\"message\":\"test_fault_proxy injected %s.\"}}",
+		 code,reason);
+	length = snprintf(response,STRING_LENGTH*2,"HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+			  "Content-Length: %d\r\nConnection: close\r\n\r\n%s",code,reason,(int)strlen(body),body);
+	Send_All(connection->Client_Socket_Fd,response,length);
+}
+
+/**
+ * Close a socket with a TCP reset (RST) rather than a normal FIN, by setting a zero SO_LINGER timeout.
+ * @param socket_fd The socket to reset.
+ */
+static void Reset_Connection(int socket_fd)
+{
+	struct linger linger_value;
+
+	linger_value.l_onoff = 1;
+	linger_value.l_linger = 0;
+	setsockopt(socket_fd,SOL_SOCKET,SO_LINGER,&linger_value,sizeof(struct linger));
+	close(socket_fd);
+}
+
+/**
+ * Connect to the upstream emulator.
+ * @return The connected socket, or -1 on failure.
+ * @see #Upstream_Hostname
+ * @see #Upstream_Port
+ */
+static int Connect_Upstream(void)
+{
+	struct addrinfo hints;
+	struct addrinfo *address_list = NULL;
+	struct addrinfo *address = NULL;
+	char port_string[32];
+	int socket_fd,retval,value;
+
+	memset(&hints,0,sizeof(struct addrinfo));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf(port_string,32,"%d",Upstream_Port);
+	retval = getaddrinfo(Upstream_Hostname,port_string,&hints,&address_list);
+	if(retval != 0)
+	{
+		fprintf(stderr,"Connect_Upstream:Failed to resolve '%s' (%s).\n",Upstream_Hostname,gai_strerror(retval));
+		return -1;
+	}
+	socket_fd = -1;
+	for(address = address_list; address != NULL; address = address->ai_next)
+	{
+		socket_fd = socket(address->ai_family,address->ai_socktype,address->ai_protocol);
+		if(socket_fd < 0)
+			continue;
+		if(connect(socket_fd,address->ai_addr,address->ai_addrlen) == 0)
+			break;
+		close(socket_fd);
+		socket_fd = -1;
+	}
+	freeaddrinfo(address_list);
+	if(socket_fd < 0)
+	{
+		fprintf(stderr,"Connect_Upstream:Failed to connect to %s:%d.\n",Upstream_Hostname,Upstream_Port);
+		return -1;
+	}
+	value = 1;
+	setsockopt(socket_fd,IPPROTO_TCP,TCP_NODELAY,&value,sizeof(int));
+	return socket_fd;
+}
+
+/**
+ * Return a random number between 0 and 1, using the connection's random seed.
+ * @param connection The connection.
+ * @return A random number in the range [0,1).
+ */
+static double Random_Double(struct Connection_Struct *connection)
+{
+	return ((double)rand_r(&(connection->Random_Seed)))/(((double)RAND_MAX)+1.0);
+}
+
+/**
+ * Increment a statistics counter, under Statistics_Mutex.
+ * @param statistic The address of the counter.
+ * @see #Statistics_Mutex
+ */
+static void Increment_Statistic(unsigned long long *statistic)
+{
+	pthread_mutex_lock(&Statistics_Mutex);
+	(*statistic)++;
+	pthread_mutex_unlock(&Statistics_Mutex);
+}
+
+/**
+ * SIGINT / SIGTERM handler, which stops the proxy.
+ * @param signal_number The signal received.
+ * @see #Stop
+ */
+static void Signal_Handler(int signal_number)
+{
+	Stop = TRUE;
+}
+
+/**
+ * Parse a probability argument (0..1).
+ * @param string The string to parse.
+ * @param value The address of a double to store the probability in.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ */
+static int Parse_Probability(char *string,double *value)
+{
+	if((sscanf(string,"%lf",value) != 1)||((*value) < 0.0)||((*value) > 1.0))
+	{
+		fprintf(stderr,"Parse_Arguments:Illegal probability %s (0..1).\n",string);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Listen_Port
+ * @see #Upstream_Hostname
+ * @see #Upstream_Port
+ * @see #Latency_MS
+ * @see #Jitter_MS
+ * @see #Bandwidth
+ * @see #Error_Rate
+ * @see #Error_Code
+ * @see #Reset_Rate
+ * @see #Truncate_Rate
+ * @see #Fault_Byte_Range
+ * @see #Random_Seed
+ * @see #Verbose
+ * @see #Parse_Probability
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	char *colon_ptr = NULL;
+	int i;
+
+	for(i=1;i<argc;i++)
+	{
+		/* arguments without a value */
+		if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-v")==0)||(strcmp(argv[i],"-verbose")==0))
+		{
+			Verbose = TRUE;
+			continue;
+		}
+		/* all other arguments take a value */
+		if((i+1)>=argc)
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' requires a value.\n",argv[i]);
+			return FALSE;
+		}
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bandwidth")==0))
+		{
+			if(sscanf(argv[i+1],"%lld",&Bandwidth) != 1)
+			{
+				fprintf(stderr,"Parse_Arguments:Failed to parse bandwidth %s.\n",argv[i+1]);
+				return FALSE;
+			}
+			i++;
+		}
+		else if((strcmp(argv[i],"-e")==0)||(strcmp(argv[i],"-error_rate")==0))
+		{
+			if(!Parse_Probability(argv[i+1],&Error_Rate))
+				return FALSE;
+			i++;
+		}
+		else if((strcmp(argv[i],"-error_code")==0))
+		{
+			if((sscanf(argv[i+1],"%d",&Error_Code) != 1)||
+			   ((Error_Code != 0)&&(Error_Code != 429)&&(Error_Code != 503)))
+			{
+				fprintf(stderr,"Parse_Arguments:Illegal error code %s (429, 503 or 0 for both).\n",argv[i+1]);
+				return FALSE;
+			}
+			i++;
+		}
+		else if((strcmp(argv[i],"-fault_bytes")==0))
+		{
+			if((sscanf(argv[i+1],"%lld",&Fault_Byte_Range) != 1)||(Fault_Byte_Range < 0))
+			{
+				fprintf(stderr,"Parse_Arguments:Failed to parse fault byte range %s.\n",argv[i+1]);
+				return FALSE;
+			}
+			i++;
+		}
+		else if((strcmp(argv[i],"-j")==0)||(strcmp(argv[i],"-jitter")==0))
+		{
+			if(sscanf(argv[i+1],"%d",&Jitter_MS) != 1)
+			{
+				fprintf(stderr,"Parse_Arguments:Failed to parse jitter %s.\n",argv[i+1]);
+				return FALSE;
+			}
+			i++;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-latency")==0))
+		{
+			if(sscanf(argv[i+1],"%d",&Latency_MS) != 1)
+			{
+				fprintf(stderr,"Parse_Arguments:Failed to parse latency %s.\n",argv[i+1]);
+				return FALSE;
+			}
+			i++;
+		}
+		else if((strcmp(argv[i],"-p")==0)||(strcmp(argv[i],"-port")==0))
+		{
+			if(sscanf(argv[i+1],"%d",&Listen_Port) != 1)
+			{
+				fprintf(stderr,"Parse_Arguments:Failed to parse port %s.\n",argv[i+1]);
+				return FALSE;
+			}
+			i++;
+		}
+		else if((strcmp(argv[i],"-r")==0)||(strcmp(argv[i],"-reset_rate")==0))
+		{
+			if(!Parse_Probability(argv[i+1],&Reset_Rate))
+				return FALSE;
+			i++;
+		}
+		else if((strcmp(argv[i],"-s")==0)||(strcmp(argv[i],"-seed")==0))
+		{
+			if(sscanf(argv[i+1],"%u",&Random_Seed) != 1)
+			{
+				fprintf(stderr,"Parse_Arguments:Failed to parse seed %s.\n",argv[i+1]);
+				return FALSE;
+			}
+			i++;
+		}
+		else if((strcmp(argv[i],"-t")==0)||(strcmp(argv[i],"-truncate_rate")==0))
+		{
+			if(!Parse_Probability(argv[i+1],&Truncate_Rate))
+				return FALSE;
+			i++;
+		}
+		else if((strcmp(argv[i],"-u")==0)||(strcmp(argv[i],"-upstream")==0))
+		{
+			strncpy(Upstream_Hostname,argv[i+1],STRING_LENGTH);
+			Upstream_Hostname[STRING_LENGTH-1] = '\0';
+			colon_ptr = strrchr(Upstream_Hostname,':');
+			if(colon_ptr == NULL)
+			{
+				fprintf(stderr,"Parse_Arguments:-upstream requires <hostname>:<port>.\n");
+				return FALSE;
+			}
+			(*colon_ptr) = '\0';
+			if(sscanf(colon_ptr+1,"%d",&Upstream_Port) != 1)
+			{
+				fprintf(stderr,"Parse_Arguments:Failed to parse upstream port %s.\n",colon_ptr+1);
+				return FALSE;
+			}
+			i++;
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test Fault Proxy:Help.\n");
+	fprintf(stdout,"This program is a fault and latency injecting HTTP proxy, to put in front of a local storage\n");
+	fprintf(stdout,"emulator. Point the library at it with CLOUD_STORAGE_EMULATOR_ENDPOINT=http://localhost:<port>.\n");
+	fprintf(stdout,"test_fault_proxy [-p[ort] <port>][-u[pstream] <hostname>:<port>][-l[atency] <ms>][-j[itter] <ms>]\n");
+	fprintf(stdout,"\t[-b[andwidth] <bytes/s>][-e[rror_rate] <0..1>][-error_code <429|503|0>][-r[eset_rate] <0..1>]\n");
+	fprintf(stdout,"\t[-t[runcate_rate] <0..1>][-fault_bytes <n>][-s[eed] <n>][-v[erbose]][-help].\n");
+	fprintf(stdout,"\t-port is the local port to listen on (default 9001).\n");
+	fprintf(stdout,"\t-upstream is the emulator to forward to (default localhost:9000).\n");
+	fprintf(stdout,"\t-latency and -jitter add a delay before the first byte of each response.\n");
+	fprintf(stdout,"\t-bandwidth caps each connection's throughput in each direction.\n");
+	fprintf(stdout,"\t-error_rate is the probability a request gets a 429/503 reply (-error_code 0 chooses either).\n");
+	fprintf(stdout,"\t-reset_rate is the probability a response is cut off with a TCP reset.\n");
+	fprintf(stdout,"\t-truncate_rate is the probability a response is cut off by closing the connection.\n");
+	fprintf(stdout,"\t-fault_bytes is the maximum number of response bytes sent before a reset/truncation.\n");
+	fprintf(stdout,"\t-seed seeds the fault selection, so runs are repeatable.\n");
+}
@@ -0,0 +1,277 @@
+/* test_fits_query.c
+*/
+/**
+ * Test querying FITS frames by their indexed header keywords with GCP_Client_Fits_Query, for instance
+ * test_fits_query -bucket lt-frames -prefix 2026/ -where "OBJECT=M31,EXPTIME>60". The matching objects,
+ * and their indexed keywords, are printed, followed by the number of matches and the time taken.
+ * The frames must have been uploaded with FITS indexing enabled (e.g. gcp_uploader -fits_index).
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_connection.h"
+#include "gcp_client_fits.h"
+#include "gcp_client_list.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH           (256)
+/**
+ * Verbosity log level : initialised to 0 (no library logging).
+ */
+static int Log_Level = 0;
+/**
+ * The name of the google cloud storage bucket containing the frames.
+ */
+static char Bucket_Name[STRING_LENGTH];
+/**
+ * The storage emulator endpoint URL (e.g. http://localhost:9000), or an empty string to use google cloud storage.
+ */
+static char Endpoint[STRING_LENGTH] = "";
+/**
+ * Only objects whose names start with this prefix are queried. An empty string queries the whole bucket.
+ */
+static char Prefix[STRING_LENGTH] = "";
+/**
+ * The query conditions, e.g. "OBJECT=M31,EXPTIME>60". An empty string matches every indexed object.
+ */
+static char Where[STRING_LENGTH] = "";
+
+static int Query_Callback(const struct GCP_Client_Object_Metadata_Struct *object,
+			  const struct GCP_Client_Fits_Keyword_Struct *keyword_list,int keyword_count,
+			  void *user_data);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>We parse the query conditions with GCP_Client_Fits_Condition_Parse.
+ * <li>If an emulator endpoint was specified, we set the CLOUD_STORAGE_EMULATOR_ENDPOINT environment variable.
+ * <li>We connect to the google cloud by calling GCP_Client_Connection_Open.
+ * <li>We run the query with GCP_Client_Fits_Query, printing each match in Query_Callback.
+ * <li>We print the number of matches and the time taken.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @see #Parse_Arguments
+ * @see #Query_Callback
+ * @see #Bucket_Name
+ * @see #Prefix
+ * @see #Where
+ * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
+ * @see ../cdocs/gcp_client_fits.html#GCP_Client_Fits_Condition_Parse
+ * @see ../cdocs/gcp_client_fits.html#GCP_Client_Fits_Query
+ */
+int main(int argc, char *argv[])
+{
+	struct GCP_Client_Fits_Condition_Struct condition_list[GCP_CLIENT_FITS_MAX_CONDITION_COUNT];
+	struct timespec start_time,end_time;
+	int condition_count,match_count;
+
+	fprintf(stderr,"test_fits_query : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	if(strlen(Bucket_Name) == 0)
+	{
+		fprintf(stderr,"test_fits_query : No bucket specified.\n");
+		return 1;
+	}
+	if(!GCP_Client_Fits_Condition_Parse(Where,condition_list,GCP_CLIENT_FITS_MAX_CONDITION_COUNT,
+					    &condition_count))
+	{
+		GCP_Client_General_Error();
+		return 1;
+	}
+	if(Log_Level > 0)
+	{
+		GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+		GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+		GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+	}
+	if(strlen(Endpoint) > 0)
+	{
+		fprintf(stderr,"test_fits_query : Using emulator endpoint '%s'.\n",Endpoint);
+		setenv("CLOUD_STORAGE_EMULATOR_ENDPOINT",Endpoint,1);
+	}
+	fprintf(stderr,"test_fits_query : Opening client connection.\n");
+	if(!GCP_Client_Connection_Open())
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	fprintf(stderr,"test_fits_query : Querying bucket '%s' prefix '%s' with %d conditions.\n",Bucket_Name,
+		Prefix,condition_count);
+	match_count = 0;
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	if(!GCP_Client_Fits_Query(Bucket_Name,(strlen(Prefix) > 0) ? Prefix : NULL,condition_list,condition_count,
+				  Query_Callback,&match_count))
+	{
+		GCP_Client_General_Error();
+		return 3;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	fprintf(stderr,"test_fits_query : %d objects matched in %.3f seconds.\n",match_count,
+		fdifftime(end_time,start_time));
+	fprintf(stderr,"test_fits_query : finished.\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Query callback. Prints the object's name and size, and it's indexed keywords, and counts the match.
+ * @param object The matching object's metadata.
+ * @param keyword_list The object's indexed keywords.
+ * @param keyword_count The number of keywords in keyword_list.
+ * @param user_data A pointer to the integer match count.
+ * @return TRUE, to continue the query.
+ */
+static int Query_Callback(const struct GCP_Client_Object_Metadata_Struct *object,
+			  const struct GCP_Client_Fits_Keyword_Struct *keyword_list,int keyword_count,
+			  void *user_data)
+{
+	int i;
+
+	fprintf(stdout,"%s %llu",object->Name,object->Size);
+	for(i = 0; i < keyword_count; i++)
+		fprintf(stdout," %s=%s",keyword_list[i].Name,keyword_list[i].Value);
+	fprintf(stdout,"\n");
+	(*(int *)user_data)++;
+	return TRUE;
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #Bucket_Name
+ * @see #Endpoint
+ * @see #Prefix
+ * @see #Where
+ * @see #Log_Level
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Bucket_Name,argv[i+1],STRING_LENGTH);
+				Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-e")==0)||(strcmp(argv[i],"-endpoint")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Endpoint,argv[i+1],STRING_LENGTH);
+				Endpoint[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-endpoint requires an emulator URL.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-p")==0)||(strcmp(argv[i],"-prefix")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Prefix,argv[i+1],STRING_LENGTH);
+				Prefix[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-prefix requires an object name prefix.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-w")==0)||(strcmp(argv[i],"-where")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Where,argv[i+1],STRING_LENGTH);
+				Where[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-where requires a list of conditions.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test Fits Query:Help.\n");
+	fprintf(stdout,"This program finds FITS frames by their indexed header keywords, without downloading them.\n");
+	fprintf(stdout,"test_fits_query -b[ucket] <bucket name> [-p[refix] <prefix>][-w[here] <conditions>]\n");
+	fprintf(stdout,"\t[-e[ndpoint] <url>][-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\t-bucket selects which google cloud bucket to use.\n");
+	fprintf(stdout,"\t-prefix only queries objects whose names start with the prefix.\n");
+	fprintf(stdout,"\t-where is a comma separated list of conditions, all of which must match, e.g.\n");
+	fprintf(stdout,"\t\t\"OBJECT=M31,EXPTIME>60\". The operators are =, !=, <, <=, > and >=.\n");
+	fprintf(stdout,"\t\tNumbers are compared numerically, anything else as strings.\n");
+	fprintf(stdout,"\t-endpoint sets a storage emulator URL (CLOUD_STORAGE_EMULATOR_ENDPOINT).\n");
+	fprintf(stdout,"\tThe frames must have been uploaded with FITS indexing enabled (gcp_uploader -fits_index).\n");
+}
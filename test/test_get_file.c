@@ -16,6 +16,7 @@
 #include "log_udp.h"
 #include "gcp_client_general.h"
 #include "gcp_client_connection.h"
+#include "gcp_client_operation.h"
 #include "gcp_client_read_write.h"
 
 /**
@@ -38,6 +39,14 @@ static char Google_Filename[STRING_LENGTH];
  * The name of a local filename to save the downloaded data into.
  */
 static char Local_Filename[STRING_LENGTH];
+/**
+ * How long the download can take, in milliseconds, or 0 for no deadline.
+ */
+static int Deadline = 0;
+/**
+ * How long the download can go without receiving any bytes, in milliseconds, or 0 for the library default.
+ */
+static int Stall_Timeout = 0;
 
 static int Save_File(char *filename,void *file_contents,size_t file_contents_length);
 static int Parse_Arguments(int argc, char *argv[]);
@@ -53,6 +62,8 @@ static void Help(void);
  * <li>We setup the GCP_Client library logging.
  * <li>We connect to the google cloud by calling GCP_Client_Connection_Open.
  * <li>We read the specified google file from the specified google bucket into memory (GCP_Client_Read_Write_Read).
+ *     If a deadline or stall timeout was specified, we create an operation with them, and read the file with
+ *     GCP_Client_Read_Write_Read_Operation instead.
  * <li>We save the read data into the specified local filename (Save_File).
  * </ul>
  * @param argc The number of arguments to the program.
@@ -62,6 +73,8 @@ static void Help(void);
  * @see #Bucket_Name
  * @see #Google_Filename
  * @see #Local_Filename
+ * @see #Deadline
+ * @see #Stall_Timeout
  * @see #Save_File
  * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
  * @see ../cdocs/gcp_client_general.html#GCP_Client_General_Set_Log_Filter_Level
@@ -70,11 +83,19 @@ static void Help(void);
  * @see ../cdocs/gcp_client_general.html#GCP_Client_General_Set_Log_Handler_Function
  * @see ../cdocs/gcp_client_general.html#GCP_Client_General_Log_Handler_Stdout
  * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Read
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Read_Operation
+ * @see ../cdocs/gcp_client_operation.html#GCP_Client_Operation_Create
+ * @see ../cdocs/gcp_client_operation.html#GCP_Client_Operation_Set_Deadline
+ * @see ../cdocs/gcp_client_operation.html#GCP_Client_Operation_Set_Stall_Timeout
+ * @see ../cdocs/gcp_client_operation.html#GCP_Client_Operation_Get_State
  */
 int main(int argc, char *argv[])
 {
+	struct GCP_Client_Operation_Struct *operation = NULL;
 	void *file_contents = NULL;
 	size_t file_contents_length;
+	unsigned long long byte_count;
+	int retval,state;
 	
 	/* parse arguments */
 	fprintf(stdout,"test_get_file : Parsing Arguments.\n");
@@ -93,7 +114,35 @@ int main(int argc, char *argv[])
 	}
 	/* get the google file into memory */
 	fprintf(stdout,"test_get_file : Reading google file '%s' from bucket '%s'.\n",Google_Filename,Bucket_Name);
-	if(!GCP_Client_Read_Write_Read(Bucket_Name,Google_Filename,&file_contents,&file_contents_length))
+	if((Deadline > 0)||(Stall_Timeout > 0))
+	{
+		fprintf(stdout,"test_get_file : Using a deadline of %d ms and a stall timeout of %d ms.\n",
+			Deadline,Stall_Timeout);
+		if(!GCP_Client_Operation_Create(&operation))
+		{
+			GCP_Client_General_Error();
+			return 3;
+		}
+		if(!GCP_Client_Operation_Set_Deadline(operation,Deadline))
+		{
+			GCP_Client_General_Error();
+			return 3;
+		}
+		if(!GCP_Client_Operation_Set_Stall_Timeout(operation,Stall_Timeout))
+		{
+			GCP_Client_General_Error();
+			return 3;
+		}
+		retval = GCP_Client_Read_Write_Read_Operation(operation,Bucket_Name,Google_Filename,&file_contents,
+							      &file_contents_length);
+		GCP_Client_Operation_Get_State(operation,&state,&byte_count);
+		fprintf(stdout,"test_get_file : Read operation ended %s after %llu bytes.\n",
+			GCP_Client_Operation_State_To_String(state),byte_count);
+		GCP_Client_Operation_Destroy(operation);
+	}
+	else
+		retval = GCP_Client_Read_Write_Read(Bucket_Name,Google_Filename,&file_contents,&file_contents_length);
+	if(!retval)
 	{
 		GCP_Client_General_Error();
 		return 3;
@@ -160,6 +209,8 @@ int Save_File(char *filename,void *file_contents,size_t file_contents_length)
  * @see #Google_Filename
  * @see #Local_Filename
  * @see #Log_Level
+ * @see #Deadline
+ * @see #Stall_Timeout
  * @see #Help
  */
 static int Parse_Arguments(int argc, char *argv[])
@@ -182,6 +233,24 @@ static int Parse_Arguments(int argc, char *argv[])
 				return FALSE;
 			}
 		}
+		else if((strcmp(argv[i],"-d")==0)||(strcmp(argv[i],"-deadline")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Deadline);
+				if((retval != 1)||(Deadline < 0))
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse deadline %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-deadline requires a number of milliseconds.\n");
+				return FALSE;
+			}
+		}
 		else if((strcmp(argv[i],"-g")==0)||(strcmp(argv[i],"-google_filename")==0))
 		{
 			if((i+1)<argc)
@@ -233,6 +302,24 @@ static int Parse_Arguments(int argc, char *argv[])
 				return FALSE;
 			}
 		}
+		else if((strcmp(argv[i],"-s")==0)||(strcmp(argv[i],"-stall_timeout")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Stall_Timeout);
+				if((retval != 1)||(Stall_Timeout < 0))
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse stall timeout %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-stall_timeout requires a number of milliseconds.\n");
+				return FALSE;
+			}
+		}
 		else
 		{
 			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
@@ -250,9 +337,12 @@ static void Help(void)
 	fprintf(stdout,"Test Get File:Help.\n");
 	fprintf(stdout,"This program calls downloads a file from google cloud storage and saves it locally.\n");
 	fprintf(stdout,"test_get_file -b[ucket] <bucket name> -g[oogle_filename] <filename>\n");
-	fprintf(stdout,"\t-o[utput_filename] <filename>[-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\t-o[utput_filename] <filename>[-help][-l[og_level <0..5>]\n");
+	fprintf(stdout,"\t[-d[eadline] <ms>][-s[tall_timeout] <ms>].\n");
 	fprintf(stdout,"\t-bucket selects which google cloud bucket to interact with.\n");
 	fprintf(stdout,"\t-google_filename selects which google cloud filename to download.\n");
 	fprintf(stdout,"\t-output_filename selects a local filename to save the downloaded file into.\n");
+	fprintf(stdout,"\t-deadline stops the download if it has not finished after this many milliseconds.\n");
+	fprintf(stdout,"\t-stall_timeout stops the download if no bytes arrive for this many milliseconds.\n");
 	fprintf(stdout,"\tThe application default login is used (see 'gcloud auth application-default login').\n");
 }
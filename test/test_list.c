@@ -0,0 +1,381 @@
+/* test_list.c
+*/
+/**
+ * Test listing the objects in a Google Cloud Services bucket.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_connection.h"
+#include "gcp_client_list.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH        (256)
+/**
+ * The maximum number of boundaries that can be specified for a parallel listing.
+ */
+#define MAX_BOUNDARY_COUNT   (64)
+/**
+ * Verbosity log level : initialised to LOG_VERBOSITY_VERY_VERBOSE.
+ */
+static int Log_Level = LOG_VERBOSITY_VERY_VERBOSE;
+/**
+ * The name of the google cloud storage bucket to list.
+ */
+static char Bucket_Name[STRING_LENGTH];
+/**
+ * The object name prefix to list, or NULL to list the whole bucket.
+ */
+static char *Prefix = NULL;
+/**
+ * The delimiter to use to emulate directories, or NULL.
+ */
+static char *Delimiter = NULL;
+/**
+ * The object name to start listing from, or NULL.
+ */
+static char *Start_Offset = NULL;
+/**
+ * The object name to stop listing before, or NULL.
+ */
+static char *End_Offset = NULL;
+/**
+ * The number of objects in each page passed to the callback. 0 selects the library default.
+ */
+static int Page_Size = 0;
+/**
+ * The list of boundaries to split a parallel listing at.
+ */
+static char *Boundary_List[MAX_BOUNDARY_COUNT];
+/**
+ * The number of boundaries in Boundary_List. If this is non-zero, a parallel listing is done.
+ */
+static int Boundary_Count = 0;
+/**
+ * If TRUE, only count the objects, don't print each one.
+ */
+static int Count_Only = FALSE;
+/**
+ * The number of objects listed so far.
+ */
+static unsigned long long Object_Count = 0;
+/**
+ * The total size of the objects listed so far, in bytes.
+ */
+static unsigned long long Total_Size = 0;
+
+static int List_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+			 void *user_data);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>We setup the GCP_Client library logging.
+ * <li>We connect to the google cloud by calling GCP_Client_Connection_Open.
+ * <li>We list the bucket, with GCP_Client_List_Parallel if boundaries were specified,
+ *     otherwise GCP_Client_List, printing each object in List_Callback.
+ * <li>We print the number of objects listed, their total size, and the time taken.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @see #Parse_Arguments
+ * @see #List_Callback
+ * @see #Log_Level
+ * @see #Bucket_Name
+ * @see #Boundary_Count
+ * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
+ * @see ../cdocs/gcp_client_general.html#GCP_Client_General_Set_Log_Filter_Level
+ * @see ../cdocs/gcp_client_general.html#GCP_Client_General_Set_Log_Filter_Function
+ * @see ../cdocs/gcp_client_general.html#GCP_Client_General_Log_Filter_Level_Absolute
+ * @see ../cdocs/gcp_client_general.html#GCP_Client_General_Set_Log_Handler_Function
+ * @see ../cdocs/gcp_client_general.html#GCP_Client_General_Log_Handler_Stdout
+ * @see ../cdocs/gcp_client_list.html#GCP_Client_List
+ * @see ../cdocs/gcp_client_list.html#GCP_Client_List_Parallel
+ */
+int main(int argc, char *argv[])
+{
+	struct timespec start_time,end_time;
+	int retval;
+
+	/* parse arguments */
+	fprintf(stdout,"test_list : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	fprintf(stdout,"test_list : Setting up gcp_client logging.\n");
+	GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+	GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+	GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+	/* open connection using the application-default gcloud authentication */
+	fprintf(stdout,"test_list : Opening client connection.\n");
+	if(!GCP_Client_Connection_Open())
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	fprintf(stdout,"test_list : Listing bucket '%s'.\n",Bucket_Name);
+	clock_gettime(CLOCK_REALTIME,&start_time);
+	if(Boundary_Count > 0)
+	{
+		retval = GCP_Client_List_Parallel(Bucket_Name,Prefix,Boundary_List,Boundary_Count,Page_Size,
+						  List_Callback,NULL);
+	}
+	else
+	{
+		retval = GCP_Client_List(Bucket_Name,Prefix,Delimiter,Start_Offset,End_Offset,Page_Size,
+					 List_Callback,NULL);
+	}
+	clock_gettime(CLOCK_REALTIME,&end_time);
+	if(retval == FALSE)
+	{
+		GCP_Client_General_Error();
+		return 3;
+	}
+	fprintf(stdout,"test_list : Listed %llu objects of total size %llu bytes in %.3f seconds.\n",
+		Object_Count,Total_Size,fdifftime(end_time,start_time));
+	fprintf(stdout,"test_list : finished.\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Listing callback. Prints each object (unless Count_Only is set), and adds it to the totals.
+ * @param object_list The page of objects.
+ * @param object_count The number of objects in the page.
+ * @param user_data Unused.
+ * @return TRUE, to continue the listing.
+ * @see #Count_Only
+ * @see #Object_Count
+ * @see #Total_Size
+ */
+static int List_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+			 void *user_data)
+{
+	char time_string[32];
+	struct tm updated_tm;
+	int i;
+
+	for(i = 0; i < object_count; i++)
+	{
+		if(Count_Only == FALSE)
+		{
+			if(object_list[i].Is_Prefix)
+			{
+				fprintf(stdout,"%-64s PREFIX\n",object_list[i].Name);
+			}
+			else
+			{
+				gmtime_r(&(object_list[i].Updated.tv_sec),&updated_tm);
+				strftime(time_string,32,"%Y-%m-%dT%H:%M:%S",&updated_tm);
+				fprintf(stdout,"%-64s %12llu %16lld %08x %s\n",object_list[i].Name,object_list[i].Size,
+					object_list[i].Generation,object_list[i].CRC32C,time_string);
+			}
+		}
+		Total_Size += object_list[i].Size;
+	}
+	Object_Count += object_count;
+	return TRUE;
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #MAX_BOUNDARY_COUNT
+ * @see #Bucket_Name
+ * @see #Prefix
+ * @see #Delimiter
+ * @see #Start_Offset
+ * @see #End_Offset
+ * @see #Page_Size
+ * @see #Boundary_List
+ * @see #Boundary_Count
+ * @see #Count_Only
+ * @see #Log_Level
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	char *boundary_ptr = NULL;
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Bucket_Name,argv[i+1],STRING_LENGTH);
+				Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-boundaries")==0)
+		{
+			if((i+1)<argc)
+			{
+				Boundary_Count = 0;
+				boundary_ptr = strtok(argv[i+1],",");
+				while(boundary_ptr != NULL)
+				{
+					if(Boundary_Count >= MAX_BOUNDARY_COUNT)
+					{
+						fprintf(stderr,"Parse_Arguments:Too many boundaries (max %d).\n",
+							MAX_BOUNDARY_COUNT);
+						return FALSE;
+					}
+					Boundary_List[Boundary_Count++] = boundary_ptr;
+					boundary_ptr = strtok(NULL,",");
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-boundaries requires a comma separated list of names.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-c")==0)||(strcmp(argv[i],"-count_only")==0))
+		{
+			Count_Only = TRUE;
+		}
+		else if((strcmp(argv[i],"-d")==0)||(strcmp(argv[i],"-delimiter")==0))
+		{
+			if((i+1)<argc)
+			{
+				Delimiter = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-delimiter requires a delimiter string.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-end_offset")==0)
+		{
+			if((i+1)<argc)
+			{
+				End_Offset = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-end_offset requires an object name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-p")==0)||(strcmp(argv[i],"-prefix")==0))
+		{
+			if((i+1)<argc)
+			{
+				Prefix = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-prefix requires an object name prefix.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-page_size")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Page_Size);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse page size %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-page_size requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-start_offset")==0)
+		{
+			if((i+1)<argc)
+			{
+				Start_Offset = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-start_offset requires an object name.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test List:Help.\n");
+	fprintf(stdout,"This program lists the objects in a google cloud storage bucket.\n");
+	fprintf(stdout,"test_list -b[ucket] <bucket name> [-p[refix] <prefix>][-d[elimiter] <delimiter>]\n");
+	fprintf(stdout,"\t[-start_offset <name>][-end_offset <name>][-page_size <n>][-boundaries <name>,<name>...]\n");
+	fprintf(stdout,"\t[-c[ount_only]][-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\t-bucket selects which google cloud bucket to list.\n");
+	fprintf(stdout,"\t-prefix only lists objects whose names start with the prefix.\n");
+	fprintf(stdout,"\t-delimiter returns common prefixes up to the delimiter (e.g. '/') as directories.\n");
+	fprintf(stdout,"\t-start_offset/-end_offset limit the listing to a range of object names.\n");
+	fprintf(stdout,"\t-boundaries splits the listing into ranges at the names, listed in parallel.\n");
+	fprintf(stdout,"\t-count_only just prints the number and total size of the objects.\n");
+	fprintf(stdout,"\tThe application default login is used (see 'gcloud auth application-default login').\n");
+}
@@ -0,0 +1,412 @@
+/* test_log_udp.c
+*/
+/**
+ * Test the batched UDP log handler. A local UDP listener is started on the loopback interface,
+ * the gcp_client library is configured to log to it using GCP_Client_Log_UDP_Handler, and a burst of log messages
+ * is generated. The received datagrams are checked for message ordering, and the number of messages received plus
+ * the number reported dropped is checked against the number logged.
+ * This test does not need a google cloud connection.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_log_udp.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH        (256)
+/**
+ * The length of the buffer used to receive datagrams.
+ */
+#define RECEIVE_BUFFER_LENGTH (65536)
+/**
+ * How long the listener waits for more datagrams, once logging has finished, in seconds.
+ */
+#define RECEIVE_TIMEOUT_S    (2)
+
+/**
+ * The number of messages to log.
+ */
+static int Message_Count = 10000;
+/**
+ * The maximum datagram length to configure the handler with (0 means the default).
+ */
+static int Datagram_Length = 0;
+/**
+ * The flush time to configure the handler with, in milliseconds (0 means the default).
+ */
+static int Flush_MS = 0;
+/**
+ * The number of microseconds to sleep between each logged message.
+ */
+static int Message_Delay_US = 0;
+/**
+ * The UDP socket the listener receives datagrams on.
+ */
+static int Listener_Socket_Fd = -1;
+/**
+ * The number of datagrams received by the listener.
+ */
+static int Received_Datagram_Count = 0;
+/**
+ * The number of messages received by the listener.
+ */
+static unsigned long long Received_Message_Count = 0;
+/**
+ * The number of messages received out of order (sequence number not greater than the previous one).
+ */
+static int Out_Of_Order_Count = 0;
+/**
+ * The number of datagrams that could not be parsed, or whose header message count did not match their contents.
+ */
+static int Malformed_Count = 0;
+/**
+ * Set to TRUE by the main thread once logging has finished.
+ */
+static volatile int Logging_Done = FALSE;
+
+static void *Listener_Thread(void *arg);
+static int Parse_Datagram(char *buffer,long long *last_sequence);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>We create a UDP socket bound to an ephemeral port on the loopback interface, and start Listener_Thread
+ *     to receive datagrams from it.
+ * <li>We open the batched UDP log handler to the listener port (GCP_Client_Log_UDP_Open), and configure the
+ *     gcp_client library to use it.
+ * <li>We log Message_Count messages.
+ * <li>We close the handler (GCP_Client_Log_UDP_Close) to flush the final batch, and get it's statistics.
+ * <li>We wait for the listener to finish, and compare it's counts to the handler statistics.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return The program returns 0 if the test passed, and non-zero if it failed.
+ * @see #Parse_Arguments
+ * @see #Listener_Thread
+ * @see #Message_Count
+ * @see ../cdocs/gcp_client_log_udp.html#GCP_Client_Log_UDP_Open
+ * @see ../cdocs/gcp_client_log_udp.html#GCP_Client_Log_UDP_Handler
+ * @see ../cdocs/gcp_client_log_udp.html#GCP_Client_Log_UDP_Close
+ * @see ../cdocs/gcp_client_log_udp.html#GCP_Client_Log_UDP_Get_Statistics
+ */
+int main(int argc, char *argv[])
+{
+	struct sockaddr_in address;
+	socklen_t address_length;
+	pthread_t listener_thread;
+	unsigned long long message_count,sent_count,dropped_count,datagram_count;
+	int i,receive_buffer_length,failed;
+
+	fprintf(stdout,"test_log_udp : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	/* create a listener socket on an ephemeral loopback port */
+	Listener_Socket_Fd = socket(AF_INET,SOCK_DGRAM,0);
+	if(Listener_Socket_Fd < 0)
+	{
+		fprintf(stderr,"test_log_udp : Failed to create listener socket (%d).\n",errno);
+		return 2;
+	}
+	receive_buffer_length = 4*1024*1024;
+	setsockopt(Listener_Socket_Fd,SOL_SOCKET,SO_RCVBUF,&receive_buffer_length,sizeof(int));
+	memset(&address,0,sizeof(struct sockaddr_in));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	if(bind(Listener_Socket_Fd,(struct sockaddr *)&address,sizeof(struct sockaddr_in)) != 0)
+	{
+		fprintf(stderr,"test_log_udp : Failed to bind listener socket (%d).\n",errno);
+		return 2;
+	}
+	address_length = sizeof(struct sockaddr_in);
+	getsockname(Listener_Socket_Fd,(struct sockaddr *)&address,&address_length);
+	fprintf(stdout,"test_log_udp : Listening on port %d.\n",ntohs(address.sin_port));
+	if(pthread_create(&listener_thread,NULL,Listener_Thread,NULL) != 0)
+	{
+		fprintf(stderr,"test_log_udp : Failed to create listener thread.\n");
+		return 2;
+	}
+	/* configure gcp_client logging to the listener */
+	if(!GCP_Client_Log_UDP_Open("127.0.0.1",ntohs(address.sin_port),Datagram_Length,Flush_MS))
+	{
+		GCP_Client_General_Error();
+		return 3;
+	}
+	GCP_Client_General_Set_Log_Filter_Level(LOG_VERBOSITY_VERY_VERBOSE);
+	GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+	GCP_Client_General_Set_Log_Handler_Function(GCP_Client_Log_UDP_Handler);
+	fprintf(stdout,"test_log_udp : Logging %d messages.\n",Message_Count);
+	for(i = 0; i < Message_Count; i++)
+	{
+		GCP_Client_General_Log_Format(LOG_VERBOSITY_VERBOSE,"test_log_udp:Test message %d of %d.",
+					      i,Message_Count);
+		if(Message_Delay_US > 0)
+			usleep(Message_Delay_US);
+	}
+	GCP_Client_General_Set_Log_Handler_Function(NULL);
+	if(!GCP_Client_Log_UDP_Close())
+	{
+		GCP_Client_General_Error();
+		return 4;
+	}
+	GCP_Client_Log_UDP_Get_Statistics(&message_count,&sent_count,&dropped_count,&datagram_count);
+	Logging_Done = TRUE;
+	pthread_join(listener_thread,NULL);
+	close(Listener_Socket_Fd);
+	fprintf(stdout,"test_log_udp : Handler: messages %llu sent %llu dropped %llu datagrams %llu.\n",
+		message_count,sent_count,dropped_count,datagram_count);
+	fprintf(stdout,"test_log_udp : Listener: messages %llu datagrams %d out of order %d malformed %d.\n",
+		Received_Message_Count,Received_Datagram_Count,Out_Of_Order_Count,Malformed_Count);
+	failed = FALSE;
+	if(message_count != (unsigned long long)Message_Count)
+	{
+		fprintf(stdout,"test_log_udp : FAILED: handler counted %llu messages, %d were logged.\n",
+			message_count,Message_Count);
+		failed = TRUE;
+	}
+	if((sent_count+dropped_count) != message_count)
+	{
+		fprintf(stdout,"test_log_udp : FAILED: sent %llu + dropped %llu != messages %llu.\n",
+			sent_count,dropped_count,message_count);
+		failed = TRUE;
+	}
+	if(Received_Message_Count != sent_count)
+	{
+		fprintf(stdout,"test_log_udp : FAILED: received %llu messages, but %llu were sent.\n",
+			Received_Message_Count,sent_count);
+		failed = TRUE;
+	}
+	if((Out_Of_Order_Count > 0)||(Malformed_Count > 0))
+	{
+		fprintf(stdout,"test_log_udp : FAILED: %d messages out of order, %d malformed datagrams.\n",
+			Out_Of_Order_Count,Malformed_Count);
+		failed = TRUE;
+	}
+	if(failed)
+		return 5;
+	fprintf(stdout,"test_log_udp : PASSED.\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Listener thread. Receives datagrams on Listener_Socket_Fd and passes them to Parse_Datagram,
+ * until logging has finished and no datagram has arrived for RECEIVE_TIMEOUT_S seconds.
+ * @param arg Thread argument, not used.
+ * @return The routine returns NULL.
+ * @see #Listener_Socket_Fd
+ * @see #Logging_Done
+ * @see #Parse_Datagram
+ * @see #RECEIVE_BUFFER_LENGTH
+ * @see #RECEIVE_TIMEOUT_S
+ */
+static void *Listener_Thread(void *arg)
+{
+	static char buffer[RECEIVE_BUFFER_LENGTH];
+	struct timeval timeout;
+	long long last_sequence = -1;
+	ssize_t length;
+
+	timeout.tv_sec = RECEIVE_TIMEOUT_S;
+	timeout.tv_usec = 0;
+	setsockopt(Listener_Socket_Fd,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(struct timeval));
+	while(TRUE)
+	{
+		length = recv(Listener_Socket_Fd,buffer,RECEIVE_BUFFER_LENGTH-1,0);
+		if(length < 0)
+		{
+			if(Logging_Done)
+				break;
+			continue;
+		}
+		buffer[length] = '\0';
+		Received_Datagram_Count++;
+		if(!Parse_Datagram(buffer,&last_sequence))
+			Malformed_Count++;
+	}
+	return NULL;
+}
+
+/**
+ * Parse a received datagram. The header line is parsed, and then each message line's sequence number is checked
+ * to be greater than the last one received.
+ * @param buffer The NULL terminated datagram contents.
+ * @param last_sequence The address of the sequence number of the last message received, updated on return.
+ * @return The routine returns TRUE if the datagram was well formed, and FALSE otherwise.
+ * @see #Received_Message_Count
+ * @see #Out_Of_Order_Count
+ * @see ../cdocs/gcp_client_log_udp.html#GCP_CLIENT_LOG_UDP_DATAGRAM_HEADER
+ */
+static int Parse_Datagram(char *buffer,long long *last_sequence)
+{
+	char header_string[STRING_LENGTH];
+	char *line_ptr = NULL;
+	char *save_ptr = NULL;
+	unsigned long long first_sequence,dropped_count;
+	long long sequence;
+	int count,line_count;
+
+	line_ptr = strtok_r(buffer,"\n",&save_ptr);
+	if(line_ptr == NULL)
+		return FALSE;
+	if(sscanf(line_ptr,"%255s %llu %d %llu",header_string,&first_sequence,&count,&dropped_count) != 4)
+		return FALSE;
+	if(strcmp(header_string,GCP_CLIENT_LOG_UDP_DATAGRAM_HEADER) != 0)
+		return FALSE;
+	line_count = 0;
+	line_ptr = strtok_r(NULL,"\n",&save_ptr);
+	while(line_ptr != NULL)
+	{
+		if(sscanf(line_ptr,"%lld",&sequence) != 1)
+			return FALSE;
+		if((line_count == 0)&&(sequence != (long long)first_sequence))
+			return FALSE;
+		if(sequence <= (*last_sequence))
+			Out_Of_Order_Count++;
+		(*last_sequence) = sequence;
+		line_count++;
+		Received_Message_Count++;
+		line_ptr = strtok_r(NULL,"\n",&save_ptr);
+	}
+	return (line_count == count);
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Message_Count
+ * @see #Datagram_Length
+ * @see #Flush_MS
+ * @see #Message_Delay_US
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-c")==0)||(strcmp(argv[i],"-count")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse message count %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-count requires a number of messages.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-d")==0)||(strcmp(argv[i],"-datagram_length")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Datagram_Length);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse datagram length %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-datagram_length requires a length in bytes.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-delay")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Delay_US);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse message delay %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-delay requires a number of microseconds.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-f")==0)||(strcmp(argv[i],"-flush_ms")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Flush_MS);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse flush time %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-flush_ms requires a number of milliseconds.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test Log UDP:Help.\n");
+	fprintf(stdout,"This program tests the batched UDP log handler against a local UDP listener.\n");
+	fprintf(stdout,"test_log_udp [-c[ount] <n>][-d[atagram_length] <bytes>][-f[lush_ms] <ms>]\n");
+	fprintf(stdout,"\t[-delay <us>][-help].\n");
+	fprintf(stdout,"\t-count is the number of messages to log.\n");
+	fprintf(stdout,"\t-datagram_length is the maximum batched datagram length.\n");
+	fprintf(stdout,"\t-flush_ms is the longest time a message waits in a partly filled batch.\n");
+	fprintf(stdout,"\t-delay is a delay between logged messages, in microseconds.\n");
+	fprintf(stdout,"\tThe test passes if messages arrive in order, and received + dropped == logged.\n");
+}
@@ -0,0 +1,338 @@
+/* test_manifest.c
+*/
+/**
+ * Test refreshing and querying a local bucket manifest.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_connection.h"
+#include "gcp_client_list.h"
+#include "gcp_client_manifest.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH        (256)
+/**
+ * Verbosity log level : initialised to LOG_VERBOSITY_VERY_VERBOSE.
+ */
+static int Log_Level = LOG_VERBOSITY_VERY_VERBOSE;
+/**
+ * The filename of the manifest.
+ */
+static char Manifest_Filename[STRING_LENGTH];
+/**
+ * The name of the google cloud storage bucket to refresh the manifest from.
+ */
+static char Bucket_Name[STRING_LENGTH];
+/**
+ * If TRUE, refresh the manifest from the bucket.
+ */
+static int Refresh = FALSE;
+/**
+ * The prefix to refresh, or NULL to refresh the whole bucket.
+ */
+static char *Refresh_Prefix = NULL;
+/**
+ * An object name to look up in the manifest, or NULL.
+ */
+static char *Lookup_Name = NULL;
+/**
+ * A prefix to scan the manifest for, or NULL.
+ */
+static char *Scan_Prefix = NULL;
+/**
+ * The number of objects scanned.
+ */
+static unsigned long long Scan_Count = 0;
+
+static void Print_Metadata(const struct GCP_Client_Object_Metadata_Struct *metadata);
+static int Scan_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+			 void *user_data);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>If -refresh was specified, we setup logging, open a connection, and refresh the manifest
+ *     (GCP_Client_Manifest_Refresh).
+ * <li>We open the manifest (GCP_Client_Manifest_Open), and print the time taken and the number of objects.
+ * <li>If -lookup was specified, we look up the object (GCP_Client_Manifest_Lookup) and print it.
+ * <li>If -scan was specified, we scan the prefix (GCP_Client_Manifest_Scan), printing each object.
+ * <li>We close the manifest.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @see #Parse_Arguments
+ * @see #Print_Metadata
+ * @see #Scan_Callback
+ * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
+ * @see ../cdocs/gcp_client_manifest.html#GCP_Client_Manifest_Refresh
+ * @see ../cdocs/gcp_client_manifest.html#GCP_Client_Manifest_Open
+ * @see ../cdocs/gcp_client_manifest.html#GCP_Client_Manifest_Lookup
+ * @see ../cdocs/gcp_client_manifest.html#GCP_Client_Manifest_Scan
+ * @see ../cdocs/gcp_client_manifest.html#GCP_Client_Manifest_Close
+ */
+int main(int argc, char *argv[])
+{
+	struct GCP_Client_Manifest_Struct *manifest = NULL;
+	struct GCP_Client_Object_Metadata_Struct metadata;
+	struct timespec start_time,end_time;
+	int found;
+
+	fprintf(stdout,"test_manifest : Parsing Arguments.\n");
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	if(strlen(Manifest_Filename) == 0)
+	{
+		fprintf(stderr,"test_manifest : No manifest filename specified.\n");
+		return 1;
+	}
+	if(Refresh)
+	{
+		GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+		GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+		GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+		fprintf(stdout,"test_manifest : Opening client connection.\n");
+		if(!GCP_Client_Connection_Open())
+		{
+			GCP_Client_General_Error();
+			return 2;
+		}
+		fprintf(stdout,"test_manifest : Refreshing manifest '%s' from bucket '%s'.\n",Manifest_Filename,
+			Bucket_Name);
+		clock_gettime(CLOCK_REALTIME,&start_time);
+		if(!GCP_Client_Manifest_Refresh(Manifest_Filename,Bucket_Name,Refresh_Prefix,NULL,NULL))
+		{
+			GCP_Client_General_Error();
+			return 3;
+		}
+		clock_gettime(CLOCK_REALTIME,&end_time);
+		fprintf(stdout,"test_manifest : Refresh took %.3f seconds.\n",fdifftime(end_time,start_time));
+	}
+	clock_gettime(CLOCK_REALTIME,&start_time);
+	if(!GCP_Client_Manifest_Open(Manifest_Filename,&manifest))
+	{
+		GCP_Client_General_Error();
+		return 4;
+	}
+	clock_gettime(CLOCK_REALTIME,&end_time);
+	fprintf(stdout,"test_manifest : Opened manifest of bucket '%s' with %llu objects in %.6f seconds.\n",
+		GCP_Client_Manifest_Get_Bucket_Name(manifest),GCP_Client_Manifest_Get_Object_Count(manifest),
+		fdifftime(end_time,start_time));
+	if(Lookup_Name != NULL)
+	{
+		clock_gettime(CLOCK_REALTIME,&start_time);
+		if(!GCP_Client_Manifest_Lookup(manifest,Lookup_Name,&metadata,&found))
+		{
+			GCP_Client_General_Error();
+			GCP_Client_Manifest_Close(&manifest);
+			return 5;
+		}
+		clock_gettime(CLOCK_REALTIME,&end_time);
+		if(found)
+			Print_Metadata(&metadata);
+		else
+			fprintf(stdout,"test_manifest : '%s' not found.\n",Lookup_Name);
+		fprintf(stdout,"test_manifest : Lookup took %.6f seconds.\n",fdifftime(end_time,start_time));
+	}
+	if(Scan_Prefix != NULL)
+	{
+		if(!GCP_Client_Manifest_Scan(manifest,Scan_Prefix,Scan_Callback,NULL))
+		{
+			GCP_Client_General_Error();
+			GCP_Client_Manifest_Close(&manifest);
+			return 6;
+		}
+		fprintf(stdout,"test_manifest : Scanned %llu objects with prefix '%s'.\n",Scan_Count,Scan_Prefix);
+	}
+	GCP_Client_Manifest_Close(&manifest);
+	fprintf(stdout,"test_manifest : finished.\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Print an object's metadata to stdout.
+ * @param metadata The object's metadata.
+ */
+static void Print_Metadata(const struct GCP_Client_Object_Metadata_Struct *metadata)
+{
+	char time_string[32];
+	struct tm updated_tm;
+
+	gmtime_r(&(metadata->Updated.tv_sec),&updated_tm);
+	strftime(time_string,32,"%Y-%m-%dT%H:%M:%S",&updated_tm);
+	fprintf(stdout,"%-64s %12llu %16lld %08x %s\n",metadata->Name,metadata->Size,metadata->Generation,
+		metadata->CRC32C,time_string);
+}
+
+/**
+ * Manifest scan callback. Prints each object and counts them.
+ * @param object_list The page of objects.
+ * @param object_count The number of objects in the page.
+ * @param user_data Unused.
+ * @return TRUE, to continue the scan.
+ * @see #Print_Metadata
+ * @see #Scan_Count
+ */
+static int Scan_Callback(const struct GCP_Client_Object_Metadata_Struct *object_list,int object_count,
+			 void *user_data)
+{
+	int i;
+
+	for(i = 0; i < object_count; i++)
+		Print_Metadata(&(object_list[i]));
+	Scan_Count += object_count;
+	return TRUE;
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #Manifest_Filename
+ * @see #Bucket_Name
+ * @see #Refresh
+ * @see #Refresh_Prefix
+ * @see #Lookup_Name
+ * @see #Scan_Prefix
+ * @see #Log_Level
+ * @see #Help
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Bucket_Name,argv[i+1],STRING_LENGTH);
+				Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-lookup")==0)
+		{
+			if((i+1)<argc)
+			{
+				Lookup_Name = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-lookup requires an object name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-m")==0)||(strcmp(argv[i],"-manifest")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Manifest_Filename,argv[i+1],STRING_LENGTH);
+				Manifest_Filename[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-manifest requires a filename.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-p")==0)||(strcmp(argv[i],"-prefix")==0))
+		{
+			if((i+1)<argc)
+			{
+				Refresh_Prefix = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-prefix requires an object name prefix.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-r")==0)||(strcmp(argv[i],"-refresh")==0))
+		{
+			Refresh = TRUE;
+		}
+		else if(strcmp(argv[i],"-scan")==0)
+		{
+			if((i+1)<argc)
+			{
+				Scan_Prefix = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-scan requires an object name prefix.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"Test Manifest:Help.\n");
+	fprintf(stdout,"This program refreshes and queries a local manifest of a google cloud storage bucket.\n");
+	fprintf(stdout,"test_manifest -m[anifest] <filename> [-r[efresh] -b[ucket] <bucket name> [-p[refix] <prefix>]]\n");
+	fprintf(stdout,"\t[-lookup <object name>][-scan <prefix>][-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\t-refresh lists the bucket (or just the objects under -prefix), and merges the listing\n");
+	fprintf(stdout,"\t\tinto the manifest, creating it if necessary.\n");
+	fprintf(stdout,"\t-lookup prints the metadata of an object, from the manifest.\n");
+	fprintf(stdout,"\t-scan prints the metadata of all the objects starting with the prefix, from the manifest.\n");
+}
@@ -0,0 +1,449 @@
+/* test_microbenchmark.cpp
+*/
+/**
+ * Microbenchmarks (using Google Benchmark) of the gcp_client library's in-memory costs, isolated from the network:
+ * <ul>
+ * <li>The 1 MB realloc growth loop used by GCP_Client_Read_Write_Read, fed by an in-memory stream.
+ * <li>The pool buffer read loop used by GCP_Client_Read_Write_Read_Buffer, fed by the same stream.
+ * <li>A plain memcpy of the same data, as the floor the read loop should be compared against.
+ * <li>The Load_File / Save_File routines used by test_put_file / test_get_file.
+ * <li>Log message filtering and formatting, synchronous and asynchronous.
+ * <li>CRC32C and MD5 checksum computation, as used to validate transfers.
+ * </ul>
+ * Byte throughput is reported for the data benchmarks, so the library overhead per GB transferred can be read off
+ * directly. Standard Google Benchmark arguments (e.g. --benchmark_filter, --benchmark_format=json) are supported.
+ * This test does not need a google cloud connection.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <streambuf>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "google/cloud/storage/client.h"
+#include "google/cloud/storage/hashing_options.h"
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_buffer.h"
+#include "gcp_client_read_write.h"
+#include "gcp_client_read_write_private.h"
+
+/**
+ * The block size of memory to reallocate/load local file contents from, as used by test_put_file.
+ */
+#define MEMORY_BLOCK_LENGTH  (1024*1024)
+/**
+ * The largest data size benchmarked, in bytes.
+ */
+#define MAX_DATA_LENGTH      (256*1024*1024)
+
+/**
+ * A read-only stream buffer over an area of memory, used to feed GCP_Client_Read_Write_Read_Stream
+ * without copying the data into a std::string first.
+ */
+class Memory_Stream_Buffer : public std::streambuf
+{
+	public:
+	Memory_Stream_Buffer(char *data,size_t length)
+	{
+		setg(data,data,data+length);
+	}
+};
+
+/**
+ * Data used as the source of the data benchmarks, MAX_DATA_LENGTH bytes long, allocated on first use.
+ */
+static char *Data = NULL;
+/**
+ * The name of a temporary file used by the Load_File / Save_File benchmarks.
+ */
+static char Temporary_Filename[] = "/tmp/test_microbenchmark_XXXXXX";
+
+static char *Get_Data(void);
+static int Load_File(char *filename,void **file_contents,size_t *file_contents_length);
+static int Save_File(char *filename,void *file_contents,size_t file_contents_length);
+static void Discard_Log_Handler(int level,const char *string);
+
+/* ------------------------------------------------------------------
+**          Benchmarks
+** ------------------------------------------------------------------ */
+/**
+ * Benchmark the GCP_Client_Read_Write_Read object read loop, reading state.range(0) bytes from an in-memory stream
+ * into a buffer grown 1 MB at a time.
+ * @param state The benchmark state.
+ * @see #Memory_Stream_Buffer
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Read_Stream
+ */
+static void BM_Read_Stream(benchmark::State &state)
+{
+	void *file_contents = NULL;
+	size_t file_contents_length;
+	char *data = Get_Data();
+
+	for(auto _ : state)
+	{
+		Memory_Stream_Buffer stream_buffer(data,state.range(0));
+		std::istream stream(&stream_buffer);
+
+		if(!GCP_Client_Read_Write_Read_Stream(stream,(char*)"bucket",(char*)"object",&file_contents,
+						      &file_contents_length,NULL,NULL))
+		{
+			GCP_Client_Read_Write_Error();
+			state.SkipWithError("GCP_Client_Read_Write_Read_Stream failed.");
+			break;
+		}
+		benchmark::DoNotOptimize(file_contents);
+		free(file_contents);
+	}
+	state.SetBytesProcessed(((int64_t)state.iterations())*state.range(0));
+}
+BENCHMARK(BM_Read_Stream)->RangeMultiplier(16)->Range(1<<10,MAX_DATA_LENGTH)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Benchmark the GCP_Client_Read_Write_Read_Buffer object read loop, reading state.range(0) bytes from an in-memory
+ * stream into a pool buffer sized from the (known) length, and releasing it back to the pool.
+ * @param state The benchmark state.
+ * @see #Memory_Stream_Buffer
+ * @see ../cdocs/gcp_client_read_write.html#GCP_Client_Read_Write_Read_Stream_Buffer
+ * @see ../cdocs/gcp_client_buffer.html#GCP_Client_Buffer_Release
+ */
+static void BM_Read_Stream_Buffer(benchmark::State &state)
+{
+	void *buffer = NULL;
+	size_t buffer_length;
+	char *data = Get_Data();
+
+	for(auto _ : state)
+	{
+		Memory_Stream_Buffer stream_buffer(data,state.range(0));
+		std::istream stream(&stream_buffer);
+
+		if(!GCP_Client_Read_Write_Read_Stream_Buffer(stream,(char*)"bucket",(char*)"object",state.range(0),
+							     &buffer,&buffer_length,NULL))
+		{
+			GCP_Client_Read_Write_Error();
+			state.SkipWithError("GCP_Client_Read_Write_Read_Stream_Buffer failed.");
+			break;
+		}
+		benchmark::DoNotOptimize(buffer);
+		GCP_Client_Buffer_Release(buffer);
+	}
+	state.SetBytesProcessed(((int64_t)state.iterations())*state.range(0));
+}
+BENCHMARK(BM_Read_Stream_Buffer)->RangeMultiplier(16)->Range(1<<10,MAX_DATA_LENGTH)->
+	Unit(benchmark::kMicrosecond);
+
+/**
+ * Benchmark copying state.range(0) bytes into a freshly allocated buffer of the right size, the floor for
+ * BM_Read_Stream.
+ * @param state The benchmark state.
+ */
+static void BM_Memcpy(benchmark::State &state)
+{
+	char *data = Get_Data();
+	void *buffer = NULL;
+
+	for(auto _ : state)
+	{
+		buffer = malloc(state.range(0));
+		memcpy(buffer,data,state.range(0));
+		benchmark::DoNotOptimize(buffer);
+		free(buffer);
+	}
+	state.SetBytesProcessed(((int64_t)state.iterations())*state.range(0));
+}
+BENCHMARK(BM_Memcpy)->RangeMultiplier(16)->Range(1<<10,MAX_DATA_LENGTH)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Benchmark saving state.range(0) bytes to a local file, as test_get_file does.
+ * @param state The benchmark state.
+ * @see #Save_File
+ * @see #Temporary_Filename
+ */
+static void BM_Save_File(benchmark::State &state)
+{
+	char *data = Get_Data();
+
+	for(auto _ : state)
+	{
+		if(!Save_File(Temporary_Filename,data,state.range(0)))
+		{
+			state.SkipWithError("Save_File failed.");
+			break;
+		}
+	}
+	state.SetBytesProcessed(((int64_t)state.iterations())*state.range(0));
+}
+BENCHMARK(BM_Save_File)->RangeMultiplier(16)->Range(1<<20,MAX_DATA_LENGTH)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Benchmark loading a state.range(0) byte local file into memory, as test_put_file does.
+ * The file is written (untimed) before the benchmark loop, so it is normally in the page cache.
+ * @param state The benchmark state.
+ * @see #Load_File
+ * @see #Save_File
+ * @see #Temporary_Filename
+ */
+static void BM_Load_File(benchmark::State &state)
+{
+	void *file_contents = NULL;
+	size_t file_contents_length;
+
+	if(!Save_File(Temporary_Filename,Get_Data(),state.range(0)))
+	{
+		state.SkipWithError("Save_File failed.");
+		return;
+	}
+	for(auto _ : state)
+	{
+		if(!Load_File(Temporary_Filename,&file_contents,&file_contents_length))
+		{
+			state.SkipWithError("Load_File failed.");
+			break;
+		}
+		benchmark::DoNotOptimize(file_contents);
+		free(file_contents);
+	}
+	state.SetBytesProcessed(((int64_t)state.iterations())*state.range(0));
+}
+BENCHMARK(BM_Load_File)->RangeMultiplier(16)->Range(1<<20,MAX_DATA_LENGTH)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Benchmark a log call that is filtered out by the module log level, before any formatting is done.
+ * @param state The benchmark state.
+ * @see #Discard_Log_Handler
+ */
+static void BM_Log_Filtered(benchmark::State &state)
+{
+	GCP_Client_General_Set_Log_Handler_Function(Discard_Log_Handler);
+	GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+	GCP_Client_General_Set_Log_Filter_Level(LOG_VERBOSITY_VERY_VERBOSE);
+	GCP_Client_General_Set_Module_Log_Level(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_TERSE);
+	for(auto _ : state)
+	{
+		GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_VERBOSE,
+						     "test_microbenchmark:Read %ld bytes from bucket '%s' filename '%s'.",
+						     (long)state.iterations(),"bucket","object");
+	}
+	GCP_Client_General_Set_Module_Log_Level(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,
+						GCP_CLIENT_GENERAL_LOG_LEVEL_ALL);
+	GCP_Client_General_Set_Log_Handler_Function(NULL);
+}
+BENCHMARK(BM_Log_Filtered);
+
+/**
+ * Benchmark formatting and (synchronously) handling a log message, with a handler that discards it.
+ * @param state The benchmark state.
+ * @see #Discard_Log_Handler
+ */
+static void BM_Log_Format(benchmark::State &state)
+{
+	GCP_Client_General_Set_Log_Handler_Function(Discard_Log_Handler);
+	GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+	GCP_Client_General_Set_Log_Filter_Level(LOG_VERBOSITY_VERY_VERBOSE);
+	for(auto _ : state)
+	{
+		GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_VERBOSE,
+						     "test_microbenchmark:Read %ld bytes from bucket '%s' filename '%s'.",
+						     (long)state.iterations(),"bucket","object");
+	}
+	GCP_Client_General_Set_Log_Handler_Function(NULL);
+}
+BENCHMARK(BM_Log_Format);
+
+/**
+ * Benchmark queueing a log message for the asynchronous logging thread, with a handler that discards it.
+ * @param state The benchmark state.
+ * @see #Discard_Log_Handler
+ */
+static void BM_Log_Format_Async(benchmark::State &state)
+{
+	GCP_Client_General_Set_Log_Handler_Function(Discard_Log_Handler);
+	GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+	GCP_Client_General_Set_Log_Filter_Level(LOG_VERBOSITY_VERY_VERBOSE);
+	if(!GCP_Client_General_Log_Async_Start(0))
+	{
+		state.SkipWithError("GCP_Client_General_Log_Async_Start failed.");
+		return;
+	}
+	for(auto _ : state)
+	{
+		GCP_Client_General_Module_Log_Format(GCP_CLIENT_GENERAL_LOG_MODULE_READ_WRITE,LOG_VERBOSITY_VERBOSE,
+						     "test_microbenchmark:Read %ld bytes from bucket '%s' filename '%s'.",
+						     (long)state.iterations(),"bucket","object");
+	}
+	GCP_Client_General_Log_Async_Stop(1000);
+	GCP_Client_General_Set_Log_Handler_Function(NULL);
+}
+BENCHMARK(BM_Log_Format_Async);
+
+/**
+ * Benchmark computing the CRC32C checksum of state.range(0) bytes.
+ * @param state The benchmark state.
+ */
+static void BM_CRC32C(benchmark::State &state)
+{
+	std::string data(Get_Data(),state.range(0));
+
+	for(auto _ : state)
+		benchmark::DoNotOptimize(::google::cloud::storage::ComputeCrc32cChecksum(data));
+	state.SetBytesProcessed(((int64_t)state.iterations())*state.range(0));
+}
+BENCHMARK(BM_CRC32C)->RangeMultiplier(16)->Range(1<<10,64<<20)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Benchmark computing the MD5 hash of state.range(0) bytes.
+ * @param state The benchmark state.
+ */
+static void BM_MD5(benchmark::State &state)
+{
+	std::string data(Get_Data(),state.range(0));
+
+	for(auto _ : state)
+		benchmark::DoNotOptimize(::google::cloud::storage::ComputeMD5Hash(data));
+	state.SetBytesProcessed(((int64_t)state.iterations())*state.range(0));
+}
+BENCHMARK(BM_MD5)->RangeMultiplier(16)->Range(1<<10,64<<20)->Unit(benchmark::kMicrosecond);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program. A temporary file is created for the file benchmarks, the benchmarks are run, and the temporary
+ * file deleted.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings, passed to Google Benchmark.
+ * @see #Temporary_Filename
+ */
+int main(int argc, char *argv[])
+{
+	int fd;
+
+	benchmark::Initialize(&argc,argv);
+	if(benchmark::ReportUnrecognizedArguments(argc,argv))
+		return 1;
+	fd = mkstemp(Temporary_Filename);
+	if(fd < 0)
+	{
+		fprintf(stderr,"test_microbenchmark : Failed to create temporary file (%d).\n",errno);
+		return 2;
+	}
+	close(fd);
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	unlink(Temporary_Filename);
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Return the benchmark source data, allocating and filling it on first use.
+ * @return A pointer to MAX_DATA_LENGTH bytes of data.
+ * @see #Data
+ * @see #MAX_DATA_LENGTH
+ */
+static char *Get_Data(void)
+{
+	size_t i;
+
+	if(Data == NULL)
+	{
+		Data = (char*)malloc(MAX_DATA_LENGTH);
+		if(Data == NULL)
+		{
+			fprintf(stderr,"test_microbenchmark : Failed to allocate %d bytes.\n",MAX_DATA_LENGTH);
+			exit(2);
+		}
+		for(i = 0; i < MAX_DATA_LENGTH; i++)
+			Data[i] = (char)((i*31)+7);
+	}
+	return Data;
+}
+
+/**
+ * Load the specified local file contents into memory. This is the same algorithm as Load_File in test_put_file.c.
+ * @param filename The filename to load the data from.
+ * @param file_contents The address of a memory pointer to reallocate and store the contents of the local file into.
+ * @param file_contents_length The address of a variable to store the loaded length of the file_contents, in bytes.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ * @see #MEMORY_BLOCK_LENGTH
+ */
+static int Load_File(char *filename,void **file_contents,size_t *file_contents_length)
+{
+	ssize_t returned_size;
+	int fd,done;
+
+	fd = open(filename,O_RDONLY);
+	if(fd < 0)
+		return FALSE;
+	done = FALSE;
+	(*file_contents) = NULL;
+	(*file_contents_length) = 0;
+	while(done == FALSE)
+	{
+		(*file_contents) = realloc((*file_contents),((*file_contents_length)+MEMORY_BLOCK_LENGTH)*sizeof(char));
+		if((*file_contents) == NULL)
+		{
+			close(fd);
+			return FALSE;
+		}
+		returned_size = read(fd,((char*)(*file_contents))+(*file_contents_length),MEMORY_BLOCK_LENGTH);
+		if(returned_size < 0)
+		{
+			close(fd);
+			return FALSE;
+		}
+		if(returned_size == 0) /* EOF */
+			done = TRUE;
+		(*file_contents_length) += returned_size;
+	}/* end while */
+	if(close(fd) != 0)
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * Save the specified file contents to the specified filename. This is the same algorithm as Save_File in
+ * test_get_file.c.
+ * @param filename The filename to save the data to.
+ * @param file_contents The contents to write to file.
+ * @param file_contents_length The length of the file_contents, in bytes.
+ * @return The routine returns TRUE on success, and FALSE on failure.
+ */
+static int Save_File(char *filename,void *file_contents,size_t file_contents_length)
+{
+	ssize_t returned_size;
+	int fd;
+
+	fd = open(filename,O_WRONLY|O_CREAT|O_TRUNC,S_IRWXU|S_IRWXG);
+	if(fd < 0)
+		return FALSE;
+	returned_size = write(fd,file_contents,file_contents_length);
+	if((returned_size < 0)||(((size_t)returned_size) < file_contents_length))
+	{
+		close(fd);
+		return FALSE;
+	}
+	if(close(fd) != 0)
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * Log handler that discards the message, so the logging benchmarks measure the library's costs only.
+ * @param level The log level of the message.
+ * @param string The message.
+ */
+static void Discard_Log_Handler(int level,const char *string)
+{
+	benchmark::DoNotOptimize(string);
+}
@@ -0,0 +1,438 @@
+/* gcp_sync.c
+*/
+/**
+ * Mirror a local directory tree to a google cloud storage bucket, uploading only new and changed files.
+ * A dry run prints the plan (what would be uploaded) without uploading anything.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_adaptive.h"
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_connection.h"
+#include "gcp_client_sync.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH        (256)
+/**
+ * Verbosity log level : initialised to 0 (no library logging).
+ */
+static int Log_Level = 0;
+/**
+ * The local directory to sync.
+ */
+static char Local_Directory[STRING_LENGTH];
+/**
+ * The name of the google cloud storage bucket to sync to.
+ */
+static char Bucket_Name[STRING_LENGTH];
+/**
+ * The prefix prepended to relative filenames to make object names, or NULL.
+ */
+static char *Prefix = NULL;
+/**
+ * The storage emulator endpoint URL (e.g. http://localhost:9000), or an empty string to use google cloud storage.
+ */
+static char Endpoint[STRING_LENGTH] = "";
+/**
+ * The number of files checksummed / uploaded at once.
+ */
+static int Concurrency = GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY;
+/**
+ * The sync flags (GCP_CLIENT_SYNC_FLAG_DRY_RUN etc).
+ */
+static int Flags = 0;
+/**
+ * If TRUE, unchanged files are printed as well.
+ */
+static int Verbose = FALSE;
+/**
+ * If TRUE, the adaptive controller's upload decisions are printed after the sync.
+ */
+static int History = FALSE;
+/**
+ * The bandwidth priority class the sync's uploads run in (GCP_CLIENT_BANDWIDTH_PRIORITY_NORMAL etc).
+ */
+static int Priority = GCP_CLIENT_BANDWIDTH_PRIORITY_NORMAL;
+/**
+ * The upload bandwidth limit in bytes per second, or GCP_CLIENT_BANDWIDTH_UNLIMITED.
+ */
+static unsigned long long Upload_Limit = GCP_CLIENT_BANDWIDTH_UNLIMITED;
+
+static void Sync_Callback(const char *local_filename,const char *object_name,int action,unsigned long long size,
+			  void *user_data);
+static void Print_History(void);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>If an emulator endpoint was specified, we set the CLOUD_STORAGE_EMULATOR_ENDPOINT environment variable.
+ * <li>We connect to the google cloud by calling GCP_Client_Connection_Open.
+ * <li>We set the upload bandwidth limit (GCP_Client_Bandwidth_Set_Limit) and this thread's bandwidth
+ *     priority (GCP_Client_Bandwidth_Set_Thread_Priority), which the sync's upload threads inherit.
+ * <li>We sync the directory with GCP_Client_Sync, printing each file's action (Sync_Callback).
+ * <li>We print a summary of the sync, and the transfer throughput.
+ * <li>If -history was specified, we print the upload chunk length and parallelism decisions (Print_History).
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return The program returns 0 on success, and non-zero on failure.
+ * @see #Parse_Arguments
+ * @see #Sync_Callback
+ * @see #Print_History
+ * @see #Priority
+ * @see #Upload_Limit
+ * @see ../cdocs/gcp_client_bandwidth.html#GCP_Client_Bandwidth_Set_Limit
+ * @see ../cdocs/gcp_client_bandwidth.html#GCP_Client_Bandwidth_Set_Thread_Priority
+ * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
+ * @see ../cdocs/gcp_client_sync.html#GCP_Client_Sync
+ */
+int main(int argc, char *argv[])
+{
+	struct GCP_Client_Sync_Stats_Struct stats;
+	unsigned long long transfer_count;
+	int retval;
+
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	if((strlen(Local_Directory) == 0)||(strlen(Bucket_Name) == 0))
+	{
+		fprintf(stderr,"gcp_sync : The local directory and bucket must be specified.\n");
+		return 1;
+	}
+	if(Log_Level > 0)
+	{
+		GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+		GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+		GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+	}
+	if(strlen(Endpoint) > 0)
+		setenv("CLOUD_STORAGE_EMULATOR_ENDPOINT",Endpoint,1);
+	if(!GCP_Client_Connection_Open())
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	if(!GCP_Client_Bandwidth_Set_Limit(GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD,Upload_Limit,0))
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	if(!GCP_Client_Bandwidth_Set_Thread_Priority(Priority))
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	retval = GCP_Client_Sync(Local_Directory,Bucket_Name,Prefix,Concurrency,Flags,Sync_Callback,NULL,&stats);
+	if(!retval)
+		GCP_Client_General_Error();
+	transfer_count = stats.New_Count+stats.Changed_Count;
+	fprintf(stdout,"gcp_sync : %s%llu local files, %llu remote objects: %llu new, %llu changed, %llu unchanged, "
+		"%llu remote only, %llu checksummed, %llu failed.\n",(Flags & GCP_CLIENT_SYNC_FLAG_DRY_RUN) ?
+		"Dry run: " : "",stats.Local_File_Count,stats.Remote_Object_Count,stats.New_Count,
+		stats.Changed_Count,stats.Unchanged_Count,stats.Remote_Only_Count,stats.Checksum_Count,
+		stats.Failed_Count);
+	fprintf(stdout,"gcp_sync : %s %llu files (%llu bytes) in %.3f seconds (%.1f files/s, %.3f MB/s).\n",
+		(Flags & GCP_CLIENT_SYNC_FLAG_DRY_RUN) ? "Would upload" : "Uploaded",transfer_count,
+		stats.Transfer_Byte_Count,stats.Elapsed_Time,
+		(stats.Elapsed_Time > 0.0) ? ((double)transfer_count)/stats.Elapsed_Time : 0.0,
+		(stats.Elapsed_Time > 0.0) ? ((double)stats.Transfer_Byte_Count)/(stats.Elapsed_Time*1000000.0) : 0.0);
+	if(History)
+		Print_History();
+	if(!retval)
+		return 3;
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Sync callback, prints the action decided for each file (unchanged files only if Verbose is set).
+ * @param local_filename The local filename, or NULL for a remote only object.
+ * @param object_name The object name.
+ * @param action The action (GCP_CLIENT_SYNC_ACTION_NEW etc).
+ * @param size The size of the file or object.
+ * @param user_data Unused.
+ * @see #Verbose
+ */
+static void Sync_Callback(const char *local_filename,const char *object_name,int action,unsigned long long size,
+			  void *user_data)
+{
+	const char *action_string = NULL;
+
+	switch(action)
+	{
+		case GCP_CLIENT_SYNC_ACTION_UNCHANGED:
+			if(!Verbose)
+				return;
+			action_string = "unchanged";
+			break;
+		case GCP_CLIENT_SYNC_ACTION_NEW:
+			action_string = "new";
+			break;
+		case GCP_CLIENT_SYNC_ACTION_CHANGED:
+			action_string = "changed";
+			break;
+		case GCP_CLIENT_SYNC_ACTION_REMOTE_ONLY:
+			action_string = "remote";
+			break;
+		case GCP_CLIENT_SYNC_ACTION_FAILED:
+			action_string = "FAILED";
+			break;
+		default:
+			action_string = "unknown";
+			break;
+	}
+	fprintf(stdout,"%-9s %12llu %s -> gs://%s/%s\n",action_string,size,
+		(local_filename != NULL) ? local_filename : "-",Bucket_Name,object_name);
+}
+
+/**
+ * Print the decisions the adaptive controller made about uploads during the sync, one line per decision, to show
+ * how the chunk length and parallelism converged.
+ * @see ../cdocs/gcp_client_adaptive.html#GCP_Client_Adaptive_Get_History
+ */
+static void Print_History(void)
+{
+	struct GCP_Client_Adaptive_Decision_Struct decision_list[GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH];
+	int count,i;
+
+	if(!GCP_Client_Adaptive_Get_History(GCP_CLIENT_ADAPTIVE_DIRECTION_UPLOAD,decision_list,
+					    GCP_CLIENT_ADAPTIVE_HISTORY_LENGTH,&count))
+	{
+		GCP_Client_General_Error();
+		return;
+	}
+	fprintf(stdout,"gcp_sync : %d upload decisions.\n",count);
+	fprintf(stdout,"%10s %12s %12s %10s %10s %12s %11s %7s\n","time_s","MB/s","stream_MB/s","rtt_ms","min_rtt_ms",
+		"chunk_bytes","parallelism","samples");
+	for(i = 0; i < count; i++)
+	{
+		fprintf(stdout,"%10.3f %12.3f %12.3f %10.3f %10.3f %12lu %11d %7d\n",decision_list[i].Time,
+			decision_list[i].Throughput/1000000.0,decision_list[i].Stream_Throughput/1000000.0,
+			decision_list[i].RTT*1000.0,decision_list[i].Min_RTT*1000.0,
+			(unsigned long)decision_list[i].Chunk_Length,decision_list[i].Parallelism,
+			decision_list[i].Sample_Count);
+	}
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #Local_Directory
+ * @see #Bucket_Name
+ * @see #Prefix
+ * @see #Endpoint
+ * @see #Concurrency
+ * @see #Flags
+ * @see #Verbose
+ * @see #History
+ * @see #Priority
+ * @see #Upload_Limit
+ * @see #Log_Level
+ * @see #Help
+ * @see ../cdocs/gcp_client_bandwidth.html#GCP_Client_Bandwidth_Priority_Parse
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Bucket_Name,argv[i+1],STRING_LENGTH);
+				Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-c")==0)||(strcmp(argv[i],"-concurrency")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Concurrency);
+				if((retval != 1)||(Concurrency < 1)||(Concurrency > GCP_CLIENT_BATCH_MAX_CONCURRENCY))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal concurrency %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-concurrency requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-checksum")==0)
+		{
+			Flags |= GCP_CLIENT_SYNC_FLAG_CHECKSUM;
+		}
+		else if((strcmp(argv[i],"-d")==0)||(strcmp(argv[i],"-directory")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Local_Directory,argv[i+1],STRING_LENGTH);
+				Local_Directory[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-directory requires a directory name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-n")==0)||(strcmp(argv[i],"-dry_run")==0))
+		{
+			Flags |= GCP_CLIENT_SYNC_FLAG_DRY_RUN;
+		}
+		else if((strcmp(argv[i],"-e")==0)||(strcmp(argv[i],"-endpoint")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Endpoint,argv[i+1],STRING_LENGTH);
+				Endpoint[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-endpoint requires an emulator URL.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-history")==0)
+		{
+			History = TRUE;
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-p")==0)||(strcmp(argv[i],"-prefix")==0))
+		{
+			if((i+1)<argc)
+			{
+				Prefix = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-prefix requires an object name prefix.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-priority")==0)
+		{
+			if((i+1)<argc)
+			{
+				if(!GCP_Client_Bandwidth_Priority_Parse(argv[i+1],&Priority))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal priority %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-priority requires high, normal or bulk.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-upload_limit")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%llu",&Upload_Limit);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal upload limit %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-upload_limit requires a number of bytes per second.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-v")==0)||(strcmp(argv[i],"-verbose")==0))
+		{
+			Verbose = TRUE;
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"GCP Sync:Help.\n");
+	fprintf(stdout,"This program uploads the new and changed files in a local directory tree to a bucket.\n");
+	fprintf(stdout,"gcp_sync -d[irectory] <directory> -b[ucket] <bucket name> [-p[refix] <prefix>]\n");
+	fprintf(stdout,"\t[-c[oncurrency] <n>][-n|-dry_run][-checksum][-v[erbose]][-e[ndpoint] <url>]\n");
+	fprintf(stdout,"\t[-priority high|normal|bulk][-upload_limit <bytes/s>][-history][-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\t-prefix is prepended to each file's path (relative to -directory) to make it's object name.\n");
+	fprintf(stdout,"\t\tTo sync into a pseudo-directory it should end in '/'.\n");
+	fprintf(stdout,"\t-concurrency is the most files checksummed / uploaded at once (default %d).\n",
+		GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY);
+	fprintf(stdout,"\t\tWithin it, the number at once is adapted to the observed throughput.\n");
+	fprintf(stdout,"\t-dry_run prints what would be uploaded, without uploading anything.\n");
+	fprintf(stdout,"\t-checksum compares checksums even when the size and modification time match.\n");
+	fprintf(stdout,"\t-verbose prints unchanged files as well.\n");
+	fprintf(stdout,"\t-endpoint sets a storage emulator URL (CLOUD_STORAGE_EMULATOR_ENDPOINT).\n");
+	fprintf(stdout,"\t-priority is the bandwidth priority class of the uploads (default normal).\n");
+	fprintf(stdout,"\t-upload_limit limits the upload bandwidth of the sync, in bytes per second (default unlimited).\n");
+	fprintf(stdout,"\t-history prints the upload chunk length and parallelism chosen over the sync.\n");
+	fprintf(stdout,"Files are compared by size, then modification time (stored in the object's metadata),\n");
+	fprintf(stdout,"then CRC32C checksum. Objects with no local file are reported as 'remote', not deleted.\n");
+}
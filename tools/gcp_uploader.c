@@ -0,0 +1,1128 @@
+/* gcp_uploader.c
+*/
+/**
+ * Long running uploader, that watches local directories (and their sub-directories) with inotify, and uploads
+ * each file to a bucket as soon as it has been written and closed (or renamed into the directory).
+ * The uploads are made by a pool of upload threads sharing the library's (warm) client, fed from a queue, and
+ * the queue depth, upload lag (the time from the file being closed to the upload finishing) and throughput are
+ * printed periodically.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>
+#include <dirent.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "log_udp.h"
+#include "gcp_client_general.h"
+#include "gcp_client_bandwidth.h"
+#include "gcp_client_batch.h"
+#include "gcp_client_connection.h"
+#include "gcp_client_fits.h"
+#include "gcp_client_sync.h"
+
+/**
+ * Length of some of the strings used in this program.
+ */
+#define STRING_LENGTH        (256)
+/**
+ * The maximum number of directories that can be specified on the command line.
+ */
+#define MAX_DIRECTORY_COUNT  (16)
+/**
+ * The inotify events watched for on each directory. Files are uploaded when they are closed after writing, or
+ * renamed into the directory. New directories are watched as well.
+ */
+#define WATCH_EVENT_MASK     (IN_CLOSE_WRITE|IN_MOVED_TO|IN_CREATE|IN_ONLYDIR|IN_DONT_FOLLOW)
+/**
+ * The length of the buffer inotify events are read into.
+ */
+#define EVENT_BUFFER_LENGTH  (64*1024)
+/**
+ * How long the main loop waits for inotify events before checking whether to stop / print statistics,
+ * in milliseconds.
+ */
+#define POLL_TIMEOUT_MS      (1000)
+
+/**
+ * Structure holding a watched directory. This consists of the following:
+ * <dl>
+ * <dt>Watch_Descriptor</dt> <dd>The inotify watch descriptor, or -1 if the directory is no longer watched.</dd>
+ * <dt>Path</dt> <dd>The directory's local path.</dd>
+ * <dt>Object_Prefix</dt> <dd>The object name prefix of files in the directory, the command line prefix followed
+ *     by the directory's path relative to the watched root directory.</dd>
+ * </dl>
+ */
+struct Watch_Struct
+{
+	int Watch_Descriptor;
+	char *Path;
+	char *Object_Prefix;
+};
+
+/**
+ * Structure holding a queued upload. This consists of the following:
+ * <dl>
+ * <dt>Local_Filename</dt> <dd>The local filename (allocated).</dd>
+ * <dt>Object_Name</dt> <dd>The object name (allocated).</dd>
+ * <dt>Event_Time</dt> <dd>The (monotonic) time the file's close was seen, used to compute the upload lag.</dd>
+ * </dl>
+ */
+struct Upload_Struct
+{
+	char *Local_Filename;
+	char *Object_Name;
+	struct timespec Event_Time;
+};
+
+/**
+ * Structure holding the upload statistics. This consists of the following:
+ * <dl>
+ * <dt>Upload_Count</dt> <dd>The number of files uploaded.</dd>
+ * <dt>Failed_Count</dt> <dd>The number of files that failed to upload.</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes uploaded.</dd>
+ * <dt>Lag_Sum</dt> <dd>The sum of the upload lags, in seconds.</dd>
+ * <dt>Lag_Max</dt> <dd>The largest upload lag, in seconds.</dd>
+ * <dt>Max_Queue_Count</dt> <dd>The largest number of files queued at once.</dd>
+ * </dl>
+ */
+struct Upload_Stats_Struct
+{
+	unsigned long long Upload_Count;
+	unsigned long long Failed_Count;
+	unsigned long long Byte_Count;
+	double Lag_Sum;
+	double Lag_Max;
+	int Max_Queue_Count;
+};
+
+/**
+ * Verbosity log level : initialised to 0 (no library logging).
+ */
+static int Log_Level = 0;
+/**
+ * The list of local directories to watch.
+ */
+static char *Directory_List[MAX_DIRECTORY_COUNT];
+/**
+ * The number of directories in Directory_List.
+ */
+static int Directory_Count = 0;
+/**
+ * The name of the google cloud storage bucket to upload to.
+ */
+static char Bucket_Name[STRING_LENGTH];
+/**
+ * The prefix prepended to relative filenames to make object names.
+ */
+static char Prefix[STRING_LENGTH] = "";
+/**
+ * If non-empty, only files whose names end in this suffix are uploaded.
+ */
+static char Suffix[STRING_LENGTH] = "";
+/**
+ * The storage emulator endpoint URL (e.g. http://localhost:9000), or an empty string to use google cloud storage.
+ */
+static char Endpoint[STRING_LENGTH] = "";
+/**
+ * The number of upload threads.
+ */
+static int Concurrency = GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY;
+/**
+ * The number of files the upload queue can hold. When it is full, inotify events are not read until
+ * an upload thread takes a file off the queue (the kernel queues the events in the meantime).
+ */
+static int Queue_Length = 1024;
+/**
+ * How often the statistics are printed, in seconds. If 0, they are only printed on exit.
+ */
+static int Stats_Interval = 10;
+/**
+ * If TRUE, each directory is synced to the bucket (GCP_Client_Sync) once it's watches are in place,
+ * to catch up with files written while the uploader was not running.
+ */
+static int Initial_Sync = FALSE;
+/**
+ * The bandwidth priority class the uploads run in (GCP_CLIENT_BANDWIDTH_PRIORITY_NORMAL etc).
+ */
+static int Priority = GCP_CLIENT_BANDWIDTH_PRIORITY_NORMAL;
+/**
+ * The upload bandwidth limit in bytes per second, or GCP_CLIENT_BANDWIDTH_UNLIMITED.
+ */
+static unsigned long long Upload_Limit = GCP_CLIENT_BANDWIDTH_UNLIMITED;
+/**
+ * If TRUE, the FITS header keywords of uploaded frames are indexed in the objects' custom metadata.
+ */
+static int Fits_Index = FALSE;
+/**
+ * The comma separated list of FITS keywords to index, or an empty string for the library's default list.
+ */
+static char Fits_Keyword_List[STRING_LENGTH] = "";
+/**
+ * Set to TRUE when a SIGINT or SIGTERM is received.
+ */
+static volatile sig_atomic_t Stop = FALSE;
+/**
+ * The inotify file descriptor.
+ */
+static int Inotify_Fd = -1;
+/**
+ * The list of watched directories (reallocated as it grows).
+ */
+static struct Watch_Struct *Watch_List = NULL;
+/**
+ * The number of entries in Watch_List.
+ */
+static int Watch_Count = 0;
+/**
+ * The upload queue, a circular buffer of Queue_Length entries.
+ */
+static struct Upload_Struct *Queue = NULL;
+/**
+ * The index of the first entry in the queue.
+ */
+static int Queue_Start = 0;
+/**
+ * The number of entries in the queue.
+ */
+static int Queue_Count = 0;
+/**
+ * The number of uploads in progress.
+ */
+static int Active_Count = 0;
+/**
+ * Set to TRUE when no more files will be queued, and the upload threads should exit once the queue is empty.
+ */
+static int Queue_Done = FALSE;
+/**
+ * Mutex protecting the queue and statistics.
+ */
+static pthread_mutex_t Queue_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * Condition signalled when a file is queued, or Queue_Done is set.
+ */
+static pthread_cond_t Queue_Not_Empty_Condition = PTHREAD_COND_INITIALIZER;
+/**
+ * Condition signalled when a file is taken off the queue.
+ */
+static pthread_cond_t Queue_Not_Full_Condition = PTHREAD_COND_INITIALIZER;
+/**
+ * The upload statistics since the uploader started.
+ */
+static struct Upload_Stats_Struct Total_Stats;
+/**
+ * The upload statistics since they were last printed.
+ */
+static struct Upload_Stats_Struct Interval_Stats;
+/**
+ * The number of times the inotify event queue overflowed (and events were lost).
+ */
+static unsigned long long Overflow_Count = 0;
+
+static void *Upload_Thread(void *user_data);
+static void Upload_Worker(int index,void *user_data);
+static int Queue_Add(char *local_filename,char *object_name,struct timespec event_time);
+static int Watch_Add_Tree(char *path,char *object_prefix,int queue_existing);
+static struct Watch_Struct *Watch_Find(int watch_descriptor);
+static void Watch_Remove(int watch_descriptor);
+static int Process_Events(void);
+static int Suffix_Matches(const char *filename);
+static void Print_Stats(char *label,struct Upload_Stats_Struct *stats,double elapsed_time);
+static double Timespec_Diff(struct timespec start_time,struct timespec end_time);
+static void Signal_Handler(int signal_number);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/* ------------------------------------------------------------------
+**          External functions
+** ------------------------------------------------------------------ */
+/**
+ * Main program.
+ * <ul>
+ * <li>We parse the arguments with Parse_Arguments.
+ * <li>If an emulator endpoint was specified, we set the CLOUD_STORAGE_EMULATOR_ENDPOINT environment variable.
+ * <li>We connect to the google cloud by calling GCP_Client_Connection_Open. The client is shared by all the
+ *     uploads.
+ * <li>We set the upload bandwidth limit with GCP_Client_Bandwidth_Set_Limit.
+ * <li>We install SIGINT/SIGTERM handlers.
+ * <li>We create an inotify instance, and watch each directory tree with Watch_Add_Tree.
+ * <li>If requested, we sync each directory with GCP_Client_Sync, to catch up with files written while we were
+ *     not running.
+ * <li>We start the upload threads (Upload_Thread).
+ * <li>We process inotify events (Process_Events) until stopped, printing the statistics every Stats_Interval
+ *     seconds.
+ * <li>We let the upload threads finish the queued files, and print the final statistics.
+ * </ul>
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return The program returns 0 on success, and non-zero on failure.
+ * @see #Parse_Arguments
+ * @see #Signal_Handler
+ * @see #Watch_Add_Tree
+ * @see #Upload_Thread
+ * @see #Process_Events
+ * @see #Print_Stats
+ * @see #Upload_Limit
+ * @see #Fits_Index
+ * @see #Fits_Keyword_List
+ * @see ../cdocs/gcp_client_bandwidth.html#GCP_Client_Bandwidth_Set_Limit
+ * @see ../cdocs/gcp_client_connection.html#GCP_Client_Connection_Open
+ * @see ../cdocs/gcp_client_fits.html#GCP_Client_Fits_Index_Set
+ * @see ../cdocs/gcp_client_sync.html#GCP_Client_Sync
+ */
+int main(int argc, char *argv[])
+{
+	struct GCP_Client_Sync_Stats_Struct sync_stats;
+	struct Upload_Stats_Struct interval_stats;
+	struct timespec start_time,stats_time,current_time;
+	struct sigaction signal_action;
+	struct pollfd poll_fd;
+	pthread_t upload_thread;
+	int i,retval,queue_count,active_count;
+
+	if(!Parse_Arguments(argc,argv))
+		return 1;
+	if((Directory_Count == 0)||(strlen(Bucket_Name) == 0))
+	{
+		fprintf(stderr,"gcp_uploader : At least one directory, and the bucket, must be specified.\n");
+		return 1;
+	}
+	if(Log_Level > 0)
+	{
+		GCP_Client_General_Set_Log_Filter_Level(Log_Level);
+		GCP_Client_General_Set_Log_Filter_Function(GCP_Client_General_Log_Filter_Level_Absolute);
+		GCP_Client_General_Set_Log_Handler_Function(GCP_Client_General_Log_Handler_Stdout);
+	}
+	if(strlen(Endpoint) > 0)
+		setenv("CLOUD_STORAGE_EMULATOR_ENDPOINT",Endpoint,1);
+	if(!GCP_Client_Connection_Open())
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	if(!GCP_Client_Bandwidth_Set_Limit(GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD,Upload_Limit,0))
+	{
+		GCP_Client_General_Error();
+		return 2;
+	}
+	if(Fits_Index)
+	{
+		if(!GCP_Client_Fits_Index_Set(TRUE,(strlen(Fits_Keyword_List) > 0) ? Fits_Keyword_List : NULL))
+		{
+			GCP_Client_General_Error();
+			return 2;
+		}
+	}
+	memset(&signal_action,0,sizeof(struct sigaction));
+	signal_action.sa_handler = Signal_Handler;
+	sigaction(SIGINT,&signal_action,NULL);
+	sigaction(SIGTERM,&signal_action,NULL);
+	Queue = (struct Upload_Struct *)malloc(Queue_Length*sizeof(struct Upload_Struct));
+	if(Queue == NULL)
+	{
+		fprintf(stderr,"gcp_uploader : Failed to allocate queue of %d files.\n",Queue_Length);
+		return 3;
+	}
+	memset(&Total_Stats,0,sizeof(struct Upload_Stats_Struct));
+	memset(&Interval_Stats,0,sizeof(struct Upload_Stats_Struct));
+	Inotify_Fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+	if(Inotify_Fd < 0)
+	{
+		fprintf(stderr,"gcp_uploader : inotify_init1 failed (%s).\n",strerror(errno));
+		return 4;
+	}
+	for(i=0; i < Directory_Count; i++)
+	{
+		if(!Watch_Add_Tree(Directory_List[i],Prefix,FALSE))
+			return 5;
+	}
+	fprintf(stdout,"gcp_uploader : Watching %d directories, uploading to gs://%s/%s with %d threads.\n",
+		Watch_Count,Bucket_Name,Prefix,Concurrency);
+	if(Initial_Sync)
+	{
+		for(i=0; i < Directory_Count; i++)
+		{
+			retval = GCP_Client_Sync(Directory_List[i],Bucket_Name,Prefix,Concurrency,0,NULL,NULL,&sync_stats);
+			if(!retval)
+				GCP_Client_General_Error();
+			fprintf(stdout,"gcp_uploader : Synced '%s': %llu new, %llu changed, %llu unchanged, %llu failed "
+				"in %.3f seconds.\n",Directory_List[i],sync_stats.New_Count,sync_stats.Changed_Count,
+				sync_stats.Unchanged_Count,sync_stats.Failed_Count,sync_stats.Elapsed_Time);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	stats_time = start_time;
+	retval = pthread_create(&upload_thread,NULL,Upload_Thread,NULL);
+	if(retval != 0)
+	{
+		fprintf(stderr,"gcp_uploader : Failed to create upload thread (%d).\n",retval);
+		return 6;
+	}
+	poll_fd.fd = Inotify_Fd;
+	poll_fd.events = POLLIN;
+	while(Stop == FALSE)
+	{
+		retval = poll(&poll_fd,1,POLL_TIMEOUT_MS);
+		if((retval < 0)&&(errno != EINTR))
+		{
+			fprintf(stderr,"gcp_uploader : poll failed (%s).\n",strerror(errno));
+			break;
+		}
+		if((retval > 0)&&(!Process_Events()))
+			break;
+		clock_gettime(CLOCK_MONOTONIC,&current_time);
+		if((Stats_Interval > 0)&&(Timespec_Diff(stats_time,current_time) >= Stats_Interval))
+		{
+			pthread_mutex_lock(&Queue_Mutex);
+			interval_stats = Interval_Stats;
+			memset(&Interval_Stats,0,sizeof(struct Upload_Stats_Struct));
+			Interval_Stats.Max_Queue_Count = Queue_Count;
+			queue_count = Queue_Count;
+			active_count = Active_Count;
+			pthread_mutex_unlock(&Queue_Mutex);
+			fprintf(stdout,"gcp_uploader : queue %d, active %d, ",queue_count,active_count);
+			Print_Stats("interval",&interval_stats,Timespec_Diff(stats_time,current_time));
+			stats_time = current_time;
+		}
+	}
+	pthread_mutex_lock(&Queue_Mutex);
+	queue_count = Queue_Count;
+	pthread_mutex_unlock(&Queue_Mutex);
+	fprintf(stdout,"gcp_uploader : Stopping, uploading the %d queued files.\n",queue_count);
+	pthread_mutex_lock(&Queue_Mutex);
+	Queue_Done = TRUE;
+	pthread_cond_broadcast(&Queue_Not_Empty_Condition);
+	pthread_mutex_unlock(&Queue_Mutex);
+	pthread_join(upload_thread,NULL);
+	clock_gettime(CLOCK_MONOTONIC,&current_time);
+	fprintf(stdout,"gcp_uploader : inotify overflows %llu, ",Overflow_Count);
+	Print_Stats("total",&Total_Stats,Timespec_Diff(start_time,current_time));
+	close(Inotify_Fd);
+	for(i=0; i < Watch_Count; i++)
+	{
+		free(Watch_List[i].Path);
+		free(Watch_List[i].Object_Prefix);
+	}
+	free(Watch_List);
+	free(Queue);
+	if(Total_Stats.Failed_Count > 0)
+		return 7;
+	return 0;
+}
+
+/* ------------------------------------------------------------------
+**          Internal functions
+** ------------------------------------------------------------------ */
+/**
+ * Thread running the upload threads, as a batch of Concurrency items, until the queue is done and empty.
+ * The thread's bandwidth priority is set to Priority first, so the upload threads inherit it.
+ * @param user_data Unused.
+ * @return The routine returns NULL.
+ * @see #Concurrency
+ * @see #Priority
+ * @see #Upload_Worker
+ * @see ../cdocs/gcp_client_bandwidth.html#GCP_Client_Bandwidth_Set_Thread_Priority
+ * @see ../cdocs/gcp_client_batch.html#GCP_Client_Batch_Run
+ */
+static void *Upload_Thread(void *user_data)
+{
+	if(!GCP_Client_Bandwidth_Set_Thread_Priority(Priority))
+	{
+		GCP_Client_General_Error();
+		return NULL;
+	}
+	if(!GCP_Client_Batch_Run(Concurrency,Concurrency,Upload_Worker,NULL))
+		GCP_Client_General_Error();
+	return NULL;
+}
+
+/**
+ * Upload thread, run as a batch item. Takes files off the queue and uploads them with
+ * GCP_Client_Sync_Upload_File, until the queue is done and empty. The upload lag, bytes uploaded and failures are
+ * added to the statistics.
+ * @param index The index of the upload thread (unused).
+ * @param user_data Unused.
+ * @see #Queue
+ * @see #Total_Stats
+ * @see #Interval_Stats
+ * @see ../cdocs/gcp_client_sync.html#GCP_Client_Sync_Upload_File
+ */
+static void Upload_Worker(int index,void *user_data)
+{
+	struct Upload_Struct upload;
+	struct timespec end_time;
+	unsigned long long byte_count;
+	double lag;
+	int retval;
+
+	while(TRUE)
+	{
+		pthread_mutex_lock(&Queue_Mutex);
+		while((Queue_Count == 0)&&(Queue_Done == FALSE))
+			pthread_cond_wait(&Queue_Not_Empty_Condition,&Queue_Mutex);
+		if(Queue_Count == 0)
+		{
+			pthread_mutex_unlock(&Queue_Mutex);
+			break;
+		}
+		upload = Queue[Queue_Start];
+		Queue_Start = (Queue_Start+1)%Queue_Length;
+		Queue_Count--;
+		Active_Count++;
+		pthread_cond_signal(&Queue_Not_Full_Condition);
+		pthread_mutex_unlock(&Queue_Mutex);
+		retval = GCP_Client_Sync_Upload_File(upload.Local_Filename,Bucket_Name,upload.Object_Name,&byte_count);
+		if(!retval)
+		{
+			fprintf(stderr,"gcp_uploader : Failed to upload '%s' to '%s'.\n",upload.Local_Filename,
+				upload.Object_Name);
+			GCP_Client_General_Error();
+		}
+		clock_gettime(CLOCK_MONOTONIC,&end_time);
+		lag = Timespec_Diff(upload.Event_Time,end_time);
+		pthread_mutex_lock(&Queue_Mutex);
+		Active_Count--;
+		if(retval)
+		{
+			Total_Stats.Upload_Count++;
+			Total_Stats.Byte_Count += byte_count;
+			Total_Stats.Lag_Sum += lag;
+			if(lag > Total_Stats.Lag_Max)
+				Total_Stats.Lag_Max = lag;
+			Interval_Stats.Upload_Count++;
+			Interval_Stats.Byte_Count += byte_count;
+			Interval_Stats.Lag_Sum += lag;
+			if(lag > Interval_Stats.Lag_Max)
+				Interval_Stats.Lag_Max = lag;
+		}
+		else
+		{
+			Total_Stats.Failed_Count++;
+			Interval_Stats.Failed_Count++;
+		}
+		pthread_mutex_unlock(&Queue_Mutex);
+		free(upload.Local_Filename);
+		free(upload.Object_Name);
+	}
+}
+
+/**
+ * Add a file to the upload queue. If the queue is full, we wait for an upload thread to take a file off it
+ * (or the uploader to be stopped).
+ * @param local_filename The local filename (copied).
+ * @param object_name The object name (copied).
+ * @param event_time The (monotonic) time the file's close was seen.
+ * @return The routine returns TRUE if the file was queued, and FALSE if it was not (out of memory, or the
+ *         uploader was stopped while waiting).
+ * @see #Queue
+ * @see #Queue_Length
+ */
+static int Queue_Add(char *local_filename,char *object_name,struct timespec event_time)
+{
+	struct Upload_Struct upload;
+	struct timespec wait_time;
+
+	upload.Local_Filename = strdup(local_filename);
+	upload.Object_Name = strdup(object_name);
+	upload.Event_Time = event_time;
+	if((upload.Local_Filename == NULL)||(upload.Object_Name == NULL))
+	{
+		fprintf(stderr,"gcp_uploader : Failed to allocate queue entry for '%s'.\n",local_filename);
+		free(upload.Local_Filename);
+		free(upload.Object_Name);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Queue_Mutex);
+	while((Queue_Count == Queue_Length)&&(Stop == FALSE))
+	{
+		clock_gettime(CLOCK_REALTIME,&wait_time);
+		wait_time.tv_sec += POLL_TIMEOUT_MS/1000;
+		pthread_cond_timedwait(&Queue_Not_Full_Condition,&Queue_Mutex,&wait_time);
+	}
+	if(Queue_Count == Queue_Length)
+	{
+		pthread_mutex_unlock(&Queue_Mutex);
+		fprintf(stderr,"gcp_uploader : Stopped before '%s' could be queued.\n",local_filename);
+		free(upload.Local_Filename);
+		free(upload.Object_Name);
+		return FALSE;
+	}
+	Queue[(Queue_Start+Queue_Count)%Queue_Length] = upload;
+	Queue_Count++;
+	if(Queue_Count > Total_Stats.Max_Queue_Count)
+		Total_Stats.Max_Queue_Count = Queue_Count;
+	if(Queue_Count > Interval_Stats.Max_Queue_Count)
+		Interval_Stats.Max_Queue_Count = Queue_Count;
+	pthread_cond_signal(&Queue_Not_Empty_Condition);
+	pthread_mutex_unlock(&Queue_Mutex);
+	return TRUE;
+}
+
+/**
+ * Watch a directory, and (recursively) it's sub-directories. Symbolic links to directories are not followed.
+ * @param path The directory's local path.
+ * @param object_prefix The object name prefix of files in the directory.
+ * @param queue_existing If TRUE, regular files already in the directory are queued for upload. This is used
+ *        for directories created while the uploader is running, whose files may have been written before the
+ *        watch was added.
+ * @return The routine returns TRUE on success, and FALSE if the directory could not be watched.
+ * @see #WATCH_EVENT_MASK
+ * @see #Watch_List
+ * @see #Watch_Find
+ * @see #Suffix_Matches
+ * @see #Queue_Add
+ */
+static int Watch_Add_Tree(char *path,char *object_prefix,int queue_existing)
+{
+	struct Watch_Struct *new_list = NULL;
+	struct Watch_Struct *watch = NULL;
+	struct dirent *entry = NULL;
+	struct timespec event_time;
+	struct stat stat_buffer;
+	char child_path[PATH_MAX];
+	char child_prefix[PATH_MAX];
+	DIR *dir = NULL;
+	int watch_descriptor;
+
+	watch_descriptor = inotify_add_watch(Inotify_Fd,path,WATCH_EVENT_MASK);
+	if(watch_descriptor < 0)
+	{
+		fprintf(stderr,"gcp_uploader : Failed to watch '%s' (%s)%s.\n",path,strerror(errno),
+			(errno == ENOSPC) ? ", increase fs.inotify.max_user_watches" : "");
+		return FALSE;
+	}
+	/* inotify returns the same watch descriptor for a directory that is already watched (for instance one that
+	** was renamed), and can reuse the descriptor of a removed directory, so it's entry is replaced */
+	watch = Watch_Find(watch_descriptor);
+	if(watch != NULL)
+	{
+		free(watch->Path);
+		free(watch->Object_Prefix);
+	}
+	else
+	{
+		new_list = (struct Watch_Struct *)realloc(Watch_List,(Watch_Count+1)*sizeof(struct Watch_Struct));
+		if(new_list == NULL)
+		{
+			fprintf(stderr,"gcp_uploader : Failed to reallocate watch list.\n");
+			return FALSE;
+		}
+		Watch_List = new_list;
+		watch = &(Watch_List[Watch_Count]);
+		Watch_Count++;
+	}
+	watch->Watch_Descriptor = watch_descriptor;
+	watch->Path = strdup(path);
+	watch->Object_Prefix = strdup(object_prefix);
+	dir = opendir(path);
+	if(dir == NULL)
+	{
+		fprintf(stderr,"gcp_uploader : Failed to open directory '%s' (%s).\n",path,strerror(errno));
+		return FALSE;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&event_time);
+	while((entry = readdir(dir)) != NULL)
+	{
+		if(entry->d_name[0] == '.')
+			continue;
+		snprintf(child_path,PATH_MAX,"%s/%s",path,entry->d_name);
+		if(lstat(child_path,&stat_buffer) != 0)
+			continue;
+		if(S_ISDIR(stat_buffer.st_mode))
+		{
+			snprintf(child_prefix,PATH_MAX,"%s%s/",object_prefix,entry->d_name);
+			if(!Watch_Add_Tree(child_path,child_prefix,queue_existing))
+			{
+				closedir(dir);
+				return FALSE;
+			}
+		}
+		else if(queue_existing&&S_ISREG(stat_buffer.st_mode)&&Suffix_Matches(entry->d_name))
+		{
+			snprintf(child_prefix,PATH_MAX,"%s%s",object_prefix,entry->d_name);
+			Queue_Add(child_path,child_prefix,event_time);
+		}
+	}
+	closedir(dir);
+	return TRUE;
+}
+
+/**
+ * Find a watched directory by it's watch descriptor.
+ * @param watch_descriptor The watch descriptor.
+ * @return The routine returns a pointer to the watched directory, or NULL if it is not in the list.
+ * @see #Watch_List
+ */
+static struct Watch_Struct *Watch_Find(int watch_descriptor)
+{
+	int i;
+
+	for(i=0; i < Watch_Count; i++)
+	{
+		if(Watch_List[i].Watch_Descriptor == watch_descriptor)
+			return &(Watch_List[i]);
+	}
+	return NULL;
+}
+
+/**
+ * Remove every entry for a watch descriptor from the watch list.
+ * @param watch_descriptor The watch descriptor.
+ * @see #Watch_List
+ * @see #Watch_Count
+ */
+static void Watch_Remove(int watch_descriptor)
+{
+	int i,j;
+
+	j = 0;
+	for(i=0; i < Watch_Count; i++)
+	{
+		if(Watch_List[i].Watch_Descriptor == watch_descriptor)
+		{
+			free(Watch_List[i].Path);
+			free(Watch_List[i].Object_Prefix);
+			continue;
+		}
+		Watch_List[j++] = Watch_List[i];
+	}
+	Watch_Count = j;
+}
+
+/**
+ * Read and process the available inotify events. Files that are closed after writing, or moved into a watched
+ * directory, are queued for upload (unless hidden, or not matching Suffix). New directories are watched.
+ * Directories that are removed are dropped from the watch list.
+ * @return The routine returns TRUE on success, and FALSE if the events could not be read.
+ * @see #EVENT_BUFFER_LENGTH
+ * @see #Watch_Find
+ * @see #Watch_Remove
+ * @see #Watch_Add_Tree
+ * @see #Suffix_Matches
+ * @see #Queue_Add
+ * @see #Overflow_Count
+ */
+static int Process_Events(void)
+{
+	char buffer[EVENT_BUFFER_LENGTH] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *event = NULL;
+	struct Watch_Struct *watch = NULL;
+	struct timespec event_time;
+	char local_filename[PATH_MAX];
+	char object_name[PATH_MAX];
+	ssize_t read_count;
+	char *ptr = NULL;
+
+	while(Stop == FALSE)
+	{
+		read_count = read(Inotify_Fd,buffer,EVENT_BUFFER_LENGTH);
+		if(read_count < 0)
+		{
+			if((errno == EAGAIN)||(errno == EINTR))
+				return TRUE;
+			fprintf(stderr,"gcp_uploader : Failed to read inotify events (%s).\n",strerror(errno));
+			return FALSE;
+		}
+		clock_gettime(CLOCK_MONOTONIC,&event_time);
+		for(ptr = buffer; ptr < buffer+read_count; ptr += sizeof(struct inotify_event)+event->len)
+		{
+			event = (const struct inotify_event *)ptr;
+			if(event->mask & IN_Q_OVERFLOW)
+			{
+				Overflow_Count++;
+				fprintf(stderr,"gcp_uploader : inotify event queue overflowed, events were lost "
+					"(run with -sync, or gcp_sync, to catch up).\n");
+				continue;
+			}
+			watch = Watch_Find(event->wd);
+			if(watch == NULL)
+				continue;
+			if(event->mask & IN_IGNORED)
+			{
+				/* the directory was removed (or unmounted), the descriptor may be reused */
+				Watch_Remove(event->wd);
+				continue;
+			}
+			if((event->len == 0)||(event->name[0] == '.'))
+				continue;
+			snprintf(local_filename,PATH_MAX,"%s/%s",watch->Path,event->name);
+			if(event->mask & IN_ISDIR)
+			{
+				if(event->mask & (IN_CREATE|IN_MOVED_TO))
+				{
+					snprintf(object_name,PATH_MAX,"%s%s/",watch->Object_Prefix,event->name);
+					/* Watch_Add_Tree may reallocate Watch_List, so watch is not used after this */
+					Watch_Add_Tree(local_filename,object_name,TRUE);
+				}
+				continue;
+			}
+			if((event->mask & (IN_CLOSE_WRITE|IN_MOVED_TO))&&Suffix_Matches(event->name))
+			{
+				snprintf(object_name,PATH_MAX,"%s%s",watch->Object_Prefix,event->name);
+				Queue_Add(local_filename,object_name,event_time);
+			}
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Check whether a filename ends in Suffix.
+ * @param filename The filename.
+ * @return The routine returns TRUE if Suffix is empty, or the filename ends in it, and FALSE otherwise.
+ * @see #Suffix
+ */
+static int Suffix_Matches(const char *filename)
+{
+	size_t filename_length,suffix_length;
+
+	suffix_length = strlen(Suffix);
+	if(suffix_length == 0)
+		return TRUE;
+	filename_length = strlen(filename);
+	if(filename_length < suffix_length)
+		return FALSE;
+	return (strcmp(filename+filename_length-suffix_length,Suffix) == 0);
+}
+
+/**
+ * Print a set of upload statistics: the number of files uploaded and failed, the maximum queue depth, the mean
+ * and maximum upload lag, and the throughput. If the upload bandwidth is limited, the rate each priority class
+ * achieved, and the time it spent waiting for bandwidth, are printed as well.
+ * @param label A label for the statistics ("interval" / "total").
+ * @param stats The statistics to print.
+ * @param elapsed_time The time the statistics were gathered over, in seconds.
+ * @see #Upload_Stats_Struct
+ * @see #Upload_Limit
+ * @see ../cdocs/gcp_client_bandwidth.html#GCP_Client_Bandwidth_Get_Stats
+ * @see ../cdocs/gcp_client_bandwidth.html#GCP_Client_Bandwidth_Priority_To_String
+ */
+static void Print_Stats(char *label,struct Upload_Stats_Struct *stats,double elapsed_time)
+{
+	struct GCP_Client_Bandwidth_Stats_Struct bandwidth_stats;
+	char time_string[32];
+	int i;
+
+	GCP_Client_General_Get_Current_Time_String(time_string,32);
+	fprintf(stdout,"%s %s: %llu uploaded, %llu failed, max queue %d, lag mean %.3f s max %.3f s, "
+		"%.1f files/s, %.3f MB/s.\n",time_string,label,stats->Upload_Count,stats->Failed_Count,
+		stats->Max_Queue_Count,(stats->Upload_Count > 0) ? stats->Lag_Sum/((double)stats->Upload_Count) : 0.0,
+		stats->Lag_Max,(elapsed_time > 0.0) ? ((double)stats->Upload_Count)/elapsed_time : 0.0,
+		(elapsed_time > 0.0) ? ((double)stats->Byte_Count)/(elapsed_time*1000000.0) : 0.0);
+	if((Upload_Limit != GCP_CLIENT_BANDWIDTH_UNLIMITED)&&
+	   GCP_Client_Bandwidth_Get_Stats(GCP_CLIENT_BANDWIDTH_DIRECTION_UPLOAD,&bandwidth_stats))
+	{
+		fprintf(stdout,"%s %s: upload limit %.3f MB/s",time_string,label,
+			((double)bandwidth_stats.Limit)/1000000.0);
+		for(i=0; i < GCP_CLIENT_BANDWIDTH_PRIORITY_COUNT; i++)
+		{
+			fprintf(stdout,", %s %.3f MB/s (waited %.3f s)",GCP_Client_Bandwidth_Priority_To_String(i),
+				bandwidth_stats.Rate[i]/1000000.0,bandwidth_stats.Wait_Time[i]);
+		}
+		fprintf(stdout,".\n");
+	}
+	fflush(stdout);
+}
+
+/**
+ * Return the difference between two times, in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return end_time - start_time, in seconds.
+ */
+static double Timespec_Diff(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+(((double)(end_time.tv_nsec-start_time.tv_nsec))/1.0E9);
+}
+
+/**
+ * SIGINT / SIGTERM handler, which stops the uploader.
+ * @param signal_number The signal received.
+ * @see #Stop
+ */
+static void Signal_Handler(int signal_number)
+{
+	Stop = TRUE;
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #STRING_LENGTH
+ * @see #MAX_DIRECTORY_COUNT
+ * @see #Directory_List
+ * @see #Bucket_Name
+ * @see #Prefix
+ * @see #Suffix
+ * @see #Endpoint
+ * @see #Concurrency
+ * @see #Queue_Length
+ * @see #Stats_Interval
+ * @see #Initial_Sync
+ * @see #Priority
+ * @see #Upload_Limit
+ * @see #Fits_Index
+ * @see #Fits_Keyword_List
+ * @see #Log_Level
+ * @see #Help
+ * @see ../cdocs/gcp_client_bandwidth.html#GCP_Client_Bandwidth_Priority_Parse
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-b")==0)||(strcmp(argv[i],"-bucket")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Bucket_Name,argv[i+1],STRING_LENGTH);
+				Bucket_Name[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-bucket requires a bucket name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-c")==0)||(strcmp(argv[i],"-concurrency")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Concurrency);
+				if((retval != 1)||(Concurrency < 1)||(Concurrency > GCP_CLIENT_BATCH_MAX_CONCURRENCY))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal concurrency %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-concurrency requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-d")==0)||(strcmp(argv[i],"-directory")==0))
+		{
+			if((i+1)<argc)
+			{
+				if(Directory_Count >= MAX_DIRECTORY_COUNT)
+				{
+					fprintf(stderr,"Parse_Arguments:Too many directories (maximum %d).\n",
+						MAX_DIRECTORY_COUNT);
+					return FALSE;
+				}
+				Directory_List[Directory_Count++] = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-directory requires a directory name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-e")==0)||(strcmp(argv[i],"-endpoint")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Endpoint,argv[i+1],STRING_LENGTH);
+				Endpoint[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-endpoint requires an emulator URL.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-fits_index")==0)
+		{
+			Fits_Index = TRUE;
+			/* the keyword list is optional */
+			if(((i+1)<argc)&&(argv[i+1][0] != '-'))
+			{
+				strncpy(Fits_Keyword_List,argv[i+1],STRING_LENGTH-1);
+				Fits_Keyword_List[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+		}
+		else if((strcmp(argv[i],"-help")==0))
+		{
+			Help();
+			return FALSE;
+		}
+		else if((strcmp(argv[i],"-l")==0)||(strcmp(argv[i],"-log_level")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Log_Level);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Failed to parse log level %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-log_level requires a number 0..5.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-p")==0)||(strcmp(argv[i],"-prefix")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Prefix,argv[i+1],STRING_LENGTH);
+				Prefix[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-prefix requires an object name prefix.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-priority")==0)
+		{
+			if((i+1)<argc)
+			{
+				if(!GCP_Client_Bandwidth_Priority_Parse(argv[i+1],&Priority))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal priority %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-priority requires high, normal or bulk.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-q")==0)||(strcmp(argv[i],"-queue_length")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Queue_Length);
+				if((retval != 1)||(Queue_Length < 1))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal queue length %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-queue_length requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-s")==0)||(strcmp(argv[i],"-suffix")==0))
+		{
+			if((i+1)<argc)
+			{
+				strncpy(Suffix,argv[i+1],STRING_LENGTH);
+				Suffix[STRING_LENGTH-1] = '\0';
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-suffix requires a filename suffix.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-stats_interval")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Stats_Interval);
+				if((retval != 1)||(Stats_Interval < 0))
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal statistics interval %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-stats_interval requires a number of seconds.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-sync")==0)
+		{
+			Initial_Sync = TRUE;
+		}
+		else if(strcmp(argv[i],"-upload_limit")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%llu",&Upload_Limit);
+				if(retval != 1)
+				{
+					fprintf(stderr,"Parse_Arguments:Illegal upload limit %s.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"Parse_Arguments:-upload_limit requires a number of bytes per second.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}/* end for */
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"GCP Uploader:Help.\n");
+	fprintf(stdout,"This program watches directories, and uploads files to a bucket as soon as they are written.\n");
+	fprintf(stdout,"gcp_uploader -d[irectory] <directory> [-d[irectory] <directory> ...] -b[ucket] <bucket name>\n");
+	fprintf(stdout,"\t[-p[refix] <prefix>][-s[uffix] <suffix>][-c[oncurrency] <n>][-q[ueue_length] <n>]\n");
+	fprintf(stdout,"\t[-stats_interval <s>][-sync][-priority high|normal|bulk][-upload_limit <bytes/s>]\n");
+	fprintf(stdout,"\t[-fits_index [<keyword>,<keyword>...]][-e[ndpoint] <url>][-help][-l[og_level <0..5>].\n");
+	fprintf(stdout,"\tUp to %d directories can be watched. Their sub-directories (including new ones) are watched "
+		"too.\n",MAX_DIRECTORY_COUNT);
+	fprintf(stdout,"\t-prefix is prepended to each file's path (relative to it's -directory) to make it's object "
+		"name.\n");
+	fprintf(stdout,"\t-suffix only uploads files whose names end in the suffix (e.g. .fits).\n");
+	fprintf(stdout,"\t-concurrency is the number of upload threads (default %d).\n",
+		GCP_CLIENT_BATCH_DEFAULT_CONCURRENCY);
+	fprintf(stdout,"\t-queue_length is the number of files that can wait for an upload thread (default 1024).\n");
+	fprintf(stdout,"\t-stats_interval is how often the queue depth, lag and throughput are printed "
+		"(default 10 s, 0 for only on exit).\n");
+	fprintf(stdout,"\t-sync uploads new and changed files already in the directories when the uploader starts.\n");
+	fprintf(stdout,"\t-priority is the bandwidth priority class of the uploads (default normal).\n");
+	fprintf(stdout,"\t-upload_limit limits the upload bandwidth, in bytes per second (default unlimited).\n");
+	fprintf(stdout,"\t-fits_index records the FITS header keywords of uploaded frames in their metadata "
+		"(default %s).\n",GCP_CLIENT_FITS_DEFAULT_KEYWORD_LIST);
+	fprintf(stdout,"\t-endpoint sets a storage emulator URL (CLOUD_STORAGE_EMULATOR_ENDPOINT).\n");
+	fprintf(stdout,"Files are uploaded when closed after writing, or renamed into a watched directory.\n");
+	fprintf(stdout,"Hidden files (starting with '.') are ignored, so files written as .name and renamed when\n");
+	fprintf(stdout,"complete are uploaded once. SIGINT / SIGTERM stop the uploader, after the queued files are "
+		"uploaded.\n");
+}